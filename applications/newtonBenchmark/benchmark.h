@@ -0,0 +1,90 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <Newton.h>
+#include <dVector.h>
+#include <dMatrix.h>
+#include <dCustomHinge.h>
+#include <dCustomBallAndSocket.h>
+
+// small deterministic generator, so every run of a scene builds the exact same world
+class BenchmarkRandom
+{
+	public:
+	BenchmarkRandom (unsigned seed = 0x12345678)
+		:m_seed (seed)
+	{
+	}
+
+	dFloat Uniform (dFloat minValue, dFloat maxValue)
+	{
+		m_seed = m_seed * 1664525u + 1013904223u;
+		dFloat t = dFloat (m_seed >> 8) / dFloat (1 << 24);
+		return minValue + (maxValue - minValue) * t;
+	}
+
+	int Integer (int count)
+	{
+		m_seed = m_seed * 1664525u + 1013904223u;
+		return int ((m_seed >> 8) % unsigned (count));
+	}
+
+	unsigned m_seed;
+};
+
+// work a scene does every frame on top of the world update, it is timed as its own phase
+class BenchmarkScene
+{
+	public:
+	BenchmarkScene ()
+		:m_name (NULL)
+		,m_extraPhaseName (NULL)
+	{
+	}
+
+	virtual ~BenchmarkScene ()
+	{
+	}
+
+	virtual void Build (NewtonWorld* const world, int scale) = 0;
+
+	virtual int ExtraPhase (NewtonWorld* const world, int frame)
+	{
+		return 0;
+	}
+
+	const char* m_name;
+	const char* m_extraPhaseName;
+};
+
+typedef BenchmarkScene* (*BenchmarkSceneFactory) ();
+
+struct BenchmarkSceneEntry
+{
+	const char* m_name;
+	BenchmarkSceneFactory m_create;
+};
+
+int BenchmarkGetSceneCount ();
+const BenchmarkSceneEntry& BenchmarkGetScene (int index);
+
+void BenchmarkApplyGravity (const NewtonBody* const body, dFloat timestep, int threadIndex);
+NewtonBody* BenchmarkCreateBody (NewtonWorld* const world, NewtonCollision* const collision, const dMatrix& matrix, dFloat mass);
+NewtonBody* BenchmarkCreateFloor (NewtonWorld* const world, dFloat size);
+NewtonCollision* BenchmarkCreateRandomShape (NewtonWorld* const world, BenchmarkRandom& random, dFloat size);
+
+#endif
@@ -0,0 +1,657 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+// headless versions of the sandbox demos, each one builds the same kind of 
+// world as the demo with the same name, without meshes, cameras or user input.
+// scale multiplies the number of dynamics objects, not their size.
+
+#include "benchmark.h"
+#include <vector>
+
+#define BENCHMARK_PI				dFloat (3.141592f)
+#define BENCHMARK_GRAVITY			dFloat (-10.0f)
+#define BENCHMARK_HEIGHTFIELD_SIZE	129
+
+bool g_benchmarkAutoSleep = true;
+
+void BenchmarkApplyGravity (const NewtonBody* const body, dFloat timestep, int threadIndex)
+{
+	dFloat mass;
+	dFloat Ixx;
+	dFloat Iyy;
+	dFloat Izz;
+
+	NewtonBodyGetMass (body, &mass, &Ixx, &Iyy, &Izz);
+	dVector force (0.0f, mass * BENCHMARK_GRAVITY, 0.0f, 0.0f);
+	NewtonBodySetForce (body, &force[0]);
+}
+
+NewtonBody* BenchmarkCreateBody (NewtonWorld* const world, NewtonCollision* const collision, const dMatrix& matrix, dFloat mass)
+{
+	NewtonBody* const body = NewtonCreateDynamicBody (world, collision, &matrix[0][0]);
+	if (mass > 0.0f) {
+		NewtonBodySetMassProperties (body, mass, collision);
+		NewtonBodySetForceAndTorqueCallback (body, BenchmarkApplyGravity);
+		NewtonBodySetAutoSleep (body, g_benchmarkAutoSleep ? 1 : 0);
+	}
+	return body;
+}
+
+NewtonBody* BenchmarkCreateFloor (NewtonWorld* const world, dFloat size)
+{
+	NewtonCollision* const collision = NewtonCreateBox (world, size, 1.0f, size, 0, NULL);
+	dMatrix matrix (dGetIdentityMatrix());
+	matrix.m_posit.m_y = -0.5f;
+	NewtonBody* const body = BenchmarkCreateBody (world, collision, matrix, 0.0f);
+	NewtonDestroyCollision (collision);
+	return body;
+}
+
+NewtonCollision* BenchmarkCreateRandomShape (NewtonWorld* const world, BenchmarkRandom& random, dFloat size)
+{
+	NewtonCollision* collision = NULL;
+	switch (random.Integer (7)) 
+	{
+		case 0:
+			collision = NewtonCreateBox (world, size * random.Uniform (0.5f, 1.0f), size * random.Uniform (0.5f, 1.0f), size * random.Uniform (0.5f, 1.0f), 0, NULL);
+			break;
+
+		case 1:
+			collision = NewtonCreateSphere (world, size * 0.5f, 0, NULL);
+			break;
+
+		case 2:
+			collision = NewtonCreateCapsule (world, size * 0.25f, size * 0.25f, size, 0, NULL);
+			break;
+
+		case 3:
+			collision = NewtonCreateCylinder (world, size * 0.5f, size * 0.5f, size * 0.75f, 0, NULL);
+			break;
+
+		case 4:
+			collision = NewtonCreateCone (world, size * 0.5f, size, 0, NULL);
+			break;
+
+		case 5:
+			collision = NewtonCreateChamferCylinder (world, size * 0.5f, size * 0.5f, 0, NULL);
+			break;
+
+		default:
+		{
+			dVector cloud[32];
+			for (int i = 0; i < 32; i ++) {
+				cloud[i] = dVector (random.Uniform (-0.5f, 0.5f) * size, random.Uniform (-0.5f, 0.5f) * size, random.Uniform (-0.5f, 0.5f) * size, 0.0f);
+			}
+			collision = NewtonCreateConvexHull (world, 32, &cloud[0][0], sizeof (dVector), 0.0f, 0, NULL);
+			break;
+		}
+	}
+	return collision;
+}
+
+static void DropRandomShapes (NewtonWorld* const world, BenchmarkRandom& random, int count, dFloat extent, dFloat baseHeight)
+{
+	int side = 1;
+	while (side * side < count) {
+		side ++;
+	}
+	dFloat spacing = extent / side;
+	for (int i = 0; i < count; i ++) {
+		NewtonCollision* const collision = BenchmarkCreateRandomShape (world, random, 1.0f);
+		dMatrix matrix (dPitchMatrix (random.Uniform (0.0f, BENCHMARK_PI)) * dYawMatrix (random.Uniform (0.0f, BENCHMARK_PI)));
+		matrix.m_posit = dVector ((i % side) * spacing - extent * 0.5f, baseHeight + (i / (side * side)) * 2.0f + random.Uniform (0.0f, 1.0f), ((i / side) % side) * spacing - extent * 0.5f, 1.0f);
+		BenchmarkCreateBody (world, collision, matrix, 1.0f);
+		NewtonDestroyCollision (collision);
+	}
+}
+
+// terrain elevation at grid point x, z, shared by the height field scenes
+static dFloat HeightFieldElevation (int x, int z)
+{
+	const int size = BENCHMARK_HEIGHTFIELD_SIZE;
+	dFloat fx = dFloat (x) / size;
+	dFloat fz = dFloat (z) / size;
+	return 3.0f * dSin (fx * 6.0f * BENCHMARK_PI) * dCos (fz * 4.0f * BENCHMARK_PI) + 1.5f * dSin ((fx + fz) * 10.0f * BENCHMARK_PI);
+}
+
+// highest terrain point under the box [x0, x1] x [z0, z1] of a height field made by CreateHeightField
+static dFloat HeightFieldMaxElevation (dFloat cellSize, dFloat x0, dFloat z0, dFloat x1, dFloat z1)
+{
+	const int size = BENCHMARK_HEIGHTFIELD_SIZE;
+	const dFloat origin = size * cellSize * 0.5f;
+	const int i0 = dClamp (int (dFloor ((x0 + origin) / cellSize)), 0, size - 1);
+	const int i1 = dClamp (int (dFloor ((x1 + origin) / cellSize)) + 1, 0, size - 1);
+	const int j0 = dClamp (int (dFloor ((z0 + origin) / cellSize)), 0, size - 1);
+	const int j1 = dClamp (int (dFloor ((z1 + origin) / cellSize)) + 1, 0, size - 1);
+
+	dFloat elevation = -1.0e10f;
+	for (int j = j0; j <= j1; j ++) {
+		for (int i = i0; i <= i1; i ++) {
+			elevation = dMax (elevation, HeightFieldElevation (i, j));
+		}
+	}
+	return elevation - 5.0f;
+}
+
+static NewtonBody* CreateHeightField (NewtonWorld* const world, dFloat cellSize)
+{
+	const int size = BENCHMARK_HEIGHTFIELD_SIZE;
+	dFloat* const elevation = new dFloat [size * size];
+	char* const attributes = new char [size * size];
+	memset (attributes, 0, size * size * sizeof (char));
+	for (int z = 0; z < size; z ++) {
+		for (int x = 0; x < size; x ++) {
+			elevation[z * size + x] = HeightFieldElevation (x, z);
+		}
+	}
+
+	NewtonCollision* const collision = NewtonCreateHeightFieldCollision (world, size, size, 1, 0, elevation, attributes, 1.0f, cellSize, cellSize, 0);
+	dMatrix matrix (dGetIdentityMatrix());
+	matrix.m_posit = dVector (-size * cellSize * 0.5f, -5.0f, -size * cellSize * 0.5f, 1.0f);
+	NewtonBody* const body = BenchmarkCreateBody (world, collision, matrix, 0.0f);
+	NewtonDestroyCollision (collision);
+
+	delete[] attributes;
+	delete[] elevation;
+	return body;
+}
+
+// same terrain function as CreateHeightField, evaluated one tile at a time
+static int GenerateHeightFieldTile (void* const userData, int x0, int z0, int width, int height, void* const elevation, char* const attributes)
+{
+	dFloat* const tileElevation = (dFloat*) elevation;
+	for (int z = 0; z < height; z ++) {
+		for (int x = 0; x < width; x ++) {
+			tileElevation[z * width + x] = HeightFieldElevation (x0 + x, z0 + z);
+			attributes[z * width + x] = 0;
+		}
+	}
+	return 1;
+}
+
+
+// towers of boxes, like the stacks of BasicStacking
+class BasicStacking: public BenchmarkScene
+{
+	public:
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		BenchmarkCreateFloor (world, 400.0f);
+
+		const int towerHigh = 12;
+		const int towers = 4 * scale;
+		int side = 1;
+		while (side * side < towers) {
+			side ++;
+		}
+
+		NewtonCollision* const box = NewtonCreateBox (world, 1.0f, 0.5f, 1.0f, 0, NULL);
+		for (int i = 0; i < towers; i ++) {
+			dFloat x = (i % side) * 3.0f;
+			dFloat z = (i / side) * 3.0f;
+			for (int j = 0; j < towerHigh; j ++) {
+				dMatrix matrix (dYawMatrix (j * 0.05f));
+				matrix.m_posit = dVector (x, 0.25f + j * 0.5f, z, 1.0f);
+				BenchmarkCreateBody (world, box, matrix, 1.0f);
+			}
+		}
+		NewtonDestroyCollision (box);
+	}
+};
+
+// pile of every convex primitive, like PrimitiveCollision
+class PrimitiveCollision: public BenchmarkScene
+{
+	public:
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		BenchmarkRandom random;
+		BenchmarkCreateFloor (world, 400.0f);
+		DropRandomShapes (world, random, 250 * scale, 20.0f, 2.0f);
+	}
+};
+
+// a rubble pile of small boxes and spheres, most of the contacts are primitive pairs
+class DebrisField: public BenchmarkScene
+{
+	public:
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		BenchmarkRandom random;
+		BenchmarkCreateFloor (world, 400.0f);
+
+		NewtonCollision* const debris[] = 
+		{
+			NewtonCreateBox (world, 0.5f, 0.5f, 0.5f, 0, NULL),
+			NewtonCreateBox (world, 0.6f, 0.2f, 0.4f, 0, NULL),
+			NewtonCreateSphere (world, 0.25f, 0, NULL),
+			NewtonCreateSphere (world, 0.15f, 0, NULL),
+		};
+		const int shapesCount = sizeof (debris) / sizeof (debris[0]);
+
+		const int count = 2000 * scale;
+		int side = 1;
+		while (side * side * 8 < count) {
+			side ++;
+		}
+		const dFloat spacing = 0.55f;
+		for (int i = 0; i < count; i ++) {
+			dMatrix matrix (dPitchMatrix (random.Uniform (0.0f, BENCHMARK_PI)) * dYawMatrix (random.Uniform (0.0f, BENCHMARK_PI)));
+			matrix.m_posit = dVector ((i % side - side / 2) * spacing, 0.5f + (i / (side * side)) * spacing, ((i / side) % side - side / 2) * spacing, 1.0f);
+			BenchmarkCreateBody (world, debris[random.Integer (shapesCount)], matrix, 1.0f);
+		}
+		for (int i = 0; i < shapesCount; i ++) {
+			NewtonDestroyCollision (debris[i]);
+		}
+	}
+};
+
+// convex shapes falling on a polygon soup terrain, like MeshCollision
+class MeshCollision: public BenchmarkScene
+{
+	public:
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		const int size = 64;
+		const dFloat cellSize = 2.0f;
+		NewtonCollision* const mesh = NewtonCreateTreeCollision (world, 0);
+		NewtonTreeCollisionBeginBuild (mesh);
+		for (int z = 0; z < size; z ++) {
+			for (int x = 0; x < size; x ++) {
+				dVector face[4];
+				for (int i = 0; i < 4; i ++) {
+					dFloat px = (x + ((i == 1) || (i == 2) ? 1 : 0) - size / 2) * cellSize;
+					dFloat pz = (z + ((i >= 2) ? 1 : 0) - size / 2) * cellSize;
+					face[i] = dVector (px, 2.0f * dSin (px * 0.2f) * dCos (pz * 0.15f), pz, 0.0f);
+				}
+				dVector triangle0[3] = {face[0], face[3], face[2]};
+				dVector triangle1[3] = {face[0], face[2], face[1]};
+				NewtonTreeCollisionAddFace (mesh, 3, &triangle0[0][0], sizeof (dVector), 0);
+				NewtonTreeCollisionAddFace (mesh, 3, &triangle1[0][0], sizeof (dVector), 0);
+			}
+		}
+		NewtonTreeCollisionEndBuild (mesh, 1);
+		BenchmarkCreateBody (world, mesh, dGetIdentityMatrix(), 0.0f);
+		NewtonDestroyCollision (mesh);
+
+		BenchmarkRandom random;
+		DropRandomShapes (world, random, 150 * scale, 40.0f, 4.0f);
+	}
+};
+
+// convex shapes falling on a height field, like HeighFieldCollision
+class HeighFieldCollision: public BenchmarkScene
+{
+	public:
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		CreateHeightField (world, 1.0f);
+		BenchmarkRandom random;
+		DropRandomShapes (world, random, 150 * scale, 60.0f, 2.0f);
+	}
+};
+
+// convex shapes falling on the middle of a 64k x 64k tiled height field, the tiles are generated when the bodies get near them
+class TiledHeightFieldCollision: public BenchmarkScene
+{
+	public:
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		const int size = 65537;
+		const dFloat cellSize = 1.0f;
+		NewtonCollision* const collision = NewtonCreateTiledHeightFieldCollision (world, size, size, 128, 1, 0, -4.5f, 4.5f, 1.0f, cellSize, cellSize, 64, 0);
+		NewtonTiledHeightFieldSetTileCallback (collision, GenerateHeightFieldTile, NULL);
+		NewtonTiledHeightFieldSetPrefetchDistance (collision, 8.0f);
+		dMatrix matrix (dGetIdentityMatrix());
+		matrix.m_posit = dVector (-(size - 1) * cellSize * 0.5f, -5.0f, -(size - 1) * cellSize * 0.5f, 1.0f);
+		BenchmarkCreateBody (world, collision, matrix, 0.0f);
+		NewtonDestroyCollision (collision);
+
+		BenchmarkRandom random;
+		DropRandomShapes (world, random, 150 * scale, 60.0f, 2.0f);
+	}
+};
+
+// articulated bodies falling in a pile, like DynamicRagDoll
+class DynamicRagDoll: public BenchmarkScene
+{
+	public:
+	NewtonBody* AddBone (NewtonWorld* const world, NewtonCollision* const shape, const dMatrix& matrix, dFloat mass)
+	{
+		// dVector addition keeps the w of the left operand, the bone positions are built from a w = 0 origin
+		dMatrix boneMatrix (matrix);
+		boneMatrix.m_posit.m_w = 1.0f;
+		return BenchmarkCreateBody (world, shape, boneMatrix, mass);
+	}
+
+	void AddBallJoint (NewtonWorld* const world, const dVector& pivot, const dVector& pin, NewtonBody* const child, NewtonBody* const parent)
+	{
+		dMatrix frame (dGrammSchmidt (pin));
+		frame.m_posit = pivot;
+		frame.m_posit.m_w = 1.0f;
+		dCustomLimitBallAndSocket* const joint = new dCustomLimitBallAndSocket (frame, child, parent);
+		joint->SetConeAngle (60.0f * BENCHMARK_PI / 180.0f);
+		joint->SetTwistAngle (-30.0f * BENCHMARK_PI / 180.0f, 30.0f * BENCHMARK_PI / 180.0f);
+	}
+
+	void AddHingeJoint (NewtonWorld* const world, const dVector& pivot, const dVector& pin, NewtonBody* const child, NewtonBody* const parent)
+	{
+		dMatrix frame (dGrammSchmidt (pin));
+		frame.m_posit = pivot;
+		frame.m_posit.m_w = 1.0f;
+		dCustomHinge* const joint = new dCustomHinge (frame, child, parent);
+		joint->EnableLimits (true);
+		joint->SetLimits (-120.0f * BENCHMARK_PI / 180.0f, 0.0f);
+	}
+
+	void BuildRagDoll (NewtonWorld* const world, const dVector& origin, NewtonCollision* const torsoShape, NewtonCollision* const headShape, NewtonCollision* const armShape, NewtonCollision* const legShape)
+	{
+		dMatrix matrix (dGetIdentityMatrix());
+		matrix.m_posit = origin + dVector (0.0f, 1.45f, 0.0f, 0.0f);
+		NewtonBody* const torso = AddBone (world, torsoShape, matrix, 10.0f);
+
+		matrix.m_posit = origin + dVector (0.0f, 1.97f, 0.0f, 0.0f);
+		NewtonBody* const head = AddBone (world, headShape, matrix, 2.0f);
+		AddBallJoint (world, origin + dVector (0.0f, 1.81f, 0.0f, 0.0f), dVector (0.0f, 1.0f, 0.0f, 0.0f), head, torso);
+
+		// arms lie along the capsule axis, legs need to be rotated to the vertical
+		for (int side = -1; side <= 1; side += 2) {
+			dFloat s = dFloat (side);
+			matrix = dGetIdentityMatrix();
+			matrix.m_posit = origin + dVector (s * 0.48f, 1.7f, 0.0f, 0.0f);
+			NewtonBody* const upperArm = AddBone (world, armShape, matrix, 2.0f);
+			AddBallJoint (world, origin + dVector (s * 0.27f, 1.7f, 0.0f, 0.0f), dVector (s, 0.0f, 0.0f, 0.0f), upperArm, torso);
+
+			matrix.m_posit = origin + dVector (s * 0.92f, 1.7f, 0.0f, 0.0f);
+			NewtonBody* const foreArm = AddBone (world, armShape, matrix, 1.5f);
+			AddHingeJoint (world, origin + dVector (s * 0.70f, 1.7f, 0.0f, 0.0f), dVector (0.0f, 1.0f, 0.0f, 0.0f), foreArm, upperArm);
+
+			matrix = dRollMatrix (0.5f * BENCHMARK_PI);
+			matrix.m_posit = origin + dVector (s * 0.15f, 0.84f, 0.0f, 0.0f);
+			NewtonBody* const thigh = AddBone (world, legShape, matrix, 4.0f);
+			AddBallJoint (world, origin + dVector (s * 0.15f, 1.08f, 0.0f, 0.0f), dVector (0.0f, -1.0f, 0.0f, 0.0f), thigh, torso);
+
+			matrix.m_posit = origin + dVector (s * 0.15f, 0.32f, 0.0f, 0.0f);
+			NewtonBody* const shin = AddBone (world, legShape, matrix, 3.0f);
+			AddHingeJoint (world, origin + dVector (s * 0.15f, 0.58f, 0.0f, 0.0f), dVector (1.0f, 0.0f, 0.0f, 0.0f), shin, thigh);
+		}
+	}
+
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		BenchmarkCreateFloor (world, 400.0f);
+
+		NewtonCollision* const torsoShape = NewtonCreateBox (world, 0.45f, 0.7f, 0.3f, 0, NULL);
+		NewtonCollision* const headShape = NewtonCreateSphere (world, 0.15f, 0, NULL);
+		NewtonCollision* const armShape = NewtonCreateCapsule (world, 0.06f, 0.06f, 0.38f, 0, NULL);
+		NewtonCollision* const legShape = NewtonCreateCapsule (world, 0.08f, 0.08f, 0.46f, 0, NULL);
+
+		// ragdolls are stacked in layers so that they fall on top of each other 
+		const int count = 8 * scale;
+		for (int i = 0; i < count; i ++) {
+			int layer = i / 4;
+			dVector origin (dFloat (i % 2) * 2.5f, 0.1f + layer * 0.6f, dFloat ((i / 2) % 2) * 2.5f, 0.0f);
+			dMatrix rotation (dYawMatrix (layer * 0.5f * BENCHMARK_PI));
+			BuildRagDoll (world, rotation.RotateVector (origin) + dVector (0.0f, layer * 2.2f, 0.0f, 0.0f), torsoShape, headShape, armShape, legShape);
+		}
+
+		NewtonDestroyCollision (torsoShape);
+		NewtonDestroyCollision (headShape);
+		NewtonDestroyCollision (armShape);
+		NewtonDestroyCollision (legShape);
+	}
+};
+
+// six wheels hinged to a heavy chassis and driven by a torque, like HeavyVehicles 
+class HeavyVehicles: public BenchmarkScene
+{
+	public:
+	static void ApplyWheelTorque (const NewtonBody* const body, dFloat timestep, int threadIndex)
+	{
+		BenchmarkApplyGravity (body, timestep, threadIndex);
+
+		// the chamfer cylinder axis is the local x axis of the wheel
+		dMatrix matrix;
+		NewtonBodyGetMatrix (body, &matrix[0][0]);
+		dVector torque (matrix.m_front.Scale (-400.0f));
+		NewtonBodySetTorque (body, &torque[0]);
+	}
+
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		const dFloat cellSize = 1.5f;
+		CreateHeightField (world, cellSize);
+
+		NewtonCollision* const chassisShape = NewtonCreateBox (world, 4.0f, 0.8f, 2.0f, 0, NULL);
+		NewtonCollision* const wheelShape = NewtonCreateChamferCylinder (world, 0.5f, 0.4f, 0, NULL);
+
+		const int count = 4 * scale;
+		for (int i = 0; i < count; i ++) {
+			dVector origin (dFloat (i % 4) * 8.0f - 12.0f, 0.0f, dFloat (i / 4) * 6.0f - 40.0f, 0.0f);
+
+			// drop the vehicle from just above the terrain, the wheel bottoms are 1.3 below the chassis origin
+			origin.m_y = HeightFieldMaxElevation (cellSize, origin.m_x - 2.0f, origin.m_z - 2.0f, origin.m_x + 2.0f, origin.m_z + 2.0f) + 1.3f + 0.2f;
+
+			dMatrix matrix (dGetIdentityMatrix());
+			matrix.m_posit = origin;
+			matrix.m_posit.m_w = 1.0f;
+			NewtonBody* const chassis = BenchmarkCreateBody (world, chassisShape, matrix, 1000.0f);
+
+			for (int j = 0; j < 6; j ++) {
+				dFloat x = (j % 3 - 1) * 1.4f;
+				dFloat z = (j < 3) ? -1.25f : 1.25f;
+				dMatrix wheelMatrix (dYawMatrix (0.5f * BENCHMARK_PI));
+				wheelMatrix.m_posit = origin + dVector (x, -0.6f, z, 0.0f);
+				wheelMatrix.m_posit.m_w = 1.0f;
+				NewtonBody* const wheel = BenchmarkCreateBody (world, wheelShape, wheelMatrix, 40.0f);
+				NewtonBodySetForceAndTorqueCallback (wheel, ApplyWheelTorque);
+				new dCustomHinge (wheelMatrix, wheel, chassis);
+			}
+		}
+
+		NewtonDestroyCollision (chassisShape);
+		NewtonDestroyCollision (wheelShape);
+	}
+};
+
+// many rays per frame against a populated height field, like MultiRayCasting
+class MultiRayCasting: public BenchmarkScene
+{
+	public:
+	MultiRayCasting ()
+		:BenchmarkScene()
+		,m_rayCount (0)
+	{
+		m_extraPhaseName = "rayCast";
+	}
+
+	static dFloat RayFilter (const NewtonBody* const body, const NewtonCollision* const shapeHit, const dFloat* const hitContact, const dFloat* const hitNormal, dLong collisionID, void* const userData, dFloat intersectParam)
+	{
+		dFloat* const param = (dFloat*) userData;
+		if (intersectParam < param[0]) {
+			param[0] = intersectParam;
+		}
+		return intersectParam;
+	}
+
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		CreateHeightField (world, 1.0f);
+		BenchmarkRandom random;
+		DropRandomShapes (world, random, 200 * scale, 60.0f, 2.0f);
+		m_rayCount = 1000 * scale;
+	}
+
+	virtual int ExtraPhase (NewtonWorld* const world, int frame)
+	{
+		int hits = 0;
+		BenchmarkRandom random (unsigned (frame) * 7919u + 1u);
+		for (int i = 0; i < m_rayCount; i ++) {
+			dFloat x = random.Uniform (-60.0f, 60.0f);
+			dFloat z = random.Uniform (-60.0f, 60.0f);
+			dVector p0 (x, 40.0f, z, 0.0f);
+			dVector p1 (x + random.Uniform (-5.0f, 5.0f), -40.0f, z + random.Uniform (-5.0f, 5.0f), 0.0f);
+			dFloat param = 1.2f;
+			NewtonWorldRayCast (world, &p0[0], &p1[0], RayFilter, &param, NULL, 0);
+			hits += (param < 1.0f) ? 1 : 0;
+		}
+		return hits;
+	}
+
+	int m_rayCount;
+};
+
+
+// pairs of touching primitives sent straight to NewtonCollisionCollide, one pair type per scene.
+// run them with --primitiveContacts 0 and 1 to compare the analytic kernels with the general contact solver
+class PrimitiveContacts: public BenchmarkScene
+{
+	public:
+	enum Shape
+	{
+		m_sphere,
+		m_capsule,
+		m_box,
+	};
+
+	PrimitiveContacts (Shape shape0, Shape shape1)
+		:BenchmarkScene()
+		,m_shape0 (shape0)
+		,m_shape1 (shape1)
+	{
+		m_extraPhaseName = "contacts";
+	}
+
+	static NewtonCollision* CreateShape (NewtonWorld* const world, Shape shape)
+	{
+		switch (shape) 
+		{
+			case m_sphere:
+				return NewtonCreateSphere (world, 0.5f, 0, NULL);
+			case m_capsule:
+				return NewtonCreateCapsule (world, 0.3f, 0.3f, 1.2f, 0, NULL);
+			default:
+				return NewtonCreateBox (world, 1.0f, 0.6f, 0.8f, 0, NULL);
+		}
+	}
+
+	virtual void Build (NewtonWorld* const world, int scale)
+	{
+		// the second shape of every pair is placed at a random direction from the first one, 
+		// close enough for most pairs to overlap
+		BenchmarkRandom random;
+		const int count = 2000 * scale;
+		m_matrix0.resize (count);
+		m_matrix1.resize (count);
+		for (int i = 0; i < count; i ++) {
+			m_matrix0[i] = dPitchMatrix (random.Uniform (0.0f, BENCHMARK_PI)) * dYawMatrix (random.Uniform (0.0f, BENCHMARK_PI)) * dRollMatrix (random.Uniform (0.0f, BENCHMARK_PI));
+			m_matrix0[i].m_posit = dVector (random.Uniform (-20.0f, 20.0f), random.Uniform (-20.0f, 20.0f), random.Uniform (-20.0f, 20.0f), 1.0f);
+
+			dVector dir (random.Uniform (-1.0f, 1.0f), random.Uniform (-1.0f, 1.0f), random.Uniform (-1.0f, 1.0f), 0.0f);
+			dir = dir.Scale (random.Uniform (0.3f, 1.0f) / dSqrt (dir.DotProduct3(dir) + 1.0e-6f));
+			m_matrix1[i] = dPitchMatrix (random.Uniform (0.0f, BENCHMARK_PI)) * dYawMatrix (random.Uniform (0.0f, BENCHMARK_PI)) * dRollMatrix (random.Uniform (0.0f, BENCHMARK_PI));
+			m_matrix1[i].m_posit = m_matrix0[i].m_posit + dir;
+		}
+	}
+
+	virtual int ExtraPhase (NewtonWorld* const world, int frame)
+	{
+		dFloat points[8 * 3];
+		dFloat normals[8 * 3];
+		dFloat penetrations[8];
+		dLong attribute0[8];
+		dLong attribute1[8];
+
+		int contacts = 0;
+		NewtonCollision* const collision0 = CreateShape (world, m_shape0);
+		NewtonCollision* const collision1 = CreateShape (world, m_shape1);
+		for (size_t i = 0; i < m_matrix0.size(); i ++) {
+			contacts += NewtonCollisionCollide (world, 8, collision0, &m_matrix0[i][0][0], collision1, &m_matrix1[i][0][0], points, normals, penetrations, attribute0, attribute1, 0);
+		}
+		NewtonDestroyCollision (collision0);
+		NewtonDestroyCollision (collision1);
+		return contacts;
+	}
+
+	Shape m_shape0;
+	Shape m_shape1;
+	std::vector<dMatrix> m_matrix0;
+	std::vector<dMatrix> m_matrix1;
+};
+
+class ContactSphereSphere: public PrimitiveContacts
+{
+	public:
+	ContactSphereSphere ()
+		:PrimitiveContacts (m_sphere, m_sphere)
+	{
+	}
+};
+
+class ContactSphereBox: public PrimitiveContacts
+{
+	public:
+	ContactSphereBox ()
+		:PrimitiveContacts (m_sphere, m_box)
+	{
+	}
+};
+
+class ContactCapsuleCapsule: public PrimitiveContacts
+{
+	public:
+	ContactCapsuleCapsule ()
+		:PrimitiveContacts (m_capsule, m_capsule)
+	{
+	}
+};
+
+class ContactBoxBox: public PrimitiveContacts
+{
+	public:
+	ContactBoxBox ()
+		:PrimitiveContacts (m_box, m_box)
+	{
+	}
+};
+
+template <class T>
+static BenchmarkScene* CreateScene ()
+{
+	return new T;
+}
+
+static BenchmarkSceneEntry g_scenes[] = 
+{
+	{"BasicStacking", CreateScene<BasicStacking>},
+	{"PrimitiveCollision", CreateScene<PrimitiveCollision>},
+	{"DebrisField", CreateScene<DebrisField>},
+	{"MeshCollision", CreateScene<MeshCollision>},
+	{"HeighFieldCollision", CreateScene<HeighFieldCollision>},
+	{"TiledHeightFieldCollision", CreateScene<TiledHeightFieldCollision>},
+	{"DynamicRagDoll", CreateScene<DynamicRagDoll>},
+	{"HeavyVehicles", CreateScene<HeavyVehicles>},
+	{"MultiRayCasting", CreateScene<MultiRayCasting>},
+	{"ContactSphereSphere", CreateScene<ContactSphereSphere>},
+	{"ContactSphereBox", CreateScene<ContactSphereBox>},
+	{"ContactCapsuleCapsule", CreateScene<ContactCapsuleCapsule>},
+	{"ContactBoxBox", CreateScene<ContactBoxBox>},
+};
+
+int BenchmarkGetSceneCount ()
+{
+	return sizeof (g_scenes) / sizeof (g_scenes[0]);
+}
+
+const BenchmarkSceneEntry& BenchmarkGetScene (int index)
+{
+	return g_scenes[index];
+}
@@ -0,0 +1,519 @@
+/* Copyright (c) <2003-2016> <Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+// newtonBenchmark: steps the sandbox workloads without graphics and writes the timings as json.
+//
+// usage: newtonBenchmark [options]
+//	--scene name[,name...]	scenes to run, "all" by default, --list prints the names
+//	--scale n				multiplier of the number of objects in each scene, 1 by default
+//	--frames n				timed frames, 600 by default
+//	--warmup n				untimed frames before the timed ones, 30 by default
+//	--threads n[,n...]		thread counts to run every scene with, 1 by default
+//	--iterations n			solver model passed to NewtonSetSolverModel, 4 by default
+//	--islandThreads 0|1		solve single islands with multiple threads, 1 by default
+//	--broadphase n			algorithm passed to NewtonSelectBroadphaseAlgorithm, 0 by default
+//	--primitiveContacts 0|1	use the analytic contact kernels of the common primitive pairs, 1 by default
+//	--autoSleep 0|1			let bodies go to sleep, 1 by default
+//	--timestep t			step size in seconds, 1/60 by default
+//	--stats 0|1				add the NewtonWorldGetStats breakdown of the timed frames to the json, 1 by default
+//	--profile 0|1			add the engine profiler phases of the timed frames to the json, 0 by default
+//	--trace prefix			also write a chrome trace of every run to prefix_scene_threads.json
+//	--output file			write the json to a file instead of stdout
+
+#include "benchmark.h"
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <map>
+
+extern bool g_benchmarkAutoSleep;
+
+class BenchmarkOptions
+{
+	public:
+	BenchmarkOptions ()
+		:m_scale (1)
+		,m_frames (600)
+		,m_warmup (30)
+		,m_iterations (4)
+		,m_islandThreads (1)
+		,m_broadphase (0)
+		,m_primitiveContacts (1)
+		,m_stats (1)
+		,m_profile (0)
+		,m_timestep (1.0f / 60.0f)
+		,m_trace (NULL)
+		,m_output (NULL)
+	{
+	}
+
+	std::vector<std::string> m_scenes;
+	std::vector<int> m_threads;
+	int m_scale;
+	int m_frames;
+	int m_warmup;
+	int m_iterations;
+	int m_islandThreads;
+	int m_broadphase;
+	int m_primitiveContacts;
+	int m_stats;
+	int m_profile;
+	dFloat m_timestep;
+	const char* m_trace;
+	const char* m_output;
+};
+
+class BenchmarkPhase
+{
+	public:
+	BenchmarkPhase ()
+		:m_total (0.0)
+		,m_mean (0.0)
+		,m_min (0.0)
+		,m_max (0.0)
+		,m_median (0.0)
+		,m_p95 (0.0)
+	{
+	}
+
+	// all values are in milliseconds
+	void Set (std::vector<double>& samples)
+	{
+		if (samples.size()) {
+			std::sort (samples.begin(), samples.end());
+			m_total = 0.0;
+			for (size_t i = 0; i < samples.size(); i ++) {
+				m_total += samples[i];
+			}
+			m_mean = m_total / samples.size();
+			m_min = samples.front();
+			m_max = samples.back();
+			m_median = samples[samples.size() / 2];
+			m_p95 = samples[std::min (samples.size() - 1, (samples.size() * 95) / 100)];
+		}
+	}
+
+	void Write (FILE* const file, const char* const name, bool last) const
+	{
+		fprintf (file, "\t\t\t\t\"%s\": {\"totalMs\": %.4f, \"meanMs\": %.4f, \"minMs\": %.4f, \"maxMs\": %.4f, \"medianMs\": %.4f, \"p95Ms\": %.4f}%s\n", 
+				 name, m_total, m_mean, m_min, m_max, m_median, m_p95, last ? "" : ",");
+	}
+
+	double m_total;
+	double m_mean;
+	double m_min;
+	double m_max;
+	double m_median;
+	double m_p95;
+};
+
+class BenchmarkEnginePhase
+{
+	public:
+	BenchmarkEnginePhase ()
+		:m_parent ("")
+		,m_depth (0)
+		,m_calls (0)
+		,m_total (0.0)
+		,m_max (0.0)
+	{
+	}
+
+	std::string m_name;
+	std::string m_parent;
+	int m_depth;
+	int m_calls;
+	double m_total;
+	double m_max;
+};
+
+// per frame means of the world statistics
+class BenchmarkWorldStats
+{
+	public:
+	enum
+	{
+		m_timesCount = 11,
+		m_countersCount = 7,
+	};
+
+	BenchmarkWorldStats ()
+		:m_frames (0)
+	{
+		memset (m_times, 0, sizeof (m_times));
+		memset (m_counters, 0, sizeof (m_counters));
+	}
+
+	void Add (const NewtonWorldStats& stats)
+	{
+		const dFloat times[m_timesCount] = {stats.m_stepTime, stats.m_forceCallbacksTime, stats.m_preListenersTime, stats.m_sleepingStateTime, stats.m_tileStreamingTime, stats.m_broadPhaseTime, 
+											stats.m_narrowPhaseTime, stats.m_buildClustersTime, stats.m_solverTime, stats.m_integrationTime, stats.m_postListenersTime};
+		const int counters[m_countersCount] = {stats.m_activeBodies, stats.m_pairsTested, stats.m_contactsCreated, stats.m_contactsDestroyed, stats.m_clusters, stats.m_jointRows, stats.m_solverPasses};
+		for (int i = 0; i < m_timesCount; i ++) {
+			m_times[i] += times[i] * 1000.0;
+		}
+		for (int i = 0; i < m_countersCount; i ++) {
+			m_counters[i] += counters[i];
+		}
+		m_frames ++;
+	}
+
+	void Write (FILE* const file) const
+	{
+		static const char* const timeNames[m_timesCount] = {"step", "forceCallbacks", "preListeners", "sleepingState", "tileStreaming", "broadPhase", "narrowPhase", "buildClusters", "solver", "integration", "postListeners"};
+		static const char* const counterNames[m_countersCount] = {"activeBodies", "pairsTested", "contactsCreated", "contactsDestroyed", "clusters", "jointRows", "solverPasses"};
+		const double scale = m_frames ? 1.0 / m_frames : 0.0;
+		fprintf (file, "\t\t\t\"engineStats\": {\n");
+		for (int i = 0; i < m_timesCount; i ++) {
+			fprintf (file, "\t\t\t\t\"%sMs\": %.4f,\n", timeNames[i], m_times[i] * scale);
+		}
+		for (int i = 0; i < m_countersCount; i ++) {
+			fprintf (file, "\t\t\t\t\"%s\": %.2f%s\n", counterNames[i], m_counters[i] * scale, (i + 1) < m_countersCount ? "," : "");
+		}
+		fprintf (file, "\t\t\t},\n");
+	}
+
+	int m_frames;
+	double m_times[m_timesCount];
+	double m_counters[m_countersCount];
+};
+
+class BenchmarkResult
+{
+	public:
+	std::string m_scene;
+	std::string m_extraPhaseName;
+	int m_threads;
+	int m_bodies;
+	int m_joints;
+	int m_contactJoints;
+	int m_contacts;
+	int m_constraints;
+	int m_extraPhaseCount;
+	int m_memoryBuild;
+	int m_memoryPeak;
+	int m_memoryEnd;
+	double m_buildMs;
+	BenchmarkPhase m_update;
+	BenchmarkPhase m_extraPhase;
+	BenchmarkWorldStats m_worldStats;
+	std::vector<BenchmarkEnginePhase> m_enginePhases;
+};
+
+static double ElapsedMs (const std::chrono::high_resolution_clock::time_point& t0, const std::chrono::high_resolution_clock::time_point& t1)
+{
+	return std::chrono::duration<double, std::milli> (t1 - t0).count();
+}
+
+static void SplitList (const char* const text, std::vector<std::string>& list)
+{
+	std::string token;
+	for (const char* ptr = text; ; ptr ++) {
+		if ((*ptr == ',') || (*ptr == 0)) {
+			if (token.size()) {
+				list.push_back (token);
+			}
+			token.clear();
+			if (*ptr == 0) {
+				break;
+			}
+		} else {
+			token += *ptr;
+		}
+	}
+}
+
+static void CountConstraints (NewtonWorld* const world, BenchmarkResult& result)
+{
+	result.m_bodies = NewtonWorldGetBodyCount (world);
+	result.m_constraints = NewtonWorldGetConstraintCount (world);
+	result.m_joints = 0;
+	result.m_contactJoints = 0;
+	result.m_contacts = 0;
+
+	// every joint is linked to both bodies, only count it from its first body
+	for (NewtonBody* body = NewtonWorldGetFirstBody (world); body; body = NewtonWorldGetNextBody (world, body)) {
+		for (NewtonJoint* joint = NewtonBodyGetFirstJoint (body); joint; joint = NewtonBodyGetNextJoint (body, joint)) {
+			if (NewtonJointGetBody0 (joint) == body) {
+				result.m_joints ++;
+			}
+		}
+		for (NewtonJoint* joint = NewtonBodyGetFirstContactJoint (body); joint; joint = NewtonBodyGetNextContactJoint (body, joint)) {
+			if (NewtonJointGetBody0 (joint) == body) {
+				result.m_contactJoints ++;
+				result.m_contacts += NewtonContactJointGetContactCount (joint);
+			}
+		}
+	}
+}
+
+// adds the profiler phases of the last world update to the run totals, phases keep the order they first showed up
+static void AccumulateEnginePhases (NewtonWorld* const world, std::map<std::string, int>& phaseIndex, std::vector<BenchmarkEnginePhase>& enginePhases)
+{
+	NewtonProfilerPhase phases[128];
+	const int count = NewtonProfilerGetFramePhases (world, 0, phases, sizeof (phases) / sizeof (phases[0]));
+	for (int i = 0; i < count; i ++) {
+		std::map<std::string, int>::iterator iter (phaseIndex.find (phases[i].m_name));
+		if (iter == phaseIndex.end()) {
+			iter = phaseIndex.insert (std::make_pair (std::string (phases[i].m_name), int (enginePhases.size()))).first;
+			enginePhases.push_back (BenchmarkEnginePhase());
+			enginePhases.back().m_name = phases[i].m_name;
+			enginePhases.back().m_parent = phases[i].m_parentName ? phases[i].m_parentName : "";
+			enginePhases.back().m_depth = phases[i].m_depth;
+		}
+		BenchmarkEnginePhase& phase = enginePhases[iter->second];
+		phase.m_calls += phases[i].m_calls;
+		phase.m_total += phases[i].m_time * 1000.0;
+		phase.m_max = std::max (phase.m_max, double (phases[i].m_maxTime) * 1000.0);
+	}
+}
+
+static void RunScene (const BenchmarkSceneEntry& entry, int threads, const BenchmarkOptions& options, BenchmarkResult& result)
+{
+	BenchmarkScene* const scene = entry.m_create();
+
+	NewtonWorld* const world = NewtonCreate ();
+	NewtonSetThreadsCount (world, threads);
+	NewtonSetMultiThreadSolverOnSingleIsland (world, options.m_islandThreads);
+	NewtonSetSolverModel (world, options.m_iterations);
+	NewtonSelectBroadphaseAlgorithm (world, options.m_broadphase);
+	NewtonWorldSetPrimitiveContacts (world, options.m_primitiveContacts);
+	NewtonWorldSetCollectStats (world, options.m_stats);
+
+	std::chrono::high_resolution_clock::time_point t0 (std::chrono::high_resolution_clock::now());
+	scene->Build (world, options.m_scale);
+	NewtonInvalidateCache (world);
+	std::chrono::high_resolution_clock::time_point t1 (std::chrono::high_resolution_clock::now());
+
+	result.m_scene = entry.m_name;
+	result.m_extraPhaseName = scene->m_extraPhaseName ? scene->m_extraPhaseName : "";
+	result.m_threads = NewtonGetThreadsCount (world);
+	result.m_buildMs = ElapsedMs (t0, t1);
+	result.m_memoryBuild = NewtonGetMemoryUsed ();
+	result.m_memoryPeak = result.m_memoryBuild;
+	result.m_extraPhaseCount = 0;
+
+	for (int i = 0; i < options.m_warmup; i ++) {
+		NewtonUpdate (world, options.m_timestep);
+		scene->ExtraPhase (world, i);
+	}
+
+	bool profile = false;
+	if (options.m_profile || options.m_trace) {
+		char traceName[256];
+		if (options.m_trace) {
+			snprintf (traceName, sizeof (traceName), "%s_%s_%d.json", options.m_trace, entry.m_name, threads);
+		}
+		profile = NewtonProfilerStartCapture (world, options.m_trace ? traceName : NULL, 0) ? true : false;
+		if (!profile) {
+			fprintf (stderr, "the engine profiler is not available\n");
+		}
+	}
+
+	std::map<std::string, int> phaseIndex;
+	std::vector<double> updateSamples;
+	std::vector<double> extraSamples;
+	updateSamples.reserve (options.m_frames);
+	for (int i = 0; i < options.m_frames; i ++) {
+		std::chrono::high_resolution_clock::time_point u0 (std::chrono::high_resolution_clock::now());
+		NewtonUpdate (world, options.m_timestep);
+		std::chrono::high_resolution_clock::time_point u1 (std::chrono::high_resolution_clock::now());
+		updateSamples.push_back (ElapsedMs (u0, u1));
+		if (options.m_stats) {
+			NewtonWorldStats stats;
+			NewtonWorldGetStats (world, &stats);
+			result.m_worldStats.Add (stats);
+		}
+		if (profile) {
+			// the benchmark owns the frame boundary, one frame per NewtonUpdate
+			NewtonProfilerUpdate ();
+			AccumulateEnginePhases (world, phaseIndex, result.m_enginePhases);
+		}
+
+		if (scene->m_extraPhaseName) {
+			std::chrono::high_resolution_clock::time_point e0 (std::chrono::high_resolution_clock::now());
+			result.m_extraPhaseCount += scene->ExtraPhase (world, options.m_warmup + i);
+			std::chrono::high_resolution_clock::time_point e1 (std::chrono::high_resolution_clock::now());
+			extraSamples.push_back (ElapsedMs (e0, e1));
+		}
+		result.m_memoryPeak = std::max (result.m_memoryPeak, NewtonGetMemoryUsed ());
+	}
+	if (profile) {
+		NewtonProfilerStopCapture (world);
+	}
+	result.m_update.Set (updateSamples);
+	result.m_extraPhase.Set (extraSamples);
+	result.m_memoryEnd = NewtonGetMemoryUsed ();
+	CountConstraints (world, result);
+
+	NewtonDestroy (world);
+	delete scene;
+}
+
+static void WriteJson (FILE* const file, const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results)
+{
+	fprintf (file, "{\n");
+	fprintf (file, "\t\"engineVersion\": %d,\n", NewtonWorldGetVersion ());
+	fprintf (file, "\t\"floatSize\": %d,\n", NewtonWorldFloatSize ());
+	fprintf (file, "\t\"scale\": %d,\n", options.m_scale);
+	fprintf (file, "\t\"frames\": %d,\n", options.m_frames);
+	fprintf (file, "\t\"warmup\": %d,\n", options.m_warmup);
+	fprintf (file, "\t\"timestep\": %f,\n", options.m_timestep);
+	fprintf (file, "\t\"solverModel\": %d,\n", options.m_iterations);
+	fprintf (file, "\t\"islandThreads\": %d,\n", options.m_islandThreads);
+	fprintf (file, "\t\"broadphase\": %d,\n", options.m_broadphase);
+	fprintf (file, "\t\"primitiveContacts\": %d,\n", options.m_primitiveContacts);
+	fprintf (file, "\t\"autoSleep\": %d,\n", g_benchmarkAutoSleep ? 1 : 0);
+	fprintf (file, "\t\"runs\": [\n");
+	for (size_t i = 0; i < results.size(); i ++) {
+		const BenchmarkResult& result = results[i];
+		fprintf (file, "\t\t{\n");
+		fprintf (file, "\t\t\t\"scene\": \"%s\",\n", result.m_scene.c_str());
+		fprintf (file, "\t\t\t\"threads\": %d,\n", result.m_threads);
+		fprintf (file, "\t\t\t\"bodies\": %d,\n", result.m_bodies);
+		fprintf (file, "\t\t\t\"joints\": %d,\n", result.m_joints);
+		fprintf (file, "\t\t\t\"contactJoints\": %d,\n", result.m_contactJoints);
+		fprintf (file, "\t\t\t\"contacts\": %d,\n", result.m_contacts);
+		fprintf (file, "\t\t\t\"constraints\": %d,\n", result.m_constraints);
+		fprintf (file, "\t\t\t\"memory\": {\"afterBuildBytes\": %d, \"peakBytes\": %d, \"endBytes\": %d},\n", result.m_memoryBuild, result.m_memoryPeak, result.m_memoryEnd);
+		if (result.m_extraPhaseName.size()) {
+			fprintf (file, "\t\t\t\"%sCount\": %d,\n", result.m_extraPhaseName.c_str(), result.m_extraPhaseCount);
+		}
+		if (result.m_worldStats.m_frames) {
+			result.m_worldStats.Write (file);
+		}
+		fprintf (file, "\t\t\t\"phases\": {\n");
+		fprintf (file, "\t\t\t\t\"build\": {\"totalMs\": %.4f},\n", result.m_buildMs);
+		result.m_update.Write (file, "update", result.m_extraPhaseName.size() == 0);
+		if (result.m_extraPhaseName.size()) {
+			result.m_extraPhase.Write (file, result.m_extraPhaseName.c_str(), true);
+		}
+		fprintf (file, "\t\t\t}%s\n", result.m_enginePhases.size() ? "," : "");
+		if (result.m_enginePhases.size()) {
+			// times are per timed frame, summed over all threads
+			fprintf (file, "\t\t\t\"enginePhases\": [\n");
+			for (size_t j = 0; j < result.m_enginePhases.size(); j ++) {
+				const BenchmarkEnginePhase& phase = result.m_enginePhases[j];
+				fprintf (file, "\t\t\t\t{\"name\": \"%s\", \"parent\": \"%s\", \"depth\": %d, \"callsPerFrame\": %.2f, \"meanMs\": %.4f, \"maxCallMs\": %.4f}%s\n",
+						 phase.m_name.c_str(), phase.m_parent.c_str(), phase.m_depth, double (phase.m_calls) / options.m_frames, phase.m_total / options.m_frames, phase.m_max,
+						 (j + 1) < result.m_enginePhases.size() ? "," : "");
+			}
+			fprintf (file, "\t\t\t]\n");
+		}
+		fprintf (file, "\t\t}%s\n", (i + 1) < results.size() ? "," : "");
+	}
+	fprintf (file, "\t]\n");
+	fprintf (file, "}\n");
+}
+
+static int FindScene (const char* const name)
+{
+	for (int i = 0; i < BenchmarkGetSceneCount(); i ++) {
+		if (!strcmp (BenchmarkGetScene(i).m_name, name)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int main (int argc, char** argv)
+{
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; i ++) {
+		const char* const option = argv[i];
+		const char* const value = ((i + 1) < argc) ? argv[i + 1] : NULL;
+		if (!strcmp (option, "--list")) {
+			for (int j = 0; j < BenchmarkGetSceneCount(); j ++) {
+				printf ("%s\n", BenchmarkGetScene(j).m_name);
+			}
+			return 0;
+		} else if (!value) {
+			fprintf (stderr, "missing value for %s\n", option);
+			return 1;
+		} else if (!strcmp (option, "--scene")) {
+			if (strcmp (value, "all")) {
+				SplitList (value, options.m_scenes);
+			}
+		} else if (!strcmp (option, "--threads")) {
+			std::vector<std::string> list;
+			SplitList (value, list);
+			for (size_t j = 0; j < list.size(); j ++) {
+				options.m_threads.push_back (std::max (1, atoi (list[j].c_str())));
+			}
+		} else if (!strcmp (option, "--scale")) {
+			options.m_scale = std::max (1, atoi (value));
+		} else if (!strcmp (option, "--frames")) {
+			options.m_frames = std::max (1, atoi (value));
+		} else if (!strcmp (option, "--warmup")) {
+			options.m_warmup = std::max (0, atoi (value));
+		} else if (!strcmp (option, "--iterations")) {
+			options.m_iterations = std::max (1, atoi (value));
+		} else if (!strcmp (option, "--islandThreads")) {
+			options.m_islandThreads = atoi (value) ? 1 : 0;
+		} else if (!strcmp (option, "--broadphase")) {
+			options.m_broadphase = std::max (0, atoi (value));
+		} else if (!strcmp (option, "--primitiveContacts")) {
+			options.m_primitiveContacts = atoi (value) ? 1 : 0;
+		} else if (!strcmp (option, "--autoSleep")) {
+			g_benchmarkAutoSleep = atoi (value) ? true : false;
+		} else if (!strcmp (option, "--timestep")) {
+			options.m_timestep = dFloat (atof (value));
+		} else if (!strcmp (option, "--stats")) {
+			options.m_stats = atoi (value) ? 1 : 0;
+		} else if (!strcmp (option, "--profile")) {
+			options.m_profile = atoi (value) ? 1 : 0;
+		} else if (!strcmp (option, "--trace")) {
+			options.m_trace = value;
+		} else if (!strcmp (option, "--output")) {
+			options.m_output = value;
+		} else {
+			fprintf (stderr, "unknown option %s\n", option);
+			return 1;
+		}
+		i ++;
+	}
+
+	if (!options.m_scenes.size()) {
+		for (int i = 0; i < BenchmarkGetSceneCount(); i ++) {
+			options.m_scenes.push_back (BenchmarkGetScene(i).m_name);
+		}
+	}
+	if (!options.m_threads.size()) {
+		options.m_threads.push_back (1);
+	}
+
+	std::vector<BenchmarkResult> results;
+	for (size_t i = 0; i < options.m_scenes.size(); i ++) {
+		int index = FindScene (options.m_scenes[i].c_str());
+		if (index < 0) {
+			fprintf (stderr, "unknown scene %s\n", options.m_scenes[i].c_str());
+			return 1;
+		}
+		for (size_t j = 0; j < options.m_threads.size(); j ++) {
+			BenchmarkResult result;
+			fprintf (stderr, "running %s, %d threads\n", options.m_scenes[i].c_str(), options.m_threads[j]);
+			RunScene (BenchmarkGetScene(index), options.m_threads[j], options, result);
+			results.push_back (result);
+		}
+	}
+
+	FILE* const file = options.m_output ? fopen (options.m_output, "wb") : stdout;
+	if (!file) {
+		fprintf (stderr, "can not open %s\n", options.m_output);
+		return 1;
+	}
+	WriteJson (file, options, results);
+	if (file != stdout) {
+		fclose (file);
+	}
+	return 0;
+}
@@ -51,6 +51,7 @@
 #include "dgQuaternion.h"
 #include "dgAsyncThread.h"
 #include "dgMutexThread.h"
+#include "dgSimdKernels.h"
 #include "dgConvexHull3d.h"
 #include "dgConvexHull4d.h"
 #include "dgIntersections.h"
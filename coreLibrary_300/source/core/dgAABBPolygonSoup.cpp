@@ -24,6 +24,7 @@
 #include "dgStack.h"
 #include "dgList.h"
 #include "dgMatrix.h"
+#include "dgThreadHive.h"
 #include "dgAABBPolygonSoup.h"
 #include "dgPolygonSoupBuilder.h"
 
@@ -234,21 +235,622 @@ class dgAABBPolygonSoup::dgSpliteInfo
 
 
 
+#define DG_SOUP_BUILD_BINS				16
+#define DG_SOUP_BUILD_MAX_CHUNKS		64
+#define DG_SOUP_BUILD_CHUNK_SIZE		1024
+#define DG_SOUP_BUILD_TASK_SIZE			4096
+#define DG_SOUP_BUILD_SMALL_RANGE		4
+#define DG_SOUP_BUILD_STACK_DEPTH		64
+
+
+DG_INLINE static dgFloat32 dgSoupBuildArea (const dgVector& minBox, const dgVector& maxBox)
+{
+	const dgVector side (maxBox - minBox);
+	return side.DotProduct4(side.ShiftTripleRight()).GetScalar();
+}
+
+// the builder partitions a packed copy of the face boxes, the face nodes themselves never move
+DG_MSC_VECTOR_ALIGMENT
+class dgSoupBuildLeaf
+{
+	public:
+	dgVector m_minBox;
+	dgVector m_maxBox;
+	dgAABBPolygonSoup::dgNodeBuilder* m_node;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgSoupBuildBounds
+{
+	public:
+	void Init()
+	{
+		m_minBox = dgVector (dgFloat32 (1.0e15f));
+		m_maxBox = dgVector (-dgFloat32 (1.0e15f));
+		m_minCentroid = m_minBox;
+		m_maxCentroid = m_maxBox;
+	}
+
+	void Add (const dgSoupBuildLeaf& leaf)
+	{
+		// twice the centroid, the scale does not change the binning
+		const dgVector centroid (leaf.m_minBox + leaf.m_maxBox);
+		m_minBox = m_minBox.GetMin(leaf.m_minBox);
+		m_maxBox = m_maxBox.GetMax(leaf.m_maxBox);
+		m_minCentroid = m_minCentroid.GetMin(centroid);
+		m_maxCentroid = m_maxCentroid.GetMax(centroid);
+	}
+
+	void Merge (const dgSoupBuildBounds& bounds)
+	{
+		m_minBox = m_minBox.GetMin(bounds.m_minBox);
+		m_maxBox = m_maxBox.GetMax(bounds.m_maxBox);
+		m_minCentroid = m_minCentroid.GetMin(bounds.m_minCentroid);
+		m_maxCentroid = m_maxCentroid.GetMax(bounds.m_maxCentroid);
+	}
+
+	dgVector m_minBox;
+	dgVector m_maxBox;
+	dgVector m_minCentroid;
+	dgVector m_maxCentroid;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgSoupBuildBins
+{
+	public:
+	void Init()
+	{
+		for (dgInt32 i = 0; i < 3; i ++) {
+			for (dgInt32 j = 0; j < DG_SOUP_BUILD_BINS; j ++) {
+				m_minBox[i][j] = dgVector (dgFloat32 (1.0e15f));
+				m_maxBox[i][j] = dgVector (-dgFloat32 (1.0e15f));
+				m_count[i][j] = 0;
+			}
+		}
+	}
+
+	void Merge (const dgSoupBuildBins& bins)
+	{
+		for (dgInt32 i = 0; i < 3; i ++) {
+			for (dgInt32 j = 0; j < DG_SOUP_BUILD_BINS; j ++) {
+				m_minBox[i][j] = m_minBox[i][j].GetMin(bins.m_minBox[i][j]);
+				m_maxBox[i][j] = m_maxBox[i][j].GetMax(bins.m_maxBox[i][j]);
+				m_count[i][j] += bins.m_count[i][j];
+			}
+		}
+	}
+
+	dgVector m_minBox[3][DG_SOUP_BUILD_BINS];
+	dgVector m_maxBox[3][DG_SOUP_BUILD_BINS];
+	dgInt32 m_count[3][DG_SOUP_BUILD_BINS];
+} DG_GCC_VECTOR_ALIGMENT;
+
+// the bins of a range are evenly spaced along the centroid bounds of the range
+DG_MSC_VECTOR_ALIGMENT
+class dgSoupBuildSplit
+{
+	public:
+	dgSoupBuildSplit (const dgSoupBuildBounds& bounds)
+		:m_origin(bounds.m_minCentroid)
+		,m_scale(dgFloat32 (0.0f))
+		,m_axis(-1)
+		,m_bin(-1)
+	{
+		const dgVector extent (bounds.m_maxCentroid - bounds.m_minCentroid);
+		for (dgInt32 i = 0; i < 3; i ++) {
+			if (extent[i] > dgFloat32 (1.0e-6f)) {
+				m_scale[i] = dgFloat32 (DG_SOUP_BUILD_BINS) * dgFloat32 (0.999f) / extent[i];
+			}
+		}
+	}
+
+	DG_INLINE dgInt32 GetBin (const dgSoupBuildLeaf& leaf, dgInt32 axis) const
+	{
+		const dgFloat32 centroid = leaf.m_minBox[axis] + leaf.m_maxBox[axis];
+		return dgMin (dgInt32 ((centroid - m_origin[axis]) * m_scale[axis]), DG_SOUP_BUILD_BINS - 1);
+	}
+
+	DG_INLINE bool IsLeft (const dgSoupBuildLeaf& leaf) const
+	{
+		return GetBin (leaf, m_axis) <= m_bin;
+	}
+
+	// pick the bin plane with the lowest surface area heuristic cost, false if all the centroids fall in one bin
+	bool Select (const dgSoupBuildBins& bins)
+	{
+		dgFloat32 bestCost = dgFloat32 (1.0e30f);
+		for (dgInt32 i = 0; i < 3; i ++) {
+			if (m_scale[i] > dgFloat32 (0.0f)) {
+				dgFloat32 rightArea[DG_SOUP_BUILD_BINS];
+				dgInt32 rightCount[DG_SOUP_BUILD_BINS];
+				dgVector minBox (dgFloat32 (1.0e15f));
+				dgVector maxBox (-dgFloat32 (1.0e15f));
+				dgInt32 count = 0;
+				for (dgInt32 j = DG_SOUP_BUILD_BINS - 1; j > 0; j --) {
+					minBox = minBox.GetMin(bins.m_minBox[i][j]);
+					maxBox = maxBox.GetMax(bins.m_maxBox[i][j]);
+					count += bins.m_count[i][j];
+					rightArea[j] = count ? dgSoupBuildArea (minBox, maxBox) : dgFloat32 (0.0f);
+					rightCount[j] = count;
+				}
+
+				minBox = dgVector (dgFloat32 (1.0e15f));
+				maxBox = dgVector (-dgFloat32 (1.0e15f));
+				count = 0;
+				for (dgInt32 j = 0; j < DG_SOUP_BUILD_BINS - 1; j ++) {
+					minBox = minBox.GetMin(bins.m_minBox[i][j]);
+					maxBox = maxBox.GetMax(bins.m_maxBox[i][j]);
+					count += bins.m_count[i][j];
+					if (count && rightCount[j + 1]) {
+						const dgFloat32 cost = dgSoupBuildArea (minBox, maxBox) * count + rightArea[j + 1] * rightCount[j + 1];
+						if (cost < bestCost) {
+							bestCost = cost;
+							m_axis = i;
+							m_bin = j;
+						}
+					}
+				}
+			}
+		}
+		return m_axis >= 0;
+	}
+
+	dgVector m_origin;
+	dgVector m_scale;
+	dgInt32 m_axis;
+	dgInt32 m_bin;
+} DG_GCC_VECTOR_ALIGMENT;
+
+class dgSoupBuildTask
+{
+	public:
+	dgAABBPolygonSoup::dgNodeBuilder* m_parent;
+	dgInt32 m_first;
+	dgInt32 m_last;
+	dgInt32 m_isLeft;
+};
+
+// a range on the build stack, the bounds of a child come out of the partition of its parent
+DG_MSC_VECTOR_ALIGMENT
+class dgSoupBuildRange
+{
+	public:
+	dgSoupBuildBounds m_bounds;
+	dgSoupBuildTask m_task;
+} DG_GCC_VECTOR_ALIGMENT;
+
+// ranges larger than the task size are split on the calling thread, with the bounds, bins and partition of each split
+// spread over the thread pool, the smaller ranges are built as independent sub tree tasks.
+// a range [first, last] of faces always owns the interior nodes [first, last - 1], so the tasks never share nodes,
+// the partition is stable and the task ranges do not depend on the thread pool, so the tree is the same for any number of threads.
+DG_MSC_VECTOR_ALIGMENT
+class dgAABBPolygonSoup::dgTreeBuildDescriptor
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator)
+
+	dgTreeBuildDescriptor (dgThreadHive* const threadPool, dgMemoryAllocator* const allocator, dgSoupBuildLeaf* const leafArray, dgSoupBuildLeaf* const tempArray, dgFloat32* const areaArray, dgNodeBuilder* const nodeArray, dgInt32 quality)
+		:m_threadPool(threadPool)
+		,m_leafArray(leafArray)
+		,m_tempArray(tempArray)
+		,m_nodeArray(nodeArray)
+		,m_root(NULL)
+		,m_split(NULL)
+		,m_areaArray(areaArray)
+		,m_tasks(allocator)
+		,m_tasksCount(0)
+		,m_quality(quality)
+	{
+	}
+
+	void ParallelFor (dgInt32 count, dgWorkerThreadRangeCallback callback)
+	{
+		if (m_threadPool) {
+			m_threadPool->ParallelFor (count, callback, this, 1);
+		} else {
+			callback (this, 0, count, 0);
+		}
+	}
+
+	void CalculateBounds (dgSoupBuildBounds& bounds, dgInt32 first, dgInt32 count) const
+	{
+		bounds.Init();
+		for (dgInt32 i = 0; i < count; i ++) {
+			bounds.Add (m_leafArray[first + i]);
+		}
+	}
+
+	void CalculateBins (dgSoupBuildBins& bins, const dgSoupBuildSplit& split, dgInt32 first, dgInt32 count) const
+	{
+		bins.Init();
+		for (dgInt32 i = 0; i < count; i ++) {
+			const dgSoupBuildLeaf& leaf = m_leafArray[first + i];
+			for (dgInt32 j = 0; j < 3; j ++) {
+				const dgInt32 bin = split.GetBin (leaf, j);
+				bins.m_minBox[j][bin] = bins.m_minBox[j][bin].GetMin(leaf.m_minBox);
+				bins.m_maxBox[j][bin] = bins.m_maxBox[j][bin].GetMax(leaf.m_maxBox);
+				bins.m_count[j][bin] ++;
+			}
+		}
+	}
+
+	// the bounds of the two children are collected while the faces are moved to their side
+	void Scatter (const dgSoupBuildSplit& split, dgInt32 first, dgInt32 count, dgInt32 leftIndex, dgInt32 rightIndex, dgSoupBuildBounds& leftBounds, dgSoupBuildBounds& rightBounds) const
+	{
+		leftBounds.Init();
+		rightBounds.Init();
+		for (dgInt32 i = 0; i < count; i ++) {
+			const dgSoupBuildLeaf& leaf = m_leafArray[first + i];
+			if (split.IsLeft (leaf)) {
+				m_tempArray[leftIndex] = leaf;
+				leftBounds.Add (leaf);
+				leftIndex ++;
+			} else {
+				m_tempArray[rightIndex] = leaf;
+				rightBounds.Add (leaf);
+				rightIndex ++;
+			}
+		}
+	}
+
+	void SetChunks (dgInt32 first, dgInt32 count)
+	{
+		m_first = first;
+		m_count = count;
+		m_chunksCount = dgMin ((count + DG_SOUP_BUILD_CHUNK_SIZE - 1) / DG_SOUP_BUILD_CHUNK_SIZE, DG_SOUP_BUILD_MAX_CHUNKS);
+		m_chunkSize = (count + m_chunksCount - 1) / m_chunksCount;
+	}
+
+	void GetChunk (dgInt32 chunk, dgInt32& first, dgInt32& count) const
+	{
+		first = m_first + chunk * m_chunkSize;
+		count = dgMin (m_chunkSize, m_first + m_count - first);
+	}
+
+	void GetBounds (dgSoupBuildBounds& bounds, dgInt32 first, dgInt32 count, bool parallel)
+	{
+		if (parallel) {
+			SetChunks (first, count);
+			ParallelFor (m_chunksCount, BoundsKernel);
+			bounds.Init();
+			for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+				bounds.Merge (m_chunkBounds[i]);
+			}
+		} else {
+			CalculateBounds (bounds, first, count);
+		}
+	}
+
+	// the binning does not pay off for a handful of faces, they are sorted along the widest axis and split in the middle
+	dgInt32 SplitSmallRange (const dgSoupBuildBounds& bounds, dgInt32 first, dgInt32 last)
+	{
+		const dgVector extent (bounds.m_maxCentroid - bounds.m_minCentroid);
+		const dgInt32 axis = (extent.m_x >= extent.m_y) ? ((extent.m_x >= extent.m_z) ? 0 : 2) : ((extent.m_y >= extent.m_z) ? 1 : 2);
+		for (dgInt32 i = first + 1; i <= last; i ++) {
+			const dgSoupBuildLeaf leaf (m_leafArray[i]);
+			const dgFloat32 key = leaf.m_minBox[axis] + leaf.m_maxBox[axis];
+			dgInt32 j = i - 1;
+			for (; (j >= first) && ((m_leafArray[j].m_minBox[axis] + m_leafArray[j].m_maxBox[axis]) > key); j --) {
+				m_leafArray[j + 1] = m_leafArray[j];
+			}
+			m_leafArray[j + 1] = leaf;
+		}
+		return first + (last - first + 1) / 2;
+	}
+
+	static dgInt32 CompareCentroids (const dgSoupBuildLeaf* const leafA, const dgSoupBuildLeaf* const leafB, void* const context)
+	{
+		const dgInt32 axis = *((dgInt32*) context);
+		const dgFloat32 keyA = leafA->m_minBox[axis] + leafA->m_maxBox[axis];
+		const dgFloat32 keyB = leafB->m_minBox[axis] + leafB->m_maxBox[axis];
+		if (keyA < keyB) {
+			return -1;
+		} else if (keyA > keyB) {
+			return 1;
+		}
+		// faces are unique, so the order never depends on the order of the input
+		return (leafA->m_node < leafB->m_node) ? -1 : ((leafA->m_node > leafB->m_node) ? 1 : 0);
+	}
+
+	// the high quality split evaluates the surface area cost between every pair of consecutive faces along each axis,
+	// the area of the right side of each candidate is accumulated backward in the area array of the range
+	dgInt32 SweepSplit (dgInt32 first, dgInt32 last, dgSoupBuildBounds& leftBounds, dgSoupBuildBounds& rightBounds)
+	{
+		const dgInt32 count = last - first + 1;
+		dgSoupBuildLeaf* const sortArray = &m_tempArray[first];
+		dgFloat32* const rightArea = &m_areaArray[first];
+
+		dgInt32 bestAxis = 0;
+		dgInt32 bestCount = count / 2;
+		dgFloat32 bestCost = dgFloat32 (1.0e30f);
+		for (dgInt32 axis = 0; axis < 3; axis ++) {
+			memcpy (sortArray, &m_leafArray[first], count * sizeof (dgSoupBuildLeaf));
+			dgSort (sortArray, count, CompareCentroids, &axis);
+
+			dgVector minBox (sortArray[count - 1].m_minBox);
+			dgVector maxBox (sortArray[count - 1].m_maxBox);
+			for (dgInt32 i = count - 1; i > 0; i --) {
+				minBox = minBox.GetMin(sortArray[i].m_minBox);
+				maxBox = maxBox.GetMax(sortArray[i].m_maxBox);
+				rightArea[i] = dgSoupBuildArea (minBox, maxBox);
+			}
+
+			minBox = sortArray[0].m_minBox;
+			maxBox = sortArray[0].m_maxBox;
+			for (dgInt32 i = 1; i < count; i ++) {
+				const dgFloat32 cost = dgSoupBuildArea (minBox, maxBox) * i + rightArea[i] * (count - i);
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestCount = i;
+				}
+				minBox = minBox.GetMin(sortArray[i].m_minBox);
+				maxBox = maxBox.GetMax(sortArray[i].m_maxBox);
+			}
+		}
+
+		dgSort (&m_leafArray[first], count, CompareCentroids, &bestAxis);
+		CalculateBounds (leftBounds, first, bestCount);
+		CalculateBounds (rightBounds, first + bestCount, count - bestCount);
+		return first + bestCount;
+	}
+
+	// returns the index of the first face of the right child, parallel splits are only issued from the calling thread
+	dgInt32 Split (const dgSoupBuildBounds& bounds, dgInt32 first, dgInt32 last, dgSoupBuildBounds& leftBounds, dgSoupBuildBounds& rightBounds, bool parallel)
+	{
+		const dgInt32 count = last - first + 1;
+		dgAssert (count >= 3);
+
+		dgInt32 mid = -1;
+		if (count <= DG_SOUP_BUILD_SMALL_RANGE) {
+			mid = SplitSmallRange (bounds, first, last);
+		} else if (!parallel && (m_quality >= DG_SOUP_BUILD_QUALITY_HIGH)) {
+			return SweepSplit (first, last, leftBounds, rightBounds);
+		} else {
+			dgSoupBuildSplit split (bounds);
+			dgSoupBuildBins bins;
+			if (parallel) {
+				SetChunks (first, count);
+				m_split = &split;
+				ParallelFor (m_chunksCount, BinsKernel);
+				bins.Init();
+				for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+					bins.Merge (m_chunkBins[i]);
+				}
+			} else {
+				CalculateBins (bins, split, first, count);
+			}
+
+			if (split.Select (bins)) {
+				// the bins already know how many faces go to each side
+				dgInt32 leftCount = 0;
+				for (dgInt32 i = 0; i <= split.m_bin; i ++) {
+					leftCount += bins.m_count[split.m_axis][i];
+				}
+				dgAssert ((leftCount > 0) && (leftCount < count));
+
+				if (parallel) {
+					dgInt32 chunkLeft = 0;
+					for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+						m_chunkLeft[i] = chunkLeft;
+						for (dgInt32 j = 0; j <= split.m_bin; j ++) {
+							chunkLeft += m_chunkBins[i].m_count[split.m_axis][j];
+						}
+					}
+					m_leftCount = leftCount;
+					ParallelFor (m_chunksCount, ScatterKernel);
+					leftBounds.Init();
+					rightBounds.Init();
+					for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+						leftBounds.Merge (m_chunkBounds[i]);
+						rightBounds.Merge (m_chunkRightBounds[i]);
+					}
+				} else {
+					Scatter (split, first, count, first, first + leftCount, leftBounds, rightBounds);
+				}
+				memcpy (&m_leafArray[first], &m_tempArray[first], count * sizeof (dgSoupBuildLeaf));
+				return first + leftCount;
+			}
+
+			// all the centroids are in the same spot, any split is as good as any other
+			mid = first + count / 2;
+		}
+
+		GetBounds (leftBounds, first, mid - first, parallel);
+		GetBounds (rightBounds, mid, last - mid + 1, parallel);
+		return mid;
+	}
+
+	void Link (dgNodeBuilder* const node, dgNodeBuilder* const parent, bool isLeft)
+	{
+		node->m_parent = parent;
+		if (!parent) {
+			m_root = node;
+		} else if (isLeft) {
+			parent->m_left = node;
+		} else {
+			parent->m_right = node;
+		}
+	}
+
+	// splits a range and pushes its two children on the stack, the smaller child on top
+	// so that the stack only grows with the log of the face count
+	dgInt32 SplitRange (dgSoupBuildRange* const stack, dgInt32 stackIndex, const dgSoupBuildRange& range, bool parallel)
+	{
+		const dgSoupBuildTask& task = range.m_task;
+		dgAssert ((stackIndex + 2) <= DG_SOUP_BUILD_STACK_DEPTH);
+
+		dgInt32 mid = task.m_last;
+		dgSoupBuildBounds leftBounds;
+		dgSoupBuildBounds rightBounds;
+		if ((task.m_last - task.m_first) == 1) {
+			CalculateBounds (leftBounds, task.m_first, 1);
+			CalculateBounds (rightBounds, task.m_last, 1);
+		} else {
+			mid = Split (range.m_bounds, task.m_first, task.m_last, leftBounds, rightBounds, parallel);
+		}
+
+		dgNodeBuilder* const node = new (&m_nodeArray[mid - 1]) dgNodeBuilder (range.m_bounds.m_minBox, range.m_bounds.m_maxBox);
+		Link (node, task.m_parent, task.m_isLeft ? true : false);
+
+		dgSoupBuildRange& left = stack[stackIndex + ((mid - task.m_first) < (task.m_last - mid + 1) ? 1 : 0)];
+		left.m_bounds = leftBounds;
+		left.m_task.m_parent = node;
+		left.m_task.m_first = task.m_first;
+		left.m_task.m_last = mid - 1;
+		left.m_task.m_isLeft = 1;
+
+		dgSoupBuildRange& right = stack[stackIndex + ((mid - task.m_first) < (task.m_last - mid + 1) ? 0 : 1)];
+		right.m_bounds = rightBounds;
+		right.m_task.m_parent = node;
+		right.m_task.m_first = mid;
+		right.m_task.m_last = task.m_last;
+		right.m_task.m_isLeft = 0;
+		return stackIndex + 2;
+	}
+
+	void BuildSubTree (const dgSoupBuildTask& task)
+	{
+		dgSoupBuildRange stack[DG_SOUP_BUILD_STACK_DEPTH];
+		stack[0].m_task = task;
+		CalculateBounds (stack[0].m_bounds, task.m_first, task.m_last - task.m_first + 1);
+		dgInt32 stackIndex = 1;
+		while (stackIndex) {
+			stackIndex --;
+			const dgSoupBuildRange range (stack[stackIndex]);
+			if (range.m_task.m_first == range.m_task.m_last) {
+				Link (m_leafArray[range.m_task.m_first].m_node, range.m_task.m_parent, range.m_task.m_isLeft ? true : false);
+			} else {
+				stackIndex = SplitRange (stack, stackIndex, range, false);
+			}
+		}
+	}
+
+	void Build (dgInt32 leafCount)
+	{
+		dgSoupBuildTask root;
+		root.m_parent = NULL;
+		root.m_first = 0;
+		root.m_last = leafCount - 1;
+		root.m_isLeft = 0;
+
+		// split the large ranges until they are small enough to be built by one thread
+		const bool parallel = m_threadPool && (m_threadPool->GetThreadCount() > 1);
+		dgSoupBuildRange stack[DG_SOUP_BUILD_STACK_DEPTH];
+		stack[0].m_task = root;
+		GetBounds (stack[0].m_bounds, 0, leafCount, parallel);
+		dgInt32 stackIndex = 1;
+		while (stackIndex) {
+			stackIndex --;
+			const dgSoupBuildRange range (stack[stackIndex]);
+			if ((range.m_task.m_last - range.m_task.m_first) < DG_SOUP_BUILD_TASK_SIZE) {
+				m_tasks[m_tasksCount] = range.m_task;
+				m_tasksCount ++;
+			} else {
+				stackIndex = SplitRange (stack, stackIndex, range, parallel);
+			}
+		}
+		ParallelFor (m_tasksCount, SubTreeKernel);
+
+		while (m_root->m_parent) {
+			m_root = m_root->m_parent;
+		}
+	}
+
+	static void BoundsKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			dgInt32 first;
+			dgInt32 count;
+			descriptor->GetChunk (i, first, count);
+			descriptor->CalculateBounds (descriptor->m_chunkBounds[i], first, count);
+		}
+	}
+
+	static void BinsKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			dgInt32 first;
+			dgInt32 count;
+			descriptor->GetChunk (i, first, count);
+			descriptor->CalculateBins (descriptor->m_chunkBins[i], *descriptor->m_split, first, count);
+		}
+	}
+
+	static void ScatterKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		// each chunk writes its left faces after the left faces of the chunks before it, and the same for the right faces
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			dgInt32 first;
+			dgInt32 count;
+			descriptor->GetChunk (i, first, count);
+			const dgInt32 leftIndex = descriptor->m_first + descriptor->m_chunkLeft[i];
+			const dgInt32 rightIndex = descriptor->m_first + descriptor->m_leftCount + (first - descriptor->m_first) - descriptor->m_chunkLeft[i];
+			descriptor->Scatter (*descriptor->m_split, first, count, leftIndex, rightIndex, descriptor->m_chunkBounds[i], descriptor->m_chunkRightBounds[i]);
+		}
+	}
+
+	static void SubTreeKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		dTimeTrackerEvent(__FUNCTION__);
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			descriptor->BuildSubTree (descriptor->m_tasks[i]);
+		}
+	}
+
+	dgSoupBuildBounds m_chunkBounds[DG_SOUP_BUILD_MAX_CHUNKS];
+	dgSoupBuildBounds m_chunkRightBounds[DG_SOUP_BUILD_MAX_CHUNKS];
+	dgSoupBuildBins m_chunkBins[DG_SOUP_BUILD_MAX_CHUNKS];
+	dgInt32 m_chunkLeft[DG_SOUP_BUILD_MAX_CHUNKS];
+	dgThreadHive* m_threadPool;
+	dgSoupBuildLeaf* m_leafArray;
+	dgSoupBuildLeaf* m_tempArray;
+	dgNodeBuilder* m_nodeArray;
+	dgNodeBuilder* m_root;
+	const dgSoupBuildSplit* m_split;
+	dgFloat32* m_areaArray;
+	dgArray<dgSoupBuildTask> m_tasks;
+	dgInt32 m_tasksCount;
+	dgInt32 m_quality;
+	dgInt32 m_first;
+	dgInt32 m_count;
+	dgInt32 m_leftCount;
+	dgInt32 m_chunkSize;
+	dgInt32 m_chunksCount;
+} DG_GCC_VECTOR_ALIGMENT;
+
+
 dgAABBPolygonSoup::dgAABBPolygonSoup ()
 	:dgPolygonSoupDatabase()
 	,m_nodesCount(0)
 	,m_indexCount(0)
 	,m_aabb(NULL)
 	,m_indices(NULL)
+	,m_compressedNodes(NULL)
+	,m_mappedImage(false)
 {
 }
 
 dgAABBPolygonSoup::~dgAABBPolygonSoup ()
 {
+	if (m_mappedImage) {
+		// the arrays are part of the application image
+		m_localVertex = NULL;
+		return;
+	}
 	if (m_aabb) {
 		dgFreeStack (m_aabb);
 		dgFreeStack (m_indices);
 	}
+	if (m_compressedNodes) {
+		dgFreeStack (m_compressedNodes);
+		dgFreeStack (m_indices);
+	}
 }
 
 
@@ -435,6 +1037,9 @@ void dgAABBPolygonSoup::GetAABB (dgVector& p0, dgVector& p1) const
 {
 	if (m_aabb) { 
 		GetNodeAABB (m_aabb, p0, p1);
+	} else if (m_compressedNodes) {
+		p0 = dgVector (&m_compressedBox[0][0]);
+		p1 = dgVector (&m_compressedBox[1][0]);
 	} else {
 		p0 = dgVector (dgFloat32 (0.0f));
 		p1 = dgVector (dgFloat32 (0.0f));
@@ -443,13 +1048,31 @@ void dgAABBPolygonSoup::GetAABB (dgVector& p0, dgVector& p1) const
 
 
 
-void dgAABBPolygonSoup::CalculateAdjacendy ()
+// each face only writes its own edge normals, so the faces can be processed in any order by any number of threads
+void dgAABBPolygonSoup::CalculateAdjacendyKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
 {
-	dgVector p0;
-	dgVector p1;
-	GetAABB (p0, p1);
-	dgFastAABBInfo box (p0, p1);
-	ForAllSectors (box, dgVector (dgFloat32 (0.0f)), dgFloat32 (1.0f), CalculateAllFaceEdgeNormals, this);
+	dTimeTrackerEvent(__FUNCTION__);
+	dgAABBPolygonSoup* const me = (dgAABBPolygonSoup*) context;
+	const dgFloat32* const vertexArray = me->GetLocalVertexPool();
+	for (dgInt32 i = start; i < end; i ++) {
+		const dgNode* const node = &me->m_aabb[i];
+		if (node->m_left.IsLeaf() && node->m_left.GetCount()) {
+			CalculateAllFaceEdgeNormals (me, vertexArray, sizeof (dgTriplex), &me->m_indices[node->m_left.GetIndex()], dgInt32 (node->m_left.GetCount()), dgFloat32 (0.0f));
+		}
+		if (node->m_right.IsLeaf() && node->m_right.GetCount()) {
+			CalculateAllFaceEdgeNormals (me, vertexArray, sizeof (dgTriplex), &me->m_indices[node->m_right.GetIndex()], dgInt32 (node->m_right.GetCount()), dgFloat32 (0.0f));
+		}
+	}
+}
+
+void dgAABBPolygonSoup::CalculateAdjacendy (dgThreadHive* const threadPool)
+{
+	dgAssert (!m_compressedNodes);
+	if (threadPool) {
+		threadPool->ParallelFor (m_nodesCount, CalculateAdjacendyKernel, this, 64);
+	} else {
+		CalculateAdjacendyKernel (this, 0, m_nodesCount, 0);
+	}
 
 	dgStack<dgTriplex> pool ((m_indexCount / 2) - 1);
 	const dgTriplex* const vertexArray = (dgTriplex*)GetLocalVertexPool();
@@ -731,7 +1354,7 @@ dgAABBPolygonSoup::dgNodeBuilder* dgAABBPolygonSoup::BuildTopDown (dgNodeBuilder
 
 
 
-void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild)
+void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild, dgThreadHive* const threadPool, dgInt32 quality)
 {
 	if (builder.m_faceCount == 0) {
 		return;
@@ -773,51 +1396,22 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 		polygonIndex += (indexCount + 1);
 	}
 
-	dgNodeBuilder* contructorAllocator = &constructor[allocatorIndex];
-	dgNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator);
-
-	dgAssert (root);
-	if (root->m_left) {
-
-		dgAssert (root->m_right);
-		dgList<dgNodeBuilder*> list (builder.m_allocator);
-		dgList<dgNodeBuilder*> stack (builder.m_allocator);
-		stack.Append(root);
-		while (stack.GetCount()) {
-			dgList<dgNodeBuilder*>::dgListNode* const stackNode = stack.GetLast();
-			dgNodeBuilder* const node = stackNode->GetInfo();
-			stack.Remove(stackNode);
-
-			if (node->m_left) {
-				dgAssert (node->m_right);
-				list.Append(node);
-				stack.Append(node->m_right);
-				stack.Append(node->m_left);
-			} 
-		}
-
-		dgFloat64 newCost = dgFloat32 (1.0e20f);
-		dgFloat64 prevCost = newCost;
-		do {
-			prevCost = newCost;
-			for (dgList<dgNodeBuilder*>::dgListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) {
-				dgNodeBuilder* const node = listNode->GetInfo();
-				ImproveNodeFitness (node);
-			}
-
-			newCost = dgFloat32 (0.0f);
-			for (dgList<dgNodeBuilder*>::dgListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) {
-				dgNodeBuilder* const node = listNode->GetInfo();
-				newCost += node->m_area;
-			}
-		} while (newCost < (prevCost * dgFloat32 (0.9999f)));
-
-		root = list.GetLast()->GetInfo();
-		while (root->m_parent) {
-			root = root->m_parent;
-		}
+	// the face nodes are followed by the interior nodes, one less than the number of faces
+	const dgInt32 leafCount = allocatorIndex;
+	dgStack<dgSoupBuildLeaf> leafArray (leafCount * 2);
+	dgStack<dgFloat32> areaArray (leafCount);
+	for (dgInt32 i = 0; i < leafCount; i ++) {
+		leafArray[i].m_minBox = constructor[i].m_p0;
+		leafArray[i].m_maxBox = constructor[i].m_p1;
+		leafArray[i].m_node = &constructor[i];
 	}
 
+	dgTreeBuildDescriptor* const descriptor = new (builder.m_allocator) dgTreeBuildDescriptor (threadPool, builder.m_allocator, &leafArray[0], &leafArray[leafCount], &areaArray[0], &constructor[leafCount], quality);
+	descriptor->Build (leafCount);
+	dgNodeBuilder* const root = descriptor->m_root;
+	delete descriptor;
+	dgAssert (root && root->m_left && root->m_right);
+
 	dgList<dgNodeBuilder*> list (builder.m_allocator);
 
 	list.Append(root);
@@ -940,35 +1534,95 @@ void dgAABBPolygonSoup::Create (const dgPolygonSoupDatabaseBuilder& builder, boo
 //	CalculateAdjacendy();
 }
 
+// the cost is the expected number of node visits plus face tests of a ray that crosses the root box
+void dgAABBPolygonSoup::GetTreeStats (dgTreeStats& stats) const
+{
+	dgAssert (!m_compressedNodes);
+	stats.m_sahCost = dgFloat32 (0.0f);
+	stats.m_faceCount = 0;
+	stats.m_nodeCount = 0;
+	stats.m_maxDepth = 0;
+	if (!m_aabb) {
+		return;
+	}
+
+	dgVector rootP0;
+	dgVector rootP1;
+	GetNodeAABB (m_aabb, rootP0, rootP1);
+	const dgFloat32 rootArea = dgMax (dgSoupBuildArea (rootP0, rootP1), dgFloat32 (1.0e-12f));
+
+	// the nodes are enumerated breadth first, so a parent always comes before its children
+	dgStack<dgInt32> depth (m_nodesCount);
+	depth[0] = 1;
+	dgFloat64 cost = dgFloat64 (0.0f);
+	for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+		const dgNode* const node = &m_aabb[i];
+		dgInt32 faces = 0;
+		const dgNode::dgLeafNodePtr children[] = {node->m_left, node->m_right};
+		for (dgInt32 j = 0; j < 2; j ++) {
+			if (children[j].IsLeaf()) {
+				faces += children[j].GetCount() ? 1 : 0;
+			} else {
+				const dgInt32 child = dgInt32 (children[j].GetNode(m_aabb) - m_aabb);
+				dgAssert (child > i);
+				depth[child] = depth[i] + 1;
+			}
+		}
+
+		dgVector p0;
+		dgVector p1;
+		GetNodeAABB (node, p0, p1);
+		cost += dgFloat64 (dgSoupBuildArea (p0, p1) / rootArea) * (1 + faces);
+		stats.m_faceCount += faces;
+		stats.m_maxDepth = dgMax (stats.m_maxDepth, depth[i]);
+	}
+	stats.m_sahCost = dgFloat32 (cost);
+	stats.m_nodeCount = m_nodesCount;
+}
+
 void dgAABBPolygonSoup::Serialize (dgSerialize callback, void* const userData) const
 {
+	dgInt32 compressed = m_compressedNodes ? 1 : 0;
 	callback (userData, &m_vertexCount, sizeof (dgInt32));
 	callback (userData, &m_indexCount, sizeof (dgInt32));
 	callback (userData, &m_nodesCount, sizeof (dgInt32));
 	callback (userData, &m_nodesCount, sizeof (dgInt32));
+	callback (userData, &compressed, sizeof (dgInt32));
 	if (m_aabb) {
-		callback (userData,  m_localVertex, sizeof (dgTriplex) * m_vertexCount);
-		callback (userData,  m_indices, sizeof (dgInt32) * m_indexCount);
-		callback (userData, m_aabb, sizeof (dgNode) * m_nodesCount);
+		dgSerializeArray (callback, userData, m_localVertex, sizeof (dgTriplex) * m_vertexCount);
+		dgSerializeArray (callback, userData, m_indices, sizeof (dgInt32) * m_indexCount);
+		dgSerializeArray (callback, userData, m_aabb, sizeof (dgNode) * m_nodesCount);
+	} else if (m_compressedNodes) {
+		dgSerializeArray (callback, userData, m_localVertex, sizeof (dgTriplex) * m_vertexCount);
+		dgSerializeArray (callback, userData, m_indices, sizeof (dgInt32) * m_indexCount);
+		callback (userData, m_compressedBox, sizeof (m_compressedBox));
+		dgSerializeArray (callback, userData, m_compressedNodes, sizeof (dgCompressedNode) * m_nodesCount);
 	}
 }
 
 void dgAABBPolygonSoup::Deserialize (dgDeserialize callback, void* const userData, dgInt32 revisionNumber)
 {
+	dgInt32 compressed = 0;
 	m_strideInBytes = sizeof (dgTriplex);
 	callback (userData, &m_vertexCount, sizeof (dgInt32));
 	callback (userData, &m_indexCount, sizeof (dgInt32));
 	callback (userData, &m_nodesCount, sizeof (dgInt32));
 	callback (userData, &m_nodesCount, sizeof (dgInt32));
+	if (revisionNumber >= m_polygonSoupNodeFormatRevision) {
+		callback (userData, &compressed, sizeof (dgInt32));
+	}
 
+	m_mappedImage = dgIsMappedImage (callback);
 	if (m_vertexCount) {
-		m_localVertex = (dgFloat32*) dgMallocStack (sizeof (dgTriplex) * m_vertexCount);
-		m_indices = (dgInt32*) dgMallocStack (sizeof (dgInt32) * m_indexCount);
-		m_aabb = (dgNode*) dgMallocStack (sizeof (dgNode) * m_nodesCount);
-
-		callback (userData, m_localVertex, sizeof (dgTriplex) * m_vertexCount);
-		callback (userData, m_indices, sizeof (dgInt32) * m_indexCount);
-		callback (userData, m_aabb, sizeof (dgNode) * m_nodesCount);
+		m_localVertex = (dgFloat32*) dgDeserializeArray (callback, userData, sizeof (dgTriplex) * m_vertexCount);
+		m_indices = (dgInt32*) dgDeserializeArray (callback, userData, sizeof (dgInt32) * m_indexCount);
+		if (compressed) {
+			m_aabb = NULL;
+			callback (userData, m_compressedBox, sizeof (m_compressedBox));
+			m_compressedNodes = (dgCompressedNode*) dgDeserializeArray (callback, userData, sizeof (dgCompressedNode) * m_nodesCount);
+		} else {
+			m_aabb = (dgNode*) dgDeserializeArray (callback, userData, sizeof (dgNode) * m_nodesCount);
+		}
 	} else {
 		m_localVertex = NULL;
 		m_indices = NULL;
@@ -977,8 +1631,125 @@ void dgAABBPolygonSoup::Deserialize (dgDeserialize callback, void* const userDat
 }
 
 
+void dgAABBPolygonSoup::QuantizeChildBox (dgCompressedNode* const node, dgInt32 child, const dgVector& origin, const dgVector& scale, const dgVector& p0, const dgVector& p1) const
+{
+	// the min rounds down and the max rounds up, then the decoded box is grown until it contains the exact one.
+	// the decoded box is the frame of the children, so the error does not accumulate down the tree
+	dgUnsigned16* const box = node->m_box[child];
+	for (dgInt32 i = 0; i < 3; i ++) {
+		const dgFloat32 invScale = (scale[i] > dgFloat32 (0.0f)) ? dgFloat32 (1.0f) / scale[i] : dgFloat32 (0.0f);
+		box[i] = dgUnsigned16 (dgClamp (dgFloor ((p0[i] - origin[i]) * invScale), dgFloat32 (0.0f), DG_COMPRESSED_NODE_RANGE));
+		box[i + 3] = dgUnsigned16 (dgClamp (dgCeil ((p1[i] - origin[i]) * invScale), dgFloat32 (0.0f), DG_COMPRESSED_NODE_RANGE));
+	}
+
+	for (bool contained = false; !contained; ) {
+		dgVector q0;
+		dgVector q1;
+		contained = true;
+		node->GetChildBox (child, origin, scale, q0, q1);
+		for (dgInt32 i = 0; i < 3; i ++) {
+			if ((q0[i] > p0[i]) && box[i]) {
+				box[i] --;
+				contained = false;
+			}
+			if ((q1[i] < p1[i]) && (box[i + 3] < dgUnsigned16 (DG_COMPRESSED_NODE_RANGE))) {
+				box[i + 3] ++;
+				contained = false;
+			}
+		}
+	}
+}
+
+void dgAABBPolygonSoup::CompressNodes ()
+{
+	// a tree loaded from a mapped image can not be rewritten in place
+	dgAssert (!m_mappedImage);
+	if (!m_aabb || m_mappedImage) {
+		return;
+	}
+
+	dgAssert (!m_compressedNodes);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+
+	// the box points are one range that follows the mesh vertex and face normals, the edge normals are after it
+	dgInt32 aabbBase = m_vertexCount;
+	dgInt32 aabbEnd = 0;
+	for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+		aabbBase = dgMin (aabbBase, dgMin (m_aabb[i].m_indexBox0, m_aabb[i].m_indexBox1));
+		aabbEnd = dgMax (aabbEnd, dgMax (m_aabb[i].m_indexBox0, m_aabb[i].m_indexBox1) + 1);
+	}
+
+	m_compressedNodes = (dgCompressedNode*) dgMallocStack (sizeof (dgCompressedNode) * m_nodesCount);
+
+	// nodes are enumerated breadth first, the box of a parent is decoded before its children are quantized in its frame
+	dgStack<dgVector> boxPool (m_nodesCount * 2);
+	boxPool[0] = dgVector (&vertexArray[m_aabb[0].m_indexBox0].m_x);
+	boxPool[1] = dgVector (&vertexArray[m_aabb[0].m_indexBox1].m_x);
+	for (dgInt32 i = 0; i < 4; i ++) {
+		m_compressedBox[0][i] = boxPool[0][i];
+		m_compressedBox[1][i] = boxPool[1][i];
+	}
+
+	for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+		const dgNode& node = m_aabb[i];
+		dgCompressedNode& compressedNode = m_compressedNodes[i];
+		memset (compressedNode.m_box, 0, sizeof (compressedNode.m_box));
+		compressedNode.m_left = node.m_left;
+		compressedNode.m_right = node.m_right;
+
+		const dgVector origin (boxPool[i * 2]);
+		const dgVector scale (dgCompressedNode::GetScale (boxPool[i * 2], boxPool[i * 2 + 1]));
+		for (dgInt32 k = 0; k < 2; k ++) {
+			const dgNode::dgLeafNodePtr& child = compressedNode.GetChild (k);
+			if (!child.IsLeaf()) {
+				const dgNode* const childNode = child.GetNode (m_aabb);
+				const dgInt32 index = dgInt32 (childNode - m_aabb);
+				dgAssert (index > i);
+				QuantizeChildBox (&compressedNode, k, origin, scale, dgVector (&vertexArray[childNode->m_indexBox0].m_x), dgVector (&vertexArray[childNode->m_indexBox1].m_x));
+				compressedNode.GetChildBox (k, origin, scale, boxPool[index * 2], boxPool[index * 2 + 1]);
+			}
+		}
+	}
+
+	// the box points are no longer referenced, remove them and move the edge normals down
+	const dgInt32 aabbCount = aabbEnd - aabbBase;
+	for (dgInt32 i = 0; i < m_nodesCount; i ++) {
+		const dgCompressedNode& node = m_compressedNodes[i];
+		for (dgInt32 k = 0; k < 2; k ++) {
+			const dgNode::dgLeafNodePtr& child = node.GetChild (k);
+			if (child.IsLeaf() && child.GetCount()) {
+				const dgInt32 vCount = dgInt32 (child.GetCount());
+				dgInt32* const face = &m_indices[child.GetIndex()];
+				dgAssert (face[vCount + 1] < aabbBase);
+				for (dgInt32 j = 0; j < vCount; j ++) {
+					dgAssert (face[j] < aabbBase);
+					dgInt32& edgeNormal = face[vCount + 2 + j];
+					dgAssert ((edgeNormal < aabbBase) || (edgeNormal >= aabbEnd));
+					if (edgeNormal >= aabbEnd) {
+						edgeNormal -= aabbCount;
+					}
+				}
+			}
+		}
+	}
+
+	dgTriplex* const vertexArray1 = (dgTriplex*) dgMallocStack (sizeof (dgTriplex) * (m_vertexCount - aabbCount));
+	memcpy (vertexArray1, vertexArray, sizeof (dgTriplex) * aabbBase);
+	memcpy (&vertexArray1[aabbBase], &vertexArray[aabbEnd], sizeof (dgTriplex) * (m_vertexCount - aabbEnd));
+	dgFreeStack (m_localVertex);
+	m_localVertex = &vertexArray1[0].m_x;
+	m_vertexCount -= aabbCount;
+
+	dgFreeStack (m_aabb);
+	m_aabb = NULL;
+}
+
 dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) const
 {
+	if (m_compressedNodes) {
+		return ForAllSectorsSupportVectexCompressed (dir);
+	}
+
 	dgVector supportVertex (dgFloat32 (0.0f));
 	if (m_aabb) {
 		dgFloat32 aabbProjection[DG_STACK_DEPTH];
@@ -1010,8 +1781,7 @@ dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) con
 					dgInt32 vCount = me->m_left.GetCount();
 					dgVector vertex (dgFloat32 (0.0f));
 					for (dgInt32 j = 0; j < vCount; j ++) {
-						dgInt32 i0 = m_indices[index + j] * dgInt32 (sizeof (dgTriplex) / sizeof (dgFloat32));
-						dgVector p (&boxArray[i0].m_x);
+						dgVector p (&boxArray[m_indices[index + j]].m_x);
 						dgFloat32 dist = p.DotProduct3 (dir);
 						if (dist > backSupportDist) {
 							backSupportDist = dist;
@@ -1044,8 +1814,7 @@ dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) con
 					dgInt32 vCount = me->m_right.GetCount();
 					dgVector vertex (dgFloat32 (0.0f));
 					for (dgInt32 j = 0; j < vCount; j ++) {
-						dgInt32 i0 = m_indices[index + j] * dgInt32 (sizeof (dgTriplex) / sizeof (dgFloat32));
-						dgVector p (&boxArray[i0].m_x);
+						dgVector p (&boxArray[m_indices[index + j]].m_x);
 						dgFloat32 dist = p.DotProduct3 (dir);
 						if (dist > frontSupportDist) {
 							frontSupportDist = dist;
@@ -1107,6 +1876,11 @@ dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectex (const dgVector& dir) con
 
 void dgAABBPolygonSoup::ForAllSectorsRayHit (const dgFastRayTest& raySrc, dgFloat32 maxParam, dgRayIntersectCallback callback, void* const context) const
 {
+	if (m_compressedNodes) {
+		ForAllSectorsRayHitCompressed (raySrc, maxParam, callback, context);
+		return;
+	}
+
 	const dgNode *stackPool[DG_STACK_DEPTH];
 	dgFloat32 distance[DG_STACK_DEPTH];
 	dgFastRayTest ray (raySrc);
@@ -1187,6 +1961,86 @@ void dgAABBPolygonSoup::ForAllSectorsRayHit (const dgFastRayTest& raySrc, dgFloa
 }
 
 
+// same as ForAllSectorsRayHit, but up to four rays walk the tree together, 
+// a node is visited once for all the rays that reach it and each ray keeps its own max param
+void dgAABBPolygonSoup::ForAllSectorsRayHitPacket (const dgFastRayTest* const* const rays, dgInt32 count, dgFloat32* const maxT, dgRayIntersectCallback callback, void* const* const contexts) const
+{
+	if (m_compressedNodes) {
+		ForAllSectorsRayHitPacketCompressed (rays, count, maxT, callback, contexts);
+		return;
+	}
+
+	const dgNode *stackPool[DG_STACK_DEPTH];
+	dgVector distance[DG_STACK_DEPTH];
+	const dgFastRayPacket packet (rays, count);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+
+	dgVector maxParam (dgFloat32 (0.0f));
+	for (dgInt32 i = 0; i < count; i ++) {
+		maxParam[i] = maxT[i];
+	}
+
+	stackPool[0] = m_aabb;
+	distance[0] = packet.BoxIntersect (dgVector (&vertexArray[m_aabb->m_indexBox0].m_x), dgVector (&vertexArray[m_aabb->m_indexBox1].m_x));
+	dgInt32 stack = 1;
+	while (stack) {
+		stack --;
+		const dgVector dist (distance[stack]);
+		if (!(dist < maxParam).GetSignMask()) {
+			continue;
+		}
+
+		const dgNode* const me = stackPool[stack];
+		const dgNode::dgLeafNodePtr children[] = {me->m_right, me->m_left};
+		const dgNode* nodes[2];
+		dgVector nodeDist[2];
+		dgInt32 nodeCount = 0;
+		for (dgInt32 k = 0; k < 2; k ++) {
+			const dgNode::dgLeafNodePtr& child = children[k];
+			if (child.IsLeaf()) {
+				dgInt32 vCount = child.GetCount();
+				if (vCount > 0) {
+					dgInt32 index = dgInt32 (child.GetIndex());
+					for (dgInt32 mask = (dist < maxParam).GetSignMask(), i = 0; mask; mask >>= 1, i ++) {
+						if (mask & 1) {
+							dgFloat32 param = callback(contexts[i], &vertexArray[0].m_x, sizeof (dgTriplex), &m_indices[index], vCount);
+							dgAssert (param >= dgFloat32 (0.0f));
+							if (param < maxParam[i]) {
+								maxParam[i] = param;
+							}
+						}
+					}
+				}
+			} else {
+				const dgNode* const node = child.GetNode(m_aabb);
+				const dgVector dist1 (packet.BoxIntersect (dgVector (&vertexArray[node->m_indexBox0].m_x), dgVector (&vertexArray[node->m_indexBox1].m_x)));
+				if ((dist1 < maxParam).GetSignMask()) {
+					nodes[nodeCount] = node;
+					nodeDist[nodeCount] = dist1;
+					nodeCount ++;
+				}
+			}
+		}
+
+		// push the farther node first, so that the rays visit the nearest one next
+		if ((nodeCount == 2) && (nodeDist[0].GetMin(maxParam).AddHorizontal().GetScalar() < nodeDist[1].GetMin(maxParam).AddHorizontal().GetScalar())) {
+			dgSwap (nodes[0], nodes[1]);
+			dgSwap (nodeDist[0], nodeDist[1]);
+		}
+		for (dgInt32 k = 0; k < nodeCount; k ++) {
+			dgAssert (stack < DG_STACK_DEPTH);
+			stackPool[stack] = nodes[k];
+			distance[stack] = nodeDist[k];
+			stack ++;
+		}
+	}
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		maxT[i] = maxParam[i];
+	}
+}
+
+
 void dgAABBPolygonSoup::ForAllSectors (const dgFastAABBInfo& obbAabbInfo, const dgVector& boxDistanceTravel, dgFloat32 m_maxT, dgAABBIntersectCallback callback, void* const context) const
 {
 	dgAssert (dgAbsf(dgAbsf(obbAabbInfo[0][0]) - obbAabbInfo.m_absDir[0][0]) < dgFloat32 (1.0e-4f));
@@ -1197,7 +2051,9 @@ void dgAABBPolygonSoup::ForAllSectors (const dgFastAABBInfo& obbAabbInfo, const
 	dgAssert (dgAbsf(dgAbsf(obbAabbInfo[0][2]) - obbAabbInfo.m_absDir[2][0]) < dgFloat32 (1.0e-4f));
 	dgAssert (dgAbsf(dgAbsf(obbAabbInfo[1][2]) - obbAabbInfo.m_absDir[2][1]) < dgFloat32 (1.0e-4f));
 
-	if (m_aabb) {
+	if (m_compressedNodes) {
+		ForAllSectorsCompressed (obbAabbInfo, boxDistanceTravel, m_maxT, callback, context);
+	} else if (m_aabb) {
 		dgFloat32 distance[DG_STACK_DEPTH];
 		const dgNode* stackPool[DG_STACK_DEPTH];
 
@@ -1376,3 +2232,327 @@ void dgAABBPolygonSoup::ForAllSectors (const dgFastAABBInfo& obbAabbInfo, const
 }
 
 
+dgVector dgAABBPolygonSoup::ForAllSectorsSupportVectexCompressed (const dgVector& dir) const
+{
+	dgFloat32 aabbProjection[DG_STACK_DEPTH];
+	dgCompressedNodeBox stackPool[DG_STACK_DEPTH];
+
+	const dgTriplex* const vertexArray = (dgTriplex*)m_localVertex;
+	const dgInt32 ix = (dir[0] > dgFloat32 (0.0f)) ? 1 : 0;
+	const dgInt32 iy = (dir[1] > dgFloat32 (0.0f)) ? 1 : 0;
+	const dgInt32 iz = (dir[2] > dgFloat32 (0.0f)) ? 1 : 0;
+
+	dgVector supportVertex (dgFloat32 (0.0f));
+	dgFloat32 maxProj = dgFloat32 (-1.0e20f); 
+
+	stackPool[0].m_node = m_compressedNodes;
+	stackPool[0].m_p0 = dgVector (&m_compressedBox[0][0]);
+	stackPool[0].m_p1 = dgVector (&m_compressedBox[1][0]);
+	aabbProjection[0] = dgFloat32 (1.0e10f);
+	dgInt32 stack = 1;
+	while (stack) {
+		stack--;
+		if (aabbProjection[stack] > maxProj) {
+			const dgCompressedNodeBox me (stackPool[stack]);
+			const dgVector scale (dgCompressedNode::GetScale (me.m_p0, me.m_p1));
+
+			dgVector box[2][2];
+			dgFloat32 supportDist[2];
+			for (dgInt32 k = 0; k < 2; k ++) {
+				const dgNode::dgLeafNodePtr& child = me.m_node->GetChild (k);
+				if (child.IsLeaf()) {
+					supportDist[k] = dgFloat32 (-1.0e20f);
+					const dgInt32 index = dgInt32 (child.GetIndex());
+					const dgInt32 vCount = dgInt32 (child.GetCount());
+					dgVector vertex (dgFloat32 (0.0f));
+					for (dgInt32 j = 0; j < vCount; j ++) {
+						dgVector p (&vertexArray[m_indices[index + j]].m_x);
+						dgFloat32 dist = p.DotProduct3 (dir);
+						if (dist > supportDist[k]) {
+							supportDist[k] = dist;
+							vertex = p;
+						}
+					}
+					if (supportDist[k] > maxProj) {
+						maxProj = supportDist[k];
+						supportVertex = vertex; 
+					}
+				} else {
+					me.m_node->GetChildBox (k, me.m_p0, scale, box[k][0], box[k][1]);
+					dgVector supportPoint (box[k][ix].m_x, box[k][iy].m_y, box[k][iz].m_z, dgFloat32 (0.0f));
+					supportDist[k] = supportPoint.DotProduct3 (dir);
+				}
+			}
+
+			// the child with the larger projection is pushed last, so that it is visited first
+			const dgInt32 first = (supportDist[1] >= supportDist[0]) ? 0 : 1;
+			for (dgInt32 i = 0; i < 2; i ++) {
+				const dgInt32 k = i ? (1 - first) : first;
+				if (!me.m_node->GetChild (k).IsLeaf()) {
+					aabbProjection[stack] = supportDist[k];
+					stackPool[stack].m_node = me.m_node->GetChildNode (k, m_compressedNodes);
+					stackPool[stack].m_p0 = box[k][0];
+					stackPool[stack].m_p1 = box[k][1];
+					stack++;
+				}
+			}
+		}
+	}
+	return supportVertex;
+}
+
+
+// same as ForAllSectorsRayHit, but the child boxes are decoded in the frame of the parent box
+void dgAABBPolygonSoup::ForAllSectorsRayHitCompressed (const dgFastRayTest& raySrc, dgFloat32 maxParam, dgRayIntersectCallback callback, void* const context) const
+{
+	dgCompressedNodeBox stackPool[DG_STACK_DEPTH];
+	dgFloat32 distance[DG_STACK_DEPTH];
+	dgFastRayTest ray (raySrc);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+
+	stackPool[0].m_node = m_compressedNodes;
+	stackPool[0].m_p0 = dgVector (&m_compressedBox[0][0]);
+	stackPool[0].m_p1 = dgVector (&m_compressedBox[1][0]);
+	distance[0] = ray.BoxIntersect (stackPool[0].m_p0, stackPool[0].m_p1);
+	dgInt32 stack = 1;
+	while (stack) {
+		stack --;
+		if (distance[stack] > maxParam) {
+			break;
+		}
+
+		// the children can be sorted into the slot of the entry, so it is copied
+		const dgCompressedNodeBox me (stackPool[stack]);
+		const dgVector scale (dgCompressedNode::GetScale (me.m_p0, me.m_p1));
+		for (dgInt32 k = 0; k < 2; k ++) {
+			const dgNode::dgLeafNodePtr& child = me.m_node->GetChild (k);
+			if (child.IsLeaf()) {
+				dgInt32 vCount = child.GetCount();
+				if (vCount > 0) {
+					dgInt32 index = dgInt32 (child.GetIndex());
+					dgFloat32 param = callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), &m_indices[index], vCount);
+					dgAssert (param >= dgFloat32 (0.0f));
+					if (param < maxParam) {
+						maxParam = param;
+						if (maxParam == dgFloat32 (0.0f)) {
+							return;
+						}
+					}
+				}
+			} else {
+				dgVector p0;
+				dgVector p1;
+				me.m_node->GetChildBox (k, me.m_p0, scale, p0, p1);
+				dgFloat32 dist1 = ray.BoxIntersect (p0, p1);
+				if (dist1 < maxParam) {
+					dgInt32 j = stack;
+					for ( ; j && (dist1 > distance[j - 1]); j --) {
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+					}
+					dgAssert (stack < DG_STACK_DEPTH);
+					stackPool[j].m_node = me.m_node->GetChildNode (k, m_compressedNodes);
+					stackPool[j].m_p0 = p0;
+					stackPool[j].m_p1 = p1;
+					distance[j] = dist1;
+					stack++;
+				}
+			}
+		}
+	}
+}
+
+
+void dgAABBPolygonSoup::ForAllSectorsRayHitPacketCompressed (const dgFastRayTest* const* const rays, dgInt32 count, dgFloat32* const maxT, dgRayIntersectCallback callback, void* const* const contexts) const
+{
+	dgCompressedNodeBox stackPool[DG_STACK_DEPTH];
+	dgVector distance[DG_STACK_DEPTH];
+	const dgFastRayPacket packet (rays, count);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+
+	dgVector maxParam (dgFloat32 (0.0f));
+	for (dgInt32 i = 0; i < count; i ++) {
+		maxParam[i] = maxT[i];
+	}
+
+	stackPool[0].m_node = m_compressedNodes;
+	stackPool[0].m_p0 = dgVector (&m_compressedBox[0][0]);
+	stackPool[0].m_p1 = dgVector (&m_compressedBox[1][0]);
+	distance[0] = packet.BoxIntersect (stackPool[0].m_p0, stackPool[0].m_p1);
+	dgInt32 stack = 1;
+	while (stack) {
+		stack --;
+		const dgVector dist (distance[stack]);
+		if (!(dist < maxParam).GetSignMask()) {
+			continue;
+		}
+
+		const dgCompressedNodeBox me (stackPool[stack]);
+		const dgVector scale (dgCompressedNode::GetScale (me.m_p0, me.m_p1));
+		dgCompressedNodeBox nodes[2];
+		dgVector nodeDist[2];
+		dgInt32 nodeCount = 0;
+		for (dgInt32 k = 1; k >= 0; k --) {
+			const dgNode::dgLeafNodePtr& child = me.m_node->GetChild (k);
+			if (child.IsLeaf()) {
+				dgInt32 vCount = child.GetCount();
+				if (vCount > 0) {
+					dgInt32 index = dgInt32 (child.GetIndex());
+					for (dgInt32 mask = (dist < maxParam).GetSignMask(), i = 0; mask; mask >>= 1, i ++) {
+						if (mask & 1) {
+							dgFloat32 param = callback(contexts[i], &vertexArray[0].m_x, sizeof (dgTriplex), &m_indices[index], vCount);
+							dgAssert (param >= dgFloat32 (0.0f));
+							if (param < maxParam[i]) {
+								maxParam[i] = param;
+							}
+						}
+					}
+				}
+			} else {
+				dgCompressedNodeBox& node = nodes[nodeCount];
+				me.m_node->GetChildBox (k, me.m_p0, scale, node.m_p0, node.m_p1);
+				const dgVector dist1 (packet.BoxIntersect (node.m_p0, node.m_p1));
+				if ((dist1 < maxParam).GetSignMask()) {
+					node.m_node = me.m_node->GetChildNode (k, m_compressedNodes);
+					nodeDist[nodeCount] = dist1;
+					nodeCount ++;
+				}
+			}
+		}
+
+		if ((nodeCount == 2) && (nodeDist[0].GetMin(maxParam).AddHorizontal().GetScalar() < nodeDist[1].GetMin(maxParam).AddHorizontal().GetScalar())) {
+			dgSwap (nodes[0], nodes[1]);
+			dgSwap (nodeDist[0], nodeDist[1]);
+		}
+		for (dgInt32 k = 0; k < nodeCount; k ++) {
+			dgAssert (stack < DG_STACK_DEPTH);
+			stackPool[stack] = nodes[k];
+			distance[stack] = nodeDist[k];
+			stack ++;
+		}
+	}
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		maxT[i] = maxParam[i];
+	}
+}
+
+
+void dgAABBPolygonSoup::ForAllSectorsCompressed (const dgFastAABBInfo& obbAabbInfo, const dgVector& boxDistanceTravel, dgFloat32 m_maxT, dgAABBIntersectCallback callback, void* const context) const
+{
+	dgFloat32 distance[DG_STACK_DEPTH];
+	dgCompressedNodeBox stackPool[DG_STACK_DEPTH];
+
+	const dgInt32 stride = sizeof (dgTriplex) / sizeof (dgFloat32);
+	const dgTriplex* const vertexArray = (dgTriplex*) m_localVertex;
+
+	stackPool[0].m_node = m_compressedNodes;
+	stackPool[0].m_p0 = dgVector (&m_compressedBox[0][0]);
+	stackPool[0].m_p1 = dgVector (&m_compressedBox[1][0]);
+	dgInt32 stack = 1;
+
+	if (boxDistanceTravel.DotProduct3 (boxDistanceTravel) < dgFloat32 (1.0e-8f)) {
+		distance[0] = dgNode::BoxPenetration (obbAabbInfo, stackPool[0].m_p0, stackPool[0].m_p1);
+		if (distance[0] <= dgFloat32(0.0f)) {
+			obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -distance[0]);
+		}
+		while (stack) {
+			stack --;
+			if (distance[stack] > dgFloat32 (0.0f)) {
+				const dgCompressedNodeBox me (stackPool[stack]);
+				const dgVector scale (dgCompressedNode::GetScale (me.m_p0, me.m_p1));
+				for (dgInt32 k = 0; k < 2; k ++) {
+					const dgNode::dgLeafNodePtr& child = me.m_node->GetChild (k);
+					if (child.IsLeaf()) {
+						dgInt32 index = dgInt32 (child.GetIndex());
+						dgInt32 vCount = child.GetCount();
+						if (vCount > 0) {
+							const dgInt32* const indices = &m_indices[index];
+							dgInt32 normalIndex = indices[vCount + 1];
+							dgVector faceNormal (&vertexArray[normalIndex].m_x);
+							dgFloat32 dist1 = obbAabbInfo.PolygonBoxDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x);
+							if (dist1 > dgFloat32 (0.0f)) {
+								obbAabbInfo.m_separationDistance = dgFloat32(0.0f);
+								dgAssert (vCount >= 3);
+								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, dist1) == t_StopSearh) {
+									return;
+								}
+							} else {
+								obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
+							}
+						}
+					} else {
+						dgVector p0;
+						dgVector p1;
+						me.m_node->GetChildBox (k, me.m_p0, scale, p0, p1);
+						dgFloat32 dist1 = dgNode::BoxPenetration (obbAabbInfo, p0, p1);
+						if (dist1 > dgFloat32 (0.0f)) {
+							dgInt32 j = stack;
+							for ( ; j && (dist1 > distance[j - 1]); j --) {
+								stackPool[j] = stackPool[j - 1];
+								distance[j] = distance[j - 1];
+							}
+							dgAssert (stack < DG_STACK_DEPTH);
+							stackPool[j].m_node = me.m_node->GetChildNode (k, m_compressedNodes);
+							stackPool[j].m_p0 = p0;
+							stackPool[j].m_p1 = p1;
+							distance[j] = dist1;
+							stack++;
+						} else {
+							obbAabbInfo.m_separationDistance = dgMin(obbAabbInfo.m_separationDistance, -dist1);
+						}
+					}
+				}
+			}
+		}
+
+	} else {
+		dgFastRayTest ray (dgVector (dgFloat32 (0.0f)), boxDistanceTravel);
+		dgFastRayTest obbRay (dgVector (dgFloat32 (0.0f)), obbAabbInfo.UnrotateVector(boxDistanceTravel));
+		distance[0] = dgNode::BoxIntersect (ray, obbRay, obbAabbInfo, stackPool[0].m_p0, stackPool[0].m_p1);
+		while (stack) {
+			stack --;
+			if (distance[stack] < dgFloat32 (1.0f)) {
+				const dgCompressedNodeBox me (stackPool[stack]);
+				const dgVector scale (dgCompressedNode::GetScale (me.m_p0, me.m_p1));
+				for (dgInt32 k = 0; k < 2; k ++) {
+					const dgNode::dgLeafNodePtr& child = me.m_node->GetChild (k);
+					if (child.IsLeaf()) {
+						dgInt32 index = dgInt32 (child.GetIndex());
+						dgInt32 vCount = child.GetCount();
+						if (vCount > 0) {
+							const dgInt32* const indices = &m_indices[index];
+							dgInt32 normalIndex = indices[vCount + 1];
+							dgVector faceNormal (&vertexArray[normalIndex].m_x);
+							dgFloat32 hitDistance = obbAabbInfo.PolygonBoxRayDistance (faceNormal, vCount, indices, stride, &vertexArray[0].m_x, ray);
+							if (hitDistance < dgFloat32 (1.0f)) {
+								dgAssert (vCount >= 3);
+								if (callback(context, &vertexArray[0].m_x, sizeof (dgTriplex), indices, vCount, hitDistance) == t_StopSearh) {
+									return;
+								}
+							}
+						}
+					} else {
+						dgVector p0;
+						dgVector p1;
+						me.m_node->GetChildBox (k, me.m_p0, scale, p0, p1);
+						dgFloat32 dist1 = dgNode::BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
+						if (dist1 < dgFloat32 (1.0f)) {
+							dgInt32 j = stack;
+							for ( ; j && (dist1 > distance[j - 1]); j --) {
+								stackPool[j] = stackPool[j - 1];
+								distance[j] = distance[j - 1];
+							}
+							dgAssert (stack < DG_STACK_DEPTH);
+							stackPool[j].m_node = me.m_node->GetChildNode (k, m_compressedNodes);
+							stackPool[j].m_p0 = p0;
+							stackPool[j].m_p1 = p1;
+							distance[j] = dist1;
+							stack ++;
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -27,8 +27,17 @@
 #include "dgPolygonSoupDatabase.h"
 
 
+class dgThreadHive;
 class dgPolygonSoupDatabaseBuilder;
 
+#define DG_COMPRESSED_NODE_RANGE	dgFloat32 (65535.0f)
+// the frame of a compressed node is a little larger than its box, so the top of the range always decodes past the box max
+#define DG_COMPRESSED_NODE_SCALE	(dgFloat32 (1.0001f) / DG_COMPRESSED_NODE_RANGE)
+
+// binned surface area heuristic tree only
+#define DG_SOUP_BUILD_QUALITY_FAST		0
+// the sub trees are split at the best surface area cost over all the faces of the range instead of the bins
+#define DG_SOUP_BUILD_QUALITY_HIGH		1
 
 class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 {
@@ -112,6 +121,18 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 		{
 			dgVector p0 (&vertexArray[m_indexBox0].m_x);
 			dgVector p1 (&vertexArray[m_indexBox1].m_x);
+			return BoxPenetration (obb, p0, p1);
+		}
+
+		DG_INLINE dgFloat32 BoxIntersect (const dgFastRayTest& ray, const dgFastRayTest& obbRay, const dgFastAABBInfo& obb, const dgTriplex* const vertexArray) const
+		{
+			dgVector p0 (&vertexArray[m_indexBox0].m_x);
+			dgVector p1 (&vertexArray[m_indexBox1].m_x);
+			return BoxIntersect (ray, obbRay, obb, p0, p1);
+		}
+
+		static DG_INLINE dgFloat32 BoxPenetration (const dgFastAABBInfo& obb, const dgVector& p0, const dgVector& p1)
+		{
 			dgVector minBox (p0 - obb.m_p1);
 			dgVector maxBox (p1 - obb.m_p0);
 			dgAssert(maxBox.m_x >= minBox.m_x);
@@ -149,10 +170,8 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 			return	dist.GetScalar();
 		}
 
-		DG_INLINE dgFloat32 BoxIntersect (const dgFastRayTest& ray, const dgFastRayTest& obbRay, const dgFastAABBInfo& obb, const dgTriplex* const vertexArray) const
+		static DG_INLINE dgFloat32 BoxIntersect (const dgFastRayTest& ray, const dgFastRayTest& obbRay, const dgFastAABBInfo& obb, const dgVector& p0, const dgVector& p1)
 		{
-			dgVector p0 (&vertexArray[m_indexBox0].m_x);
-			dgVector p1 (&vertexArray[m_indexBox1].m_x);
 			dgVector minBox (p0 - obb.m_p1);
 			dgVector maxBox (p1 - obb.m_p0);
 			dgFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -179,62 +198,156 @@ class dgAABBPolygonSoup: public dgPolygonSoupDatabase
 		dgLeafNodePtr m_right;
 	};
 
+	// same tree as dgNode, but the boxes of both children are stored in the parent, quantized to 16 bits
+	// in the frame of the parent box. a node visit reads one 32 byte node and no box vertex. 
+	// the box of a node is not stored, queries carry the decoded box of the parent down the tree.
+	class dgCompressedNode
+	{
+		public:
+		static DG_INLINE dgVector GetScale (const dgVector& p0, const dgVector& p1)
+		{
+			return (p1 - p0).CompProduct4 (dgVector (DG_COMPRESSED_NODE_SCALE));
+		}
+
+		DG_INLINE const dgNode::dgLeafNodePtr& GetChild (dgInt32 child) const
+		{
+			return child ? m_right : m_left;
+		}
+
+		DG_INLINE const dgCompressedNode* GetChildNode (dgInt32 child, const dgCompressedNode* const root) const
+		{
+			dgAssert (!GetChild (child).IsLeaf());
+			return root + GetChild (child).m_node;
+		}
+
+		DG_INLINE void GetChildBox (dgInt32 child, const dgVector& origin, const dgVector& scale, dgVector& p0, dgVector& p1) const
+		{
+			const dgUnsigned16* const box = m_box[child];
+			p0 = origin + dgVector (dgFloat32 (box[0]), dgFloat32 (box[1]), dgFloat32 (box[2]), dgFloat32 (0.0f)).CompProduct4 (scale);
+			p1 = origin + dgVector (dgFloat32 (box[3]), dgFloat32 (box[4]), dgFloat32 (box[5]), dgFloat32 (0.0f)).CompProduct4 (scale);
+		}
+
+		dgUnsigned16 m_box[2][6];
+		dgNode::dgLeafNodePtr m_left;
+		dgNode::dgLeafNodePtr m_right;
+	};
+
+	DG_MSC_VECTOR_ALIGMENT
+	class dgCompressedNodeBox
+	{
+		public:
+		dgVector m_p0;
+		dgVector m_p1;
+		const dgCompressedNode* m_node;
+	} DG_GCC_VECTOR_ALIGMENT;
+
 	class dgSpliteInfo;
 	class dgNodeBuilder;
+	class dgTreeBuildDescriptor;
+
+	class dgTreeStats
+	{
+		public:
+		dgFloat32 m_sahCost;
+		dgInt32 m_faceCount;
+		dgInt32 m_nodeCount;
+		dgInt32 m_maxDepth;
+	};
 
 	virtual void GetAABB (dgVector& p0, dgVector& p1) const;
 	virtual void Serialize (dgSerialize callback, void* const userData) const;
 	virtual void Deserialize (dgDeserialize callback, void* const userData, dgInt32 revisionNumber);
+	void CompressNodes ();
+	void GetTreeStats (dgTreeStats& stats) const;
 
 	protected:
 	dgAABBPolygonSoup ();
 	virtual ~dgAABBPolygonSoup ();
 
-	void Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild);
-	void CalculateAdjacendy ();
+	void Create (const dgPolygonSoupDatabaseBuilder& builder, bool optimizedBuild, dgThreadHive* const threadPool = NULL, dgInt32 quality = DG_SOUP_BUILD_QUALITY_HIGH);
+	void CalculateAdjacendy (dgThreadHive* const threadPool = NULL);
 	virtual void ForAllSectorsRayHit (const dgFastRayTest& ray, dgFloat32 maxT, dgRayIntersectCallback callback, void* const context) const;
+	void ForAllSectorsRayHitPacket (const dgFastRayTest* const* const rays, dgInt32 count, dgFloat32* const maxT, dgRayIntersectCallback callback, void* const* const contexts) const;
 	virtual void ForAllSectors (const dgFastAABBInfo& obbAabb, const dgVector& boxDistanceTravel, dgFloat32 m_maxT, dgAABBIntersectCallback callback, void* const context) const;
 	
 
 	DG_INLINE void* GetRootNode() const 
 	{
-		return m_aabb;
+		return m_compressedNodes ? (void*) m_compressedNodes : (void*) m_aabb;
 	}
 
 	DG_INLINE void* GetBackNode(const void* const root) const 
 	{
+		if (m_compressedNodes) {
+			const dgCompressedNode* const node = (dgCompressedNode*) root;
+			return node->m_left.IsLeaf() ? NULL : (void*) node->GetChildNode (0, m_compressedNodes);
+		}
 		dgNode* const node = (dgNode*) root;
 		return node->m_left.IsLeaf() ? NULL : node->m_left.GetNode(m_aabb);
 	}
 
 	DG_INLINE void* GetFrontNode(const void* const root) const 
 	{
+		if (m_compressedNodes) {
+			const dgCompressedNode* const node = (dgCompressedNode*) root;
+			return node->m_right.IsLeaf() ? NULL : (void*) node->GetChildNode (1, m_compressedNodes);
+		}
 		dgNode* const node = (dgNode*) root;
 		return node->m_right.IsLeaf() ? NULL : node->m_right.GetNode(m_aabb);
 	}
 
 	DG_INLINE void GetNodeAABB(const void* const root, dgVector& p0, dgVector& p1) const 
 	{
+		if (m_compressedNodes) {
+			// compressed nodes do not store their own box, only the root box can be read directly
+			dgAssert (root == m_compressedNodes);
+			p0 = dgVector (&m_compressedBox[0][0]);
+			p1 = dgVector (&m_compressedBox[1][0]);
+			return;
+		}
 		const dgNode* const node = (dgNode*)root;
 		p0 = dgVector (&((dgTriplex*)m_localVertex)[node->m_indexBox0].m_x);
 		p1 = dgVector (&((dgTriplex*)m_localVertex)[node->m_indexBox1].m_x);
 	}
+
+	// box of the back (child = 0) or front (child = 1) node of root, given the box of root
+	DG_INLINE void GetChildNodeAABB(const void* const root, const dgVector& rootP0, const dgVector& rootP1, dgInt32 child, dgVector& p0, dgVector& p1) const 
+	{
+		if (m_compressedNodes) {
+			const dgCompressedNode* const node = (dgCompressedNode*) root;
+			dgAssert (!node->GetChild (child).IsLeaf());
+			node->GetChildBox (child, rootP0, dgCompressedNode::GetScale (rootP0, rootP1), p0, p1);
+			return;
+		}
+		const dgNode* const node = (dgNode*)root;
+		GetNodeAABB (child ? node->m_right.GetNode(m_aabb) : node->m_left.GetNode(m_aabb), p0, p1);
+	}
 	virtual dgVector ForAllSectorsSupportVectex (const dgVector& dir) const;
 
 	
 
 	private:
 	dgNodeBuilder* BuildTopDown (dgNodeBuilder* const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgNodeBuilder** const allocator) const;
+	static void CalculateAdjacendyKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID);
 	dgFloat32 CalculateFaceMaxSize (const dgVector* const vertex, dgInt32 indexCount, const dgInt32* const indexArray) const;
 //	static dgIntersectStatus CalculateManifoldFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount);
 	static dgIntersectStatus CalculateDisjointedFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 	static dgIntersectStatus CalculateAllFaceEdgeNormals (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance);
 	void ImproveNodeFitness (dgNodeBuilder* const node) const;
 
+	void QuantizeChildBox (dgCompressedNode* const node, dgInt32 child, const dgVector& origin, const dgVector& scale, const dgVector& p0, const dgVector& p1) const;
+	dgVector ForAllSectorsSupportVectexCompressed (const dgVector& dir) const;
+	void ForAllSectorsRayHitCompressed (const dgFastRayTest& ray, dgFloat32 maxT, dgRayIntersectCallback callback, void* const context) const;
+	void ForAllSectorsRayHitPacketCompressed (const dgFastRayTest* const* const rays, dgInt32 count, dgFloat32* const maxT, dgRayIntersectCallback callback, void* const* const contexts) const;
+	void ForAllSectorsCompressed (const dgFastAABBInfo& obbAabb, const dgVector& boxDistanceTravel, dgFloat32 m_maxT, dgAABBIntersectCallback callback, void* const context) const;
+
 	dgInt32 m_nodesCount;
 	dgInt32 m_indexCount;
 	dgNode* m_aabb;
 	dgInt32* m_indices;
+	dgCompressedNode* m_compressedNodes;
+	dgFloat32 m_compressedBox[2][4];
+	bool m_mappedImage;
 };
 
 
@@ -25,6 +25,7 @@
 #include "dgGoogol.h"
 #include "dgConvexHull3d.h"
 #include "dgSmallDeterminant.h"
+#include "dgSimdKernels.h"
 
 #define DG_CONVEXHULL_3D_VERTEX_CLUSTER_SIZE		8 
 
@@ -264,8 +265,9 @@ dgConvexHull3dAABBTreeNode* dgConvexHull3d::BuildTree (dgConvexHull3dAABBTreeNod
 	dgConvexHull3dAABBTreeNode* tree = NULL;
 
 	dgAssert (count);
-	dgBigVector minP ( dgFloat32 (1.0e15f)); 
-	dgBigVector maxP (-dgFloat32 (1.0e15f)); 
+	dgBigVector minP; 
+	dgBigVector maxP; 
+	const dgSimdKernels& kernels = dgSimdKernels::GetKernels();
 	if (count <= DG_CONVEXHULL_3D_VERTEX_CLUSTER_SIZE) {
 
 		dgConvexHull3dPointCluster* const clump = new (*memoryPool) dgConvexHull3dPointCluster;
@@ -277,38 +279,17 @@ dgConvexHull3dAABBTreeNode* dgConvexHull3d::BuildTree (dgConvexHull3dAABBTreeNod
 		clump->m_count = count;
 		for (dgInt32 i = 0; i < count; i ++) {
 			clump->m_indices[i] = i + baseIndex;
-
-			const dgBigVector& p = points[i];
-			minP.m_x = dgMin (p.m_x, minP.m_x); 
-			minP.m_y = dgMin (p.m_y, minP.m_y); 
-			minP.m_z = dgMin (p.m_z, minP.m_z); 
-
-			maxP.m_x = dgMax (p.m_x, maxP.m_x); 
-			maxP.m_y = dgMax (p.m_y, maxP.m_y); 
-			maxP.m_z = dgMax (p.m_z, maxP.m_z); 
 		}
+		kernels.m_pointCloudMoments (&minP.m_x, &maxP.m_x, NULL, NULL, &points[0].m_x, sizeof (dgConvexHull3DVertex), count);
 
 		clump->m_left = NULL;
 		clump->m_right = NULL;
 		tree = clump;
 
 	} else {
-		dgBigVector median (dgFloat32 (0.0f));
-		dgBigVector varian (dgFloat32 (0.0f));
-		for (dgInt32 i = 0; i < count; i ++) {
-
-			const dgBigVector& p = points[i];
-			minP.m_x = dgMin (p.m_x, minP.m_x); 
-			minP.m_y = dgMin (p.m_y, minP.m_y); 
-			minP.m_z = dgMin (p.m_z, minP.m_z); 
-
-			maxP.m_x = dgMax (p.m_x, maxP.m_x); 
-			maxP.m_y = dgMax (p.m_y, maxP.m_y); 
-			maxP.m_z = dgMax (p.m_z, maxP.m_z); 
-
-			median += p;
-			varian += p.CompProduct3 (p);
-		}
+		dgBigVector median;
+		dgBigVector varian;
+		kernels.m_pointCloudMoments (&minP.m_x, &maxP.m_x, &median.m_x, &varian.m_x, &points[0].m_x, sizeof (dgConvexHull3DVertex), count);
 
 		varian = varian.Scale3 (dgFloat32 (count)) - median.CompProduct3(median);
 		dgInt32 index = 0;
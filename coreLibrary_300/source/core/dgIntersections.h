@@ -238,6 +238,59 @@ class dgFastRayTest
 } DG_GCC_VECTOR_ALIGMENT;
 
 
+// up to four rays in SoA form, one ray per lane, so that a single box is tested against all of them at once
+DG_MSC_VECTOR_ALIGMENT 
+class dgFastRayPacket
+{
+	public:
+	DG_INLINE dgFastRayPacket(const dgFastRayTest* const* const rays, dgInt32 count)
+	{
+		dgAssert((count >= 1) && (count <= 4));
+		// unused lanes repeat the last ray, the caller keeps them inactive with a zero max param.
+		// the lanes are transposed with shuffles, the parallel masks are nans and do not survive a scalar float copy
+		const dgFastRayTest& ray0 = *rays[0];
+		const dgFastRayTest& ray1 = *rays[dgMin(1, count - 1)];
+		const dgFastRayTest& ray2 = *rays[dgMin(2, count - 1)];
+		const dgFastRayTest& ray3 = *rays[dgMin(3, count - 1)];
+		dgVector unused;
+		dgVector::Transpose4x4 (m_p0[0], m_p0[1], m_p0[2], unused, ray0.m_p0, ray1.m_p0, ray2.m_p0, ray3.m_p0);
+		dgVector::Transpose4x4 (m_dpInv[0], m_dpInv[1], m_dpInv[2], unused, ray0.m_dpInv, ray1.m_dpInv, ray2.m_dpInv, ray3.m_dpInv);
+		dgVector::Transpose4x4 (m_isParallel[0], m_isParallel[1], m_isParallel[2], unused, ray0.m_isParallel, ray1.m_isParallel, ray2.m_isParallel, ray3.m_isParallel);
+	}
+
+	// same slab test as dgFastRayTest::BoxIntersect, returns the entry param of each lane or 1.2 for a miss
+	DG_INLINE dgVector BoxIntersect(const dgVector& minBox, const dgVector& maxBox) const
+	{
+		const dgVector minX(minBox.BroadcastX());
+		const dgVector minY(minBox.BroadcastY());
+		const dgVector minZ(minBox.BroadcastZ());
+		const dgVector maxX(maxBox.BroadcastX());
+		const dgVector maxY(maxBox.BroadcastY());
+		const dgVector maxZ(maxBox.BroadcastZ());
+
+		const dgVector reject((m_isParallel[0] & ((m_p0[0] <= minX) | (m_p0[0] >= maxX))) |
+							  (m_isParallel[1] & ((m_p0[1] <= minY) | (m_p0[1] >= maxY))) |
+							  (m_isParallel[2] & ((m_p0[2] <= minZ) | (m_p0[2] >= maxZ))));
+
+		const dgVector tx0((minX - m_p0[0]).CompProduct4(m_dpInv[0]));
+		const dgVector tx1((maxX - m_p0[0]).CompProduct4(m_dpInv[0]));
+		const dgVector ty0((minY - m_p0[1]).CompProduct4(m_dpInv[1]));
+		const dgVector ty1((maxY - m_p0[1]).CompProduct4(m_dpInv[1]));
+		const dgVector tz0((minZ - m_p0[2]).CompProduct4(m_dpInv[2]));
+		const dgVector tz1((maxZ - m_p0[2]).CompProduct4(m_dpInv[2]));
+
+		const dgVector t0(dgVector::m_zero.GetMax(tx0.GetMin(tx1)).GetMax(ty0.GetMin(ty1)).GetMax(tz0.GetMin(tz1)));
+		const dgVector t1(dgVector::m_one.GetMin(tx0.GetMax(tx1)).GetMin(ty0.GetMax(ty1)).GetMin(tz0.GetMax(tz1)));
+		const dgVector mask((t0 < t1).AndNot(reject));
+		return (t0 & mask) | dgVector(dgFloat32(1.2f)).AndNot(mask);
+	}
+
+	dgVector m_p0[3];
+	dgVector m_dpInv[3];
+	dgVector m_isParallel[3];
+} DG_GCC_VECTOR_ALIGMENT;
+
+
 DG_MSC_VECTOR_ALIGMENT 
 class dgFastAABBInfo: public dgObb
 {
@@ -393,6 +446,7 @@ class dgFastAABBInfo: public dgObb
 	friend class dgAABBPolygonSoup;
 	friend class dgCollisionUserMesh;
 	friend class dgCollisionHeightField;
+	friend class dgCollisionHeightFieldTiled;
 } DG_GCC_VECTOR_ALIGMENT;
 
 
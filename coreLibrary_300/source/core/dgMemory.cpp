@@ -36,6 +36,60 @@ static dgInt32 m_threadSanityCheck = 0;
 	#define DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK()
 #endif
 
+// the thread slot of the blocks that live in a shared system block
+#define DG_MEMORY_SHARED_BLOCK_SLOT	-1
+
+#ifndef DG_USE_THREAD_EMULATION
+static dgInt32 dgMemoryThreadSlotCounter = 0;
+static dgInt32 dgMemoryThreadSlotInUse[DG_MEMORY_THREAD_SLOTS];
+
+// a thread keeps its slot until it calls ReleaseThreadSlot, the slot is then free for the next thread
+static DG_THREAD_LOCAL dgInt32 dgMemoryThreadSlot = -1;
+static DG_THREAD_LOCAL dgInt32 dgMemoryThreadSlotShared = 0;
+#endif
+
+// each thread claims a free slot the first time it touches a thread safe allocator.
+// With more than DG_MEMORY_THREAD_SLOTS live threads two threads share a slot, the slot lock keeps
+// that case correct but the magazines are contended, so it asserts
+DG_INLINE static dgInt32 dgGetMemoryThreadSlot()
+{
+#ifndef DG_USE_THREAD_EMULATION
+	if (dgMemoryThreadSlot < 0) {
+		const dgInt32 start = dgAtomicExchangeAndAdd(&dgMemoryThreadSlotCounter, 1);
+		for (dgInt32 i = 0; i < DG_MEMORY_THREAD_SLOTS; i ++) {
+			const dgInt32 slot = (start + i) & (DG_MEMORY_THREAD_SLOTS - 1);
+			if (!dgInterlockedExchange(&dgMemoryThreadSlotInUse[slot], 1)) {
+				dgMemoryThreadSlot = slot;
+				break;
+			}
+		}
+		if (dgMemoryThreadSlot < 0) {
+			dgAssert (0);
+			dgMemoryThreadSlot = start & (DG_MEMORY_THREAD_SLOTS - 1);
+			dgMemoryThreadSlotShared = 1;
+		}
+	}
+	return dgMemoryThreadSlot;
+#else
+	return 0;
+#endif
+}
+
+DG_INLINE static void dgMemoryLock (dgInt32* const lock, dgInt32& contention)
+{
+#ifndef DG_USE_THREAD_EMULATION
+	if (dgInterlockedExchange(lock, 1)) {
+		contention ++;
+		dgSpinLock (lock, true);
+	}
+#endif
+}
+
+DG_INLINE static void dgMemoryUnlock (dgInt32* const lock)
+{
+	dgSpinUnlock (lock);
+}
+
 
 class dgMemoryAllocator::dgMemoryBin
 {
@@ -60,6 +114,15 @@ class dgMemoryAllocator::dgMemoryCacheEntry
 	dgMemoryCacheEntry* m_prev;
 };
 
+// the header of a system block shared by the blocks of a MallocBlocks call
+class dgMemoryAllocator::dgMemorySharedBlock
+{
+	public:
+	void* m_ptr;
+	dgInt32 m_size;
+	dgInt32 m_count;
+};
+
 class dgMemoryAllocator::dgMemoryInfo
 {
 	public:
@@ -67,6 +130,7 @@ class dgMemoryAllocator::dgMemoryInfo
 	dgMemoryAllocator* m_allocator;
 	dgInt32 m_size;
 	dgInt32 m_enum;
+	dgInt32 m_threadSlot;
 
 	#ifdef _DEBUG
 	dgInt32 m_workingSize;
@@ -79,12 +143,29 @@ class dgMemoryAllocator::dgMemoryInfo
 		m_enum = enumerator;
 		enumerator++;
 		m_allocator = allocator;
+		m_threadSlot = 0;
 #ifdef _DEBUG
 		m_workingSize = workingSize;
 #endif
 	}
 };
 
+// a magazine is a small stack of free blocks of one size class owned by a thread slot,
+// it is refilled from and drained to the shared bins in batches of half its capacity 
+class dgMemoryAllocator::dgMemoryThreadCache
+{
+	public:
+	class dgMagazine
+	{
+		public:
+		dgInt32 m_count;
+		void* m_blocks[DG_MEMORY_MAGAZINE_SIZE];
+	};
+
+	dgInt32 m_lock;
+	dgMemoryStats m_stats;
+	dgMagazine m_magazines[DG_MEMORY_BIN_ENTRIES];
+};
 
 class dgGlobalAllocator: public dgMemoryAllocator, public dgList<dgMemoryAllocator*>
 {
@@ -140,7 +221,9 @@ class dgGlobalAllocator: public dgMemoryAllocator, public dgList<dgMemoryAllocat
 dgMemoryAllocator::dgMemoryAllocator ()
 	:m_emumerator(0)
 	,m_memoryUsed(0)
+	,m_lock(0)
 	,m_isInList(true)
+	,m_threadCache(NULL)
 	,m_free(NULL)
 	,m_malloc(NULL)
 {
@@ -152,7 +235,9 @@ dgMemoryAllocator::dgMemoryAllocator ()
 dgMemoryAllocator::dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree)
 	:m_emumerator(0)
 	,m_memoryUsed(0)
+	,m_lock(0)
 	,m_isInList(false)
+	,m_threadCache(NULL)
 	,m_free(NULL)
 	,m_malloc(NULL)
 {
@@ -163,6 +248,7 @@ dgMemoryAllocator::dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree)
 
 dgMemoryAllocator::~dgMemoryAllocator  ()
 {
+	SetThreadSafe (false);
 	if (m_isInList) {
 		dgGlobalAllocator::GetGlobalAllocator().Remove(this);
 	}
@@ -221,13 +307,54 @@ void dgMemoryAllocator::FreeLow (void* const retPtr)
 	dgMemoryInfo* const info = ((dgMemoryInfo*) (retPtr)) - 1;
 	dgAssert (info->m_allocator == this);
 
-	dgAtomicExchangeAndAdd (&m_memoryUsed, -info->m_size);
-
 #ifdef _DEBUG
 	memset (retPtr, 0, info->m_workingSize);
 #endif
 
-	m_free (info->m_ptr, dgUnsigned32 (info->m_size));
+	if (info->m_threadSlot == DG_MEMORY_SHARED_BLOCK_SLOT) {
+		dgMemorySharedBlock* const block = (dgMemorySharedBlock*) info->m_ptr;
+		if (dgAtomicExchangeAndAdd (&block->m_count, -1) == 1) {
+			dgAtomicExchangeAndAdd (&m_memoryUsed, -block->m_size);
+			m_free (block->m_ptr, dgUnsigned32 (block->m_size));
+		}
+	} else {
+		dgAtomicExchangeAndAdd (&m_memoryUsed, -info->m_size);
+		m_free (info->m_ptr, dgUnsigned32 (info->m_size));
+	}
+}
+
+void dgMemoryAllocator::MallocBlocks (dgInt32 memsize, dgInt32 count, void** const blocks)
+{
+	dgAssert (count > 0);
+	dgAssert (dgInt32 (sizeof (dgMemorySharedBlock)) <= DG_MEMORY_GRANULARITY);
+
+	// each block is preceded by its info, the info size is the stride in bytes, 
+	// which is always past the bin entries, so Free sends the blocks to FreeLow
+	dgInt32 stride = memsize + DG_MEMORY_GRANULARITY - 1;
+	stride &= (-DG_MEMORY_GRANULARITY);
+	stride += DG_MEMORY_GRANULARITY;
+	dgAssert (stride >= DG_MEMORY_BIN_ENTRIES);
+
+	const dgInt32 size = stride * count + DG_MEMORY_GRANULARITY * 2;
+	void* const ptr = m_malloc(dgUnsigned32 (size));
+	dgAssert (ptr);
+
+	dgUnsigned64 val = dgUnsigned64 (PointerToInt(ptr));
+	val = (val & dgUnsigned64(-DG_MEMORY_GRANULARITY)) + DG_MEMORY_GRANULARITY;
+	dgMemorySharedBlock* const block = (dgMemorySharedBlock*) IntToPointer (val);
+	block->m_ptr = ptr;
+	block->m_size = size;
+	block->m_count = count;
+
+	dgInt8* charPtr = ((dgInt8*) block) + DG_MEMORY_GRANULARITY * 2;
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgMemoryInfo* const info = ((dgMemoryInfo*) (charPtr)) - 1;
+		info->SaveInfo(this, block, stride, m_emumerator, memsize);
+		info->m_threadSlot = DG_MEMORY_SHARED_BLOCK_SLOT;
+		blocks[i] = charPtr;
+		charPtr += stride;
+	}
+	dgAtomicExchangeAndAdd (&m_memoryUsed, size);
 }
 
 // alloca memory on pool that are quantized to DG_MEMORY_GRANULARITY
@@ -245,135 +372,280 @@ void *dgMemoryAllocator::Malloc (dgInt32 memsize)
 	void* ptr;
 	if (entry >= DG_MEMORY_BIN_ENTRIES) {
 		ptr = MallocLow (size);
+	} else if (m_threadCache) {
+		ptr = ThreadCacheMalloc (entry, memsize);
 	} else {
-		if (!m_memoryDirectory[entry].m_cache) {
-			dgMemoryBin* const bin = (dgMemoryBin*) MallocLow (sizeof (dgMemoryBin));
-
-			dgInt32 count = dgInt32 (sizeof (bin->m_pool) / paddedSize);
-			bin->m_info.m_count = 0;
-			bin->m_info.m_totalCount = count;
-			bin->m_info.m_stepInBites = paddedSize;
-			bin->m_info.m_next = m_memoryDirectory[entry].m_first;
-			bin->m_info.m_prev = NULL;
-			if (bin->m_info.m_next) {
-				bin->m_info.m_next->m_info.m_prev = bin;
-			}
+		ptr = MallocEntry (entry, memsize);
+	}
+	return ptr;
+}
 
-			m_memoryDirectory[entry].m_first = bin;
+// alloca memory on pool that are quantized to DG_MEMORY_GRANULARITY
+// if memory size is larger than DG_MEMORY_BIN_ENTRIES then the memory is not placed into a pool
+void dgMemoryAllocator::Free (void* const retPtr)
+{
+	dgMemoryInfo* const info = ((dgMemoryInfo*) (retPtr)) - 1;
+	dgAssert (info->m_allocator == this);
 
-			dgInt8* charPtr = reinterpret_cast<dgInt8*>(bin->m_pool);
-			m_memoryDirectory[entry].m_cache = (dgMemoryCacheEntry*)charPtr;
+	dgInt32 entry = info->m_size;
 
-			for (dgInt32 i = 0; i < count; i ++) {
-				dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) charPtr;
-				cashe->m_next = (dgMemoryCacheEntry*) (charPtr + paddedSize);
-				cashe->m_prev = (dgMemoryCacheEntry*) (charPtr - paddedSize);
-				dgMemoryInfo* const info = ((dgMemoryInfo*) (charPtr + DG_MEMORY_GRANULARITY)) - 1;						
-				info->SaveInfo(this, bin, entry, m_emumerator, memsize);
-				charPtr += paddedSize;
-			}
-			dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (charPtr - paddedSize);
-			cashe->m_next = NULL;
-			m_memoryDirectory[entry].m_cache->m_prev = NULL;
+	if (entry >= DG_MEMORY_BIN_ENTRIES) {
+		FreeLow (retPtr);
+	} else if (m_threadCache) {
+		ThreadCacheFree (retPtr, entry);
+	} else {
+		FreeEntry (retPtr, entry);
+	}
+}
+
+// take one block from the bins of size class entry, a new bin is created when the class is empty
+void* dgMemoryAllocator::MallocEntry (dgInt32 entry, dgInt32 memsize)
+{
+	if (!m_memoryDirectory[entry].m_cache) {
+		dgInt32 paddedSize = entry << DG_MEMORY_GRANULARITY_BITS;
+		dgMemoryBin* const bin = (dgMemoryBin*) MallocLow (sizeof (dgMemoryBin));
+
+		dgInt32 count = dgInt32 (sizeof (bin->m_pool) / paddedSize);
+		bin->m_info.m_count = 0;
+		bin->m_info.m_totalCount = count;
+		bin->m_info.m_stepInBites = paddedSize;
+		bin->m_info.m_next = m_memoryDirectory[entry].m_first;
+		bin->m_info.m_prev = NULL;
+		if (bin->m_info.m_next) {
+			bin->m_info.m_next->m_info.m_prev = bin;
 		}
 
+		m_memoryDirectory[entry].m_first = bin;
 
-		dgAssert (m_memoryDirectory[entry].m_cache);
+		dgInt8* charPtr = reinterpret_cast<dgInt8*>(bin->m_pool);
+		m_memoryDirectory[entry].m_cache = (dgMemoryCacheEntry*)charPtr;
 
-		dgMemoryCacheEntry* const cashe = m_memoryDirectory[entry].m_cache;
-		m_memoryDirectory[entry].m_cache = cashe->m_next;
-		if (cashe->m_next) {
-			cashe->m_next->m_prev = NULL;
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) charPtr;
+			cashe->m_next = (dgMemoryCacheEntry*) (charPtr + paddedSize);
+			cashe->m_prev = (dgMemoryCacheEntry*) (charPtr - paddedSize);
+			dgMemoryInfo* const info = ((dgMemoryInfo*) (charPtr + DG_MEMORY_GRANULARITY)) - 1;						
+			info->SaveInfo(this, bin, entry, m_emumerator, memsize);
+			charPtr += paddedSize;
 		}
+		dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (charPtr - paddedSize);
+		cashe->m_next = NULL;
+		m_memoryDirectory[entry].m_cache->m_prev = NULL;
+	}
 
-		ptr = ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY;
 
-		dgMemoryInfo* info;
-		info = ((dgMemoryInfo*) (ptr)) - 1;
-		dgAssert (info->m_allocator == this);
+	dgAssert (m_memoryDirectory[entry].m_cache);
 
-		dgMemoryBin* const bin = (dgMemoryBin*) info->m_ptr;
-		bin->m_info.m_count ++;
+	dgMemoryCacheEntry* const cashe = m_memoryDirectory[entry].m_cache;
+	m_memoryDirectory[entry].m_cache = cashe->m_next;
+	if (cashe->m_next) {
+		cashe->m_next->m_prev = NULL;
+	}
 
-		#ifdef __TRACK_MEMORY_LEAKS__
-		m_leaklTracker.InsertBlock (dgInt32 (memsize), ptr);
-		#endif
+	void* const ptr = ((dgInt8*)cashe) + DG_MEMORY_GRANULARITY;
+
+	dgMemoryInfo* const info = ((dgMemoryInfo*) (ptr)) - 1;
+	dgAssert (info->m_allocator == this);
+
+	dgMemoryBin* const bin = (dgMemoryBin*) info->m_ptr;
+	bin->m_info.m_count ++;
+
+	#ifdef __TRACK_MEMORY_LEAKS__
+	m_leaklTracker.InsertBlock (dgInt32 (memsize), ptr);
+	#endif
 
-	}
 	return ptr;
 }
 
-// alloca memory on pool that are quantized to DG_MEMORY_GRANULARITY
-// if memory size is larger than DG_MEMORY_BIN_ENTRIES then the memory is not placed into a pool
-void dgMemoryAllocator::Free (void* const retPtr)
+// return one block to the bins of size class entry, the bin is released when all its blocks are free
+void dgMemoryAllocator::FreeEntry (void* const retPtr, dgInt32 entry)
 {
 	dgMemoryInfo* const info = ((dgMemoryInfo*) (retPtr)) - 1;
-	dgAssert (info->m_allocator == this);
-
-	dgInt32 entry = info->m_size;
 
-	if (entry >= DG_MEMORY_BIN_ENTRIES) {
-		FreeLow (retPtr);
-	} else {
-		#ifdef __TRACK_MEMORY_LEAKS__
-		m_leaklTracker.RemoveBlock (retPtr);
-		#endif
+	#ifdef __TRACK_MEMORY_LEAKS__
+	m_leaklTracker.RemoveBlock (retPtr);
+	#endif
 
-		dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY) ;
+	dgMemoryCacheEntry* const cashe = (dgMemoryCacheEntry*) (((char*)retPtr) - DG_MEMORY_GRANULARITY) ;
 
-		dgMemoryCacheEntry* const tmpCashe = m_memoryDirectory[entry].m_cache;
-		if (tmpCashe) {
-			dgAssert (!tmpCashe->m_prev);
-			tmpCashe->m_prev = cashe;
-		}
-		cashe->m_next = tmpCashe;
-		cashe->m_prev = NULL;
+	dgMemoryCacheEntry* const tmpCashe = m_memoryDirectory[entry].m_cache;
+	if (tmpCashe) {
+		dgAssert (!tmpCashe->m_prev);
+		tmpCashe->m_prev = cashe;
+	}
+	cashe->m_next = tmpCashe;
+	cashe->m_prev = NULL;
 
-		m_memoryDirectory[entry].m_cache = cashe;
+	m_memoryDirectory[entry].m_cache = cashe;
 
-		dgMemoryBin* const bin = (dgMemoryBin *) info->m_ptr;
+	dgMemoryBin* const bin = (dgMemoryBin *) info->m_ptr;
 
-		dgAssert (bin);
+	dgAssert (bin);
 #ifdef _DEBUG
-		dgAssert ((bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY) > 0);
-		memset (retPtr, 0, bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY);
+	dgAssert ((bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY) > 0);
+	memset (retPtr, 0, bin->m_info.m_stepInBites - DG_MEMORY_GRANULARITY);
 #endif
 
-		bin->m_info.m_count --;
-		if (bin->m_info.m_count == 0) {
-
-			dgInt32 count = bin->m_info.m_totalCount;
-			dgInt32 sizeInBytes = bin->m_info.m_stepInBites;
-			char* charPtr = bin->m_pool;
-			for (dgInt32 i = 0; i < count; i ++) {
-				dgMemoryCacheEntry* const tmpCashe1 = (dgMemoryCacheEntry*)charPtr;
-				charPtr += sizeInBytes;
+	bin->m_info.m_count --;
+	if (bin->m_info.m_count == 0) {
 
-				if (tmpCashe1 == m_memoryDirectory[entry].m_cache) {
-					m_memoryDirectory[entry].m_cache = tmpCashe1->m_next;
-				}
+		dgInt32 count = bin->m_info.m_totalCount;
+		dgInt32 sizeInBytes = bin->m_info.m_stepInBites;
+		char* charPtr = bin->m_pool;
+		for (dgInt32 i = 0; i < count; i ++) {
+			dgMemoryCacheEntry* const tmpCashe1 = (dgMemoryCacheEntry*)charPtr;
+			charPtr += sizeInBytes;
 
-				if (tmpCashe1->m_prev) {
-					tmpCashe1->m_prev->m_next = tmpCashe1->m_next;
-				}
-
-				if (tmpCashe1->m_next) {
-					tmpCashe1->m_next->m_prev = tmpCashe1->m_prev;
-				}
+			if (tmpCashe1 == m_memoryDirectory[entry].m_cache) {
+				m_memoryDirectory[entry].m_cache = tmpCashe1->m_next;
 			}
 
-			if (m_memoryDirectory[entry].m_first == bin) {
-				m_memoryDirectory[entry].m_first = bin->m_info.m_next;
+			if (tmpCashe1->m_prev) {
+				tmpCashe1->m_prev->m_next = tmpCashe1->m_next;
 			}
 
-			if (bin->m_info.m_next) {
-				bin->m_info.m_next->m_info.m_prev = bin->m_info.m_prev;
+			if (tmpCashe1->m_next) {
+				tmpCashe1->m_next->m_prev = tmpCashe1->m_prev;
 			}
-			if (bin->m_info.m_prev) {
-				bin->m_info.m_prev->m_info.m_next = bin->m_info.m_next;
+		}
+
+		if (m_memoryDirectory[entry].m_first == bin) {
+			m_memoryDirectory[entry].m_first = bin->m_info.m_next;
+		}
+
+		if (bin->m_info.m_next) {
+			bin->m_info.m_next->m_info.m_prev = bin->m_info.m_prev;
+		}
+		if (bin->m_info.m_prev) {
+			bin->m_info.m_prev->m_info.m_next = bin->m_info.m_next;
+		}
+
+		FreeLow (bin);
+	}
+}
+
+// blocks handed out of a magazine stay counted as allocated by their bins, 
+// so the shared bins are only touched, under the allocator lock, when a magazine runs empty or full
+void* dgMemoryAllocator::ThreadCacheMalloc (dgInt32 entry, dgInt32 memsize)
+{
+	const dgInt32 slot = dgGetMemoryThreadSlot();
+	dgMemoryThreadCache& cache = m_threadCache[slot];
+	dgMemoryLock (&cache.m_lock, cache.m_stats.m_lockContention);
+
+	dgMemoryThreadCache::dgMagazine& magazine = cache.m_magazines[entry];
+	if (magazine.m_count) {
+		cache.m_stats.m_magazineHits ++;
+	} else {
+		dgMemoryLock (&m_lock, cache.m_stats.m_lockContention);
+		for (dgInt32 i = 0; i < DG_MEMORY_MAGAZINE_SIZE / 2; i ++) {
+			magazine.m_blocks[i] = MallocEntry (entry, memsize);
+		}
+		dgMemoryUnlock (&m_lock);
+		magazine.m_count = DG_MEMORY_MAGAZINE_SIZE / 2;
+		cache.m_stats.m_refillCount ++;
+	}
+
+	magazine.m_count --;
+	void* const ptr = magazine.m_blocks[magazine.m_count];
+	cache.m_stats.m_mallocCount ++;
+
+	dgMemoryInfo* const info = ((dgMemoryInfo*) (ptr)) - 1;
+	info->m_threadSlot = slot;
+
+	dgMemoryUnlock (&cache.m_lock);
+	return ptr;
+}
+
+// a block freed by a thread other than the one that allocated it simply joins the magazine of the 
+// freeing thread, the bin bookkeeping does not depend on which thread owns the block
+void dgMemoryAllocator::ThreadCacheFree (void* const retPtr, dgInt32 entry)
+{
+	const dgInt32 slot = dgGetMemoryThreadSlot();
+	dgMemoryThreadCache& cache = m_threadCache[slot];
+	dgMemoryLock (&cache.m_lock, cache.m_stats.m_lockContention);
+
+	dgMemoryInfo* const info = ((dgMemoryInfo*) (retPtr)) - 1;
+	if (info->m_threadSlot != slot) {
+		cache.m_stats.m_crossThreadFreeCount ++;
+	}
+
+	dgMemoryThreadCache::dgMagazine& magazine = cache.m_magazines[entry];
+	if (magazine.m_count == DG_MEMORY_MAGAZINE_SIZE) {
+		const dgInt32 base = DG_MEMORY_MAGAZINE_SIZE / 2;
+		dgMemoryLock (&m_lock, cache.m_stats.m_lockContention);
+		for (dgInt32 i = base; i < DG_MEMORY_MAGAZINE_SIZE; i ++) {
+			FreeEntry (magazine.m_blocks[i], entry);
+		}
+		dgMemoryUnlock (&m_lock);
+		magazine.m_count = base;
+		cache.m_stats.m_returnCount ++;
+	}
+
+#ifdef _DEBUG
+	memset (retPtr, 0, (entry << DG_MEMORY_GRANULARITY_BITS) - DG_MEMORY_GRANULARITY);
+#endif
+	magazine.m_blocks[magazine.m_count] = retPtr;
+	magazine.m_count ++;
+	cache.m_stats.m_freeCount ++;
+
+	dgMemoryUnlock (&cache.m_lock);
+}
+
+void dgMemoryAllocator::FlushThreadCache ()
+{
+	for (dgInt32 i = 0; i < DG_MEMORY_THREAD_SLOTS; i ++) {
+		dgMemoryThreadCache& cache = m_threadCache[i];
+		for (dgInt32 j = 0; j < DG_MEMORY_BIN_ENTRIES; j ++) {
+			dgMemoryThreadCache::dgMagazine& magazine = cache.m_magazines[j];
+			for (dgInt32 k = 0; k < magazine.m_count; k ++) {
+				FreeEntry (magazine.m_blocks[k], j);
 			}
+			magazine.m_count = 0;
+		}
+	}
+}
 
-			FreeLow (bin);
+void dgMemoryAllocator::SetThreadSafe (bool state)
+{
+	if (state && !m_threadCache) {
+		m_threadCache = (dgMemoryThreadCache*) MallocLow (DG_MEMORY_THREAD_SLOTS * sizeof (dgMemoryThreadCache));
+		memset (m_threadCache, 0, DG_MEMORY_THREAD_SLOTS * sizeof (dgMemoryThreadCache));
+	} else if (!state && m_threadCache) {
+		FlushThreadCache ();
+		FreeLow (m_threadCache);
+		m_threadCache = NULL;
+	}
+}
+
+void dgMemoryAllocator::ReleaseThreadSlot ()
+{
+#ifndef DG_USE_THREAD_EMULATION
+	if ((dgMemoryThreadSlot >= 0) && !dgMemoryThreadSlotShared) {
+		dgInterlockedExchange(&dgMemoryThreadSlotInUse[dgMemoryThreadSlot], 0);
+	}
+	dgMemoryThreadSlot = -1;
+	dgMemoryThreadSlotShared = 0;
+#endif
+}
+
+bool dgMemoryAllocator::IsThreadSafe () const
+{
+	return m_threadCache ? true : false;
+}
+
+void dgMemoryAllocator::GetStats (dgMemoryStats& stats) const
+{
+	memset (&stats, 0, sizeof (dgMemoryStats));
+	if (m_threadCache) {
+		for (dgInt32 i = 0; i < DG_MEMORY_THREAD_SLOTS; i ++) {
+			const dgMemoryStats& slotStats = m_threadCache[i].m_stats;
+			stats.m_mallocCount += slotStats.m_mallocCount;
+			stats.m_freeCount += slotStats.m_freeCount;
+			stats.m_magazineHits += slotStats.m_magazineHits;
+			stats.m_refillCount += slotStats.m_refillCount;
+			stats.m_returnCount += slotStats.m_returnCount;
+			stats.m_crossThreadFreeCount += slotStats.m_crossThreadFreeCount;
+			stats.m_lockContention += slotStats.m_lockContention;
 		}
 	}
 }
@@ -468,12 +740,10 @@ dgInt32 dgMemoryAllocator::GetGlobalMemoryUsed ()
 // this by pases the pool allocation because this should only be used for very large memory blocks.
 // this was using virtual memory on windows but 
 // but because of many complaint I changed it to use malloc and free
+// the global allocator goes straight to the system heap, so worker threads can build their own stack pools
 void* dgApi dgMallocStack (size_t size)
 {
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
-	void * const ptr = dgGlobalAllocator::GetGlobalAllocator().MallocLow (dgInt32 (size));
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
-	return ptr;
+	return dgGlobalAllocator::GetGlobalAllocator().MallocLow (dgInt32 (size));
 }
 
 void* dgApi dgMallocAligned (size_t size, dgInt32 align)
@@ -491,9 +761,7 @@ void* dgApi dgMallocAligned (size_t size, dgInt32 align)
 // but because of many complaint I changed it to use malloc and free
 void  dgApi dgFreeStack (void* const ptr)
 {
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 	dgGlobalAllocator::GetGlobalAllocator().FreeLow (ptr);
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 }
 
 
@@ -503,12 +771,15 @@ void* dgApi dgMalloc (size_t size, dgMemoryAllocator* const allocator)
 	void* ptr = NULL;
 	dgAssert (allocator);
 
-	DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 	if (size) {
-		ptr = allocator->Malloc (dgInt32 (size));
+		if (allocator->IsThreadSafe()) {
+			ptr = allocator->Malloc (dgInt32 (size));
+		} else {
+			DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
+			ptr = allocator->Malloc (dgInt32 (size));
+			DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
+		}
 	}
-
-	DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
 	return ptr;
 }
 
@@ -517,12 +788,16 @@ void* dgApi dgMalloc (size_t size, dgMemoryAllocator* const allocator)
 void dgApi dgFree (void* const ptr)
 {
 	if (ptr) {
-		DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
 		dgMemoryAllocator::dgMemoryInfo* info;
 		info = ((dgMemoryAllocator::dgMemoryInfo*) ptr) - 1; 
 		dgAssert (info->m_allocator);
-		info->m_allocator->Free (ptr);
-		DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
+		if (info->m_allocator->IsThreadSafe()) {
+			info->m_allocator->Free (ptr);
+		} else {
+			DG_MEMORY_THREAD_SANITY_CHECK_LOCK();
+			info->m_allocator->Free (ptr);
+			DG_MEMORY_THREAD_SANITY_CHECK_UNLOCK();
+		}
 	}
 }
 
@@ -75,11 +75,28 @@ class dgMemoryAllocator
 	#define DG_MEMORY_SIZE						(1024 - 64)
 	#define DG_MEMORY_BIN_SIZE					(1024 * 16)
 	#define DG_MEMORY_BIN_ENTRIES				(DG_MEMORY_SIZE / DG_MEMORY_GRANULARITY)
+	#define DG_MEMORY_THREAD_SLOTS				32
+	#define DG_MEMORY_MAGAZINE_SIZE				32
 
 	public: 
 	class dgMemoryBin;
 	class dgMemoryInfo;
 	class dgMemoryCacheEntry;
+	class dgMemoryThreadCache;
+	class dgMemorySharedBlock;
+
+	// counters collected by the thread safe mode, summed over all thread slots
+	class dgMemoryStats
+	{
+		public: 
+		dgInt32 m_mallocCount;
+		dgInt32 m_freeCount;
+		dgInt32 m_magazineHits;
+		dgInt32 m_refillCount;
+		dgInt32 m_returnCount;
+		dgInt32 m_crossThreadFreeCount;
+		dgInt32 m_lockContention;
+	};
 
 	class dgMemDirectory
 	{
@@ -128,20 +145,43 @@ class dgMemoryAllocator
 	virtual void *Malloc (dgInt32 memsize);
 	virtual void Free (void* const retPtr);
 
+	// allocates count blocks of the same size back to back from one system block, each block is released 
+	// with Free like any other, the system block goes back when the last of its blocks is released
+	void MallocBlocks (dgInt32 memsize, dgInt32 count, void** const blocks);
+
+	// in thread safe mode small blocks are served from per thread magazines, 
+	// the mode should only be changed when no other thread is using the allocator
+	void SetThreadSafe (bool state);
+	bool IsThreadSafe () const;
+	void GetStats (dgMemoryStats& stats) const;
+
 	static dgInt32 GetGlobalMemoryUsed ();
 	static void SetGlobalAllocators (dgMemAlloc alloc, dgMemFree free);
 
+	// gives back the thread slot of the calling thread, engine threads call it before they exit,
+	// blocks already handed out stay valid and the thread claims a new slot if it allocates again
+	static void ReleaseThreadSlot ();
+
 	protected:
 	dgMemoryAllocator (bool init)
 	{	
 		m_memoryUsed = 0;
 		m_isInList = false;
+		m_threadCache = NULL;
 	}
 	dgMemoryAllocator (dgMemAlloc memAlloc, dgMemFree memFree);
 
+	void* MallocEntry (dgInt32 entry, dgInt32 memsize);
+	void FreeEntry (void* const retPtr, dgInt32 entry);
+	void* ThreadCacheMalloc (dgInt32 entry, dgInt32 memsize);
+	void ThreadCacheFree (void* const retPtr, dgInt32 entry);
+	void FlushThreadCache ();
+
 	dgInt32 m_emumerator;
 	dgInt32 m_memoryUsed;
+	dgInt32 m_lock;
 	bool m_isInList;
+	dgMemoryThreadCache* m_threadCache;
 	dgMemFree m_free;
 	dgMemAlloc m_malloc;
 	dgMemDirectory m_memoryDirectory[DG_MEMORY_BIN_ENTRIES + 1]; 
@@ -29,6 +29,7 @@
 #include "dgMatrix.h"
 #include "dgMemory.h"
 #include "dgPolyhedra.h"
+#include "dgThreadHive.h"
 #include "dgPolygonSoupBuilder.h"
 
 #define DG_POINTS_RUN (512 * 1024)
@@ -82,6 +83,48 @@ class dgPolygonSoupDatabaseBuilder::dgFaceMap: public dgTree<dgFaceBucket, dgInt
 };
 
 
+class dgPolygonSoupDatabaseBuilder::dgOptimizePartition
+{
+	public:
+	dgPolygonSoupDatabaseBuilder* m_builder;
+	dgInt32 m_faceId;
+	dgInt32 m_start;
+	dgInt32 m_count;
+};
+
+// the faces of each partition, in the order the partitions are added back to the mesh
+class dgPolygonSoupDatabaseBuilder::dgOptimizeDescriptor
+{
+	public:
+	dgOptimizeDescriptor (const dgPolygonSoupDatabaseBuilder& source)
+		:m_source(source)
+		,m_faces(source.m_allocator)
+		,m_partitions(source.m_allocator)
+		,m_facesCount(0)
+		,m_partitionsCount(0)
+	{
+	}
+
+	void AddPartition (dgInt32 faceId, dgInt32 start, dgInt32 count)
+	{
+		dgAssert (start == m_facesCount);
+		dgOptimizePartition& partition = m_partitions[m_partitionsCount];
+		partition.m_builder = NULL;
+		partition.m_faceId = faceId;
+		partition.m_start = start;
+		partition.m_count = count;
+		m_facesCount += count;
+		m_partitionsCount ++;
+	}
+
+	const dgPolygonSoupDatabaseBuilder& m_source;
+	dgArray<dgFaceInfo> m_faces;
+	dgArray<dgOptimizePartition> m_partitions;
+	dgInt32 m_facesCount;
+	dgInt32 m_partitionsCount;
+};
+
+
 class dgPolygonSoupDatabaseBuilder::dgPolySoupFilterAllocator: public dgPolyhedra
 {
 	public: 
@@ -464,17 +507,31 @@ void dgPolygonSoupDatabaseBuilder::OptimizeByIndividualFaces()
 }
 
 
-void dgPolygonSoupDatabaseBuilder::End(bool optimize)
+void dgPolygonSoupDatabaseBuilder::End(bool optimize, dgThreadHive* const threadPool)
 {
 	if (optimize) {
 		dgPolygonSoupDatabaseBuilder copy (*this);
 		dgFaceMap faceMap (m_allocator, copy);
 
-		Begin();
+		dgOptimizeDescriptor descriptor (copy);
 		dgFaceMap::Iterator iter (faceMap);
 		for (iter.Begin(); iter; iter ++) {
 			const dgFaceBucket& bucket = iter.GetNode()->GetInfo();
-			Optimize(iter.GetNode()->GetKey(), bucket, copy);
+			Optimize(iter.GetNode()->GetKey(), bucket, copy, descriptor);
+		}
+
+		// the partitions only read the copy, so they are merged concurrently, 
+		// but they are added back in the order they were made so the mesh does not depend on the thread count
+		if (threadPool) {
+			threadPool->ParallelFor (descriptor.m_partitionsCount, OptimizePartitionKernel, &descriptor, 1);
+		} else {
+			OptimizePartitionKernel (&descriptor, 0, descriptor.m_partitionsCount, 0);
+		}
+
+		Begin();
+		for (dgInt32 i = 0; i < descriptor.m_partitionsCount; i ++) {
+			AddOptimizedPartition (descriptor.m_partitions[i]);
+			delete descriptor.m_partitions[i].m_builder;
 		}
 	}
 	Finalize();
@@ -511,15 +568,13 @@ void dgPolygonSoupDatabaseBuilder::End(bool optimize)
 }
 
 
-void dgPolygonSoupDatabaseBuilder::Optimize(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source)
+void dgPolygonSoupDatabaseBuilder::Optimize(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source, dgOptimizeDescriptor& descriptor)
 {
 	#define DG_MESH_PARTITION_SIZE (1024 * 4)
 
 	const dgInt32* const indexArray = &source.m_vertexIndex[0];
 	const dgBigVector* const points = &source.m_vertexPoints[0];
 
-	dgVector face[256];
-	dgInt32 faceIndex[256];
 	if (faceBucket.GetCount() >= DG_MESH_PARTITION_SIZE) {
 		dgStack<dgFaceBucket::dgListNode*> array(faceBucket.GetCount());
 		dgInt32 count = 0;
@@ -540,37 +595,11 @@ void dgPolygonSoupDatabaseBuilder::Optimize(dgInt32 faceId, const dgFaceBucket&
 			dgInt32 faceCount = segments[stack][1];
 
 			if (faceCount <= DG_MESH_PARTITION_SIZE) {
-
-				dgPolygonSoupDatabaseBuilder tmpBuilder (m_allocator);
+				const dgInt32 start = descriptor.m_facesCount;
 				for (dgInt32 i = 0; i < faceCount; i ++) {
-					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
-
-					dgInt32 count1 = faceInfo.indexCount - 1;
-					dgInt32 start1 = faceInfo.indexStart;
-					dgAssert (faceId == indexArray[start1 + count1]);
-					for (dgInt32 j = 0; j < count1; j ++) {
-						dgInt32 index = indexArray[start1 + j];
-						face[j] = points[index];
-						faceIndex[j] = j;
-					}
-					dgInt32 faceIndexCount = count1;
-					tmpBuilder.AddMesh (&face[0].m_x, count1, sizeof (dgVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dgGetIdentityMatrix()); 
-				}
-				tmpBuilder.FinalizeAndOptimize ();
-
-				dgInt32 faceIndexNumber = 0;
-				for (dgInt32 i = 0; i < tmpBuilder.m_faceCount; i ++) {
-					dgInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-					for (dgInt32 j = 0; j < indexCount; j ++) {
-						dgInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-						face[j] = tmpBuilder.m_vertexPoints[index];
-						faceIndex[j] = j;
-					}
-					dgInt32 faceArray = indexCount;
-					AddMesh (&face[0].m_x, indexCount, sizeof (dgVector), 1, &faceArray, faceIndex, &faceId, dgGetIdentityMatrix());
-
-					faceIndexNumber += (indexCount + 1); 
+					descriptor.m_faces[start + i] = array[faceStart + i]->GetInfo();
 				}
+				descriptor.AddPartition (faceId, start, faceCount);
 
 			} else {
 				dgBigVector median (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
@@ -649,36 +678,67 @@ void dgPolygonSoupDatabaseBuilder::Optimize(dgInt32 faceId, const dgFaceBucket&
 		}
 	
 	} else {
-		dgPolygonSoupDatabaseBuilder tmpBuilder (m_allocator);
+		const dgInt32 start = descriptor.m_facesCount;
+		dgInt32 count = 0;
 		for (dgFaceBucket::dgListNode* node = faceBucket.GetFirst(); node; node = node->GetNext()) {
-			const dgFaceInfo& faceInfo = node->GetInfo();
+			descriptor.m_faces[start + count] = node->GetInfo();
+			count ++;
+		}
+		descriptor.AddPartition (faceId, start, count);
+	}
+}
+
+void dgPolygonSoupDatabaseBuilder::OptimizePartitionKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgOptimizeDescriptor* const descriptor = (dgOptimizeDescriptor*) context;
+	const dgInt32* const indexArray = &descriptor->m_source.m_vertexIndex[0];
+	const dgBigVector* const points = &descriptor->m_source.m_vertexPoints[0];
+
+	dgVector face[256];
+	dgInt32 faceIndex[256];
+	for (dgInt32 i = start; i < end; i ++) {
+		dgOptimizePartition& partition = descriptor->m_partitions[i];
+		dgInt32 faceId = partition.m_faceId;
+		dgPolygonSoupDatabaseBuilder* const tmpBuilder = new (descriptor->m_source.m_allocator) dgPolygonSoupDatabaseBuilder (descriptor->m_source.m_allocator);
+		for (dgInt32 j = 0; j < partition.m_count; j ++) {
+			const dgFaceInfo& faceInfo = descriptor->m_faces[partition.m_start + j];
 
 			dgInt32 count = faceInfo.indexCount - 1;
-			dgInt32 start = faceInfo.indexStart;
-			dgAssert (faceId == indexArray[start + count]);
-			for (dgInt32 j = 0; j < count; j ++) {
-				dgInt32 index = indexArray[start + j];
-				face[j] = points[index];
-				faceIndex[j] = j;
+			dgInt32 start1 = faceInfo.indexStart;
+			dgAssert (faceId == indexArray[start1 + count]);
+			for (dgInt32 k = 0; k < count; k ++) {
+				dgInt32 index = indexArray[start1 + k];
+				face[k] = points[index];
+				faceIndex[k] = k;
 			}
 			dgInt32 faceIndexCount = count;
-			tmpBuilder.AddMesh (&face[0].m_x, count, sizeof (dgVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dgGetIdentityMatrix()); 
+			tmpBuilder->AddMesh (&face[0].m_x, count, sizeof (dgVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dgGetIdentityMatrix()); 
 		}
-		tmpBuilder.FinalizeAndOptimize ();
-
-		dgInt32 faceIndexNumber = 0;
-		for (dgInt32 i = 0; i < tmpBuilder.m_faceCount; i ++) {
-			dgInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-			for (dgInt32 j = 0; j < indexCount; j ++) {
-				dgInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-				face[j] = tmpBuilder.m_vertexPoints[index];
-				faceIndex[j] = j;
-			}
-			dgInt32 faceArray = indexCount;
-			AddMesh (&face[0].m_x, indexCount, sizeof (dgVector), 1, &faceArray, faceIndex, &faceId, dgGetIdentityMatrix());
+		tmpBuilder->FinalizeAndOptimize ();
+		partition.m_builder = tmpBuilder;
+	}
+}
+
+void dgPolygonSoupDatabaseBuilder::AddOptimizedPartition (const dgOptimizePartition& partition)
+{
+	dgVector face[256];
+	dgInt32 faceIndex[256];
 
-			faceIndexNumber += (indexCount + 1); 
+	const dgPolygonSoupDatabaseBuilder& tmpBuilder = *partition.m_builder;
+	dgInt32 faceId = partition.m_faceId;
+	dgInt32 faceIndexNumber = 0;
+	for (dgInt32 i = 0; i < tmpBuilder.m_faceCount; i ++) {
+		dgInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
+		for (dgInt32 j = 0; j < indexCount; j ++) {
+			dgInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
+			face[j] = tmpBuilder.m_vertexPoints[index];
+			faceIndex[j] = j;
 		}
+		dgInt32 faceArray = indexCount;
+		AddMesh (&face[0].m_x, indexCount, sizeof (dgVector), 1, &faceArray, faceIndex, &faceId, dgGetIdentityMatrix());
+
+		faceIndexNumber += (indexCount + 1); 
 	}
 }
 
@@ -33,6 +33,8 @@
 #include "dgArray.h"
 #include "dgIntersections.h"
 
+class dgThreadHive;
+
 
 class AdjacentdFace
 {
@@ -49,6 +51,8 @@ class dgPolygonSoupDatabaseBuilder
 	class dgFaceInfo;
 	class dgFaceBucket;
 	class dgPolySoupFilterAllocator;
+	class dgOptimizePartition;
+	class dgOptimizeDescriptor;
 	public:
 
 	dgPolygonSoupDatabaseBuilder (dgMemoryAllocator* const allocator);
@@ -58,12 +62,14 @@ class dgPolygonSoupDatabaseBuilder
 	DG_CLASS_ALLOCATOR(allocator)
 
 	void Begin();
-	void End(bool optimize);
+	void End(bool optimize, dgThreadHive* const threadPool = NULL);
 	void AddMesh (const dgFloat32* const vertex, dgInt32 vertexCount, dgInt32 strideInBytes, dgInt32 faceCount, 
 		          const dgInt32* const faceArray, const dgInt32* const indexArray, const dgInt32* const faceTagsData, const dgMatrix& worldMatrix); 
 
 	private:
-	void Optimize(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source);
+	void Optimize(dgInt32 faceId, const dgFaceBucket& faceBucket, const dgPolygonSoupDatabaseBuilder& source, dgOptimizeDescriptor& descriptor);
+	void AddOptimizedPartition (const dgOptimizePartition& partition);
+	static void OptimizePartitionKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID);
 
 	void Finalize();
 	void FinalizeAndOptimize();
@@ -0,0 +1,206 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgStdafx.h"
+#include "dgTypes.h"
+#include "dgVector.h"
+#include "dgSimdKernels.h"
+
+#ifdef DG_SIMD_KERNELS_RUNTIME_DISPATCH
+	#if (defined (_WIN_32_VER) || defined (_WIN_64_VER)) && !defined (__GNUC__)
+		#include <intrin.h>
+		#define DG_AVX2_TARGET
+	#else
+		#include <immintrin.h>
+		#define DG_AVX2_TARGET __attribute__ ((target ("avx2,fma")))
+	#endif
+#endif
+
+
+static void dgPointCloudMomentsDefault (dgFloat64* const minOut, dgFloat64* const maxOut, dgFloat64* const sumOut, dgFloat64* const sumSquareOut, const dgFloat64* const points, dgInt32 strideInBytes, dgInt32 count)
+{
+	dgInt32 stride = dgInt32 (strideInBytes / sizeof (dgFloat64));
+	dgAssert (stride >= 3);
+	dgAssert (count >= 1);
+
+	dgBigVector minP (points[0], points[1], points[2], dgFloat64 (0.0f));
+	dgBigVector maxP (minP);
+	dgBigVector sum (dgBigVector::m_zero);
+	dgBigVector sumSquare (dgBigVector::m_zero);
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgFloat64* const ptr = &points[i * stride];
+		dgBigVector p (ptr[0], ptr[1], ptr[2], dgFloat64 (0.0f));
+		minP = minP.GetMin (p);
+		maxP = maxP.GetMax (p);
+		sum += p;
+		sumSquare += p.CompProduct4 (p);
+	}
+
+	for (dgInt32 i = 0; i < 4; i ++) {
+		minOut[i] = minP[i];
+		maxOut[i] = maxP[i];
+	}
+	if (sumOut) {
+		for (dgInt32 i = 0; i < 4; i ++) {
+			sumOut[i] = sum[i];
+		}
+	}
+	if (sumSquareOut) {
+		for (dgInt32 i = 0; i < 4; i ++) {
+			sumSquareOut[i] = sumSquare[i];
+		}
+	}
+}
+
+
+#ifdef DG_SIMD_KERNELS_RUNTIME_DISPATCH
+
+// this function is compiled for AVX2 regardless of the library flags, so it can not call 
+// any of the dgVector inline functions, those may be emitted with AVX2 code in this unit.
+// it reads two points per iteration, eight doubles, into two independent accumulator sets.
+DG_AVX2_TARGET static void dgPointCloudMomentsAvx2 (dgFloat64* const minOut, dgFloat64* const maxOut, dgFloat64* const sumOut, dgFloat64* const sumSquareOut, const dgFloat64* const points, dgInt32 strideInBytes, dgInt32 count)
+{
+	dgInt32 stride = dgInt32 (strideInBytes / sizeof (dgFloat64));
+	dgAssert (stride >= 3);
+	dgAssert (count >= 1);
+
+	// the masked load does not touch the w component, a tight array of three doubles can not overrun its end
+	const __m256i mask (_mm256_set_epi64x (0, -1, -1, -1));
+	__m256d min0 (_mm256_maskload_pd (points, mask));
+	__m256d max0 (min0);
+	__m256d sum0 (_mm256_setzero_pd());
+	__m256d sumSquare0 (_mm256_setzero_pd());
+	__m256d min1 (min0);
+	__m256d max1 (min0);
+	__m256d sum1 (_mm256_setzero_pd());
+	__m256d sumSquare1 (_mm256_setzero_pd());
+
+	dgInt32 i = 0;
+	for (; i < (count - 1); i += 2) {
+		const __m256d p0 (_mm256_maskload_pd (&points[i * stride], mask));
+		const __m256d p1 (_mm256_maskload_pd (&points[(i + 1) * stride], mask));
+		min0 = _mm256_min_pd (min0, p0);
+		min1 = _mm256_min_pd (min1, p1);
+		max0 = _mm256_max_pd (max0, p0);
+		max1 = _mm256_max_pd (max1, p1);
+		sum0 = _mm256_add_pd (sum0, p0);
+		sum1 = _mm256_add_pd (sum1, p1);
+		sumSquare0 = _mm256_fmadd_pd (p0, p0, sumSquare0);
+		sumSquare1 = _mm256_fmadd_pd (p1, p1, sumSquare1);
+	}
+	if (i < count) {
+		const __m256d p0 (_mm256_maskload_pd (&points[i * stride], mask));
+		min0 = _mm256_min_pd (min0, p0);
+		max0 = _mm256_max_pd (max0, p0);
+		sum0 = _mm256_add_pd (sum0, p0);
+		sumSquare0 = _mm256_fmadd_pd (p0, p0, sumSquare0);
+	}
+
+	_mm256_storeu_pd (minOut, _mm256_min_pd (min0, min1));
+	_mm256_storeu_pd (maxOut, _mm256_max_pd (max0, max1));
+	if (sumOut) {
+		_mm256_storeu_pd (sumOut, _mm256_add_pd (sum0, sum1));
+	}
+	if (sumSquareOut) {
+		_mm256_storeu_pd (sumSquareOut, _mm256_add_pd (sumSquare0, sumSquare1));
+	}
+}
+
+static bool dgCpuHasAvx2 ()
+{
+	#if (defined (_WIN_32_VER) || defined (_WIN_64_VER)) && !defined (__GNUC__)
+		int info[4];
+		__cpuid (info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuid (info, 1);
+		const bool fma = (info[2] & (1 << 12)) ? true : false;
+		const bool osxsave = (info[2] & (1 << 27)) ? true : false;
+		const bool avx = (info[2] & (1 << 28)) ? true : false;
+		if (!(fma && osxsave && avx)) {
+			return false;
+		}
+		// the os must be saving the ymm registers on context switches
+		if ((_xgetbv (0) & 6) != 6) {
+			return false;
+		}
+		__cpuidex (info, 7, 0);
+		return (info[1] & (1 << 5)) ? true : false;
+	#else
+		__builtin_cpu_init ();
+		return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma");
+	#endif
+}
+#endif
+
+
+class dgSimdKernelsTable: public dgSimdKernels
+{
+	public:
+	dgSimdKernelsTable ()
+	{
+		m_supportedInstructionSet = m_simdDefault;
+		#ifdef DG_SIMD_KERNELS_RUNTIME_DISPATCH
+		if (dgCpuHasAvx2 ()) {
+			m_supportedInstructionSet = m_simdAvx2;
+		}
+		#endif
+		Select (m_supportedInstructionSet);
+	}
+
+	void Select (dgSimdInstructionSet instructionSet)
+	{
+		m_instructionSet = m_simdDefault;
+		m_pointCloudMoments = dgPointCloudMomentsDefault;
+
+		#ifdef DG_SIMD_KERNELS_RUNTIME_DISPATCH
+		if ((instructionSet >= m_simdAvx2) && (m_supportedInstructionSet >= m_simdAvx2)) {
+			m_instructionSet = m_simdAvx2;
+			m_pointCloudMoments = dgPointCloudMomentsAvx2;
+		}
+		#endif
+	}
+
+	dgSimdInstructionSet m_supportedInstructionSet;
+};
+
+static dgSimdKernelsTable& dgGetSimdKernelsTable ()
+{
+	static dgSimdKernelsTable kernels;
+	return kernels;
+}
+
+const dgSimdKernels& dgSimdKernels::GetKernels ()
+{
+	return dgGetSimdKernelsTable ();
+}
+
+dgSimdInstructionSet dgSimdKernels::GetSupportedInstructionSet ()
+{
+	return dgGetSimdKernelsTable ().m_supportedInstructionSet;
+}
+
+void dgSimdKernels::SetInstructionSet (dgSimdInstructionSet instructionSet)
+{
+	dgGetSimdKernelsTable ().Select (instructionSet);
+}
+
@@ -0,0 +1,57 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __dgSimdKernels__
+#define __dgSimdKernels__
+
+#include "dgStdafx.h"
+#include "dgTypes.h"
+
+// x86 builds also compile an AVX2/FMA version of each kernel, the one
+// used is selected at load time from the cpuid bits, so that a single
+// library runs on old cpus and still uses the wide units on new ones.
+#if (defined (__x86_64__) || defined (__i386__) || defined (_M_X64) || defined (_M_IX86)) && !defined (DG_SCALAR_VECTOR_CLASS)
+	#define DG_SIMD_KERNELS_RUNTIME_DISPATCH
+#endif
+
+enum dgSimdInstructionSet
+{
+	m_simdDefault = 0,
+	m_simdAvx2,
+};
+
+class dgSimdKernels
+{
+	public:
+	// min, max, sum and sum of the squares of the x, y, z components of a strided array of double points.
+	// the w of every output is set to zero, and sumOut and sumSquareOut can be NULL.
+	typedef void (*dgPointCloudMoments) (dgFloat64* const minOut, dgFloat64* const maxOut, dgFloat64* const sumOut, dgFloat64* const sumSquareOut, const dgFloat64* const points, dgInt32 strideInBytes, dgInt32 count);
+
+	static const dgSimdKernels& GetKernels ();
+	static dgSimdInstructionSet GetSupportedInstructionSet ();
+	static void SetInstructionSet (dgSimdInstructionSet instructionSet);
+
+	dgSimdInstructionSet m_instructionSet;
+	dgPointCloudMoments m_pointCloudMoments;
+};
+
+#endif
+
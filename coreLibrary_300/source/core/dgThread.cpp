@@ -21,6 +21,7 @@
 
 #include "dgStdafx.h"
 #include "dgThread.h"
+#include "dgMemory.h"
 
 
 
@@ -166,6 +167,7 @@ void* dgThread::dgThreadSystemCallback(void* threadData)
 
 	dgInterlockedExchange(&me->m_threadRunning, 1);
 	me->Execute(me->m_id);
+	dgMemoryAllocator::ReleaseThreadSlot();
 	dgInterlockedExchange(&me->m_threadRunning, 0);
 	dgThreadYield();
 	return 0;
@@ -26,6 +26,14 @@
 
 #define DG_WORKER_THREAD_STACK_SIZE_IN_BYTES (256 * 1024)
 
+#if defined (_DEBUG) && !defined (DG_USE_THREAD_EMULATION)
+// the address of this variable identifies the calling thread
+static DG_THREAD_LOCAL dgInt32 dgThreadHiveCallerToken = 0;
+
+// the barrier marks the queues with the hive itself while it runs the jobs, so queuing from inside a job asserts
+#define DG_THREAD_HIVE_BARRIER_OWNER(hive)	((const void*)(hive))
+#endif
+
 dgThreadHive::dgThreadBee::dgThreadBee()
 	:dgThread()
 	,m_isBusy(0)
@@ -66,7 +74,8 @@ void dgThreadHive::dgThreadBee::Execute (dgInt32 threadId)
 		SuspendExecution(m_myMutex);
 		dgInterlockedExchange(&m_isBusy, 1);
 		if (!m_terminate) {
-			RunNextJobInQueue(threadId);
+			dgAssert (threadId == m_id);
+			m_hive->RunJobs(threadId);
 			m_hive->m_myMutex[threadId].Release();
 		}
 	}
@@ -77,42 +86,25 @@ void dgThreadHive::dgThreadBee::Execute (dgInt32 threadId)
 }
 
 
-void dgThreadHive::dgThreadBee::RunNextJobInQueue(dgInt32 threadId)
-{
-	bool isEmpty = false;
-	do {
-		dgThreadJob job;
-		dgAssert (threadId == m_id);
-		m_hive->m_jobsCriticalSection.Lock(false);
-		isEmpty = m_hive->m_jobsPool.IsEmpty();
-		if (!isEmpty) {
-			job = m_hive->m_jobsPool.GetHead();
-			m_hive->m_jobsPool.Pop();
-		}
-		m_hive->m_jobsCriticalSection.Unlock();
-
-		if (!isEmpty) {
-			job.m_callback (job.m_context0, job.m_context1, m_id);
-		}
-	} while (!isEmpty);
-}
-
-
 dgThreadHive::dgThreadHive(dgMemoryAllocator* const allocator)
 	:m_beesCount(0)
 	,m_currentIdleBee(0)
 	,m_workerBees(NULL)
+	,m_jobQueues(NULL)
 	,m_myMasterThread(NULL)
 	,m_allocator(allocator)
-	,m_jobsCriticalSection()
 	,m_globalCriticalSection()
-    ,m_jobsPool(allocator)
+#ifdef _DEBUG
+	,m_jobsOwner(NULL)
+#endif
 {
 }
 
 dgThreadHive::~dgThreadHive()
 {
 	DestroyThreads();
+	// the worker threads gave back their slots on exit, the calling thread gives back its own here
+	dgMemoryAllocator::ReleaseThreadSlot();
 }
 
 void dgThreadHive::SetMatertThread (dgThread* const mastertThread)
@@ -124,8 +116,11 @@ void dgThreadHive::DestroyThreads()
 {
 	if (m_beesCount) {
 		delete[] m_workerBees;
+		delete[] m_jobQueues;
 		m_workerBees = NULL;
+		m_jobQueues = NULL;
 		m_beesCount = 0;
+		m_currentIdleBee = 0;
 	}
 }
 
@@ -149,12 +144,14 @@ void dgThreadHive::SetThreadsCount (dgInt32 threads)
 	}
 
 	if (m_beesCount) {
-		m_workerBees = new (m_allocator) dgThreadBee[dgUnsigned32 (m_beesCount)];
+		m_jobQueues = new (m_allocator) dgThreadJobQueue[dgUnsigned32 (m_beesCount)];
+		m_workerBees = new (m_allocator) dgThreadBee[dgUnsigned32 (m_beesCount - 1)];
 
-		for (dgInt32 i = 0; i < m_beesCount; i ++) {
+		// thread zero is the thread calling the synchronization barrier 
+		for (dgInt32 i = 1; i < m_beesCount; i ++) {
 			char name[256];
 			sprintf (name, "dgThreadBee%d", i);
-			m_workerBees[i].SetUp(m_allocator, name, i, this);
+			m_workerBees[i - 1].SetUp(m_allocator, name, i, this);
 		}
 	}
 }
@@ -168,9 +165,16 @@ void dgThreadHive::QueueJob (dgWorkerThreadTaskCallback callback, void* const co
 		#ifdef DG_USE_THREAD_EMULATION
 			callback (context0, context1, 0);
 		#else 
+			#ifdef _DEBUG
+			dgAssert (m_jobsOwner != DG_THREAD_HIVE_BARRIER_OWNER(this));
+			dgAssert (!m_jobsOwner || (m_jobsOwner == &dgThreadHiveCallerToken));
+			m_jobsOwner = &dgThreadHiveCallerToken;
+			#endif
 			dgThreadJob job (context0, context1, callback);
-			m_jobsPool.Push(job);
-			if (m_jobsPool.IsFull()) {
+			dgThreadJobQueue& queue = m_jobQueues[m_currentIdleBee];
+			queue.Push(job);
+			m_currentIdleBee = (m_currentIdleBee + 1 < m_beesCount) ? m_currentIdleBee + 1 : 0;
+			if (queue.IsFull()) {
 				SynchronizationBarrier ();
 			}
 		#endif
@@ -187,16 +191,119 @@ void dgThreadHive::OnEndWorkerThread (dgInt32 threadId)
 }
 
 
+void dgThreadHive::RunJobs (dgInt32 threadId)
+{
+	dgThreadJob job;
+	dgThreadJobQueue& queue = m_jobQueues[threadId];
+	while (queue.Pop(job)) {
+		job.m_callback (job.m_context0, job.m_context1, threadId);
+	}
+
+	// when the local queue is empty steal jobs from the other threads
+	for (dgInt32 i = 1; i < m_beesCount; i ++) {
+		dgInt32 victim = threadId + i;
+		victim = (victim >= m_beesCount) ? victim - m_beesCount : victim;
+		dgThreadJobQueue& victimQueue = m_jobQueues[victim];
+		while (victimQueue.Pop(job)) {
+			job.m_callback (job.m_context0, job.m_context1, threadId);
+		}
+	}
+}
+
+
 void dgThreadHive::SynchronizationBarrier ()
 {
 	if (m_beesCount) {
-		for (dgInt32 i = 0; i < m_beesCount; i ++) {
+		#if defined (_DEBUG) && !defined (DG_USE_THREAD_EMULATION)
+		dgAssert (!m_jobsOwner || (m_jobsOwner == &dgThreadHiveCallerToken));
+		m_jobsOwner = DG_THREAD_HIVE_BARRIER_OWNER(this);
+		#endif
+
+		for (dgInt32 i = 0; i < m_beesCount - 1; i ++) {
 			m_workerBees[i].m_myMutex.Release();
 		}
 
-		m_myMasterThread->SuspendExecution(m_beesCount, m_myMutex);
-		dgAssert (m_jobsPool.IsEmpty());
+		// the calling thread does not idle, it executes jobs as thread zero
+		RunJobs (0);
+
+		for (dgInt32 i = 1; i < m_beesCount; i ++) {
+			m_myMutex[i].Wait();
+		}
+
+		for (dgInt32 i = 0; i < m_beesCount; i ++) {
+			dgAssert (m_jobQueues[i].m_head >= m_jobQueues[i].m_tail);
+			m_jobQueues[i].Reset();
+		}
+		m_currentIdleBee = 0;
+		#ifdef _DEBUG
+		m_jobsOwner = NULL;
+		#endif
+	}
+}
+
+
+bool dgThreadHive::ParallelForClaimRange (dgParallelForDescriptor* const descriptor, dgParallelForRange& range, dgInt32 threadID)
+{
+	// claim a chunk proportional to the remaining work, so that chunks shrink as the range empties 
+	// and late threads can still steal from a busy thread
+	const dgInt32 remaining = range.m_end - range.m_start;
+	if (remaining <= 0) {
+		return false;
+	}
+	const dgInt32 grain = dgMax (descriptor->m_minGrainSize, remaining / (descriptor->m_threadCount * 2));
+	const dgInt32 start = dgAtomicExchangeAndAdd(&range.m_start, grain);
+	if (start >= range.m_end) {
+		return false;
+	}
+	const dgInt32 end = dgMin (start + grain, range.m_end);
+	descriptor->m_callback (descriptor->m_context, start, end, threadID);
+	return true;
+}
+
+
+void dgThreadHive::ParallelForKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dgParallelForDescriptor* const descriptor = (dgParallelForDescriptor*) context;
+	const dgInt32 threadCount = descriptor->m_threadCount;
+
+	dgParallelForRange& range = descriptor->m_ranges[threadID];
+	while (ParallelForClaimRange (descriptor, range, threadID));
+
+	for (dgInt32 i = 1; i < threadCount; i ++) {
+		dgInt32 victim = threadID + i;
+		victim = (victim >= threadCount) ? victim - threadCount : victim;
+		dgParallelForRange& victimRange = descriptor->m_ranges[victim];
+		while (ParallelForClaimRange (descriptor, victimRange, threadID));
 	}
 }
 
 
+void dgThreadHive::ParallelFor (dgInt32 count, dgWorkerThreadRangeCallback callback, void* const context, dgInt32 minGrainSize)
+{
+	const dgInt32 threadCount = GetThreadCount();
+	if ((threadCount == 1) || (count <= minGrainSize)) {
+		if (count > 0) {
+			callback (context, 0, count, 0);
+		}
+	} else {
+		dgParallelForDescriptor descriptor;
+		descriptor.m_callback = callback;
+		descriptor.m_context = context;
+		descriptor.m_threadCount = threadCount;
+		descriptor.m_minGrainSize = dgMax (minGrainSize, 1);
+
+		// start with one contiguous range per thread 
+		dgInt32 start = 0;
+		for (dgInt32 i = 0; i < threadCount; i ++) {
+			dgInt32 end = dgInt32 ((dgInt64 (count) * (i + 1)) / threadCount);
+			descriptor.m_ranges[i].m_start = start;
+			descriptor.m_ranges[i].m_end = end;
+			start = end;
+		}
+
+		for (dgInt32 i = 0; i < threadCount; i ++) {
+			QueueJob (ParallelForKernel, &descriptor, this);
+		}
+		SynchronizationBarrier();
+	}
+}
@@ -25,14 +25,15 @@
 
 #include "dgThread.h"
 #include "dgMemory.h"
-#include "dgFastQueue.h"
 
 
 
 //#define DG_THREAD_POOL_JOB_SIZE (512)
 #define DG_THREAD_POOL_JOB_SIZE (1024 * 8)
+#define DG_THREAD_QUEUE_JOB_SIZE (DG_THREAD_POOL_JOB_SIZE / 8)
 
 typedef void (*dgWorkerThreadTaskCallback) (void* const context0, void* const context1, dgInt32 threadID);
+typedef void (*dgWorkerThreadRangeCallback) (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID);
 
 class dgThreadHive  
 {
@@ -56,6 +57,73 @@ class dgThreadHive
 		dgWorkerThreadTaskCallback m_callback;
 	};
 
+	// each thread owns one queue, jobs are claimed with an atomic index so that idle threads can steal from busy ones.
+	// Push is not atomic, all jobs between two barriers must be queued by the thread that calls SynchronizationBarrier
+	class dgThreadJobQueue
+	{
+		public:
+		DG_CLASS_ALLOCATOR(allocator)
+
+		dgThreadJobQueue()
+			:m_head(0)
+			,m_tail(0)
+		{
+		}
+
+		bool IsFull() const
+		{
+			return m_tail >= DG_THREAD_QUEUE_JOB_SIZE;
+		}
+
+		void Push (const dgThreadJob& job)
+		{
+			dgAssert (!IsFull());
+			m_jobs[m_tail] = job;
+			m_tail ++;
+		}
+
+		bool Pop (dgThreadJob& job)
+		{
+			if (m_head >= m_tail) {
+				return false;
+			}
+			dgInt32 index = dgAtomicExchangeAndAdd(&m_head, 1);
+			if (index >= m_tail) {
+				return false;
+			}
+			job = m_jobs[index];
+			return true;
+		}
+
+		void Reset()
+		{
+			m_head = 0;
+			m_tail = 0;
+		}
+
+		dgInt32 m_head;
+		dgInt32 m_tail;
+		dgThreadJob m_jobs[DG_THREAD_QUEUE_JOB_SIZE];
+	};
+
+	class dgParallelForRange
+	{
+		public:
+		dgInt32 m_start;
+		dgInt32 m_end;
+		dgInt32 m_padding[14];
+	};
+
+	class dgParallelForDescriptor
+	{
+		public:
+		dgParallelForRange m_ranges[DG_MAX_THREADS_HIVE_COUNT];
+		dgWorkerThreadRangeCallback m_callback;
+		void* m_context;
+		dgInt32 m_threadCount;
+		dgInt32 m_minGrainSize;
+	};
+
 
 	class dgThreadBee: public dgThread
 	{
@@ -69,8 +137,6 @@ class dgThreadHive
 		void SetUp(dgMemoryAllocator* const allocator, const char* const name, dgInt32 id, dgThreadHive* const hive);
 		virtual void Execute (dgInt32 threadId);
 
-		void RunNextJobInQueue(dgInt32 threadId);
-
 		dgInt32 m_isBusy;
 		dgSemaphore m_myMutex;
 		dgThreadHive* m_hive;
@@ -98,18 +164,30 @@ class dgThreadHive
 	void QueueJob (dgWorkerThreadTaskCallback callback, void* const context0, void* const context1);
 	void SynchronizationBarrier ();
 
+	// calls callback over sub ranges of [0, count), ranges are split and stolen adaptively by idle threads 
+	void ParallelFor (dgInt32 count, dgWorkerThreadRangeCallback callback, void* const context, dgInt32 minGrainSize = 1);
+
 	private:
 	void DestroyThreads();
+	void RunJobs (dgInt32 threadId);
+	static void ParallelForKernel (void* const context, void* const worldContext, dgInt32 threadID);
+	static bool ParallelForClaimRange (dgParallelForDescriptor* const descriptor, dgParallelForRange& range, dgInt32 threadID);
 
+	// m_beesCount is the number of threads that execute jobs, the calling thread runs as thread zero
+	// so only m_beesCount - 1 worker threads are created. 
 	dgInt32 m_beesCount;
 	dgInt32 m_currentIdleBee;
 	dgThreadBee* m_workerBees;
+	dgThreadJobQueue* m_jobQueues;
 	dgThread* m_myMasterThread;
 	dgMemoryAllocator* m_allocator;
-	dgThread::dgCriticalSection m_jobsCriticalSection;
 	mutable dgThread::dgCriticalSection m_globalCriticalSection;
 	dgThread::dgSemaphore m_myMutex[DG_MAX_THREADS_HIVE_COUNT];
-	dgFastQueue<dgThreadJob, DG_THREAD_POOL_JOB_SIZE> m_jobsPool;
+
+	#ifdef _DEBUG
+	// the thread that queued the pending jobs, checks that queues have a single producer
+	const void* m_jobsOwner;
+	#endif
 };
 
 
@@ -25,6 +25,7 @@
 #include "dgVector.h"
 #include "dgMemory.h"
 #include "dgStack.h"
+#include "dgSimdKernels.h"
 
 dgUnsigned64 dgGetTimeInMicrosenconds()
 {
@@ -71,6 +72,32 @@ dgUnsigned64 dgGetTimeInMicrosenconds()
 #endif
 }
 
+// monotonic clock for measuring short intervals, the origin is arbitrary
+dgUnsigned64 dgGetTimeInNanoseconds()
+{
+#ifdef _MSC_VER
+	static LARGE_INTEGER frequency;
+	if (!frequency.QuadPart) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	LARGE_INTEGER count;
+	QueryPerformanceCounter (&count);
+	return dgUnsigned64 (count.QuadPart / frequency.QuadPart) * 1000000000 + dgUnsigned64 (count.QuadPart % frequency.QuadPart) * 1000000000 / dgUnsigned64 (frequency.QuadPart);
+#endif
+
+#if (defined (_POSIX_VER) || defined (_POSIX_VER_64))
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return dgUnsigned64 (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+
+#ifdef _MACOSX_VER
+	timeval tp;
+	gettimeofday(&tp, NULL);
+	return (dgUnsigned64 (tp.tv_sec) * 1000000 + tp.tv_usec) * 1000;
+#endif
+}
+
 
 dgFloat64 dgRoundToFloat(dgFloat64 val)
 {
@@ -88,24 +115,8 @@ dgFloat64 dgRoundToFloat(dgFloat64 val)
 
 void dgGetMinMax (dgBigVector &minOut, dgBigVector &maxOut, const dgFloat64* const vertexArray, dgInt32 vCount, dgInt32 strideInBytes)
 {
-	dgInt32 stride = dgInt32 (strideInBytes / sizeof (dgFloat64));
-	const dgFloat64* vArray = vertexArray + stride;
-
-	dgAssert (stride >= 3);
-	minOut = dgBigVector (vertexArray[0], vertexArray[1], vertexArray[2], dgFloat64 (0.0f)); 
-	maxOut = dgBigVector (vertexArray[0], vertexArray[1], vertexArray[2], dgFloat64 (0.0f)); 
-
-	for (dgInt32 i = 1; i < vCount; i ++) {
-		minOut.m_x = dgMin (minOut.m_x, vArray[0]);
-		minOut.m_y = dgMin (minOut.m_y, vArray[1]);
-		minOut.m_z = dgMin (minOut.m_z, vArray[2]);
-
-		maxOut.m_x = dgMax (maxOut.m_x, vArray[0]);
-		maxOut.m_y = dgMax (maxOut.m_y, vArray[1]);
-		maxOut.m_z = dgMax (maxOut.m_z, vArray[2]);
-
-		vArray += stride;
-	}
+	dgAssert (strideInBytes >= dgInt32 (3 * sizeof (dgFloat64)));
+	dgSimdKernels::GetKernels().m_pointCloudMoments (&minOut.m_x, &maxOut.m_x, NULL, NULL, vertexArray, strideInBytes, vCount);
 }
 
 
@@ -552,6 +563,10 @@ dgInt32 dgDeserializeMarker(dgDeserialize serializeCallback, void* const userDat
 	while (state != 3) {
 		dgInt32 marker;
 		serializeCallback (userData, &marker, sizeof (marker));
+		if (dgIsMappedImage (serializeCallback) && ((dgMappedImageReader*) userData)->HasFailed()) {
+			// the end of a mapped image was reached without finding the marker
+			return 0;
+		}
 		switch (state) 
 		{
 			case 0:
@@ -594,6 +609,122 @@ dgInt32 dgDeserializeMarker(dgDeserialize serializeCallback, void* const userDat
 	return revision;
 }
 
+//#define MAPPED_IMAGE_ID	'imdn'
+#define MAPPED_IMAGE_ID		0x696d646e
+#define MAPPED_IMAGE_BYTE_ORDER	0x01020304
+
+struct dgMappedImageHeader
+{
+	dgInt32 m_id;
+	dgInt32 m_version;
+	dgInt32 m_byteOrder;
+	dgInt32 m_reserved;
+};
+
+dgMappedImageWriter::dgMappedImageWriter (dgSerialize serializeCallback, void* const userData)
+	:m_callback(serializeCallback)
+	,m_userData(userData)
+	,m_offset(0)
+{
+	dgMappedImageHeader header;
+	header.m_id = MAPPED_IMAGE_ID;
+	header.m_version = DG_MAPPED_IMAGE_VERSION;
+	header.m_byteOrder = MAPPED_IMAGE_BYTE_ORDER;
+	header.m_reserved = 0;
+	Write (this, &header, sizeof (header));
+}
+
+void dgMappedImageWriter::Align ()
+{
+	const dgUnsigned8 padding[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+	size_t paddingSize = (16 - (m_offset & 15)) & 15;
+	if (paddingSize) {
+		Write (this, padding, paddingSize);
+	}
+}
+
+void dgMappedImageWriter::Write (void* const userData, const void* const buffer, size_t size)
+{
+	dgMappedImageWriter* const writer = (dgMappedImageWriter*) userData;
+	writer->m_callback (writer->m_userData, buffer, size);
+	writer->m_offset += size;
+}
+
+dgMappedImageReader::dgMappedImageReader (const void* const image, size_t size)
+	:m_image((dgUnsigned8*) image)
+	,m_size(size)
+	,m_offset(sizeof (dgMappedImageHeader))
+	,m_failed(false)
+{
+	// the image is used in place, an image without the alignment of the arrays is rejected by IsValid
+	if ((m_size < sizeof (dgMappedImageHeader)) || (size_t (image) & 15)) {
+		m_failed = true;
+	}
+}
+
+bool dgMappedImageReader::IsValid () const
+{
+	if (m_failed) {
+		return false;
+	}
+	const dgMappedImageHeader* const header = (dgMappedImageHeader*) m_image;
+	return (header->m_id == MAPPED_IMAGE_ID) && (header->m_version == DG_MAPPED_IMAGE_VERSION) && (header->m_byteOrder == MAPPED_IMAGE_BYTE_ORDER);
+}
+
+// the failure is sticky, once a read runs past the end of the image every following read fails too
+bool dgMappedImageReader::HasFailed () const
+{
+	return m_failed;
+}
+
+const void* dgMappedImageReader::Map (size_t size)
+{
+	const size_t offset = (m_offset + 15) & ~size_t (15);
+	if (m_failed || (offset > m_size) || (size > (m_size - offset))) {
+		m_failed = true;
+		m_offset = m_size;
+		return NULL;
+	}
+	m_offset = offset + size;
+	return &m_image[offset];
+}
+
+void dgMappedImageReader::Read (void* const userData, void* buffer, size_t size)
+{
+	dgMappedImageReader* const reader = (dgMappedImageReader*) userData;
+	if (reader->m_failed || (size > (reader->m_size - reader->m_offset))) {
+		reader->m_failed = true;
+		reader->m_offset = reader->m_size;
+		memset (buffer, 0, size);
+		return;
+	}
+	memcpy (buffer, &reader->m_image[reader->m_offset], size);
+	reader->m_offset += size;
+}
+
+void dgSerializeArray (dgSerialize serializeCallback, void* const userData, const void* const buffer, size_t size)
+{
+	if (serializeCallback == dgMappedImageWriter::Write) {
+		((dgMappedImageWriter*) userData)->Align();
+	}
+	serializeCallback (userData, buffer, size);
+}
+
+void* dgDeserializeArray (dgDeserialize serializeCallback, void* const userData, size_t size)
+{
+	if (serializeCallback == dgMappedImageReader::Read) {
+		return (void*) ((dgMappedImageReader*) userData)->Map(size);
+	}
+	void* const buffer = dgMallocStack (size);
+	serializeCallback (userData, buffer, size);
+	return buffer;
+}
+
+bool dgIsMappedImage (dgDeserialize serializeCallback)
+{
+	return serializeCallback == dgMappedImageReader::Read;
+}
+
 dgSetPrecisionDouble::dgSetPrecisionDouble()
 {
 	#if (defined (_MSC_VER) && defined (_WIN_32_VER))
@@ -98,6 +98,11 @@
 //	#define DG_SSE4_INSTRUCTIONS_SET
 	#include <intrin.h>
 	#include <emmintrin.h> 
+	#ifdef __AVX2__
+		// /arch:AVX2 also implies the FMA3 instructions
+		#define DG_AVX2_INSTRUCTIONS_SET
+		#include <immintrin.h>
+	#endif
 #endif
 
 
@@ -127,6 +132,10 @@
 //				#define DG_SSE4_INSTRUCTIONS_SET
 				#include <smmintrin.h>
 			#endif
+			#if (defined (__AVX2__) && defined (__FMA__))
+				#define DG_AVX2_INSTRUCTIONS_SET
+				#include <immintrin.h>
+			#endif
 		} 
 	#endif
 #endif
@@ -145,6 +154,10 @@
 			#define DG_SSE4_INSTRUCTIONS_SET
 			#include <smmintrin.h>
 		#endif
+		#if (defined (__AVX2__) && defined (__FMA__))
+			#define DG_AVX2_INSTRUCTIONS_SET
+			#include <immintrin.h>
+		#endif
     #endif
 #endif
 
@@ -156,6 +169,7 @@
 
 #if defined (__ppc__) || defined (ANDROID) || defined (IOS)
 	#undef DG_SSE4_INSTRUCTIONS_SET
+	#undef DG_AVX2_INSTRUCTIONS_SET
 	#ifndef DG_SCALAR_VECTOR_CLASS
 		#define DG_SCALAR_VECTOR_CLASS
 	#endif
@@ -185,6 +199,13 @@
 	#include <condition_variable>
 #endif
 
+// thread local storage for plain data, c++11 thread_local is not available in older compilers
+#ifdef _MSC_VER
+	#define DG_THREAD_LOCAL __declspec(thread)
+#else
+	#define DG_THREAD_LOCAL __thread
+#endif
+
 
 //************************************************************
 #ifdef DG_DISABLE_ASSERT
@@ -526,7 +547,7 @@ void dgRadixSort (T* const array, T* const tmpArray, dgInt32 elements, dgInt32 r
 			
 			dgInt32 radixShift = (radix + 1) << 3;
 			for (dgInt32 i = 0; i < elements; i ++) {
-				dgInt32 key = (getRadixKey (&array[i], context) >> radixShift) & 0xff;
+				dgInt32 key = (getRadixKey (&tmpArray[i], context) >> radixShift) & 0xff;
 				dgInt32 index = scanCount[key];
 				array[index] = tmpArray[i];
 				scanCount[key] = index + 1;
@@ -749,14 +770,54 @@ enum dgSerializeRevisionNumber
 {
 	m_firstRevision = 100,
 	// add new serialization revision number here
+	// files written before the first addition have revision 101
+	m_polygonSoupNodeFormatRevision = 102,
 	m_currentRevision 
 };
 
 dgUnsigned64 dgGetTimeInMicrosenconds();
+dgUnsigned64 dgGetTimeInNanoseconds();
 dgFloat64 dgRoundToFloat(dgFloat64 val);
 void dgSerializeMarker(dgSerialize serializeCallback, void* const userData);
 dgInt32 dgDeserializeMarker(dgDeserialize serializeCallback, void* const userData);
 
+// a mapped image is a serialization stream where the large arrays start at 16 byte offsets, 
+// so that a memory mapping of the file can be used in place without making copies of the arrays
+#define DG_MAPPED_IMAGE_VERSION		1
+
+class dgMappedImageWriter
+{
+	public:
+	dgMappedImageWriter (dgSerialize serializeCallback, void* const userData);
+	void Align ();
+	static void dgApi Write (void* const userData, const void* const buffer, size_t size);
+
+	dgSerialize m_callback;
+	void* m_userData;
+	size_t m_offset;
+};
+
+class dgMappedImageReader
+{
+	public:
+	dgMappedImageReader (const void* const image, size_t size);
+	bool IsValid () const;
+	bool HasFailed () const;
+	const void* Map (size_t size);
+	static void dgApi Read (void* const userData, void* buffer, size_t size);
+
+	const dgUnsigned8* m_image;
+	size_t m_size;
+	size_t m_offset;
+	bool m_failed;
+};
+
+// arrays serialized with these functions are aligned in a mapped image, and are not copied when deserializing from it.
+// dgDeserializeArray allocates the array when the stream is not a mapped image, use dgIsMappedImage to know who owns it 
+void dgSerializeArray (dgSerialize serializeCallback, void* const userData, const void* const buffer, size_t size);
+void* dgDeserializeArray (dgDeserialize serializeCallback, void* const userData, size_t size);
+bool dgIsMappedImage (dgDeserialize serializeCallback);
+
 class dgFloatExceptions
 {
 	public:
@@ -815,6 +876,21 @@ DG_INLINE dgInt32 dgInterlockedExchange(dgInt32* const ptr, dgInt32 value)
 	#endif
 }
 
+DG_INLINE dgInt64 dgInterlockedCompareExchange64 (dgInt64* const ptr, dgInt64 newValue, dgInt64 comparand)
+{
+	#if (defined (_WIN_32_VER) || defined (_WIN_64_VER))
+		return _InterlockedCompareExchange64((long long*) ptr, newValue, comparand);
+	#endif
+
+	#if (defined (_MINGW_32_VER) || defined (_MINGW_64_VER))
+		return InterlockedCompareExchange64((long long*) ptr, newValue, comparand);
+	#endif
+
+	#if (defined (_POSIX_VER) || defined (_POSIX_VER_64) ||defined (_MACOSX_VER))
+		return __sync_val_compare_and_swap ((int64_t*)ptr, comparand, newValue);
+	#endif
+}
+
 DG_INLINE void dgThreadYield()
 {
 	#ifndef DG_USE_THREAD_EMULATION
@@ -1442,6 +1442,405 @@ class dgVector
 
 
 
+#ifdef DG_AVX2_INSTRUCTIONS_SET
+
+// *****************************************************************************************
+//
+// 4 x 1 double precision AVX2 vector class declaration
+//
+// *****************************************************************************************
+DG_MSC_VECTOR_ALIGMENT
+class dgBigVector
+{
+	public:
+	DG_INLINE dgBigVector()
+	{
+	}
+
+	DG_INLINE dgBigVector(const __m256d type)
+		:m_type(type)
+	{
+	}
+
+	DG_INLINE dgBigVector(const __m256i type)
+		:m_typeInt(type)
+	{
+	}
+
+	DG_INLINE dgBigVector(const dgFloat64 a)
+		:m_type(_mm256_set1_pd(a))
+	{
+	}
+
+#ifdef _NEWTON_USE_DOUBLE
+	DG_INLINE dgBigVector(const dgVector& v)
+		:m_type(v.m_type)
+	{
+	}
+
+	DG_INLINE dgBigVector (const dgFloat32* const ptr)
+		:m_type(_mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(ptr)), _mm_set_pd(dgFloat64(0.0f), ptr[2]), 1))
+	{
+		dgAssert (dgCheckVector ((*this)));
+	}
+#else
+
+	DG_INLINE dgBigVector(const dgVector& v)
+		:m_type(_mm256_cvtps_pd (v.m_type))
+	{
+		dgAssert(dgCheckVector((*this)));
+	}
+
+	DG_INLINE dgBigVector(const dgFloat64* const ptr)
+		:m_type(_mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(ptr)), _mm_set_pd(dgFloat64(0.0f), ptr[2]), 1))
+	{
+	}
+#endif
+
+	DG_INLINE dgBigVector(const __m128d typeLow, const __m128d typeHigh)
+		:m_type(_mm256_insertf128_pd(_mm256_castpd128_pd256(typeLow), typeHigh, 1))
+	{
+	}
+
+	DG_INLINE dgBigVector(dgFloat64 x, dgFloat64 y, dgFloat64 z, dgFloat64 w)
+		:m_type(_mm256_set_pd(w, z, y, x))
+	{
+	}
+
+	DG_INLINE dgBigVector(const __m128i typeLow, const __m128i typeHigh)
+		:m_typeInt(_mm256_inserti128_si256(_mm256_castsi128_si256(typeLow), typeHigh, 1))
+	{
+	}
+
+	DG_INLINE dgBigVector(dgInt32 ix, dgInt32 iy, dgInt32 iz, dgInt32 iw)
+		:m_typeInt(_mm256_set_epi64x(dgInt64 (iw), dgInt64 (iz), dgInt64 (iy), dgInt64 (ix)))
+	{
+	}
+
+	DG_INLINE dgFloat64& operator[] (dgInt32 i)
+	{
+		dgAssert(i < 4);
+		dgAssert(i >= 0);
+		return m_f[i];
+	}
+
+	DG_INLINE const dgFloat64& operator[] (dgInt32 i) const
+	{
+		dgAssert(i < 4);
+		dgAssert(i >= 0);
+		return m_f[i];
+	}
+
+	DG_INLINE dgFloat64 GetScalar() const
+	{
+		return m_x;
+	}
+
+	DG_INLINE dgBigVector operator+ (const dgBigVector& A) const
+	{
+		return _mm256_add_pd(m_type, A.m_type);
+	}
+
+	DG_INLINE dgBigVector operator- (const dgBigVector& A) const
+	{
+		return _mm256_sub_pd(m_type, A.m_type);
+	}
+
+	DG_INLINE dgBigVector &operator+= (const dgBigVector& A)
+	{
+		m_type = _mm256_add_pd(m_type, A.m_type);
+		return *this;
+	}
+
+	DG_INLINE dgBigVector &operator-= (const dgBigVector& A)
+	{
+		m_type = _mm256_sub_pd(m_type, A.m_type);
+		return *this;
+	}
+
+	DG_INLINE dgFloat64 DotProduct3(const dgBigVector& A) const
+	{
+		__m128d tmp0(_mm_and_pd(_mm256_extractf128_pd(m_type, 1), dgBigVector::m_triplexMask.m_typeHigh));
+		__m128d tmp1(_mm_fmadd_pd(tmp0, _mm256_extractf128_pd(A.m_type, 1), _mm_mul_pd(_mm256_castpd256_pd128(m_type), _mm256_castpd256_pd128(A.m_type))));
+		return _mm_cvtsd_f64(_mm_hadd_pd(tmp1, tmp1));
+	}
+
+	// return cross product
+	DG_INLINE dgBigVector CrossProduct3(const dgBigVector& B) const
+	{
+		__m256d tmp(_mm256_mul_pd(ShiftTripleRight().m_type, B.ShiftTripleLeft().m_type));
+		return _mm256_fmsub_pd(ShiftTripleLeft().m_type, B.ShiftTripleRight().m_type, tmp);
+	}
+
+	DG_INLINE dgBigVector DotProduct4(const dgBigVector& A) const
+	{
+		__m128d tmp0(_mm_fmadd_pd(_mm256_extractf128_pd(m_type, 1), _mm256_extractf128_pd(A.m_type, 1), _mm_mul_pd(_mm256_castpd256_pd128(m_type), _mm256_castpd256_pd128(A.m_type))));
+		__m128d dot(_mm_hadd_pd(tmp0, tmp0));
+		return dgBigVector(dot, dot);
+	}
+
+	DG_INLINE dgBigVector AddHorizontal() const
+	{
+		__m128d tmp0(_mm_add_pd(_mm256_extractf128_pd(m_type, 1), _mm256_castpd256_pd128(m_type)));
+		__m128d tmp1(_mm_hadd_pd(tmp0, tmp0));
+		return dgBigVector(tmp1, tmp1);
+	}
+
+	// component wise multiplication
+	DG_INLINE dgBigVector CompProduct3(const dgBigVector& A) const
+	{
+		return _mm256_and_pd(_mm256_mul_pd(m_type, A.m_type), m_triplexMask.m_type);
+	}
+
+	// component wide multiplication
+	DG_INLINE dgBigVector CompProduct4(const dgBigVector& A) const
+	{
+		return _mm256_mul_pd(m_type, A.m_type);
+	}
+
+	DG_INLINE dgBigVector BroadcastX() const
+	{
+		return _mm256_permute4x64_pd(m_type, _MM_SHUFFLE (0, 0, 0, 0));
+	}
+
+	DG_INLINE dgBigVector BroadcastY() const
+	{
+		return _mm256_permute4x64_pd(m_type, _MM_SHUFFLE (1, 1, 1, 1));
+	}
+
+	DG_INLINE dgBigVector BroadcastZ() const
+	{
+		return _mm256_permute4x64_pd(m_type, _MM_SHUFFLE (2, 2, 2, 2));
+	}
+
+	DG_INLINE dgBigVector BroadcastW() const
+	{
+		return _mm256_permute4x64_pd(m_type, _MM_SHUFFLE (3, 3, 3, 3));
+	}
+
+	DG_INLINE dgBigVector Scale3(dgFloat64 s) const
+	{
+		return _mm256_mul_pd(m_type, _mm256_set_pd(dgFloat64(1.0f), s, s, s));
+	}
+
+	DG_INLINE dgBigVector Scale4(dgFloat64 s) const
+	{
+		return _mm256_mul_pd(m_type, _mm256_set1_pd(s));
+	}
+
+	DG_INLINE dgBigVector Abs() const
+	{
+		return _mm256_and_pd(m_type, m_signMask.m_type);
+	}
+
+	DG_INLINE dgBigVector Reciproc() const
+	{
+		return _mm256_div_pd(m_one.m_type, m_type);
+	}
+
+	DG_INLINE dgBigVector Sqrt() const
+	{
+		return _mm256_sqrt_pd(m_type);
+	}
+
+	DG_INLINE dgBigVector InvSqrt() const
+	{
+		return Sqrt().Reciproc();
+	}
+
+	DG_INLINE dgBigVector InvMagSqrt() const
+	{
+		return (DotProduct4(*this)).InvSqrt();
+	}
+
+	dgBigVector GetMax(const dgBigVector& data) const
+	{
+		return _mm256_max_pd(m_type, data.m_type);
+	}
+
+	dgBigVector GetMin(const dgBigVector& data) const
+	{
+		return _mm256_min_pd(m_type, data.m_type);
+	}
+
+	DG_INLINE dgBigVector GetInt() const
+	{
+		return _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(_mm256_floor_pd(m_type)));
+	}
+
+	// relational operators
+	DG_INLINE dgBigVector operator> (const dgBigVector& data) const
+	{
+		return _mm256_cmp_pd(m_type, data.m_type, _CMP_GT_OQ);
+	}
+
+	DG_INLINE dgBigVector operator== (const dgBigVector& data) const
+	{
+		return _mm256_cmp_pd(m_type, data.m_type, _CMP_EQ_OQ);
+	}
+
+	DG_INLINE dgBigVector operator< (const dgBigVector& data) const
+	{
+		return _mm256_cmp_pd(m_type, data.m_type, _CMP_LT_OQ);
+	}
+
+	DG_INLINE dgBigVector operator>= (const dgBigVector& data) const
+	{
+		return _mm256_cmp_pd(m_type, data.m_type, _CMP_GE_OQ);
+	}
+
+	DG_INLINE dgBigVector operator<= (const dgBigVector& data) const
+	{
+		return _mm256_cmp_pd(m_type, data.m_type, _CMP_LE_OQ);
+	}
+
+	// logical operations
+	DG_INLINE dgBigVector operator& (const dgBigVector& data) const
+	{
+		return _mm256_and_pd(m_type, data.m_type);
+	}
+
+	DG_INLINE dgBigVector operator| (const dgBigVector& data) const
+	{
+		return _mm256_or_pd(m_type, data.m_type);
+	}
+
+	DG_INLINE dgBigVector operator^ (const dgBigVector& data) const
+	{
+		return _mm256_xor_pd(m_type, data.m_type);
+	}
+
+	DG_INLINE dgBigVector AndNot(const dgBigVector& data) const
+	{
+		return _mm256_andnot_pd(data.m_type, m_type);
+	}
+
+	DG_INLINE dgBigVector ShiftTripleRight() const
+	{
+		return _mm256_permute4x64_pd(m_type, _MM_SHUFFLE (3, 1, 0, 2));
+	}
+
+	DG_INLINE dgBigVector ShiftTripleLeft() const
+	{
+		return _mm256_permute4x64_pd(m_type, _MM_SHUFFLE (3, 0, 2, 1));
+	}
+
+	DG_INLINE dgBigVector ShiftRightLogical(int bits) const
+	{
+		return _mm256_srli_epi64(m_typeInt, bits);
+	}
+
+	DG_INLINE dgInt32 GetSignMask() const
+	{
+		return _mm256_movemask_pd(m_type);
+	}
+
+	DG_INLINE dgBigVector Floor() const
+	{
+		return _mm256_floor_pd(m_type);
+	}
+
+	DG_INLINE dgBigVector CrossProduct4(const dgBigVector& A, const dgBigVector& B) const
+	{
+		dgFloat64 array[4][4];
+		dgFloat64 cofactor[3][3];
+
+		const dgBigVector& me = *this;
+		for (dgInt32 i = 0; i < 4; i++) {
+			array[0][i] = me[i];
+			array[1][i] = A[i];
+			array[2][i] = B[i];
+			array[3][i] = dgFloat64(1.0f);
+		}
+
+		dgBigVector normal;
+		dgFloat64 sign = dgFloat32(-1.0f);
+		for (dgInt32 i = 0; i < 4; i++) {
+			for (dgInt32 j = 0; j < 3; j++) {
+				dgInt32 k0 = 0;
+				for (dgInt32 k = 0; k < 4; k++) {
+					if (k != i) {
+						cofactor[j][k0] = array[j][k];
+						k0++;
+					}
+				}
+			}
+			dgFloat64 x = cofactor[0][0] * (cofactor[1][1] * cofactor[2][2] - cofactor[1][2] * cofactor[2][1]);
+			dgFloat64 y = cofactor[0][1] * (cofactor[1][2] * cofactor[2][0] - cofactor[1][0] * cofactor[2][2]);
+			dgFloat64 z = cofactor[0][2] * (cofactor[1][0] * cofactor[2][1] - cofactor[1][1] * cofactor[2][0]);
+			dgFloat64 det = x + y + z;
+
+			normal[i] = sign * det;
+			sign *= dgFloat64(-1.0f);
+		}
+
+		return normal;
+	}
+
+	DG_INLINE dgBigVector TestZero() const
+	{
+		return _mm256_and_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(m_typeInt, m_zero.m_typeInt)), m_negOne.m_type);
+	}
+
+	DG_INLINE static void Transpose4x4(dgBigVector& dst0, dgBigVector& dst1, dgBigVector& dst2, dgBigVector& dst3,
+		const dgBigVector& src0, const dgBigVector& src1, const dgBigVector& src2, const dgBigVector& src3)
+	{
+		__m256d tmp0(_mm256_unpacklo_pd(src0.m_type, src1.m_type));
+		__m256d tmp1(_mm256_unpackhi_pd(src0.m_type, src1.m_type));
+		__m256d tmp2(_mm256_unpacklo_pd(src2.m_type, src3.m_type));
+		__m256d tmp3(_mm256_unpackhi_pd(src2.m_type, src3.m_type));
+
+		dst0 = _mm256_permute2f128_pd(tmp0, tmp2, 0x20);
+		dst1 = _mm256_permute2f128_pd(tmp1, tmp3, 0x20);
+		dst2 = _mm256_permute2f128_pd(tmp0, tmp2, 0x31);
+		dst3 = _mm256_permute2f128_pd(tmp1, tmp3, 0x31);
+	}
+
+	DG_CLASS_ALLOCATOR(allocator)
+
+	union
+	{
+		dgFloat64 m_f[4];
+		__m256d m_type;
+		__m256i m_typeInt;
+		struct
+		{
+			__m128d m_typeLow;
+			__m128d m_typeHigh;
+		};
+		struct
+		{
+			dgFloat64 m_x;
+			dgFloat64 m_y;
+			dgFloat64 m_z;
+			dgFloat64 m_w;
+		};
+		struct
+		{
+			dgInt64 m_ix;
+			dgInt64 m_iy;
+			dgInt64 m_iz;
+			dgInt64 m_iw;
+		};
+	};
+
+	static dgBigVector m_zero;
+	static dgBigVector m_one;
+	static dgBigVector m_wOne;
+	static dgBigVector m_two;
+	static dgBigVector m_half;
+	static dgBigVector m_three;
+	static dgBigVector m_negOne;
+	static dgBigVector m_xMask;
+	static dgBigVector m_yMask;
+	static dgBigVector m_zMask;
+	static dgBigVector m_wMask;
+	static dgBigVector m_signMask;
+	static dgBigVector m_triplexMask;
+} DG_GCC_VECTOR_ALIGMENT;
+
+#else
+
 // *****************************************************************************************
 //
 // 4 x 1 double precision SSE2 vector class declaration
@@ -1873,6 +2272,7 @@ class dgBigVector
 	static dgBigVector m_signMask;
 	static dgBigVector m_triplexMask;
 } DG_GCC_VECTOR_ALIGMENT;
+#endif
 
 
 #endif
@@ -125,6 +125,52 @@ void NewtonSetMemorySystem (NewtonAllocMemory mallocFnt, NewtonFreeMemory mfreeF
 	dgMemoryAllocator::SetGlobalAllocators (_malloc, _free);
 }
 
+/*!
+  Return the number of simd kernel sets this cpu can run.
+
+  @return 1 when only the default kernels are available, 2 when the avx2/fma kernels can also be used.
+
+  The kernel set is a process wide setting shared by all worlds, it is selected at load time from the cpu features.
+
+  See also: ::NewtonGetSimdInstructionSet, ::NewtonSetSimdInstructionSet
+*/
+int NewtonEnumerateSimdInstructionSets ()
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	return dgSimdKernels::GetSupportedInstructionSet() + 1;
+}
+
+/*!
+  Return the index of the simd kernel set in use.
+
+  @return 0 for the default kernels, 1 for the avx2/fma kernels.
+
+  See also: ::NewtonEnumerateSimdInstructionSets, ::NewtonSetSimdInstructionSet
+*/
+int NewtonGetSimdInstructionSet ()
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	return dgSimdKernels::GetKernels().m_instructionSet;
+}
+
+/*!
+  Select the simd kernel set used by the whole process.
+
+  @param instructionSet index of the kernel set, it is clamped to the sets supported by this cpu.
+
+  @return Nothing.
+
+  This changes the kernels of every world, it must not be called while any world is being updated or is building collision shapes.
+
+  See also: ::NewtonEnumerateSimdInstructionSets, ::NewtonGetSimdInstructionSet
+*/
+void NewtonSetSimdInstructionSet (int instructionSet)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	instructionSet = dgClamp (instructionSet, 0, dgInt32 (dgSimdKernels::GetSupportedInstructionSet()));
+	dgSimdKernels::SetInstructionSet (dgSimdInstructionSet (instructionSet));
+}
+
 
 void* NewtonAlloc (int sizeInBytes)
 {
@@ -221,6 +267,61 @@ void NewtonSelectBroadphaseAlgorithm (const NewtonWorld* const newtonWorld, int
 	world->SetBroadPhaseType(algorithmType);
 }
 
+/*!
+  Get the entropy ratio that triggers a full rebuild of the broad phase tree.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @return the current ratio, zero if the automatic rebuild is disabled.
+
+  See also: ::NewtonSetBroadphaseRebuildRatio, ::NewtonRebuildBroadphase
+*/
+dFloat NewtonGetBroadphaseRebuildRatio (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetBroadPhaseRebuildRatio();
+}
+
+/*!
+  Set the entropy ratio that triggers a full rebuild of the broad phase tree.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param ratio how much the cost per node of the tree can grow over the cost of the last build before the tree is rebuilt.
+  @return Nothing.
+
+  The broad phase tree is kept in shape with local rotations, which can not undo the damage of mass spawns, explosions
+  or level streaming. Once the tree cost exceeds the cost of the last build by this ratio, the tree is rebuilt from scratch
+  with a surface area heuristic builder that runs on all the worker threads. The default is 1.5, zero disables the automatic rebuild.
+
+  See also: ::NewtonGetBroadphaseRebuildRatio, ::NewtonRebuildBroadphase
+*/
+void NewtonSetBroadphaseRebuildRatio (const NewtonWorld* const newtonWorld, dFloat ratio)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->SetBroadPhaseRebuildRatio(ratio);
+}
+
+/*!
+  Rebuild the broad phase tree from scratch.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @return Nothing.
+
+  Call this function after adding or moving a large number of bodies, for example after streaming in a level,
+  so that the queries and the next update run on an optimal tree. Unlike ::NewtonInvalidateCache, the contacts are preserved.
+
+  This function must be called outside of a Newton Update.
+
+  See also: ::NewtonSetBroadphaseRebuildRatio
+*/
+void NewtonRebuildBroadphase (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	world->RebuildBroadPhase();
+}
+
 
 dFloat NewtonGetContactMergeTolerance (const NewtonWorld* const newtonWorld)
 {
@@ -544,6 +645,53 @@ void NewtonSyncThreadJobs(const NewtonWorld* const newtonWorld)
 	world->SynchronizationBarrier();
 }
 
+/*!
+  Switch the world memory allocator to thread safe mode.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param state 1 serves small allocations from per thread caches so that worker threads can allocate and free concurrently, 0 restores the single threaded allocator.
+
+  @return Nothing.
+
+  This function must not be called from inside a world update or while other threads are using the world.
+  ::NewtonSetThreadsCount switches the allocator to thread safe mode when the world runs more than one thread,
+  so that the narrow phase can add and remove contact points without taking the world lock.
+
+  See also: ::NewtonGetAllocatorStats
+*/
+void NewtonSetThreadSafeAllocator (const NewtonWorld* const newtonWorld, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->dgWorld::GetAllocator()->SetThreadSafe (state ? true : false);
+}
+
+/*!
+  Read the counters collected by the world allocator while in thread safe mode.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *stats Pointer to the structure that receives the counters, all zero when the allocator is not thread safe.
+
+  @return Nothing.
+
+  See also: ::NewtonSetThreadSafeAllocator
+*/
+void NewtonGetAllocatorStats (const NewtonWorld* const newtonWorld, NewtonAllocatorStats* const stats)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+
+	dgMemoryAllocator::dgMemoryStats allocatorStats;
+	world->dgWorld::GetAllocator()->GetStats (allocatorStats);
+	stats->m_mallocCount = allocatorStats.m_mallocCount;
+	stats->m_freeCount = allocatorStats.m_freeCount;
+	stats->m_magazineHits = allocatorStats.m_magazineHits;
+	stats->m_refillCount = allocatorStats.m_refillCount;
+	stats->m_returnCount = allocatorStats.m_returnCount;
+	stats->m_crossThreadFreeCount = allocatorStats.m_crossThreadFreeCount;
+	stats->m_lockContention = allocatorStats.m_lockContention;
+}
+
 
 
 
@@ -619,6 +767,139 @@ void NewtonSetPerformanceClock(const NewtonWorld* const newtonWorld, NewtonGetTi
 	world->SetGetTimeInMicrosenconds ((dgWorld::OnGetTimeInMicrosenconds) callback);
 }
 
+/*!
+  Start recording the engine profiler events.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *traceFileName name of a chrome trace event json file to write the events to, or NULL to only collect the frame summaries.
+  @param numberOfFrames stop capturing after this many profiler frames, zero or negative to capture until ::NewtonProfilerStopCapture.
+
+  @return 1 if the capture started, 0 if the file could not be opened or the library was built without the time tracker.
+
+  The profiler is shared by all worlds in the process, the application closes each frame with ::NewtonProfilerUpdate
+  after it has updated all its worlds.
+
+  See also: ::NewtonProfilerStopCapture, ::NewtonProfilerGetFramePhases
+*/
+int NewtonProfilerStartCapture (const NewtonWorld* const newtonWorld, const char* const traceFileName, int numberOfFrames)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+#ifdef D_TIME_TRACKER
+	return dTimeTracker::GetInstance()->StartCapture (traceFileName, numberOfFrames) ? 1 : 0;
+#else
+	return 0;
+#endif
+}
+
+/*!
+  Stop recording the profiler events and close the trace file.
+
+  @param *newtonWorld Pointer to the Newton world.
+
+  The frame summaries collected during the capture stay available until the next capture starts.
+*/
+void NewtonProfilerStopCapture (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+#ifdef D_TIME_TRACKER
+	dTimeTracker::GetInstance()->StopCapture ();
+#endif
+}
+
+/*!
+  Close the current profiler frame and start the next one.
+
+  @return Nothing.
+
+  Call it once per application frame, after all the worlds have been updated. It does nothing when no capture is running.
+
+  See also: ::NewtonProfilerStartCapture, ::NewtonProfilerGetFramePhases
+*/
+void NewtonProfilerUpdate ()
+{
+	TRACE_FUNCTION(__FUNCTION__);
+#ifdef D_TIME_TRACKER
+	dTimeTracker::GetInstance()->Update ();
+#endif
+}
+
+int NewtonProfilerIsCapturing (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+#ifdef D_TIME_TRACKER
+	return dTimeTracker::GetInstance()->IsCapturing () ? 1 : 0;
+#else
+	return 0;
+#endif
+}
+
+/*!
+  Return the number of completed frames that can be read with ::NewtonProfilerGetFramePhases.
+
+  @param *newtonWorld Pointer to the Newton world.
+
+  Only the most recent frames are kept, older ones are overwritten.
+*/
+int NewtonProfilerGetFrameCount (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+#ifdef D_TIME_TRACKER
+	return dTimeTracker::GetInstance()->GetFrameCount ();
+#else
+	return 0;
+#endif
+}
+
+/*!
+  Return the wall time in seconds between the start of a captured frame and the ::NewtonProfilerUpdate call that closed it.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param frame index of the frame, zero is the most recent one.
+*/
+dFloat NewtonProfilerGetFrameTime (const NewtonWorld* const newtonWorld, int frame)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+#ifdef D_TIME_TRACKER
+	return dFloat (dgFloat64 (dTimeTracker::GetInstance()->GetFrameTime (frame)) * dgFloat64 (1.0e-9));
+#else
+	return dFloat (0.0f);
+#endif
+}
+
+/*!
+  Read the per phase summary of a captured frame.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param frame index of the frame, zero is the most recent one.
+  @param *phases array to receive the phases.
+  @param maxCount size of the array.
+
+  @return the number of phases written.
+
+  There is one phase for each distinct event name recorded in the frame, with the time summed over all
+  the calls and threads. Phases are listed in the order they first completed, m_depth and m_parentName
+  describe where the event is nested in the update.
+*/
+int NewtonProfilerGetFramePhases (const NewtonWorld* const newtonWorld, int frame, NewtonProfilerPhase* const phases, int maxCount)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+#ifdef D_TIME_TRACKER
+	dTimeTracker::dPhaseSummary summary[D_TIME_TRACKER_FRAME_PHASES];
+	const int count = dTimeTracker::GetInstance()->GetFrameSummary (frame, summary, dgMin (maxCount, D_TIME_TRACKER_FRAME_PHASES));
+	for (int i = 0; i < count; i ++) {
+		phases[i].m_name = summary[i].m_name;
+		phases[i].m_parentName = summary[i].m_parentName;
+		phases[i].m_time = dFloat (dgFloat64 (summary[i].m_time) * dgFloat64 (1.0e-9));
+		phases[i].m_maxTime = dFloat (dgFloat64 (summary[i].m_maxTime) * dgFloat64 (1.0e-9));
+		phases[i].m_calls = summary[i].m_calls;
+		phases[i].m_depth = summary[i].m_depth;
+	}
+	return count;
+#else
+	return 0;
+#endif
+}
+
 /*!
   Advance the simulation by a user defined amount of time.
 
@@ -672,6 +953,95 @@ dFloat NewtonGetLastUpdateTime (const NewtonWorld* const newtonWorld)
 	return world->GetUpdateTime();
 }
 
+/*!
+  Enable or disable the per phase statistics of the world update.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param state 1 to collect the statistics on every update, 0 to stop collecting them.
+
+  When disabled every probe in the update is a single pointer test.
+
+  See also: ::NewtonWorldGetStats
+*/
+void NewtonWorldSetCollectStats (const NewtonWorld* const newtonWorld, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetCollectStats (state ? true : false);
+}
+
+int NewtonWorldGetCollectStats (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetCollectStats () ? 1 : 0;
+}
+
+/*!
+  Enable or disable the analytic contact kernels of the narrow phase.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param state 1 to use the kernels, 0 to send every convex pair to the general contact solver.
+
+  Sphere-sphere, sphere-capsule, sphere-box, capsule-capsule and box-box pairs are solved in closed form
+  and produce the same contacts the general solver would. Pairs the kernels can not handle, like non uniformly
+  scaled spheres or tapered capsules, still go to the general solver. The kernels are enabled by default.
+
+  See also: ::NewtonWorldGetPrimitiveContacts
+*/
+void NewtonWorldSetPrimitiveContacts (const NewtonWorld* const newtonWorld, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SetPrimitiveContacts (state ? true : false);
+}
+
+int NewtonWorldGetPrimitiveContacts (const NewtonWorld* const newtonWorld)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return world->GetPrimitiveContacts () ? 1 : 0;
+}
+
+/*!
+  Read the statistics of the last world update.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *stats receives the statistics.
+
+  The values are summed over all the sub steps of the update. When the world is updated
+  with NewtonUpdateAsync, call NewtonWaitForUpdateToFinish before reading them.
+
+  See also: ::NewtonWorldSetCollectStats
+*/
+void NewtonWorldGetStats (const NewtonWorld* const newtonWorld, NewtonWorldStats* const stats)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	const dgWorldStats& worldStats = world->GetStats();
+
+	const dgFloat64 scale = dgFloat64 (1.0e-9);
+	stats->m_stepTime = dFloat (dgFloat64 (worldStats.m_stepTime) * scale);
+	stats->m_forceCallbacksTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_forceCallbacks]) * scale);
+	stats->m_preListenersTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_preListeners]) * scale);
+	stats->m_sleepingStateTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_sleepingState]) * scale);
+	stats->m_tileStreamingTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_tileStreaming]) * scale);
+	stats->m_broadPhaseTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_broadPhase]) * scale);
+	stats->m_narrowPhaseTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_narrowPhase]) * scale);
+	stats->m_buildClustersTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_buildClusters]) * scale);
+	stats->m_solverTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_solver]) * scale);
+	stats->m_integrationTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_integration]) * scale);
+	stats->m_postListenersTime = dFloat (dgFloat64 (worldStats.m_phaseTime[dgWorldStats::m_postListeners]) * scale);
+	stats->m_substeps = worldStats.m_substeps;
+	stats->m_activeBodies = worldStats.m_activeBodies;
+	stats->m_pairsTested = worldStats.m_pairsTested;
+	stats->m_contactsCreated = worldStats.m_contactsCreated;
+	stats->m_contactsDestroyed = worldStats.m_contactsDestroyed;
+	stats->m_clusters = worldStats.m_clusters;
+	stats->m_jointRows = worldStats.m_jointRows;
+	stats->m_solverPasses = worldStats.m_solverPasses;
+}
+
 
 void NewtonSetNumberOfSubsteps (const NewtonWorld* const newtonWorld, int subSteps)
 {
@@ -1137,6 +1507,40 @@ void NewtonWorldRayCast(const NewtonWorld* const newtonWorld, const dFloat* cons
 }
 
 
+/*!
+  Cast an array of rays in one call.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *p0 pointer to the first ray origin, each entry has at least three floats in global space.
+  @param *p1 pointer to the first ray destination, each entry has at least three floats in global space.
+  @param strideInBytes distance in bytes between two consecutive entries of the *p0* and *p1* arrays.
+  @param rayCount number of rays in the batch.
+  @param *info pointer to an array of at least *rayCount* entries that receives the result of each ray.
+  @param mode NEWTON_RAY_CAST_CLOSEST_HIT to get the closest intersection of each ray, NEWTON_RAY_CAST_ANY_HIT to stop each ray at the first intersection found.
+  @param *userData user data to be passed to the prefilter callback.
+  @param prefilter user defined function to be called for each body before intersection, can be NULL.
+
+  @return the number of rays that hit a body.
+
+  Unlike ::NewtonWorldRayCast there is no filter callback, the result of ray *i* is written to *info[i]*.
+  A ray that does not hit anything gets a NULL *m_hitBody* and an intersection parameter of one.
+
+  The rays are sorted so that rays with similar origin and direction are processed together, they walk
+  the broadphase and the collision trees in packets of four and the batch is split across the world worker threads.
+  The any hit mode is the cheaper one, and is the one to use for line of sight tests.
+
+  Because the batch uses the world threads, this function must be called from outside of a Newton update.
+
+  See also: ::NewtonWorldRayCast
+*/
+int NewtonWorldRayCastBatch (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, int strideInBytes, int rayCount, NewtonWorldRayCastReturnInfo* const info, int mode, void* const userData, NewtonWorldRayPrefilterCallback prefilter)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *) newtonWorld;
+	return world->GetBroadPhase()->RayCastBatch (p0, p1, strideInBytes, rayCount, (dgRayCastReturnInfo*) info, mode == NEWTON_RAY_CAST_ANY_HIT, (OnRayPrecastAction) prefilter, userData);
+}
+
+
 /*!
   cast a simple convex shape along the ray that goes for the matrix position to the destination and get the firsts contacts of collision.
 
@@ -3200,6 +3604,181 @@ void NewtonHeightFieldSetHorizontalDisplacement (const NewtonCollision* const he
 	}
 }
 
+/*!
+  Enable or disable the min max elevation pyramid of a height field.
+
+  @param *heightField is the pointer to the height field collision.
+  @param state 1 build the pyramid, 0 release it.
+
+  The pyramid stores the lowest and highest elevation of every block of 4 x 4 cells and of every 
+  level above, it is used to reject whole blocks in ray casts, convex casts and contact queries.
+  Height fields are created with the pyramid enabled, the memory cost is about one sixth of the elevation map.
+  if the application modifies the elevation map after creation, calling this function with state 1 rebuilds the pyramid.
+
+  See also: ::NewtonHeightFieldGetMinMaxPyramid
+*/
+void NewtonHeightFieldSetMinMaxPyramid (const NewtonCollision* const heightField, int state)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)heightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightField_RTTI)) {
+		dgCollisionHeightField* const shape = (dgCollisionHeightField*)collision->GetChildShape();
+		shape->SetMinMaxPyramid (state ? true : false);
+	}
+}
+
+int NewtonHeightFieldGetMinMaxPyramid (const NewtonCollision* const heightField)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)heightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightField_RTTI)) {
+		dgCollisionHeightField* const shape = (dgCollisionHeightField*)collision->GetChildShape();
+		return shape->GetMinMaxPyramid() ? 1 : 0;
+	}
+	return 0;
+}
+
+/*!
+  Create a tiled height field collision, for terrains too large to be kept in memory.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param width number of samples along the x axis, it can be as large as 65536.
+  @param height number of samples along the z axis, it can be as large as 65536.
+  @param tileSize number of cells along the side of a tile, rounded up to an even number.
+  @param gridsDiagonals diagonal pattern of the cells, same as ::NewtonCreateHeightFieldCollision.
+  @param elevationdatType 0 for 32 bit float elevations, 1 for unsigned 16 bit elevations.
+  @param minElevation lowest elevation value of the map, before the vertical scale.
+  @param maxElevation highest elevation value of the map, before the vertical scale.
+  @param verticalScale scale applied to the elevation values.
+  @param horizontalScale_x size of the cells along the x axis.
+  @param horizontalScale_z size of the cells along the z axis.
+  @param maxResidentTiles number of tiles kept in memory, the least recently used tiles are released above this budget.
+  @param shapeID user data id of the shape.
+
+  @return Pointer to the collision.
+
+  The elevation of the terrain is not passed at creation, each tile is read when it is needed from the tile
+  callback or from the memory mapped image set with ::NewtonTiledHeightFieldSetTileCallback or ::NewtonTiledHeightFieldSetMappedSource.
+  before each step the world loads the tiles under the dynamic bodies, the contacts and ray casts only see resident tiles.
+  minElevation and maxElevation set the bounding box of the shape, since the elevation of a tile is not known until it is loaded.
+
+  See also: ::NewtonTiledHeightFieldSetTileCallback, ::NewtonTiledHeightFieldSetMappedSource, ::NewtonTiledHeightFieldSetPrefetchDistance
+*/
+NewtonCollision* NewtonCreateTiledHeightFieldCollision (const NewtonWorld* const newtonWorld, int width, int height, int tileSize, int gridsDiagonals, int elevationdatType,
+														dFloat minElevation, dFloat maxElevation, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, int maxResidentTiles, int shapeID)
+{
+	Newton* const world = (Newton *)newtonWorld;
+
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = world->CreateTiledHeightField(width, height, tileSize, gridsDiagonals, elevationdatType, dgFloat32 (minElevation), dgFloat32 (maxElevation),
+																		 dgFloat32 (verticalScale), dgFloat32 (horizontalScale_x), dgFloat32 (horizontalScale_z), maxResidentTiles);
+	collision->SetUserDataID(dgUnsigned32 (shapeID));
+	return (NewtonCollision*) collision;
+}
+
+/*!
+  Set the callback that reads the tiles of a tiled height field.
+
+  @param *tiledHeightField is the pointer to the tiled height field collision.
+  @param tileCallback function that fills the elevation and attributes of a rectangle of samples.
+  @param *userData pointer passed to the callback.
+
+  the callback receives the first sample x0, z0 and the width and height of the rectangle, it writes width * height
+  elevations of the type of the height field and width * height attributes, row by row, and returns 0 if the tile could not be read.
+  the callback is called from the world update, before the broad phase, or from ::NewtonTiledHeightFieldRequestTiles.
+  Setting a new source releases the resident tiles.
+*/
+void NewtonTiledHeightFieldSetTileCallback (const NewtonCollision* const tiledHeightField, NewtonTiledHeightFieldTileCallback tileCallback, void* const userData)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)tiledHeightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+		dgCollisionHeightFieldTiled* const shape = (dgCollisionHeightFieldTiled*)collision->GetChildShape();
+		shape->SetTileCallback ((dgCollisionHeightFieldTiled::OnTileLoadCallback) tileCallback, userData);
+	}
+}
+
+/*!
+  Read the tiles of a tiled height field from images of the whole terrain.
+
+  @param *tiledHeightField is the pointer to the tiled height field collision.
+  @param *elevationMap width * height elevations, row by row.
+  @param *attributeMap width * height attributes, row by row, it can be NULL.
+
+  The maps are not copied, they are usually memory mapped files and the application keeps them mapped
+  for as long as the collision uses them. Only the pages of the resident tiles are touched.
+  Setting a new source releases the resident tiles.
+*/
+void NewtonTiledHeightFieldSetMappedSource (const NewtonCollision* const tiledHeightField, const void* const elevationMap, const char* const attributeMap)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)tiledHeightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+		dgCollisionHeightFieldTiled* const shape = (dgCollisionHeightFieldTiled*)collision->GetChildShape();
+		shape->SetMappedSource (elevationMap, (const dgInt8*) attributeMap);
+	}
+}
+
+/*!
+  Set the distance around the dynamic bodies that the world keeps resident.
+
+  @param *tiledHeightField is the pointer to the tiled height field collision.
+  @param distance distance added to the box of the bodies, in the units of the height field.
+*/
+void NewtonTiledHeightFieldSetPrefetchDistance (const NewtonCollision* const tiledHeightField, dFloat distance)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)tiledHeightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+		dgCollisionHeightFieldTiled* const shape = (dgCollisionHeightFieldTiled*)collision->GetChildShape();
+		shape->SetPrefetchDistance (dgFloat32 (distance));
+	}
+}
+
+void NewtonTiledHeightFieldSetMaxResidentTiles (const NewtonCollision* const tiledHeightField, int maxResidentTiles)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)tiledHeightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+		dgCollisionHeightFieldTiled* const shape = (dgCollisionHeightFieldTiled*)collision->GetChildShape();
+		shape->SetMaxResidentTiles (maxResidentTiles);
+	}
+}
+
+/*!
+  Load now the tiles overlapping a box, for example around a camera or a spawn point.
+
+  @param *tiledHeightField is the pointer to the tiled height field collision.
+  @param *p0 minimum point of the box in the local space of the height field.
+  @param *p1 maximum point of the box in the local space of the height field.
+
+  The tiles in the box are pinned for the next step, this function can not be called during the world update.
+*/
+void NewtonTiledHeightFieldRequestTiles (const NewtonCollision* const tiledHeightField, const dFloat* const p0, const dFloat* const p1)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)tiledHeightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+		dgCollisionHeightFieldTiled* const shape = (dgCollisionHeightFieldTiled*)collision->GetChildShape();
+		dgVector q0 (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+		dgVector q1 (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+		shape->BeginTileRequests();
+		shape->RequestTiles (q0.GetMin (q1), q0.GetMax (q1));
+		shape->CommitTileRequests();
+	}
+}
+
+int NewtonTiledHeightFieldGetResidentTileCount (const NewtonCollision* const tiledHeightField)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionInstance* const collision = (dgCollisionInstance*)tiledHeightField;
+	if (collision->IsType(dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+		dgCollisionHeightFieldTiled* const shape = (dgCollisionHeightFieldTiled*)collision->GetChildShape();
+		return shape->GetResidentTileCount();
+	}
+	return 0;
+}
+
 /*!
   Prepare a *TreeCollision* to begin to accept the polygons that comprise the collision mesh.
 
@@ -3269,6 +3848,63 @@ void NewtonTreeCollisionEndBuild(const NewtonCollision* const treeCollision, int
 	collision->EndBuild(optimize);
 }
 
+/*!
+  Finalize the construction of the polygonal mesh using worker threads.
+
+  @param *treeCollision is the pointer to the collision tree.
+  @param optimize flag that indicates to Newton whether it should optimize this mesh, see ::NewtonTreeCollisionEndBuild.
+  @param threadCount number of threads used by the build, 1 builds on the calling thread.
+  @param quality 0 splits every node with the binned surface area heuristic, 1 splits the nodes of the sub trees at the best position over all their faces, which is slower but gives a tree with a lower cost.
+  @param *stats pointer to the structure that receives the statistics of the new tree, it can be NULL.
+
+  @return Nothing.
+
+  The optimization of flat faces is done in independent partitions of the mesh, the tree is built by splitting the large ranges of faces
+  across all threads and then building the sub trees as independent tasks, and the face edge normals are computed in parallel.
+  The build creates and destroys its own threads, and the world allocator is switched to thread safe mode while they run,
+  so this function must not be called while the world updates. The resulting mesh is the same for any thread count.
+
+  ::NewtonTreeCollisionEndBuild is the same as calling this function with one thread and quality 1.
+
+  See also: ::NewtonTreeCollisionEndBuild, ::NewtonTreeCollisionCompressNodes
+*/
+void NewtonTreeCollisionEndBuildParallel (const NewtonCollision* const treeCollision, int optimize, int threadCount, int quality, NewtonTreeCollisionBuildStats* const stats)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+
+	dgCollisionBVH::dgTreeStats treeStats;
+	collision->EndBuild(optimize, dgMax (threadCount, 1), quality ? DG_SOUP_BUILD_QUALITY_HIGH : DG_SOUP_BUILD_QUALITY_FAST, stats ? &treeStats : NULL);
+	if (stats) {
+		stats->m_sahCost = treeStats.m_sahCost;
+		stats->m_faceCount = treeStats.m_faceCount;
+		stats->m_nodeCount = treeStats.m_nodeCount;
+		stats->m_maxDepth = treeStats.m_maxDepth;
+	}
+}
+
+/*!
+  Convert the nodes of a finished *TreeCollision* to the compressed format.
+
+  @param *treeCollision is the pointer to the collision tree.
+
+  @return Nothing.
+
+  A compressed node stores the boxes of both of its children quantized to 16 bits relative to its own box, so a query reads one 32 byte node per visit
+  instead of a node and the box vertices of each child. The float boxes and their vertices are freed. The quantized boxes are conservative, queries report the same faces.
+  The format is kept by ::NewtonCollisionSerialize. Call this function after ::NewtonTreeCollisionEndBuild, a mesh that is already compressed is left unchanged.
+
+  See also: ::NewtonTreeCollisionEndBuild
+*/
+void NewtonTreeCollisionCompressNodes (const NewtonCollision* const treeCollision)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	dgCollisionBVH* const collision = (dgCollisionBVH*) ((dgCollisionInstance*)treeCollision)->GetChildShape();
+	dgAssert (collision->IsType (dgCollision::dgCollisionBVH_RTTI));
+	collision->CompressNodes();
+}
+
 
 /*!
   Get the user defined collision attributes stored with each face of the collision mesh.
@@ -4074,6 +4710,51 @@ NewtonCollision* NewtonCreateCollisionFromSerialization(const NewtonWorld* const
 	return  (NewtonCollision*) world->CreateCollisionFromSerialization ((dgDeserialize) deserializeFunction, serializeHandle);
 }
 
+/*!
+  Serialize a collision shape as a mapped image.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *collision is the pointer to the collision tree shape.
+  @param serializeFunction pointer to the event function that will do the serialization.
+  @param *serializeHandle	user data that will be passed to the _NewtonSerialize_ callback.
+
+  @return Nothing.
+
+  The image is the same stream written by *NewtonCollisionSerialize* preceded by a version header, with the vertex, face, node and elevation 
+  arrays padded to start at 16 byte offsets, so that the file can be memory mapped and used in place by *NewtonCreateCollisionFromMappedImage*.
+
+  See also: ::NewtonCreateCollisionFromMappedImage, ::NewtonCollisionSerialize
+*/
+void NewtonCollisionSerializeMappedImage(const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, NewtonSerializeCallback serializeFunction, void* const serializeHandle)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	world->SerializeCollisionMappedImage((dgCollisionInstance*) collision, (dgSerialize) serializeFunction, serializeHandle);
+}
+
+/*!
+  Create a collision shape that uses a mapped image in place.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *image pointer to the image written by *NewtonCollisionSerializeMappedImage*, it must be 16 byte aligned, a memory mapped file always is.
+  @param sizeInBytes size of the image.
+
+  @return the collision shape, or NULL if the image is not 16 byte aligned, has the wrong version or byte order, or is truncated.
+
+  The vertex, face and node arrays of tree collisions and the elevation maps of height fields point into the image instead of being copied, 
+  so many processes that map the same file read only share the same physical pages, and loading does not touch the pages until they are used.
+  The image must stay mapped for the life of the shape. The image can be mapped read only, unless the application changes the face attributes
+  of a tree collision, in which case it should be mapped copy on write.
+
+  See also: ::NewtonCollisionSerializeMappedImage, ::NewtonCreateCollisionFromSerialization
+*/
+NewtonCollision* NewtonCreateCollisionFromMappedImage(const NewtonWorld* const newtonWorld, const void* const image, dLong sizeInBytes)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	return (NewtonCollision*) world->CreateCollisionFromMappedImage (image, size_t (sizeInBytes));
+}
+
 
 /*!
   Get creation parameters for this collision objects.
@@ -4318,6 +4999,105 @@ void NewtonDestroyBody (const NewtonBody* const bodyPtr)
 	world->DestroyBody(body);
 }
 
+static void NewtonCreateBodies (const NewtonWorld* const newtonWorld, dgBody::dgType type, int count, const NewtonCollision* const* const collisions, const dFloat* const matrices, NewtonBody** const bodies)
+{
+	Newton* const world = (Newton *)newtonWorld;
+	if (count <= 0) {
+		return;
+	}
+
+	dgCollisionInstance* nullCollision = NULL;
+	dgStack<dgMatrix> matrixArray (count);
+	dgStack<dgCollisionInstance*> collisionArray (count);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgCollisionInstance* collision = (dgCollisionInstance*)collisions[i];
+		if (!collision) {
+			if (!nullCollision) {
+				nullCollision = (dgCollisionInstance*) NewtonCreateNull(newtonWorld);
+			}
+			collision = nullCollision;
+		}
+		collisionArray[i] = collision;
+
+		dgMatrix& matrix = matrixArray[i];
+		matrix = dgMatrix (&matrices[i * 16]);
+		matrix.m_front.m_w = dgFloat32 (0.0f);
+		matrix.m_up.m_w    = dgFloat32 (0.0f);
+		matrix.m_right.m_w = dgFloat32 (0.0f);
+		matrix.m_posit.m_w = dgFloat32 (1.0f);
+	}
+
+	world->CreateBodies (type, count, &collisionArray[0], &matrixArray[0], (dgBody**) bodies);
+	if (nullCollision) {
+		NewtonDestroyCollision((NewtonCollision*)nullCollision);
+	}
+}
+
+/*!
+  Create a batch of rigid bodies.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param count number of bodies to create.
+  @param *collisions array of count pointers to the collision of each body, a NULL entry creates a body with a null collision.
+  @param *matrices array of count 4x4 matrices, sixteen consecutive floats per body.
+  @param *bodies array of count pointers that receives the new bodies.
+
+  @return Nothing.
+
+  The bodies are the same as the ones made by count calls to ::NewtonCreateDynamicBody, but they are allocated 
+  in one memory block and the broadphase builds them into a single subtree instead of inserting them one by one. 
+  This is the function to use for streaming in large groups of bodies.
+
+  See also: ::NewtonCreateDynamicBody, ::NewtonDestroyBodies
+*/
+void NewtonCreateDynamicBodies (const NewtonWorld* const newtonWorld, int count, const NewtonCollision* const* const collisions, const dFloat* const matrices, NewtonBody** const bodies)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	NewtonCreateBodies (newtonWorld, dgBody::m_dynamicBody, count, collisions, matrices, bodies);
+}
+
+/*!
+  Create a batch of kinematic bodies.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param count number of bodies to create.
+  @param *collisions array of count pointers to the collision of each body, a NULL entry creates a body with a null collision.
+  @param *matrices array of count 4x4 matrices, sixteen consecutive floats per body.
+  @param *bodies array of count pointers that receives the new bodies.
+
+  @return Nothing.
+
+  See also: ::NewtonCreateKinematicBody, ::NewtonCreateDynamicBodies
+*/
+void NewtonCreateKinematicBodies (const NewtonWorld* const newtonWorld, int count, const NewtonCollision* const* const collisions, const dFloat* const matrices, NewtonBody** const bodies)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	NewtonCreateBodies (newtonWorld, dgBody::m_kinematicBody, count, collisions, matrices, bodies);
+}
+
+/*!
+  Destroy a batch of rigid bodies.
+
+  @param *newtonWorld Pointer to the Newton world.
+  @param *bodies array of count pointers to the bodies to be destroyed.
+  @param count number of bodies.
+
+  @return Nothing.
+
+  The destroy callbacks are called for each body like in ::NewtonDestroyBody, but the broadphase removes 
+  all the bodies before any of them is released. This function must not be called from inside a simulation step.
+
+  See also: ::NewtonDestroyBody, ::NewtonCreateDynamicBodies
+*/
+void NewtonDestroyBodies (const NewtonWorld* const newtonWorld, const NewtonBody* const* const bodies, int count)
+{
+	TRACE_FUNCTION(__FUNCTION__);
+	Newton* const world = (Newton *)newtonWorld;
+	if (count > 0) {
+		world->DestroyBodies ((dgBody**) bodies, count);
+	}
+}
+
 /*
 void NewtonBodyEnableSimulation(const NewtonBody* const bodyPtr)
 {
@@ -7324,7 +8104,7 @@ void NewtonJointSetCollisionState(const NewtonJoint* const joint, int state)
 {
 	TRACE_FUNCTION(__FUNCTION__);
 	dgConstraint* const contraint = (dgConstraint*) joint;
-	return contraint->SetCollidable (state ? true : false);
+	contraint->SetCollidable (state ? true : false);
 }
 
 /*!
@@ -69,6 +69,12 @@ extern "C" {
 	
 	#define NEWTON_BROADPHASE_DEFAULT						0
 	#define NEWTON_BROADPHASE_PERSINTENT					1
+	#define NEWTON_BROADPHASE_LINEAR						2
+	#define NEWTON_BROADPHASE_QUAD							3
+	#define NEWTON_BROADPHASE_SWEEP_AND_PRUNE				4
+
+	#define NEWTON_RAY_CAST_CLOSEST_HIT						0
+	#define NEWTON_RAY_CAST_ANY_HIT							1
 
 	#define NEWTON_DYNAMIC_BODY								0
 	#define NEWTON_KINEMATIC_BODY							1
@@ -90,6 +96,7 @@ extern "C" {
 	#define SERIALIZE_ID_USERMESH							13
 	#define SERIALIZE_ID_SCENE								14
 	#define SERIALIZE_ID_FRACTURED_COMPOUND					15
+	#define SERIALIZE_ID_TILED_HEIGHTFIELD					16
 
 #ifdef __cplusplus
 	class NewtonMesh;
@@ -275,6 +282,15 @@ extern "C" {
 		const NewtonBody* m_hitBody;			// body hit at contact point
 		dFloat m_penetration;                   // contact penetration at collision point
 	} NewtonWorldConvexCastReturnInfo;
+
+	typedef struct NewtonWorldRayCastReturnInfo
+	{
+		dFloat m_point[4];						// ray intersection point in global space
+		dFloat m_normal[4];						// surface normal at the intersection point in global space
+		dLong m_contactID;						// collision ID at the intersection point
+		const NewtonBody* m_hitBody;			// body hit by the ray, NULL if the ray did not hit anything
+		dFloat m_intersectParam;				// intersection parameter along the ray, one if the ray did not hit anything
+	} NewtonWorldRayCastReturnInfo;
 	
 	typedef struct NewtonUserMeshCollisionRayHitDesc
 	{
@@ -331,6 +347,58 @@ extern "C" {
 		NewtonMeshFloatData m_vertexColor;
 	} NewtonMeshVertexFormat;
 
+	typedef struct NewtonAllocatorStats
+	{
+		int m_mallocCount;
+		int m_freeCount;
+		int m_magazineHits;
+		int m_refillCount;
+		int m_returnCount;
+		int m_crossThreadFreeCount;
+		int m_lockContention;
+	} NewtonAllocatorStats;
+
+	typedef struct NewtonProfilerPhase
+	{
+		const char* m_name;
+		const char* m_parentName;
+		dFloat m_time;							// inclusive time in seconds, summed over all calls and threads
+		dFloat m_maxTime;						// longest single call in seconds
+		int m_calls;
+		int m_depth;
+	} NewtonProfilerPhase;
+
+	typedef struct NewtonWorldStats
+	{
+		dFloat m_stepTime;						// all times are in seconds
+		dFloat m_forceCallbacksTime;
+		dFloat m_preListenersTime;
+		dFloat m_sleepingStateTime;
+		dFloat m_tileStreamingTime;				// loading the tiles of the tiled height fields
+		dFloat m_broadPhaseTime;
+		dFloat m_narrowPhaseTime;
+		dFloat m_buildClustersTime;
+		dFloat m_solverTime;
+		dFloat m_integrationTime;				// summed over the clusters, it is included in m_solverTime
+		dFloat m_postListenersTime;
+		int m_substeps;
+		int m_activeBodies;
+		int m_pairsTested;
+		int m_contactsCreated;
+		int m_contactsDestroyed;
+		int m_clusters;
+		int m_jointRows;
+		int m_solverPasses;
+	} NewtonWorldStats;
+
+	typedef struct NewtonTreeCollisionBuildStats
+	{
+		dFloat m_sahCost;						// expected node visits plus face tests of a ray crossing the root box
+		int m_faceCount;
+		int m_nodeCount;
+		int m_maxDepth;
+	} NewtonTreeCollisionBuildStats;
+
 	// Newton callback functions
 	typedef void* (*NewtonAllocMemory) (int sizeInBytes);
 	typedef void (*NewtonFreeMemory) (void* const ptr, int sizeInBytes);
@@ -368,6 +436,7 @@ extern "C" {
 
 	typedef dFloat (*NewtonCollisionTreeRayCastCallback) (const NewtonBody* const body, const NewtonCollision* const treeCollision, dFloat intersection, dFloat* const normal, int faceId, void* const usedData);
 	typedef dFloat (*NewtonHeightFieldRayCastCallback) (const NewtonBody* const body, const NewtonCollision* const heightFieldCollision, dFloat intersection, int row, int col, dFloat* const normal, int faceId, void* const usedData);
+	typedef int (*NewtonTiledHeightFieldTileCallback) (void* const userData, int x0, int z0, int width, int height, void* const elevation, char* const attributes);
 
 	typedef void (*NewtonCollisionCopyConstructionCallback) (const NewtonWorld* const newtonWorld, NewtonCollision* const collision, const NewtonCollision* const sourceCollision);
 	typedef void (*NewtonCollisionDestructorCallback) (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision);
@@ -423,6 +492,10 @@ extern "C" {
 	NEWTON_API int NewtonGetMemoryUsed ();
 	NEWTON_API void NewtonSetMemorySystem (NewtonAllocMemory malloc, NewtonFreeMemory free);
 
+	NEWTON_API int NewtonEnumerateSimdInstructionSets ();
+	NEWTON_API int NewtonGetSimdInstructionSet ();
+	NEWTON_API void NewtonSetSimdInstructionSet (int instructionSet);
+
 	NEWTON_API NewtonWorld* NewtonCreate ();
 	NEWTON_API NewtonWorld* NewtonCreateEx (int stackSizeInMegabytes);
 	NEWTON_API void NewtonDestroy (const NewtonWorld* const newtonWorld);
@@ -462,8 +535,19 @@ extern "C" {
 	//NEWTON_API unsigned NewtonReadPerformanceTicks (const NewtonWorld* const newtonWorld, unsigned performanceEntry);
 	//NEWTON_API unsigned NewtonReadThreadPerformanceTicks (const NewtonWorld* newtonWorld, unsigned threadIndex);
 
+	NEWTON_API int NewtonProfilerStartCapture (const NewtonWorld* const newtonWorld, const char* const traceFileName, int numberOfFrames);
+	NEWTON_API void NewtonProfilerStopCapture (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonProfilerUpdate ();
+	NEWTON_API int NewtonProfilerIsCapturing (const NewtonWorld* const newtonWorld);
+	NEWTON_API int NewtonProfilerGetFrameCount (const NewtonWorld* const newtonWorld);
+	NEWTON_API dFloat NewtonProfilerGetFrameTime (const NewtonWorld* const newtonWorld, int frame);
+	NEWTON_API int NewtonProfilerGetFramePhases (const NewtonWorld* const newtonWorld, int frame, NewtonProfilerPhase* const phases, int maxCount);
+
 	NEWTON_API int NewtonGetBroadphaseAlgorithm (const NewtonWorld* const newtonWorld);
 	NEWTON_API void NewtonSelectBroadphaseAlgorithm (const NewtonWorld* const newtonWorld, int algorithmType);
+	NEWTON_API dFloat NewtonGetBroadphaseRebuildRatio (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetBroadphaseRebuildRatio (const NewtonWorld* const newtonWorld, dFloat ratio);
+	NEWTON_API void NewtonRebuildBroadphase (const NewtonWorld* const newtonWorld);
 	
 	NEWTON_API void NewtonUpdate (const NewtonWorld* const newtonWorld, dFloat timestep);
 	NEWTON_API void NewtonUpdateAsync (const NewtonWorld* const newtonWorld, dFloat timestep);
@@ -473,6 +557,12 @@ extern "C" {
 	NEWTON_API void NewtonSetNumberOfSubsteps (const NewtonWorld* const newtonWorld, int subSteps);
 	NEWTON_API dFloat NewtonGetLastUpdateTime (const NewtonWorld* const newtonWorld);
 
+	NEWTON_API void NewtonWorldSetCollectStats (const NewtonWorld* const newtonWorld, int state);
+	NEWTON_API int NewtonWorldGetCollectStats (const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonWorldGetStats (const NewtonWorld* const newtonWorld, NewtonWorldStats* const stats);
+	NEWTON_API void NewtonWorldSetPrimitiveContacts (const NewtonWorld* const newtonWorld, int state);
+	NEWTON_API int NewtonWorldGetPrimitiveContacts (const NewtonWorld* const newtonWorld);
+
 	NEWTON_API void NewtonSerializeToFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodySerializationCallback bodyCallback, void* const bodyUserData);
 	NEWTON_API void NewtonDeserializeFromFile (const NewtonWorld* const newtonWorld, const char* const filename, NewtonOnBodyDeserializationCallback bodyCallback, void* const bodyUserData);
 
@@ -489,6 +579,8 @@ extern "C" {
 	NEWTON_API int NewtonGetMaxThreadsCount(const NewtonWorld* const newtonWorld);
 	NEWTON_API void NewtonDispachThreadJob(const NewtonWorld* const newtonWorld, NewtonJobTask task, void* const usedData);
 	NEWTON_API void NewtonSyncThreadJobs(const NewtonWorld* const newtonWorld);
+	NEWTON_API void NewtonSetThreadSafeAllocator (const NewtonWorld* const newtonWorld, int state);
+	NEWTON_API void NewtonGetAllocatorStats (const NewtonWorld* const newtonWorld, NewtonAllocatorStats* const stats);
 
 	// atomic operations
 	NEWTON_API int NewtonAtomicAdd (int* const ptr, int value);
@@ -520,6 +612,7 @@ extern "C" {
 	NEWTON_API void NewtonWorldSetCollisionConstructorDestructorCallback (const NewtonWorld* const newtonWorld, NewtonCollisionCopyConstructionCallback constructor, NewtonCollisionDestructorCallback destructor);
 
 	NEWTON_API void NewtonWorldRayCast (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, NewtonWorldRayFilterCallback filter, void* const userData, NewtonWorldRayPrefilterCallback prefilter, int threadIndex);
+	NEWTON_API int NewtonWorldRayCastBatch (const NewtonWorld* const newtonWorld, const dFloat* const p0, const dFloat* const p1, int strideInBytes, int rayCount, NewtonWorldRayCastReturnInfo* const info, int mode, void* const userData, NewtonWorldRayPrefilterCallback prefilter);
 	NEWTON_API int NewtonWorldConvexCast (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const dFloat* const target, const NewtonCollision* const shape, dFloat* const param, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
 	NEWTON_API int NewtonWorldCollide (const NewtonWorld* const newtonWorld, const dFloat* const matrix, const NewtonCollision* const shape, void* const userData, NewtonWorldRayPrefilterCallback prefilter, NewtonWorldConvexCastReturnInfo* const info, int maxContactsCount, int threadIndex);
 	
@@ -727,6 +820,8 @@ extern "C" {
 	// ***********************************************************************************************************
 	NEWTON_API NewtonCollision* NewtonCreateCollisionFromSerialization (const NewtonWorld* const newtonWorld, NewtonDeserializeCallback deserializeFunction, void* const serializeHandle);
 	NEWTON_API void NewtonCollisionSerialize (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, NewtonSerializeCallback serializeFunction, void* const serializeHandle);
+	NEWTON_API NewtonCollision* NewtonCreateCollisionFromMappedImage (const NewtonWorld* const newtonWorld, const void* const image, dLong sizeInBytes);
+	NEWTON_API void NewtonCollisionSerializeMappedImage (const NewtonWorld* const newtonWorld, const NewtonCollision* const collision, NewtonSerializeCallback serializeFunction, void* const serializeHandle);
 	NEWTON_API void NewtonCollisionGetInfo (const NewtonCollision* const collision, NewtonCollisionInfoRecord* const collisionInfo);
 
 	// **********************************************************************************************
@@ -738,6 +833,17 @@ extern "C" {
 																  const void* const elevationMap, const char* const attributeMap, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, int shapeID);
 	NEWTON_API void NewtonHeightFieldSetUserRayCastCallback (const NewtonCollision* const heightfieldCollision, NewtonHeightFieldRayCastCallback rayHitCallback);
 	NEWTON_API void NewtonHeightFieldSetHorizontalDisplacement (const NewtonCollision* const heightfieldCollision, const unsigned short* const horizontalMap, dFloat scale);
+	NEWTON_API void NewtonHeightFieldSetMinMaxPyramid (const NewtonCollision* const heightfieldCollision, int state);
+	NEWTON_API int NewtonHeightFieldGetMinMaxPyramid (const NewtonCollision* const heightfieldCollision);
+
+	NEWTON_API NewtonCollision* NewtonCreateTiledHeightFieldCollision (const NewtonWorld* const newtonWorld, int width, int height, int tileSize, int gridsDiagonals, int elevationdatType,
+																	   dFloat minElevation, dFloat maxElevation, dFloat verticalScale, dFloat horizontalScale_x, dFloat horizontalScale_z, int maxResidentTiles, int shapeID);
+	NEWTON_API void NewtonTiledHeightFieldSetTileCallback (const NewtonCollision* const tiledHeightfieldCollision, NewtonTiledHeightFieldTileCallback tileCallback, void* const userData);
+	NEWTON_API void NewtonTiledHeightFieldSetMappedSource (const NewtonCollision* const tiledHeightfieldCollision, const void* const elevationMap, const char* const attributeMap);
+	NEWTON_API void NewtonTiledHeightFieldSetPrefetchDistance (const NewtonCollision* const tiledHeightfieldCollision, dFloat distance);
+	NEWTON_API void NewtonTiledHeightFieldSetMaxResidentTiles (const NewtonCollision* const tiledHeightfieldCollision, int maxResidentTiles);
+	NEWTON_API void NewtonTiledHeightFieldRequestTiles (const NewtonCollision* const tiledHeightfieldCollision, const dFloat* const p0, const dFloat* const p1);
+	NEWTON_API int NewtonTiledHeightFieldGetResidentTileCount (const NewtonCollision* const tiledHeightfieldCollision);
 
 	NEWTON_API NewtonCollision* NewtonCreateTreeCollision (const NewtonWorld* const newtonWorld, int shapeID);
 	NEWTON_API NewtonCollision* NewtonCreateTreeCollisionFromMesh (const NewtonWorld* const newtonWorld, const NewtonMesh* const mesh, int shapeID);
@@ -746,6 +852,8 @@ extern "C" {
 	NEWTON_API void NewtonTreeCollisionBeginBuild (const NewtonCollision* const treeCollision);
 	NEWTON_API void NewtonTreeCollisionAddFace (const NewtonCollision* const treeCollision, int vertexCount, const dFloat* const vertexPtr, int strideInBytes, int faceAttribute);
 	NEWTON_API void NewtonTreeCollisionEndBuild (const NewtonCollision* const treeCollision, int optimize);
+	NEWTON_API void NewtonTreeCollisionEndBuildParallel (const NewtonCollision* const treeCollision, int optimize, int threadCount, int quality, NewtonTreeCollisionBuildStats* const stats);
+	NEWTON_API void NewtonTreeCollisionCompressNodes (const NewtonCollision* const treeCollision);
 
 	NEWTON_API int NewtonTreeCollisionGetFaceAttribute (const NewtonCollision* const treeCollision, const int* const faceIndexArray, int indexCount); 
 	NEWTON_API void NewtonTreeCollisionSetFaceAttribute (const NewtonCollision* const treeCollision, const int* const faceIndexArray, int indexCount, int attribute);
@@ -854,6 +962,10 @@ extern "C" {
 
 	NEWTON_API void NewtonDestroyBody(const NewtonBody* const body);
 
+	NEWTON_API void NewtonCreateDynamicBodies (const NewtonWorld* const newtonWorld, int count, const NewtonCollision* const* const collisions, const dFloat* const matrices, NewtonBody** const bodies);
+	NEWTON_API void NewtonCreateKinematicBodies (const NewtonWorld* const newtonWorld, int count, const NewtonCollision* const* const collisions, const dFloat* const matrices, NewtonBody** const bodies);
+	NEWTON_API void NewtonDestroyBodies (const NewtonWorld* const newtonWorld, const NewtonBody* const* const bodies, int count);
+
 	NEWTON_API int NewtonBodyGetSimulationState(const NewtonBody* const body);
 	NEWTON_API void NewtonBodySetSimulationState(const NewtonBody* const bodyPtr, const int state);
 
@@ -279,6 +279,9 @@ class dgBody
 	friend class dgBroadPhase;
 	friend class dgCollisionBVH;
 	friend class dgBroadPhaseNode;
+	friend class dgBroadPhaseLinear;
+	friend class dgBroadPhaseQuad;
+	friend class dgBroadPhaseSweepAndPrune;
 	friend class dgBodyMasterList;
 	friend class dgCollisionScene;
 	friend class dgCollisionConvex;
@@ -33,6 +33,7 @@ dgBodyMasterListRow::dgBodyMasterListRow ()
 	:dgList<dgBodyMasterListCell>(NULL)
 	,m_body (NULL)
 	,m_contactCount(0)
+	,m_bodyArrayIndex(-1)
 {
 }
 
@@ -240,8 +241,10 @@ void dgBodyMasterListRow::SortList()
 dgBodyMasterList::dgBodyMasterList (dgMemoryAllocator* const allocator)
 	:dgList<dgBodyMasterListRow>(allocator)
 	,m_disableBodies(allocator)
+	,m_bodyArray(allocator, 64)
 	,m_constraintCount (0)
 {
+	m_bodyArray.Resize(256);
 }
 
 
@@ -260,6 +263,10 @@ void dgBodyMasterList::AddBody (dgBody* const body)
 	if (GetFirst() != node) {
 		InsertAfter (GetFirst(), node);
 	}
+
+	const dgInt32 index = GetCount() - 1;
+	m_bodyArray[index] = body;
+	node->GetInfo().m_bodyArrayIndex = index;
 }
 
 void dgBodyMasterList::RemoveBody (dgBody* const body)
@@ -270,6 +277,14 @@ void dgBodyMasterList::RemoveBody (dgBody* const body)
 	node->GetInfo().RemoveAllJoints();
 	dgAssert (node->GetInfo().GetCount() == 0);
 
+	// fill the hole with the last body, so that the array stays dense
+	const dgInt32 index = node->GetInfo().m_bodyArrayIndex;
+	const dgInt32 lastIndex = GetCount() - 1;
+	dgAssert (m_bodyArray[index] == body);
+	dgBody* const lastBody = m_bodyArray[lastIndex];
+	m_bodyArray[index] = lastBody;
+	lastBody->m_masterNode->GetInfo().m_bodyArrayIndex = index;
+
 	Remove (node);
 	body->m_masterNode = NULL;
 }
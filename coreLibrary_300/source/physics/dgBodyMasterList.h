@@ -63,6 +63,7 @@ class dgBodyMasterListRow: public dgList<dgBodyMasterListCell>
 	dgBody* m_body;
 	dgListNode* m_acceleratedSearch[3];
 	dgInt32 m_contactCount;
+	dgInt32 m_bodyArrayIndex;
 	static dgInt32 m_contactCountReversal[];
 	friend class dgBodyMasterList;
 };
@@ -86,8 +87,15 @@ class dgBodyMasterList: public dgList<dgBodyMasterListRow>
 	dgUnsigned32 MakeSortMask(const dgBody* const body) const;
 	void SortMasterList();
 
+	// dense array of all bodies in the list, in no particular order
+	dgBody* const* GetBodyArray() const
+	{
+		return &m_bodyArray[0];
+	}
+
 	public:
 	dgTree<int, dgBody*> m_disableBodies;
+	dgArray<dgBody*> m_bodyArray;
 	dgUnsigned32 m_constraintCount;
 };
 
@@ -33,7 +33,6 @@
 #include "dgCollisionLumpedMassParticles.h"
 //#include "dgCollisionLumpedMassParticles.h"
 
-#define DG_CONVEX_CAST_POOLSIZE			32
 #define DG_BROADPHASE_AABB_SCALE		dgFloat32 (8.0f)
 #define DG_BROADPHASE_AABB_INV_SCALE	(dgFloat32 (1.0f) / DG_BROADPHASE_AABB_SCALE)
 #define DG_CONTACT_TRANSLATION_ERROR	dgFloat32 (1.0e-3f)
@@ -59,114 +58,40 @@ dgInt32 dgBroadPhase::m_obbTestSimplex[4][4] =
 };
 
 
-class dgBroadPhase::dgSpliteInfo
-{
-	public:
-	dgSpliteInfo (dgBroadPhaseNode** const boxArray, dgInt32 boxCount)
-	{
-		dgVector minP ( dgFloat32 (1.0e15f)); 
-		dgVector maxP (-dgFloat32 (1.0e15f)); 
-
-		if (boxCount == 2) {
-			m_axis = 1;
-			for (dgInt32 i = 0; i < boxCount; i ++) {
-				dgBroadPhaseNode* const node = boxArray[i];
-				dgAssert (node->IsLeafNode());
-				minP = minP.GetMin (node->m_minBox); 
-				maxP = maxP.GetMax (node->m_maxBox); 
-			}
-		} else {
-			dgVector median (dgFloat32 (0.0f));
-			dgVector varian (dgFloat32 (0.0f));
-			for (dgInt32 i = 0; i < boxCount; i ++) {
-				dgBroadPhaseNode* const node = boxArray[i];
-				dgAssert (node->IsLeafNode());
-				minP = minP.GetMin (node->m_minBox); 
-				maxP = maxP.GetMax (node->m_maxBox); 
-				dgVector p ((node->m_minBox + node->m_maxBox).CompProduct4(dgVector::m_half));
-				median += p;
-				varian += p.CompProduct4(p);
-			}
-
-			varian = varian.Scale4 (dgFloat32 (boxCount)) - median.CompProduct4(median);
-
-			dgInt32 index = 0;
-			dgFloat32 maxVarian = dgFloat32 (-1.0e10f);
-			for (dgInt32 i = 0; i < 3; i ++) {
-				if (varian[i] > maxVarian) {
-					index = i;
-					maxVarian = varian[i];
-				}
-			}
-
-			dgVector center = median.Scale4 (dgFloat32 (1.0f) / dgFloat32 (boxCount));
-
-			dgFloat32 test = center[index];
-
-			dgInt32 i0 = 0;
-			dgInt32 i1 = boxCount - 1;
-			do {    
-				for (; i0 <= i1; i0 ++) {
-					dgBroadPhaseNode* const node = boxArray[i0];
-					dgFloat32 val = (node->m_minBox[index] + node->m_maxBox[index]) * dgFloat32 (0.5f);
-					if (val > test) {
-						break;
-					}
-				}
-
-				for (; i1 >= i0; i1 --) {
-					dgBroadPhaseNode* const node = boxArray[i1];
-					dgFloat32 val = (node->m_minBox[index] + node->m_maxBox[index]) * dgFloat32 (0.5f);
-					if (val < test) {
-						break;
-					}
-				}
-
-				if (i0 < i1)	{
-					dgSwap(boxArray[i0], boxArray[i1]);
-					i0++; 
-					i1--;
-				}
-
-			} while (i0 <= i1);
-
-			if (i0 > 0){
-				i0 --;
-			}
-			if ((i0 + 1) >= boxCount) {
-				i0 = boxCount - 2;
-			}
-			m_axis = i0 + 1;
-		}
-
-		dgAssert (maxP.m_x - minP.m_x >= dgFloat32 (0.0f));
-		dgAssert (maxP.m_y - minP.m_y >= dgFloat32 (0.0f));
-		dgAssert (maxP.m_z - minP.m_z >= dgFloat32 (0.0f));
-		m_p0 = minP;
-		m_p1 = maxP;
-	}
-
-	dgInt32 m_axis;
-	dgVector m_p0;
-	dgVector m_p1;
-};
 
 
 dgBroadPhase::dgBroadPhase(dgWorld* const world)
 	:m_world(world)
 	,m_rootNode(NULL)
 	,m_generatedBodies(world->GetAllocator())
-	,m_updateList(world->GetAllocator())
+	,m_updateArray(world->GetAllocator(), 64)
 	,m_aggregateList(world->GetAllocator())
 	,m_lru(DG_CONTACT_DELAY_FRAMES)
-	,m_contacJointLock()
+	,m_treeRevision(0)
 	,m_criticalSectionLock()
 	,m_pendingSoftBodyCollisions(world->GetAllocator(), 64)
+	,m_pairHash(world->GetAllocator(), 64)
+	,m_pairCache(world->GetAllocator(), 64)
+	,m_pairCacheCount(0)
+	,m_pairCacheMissCount(0)
+	,m_pairHashSize(0)
 	,m_pendingSoftBodyPairsCount(0)
 	,m_dirtyNodesCount(0)
+	,m_updateCount(0)
 	,m_scanTwoWays(false)
 	,m_recursiveChunks(false)
+	,m_pairCacheIsValid(false)
+	,m_usePairCache(false)
+	,m_buildPairCache(false)
 {
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		m_pendingContacts[i].SetAllocator(world->GetAllocator());
+		m_pendingContactsCount[i] = 0;
+		m_pairCacheNewPairs[i].SetAllocator(world->GetAllocator());
+		m_pairCacheNewPairsCount[i] = 0;
+		m_pairCacheLeaves[i].SetAllocator(world->GetAllocator());
+		m_pairCacheLeavesCount[i] = 0;
+	}
 }
 
 dgBroadPhase::~dgBroadPhase()
@@ -190,8 +115,7 @@ void dgBroadPhase::MoveNodes (dgBroadPhase* const dst)
 		next = ptr->GetNext();
 		dgBroadPhaseAggregate* const aggregate = ptr->GetInfo();
 		m_aggregateList.Remove (aggregate->m_myAggregateNode);
-		m_updateList.Remove(aggregate->m_updateNode);
-		aggregate->m_updateNode = NULL;
+		RemoveFromUpdateArray(aggregate);
 		aggregate->m_myAggregateNode = NULL;
 		UnlinkAggregate(aggregate);
 		dst->LinkAggregate(aggregate);
@@ -240,6 +164,50 @@ dgBroadPhaseTreeNode* dgBroadPhase::InsertNode(dgBroadPhaseNode* const root, dgB
 	return parent;
 }
 
+void dgBroadPhase::AddLeaves (dgFitnessList& fitness, dgFloat64& entropy, dgBroadPhaseNode** const root, dgBroadPhaseNode* const parent, dgBroadPhaseNode** const leaves, dgInt32 count)
+{
+	dgAssert (count > 0);
+	const dgInt32 treeLeavesCount = *root ? fitness.GetCount() + 1 : 0;
+	if ((count * 2) >= treeLeavesCount) {
+		// a batch that is a good part of the tree would trigger a rebuild on the next update anyway, 
+		// so the tree is built with the new leaves right away and the entropy reference is set for the new tree
+		if ((treeLeavesCount + count) > 1) {
+			BuildTreeSAH(fitness, root, leaves, count);
+		} else {
+			*root = leaves[0];
+		}
+		(*root)->m_parent = parent;
+		dgAtomicExchangeAndAdd(&m_treeRevision, 1);
+		entropy = fitness.TotalCost();
+		fitness.m_buildEntropy = entropy;
+		fitness.m_buildCount = fitness.GetCount();
+	} else {
+		// a small batch is built into a sub tree that goes in the tree as a single node 
+		dgBroadPhaseNode* const subTree = (count > 1) ? BuildSubTreeSAH(fitness, leaves, count) : leaves[0];
+		dgBroadPhaseTreeNode* const node = InsertNode(*root, subTree);
+		node->m_fitnessNode = fitness.Append(node);
+		if (!node->m_parent) {
+			*root = node;
+		}
+	}
+}
+
+void dgBroadPhase::AddBodies(dgBody** const bodies, dgInt32 count)
+{
+	for (dgInt32 i = 0; i < count; i ++) {
+		Add(bodies[i]);
+	}
+}
+
+void dgBroadPhase::RemoveBodies(dgBody** const bodies, dgInt32 count)
+{
+	// unlinking a leaf does not touch the rest of the tree, a batch that removes a good part 
+	// of the leaves drops the tree entropy enough for the next update to rebuild it
+	for (dgInt32 i = 0; i < count; i ++) {
+		Remove(bodies[i]);
+	}
+}
+
 
 void dgBroadPhase::UpdateAggregateEntropyKernel(void* const context, void* const node, dgInt32 threadID)
 {
@@ -250,28 +218,61 @@ void dgBroadPhase::UpdateAggregateEntropyKernel(void* const context, void* const
 	broadPhase->UpdateAggregateEntropy(descriptor, (dgList<dgBroadPhaseAggregate*>::dgListNode*) node, threadID);
 }
 
-void dgBroadPhase::ForceAndToqueKernel(void* const context, void* const node, dgInt32 threadID)
+void dgBroadPhase::ForceAndToqueKernel(void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dTimeTrackerEvent(__FUNCTION__);
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
-	broadPhase->ApplyForceAndtorque(descriptor, (dgBodyMasterList::dgListNode*) node, threadID);
+	broadPhase->ApplyForceAndtorque(descriptor, threadID);
 }
 
-void dgBroadPhase::SleepingStateKernel(void* const context, void* const node, dgInt32 threadID)
+void dgBroadPhase::SleepingStateKernel(void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dTimeTrackerEvent(__FUNCTION__);
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
-	broadPhase->SleepingState(descriptor, (dgBodyMasterList::dgListNode*) node, threadID);
+	broadPhase->SleepingState(descriptor, threadID);
 }
 
-bool dgBroadPhase::DoNeedUpdate(dgBodyMasterList::dgListNode* const node) const
+dgInt32& dgBroadPhase::GetUpdateIndex (dgBroadPhaseNode* const node) const
 {
-	dgBody* const body = node->GetInfo().GetBody();
+	dgAssert (node->IsLeafNode());
+	if (node->IsAggregate()) {
+		return ((dgBroadPhaseAggregate*)node)->m_updateIndex;
+	}
+	return ((dgBroadPhaseBodyNode*)node)->m_updateIndex;
+}
+
+void dgBroadPhase::AddToUpdateArray (dgBroadPhaseNode* const node)
+{
+	dgInt32& index = GetUpdateIndex (node);
+	dgAssert (index == -1);
+	index = m_updateCount;
+	m_updateArray[m_updateCount] = node;
+	m_updateCount ++;
+	// the leaves already in the tree do not have the new leaf in their cached pairs
+	InvalidatePairCache();
+}
+
+void dgBroadPhase::RemoveFromUpdateArray (dgBroadPhaseNode* const node)
+{
+	dgInt32& index = GetUpdateIndex (node);
+	if (index != -1) {
+		dgAssert (m_updateArray[index] == node);
+		m_updateCount --;
+		dgBroadPhaseNode* const lastNode = m_updateArray[m_updateCount];
+		m_updateArray[index] = lastNode;
+		GetUpdateIndex (lastNode) = index;
+		index = -1;
+	}
+	// the cached pairs may still reference the leaf, the static leaves of the persistent broadphase are removed here too
+	InvalidatePairCache();
+}
 
+bool dgBroadPhase::DoNeedUpdate(dgBody* const body) const
+{
 	bool state = body->GetInvMass().m_w != dgFloat32 (0.0f);
 	state = state || !body->m_equilibrium || (body->GetExtForceAndTorqueCallback() != NULL);
 	return state;
@@ -289,78 +290,80 @@ void dgBroadPhase::UpdateAggregateEntropy (dgBroadphaseSyncDescriptor* const des
 }
 
 
-void dgBroadPhase::ApplyForceAndtorque(dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID)
+void dgBroadPhase::ApplyForceAndtorque(dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
 {
 	dgFloat32 timestep = descriptor->m_timestep;
 
-	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
-	while (node) {
-		if (DoNeedUpdate(node)) {
-			dgBody* const body = node->GetInfo().GetBody();
-
-			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
-				dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
-				dynamicBody->ApplyExtenalForces(timestep, threadID);
+	const dgBodyMasterList* const masterList = m_world;
+	dgBody* const* const bodyArray = masterList->GetBodyArray();
+	const dgInt32 bodyCount = masterList->GetCount();
+	dgInt32* const atomicIndex = &descriptor->m_atomicIndex;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE); i < bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE)) {
+		const dgInt32 count = dgMin (bodyCount - i, DG_BROADPHASE_BODY_CHUNK_SIZE);
+		for (dgInt32 j = 0; j < count; j ++) {
+			dgBody* const body = bodyArray[i + j];
+			if (DoNeedUpdate(body)) {
+				if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+					dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+					dynamicBody->ApplyExtenalForces(timestep, threadID);
+				}
 			}
 		}
-
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			node = node ? node->GetPrev() : NULL;
-		}
 	}
 }
 
 
-void dgBroadPhase::SleepingState(dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID)
+void dgBroadPhase::SleepingState(dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
 {
 	dgFloat32 timestep = descriptor->m_timestep;
 
-	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
-	while (node) {
-		if (DoNeedUpdate(node)) {
-			dgBody* const body = node->GetInfo().GetBody();
-
-			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
-				dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
-				if (!dynamicBody->IsInEquilibrium()) {
-					dynamicBody->m_sleeping = false;
-					dynamicBody->m_equilibrium = false;
-					dynamicBody->UpdateCollisionMatrix(timestep, threadID);
-				}
-				if (dynamicBody->GetInvMass().m_w == dgFloat32(0.0f) || body->m_collision->IsType(dgCollision::dgCollisionMesh_RTTI)) {
-					dynamicBody->m_sleeping = true;
-					dynamicBody->m_autoSleep = true;
-					dynamicBody->m_equilibrium = true;
-				}
-
-				dynamicBody->m_savedExternalForce = dynamicBody->m_externalForce;
-				dynamicBody->m_savedExternalTorque = dynamicBody->m_externalTorque;
-			} else {
-				dgAssert(body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
+	const dgBodyMasterList* const masterList = m_world;
+	dgBody* const* const bodyArray = masterList->GetBodyArray();
+	const dgInt32 bodyCount = masterList->GetCount();
+	dgInt32* const atomicIndex = &descriptor->m_atomicIndex;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE); i < bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE)) {
+		const dgInt32 count = dgMin (bodyCount - i, DG_BROADPHASE_BODY_CHUNK_SIZE);
+		for (dgInt32 k = 0; k < count; k ++) {
+			dgBody* const body = bodyArray[i + k];
+			if (DoNeedUpdate(body)) {
+				if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+					dgDynamicBody* const dynamicBody = (dgDynamicBody*)body;
+					if (!dynamicBody->IsInEquilibrium()) {
+						dynamicBody->m_sleeping = false;
+						dynamicBody->m_equilibrium = false;
+						dynamicBody->UpdateCollisionMatrix(timestep, threadID);
+					}
+					if (dynamicBody->GetInvMass().m_w == dgFloat32(0.0f) || body->m_collision->IsType(dgCollision::dgCollisionMesh_RTTI)) {
+						dynamicBody->m_sleeping = true;
+						dynamicBody->m_autoSleep = true;
+						dynamicBody->m_equilibrium = true;
+					}
 
-				// kinematic bodies are always sleeping (skip collision with kinematic bodies)
-				if (body->IsCollidable()) {
-					body->m_sleeping = false;
-					body->m_autoSleep = false;
+					dynamicBody->m_savedExternalForce = dynamicBody->m_externalForce;
+					dynamicBody->m_savedExternalTorque = dynamicBody->m_externalTorque;
 				} else {
-					body->m_sleeping = true;
-					body->m_autoSleep = true;
-				}
-				body->m_equilibrium = true;
+					dgAssert(body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
 
-				// update collision matrix by calling the transform callback for all kinematic bodies
-				body->UpdateMatrix(timestep, threadID);
-			}
-		}
+					// kinematic bodies are always sleeping (skip collision with kinematic bodies)
+					if (body->IsCollidable()) {
+						body->m_sleeping = false;
+						body->m_autoSleep = false;
+					} else {
+						body->m_sleeping = true;
+						body->m_autoSleep = true;
+					}
+					body->m_equilibrium = true;
 
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			node = node ? node->GetPrev() : NULL;
+					// update collision matrix by calling the transform callback for all kinematic bodies
+					body->UpdateMatrix(timestep, threadID);
+				}
+			}
 		}
 	}
 }
 
 
-void dgBroadPhase::ForEachBodyInAABB(const dgBroadPhaseNode** stackPool, dgInt32 stack, const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+bool dgBroadPhase::ForEachBodyInAABB(const dgBroadPhaseNode** stackPool, dgInt32 stack, const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
 {
 	while (stack) {
 		stack--;
@@ -371,7 +374,7 @@ void dgBroadPhase::ForEachBodyInAABB(const dgBroadPhaseNode** stackPool, dgInt32
 			if (body) {
 				if (dgOverlapTest(body->m_minAABB, body->m_maxAABB, minBox, maxBox)) {
 					if (!callback(body, userData)) {
-						break;
+						return false;
 					}
 				}
 			} else if (rootNode->IsAggregate()) {
@@ -395,6 +398,7 @@ void dgBroadPhase::ForEachBodyInAABB(const dgBroadPhaseNode** stackPool, dgInt32
 			}
 		}
 	}
+	return true;
 }
 
 
@@ -712,17 +716,20 @@ void dgBroadPhase::UpdateBody(dgBody* const body, dgInt32 threadIndex)
 		const dgBroadPhaseNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? NULL : m_rootNode;
 
 		dgThreadHiveScopeLock lock(m_world, &m_criticalSectionLock, true);
-		if (body1->GetBroadPhaseAggregate()) {
-			dgBroadPhaseAggregate* const aggregate = body1->GetBroadPhaseAggregate();
+		dgBroadPhaseAggregate* const aggregate = body1->GetBroadPhaseAggregate();
+		if (aggregate) {
 			aggregate->m_isInEquilibrium = body1->m_equilibrium;
 			aggregate->SetAsDirty(m_lru + 1);
 		}
 
+		bool pairCacheMiss = false;
 		m_dirtyNodesCount += (node->m_nodeIsDirtyLru != (m_lru + 1)) ? 1 : 0;
 		node->SetAsDirty(m_lru + 1);
 		if (!dgBoxInclusionTest(body1->m_minAABB, body1->m_maxAABB, node->m_minBox, node->m_maxBox)) {
 			dgAssert(!node->IsAggregate());
+			pairCacheMiss = true;
 			node->SetAABB(body1->m_minAABB, body1->m_maxAABB);
+			UpdateLeafBox(node);
 			for (dgBroadPhaseNode* parent = node->m_parent; parent != root; parent = parent->m_parent) {
 				if (!parent->IsAggregate()) {
 					dgVector minBox;
@@ -742,94 +749,18 @@ void dgBroadPhase::UpdateBody(dgBody* const body, dgInt32 threadIndex)
 				}
 			}
 		}
-	}
-}
 
-
-dgBroadPhaseNode* dgBroadPhase::BuildTopDown(dgBroadPhaseNode** const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgFitnessList::dgListNode** const nextNode)
-{
-	dgAssert(firstBox >= 0);
-	dgAssert(lastBox >= 0);
-
-	if (lastBox == firstBox) {
-		return leafArray[firstBox];
-	} else {
-		dgSpliteInfo info(&leafArray[firstBox], lastBox - firstBox + 1);
-
-		dgBroadPhaseTreeNode* const parent = (*nextNode)->GetInfo();
-		parent->m_parent = NULL;
-		*nextNode = (*nextNode)->GetNext();
-
-		parent->SetAABB(info.m_p0, info.m_p1);
-
-		parent->m_left = BuildTopDown(leafArray, firstBox, firstBox + info.m_axis - 1, nextNode);
-		parent->m_left->m_parent = parent;
-
-		parent->m_right = BuildTopDown(leafArray, firstBox + info.m_axis, lastBox, nextNode);
-		parent->m_right->m_parent = parent;
-		return parent;
-	}
-}
-
-
-dgBroadPhaseNode* dgBroadPhase::BuildTopDownBig(dgBroadPhaseNode** const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgFitnessList::dgListNode** const nextNode)
-{
-	if (lastBox == firstBox) {
-		return BuildTopDown(leafArray, firstBox, lastBox, nextNode);
-	}
-
-	dgInt32 midPoint = -1;
-	const dgFloat32 scale = dgFloat32(10.0f);
-	const dgFloat32 scale2 = dgFloat32(3.0f) * scale * scale;
-	const dgInt32 count = lastBox - firstBox;
-	for (dgInt32 i = 0; i < count; i++) {
-		const dgBroadPhaseNode* const node0 = leafArray[firstBox + i];
-		const dgBroadPhaseNode* const node1 = leafArray[firstBox + i + 1];
-		if (node1->m_surfaceArea >(scale2 * node0->m_surfaceArea)) {
-			midPoint = i;
-			break;
-		}
-	}
-
-	if (midPoint == -1) {
-		return BuildTopDown(leafArray, firstBox, lastBox, nextNode);
-	} else {
-		dgBroadPhaseTreeNode* const parent = (*nextNode)->GetInfo();
-
-		parent->m_parent = NULL;
-		*nextNode = (*nextNode)->GetNext();
-
-		dgVector minP(dgFloat32(1.0e15f));
-		dgVector maxP(-dgFloat32(1.0e15f));
-		for (dgInt32 i = 0; i <= count; i++) {
-			const dgBroadPhaseNode* const node = leafArray[firstBox + i];
-			dgAssert(node->IsLeafNode());
-			minP = minP.GetMin(node->m_minBox);
-			maxP = maxP.GetMax(node->m_maxBox);
+		if (pairCacheMiss) {
+			// the cached pairs of the leaf are found again by the next scan
+			node->m_pairCacheLru = m_lru + 1;
+			if (aggregate) {
+				aggregate->m_pairCacheLru = m_lru + 1;
+			} else if (node->m_updateIndex == -1) {
+				// static leaves of the persistent broadphase are never scanned, only a full scan finds their new pairs
+				m_pairCacheIsValid = false;
+			}
 		}
-
-		parent->SetAABB(minP, maxP);
-		parent->m_left = BuildTopDown(leafArray, firstBox, firstBox + midPoint, nextNode);
-		parent->m_left->m_parent = parent;
-
-		parent->m_right = BuildTopDownBig(leafArray, firstBox + midPoint + 1, lastBox, nextNode);
-		parent->m_right->m_parent = parent;
-		return parent;
-	}
-}
-
-
-dgInt32 dgBroadPhase::CompareNodes(const dgBroadPhaseNode* const nodeA, const dgBroadPhaseNode* const nodeB, void* const)
-{
-	dgFloat32 areaA = nodeA->m_surfaceArea;
-	dgFloat32 areaB = nodeB->m_surfaceArea;
-	if (areaA < areaB) {
-		return -1;
-	}
-	if (areaA > areaB) {
-		return 1;
 	}
-	return 0;
 }
 
 
@@ -839,51 +770,45 @@ void dgBroadPhase::ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy,
 	if (*root) {
 		dgBroadPhaseNode* const parent = (*root)->m_parent;
 		(*root)->m_parent = NULL;
-		dgFloat64 entropy = CalculateEntropy(fitness, root);
 
-		if ((entropy > oldEntropy * dgFloat32(2.0f)) || (entropy < oldEntropy * dgFloat32(0.5f))) {
-			if (fitness.GetFirst()) {
-				m_world->m_solverJacobiansMemory.ResizeIfNecessary ((fitness.GetCount() * 2 + 16) * sizeof (dgBroadPhaseNode*));
-				dgBroadPhaseNode** const leafArray = (dgBroadPhaseNode**)&m_world->m_solverJacobiansMemory[0];
-
-				dgInt32 leafNodesCount = 0;
-				for (dgFitnessList::dgListNode* nodePtr = fitness.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) {
-					dgBroadPhaseNode* const node = nodePtr->GetInfo();
-					dgBroadPhaseNode* const leftNode = node->GetLeft();
-					dgBody* const leftBody = leftNode->GetBody();
-					if (leftBody) {
-						node->SetAABB(leftBody->m_minAABB, leftBody->m_maxAABB);
-						leafArray[leafNodesCount] = leftNode;
-						leafNodesCount++;
-					} else if (leftNode->IsAggregate()) {
-						leafArray[leafNodesCount] = leftNode;
-						leafNodesCount++;
-					}
-					dgBroadPhaseNode* const rightNode = node->GetRight();
-					dgBody* const rightBody = rightNode->GetBody();
-					if (rightBody) {
-						rightNode->SetAABB(rightBody->m_minAABB, rightBody->m_maxAABB);
-						leafArray[leafNodesCount] = rightNode;
-						leafNodesCount++;
-					} else if (rightNode->IsAggregate()) {
-						leafArray[leafNodesCount] = rightNode;
-						leafNodesCount++;
-					}
-				}
-
-				dgFitnessList::dgListNode* nodePtr = fitness.GetFirst();
+		// a reset entropy means the tree is rebuilt, there is no point in rotating it first
+		bool rebuild = (oldEntropy == dgFloat32 (0.0f));
+		dgFloat64 entropy = dgFloat32 (0.0f);
+		if (!rebuild) {
+			entropy = CalculateEntropy(fitness, root);
+			rebuild = (entropy > oldEntropy * dgFloat32(2.0f)) || (entropy < oldEntropy * dgFloat32(0.5f));
+
+			// rotations only fix the tree locally, after mass spawns or explosions the tree keeps degrading slowly
+			// so it is also rebuilt once the entropy per node exceeds the one of the last build by the rebuild ratio
+			const dgFloat32 ratio = m_world->m_broadPhaseRebuildRatio;
+			if ((ratio > dgFloat32 (0.0f)) && fitness.m_buildCount && fitness.GetCount()) {
+				rebuild |= (entropy * fitness.m_buildCount) > (ratio * fitness.m_buildEntropy * fitness.GetCount());
+			}
+		}
 
-				dgSortIndirect(leafArray, leafNodesCount, CompareNodes);
-				*root = BuildTopDownBig(leafArray, 0, leafNodesCount - 1, &nodePtr);
+		if (rebuild) {
+			// the rotations of the next update take care of whatever the builder left
+			if (fitness.GetFirst()) {
+				BuildTreeSAH(fitness, root);
 				dgAssert(!(*root)->m_parent);
-				entropy = CalculateEntropy(fitness, root);
+				dgAtomicExchangeAndAdd(&m_treeRevision, 1);
 			}
+			entropy = fitness.TotalCost();
+			fitness.m_buildEntropy = entropy;
+			fitness.m_buildCount = fitness.GetCount();
 		}
 		(*root)->m_parent = parent;
 		oldEntropy = entropy;
 	}
 }
 
+void dgBroadPhase::RebuildTree()
+{
+	// a reset entropy forces all the trees of the broad phase to be rebuilt
+	ResetEntropy();
+	UpdateFitness();
+}
+
 
 void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNode** const root)
 {
@@ -904,6 +829,7 @@ void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNod
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		dgAtomicExchangeAndAdd(&m_treeRevision, 1);
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (grandParent) {
@@ -932,6 +858,7 @@ void dgBroadPhase::RotateLeft (dgBroadPhaseTreeNode* const node, dgBroadPhaseNod
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		dgAtomicExchangeAndAdd(&m_treeRevision, 1);
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (grandParent) {
@@ -977,6 +904,7 @@ void dgBroadPhase::RotateRight (dgBroadPhaseTreeNode* const node, dgBroadPhaseNo
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		dgAtomicExchangeAndAdd(&m_treeRevision, 1);
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (grandParent) {
@@ -1005,6 +933,7 @@ void dgBroadPhase::RotateRight (dgBroadPhaseTreeNode* const node, dgBroadPhaseNo
 		node->m_minBox = parent->m_minBox;
 		node->m_maxBox = parent->m_maxBox;
 		node->m_surfaceArea = parent->m_surfaceArea;
+		dgAtomicExchangeAndAdd(&m_treeRevision, 1);
 
 		dgBroadPhaseTreeNode* const grandParent = (dgBroadPhaseTreeNode*) parent->m_parent;
 		if (parent->m_parent) {
@@ -1059,6 +988,22 @@ bool dgBroadPhase::ValidateContactCache(dgContact* const contact, dgFloat32 time
 }
 
 
+// the convex primitive pairs of a thread are collected by kind and collided DG_PRIMITIVE_BATCH_WIDTH at the time
+class dgBroadPhase::dgPrimitivePairBatch
+{
+	public:
+	dgPrimitivePairBatch(dgFloat32 timestep)
+		:m_timestep(timestep)
+	{
+		memset (m_count, 0, sizeof (m_count));
+	}
+
+	dgContact* m_pairs[m_primitiveBatchKinds][DG_PRIMITIVE_BATCH_WIDTH];
+	dgInt32 m_count[m_primitiveBatchKinds];
+	dgFloat32 m_timestep;
+};
+
+
 void dgBroadPhase::CalculatePairContacts (dgPair* const pair, dgInt32 threadID)
 {
     dgContactPoint contacts[DG_MAX_CONTATCS];
@@ -1066,7 +1011,11 @@ void dgBroadPhase::CalculatePairContacts (dgPair* const pair, dgInt32 threadID)
 	pair->m_cacheIsValid = false;
 	pair->m_contactBuffer = contacts;
 	m_world->CalculateContacts(pair, threadID, false, false);
+	ProcessPairContacts (pair, threadID);
+}
 
+void dgBroadPhase::ProcessPairContacts (dgPair* const pair, dgInt32 threadID)
+{
 	if (pair->m_contactCount) {
 		if (pair->m_contact->m_body0->m_invMass.m_w != dgFloat32 (0.0f)) {
 			pair->m_contact->m_body0->m_equilibrium = false;
@@ -1087,7 +1036,37 @@ void dgBroadPhase::CalculatePairContacts (dgPair* const pair, dgInt32 threadID)
 	}
 }
 
-void dgBroadPhase::AddPair (dgContact* const contact, dgFloat32 timestep, dgInt32 threadIndex)
+void dgBroadPhase::CalculatePairContactsBatch (dgPrimitivePairBatch* const batch, dgInt32 kind, dgInt32 threadID)
+{
+	dgPrimitiveContact results[DG_PRIMITIVE_BATCH_WIDTH];
+	dgInt32 valid[DG_PRIMITIVE_BATCH_WIDTH];
+
+	const dgInt32 count = batch->m_count[kind];
+	dgContact* const* const pairs = batch->m_pairs[kind];
+	m_world->CalculatePrimitiveContactBatch (kind, pairs, count, results, valid);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgContact* const contact = pairs[i];
+		dgPair pair;
+		pair.m_contact = contact;
+		pair.m_timestep = batch->m_timestep;
+		if (valid[i]) {
+			dgContactPoint contacts[DG_MAX_CONTATCS];
+			pair.m_cacheIsValid = false;
+			pair.m_contactBuffer = contacts;
+			m_world->CalculatePrimitivePairContacts (&pair, results[i], threadID);
+			ProcessPairContacts (&pair, threadID);
+		} else {
+			CalculatePairContacts (&pair, threadID);
+		}
+		if (contact->m_maxDOF) {
+			contact->m_timeOfImpact = dgFloat32(1.0e10f);
+		}
+	}
+	batch->m_count[kind] = 0;
+}
+
+// returns true when the pair was queued in the batch, its contacts are calculated when the batch is full or flushed
+bool dgBroadPhase::AddPair (dgContact* const contact, dgFloat32 timestep, dgInt32 threadIndex, dgPrimitivePairBatch* const batch)
 {
 	dgWorld* const world = (dgWorld*) m_world;
 	dgBody* const body0 = contact->m_body0;
@@ -1102,7 +1081,7 @@ void dgBroadPhase::AddPair (dgContact* const contact, dgFloat32 timestep, dgInt3
 	dgAssert (body1->GetWorld() == world);
 	if (!(body0->m_collideWithLinkedBodies & body1->m_collideWithLinkedBodies)) {
 		if (world->AreBodyConnectedByJoints (body0, body1)) {
-			return;
+			return false;
 		}
 	}
 
@@ -1117,11 +1096,305 @@ void dgBroadPhase::AddPair (dgContact* const contact, dgFloat32 timestep, dgInt3
 			dgAssert (!body0->m_collision->IsType (dgCollision::dgCollisionNull_RTTI));
 			dgAssert (!body1->m_collision->IsType (dgCollision::dgCollisionNull_RTTI));
 
+			if (batch) {
+				const dgInt32 kind = world->GetPrimitiveBatchKind (contact);
+				if (kind >= 0) {
+					dgAssert (batch->m_count[kind] < DG_PRIMITIVE_BATCH_WIDTH);
+					batch->m_pairs[kind][batch->m_count[kind]] = contact;
+					batch->m_count[kind] ++;
+					if (batch->m_count[kind] == DG_PRIMITIVE_BATCH_WIDTH) {
+						CalculatePairContactsBatch (batch, kind, threadIndex);
+					}
+					return true;
+				}
+			}
+
 			pair.m_contact = contact;
 			pair.m_timestep = timestep;
             CalculatePairContacts (&pair, threadIndex);
 		}
 	}
+	return false;
+}
+
+
+bool dgBroadPhase::AddPairToHash (const dgBody* const body0, const dgBody* const body1, dgInt32& slot)
+{
+	// unique ids are never repeated, so key zero marks an empty slot
+	dgUnsigned32 id0 = dgUnsigned32 (body0->m_uniqueID);
+	dgUnsigned32 id1 = dgUnsigned32 (body1->m_uniqueID);
+	if (id1 < id0) {
+		dgSwap (id0, id1);
+	}
+	const dgInt64 key = dgInt64 ((dgUnsigned64 (id1) << 32) | id0);
+	dgAssert (key);
+
+	const dgInt32 mask = m_pairHashSize - 1;
+	dgInt64* const hash = &m_pairHash[0];
+	dgInt32 index = dgInt32 ((dgUnsigned64 (key) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+	for (dgInt32 i = 0; i < m_pairHashSize; i ++) {
+		const dgInt64 entry = hash[index];
+		if (entry == key) {
+			return false;
+		}
+		if (!entry) {
+			const dgInt64 oldEntry = dgInterlockedCompareExchange64 (&hash[index], key, 0);
+			if (!oldEntry) {
+				slot = index;
+				return true;
+			}
+			if (oldEntry == key) {
+				return false;
+			}
+		}
+		index = (index + 1) & mask;
+	}
+
+	// the table is full, duplicates will be filtered when the contacts are created
+	slot = -1;
+	return true;
+}
+
+
+void dgBroadPhase::ResizePairHash ()
+{
+	const dgActiveContacts* const contactList = m_world;
+	const dgInt32 expectedPairs = 2 * (contactList->GetCount() + m_updateCount);
+	if (expectedPairs > (m_pairHashSize >> 1)) {
+		dgInt32 size = dgMax (m_pairHashSize, DG_BROADPHASE_MIN_PAIR_HASH_SIZE);
+		while (size < expectedPairs * 2) {
+			size *= 2;
+		}
+		m_pairHash.Resize(size);
+		m_pairHashSize = size;
+		memset (&m_pairHash[0], 0, size * sizeof (dgInt64));
+	}
+
+	// the pending arrays are written by the scan threads, so they are grown here before the scan starts
+	const dgInt32 threadsCount = m_world->GetThreadCount();
+	for (dgInt32 i = 0; i < threadsCount; i ++) {
+		m_pendingContacts[i].ResizeIfNecessary (expectedPairs);
+	}
+}
+
+
+void dgBroadPhase::CreatePendingContacts ()
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgInt64* const hash = &m_pairHash[0];
+	dgInt32 createdCount = 0;
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		const dgInt32 count = m_pendingContactsCount[i];
+		for (dgInt32 j = 0; j < count; j ++) {
+			const dgPendingContact& pending = m_pendingContacts[i][j];
+			dgBody* const body0 = pending.m_body0;
+			dgBody* const body1 = pending.m_body1;
+			if (pending.m_hashSlot >= 0) {
+				hash[pending.m_hashSlot] = 0;
+			}
+
+			if (pending.m_isSoftBody) {
+				m_pendingSoftBodyCollisions[m_pendingSoftBodyPairsCount].m_body0 = body0;
+				m_pendingSoftBodyCollisions[m_pendingSoftBodyPairsCount].m_body1 = body1;
+				m_pendingSoftBodyPairsCount++;
+			} else {
+				dgContact* contact = m_world->FindContactJoint(body0, body1);
+				if (!contact) {
+					contact = new (m_world->m_allocator) dgContact(m_world, pending.m_material);
+					contact->AppendToActiveList();
+					m_world->AttachConstraint(contact, body0, body1);
+					createdCount ++;
+
+					contact->m_contactActive = 0;
+					contact->m_positAcc = dgVector(dgFloat32(10.0f));
+					contact->m_timeOfImpact = dgFloat32(1.0e10f);
+				}
+				contact->m_broadphaseLru = m_lru;
+			}
+		}
+		m_pendingContactsCount[i] = 0;
+	}
+
+	dgWorldStats* const stats = m_world->GetStatsCollector();
+	if (stats) {
+		stats->m_contactsCreated += createdCount;
+	}
+}
+
+
+void dgBroadPhase::ExpirePairCacheContacts (dgBroadPhaseNode* const leaf, dgInt32& destroyedCount)
+{
+	dgAssert (leaf->IsLeafNode());
+	if (leaf->IsAggregate()) {
+		dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*) leaf;
+		if (aggregate->m_root) {
+			dgBroadPhaseNode* pool[DG_BROADPHASE_MAX_STACK_DEPTH];
+			pool[0] = aggregate->m_root;
+			dgInt32 stack = 1;
+			while (stack) {
+				stack --;
+				dgBroadPhaseNode* const node = pool[stack];
+				if (node->IsLeafNode()) {
+					ExpirePairCacheContacts (node, destroyedCount);
+				} else {
+					pool[stack] = node->GetLeft();
+					stack ++;
+					pool[stack] = node->GetRight();
+					stack ++;
+					dgAssert(stack < dgInt32(sizeof (pool) / sizeof (pool[0])));
+				}
+			}
+		}
+	} else {
+		// same expiration as the contact list scan, the other body of a contact at rest is in equilibrium
+		dgBody* const body = leaf->GetBody();
+		dgAssert (body && body->m_masterNode);
+		const dgUnsigned32 lru = m_lru - DG_CONTACT_DELAY_FRAMES;
+		dgBodyMasterListRow& row = body->m_masterNode->GetInfo();
+		for (dgBodyMasterListRow::dgListNode* link = row.GetFirst(); link;) {
+			dgConstraint* const joint = link->GetInfo().m_joint;
+			link = link->GetNext();
+			if (joint->GetId() == dgConstraint::m_contactConstraint) {
+				dgContact* const contact = (dgContact*) joint;
+				const dgInt32 equilbriun0 = contact->GetBody0()->m_equilibrium;
+				const dgInt32 equilbriun1 = contact->GetBody1()->m_equilibrium;
+				if (equilbriun0 & equilbriun1) {
+					contact->m_broadphaseLru = lru;
+				}
+				if (contact->m_broadphaseLru < lru) {
+					m_world->DestroyConstraint(contact);
+					destroyedCount ++;
+				}
+			}
+		}
+	}
+}
+
+
+void dgBroadPhase::FindPairCacheLeaves (dgBroadPhaseNode* const leaf, bool twoWays, dgFloat32 timestep, dgInt32 threadID)
+{
+	dgAssert (leaf->IsLeafNode());
+	for (dgBroadPhaseNode* ptr = leaf; ptr->m_parent; ptr = ptr->m_parent) {
+		dgBroadPhaseNode* const parent = ptr->m_parent;
+		dgAssert (!parent->IsLeafNode());
+		dgBroadPhaseNode* const rightSibling = parent->GetRight();
+		if (rightSibling && (rightSibling != ptr)) {
+			SubmitPairCacheLeaves (leaf, rightSibling, twoWays, timestep, threadID);
+		}
+		if (twoWays) {
+			dgBroadPhaseNode* const leftSibling = parent->GetLeft();
+			if (leftSibling && (leftSibling != ptr)) {
+				SubmitPairCacheLeaves (leaf, leftSibling, twoWays, timestep, threadID);
+			}
+		}
+	}
+}
+
+
+void dgBroadPhase::SubmitPairCacheLeaves (dgBroadPhaseNode* const leaf, dgBroadPhaseNode* const node, bool twoWays, dgFloat32 timestep, dgInt32 threadID)
+{
+	dgBroadPhaseNode* pool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	pool[0] = node;
+	dgInt32 stack = 1;
+
+	const dgUnsigned32 lru = m_lru;
+	const dgVector boxP0 (leaf->m_minBox);
+	const dgVector boxP1 (leaf->m_maxBox);
+	dgArray<dgPairCacheEntry>& newPairs = m_pairCacheNewPairs[threadID];
+	dgInt32& newPairsCount = m_pairCacheNewPairsCount[threadID];
+	while (stack) {
+		stack--;
+		dgBroadPhaseNode* const rootNode = pool[stack];
+		if (dgOverlapTest(rootNode->m_minBox, rootNode->m_maxBox, boxP0, boxP1)) {
+			if (rootNode->IsLeafNode()) {
+				// when the box of both leaves changed, both scans find the pair and only one of them keeps it
+				if (!twoWays || (rootNode->m_pairCacheLru < lru) || (GetUpdateIndex(leaf) < GetUpdateIndex(rootNode))) {
+					dgPairCacheEntry& pair = newPairs[newPairsCount];
+					pair.m_leaf0 = leaf;
+					pair.m_leaf1 = rootNode;
+					newPairsCount ++;
+					SubmitPairCachePair (leaf, rootNode, timestep, threadID);
+				}
+			} else {
+				dgBroadPhaseTreeNode* const tmpNode = (dgBroadPhaseTreeNode*) rootNode;
+				dgAssert (tmpNode->m_left);
+				dgAssert (tmpNode->m_right);
+
+				pool[stack] = tmpNode->m_left;
+				stack++;
+				dgAssert(stack < dgInt32(sizeof (pool) / sizeof (pool[0])));
+
+				pool[stack] = tmpNode->m_right;
+				stack++;
+				dgAssert(stack < dgInt32(sizeof (pool) / sizeof (pool[0])));
+			}
+		}
+	}
+}
+
+
+void dgBroadPhase::SubmitPairCachePair (dgBroadPhaseNode* const leaf0, dgBroadPhaseNode* const leaf1, dgFloat32 timestep, dgInt32 threadID)
+{
+	// the pair is submitted when the two way scan of a moving leaf would find it,
+	// that is when the body box of a moving leaf overlaps the box of the other leaf
+	const dgUnsigned32 lru = m_lru + 1;
+	dgBody* const body0 = leaf0->GetBody();
+	dgBody* const body1 = leaf1->GetBody();
+	bool overlap = false;
+	if (leaf0->GetDirtyLru() == lru) {
+		overlap = body0 ? dgOverlapTest(body0->m_minAABB, body0->m_maxAABB, leaf1->m_minBox, leaf1->m_maxBox) : true;
+	}
+	if (!overlap && (leaf1->GetDirtyLru() == lru)) {
+		overlap = body1 ? dgOverlapTest(body1->m_minAABB, body1->m_maxAABB, leaf0->m_minBox, leaf0->m_maxBox) : true;
+	}
+
+	if (overlap) {
+		if (body0) {
+			if (body1) {
+				if ((body0->GetInvMass().m_w != dgFloat32(0.0f)) || (body1->GetInvMass().m_w != dgFloat32(0.0f))) {
+					AddPair(body0, body1, timestep, threadID);
+				}
+			} else {
+				dgAssert (leaf1->IsAggregate());
+				dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*) leaf1;
+				aggregate->SummitPairs(body0, timestep, threadID);
+			}
+		} else {
+			dgAssert (leaf0->IsAggregate());
+			dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*) leaf0;
+			if (body1) {
+				aggregate->SummitPairs(body1, timestep, threadID);
+			} else {
+				dgAssert (leaf1->IsAggregate());
+				aggregate->SummitPairs((dgBroadPhaseAggregate*) leaf1, timestep, threadID);
+			}
+		}
+	}
+}
+
+
+void dgBroadPhase::UpdatePairCache ()
+{
+	dgInt32 count = 0;
+	if (m_usePairCache) {
+		// the pairs of the changed leaves were found again by the scan
+		for (dgInt32 i = 0; i < m_pairCacheCount; i ++) {
+			if (m_pairCache[i].m_leaf0) {
+				m_pairCache[count] = m_pairCache[i];
+				count ++;
+			}
+		}
+	}
+
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		const dgInt32 newPairsCount = m_pairCacheNewPairsCount[i];
+		for (dgInt32 j = 0; j < newPairsCount; j ++) {
+			m_pairCache[count] = m_pairCacheNewPairs[i][j];
+			count ++;
+		}
+		m_pairCacheNewPairsCount[i] = 0;
+	}
+	m_pairCacheCount = count;
 }
 
 
@@ -1130,9 +1403,12 @@ void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgFl
 	dTimeTrackerEvent(__FUNCTION__);
 
 	dgAssert ((body0->GetInvMass().m_w != dgFloat32 (0.0f)) || (body1->GetInvMass().m_w != dgFloat32 (0.0f)) || (body0->IsRTTIType(dgBody::m_kinematicBodyRTTI)) || (body1->IsRTTIType(dgBody::m_kinematicBodyRTTI)));
-	dgThreadHiveScopeLock lock(m_world, &m_contacJointLock, true);
-	dgContact* contact = m_world->FindContactJoint(body0, body1);
-	if (!contact) {
+
+	// joints are not created or destroyed while pairs are being scanned, so the body joint lists can be read without a lock
+	dgContact* const contact = m_world->FindContactJoint(body0, body1);
+	if (contact) {
+		contact->m_broadphaseLru = m_lru;
+	} else {
 		const dgBilateralConstraint* const bilateral = m_world->FindBilateralJoint (body0, body1);
 		const bool isCollidable = bilateral ? bilateral->IsCollidable() : true;
 
@@ -1150,30 +1426,27 @@ void dgBroadPhase::AddPair (dgBody* const body0, dgBody* const body1, const dgFl
 			if (material->m_flags & dgContactMaterial::m_collisionEnable) {
 				bool kinematicBodyEquilibrium = (((body0->IsRTTIType(dgBody::m_kinematicBodyRTTI) ? true : false) & body0->IsCollidable()) | ((body1->IsRTTIType(dgBody::m_kinematicBodyRTTI) ? true : false) & body1->IsCollidable())) ? false : true;
 				if (!(body0->m_equilibrium & body1->m_equilibrium & kinematicBodyEquilibrium)) {
-					const dgInt32 isSofBody0 = body0->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI);
-					const dgInt32 isSofBody1 = body1->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI);
-					if (isSofBody0 || isSofBody1) {
-						m_pendingSoftBodyCollisions[m_pendingSoftBodyPairsCount].m_body0 = body0;
-						m_pendingSoftBodyCollisions[m_pendingSoftBodyPairsCount].m_body1 = body1;
-						m_pendingSoftBodyPairsCount++;
-					} else {
-						contact = new (m_world->m_allocator) dgContact(m_world, material);
-						contact->AppendToActiveList();
-						m_world->AttachConstraint(contact, body0, body1);
-
-						dgAssert(contact);
-						contact->m_contactActive = 0;
-						contact->m_positAcc = dgVector(dgFloat32(10.0f));
-						contact->m_timeOfImpact = dgFloat32(1.0e10f);
+					dgInt32 slot;
+					if (AddPairToHash (body0, body1, slot)) {
+						dgInt32& count = m_pendingContactsCount[threadID];
+						dgArray<dgPendingContact>& pendingContacts = m_pendingContacts[threadID];
+						if (count >= pendingContacts.GetElementsCapacity()) {
+							// more new pairs than ResizePairHash expected, the allocator is not safe to share between threads
+							dgThreadHiveScopeLock lock (m_world, &m_criticalSectionLock, false);
+							pendingContacts.ResizeIfNecessary (count);
+						}
+						dgPendingContact& pending = pendingContacts[count];
+						pending.m_body0 = body0;
+						pending.m_body1 = body1;
+						pending.m_material = material;
+						pending.m_hashSlot = slot;
+						pending.m_isSoftBody = body0->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI) || body1->m_collision->IsType(dgCollision::dgCollisionLumpedMass_RTTI);
+						count ++;
 					}
 				}
 			}
 		}
 	}
-
-	if (contact) {
-		contact->m_broadphaseLru = m_lru;
-	}
 }
 
 
@@ -1348,17 +1621,90 @@ void dgBroadPhase::KinematicBodyActivation (dgContact* const contatJoint) const
 }
 
 
-void dgBroadPhase::CollidingPairsKernel(void* const context, void* const node, dgInt32 threadID)
+void dgBroadPhase::CollidingPairsKernel(void* const context, void* const worldContext, dgInt32 threadID)
 {
 	dTimeTrackerEvent(__FUNCTION__);
 	dgBroadphaseSyncDescriptor* const descriptor = (dgBroadphaseSyncDescriptor*)context;
 	dgWorld* const world = descriptor->m_world;
 	dgBroadPhase* const broadPhase = world->GetBroadPhase();
-	if (broadPhase->m_scanTwoWays) {
-		broadPhase->FindCollidingPairsForwardAndBackward(descriptor, (dgList<dgBroadPhaseNode*>::dgListNode*) node, threadID);
+	broadPhase->FindCollidingPairs(descriptor, threadID);
+}
+
+
+void dgBroadPhase::FindCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID)
+{
+	dgBroadPhaseNode** const updateArray = &m_updateArray[0];
+	const dgInt32 updateCount = m_updateCount;
+	const dgUnsigned32 lru = m_lru;
+	dgInt32* const atomicIndex = &descriptor->m_atomicIndex;
+	dgInt32 missCount = 0;
+	if (m_usePairCache || m_buildPairCache) {
+		// the cache keeps the pairs of leaves whose boxes overlap, only the leaves whose box changed are scanned again.
+		// the kernel only writes to the arrays of its thread, the cache is updated after the barrier
+		const dgFloat32 timestep = descriptor->m_timestep;
+		const dgUnsigned32 dirtyLru = lru + 1;
+		dgArray<dgBroadPhaseNode*>& leaves = m_pairCacheLeaves[threadID];
+		dgInt32& leavesCount = m_pairCacheLeavesCount[threadID];
+		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE); i < updateCount; i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE)) {
+			const dgInt32 count = dgMin (updateCount - i, DG_BROADPHASE_BODY_CHUNK_SIZE);
+			for (dgInt32 j = 0; j < count; j ++) {
+				dgBroadPhaseNode* const node = updateArray[i + j];
+				const bool changed = node->m_pairCacheLru >= lru;
+				missCount += changed ? 1 : 0;
+				if (m_buildPairCache) {
+					FindPairCacheLeaves(node, false, timestep, threadID);
+				} else if (changed) {
+					FindPairCacheLeaves(node, true, timestep, threadID);
+				}
+				if (node->GetDirtyLru() == dirtyLru) {
+					if (node->IsAggregate()) {
+						((dgBroadPhaseAggregate*)node)->SubmitSeltPairs(timestep, threadID);
+					}
+					if (m_usePairCache) {
+						leaves[leavesCount] = node;
+						leavesCount ++;
+					}
+				}
+			}
+		}
+
+		if (m_usePairCache) {
+			// pairs of two unchanged leaves are still valid, they are submitted when one of the leaves is moving
+			const dgInt32 pairsCount = m_pairCacheCount;
+			dgInt32* const pairsIndex = &descriptor->m_pairCacheAtomicIndex;
+			for (dgInt32 i = dgAtomicExchangeAndAdd(pairsIndex, DG_BROADPHASE_PAIR_CACHE_CHUNK_SIZE); i < pairsCount; i = dgAtomicExchangeAndAdd(pairsIndex, DG_BROADPHASE_PAIR_CACHE_CHUNK_SIZE)) {
+				const dgInt32 count = dgMin (pairsCount - i, DG_BROADPHASE_PAIR_CACHE_CHUNK_SIZE);
+				for (dgInt32 j = 0; j < count; j ++) {
+					dgPairCacheEntry& pair = m_pairCache[i + j];
+					if ((pair.m_leaf0->m_pairCacheLru >= lru) || (pair.m_leaf1->m_pairCacheLru >= lru)) {
+						// the scan of the changed leaf found the pair again if it is still valid
+						pair.m_leaf0 = NULL;
+					} else if ((pair.m_leaf0->GetDirtyLru() == dirtyLru) || (pair.m_leaf1->GetDirtyLru() == dirtyLru)) {
+						SubmitPairCachePair(pair.m_leaf0, pair.m_leaf1, timestep, threadID);
+					}
+				}
+			}
+		}
+	} else if (m_scanTwoWays) {
+		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE); i < updateCount; i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE)) {
+			const dgInt32 count = dgMin (updateCount - i, DG_BROADPHASE_BODY_CHUNK_SIZE);
+			for (dgInt32 j = 0; j < count; j ++) {
+				dgBroadPhaseNode* const node = updateArray[i + j];
+				missCount += (node->m_pairCacheLru >= lru) ? 1 : 0;
+				FindCollidingPairsForwardAndBackward(descriptor, node, threadID);
+			}
+		}
 	} else {
-		broadPhase->FindCollidingPairsForward(descriptor, (dgList<dgBroadPhaseNode*>::dgListNode*) node, threadID);
+		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE); i < updateCount; i = dgAtomicExchangeAndAdd(atomicIndex, DG_BROADPHASE_BODY_CHUNK_SIZE)) {
+			const dgInt32 count = dgMin (updateCount - i, DG_BROADPHASE_BODY_CHUNK_SIZE);
+			for (dgInt32 j = 0; j < count; j ++) {
+				dgBroadPhaseNode* const node = updateArray[i + j];
+				missCount += (node->m_pairCacheLru >= lru) ? 1 : 0;
+				FindCollidingPairsForward(descriptor, node, threadID);
+			}
+		}
 	}
+	dgAtomicExchangeAndAdd(&m_pairCacheMissCount, missCount);
 }
 
 
@@ -1376,38 +1722,62 @@ void dgBroadPhase::ScanForContactJoints(dgBroadphaseSyncDescriptor& syncPoints)
 {
 	dTimeTrackerEvent(__FUNCTION__);
 	dgInt32 threadsCount = m_world->GetThreadCount();
-	dgList<dgBroadPhaseNode*>::dgListNode* node = m_updateList.GetFirst();
+	ResizePairHash();
+	syncPoints.m_atomicIndex = 0;
+	syncPoints.m_pairCacheAtomicIndex = 0;
 	for (dgInt32 i = 0; i < threadsCount; i++) {
-		m_world->QueueJob(CollidingPairsKernel, &syncPoints, node);
-		node = node ? node->GetNext() : NULL;
+		m_world->QueueJob(CollidingPairsKernel, &syncPoints, m_world);
 	}
 	m_world->SynchronizationBarrier();
+	CreatePendingContacts();
 
-	const dgUnsigned32 lru = m_lru - DG_CONTACT_DELAY_FRAMES;
-	dgActiveContacts* const contactList = m_world;
-	for (dgActiveContacts::dgListNode* contactNode = contactList->GetFirst(); contactNode;) {
-		dgContact* const contact = contactNode->GetInfo();
-		contactNode = contactNode->GetNext();
-		const dgBody* const body0 = contact->GetBody0();
-		const dgBody* const body1 = contact->GetBody1();
-		const dgInt32 equilbriun0 = body0->m_equilibrium;
-		const dgInt32 equilbriun1 = body1->m_equilibrium;
-		if (equilbriun0 & equilbriun1) {
-			contact->m_broadphaseLru = lru;
+	if (m_usePairCache || m_buildPairCache) {
+		UpdatePairCache();
+	}
+
+	dgInt32 destroyedCount = 0;
+	if (m_usePairCache) {
+		// the contacts of the leaves at rest are not expired by the contact list scan, so only the contacts of the moving leaves are visited
+		for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+			const dgInt32 count = m_pairCacheLeavesCount[i];
+			for (dgInt32 j = 0; j < count; j ++) {
+				ExpirePairCacheContacts (m_pairCacheLeaves[i][j], destroyedCount);
+			}
+			m_pairCacheLeavesCount[i] = 0;
 		}
-		if (contact->m_broadphaseLru < lru) {
-			m_world->DestroyConstraint(contact);
+	} else {
+		const dgUnsigned32 lru = m_lru - DG_CONTACT_DELAY_FRAMES;
+		dgActiveContacts* const contactList = m_world;
+		for (dgActiveContacts::dgListNode* contactNode = contactList->GetFirst(); contactNode;) {
+			dgContact* const contact = contactNode->GetInfo();
+			contactNode = contactNode->GetNext();
+			const dgBody* const body0 = contact->GetBody0();
+			const dgBody* const body1 = contact->GetBody1();
+			const dgInt32 equilbriun0 = body0->m_equilibrium;
+			const dgInt32 equilbriun1 = body1->m_equilibrium;
+			if (equilbriun0 & equilbriun1) {
+				contact->m_broadphaseLru = lru;
+			}
+			if (contact->m_broadphaseLru < lru) {
+				m_world->DestroyConstraint(contact);
+				destroyedCount ++;
+			}
 		}
 	}
 
+	dgWorldStats* const stats = m_world->GetStatsCollector();
+	if (stats) {
+		stats->m_contactsDestroyed += destroyedCount;
+	}
+
 
 #if 0
 static dgInt32 xxx;
 dgInt32 xxx0 = 0;
 dgInt32 xxx1 = 0;
-	for (dgList<dgBroadPhaseNode*>::dgListNode* nodePtr = m_updateList.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) {
+	for (dgInt32 i = 0; i < m_updateCount; i ++) {
 xxx0 ++;
-		dgBroadPhaseNode* const node = nodePtr->GetInfo();
+		dgBroadPhaseNode* const node = m_updateArray[i];
 		dgAssert (node->IsLeafNode());
 		dgBroadPhaseBodyNode* const bodyNode = (dgBroadPhaseBodyNode*)node;
 xxx1 += bodyNode->m_nodeIsDirtyLru == (m_lru + 1) ? 1 : 0;
@@ -1460,6 +1830,8 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 	dgActiveContacts::dgListNode* node = nodePtr;
 	const dgFloat32 timestep = descriptor->m_timestep;
 	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
+	dgInt32 pairsTested = 0;
+	dgPrimitivePairBatch batch (timestep);
 	while (node) {
 		dgContact* const contact = node->GetInfo();
 
@@ -1492,8 +1864,8 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 					contact->m_separationDistance = distance;
 				}
 				if (distance < DG_NARROW_PHASE_DIST) {
-					AddPair(contact, timestep, threadID);
-					if (contact->m_maxDOF) {
+					pairsTested ++;
+					if (!AddPair(contact, timestep, threadID, &batch) && contact->m_maxDOF) {
 						contact->m_timeOfImpact = dgFloat32(1.0e10f);
 					}
 				}
@@ -1504,6 +1876,17 @@ void dgBroadPhase::UpdateRigidBodyContacts(dgBroadphaseSyncDescriptor* const des
 			node = node ? node->GetNext() : NULL;
 		}
 	}
+
+	for (dgInt32 i = 0; i < m_primitiveBatchKinds; i ++) {
+		if (batch.m_count[i]) {
+			CalculatePairContactsBatch (&batch, i, threadID);
+		}
+	}
+
+	dgWorldStats* const stats = descriptor->m_world->GetStatsCollector();
+	if (stats) {
+		stats->AddCount (&stats->m_pairsTested, pairsTested);
+	}
 }
 
 
@@ -1518,15 +1901,15 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
 	m_recursiveChunks = true;
 	dgInt32 threadsCount = m_world->GetThreadCount();
 
-	const dgBodyMasterList* const masterList = m_world;
 	dgBroadphaseSyncDescriptor syncPoints(timestep, m_world);
+	dgWorldStats::dgPhaseTimer timer (m_world->GetStatsCollector());
 
-	dgBodyMasterList::dgListNode* node = masterList->GetLast();
+	syncPoints.m_atomicIndex = 0;
 	for (dgInt32 i = 0; i < threadsCount; i++) {
-		m_world->QueueJob(ForceAndToqueKernel, &syncPoints, node);
-		node = node ? node->GetPrev() : NULL;
+		m_world->QueueJob(ForceAndToqueKernel, &syncPoints, m_world);
 	}
 	m_world->SynchronizationBarrier();
+	timer.Lap (dgWorldStats::m_forceCallbacks);
 
 	// update pre-listeners after the force and true are applied
 	if (m_world->m_preListener.GetCount()) {
@@ -1536,13 +1919,14 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
 			listener.m_onListenerUpdate(m_world, listener.m_userData, timestep);
 		}
 	}
+	timer.Lap (dgWorldStats::m_preListeners);
 
-	node = masterList->GetLast();
+	syncPoints.m_atomicIndex = 0;
 	for (dgInt32 i = 0; i < threadsCount; i++) {
-		m_world->QueueJob(SleepingStateKernel, &syncPoints, node);
-		node = node ? node->GetPrev() : NULL;
+		m_world->QueueJob(SleepingStateKernel, &syncPoints, m_world);
 	}
 	m_world->SynchronizationBarrier();
+	timer.Lap (dgWorldStats::m_sleepingState);
 
 
 #if 0
@@ -1593,8 +1977,16 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
 	m_world->SynchronizationBarrier();
 	UpdateFitness();
 
-	m_scanTwoWays = (lastDirtyCount * 100) < (40 * m_updateList.GetCount());
+	m_scanTwoWays = (lastDirtyCount * 100) < (40 * m_updateCount);
+	// the pair cache finds the pairs of the two way scan, it is rebuilt after leaves are added or removed,
+	// and it is not used when most leaves changed their box last step
+	const bool pairCacheHit = m_scanTwoWays && ((m_pairCacheMissCount * 100) < (40 * m_updateCount));
+	m_usePairCache = pairCacheHit && m_pairCacheIsValid;
+	m_buildPairCache = pairCacheHit && !m_pairCacheIsValid;
+	m_pairCacheIsValid = pairCacheHit;
+	m_pairCacheMissCount = 0;
 	ScanForContactJoints (syncPoints);
+	timer.Lap (dgWorldStats::m_broadPhase);
 
 	dgActiveContacts* const contactList = m_world;
 	dgActiveContacts::dgListNode* contactListNode = contactList->GetFirst();
@@ -1610,6 +2002,7 @@ void dgBroadPhase::UpdateContacts(dgFloat32 timestep)
 		}
 		m_world->SynchronizationBarrier();
 	}
+	timer.Lap (dgWorldStats::m_narrowPhase);
 
 
 	m_recursiveChunks = false;
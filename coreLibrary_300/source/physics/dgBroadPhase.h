@@ -32,11 +32,17 @@ class dgContact;
 class dgCollision;
 class dgDynamicBody;
 class dgCollisionInstance;
+class dgContactMaterial;
 class dgBroadPhaseAggregate;
 
 
 #define DG_CACHE_DIST_TOL				dgFloat32 (1.0e-3f)
 #define DG_BROADPHASE_MAX_STACK_DEPTH	256
+#define DG_CONVEX_CAST_POOLSIZE			32
+#define DG_BROADPHASE_BODY_CHUNK_SIZE	16
+#define DG_BROADPHASE_PAIR_CACHE_CHUNK_SIZE	64
+#define DG_BROADPHASE_MIN_PAIR_HASH_SIZE	1024
+#define DG_BROADPHASE_REBUILD_RATIO		dgFloat32 (1.5f)
 
 class dgConvexCastReturnInfo
 {
@@ -50,6 +56,16 @@ class dgConvexCastReturnInfo
 	dgFloat32 m_penetration;                // contact penetration at collision point
 };
 
+class dgRayCastReturnInfo
+{
+	public:
+	dgFloat32 m_point[4];					// ray intersection point in global space
+	dgFloat32 m_normal[4];					// surface normal at the intersection point in global space
+	dgInt64  m_contaID;	                // collision ID at the intersection point
+	const dgBody* m_hitBody;				// body hit by the ray, NULL if the ray did not hit anything
+	dgFloat32 m_intersectParam;             // intersection parameter along the ray, one if the ray did not hit anything
+};
+
 
 DG_MSC_VECTOR_ALIGMENT
 class dgBroadPhaseNode
@@ -62,6 +78,8 @@ class dgBroadPhaseNode
 		,m_parent(parent)
 		,m_surfaceArea(dgFloat32(1.0e20f))
 		,m_nodeIsDirtyLru(0)
+		,m_pairCacheLru(0)
+		,m_linearIndex(-1)
 	{
 	}
 
@@ -133,6 +151,8 @@ class dgBroadPhaseNode
 	dgBroadPhaseNode* m_parent;
 	dgFloat32 m_surfaceArea;
 	dgUnsigned32 m_nodeIsDirtyLru;
+	dgUnsigned32 m_pairCacheLru;
+	dgInt32 m_linearIndex;
 
 	static dgVector m_broadPhaseScale;
 	static dgVector m_broadInvPhaseScale;
@@ -145,7 +165,7 @@ class dgBroadPhaseBodyNode: public dgBroadPhaseNode
 	dgBroadPhaseBodyNode(dgBody* const body)
 		:dgBroadPhaseNode(NULL)
 		,m_body(body)
-		,m_updateNode(NULL)
+		,m_updateIndex(-1)
 	{
 		SetAABB(body->m_minAABB, body->m_maxAABB);
 		m_body->SetBroadPhase(this);
@@ -162,7 +182,7 @@ class dgBroadPhaseBodyNode: public dgBroadPhaseNode
 	}
 
 	dgBody* m_body;
-	dgList<dgBroadPhaseNode*>::dgListNode* m_updateNode;
+	dgInt32 m_updateIndex;
 };
 
 class dgBroadPhaseTreeNode: public dgBroadPhaseNode
@@ -233,7 +253,6 @@ class dgBroadPhaseTreeNode: public dgBroadPhaseNode
 class dgBroadPhase
 {
 	protected:
-	class dgSpliteInfo;
 	class dgBroadphaseSyncDescriptor
 	{
 		public:
@@ -242,6 +261,8 @@ class dgBroadPhase
 			,m_newBodiesNodes(NULL)
 			,m_timestep(timestep)
 			,m_pairsAtomicCounter(0)
+			,m_atomicIndex(0)
+			,m_pairCacheAtomicIndex(0)
 		{
 		}
 
@@ -249,13 +270,21 @@ class dgBroadPhase
 		dgList<dgBody*>::dgListNode* m_newBodiesNodes;
 		dgFloat32 m_timestep;
 		dgInt32 m_pairsAtomicCounter;
+		dgInt32 m_atomicIndex;
+		dgInt32 m_pairCacheAtomicIndex;
 	};
 	
+	class dgRayCastBatchDescriptor;
+	class dgPrimitivePairBatch;
+	class dgTreeBuildDescriptor;
+
 	class dgFitnessList: public dgList <dgBroadPhaseTreeNode*>
 	{
 		public:
 		dgFitnessList(dgMemoryAllocator* const allocator)
 			:dgList <dgBroadPhaseTreeNode*>(allocator)
+			,m_buildEntropy(dgFloat32(0.0f))
+			,m_buildCount(0)
 		{
 		}
 
@@ -268,6 +297,10 @@ class dgBroadPhase
 			}
 			return cost;
 		}
+
+		// the entropy per node right after the last full build, the reference to measure how much the tree degraded
+		dgFloat64 m_buildEntropy;
+		dgInt32 m_buildCount;
 	};
 
 	public:
@@ -310,6 +343,8 @@ class dgBroadPhase
 	
 	virtual void Add(dgBody* const body) = 0;
 	virtual void Remove(dgBody* const body) = 0;
+	virtual void AddBodies(dgBody** const bodies, dgInt32 count);
+	virtual void RemoveBodies(dgBody** const bodies, dgInt32 count);
 
 	virtual void ResetEntropy() = 0;
 	virtual void UpdateFitness() = 0;
@@ -322,8 +357,10 @@ class dgBroadPhase
 	virtual void RayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const = 0;
 	virtual dgInt32 Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const = 0;
 	virtual dgInt32 ConvexCast (dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const = 0;
-	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID) = 0;
-	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID) = 0;
+	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID) = 0;
+	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID) = 0;
+
+	dgInt32 RayCastBatch (const dgFloat32* const p0, const dgFloat32* const p1, dgInt32 strideInBytes, dgInt32 count, dgRayCastReturnInfo* const info, bool anyHit, OnRayPrecastAction prefilter, void* const userData) const;
 
 	void ScanForContactJoints(dgBroadphaseSyncDescriptor& syncPoints);
 
@@ -337,12 +374,22 @@ class dgBroadPhase
 	void CollisionChange (dgBody* const body, dgCollisionInstance* const collisionSrc);
 
 	void MoveNodes (dgBroadPhase* const dest);
+	void RebuildTree ();
 
 	protected:
 	virtual void LinkAggregate (dgBroadPhaseAggregate* const aggregate) = 0; 
 	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate) = 0; 
+	virtual void UpdateLeafBox (dgBroadPhaseNode* const leaf) {}
+
+	bool DoNeedUpdate(dgBody* const body) const;
+	void AddToUpdateArray (dgBroadPhaseNode* const node);
+	void RemoveFromUpdateArray (dgBroadPhaseNode* const node);
+	dgInt32& GetUpdateIndex (dgBroadPhaseNode* const node) const;
+	void InvalidatePairCache()
+	{
+		m_pairCacheIsValid = false;
+	}
 
-	bool DoNeedUpdate(dgBodyMasterList::dgListNode* const node) const;
 	dgFloat64 CalculateEntropy (dgFitnessList& fitness, dgBroadPhaseNode** const root);
 	dgBroadPhaseTreeNode* InsertNode (dgBroadPhaseNode* const root, dgBroadPhaseNode* const node);
 
@@ -352,11 +399,13 @@ class dgBroadPhase
 	void ImproveFitness(dgFitnessList& fitness, dgFloat64& oldEntropy, dgBroadPhaseNode** const root);
 
 	void CalculatePairContacts (dgPair* const pair, dgInt32 threadID);
+	void ProcessPairContacts (dgPair* const pair, dgInt32 threadID);
+	void CalculatePairContactsBatch (dgPrimitivePairBatch* const batch, dgInt32 kind, dgInt32 threadID);
 	bool ValidateContactCache(dgContact* const contact, dgFloat32 timestep) const;
-    void AddPair (dgContact* const contact, dgFloat32 timestep, dgInt32 threadIndex);
+	bool AddPair (dgContact* const contact, dgFloat32 timestep, dgInt32 threadIndex, dgPrimitivePairBatch* const batch);
 	void AddPair (dgBody* const body0, dgBody* const body1, dgFloat32 timestep, dgInt32 threadID);	
 
-	void ForEachBodyInAABB (const dgBroadPhaseNode** stackPool, dgInt32 stack, const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const;
+	bool ForEachBodyInAABB (const dgBroadPhaseNode** stackPool, dgInt32 stack, const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const;
 	void RayCast (const dgBroadPhaseNode** stackPool, dgFloat32* const distance, dgInt32 stack, const dgVector& l0, const dgVector& l1, dgFastRayTest& ray, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
 
 	dgInt32 ConvexCast (const dgBroadPhaseNode** stackPool, dgFloat32* const distance, dgInt32 stack, const dgVector& velocA, const dgVector& velocB, dgFastRayTest& ray,  
@@ -365,13 +414,18 @@ class dgBroadPhase
 	dgInt32 Collide(const dgBroadPhaseNode** stackPool, dgInt32* const overlap, dgInt32 stack, const dgVector& p0, const dgVector& p1, 
 		            dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
 
-	void SleepingState (dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID);
-	void ApplyForceAndtorque (dgBroadphaseSyncDescriptor* const descriptor, dgBodyMasterList::dgListNode* node, dgInt32 threadID);
+	void RayCastPacket (const dgRayCastBatchDescriptor* const descriptor, const dgInt32* const rayIndex, dgInt32 count) const;
+	void RayCastPacketBody (const dgRayCastBatchDescriptor* const descriptor, dgBody* const body, const dgFastRayTest* const* const rays, const dgInt32* const rayIndex, dgVector& maxParam, dgInt32 mask) const;
+
+	void SleepingState (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
+	void ApplyForceAndtorque (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
+	void FindCollidingPairs (dgBroadphaseSyncDescriptor* const descriptor, dgInt32 threadID);
 	
 	void UpdateAggregateEntropy (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseAggregate*>::dgListNode* node, dgInt32 threadID);
 
-	dgBroadPhaseNode* BuildTopDown(dgBroadPhaseNode** const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgFitnessList::dgListNode** const nextNode);
-	dgBroadPhaseNode* BuildTopDownBig(dgBroadPhaseNode** const leafArray, dgInt32 firstBox, dgInt32 lastBox, dgFitnessList::dgListNode** const nextNode);
+	void BuildTreeSAH (dgFitnessList& fitness, dgBroadPhaseNode** const root, dgBroadPhaseNode** const newLeaves = NULL, dgInt32 newLeavesCount = 0);
+	dgBroadPhaseNode* BuildSubTreeSAH (dgFitnessList& fitness, dgBroadPhaseNode** const leaves, dgInt32 count);
+	void AddLeaves (dgFitnessList& fitness, dgFloat64& entropy, dgBroadPhaseNode** const root, dgBroadPhaseNode* const parent, dgBroadPhaseNode** const leaves, dgInt32 count);
 
 	void KinematicBodyActivation (dgContact* const contatJoint) const;
 	
@@ -387,7 +441,7 @@ class dgBroadPhase
 	static void AddGeneratedBodiesContactsKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void UpdateRigidBodyContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
 	static void UpdateSoftBodyContactKernel(void* const descriptor, void* const worldContext, dgInt32 threadID);
-	static dgInt32 CompareNodes(const dgBroadPhaseNode* const nodeA, const dgBroadPhaseNode* const nodeB, void* const notUsed);
+	static void RayCastBatchKernel(void* const descriptor, dgInt32 start, dgInt32 end, dgInt32 threadID);
 
 	class dgPendingCollisionSofBodies
 	{
@@ -396,19 +450,63 @@ class dgBroadPhase
 		dgBody* m_body1;
 	};
 
+	// new pairs found by a thread, the contact joints are created after the pairs scan barrier
+	class dgPendingContact
+	{
+		public:
+		dgBody* m_body0;
+		dgBody* m_body1;
+		const dgContactMaterial* m_material;
+		dgInt32 m_hashSlot;
+		dgInt32 m_isSoftBody;
+	};
+
+	// two top level leaves whose boxes overlap, the entry is valid until the box of one of them changes
+	class dgPairCacheEntry
+	{
+		public:
+		dgBroadPhaseNode* m_leaf0;
+		dgBroadPhaseNode* m_leaf1;
+	};
+
+	bool AddPairToHash (const dgBody* const body0, const dgBody* const body1, dgInt32& slot);
+	void ResizePairHash ();
+	void CreatePendingContacts ();
+	void FindPairCacheLeaves (dgBroadPhaseNode* const leaf, bool twoWays, dgFloat32 timestep, dgInt32 threadID);
+	void SubmitPairCacheLeaves (dgBroadPhaseNode* const leaf, dgBroadPhaseNode* const node, bool twoWays, dgFloat32 timestep, dgInt32 threadID);
+	void SubmitPairCachePair (dgBroadPhaseNode* const leaf0, dgBroadPhaseNode* const leaf1, dgFloat32 timestep, dgInt32 threadID);
+	void UpdatePairCache ();
+	void ExpirePairCacheContacts (dgBroadPhaseNode* const leaf, dgInt32& destroyedCount);
+
 	dgWorld* m_world;
 	dgBroadPhaseNode* m_rootNode;
 	dgList<dgBody*> m_generatedBodies;
-	dgList<dgBroadPhaseNode*> m_updateList;
+	dgArray<dgBroadPhaseNode*> m_updateArray;
 	dgList<dgBroadPhaseAggregate*> m_aggregateList;
 	dgUnsigned32 m_lru;
-	dgThread::dgCriticalSection m_contacJointLock;
+	// counts tree rotations and rebuilds, the aggregate trees are rotated in parallel so it is bumped atomically
+	dgInt32 m_treeRevision;
 	dgThread::dgCriticalSection m_criticalSectionLock;
 	dgArray<dgPendingCollisionSofBodies> m_pendingSoftBodyCollisions;
+	dgArray<dgInt64> m_pairHash;
+	dgArray<dgPendingContact> m_pendingContacts[DG_MAX_THREADS_HIVE_COUNT];
+	dgInt32 m_pendingContactsCount[DG_MAX_THREADS_HIVE_COUNT];
+	dgArray<dgPairCacheEntry> m_pairCache;
+	dgArray<dgPairCacheEntry> m_pairCacheNewPairs[DG_MAX_THREADS_HIVE_COUNT];
+	dgInt32 m_pairCacheNewPairsCount[DG_MAX_THREADS_HIVE_COUNT];
+	dgArray<dgBroadPhaseNode*> m_pairCacheLeaves[DG_MAX_THREADS_HIVE_COUNT];
+	dgInt32 m_pairCacheLeavesCount[DG_MAX_THREADS_HIVE_COUNT];
+	dgInt32 m_pairCacheCount;
+	dgInt32 m_pairCacheMissCount;
+	dgInt32 m_pairHashSize;
 	dgInt32 m_pendingSoftBodyPairsCount;
 	dgInt32 m_dirtyNodesCount;
+	dgInt32 m_updateCount;
 	bool m_scanTwoWays;
 	bool m_recursiveChunks;
+	bool m_pairCacheIsValid;
+	bool m_usePairCache;
+	bool m_buildPairCache;
 
 	//DG_INLINE dgVector ReduceLine(dgVector* const simplex, dgInt32& indexOut) const;
 	//DG_INLINE dgVector ReduceTriangle(dgVector* const simplex, dgInt32& indexOut) const;
@@ -29,7 +29,7 @@ dgBroadPhaseAggregate::dgBroadPhaseAggregate(dgBroadPhase* const broadPhase)
 	:dgBroadPhaseNode(NULL)
 	,m_root(NULL)
 	,m_broadPhase(broadPhase)
-	,m_updateNode(NULL)
+	,m_updateIndex(-1)
 	,m_myAggregateNode(NULL)
 	,m_fitnessList(broadPhase->m_world->GetAllocator())
 	,m_treeEntropy(dgFloat32(0.0f))
@@ -106,6 +106,10 @@ void dgBroadPhaseAggregate::AddBody(dgBody* const body)
 		ptr->m_parent->m_maxBox = maxBox;
 		ptr->m_parent->m_surfaceArea = area;
 	}
+	// broadphases that track the top level leaves need to know the aggregate box has grown
+	m_broadPhase->UpdateLeafBox(newNode);
+	// the pairs of the grown aggregate box are found by the next scan
+	m_pairCacheLru = m_broadPhase->m_lru + 1;
 }
 
 void dgBroadPhaseAggregate::RemoveBody(dgBody* const body)
@@ -62,7 +62,7 @@ class dgBroadPhaseAggregate: public dgBroadPhaseNode
 
 	dgBroadPhaseNode* m_root;
 	dgBroadPhase* m_broadPhase;
-	dgList<dgBroadPhaseNode*>::dgListNode* m_updateNode;
+	dgInt32 m_updateIndex;
 	dgList<dgBroadPhaseAggregate*>::dgListNode* m_myAggregateNode;
 	dgList<dgBroadPhaseTreeNode*> m_fitnessList;
 	dgFloat64 m_treeEntropy;
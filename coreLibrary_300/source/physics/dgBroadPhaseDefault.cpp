@@ -160,10 +160,22 @@ void dgBroadPhaseDefault::Add(dgBody* const body)
 	// create a new leaf node;
 	dgAssert (!body->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI));
 	dgBroadPhaseBodyNode* const newNode = new (m_world->GetAllocator()) dgBroadPhaseBodyNode(body);
-	newNode->m_updateNode = m_updateList.Append(newNode);
+	AddToUpdateArray(newNode);
 	AddNode(newNode);
 }
 
+void dgBroadPhaseDefault::AddBodies(dgBody** const bodies, dgInt32 count)
+{
+	dgStack<dgBroadPhaseNode*> leaves(count);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgAssert (!bodies[i]->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI));
+		dgBroadPhaseBodyNode* const newNode = new (m_world->GetAllocator()) dgBroadPhaseBodyNode(bodies[i]);
+		AddToUpdateArray(newNode);
+		leaves[i] = newNode;
+	}
+	AddLeaves(m_fitness, m_treeEntropy, &m_rootNode, NULL, &leaves[0], count);
+}
+
 dgBroadPhaseAggregate* dgBroadPhaseDefault::CreateAggregate()
 {
 	dgBroadPhaseAggregate* const aggregate = new (m_world->GetAllocator()) dgBroadPhaseAggregate(m_world->GetBroadPhase());
@@ -175,7 +187,7 @@ void dgBroadPhaseDefault::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
 {
 	AddNode(aggregate);
 	aggregate->m_broadPhase = this;
-	aggregate->m_updateNode = m_updateList.Append(aggregate);
+	AddToUpdateArray(aggregate);
 	aggregate->m_myAggregateNode = m_aggregateList.Append(aggregate);
 }
 
@@ -322,9 +334,7 @@ void dgBroadPhaseDefault::Remove(dgBody* const body)
 {
 	if (body->GetBroadPhase()) {
 		dgBroadPhaseBodyNode* const node = (dgBroadPhaseBodyNode*)body->GetBroadPhase();
-		if (node->m_updateNode) {
-			m_updateList.Remove(node->m_updateNode);
-		}
+		RemoveFromUpdateArray(node);
 		RemoveNode(node);
 	}
 }
@@ -332,75 +342,58 @@ void dgBroadPhaseDefault::Remove(dgBody* const body)
 
 void dgBroadPhaseDefault::DestroyAggregate(dgBroadPhaseAggregate* const aggregate)
 {
-	m_updateList.Remove(aggregate->m_updateNode);
+	RemoveFromUpdateArray(aggregate);
 	m_aggregateList.Remove(aggregate->m_myAggregateNode);
 	RemoveNode(aggregate);
 }
 
-void dgBroadPhaseDefault::FindCollidingPairsForward(dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const nodePtr, dgInt32 threadID)
+void dgBroadPhaseDefault::FindCollidingPairsForward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
 {
 	const dgFloat32 timestep = descriptor->m_timestep;
 
-	dgList<dgBroadPhaseNode*>::dgListNode* node = nodePtr;
-	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
-	while (node) {
-		dgBroadPhaseNode* const broadPhaseNode = node->GetInfo();
-		dgAssert(broadPhaseNode->IsLeafNode());
-		dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
-
-		if (broadPhaseNode->IsAggregate()) {
-			((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
-		}
+	dgAssert(broadPhaseNode->IsLeafNode());
+	dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
 
-		for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
-			dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
-			dgAssert(!parent->IsLeafNode());
-			dgBroadPhaseNode* const sibling = parent->m_right;
-			if (sibling != ptr) {
-				SubmitPairs(broadPhaseNode, sibling, timestep, 0, threadID);
-			}
-		}
+	if (broadPhaseNode->IsAggregate()) {
+		((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
+	}
 
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			node = node ? node->GetNext() : NULL;
+	for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
+		dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
+		dgAssert(!parent->IsLeafNode());
+		dgBroadPhaseNode* const sibling = parent->m_right;
+		if (sibling != ptr) {
+			SubmitPairs(broadPhaseNode, sibling, timestep, 0, threadID);
 		}
 	}
 }
 
 
-void dgBroadPhaseDefault::FindCollidingPairsForwardAndBackward(dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const nodePtr, dgInt32 threadID)
+void dgBroadPhaseDefault::FindCollidingPairsForwardAndBackward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
 {
 	const dgFloat32 timestep = descriptor->m_timestep;
 
-	dgList<dgBroadPhaseNode*>::dgListNode* node = nodePtr;
 	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
 	const dgUnsigned32 lru = m_lru + 1;
-	while (node) {
-		dgBroadPhaseNode* const broadPhaseNode = node->GetInfo();
-		dgAssert(broadPhaseNode->IsLeafNode());
-		dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
-
-		if (lru == broadPhaseNode->GetDirtyLru()) {
-			if (broadPhaseNode->IsAggregate()) {
-				((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
-			}
+	dgAssert(broadPhaseNode->IsLeafNode());
+	dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
 
-			for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
-				dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
-				dgAssert(!parent->IsLeafNode());
-				dgBroadPhaseNode* const rightSibling = parent->m_right;
-				if (rightSibling && (rightSibling != ptr)) {
-					SubmitPairs(broadPhaseNode, rightSibling, timestep, threadCount, threadID);
-				}
-				dgBroadPhaseNode* const leftSibling = parent->m_left;
-				if (leftSibling != ptr) {
-					SubmitPairs(broadPhaseNode, leftSibling, timestep, threadCount, threadID);
-				}
-			}
+	if (lru == broadPhaseNode->GetDirtyLru()) {
+		if (broadPhaseNode->IsAggregate()) {
+			((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
 		}
 
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			node = node ? node->GetNext() : NULL;
+		for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
+			dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
+			dgAssert(!parent->IsLeafNode());
+			dgBroadPhaseNode* const rightSibling = parent->m_right;
+			if (rightSibling && (rightSibling != ptr)) {
+				SubmitPairs(broadPhaseNode, rightSibling, timestep, threadCount, threadID);
+			}
+			dgBroadPhaseNode* const leftSibling = parent->m_left;
+			if (leftSibling != ptr) {
+				SubmitPairs(broadPhaseNode, leftSibling, timestep, threadCount, threadID);
+			}
 		}
 	}
 }
@@ -38,6 +38,7 @@ class dgBroadPhaseDefault: public dgBroadPhase
 	virtual dgInt32 GetType() const;
 	virtual void Add(dgBody* const body);
 	virtual void Remove(dgBody* const body);
+	virtual void AddBodies(dgBody** const bodies, dgInt32 count);
 	virtual void UpdateFitness();
 	virtual void InvalidateCache();
 	virtual dgBroadPhaseAggregate* CreateAggregate();
@@ -46,8 +47,8 @@ class dgBroadPhaseDefault: public dgBroadPhase
 	virtual void LinkAggregate (dgBroadPhaseAggregate* const aggregate); 
 	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate); 
 	virtual void CheckStaticDynamic(dgBody* const body, dgFloat32 mass) {}
-	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID);
-	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
 
 	void RayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
 	dgInt32 Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
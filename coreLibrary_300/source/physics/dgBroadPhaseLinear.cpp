@@ -0,0 +1,775 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgCollisionInstance.h"
+#include "dgBroadPhaseLinear.h"
+#include "dgBroadPhaseAggregate.h"
+
+
+DG_INLINE static dgInt32 dgLinearPushNode (dgInt32* const stackPool, dgFloat32* const distance, dgInt32 stack, dgInt32 node, dgFloat32 dist)
+{
+	dgInt32 j = stack;
+	for (; j && (dist > distance[j - 1]); j--) {
+		stackPool[j] = stackPool[j - 1];
+		distance[j] = distance[j - 1];
+	}
+	stackPool[j] = node;
+	distance[j] = dist;
+	dgAssert((stack + 1) < DG_BROADPHASE_MAX_STACK_DEPTH);
+	return stack + 1;
+}
+
+
+dgBroadPhaseLinear::dgBroadPhaseLinear(dgWorld* const world)
+	:dgBroadPhaseDefault(world)
+	,m_linearNodes(world->GetAllocator(), 64)
+	,m_quantizeOrigin(dgFloat32(0.0f))
+	,m_quantizeScale(dgBroadPhaseNode::m_broadPhaseScale)
+	,m_quantizeInvScale(dgBroadPhaseNode::m_broadInvPhaseScale)
+	,m_linearNodesCount(0)
+	,m_linearRevision(0)
+	,m_linearDirty(true)
+{
+	dgAssert(sizeof (dgLinearNode) <= 32);
+}
+
+dgBroadPhaseLinear::~dgBroadPhaseLinear()
+{
+}
+
+dgInt32 dgBroadPhaseLinear::GetType() const
+{
+	return dgWorld::m_linearBroadphase;
+}
+
+void dgBroadPhaseLinear::Add(dgBody* const body)
+{
+	dgBroadPhaseDefault::Add(body);
+	m_linearDirty = true;
+}
+
+void dgBroadPhaseLinear::Remove(dgBody* const body)
+{
+	dgBroadPhaseDefault::Remove(body);
+	m_linearDirty = true;
+}
+
+void dgBroadPhaseLinear::AddBodies(dgBody** const bodies, dgInt32 count)
+{
+	dgBroadPhaseDefault::AddBodies(bodies, count);
+	m_linearDirty = true;
+}
+
+void dgBroadPhaseLinear::DestroyAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgBroadPhaseDefault::DestroyAggregate(aggregate);
+	m_linearDirty = true;
+}
+
+void dgBroadPhaseLinear::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgBroadPhaseDefault::LinkAggregate(aggregate);
+	m_linearDirty = true;
+}
+
+void dgBroadPhaseLinear::UnlinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgBroadPhaseDefault::UnlinkAggregate(aggregate);
+	m_linearDirty = true;
+}
+
+void dgBroadPhaseLinear::UpdateFitness()
+{
+	ImproveFitness(m_fitness, m_treeEntropy, &m_rootNode);
+	// the mirror is still a valid tree after the rotations, so it is only rebuilt
+	// once the rotations have changed a good part of the pointer tree
+	const dgUnsigned32 rotations = m_treeRevision - m_linearRevision;
+	if (!IsValid() || (rotations > dgUnsigned32(m_linearNodesCount >> 3))) {
+		BuildLinearTree();
+	}
+}
+
+void dgBroadPhaseLinear::InvalidateCache()
+{
+	dgBroadPhaseDefault::InvalidateCache();
+	BuildLinearTree();
+}
+
+void dgBroadPhaseLinear::QuantizeBox(const dgVector& minBox, const dgVector& maxBox, dgInt32* const minQuantized, dgInt32* const maxQuantized) const
+{
+	// the max is rounded to the next integer rather than up, two boxes that are apart by less
+	// than the float precision of the frame quantize to the same value and must still overlap
+	const dgFloat32 lowLimit = dgFloat32(-1.0f);
+	const dgFloat32 highLimit = DG_LINEAR_QUANTIZE_RANGE + dgFloat32(1.0f);
+	for (dgInt32 i = 0; i < 3; i++) {
+		const dgFloat32 p0 = dgFloor((minBox[i] - m_quantizeOrigin[i]) * m_quantizeScale[i]);
+		const dgFloat32 p1 = dgFloor((maxBox[i] - m_quantizeOrigin[i]) * m_quantizeScale[i]) + dgFloat32(1.0f);
+		minQuantized[i] = dgInt32(dgClamp(p0, lowLimit, highLimit));
+		maxQuantized[i] = dgInt32(dgClamp(p1, lowLimit, highLimit));
+	}
+}
+
+bool dgBroadPhaseLinear::QuantizeNode(dgLinearNode* const linearNode, const dgBroadPhaseNode* const node) const
+{
+	dgInt32 minBox[3];
+	dgInt32 maxBox[3];
+	QuantizeBox(node->m_minBox, node->m_maxBox, minBox, maxBox);
+	for (dgInt32 i = 0; i < 3; i++) {
+		if ((minBox[i] < 0) || (maxBox[i] > dgInt32(DG_LINEAR_QUANTIZE_RANGE))) {
+			return false;
+		}
+		linearNode->m_minBox[i] = dgUnsigned16(minBox[i]);
+		linearNode->m_maxBox[i] = dgUnsigned16(maxBox[i]);
+	}
+	return true;
+}
+
+void dgBroadPhaseLinear::GetNodeBox(const dgLinearNode& node, dgVector& minBox, dgVector& maxBox) const
+{
+	minBox = dgVector(dgFloat32(node.m_minBox[0]), dgFloat32(node.m_minBox[1]), dgFloat32(node.m_minBox[2]), dgFloat32(0.0f)).CompProduct4(m_quantizeInvScale) + m_quantizeOrigin;
+	maxBox = dgVector(dgFloat32(node.m_maxBox[0]), dgFloat32(node.m_maxBox[1]), dgFloat32(node.m_maxBox[2]), dgFloat32(0.0f)).CompProduct4(m_quantizeInvScale) + m_quantizeOrigin;
+}
+
+void dgBroadPhaseLinear::BuildLinearTree()
+{
+	dTimeTrackerEvent(__FUNCTION__);
+
+	m_linearDirty = false;
+	m_linearNodesCount = 0;
+	m_linearRevision = m_treeRevision;
+	if (!m_rootNode) {
+		return;
+	}
+
+	// the frame is twice the size of the tree, so that bodies can move for a while before the mirror has to be rebuilt.
+	// the step starts at the broadphase grid size, so for most worlds the quantized bounds are within one grid cell
+	for (dgInt32 i = 0; i < 3; i++) {
+		const dgFloat32 extent = m_rootNode->m_maxBox[i] - m_rootNode->m_minBox[i];
+		const dgFloat32 center = (m_rootNode->m_maxBox[i] + m_rootNode->m_minBox[i]) * dgFloat32(0.5f);
+		const dgFloat32 size = extent * dgFloat32(2.0f) + dgFloat32(16.0f);
+		dgFloat32 scale = dgBroadPhaseNode::m_broadPhaseScale[i];
+		while ((size * scale) > DG_LINEAR_QUANTIZE_RANGE) {
+			scale *= dgFloat32(0.5f);
+		}
+		m_quantizeScale[i] = scale;
+		m_quantizeInvScale[i] = dgFloat32(1.0f) / scale;
+		m_quantizeOrigin[i] = dgFloor((center - size * dgFloat32(0.5f)) * scale) * m_quantizeInvScale[i];
+	}
+
+	// depth first, right child first, this is the same order the pointer tree stacks visit the nodes
+	dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	dgInt32 parentPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	bool leftPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+	stackPool[0] = m_rootNode;
+	parentPool[0] = -1;
+	leftPool[0] = false;
+	dgInt32 stack = 1;
+	while (stack) {
+		stack--;
+		dgBroadPhaseNode* const node = stackPool[stack];
+		const dgInt32 parent = parentPool[stack];
+		const dgInt32 index = m_linearNodesCount;
+		m_linearNodesCount++;
+
+		if (leftPool[stack]) {
+			m_linearNodes[parent].SetChild(index, m_treeNode);
+		}
+
+		dgLinearNode& linearNode = m_linearNodes[index];
+		linearNode.m_parent = parent;
+		linearNode.m_skip = index + 1;
+		linearNode.m_leaf = NULL;
+		node->m_linearIndex = index;
+
+		if (node->IsAggregate()) {
+			dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)node;
+			linearNode.m_aggregate = aggregate;
+			if (aggregate->m_root) {
+				linearNode.SetChild(index + 1, m_aggregateNode);
+				stackPool[stack] = aggregate->m_root;
+				parentPool[stack] = index;
+				leftPool[stack] = false;
+				stack++;
+				dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+			} else {
+				linearNode.SetChild(0, m_aggregateNode);
+			}
+		} else if (node->IsLeafNode()) {
+			linearNode.SetChild(0, m_bodyNode);
+			linearNode.m_body = node->GetBody();
+			dgAssert(linearNode.m_body);
+		} else {
+			dgBroadPhaseTreeNode* const treeNode = (dgBroadPhaseTreeNode*)node;
+			linearNode.SetChild(0, m_treeNode);
+
+			stackPool[stack] = treeNode->m_left;
+			parentPool[stack] = index;
+			leftPool[stack] = true;
+			stack++;
+			dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+
+			stackPool[stack] = treeNode->m_right;
+			parentPool[stack] = index;
+			leftPool[stack] = false;
+			stack++;
+			dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+		}
+	}
+
+	// children always come after their parent, a backward sweep sets bounds and skip links bottom up
+	dgLinearNode* const nodes = &m_linearNodes[0];
+	for (dgInt32 i = m_linearNodesCount - 1; i >= 0; i--) {
+		dgLinearNode& node = nodes[i];
+		switch (node.GetKind())
+		{
+			case m_bodyNode:
+			{
+				bool inFrame = QuantizeNode(&node, node.m_body->GetBroadPhase());
+				dgAssert(inFrame);
+				if (!inFrame) {
+					m_linearDirty = true;
+				}
+				break;
+			}
+
+			case m_aggregateNode:
+			{
+				if (node.GetChild()) {
+					const dgLinearNode& child = nodes[i + 1];
+					for (dgInt32 j = 0; j < 3; j++) {
+						node.m_minBox[j] = child.m_minBox[j];
+						node.m_maxBox[j] = child.m_maxBox[j];
+					}
+					node.m_skip = child.m_skip;
+				} else {
+					// an empty aggregate can not overlap anything
+					for (dgInt32 j = 0; j < 3; j++) {
+						node.m_minBox[j] = dgUnsigned16(DG_LINEAR_QUANTIZE_RANGE);
+						node.m_maxBox[j] = 0;
+					}
+				}
+				break;
+			}
+
+			case m_treeNode:
+			default:
+			{
+				const dgLinearNode& right = nodes[i + 1];
+				const dgLinearNode& left = nodes[node.GetChild()];
+				dgAssert(right.m_skip == node.GetChild());
+				for (dgInt32 j = 0; j < 3; j++) {
+					node.m_minBox[j] = dgMin(left.m_minBox[j], right.m_minBox[j]);
+					node.m_maxBox[j] = dgMax(left.m_maxBox[j], right.m_maxBox[j]);
+				}
+				node.m_skip = left.m_skip;
+				break;
+			}
+		}
+	}
+}
+
+void dgBroadPhaseLinear::RefitLinearNode(dgInt32 index)
+{
+	dgLinearNode* const nodes = &m_linearNodes[0];
+	for (dgInt32 parent = nodes[index].m_parent; parent >= 0; parent = nodes[parent].m_parent) {
+		dgLinearNode& node = nodes[parent];
+		const dgLinearNode& right = nodes[parent + 1];
+
+		dgUnsigned16 minBox[3];
+		dgUnsigned16 maxBox[3];
+		if (node.GetKind() == m_treeNode) {
+			const dgLinearNode& left = nodes[node.GetChild()];
+			for (dgInt32 j = 0; j < 3; j++) {
+				minBox[j] = dgMin(left.m_minBox[j], right.m_minBox[j]);
+				maxBox[j] = dgMax(left.m_maxBox[j], right.m_maxBox[j]);
+			}
+		} else {
+			dgAssert(node.GetKind() == m_aggregateNode);
+			for (dgInt32 j = 0; j < 3; j++) {
+				minBox[j] = right.m_minBox[j];
+				maxBox[j] = right.m_maxBox[j];
+			}
+		}
+
+		// same as the pointer tree, stop as soon as a parent still contains its children
+		bool inside = true;
+		for (dgInt32 j = 0; j < 3; j++) {
+			inside &= (minBox[j] >= node.m_minBox[j]) && (maxBox[j] <= node.m_maxBox[j]);
+		}
+		if (inside) {
+			break;
+		}
+		for (dgInt32 j = 0; j < 3; j++) {
+			node.m_minBox[j] = minBox[j];
+			node.m_maxBox[j] = maxBox[j];
+		}
+	}
+}
+
+void dgBroadPhaseLinear::UpdateLeafBox(dgBroadPhaseNode* const leaf)
+{
+	// called from UpdateBody with the broadphase lock held
+	if (IsValid()) {
+		const dgInt32 index = leaf->m_linearIndex;
+		dgAssert((index >= 0) && (index < m_linearNodesCount));
+		dgLinearNode* const node = &m_linearNodes[index];
+		dgAssert(node->GetKind() == m_bodyNode);
+		if (QuantizeNode(node, leaf)) {
+			RefitLinearNode(index);
+		} else {
+			// the body left the frame, use the pointer tree until the mirror is rebuilt
+			m_linearDirty = true;
+		}
+	}
+}
+
+bool dgBroadPhaseLinear::LeafOverlap(const dgLinearNode& leaf, const dgVector& minBox, const dgVector& maxBox) const
+{
+	const dgBroadPhaseNode* const node = (leaf.GetKind() == m_bodyNode) ? (dgBroadPhaseNode*)leaf.m_body->GetBroadPhase() : (dgBroadPhaseNode*)leaf.m_aggregate;
+	return dgOverlapTest(node->m_minBox, node->m_maxBox, minBox, maxBox) ? true : false;
+}
+
+void dgBroadPhaseLinear::QuantizeLeaf(const dgLinearNode& leaf, dgInt32* const minBox, dgInt32* const maxBox) const
+{
+	dgBody* const body0 = (leaf.GetKind() == m_bodyNode) ? leaf.m_body : NULL;
+	const dgVector& boxP0 = body0 ? body0->m_minAABB : leaf.m_aggregate->m_minBox;
+	const dgVector& boxP1 = body0 ? body0->m_maxAABB : leaf.m_aggregate->m_maxBox;
+	QuantizeBox(boxP0, boxP1, minBox, maxBox);
+}
+
+void dgBroadPhaseLinear::SubmitPairs(const dgLinearNode& leaf, const dgInt32* const minBox, const dgInt32* const maxBox, dgInt32 index, dgFloat32 timestep, dgInt32 threadID)
+{
+	dgBody* const body0 = (leaf.GetKind() == m_bodyNode) ? leaf.m_body : NULL;
+	const dgVector& boxP0 = body0 ? body0->m_minAABB : leaf.m_aggregate->m_minBox;
+	const dgVector& boxP1 = body0 ? body0->m_maxAABB : leaf.m_aggregate->m_maxBox;
+
+	const bool test0 = body0 ? (body0->GetInvMass().m_w != dgFloat32(0.0f)) : true;
+	const dgLinearNode* const nodes = &m_linearNodes[0];
+	const dgInt32 end = nodes[index].m_skip;
+	for (dgInt32 i = index; i < end; ) {
+		const dgLinearNode& node = nodes[i];
+		if (!node.Overlap(minBox, maxBox)) {
+			i = node.m_skip;
+		} else if (node.GetKind() == m_treeNode) {
+			i++;
+		} else if (!LeafOverlap(node, boxP0, boxP1)) {
+			// the quantized boxes are conservative, the leaves get the exact test of the pointer tree
+			i = node.m_skip;
+		} else {
+			if (body0) {
+				if (node.GetKind() == m_bodyNode) {
+					dgBody* const body1 = node.m_body;
+					if (test0 || (body1->GetInvMass().m_w != dgFloat32(0.0f))) {
+						AddPair(body0, body1, timestep, threadID);
+					}
+				} else {
+					node.m_aggregate->SummitPairs(body0, timestep, threadID);
+				}
+			} else {
+				dgBroadPhaseAggregate* const aggregate = leaf.m_aggregate;
+				if (node.GetKind() == m_bodyNode) {
+					aggregate->SummitPairs(node.m_body, timestep, threadID);
+				} else {
+					aggregate->SummitPairs(node.m_aggregate, timestep, threadID);
+				}
+			}
+			i = node.m_skip;
+		}
+	}
+}
+
+void dgBroadPhaseLinear::FindCollidingPairsForward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::FindCollidingPairsForward(descriptor, broadPhaseNode, threadID);
+		return;
+	}
+
+	const dgFloat32 timestep = descriptor->m_timestep;
+	const dgLinearNode* const nodes = &m_linearNodes[0];
+	const dgInt32 leafIndex = broadPhaseNode->m_linearIndex;
+	dgAssert((leafIndex >= 0) && (leafIndex < m_linearNodesCount));
+	const dgLinearNode& leaf = nodes[leafIndex];
+
+	if (leaf.GetKind() == m_aggregateNode) {
+		leaf.m_aggregate->SubmitSeltPairs(timestep, threadID);
+	}
+
+	// the leaf box is quantized once for all the levels
+	dgInt32 minBox[3];
+	dgInt32 maxBox[3];
+	QuantizeLeaf(leaf, minBox, maxBox);
+	for (dgInt32 ptr = leafIndex, parent = leaf.m_parent; parent >= 0; ptr = parent, parent = nodes[parent].m_parent) {
+		dgAssert(nodes[parent].GetKind() == m_treeNode);
+		const dgInt32 rightSibling = parent + 1;
+		if (rightSibling != ptr) {
+			SubmitPairs(leaf, minBox, maxBox, rightSibling, timestep, threadID);
+		}
+	}
+}
+
+void dgBroadPhaseLinear::FindCollidingPairsForwardAndBackward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::FindCollidingPairsForwardAndBackward(descriptor, broadPhaseNode, threadID);
+		return;
+	}
+
+	const dgUnsigned32 lru = m_lru + 1;
+	if (lru == broadPhaseNode->GetDirtyLru()) {
+		const dgFloat32 timestep = descriptor->m_timestep;
+		const dgLinearNode* const nodes = &m_linearNodes[0];
+		const dgInt32 leafIndex = broadPhaseNode->m_linearIndex;
+		dgAssert((leafIndex >= 0) && (leafIndex < m_linearNodesCount));
+		const dgLinearNode& leaf = nodes[leafIndex];
+
+		if (leaf.GetKind() == m_aggregateNode) {
+			leaf.m_aggregate->SubmitSeltPairs(timestep, threadID);
+		}
+
+		dgInt32 minBox[3];
+		dgInt32 maxBox[3];
+		QuantizeLeaf(leaf, minBox, maxBox);
+		for (dgInt32 ptr = leafIndex, parent = leaf.m_parent; parent >= 0; ptr = parent, parent = nodes[parent].m_parent) {
+			dgAssert(nodes[parent].GetKind() == m_treeNode);
+			const dgInt32 rightSibling = parent + 1;
+			if (rightSibling != ptr) {
+				SubmitPairs(leaf, minBox, maxBox, rightSibling, timestep, threadID);
+			}
+			const dgInt32 leftSibling = nodes[parent].GetChild();
+			if (leftSibling != ptr) {
+				SubmitPairs(leaf, minBox, maxBox, leftSibling, timestep, threadID);
+			}
+		}
+	}
+}
+
+void dgBroadPhaseLinear::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::ForEachBodyInAABB(minBox, maxBox, callback, userData);
+		return;
+	}
+
+	dgInt32 minQuantized[3];
+	dgInt32 maxQuantized[3];
+	QuantizeBox(minBox, maxBox, minQuantized, maxQuantized);
+
+	const dgLinearNode* const nodes = &m_linearNodes[0];
+	for (dgInt32 i = 0; i < m_linearNodesCount; ) {
+		const dgLinearNode& node = nodes[i];
+		if (!node.Overlap(minQuantized, maxQuantized)) {
+			i = node.m_skip;
+		} else if (node.GetKind() == m_bodyNode) {
+			dgBody* const body = node.m_body;
+			if (dgOverlapTest(body->m_minAABB, body->m_maxAABB, minBox, maxBox)) {
+				if (!callback(body, userData)) {
+					break;
+				}
+			}
+			i = node.m_skip;
+		} else {
+			i++;
+		}
+	}
+}
+
+void dgBroadPhaseLinear::RayCast(const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::RayCast(l0, l1, filter, prefilter, userData);
+		return;
+	}
+
+	if (filter) {
+		dgVector segment(l1 - l0);
+		dgFloat32 dist2 = segment.DotProduct3(segment);
+		if (dist2 > dgFloat32(1.0e-8f)) {
+			dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
+			dgInt32 stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+			dgFastRayTest ray(l0, l1);
+			dgLineBox line;
+			line.m_l0 = l0;
+			line.m_l1 = l1;
+			dgVector test(line.m_l0 <= line.m_l1);
+			line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
+			line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
+
+			dgVector minBox;
+			dgVector maxBox;
+			const dgLinearNode* const nodes = &m_linearNodes[0];
+			GetNodeBox(nodes[0], minBox, maxBox);
+			stackPool[0] = 0;
+			distance[0] = ray.BoxIntersect(minBox, maxBox);
+
+			dgInt32 stack = 1;
+			dgFloat32 maxParam = dgFloat32(1.2f);
+			while (stack) {
+				stack--;
+				if (distance[stack] > maxParam) {
+					break;
+				}
+				const dgInt32 index = stackPool[stack];
+				const dgLinearNode& node = nodes[index];
+				switch (node.GetKind())
+				{
+					case m_bodyNode:
+					{
+						dgFloat32 param = node.m_body->RayCast(line, filter, prefilter, userData, maxParam);
+						if (param < maxParam) {
+							maxParam = param;
+							if (maxParam < dgFloat32(1.0e-8f)) {
+								stack = 0;
+							}
+						}
+						break;
+					}
+
+					case m_aggregateNode:
+					{
+						if (node.GetChild()) {
+							const dgInt32 child = index + 1;
+							GetNodeBox(nodes[child], minBox, maxBox);
+							dgFloat32 dist1 = ray.BoxIntersect(minBox, maxBox);
+							if (dist1 < maxParam) {
+								stack = dgLinearPushNode(stackPool, distance, stack, child, dist1);
+							}
+						}
+						break;
+					}
+
+					case m_treeNode:
+					default:
+					{
+						const dgInt32 left = node.GetChild();
+						GetNodeBox(nodes[left], minBox, maxBox);
+						dgFloat32 dist1 = ray.BoxIntersect(minBox, maxBox);
+						if (dist1 < maxParam) {
+							stack = dgLinearPushNode(stackPool, distance, stack, left, dist1);
+						}
+
+						const dgInt32 right = index + 1;
+						GetNodeBox(nodes[right], minBox, maxBox);
+						dist1 = ray.BoxIntersect(minBox, maxBox);
+						if (dist1 < maxParam) {
+							stack = dgLinearPushNode(stackPool, distance, stack, right, dist1);
+						}
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+dgInt32 dgBroadPhaseLinear::ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	if (!IsValid()) {
+		return dgBroadPhaseDefault::ConvexCast(shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	dgVector boxP0;
+	dgVector boxP1;
+	dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
+	dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
+	dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
+	dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
+	dgInt32 stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgVector velocA((target - matrix.m_posit) & dgVector::m_triplexMask);
+	dgVector velocB(dgFloat32(0.0f));
+	dgFastRayTest ray(dgVector(dgFloat32(0.0f)), velocA);
+
+	dgVector minBox;
+	dgVector maxBox;
+	const dgLinearNode* const nodes = &m_linearNodes[0];
+	GetNodeBox(nodes[0], minBox, maxBox);
+	stackPool[0] = 0;
+	distance[0] = ray.BoxIntersect(minBox - boxP1, maxBox - boxP0);
+
+	maxContacts = dgMin(maxContacts, DG_CONVEX_CAST_POOLSIZE);
+	dgAssert(!maxContacts || (maxContacts && info));
+
+	*param = dgFloat32(1.0f);
+	dgInt32 totalCount = 0;
+	dgInt32 stack = 1;
+	dgFloat32 maxParam = *param;
+	dgFloat32 timeToImpact = *param;
+	while (stack) {
+		stack--;
+		if (distance[stack] > maxParam) {
+			break;
+		}
+
+		const dgInt32 index = stackPool[stack];
+		const dgLinearNode& node = nodes[index];
+		switch (node.GetKind())
+		{
+			case m_bodyNode:
+			{
+				dgBody* const body = node.m_body;
+				if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
+					dgInt32 count = m_world->CollideContinue(shape, matrix, velocA, velocB, body->m_collision, body->m_matrix, velocB, velocB, timeToImpact, points, normals, penetration, attributeA, attributeB, maxContacts, threadIndex);
+
+					if (timeToImpact < maxParam) {
+						if ((timeToImpact - maxParam) < dgFloat32(-1.0e-3f)) {
+							totalCount = 0;
+						}
+						maxParam = timeToImpact;
+						if (count >= (maxContacts - totalCount)) {
+							count = maxContacts - totalCount;
+						}
+
+						for (dgInt32 i = 0; i < count; i++) {
+							info[totalCount].m_point[0] = points[i].m_x;
+							info[totalCount].m_point[1] = points[i].m_y;
+							info[totalCount].m_point[2] = points[i].m_z;
+							info[totalCount].m_point[3] = dgFloat32(0.0f);
+							info[totalCount].m_normal[0] = normals[i].m_x;
+							info[totalCount].m_normal[1] = normals[i].m_y;
+							info[totalCount].m_normal[2] = normals[i].m_z;
+							info[totalCount].m_normal[3] = dgFloat32(0.0f);
+							info[totalCount].m_penetration = penetration[i];
+							info[totalCount].m_contaID = attributeB[i];
+							info[totalCount].m_hitBody = body;
+							totalCount++;
+						}
+					}
+					if (maxParam < 1.0e-8f) {
+						stack = 0;
+					}
+				}
+				break;
+			}
+
+			case m_aggregateNode:
+			{
+				if (node.GetChild()) {
+					const dgInt32 child = index + 1;
+					GetNodeBox(nodes[child], minBox, maxBox);
+					dgFloat32 dist1 = ray.BoxIntersect(minBox - boxP1, maxBox - boxP0);
+					if (dist1 < maxParam) {
+						stack = dgLinearPushNode(stackPool, distance, stack, child, dist1);
+					}
+				}
+				break;
+			}
+
+			case m_treeNode:
+			default:
+			{
+				const dgInt32 left = node.GetChild();
+				GetNodeBox(nodes[left], minBox, maxBox);
+				dgFloat32 dist1 = ray.BoxIntersect(minBox - boxP1, maxBox - boxP0);
+				if (dist1 < maxParam) {
+					stack = dgLinearPushNode(stackPool, distance, stack, left, dist1);
+				}
+
+				const dgInt32 right = index + 1;
+				GetNodeBox(nodes[right], minBox, maxBox);
+				dist1 = ray.BoxIntersect(minBox - boxP1, maxBox - boxP0);
+				if (dist1 < maxParam) {
+					stack = dgLinearPushNode(stackPool, distance, stack, right, dist1);
+				}
+				break;
+			}
+		}
+	}
+	*param = maxParam;
+	return totalCount;
+}
+
+dgInt32 dgBroadPhaseLinear::Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	if (!IsValid()) {
+		return dgBroadPhaseDefault::Collide(shape, matrix, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	dgVector boxP0;
+	dgVector boxP1;
+	dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
+	dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
+	dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
+
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgInt32 minQuantized[3];
+	dgInt32 maxQuantized[3];
+	QuantizeBox(boxP0, boxP1, minQuantized, maxQuantized);
+
+	dgInt32 totalCount = 0;
+	const dgLinearNode* const nodes = &m_linearNodes[0];
+	for (dgInt32 i = 0; i < m_linearNodesCount; ) {
+		const dgLinearNode& node = nodes[i];
+		if (!node.Overlap(minQuantized, maxQuantized)) {
+			i = node.m_skip;
+		} else if (node.GetKind() == m_bodyNode) {
+			dgBody* const body = node.m_body;
+			if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
+				dgInt32 count = m_world->Collide(shape, matrix, body->m_collision, body->m_matrix, points, normals, penetration, attributeA, attributeB, DG_CONVEX_CAST_POOLSIZE, threadIndex);
+
+				if (count) {
+					bool teminate = false;
+					if (count >= (maxContacts - totalCount)) {
+						count = maxContacts - totalCount;
+						teminate = true;
+					}
+
+					for (dgInt32 j = 0; j < count; j++) {
+						info[totalCount].m_point[0] = points[j].m_x;
+						info[totalCount].m_point[1] = points[j].m_y;
+						info[totalCount].m_point[2] = points[j].m_z;
+						info[totalCount].m_point[3] = dgFloat32(0.0f);
+						info[totalCount].m_normal[0] = normals[j].m_x;
+						info[totalCount].m_normal[1] = normals[j].m_y;
+						info[totalCount].m_normal[2] = normals[j].m_z;
+						info[totalCount].m_normal[3] = dgFloat32(0.0f);
+						info[totalCount].m_penetration = penetration[j];
+						info[totalCount].m_contaID = attributeB[j];
+						info[totalCount].m_hitBody = body;
+						totalCount++;
+					}
+
+					if (teminate) {
+						break;
+					}
+				}
+			}
+			i = node.m_skip;
+		} else {
+			i++;
+		}
+	}
+	return totalCount;
+}
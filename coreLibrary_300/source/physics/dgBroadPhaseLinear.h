@@ -0,0 +1,133 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __AFX_BROADPHASE_LINEAR_H_
+#define __AFX_BROADPHASE_LINEAR_H_
+
+#include "dgPhysicsStdafx.h"
+#include "dgBroadPhaseDefault.h"
+
+#define DG_LINEAR_NODE_KIND_MASK	3
+#define DG_LINEAR_NODE_KIND_BITS	2
+#define DG_LINEAR_QUANTIZE_RANGE	dgFloat32 (65535.0f)
+
+// same tree as the default broadphase, but all traversals run on a flat mirror of it.
+// the mirror is 32 byte nodes in depth first order, the right child always follows its parent
+// and the left child index is tagged in the low bits with the node kind.
+// bounds are 16 bit integers relative to a frame that is chosen when the mirror is rebuilt.
+class dgBroadPhaseLinear: public dgBroadPhaseDefault
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator);
+
+	dgBroadPhaseLinear(dgWorld* const world);
+	virtual ~dgBroadPhaseLinear();
+
+	protected:
+	enum dgNodeKind
+	{
+		m_treeNode,
+		m_bodyNode,
+		m_aggregateNode,
+	};
+
+	class dgLinearNode
+	{
+		public:
+		DG_INLINE dgInt32 GetKind() const
+		{
+			return m_child & DG_LINEAR_NODE_KIND_MASK;
+		}
+
+		DG_INLINE dgInt32 GetChild() const
+		{
+			return m_child >> DG_LINEAR_NODE_KIND_BITS;
+		}
+
+		DG_INLINE void SetChild(dgInt32 index, dgInt32 kind)
+		{
+			m_child = (index << DG_LINEAR_NODE_KIND_BITS) | kind;
+		}
+
+		DG_INLINE dgInt32 Overlap(const dgInt32* const minBox, const dgInt32* const maxBox) const
+		{
+			return (dgInt32 (m_minBox[0]) < maxBox[0]) & (dgInt32 (m_maxBox[0]) > minBox[0]) &
+				   (dgInt32 (m_minBox[1]) < maxBox[1]) & (dgInt32 (m_maxBox[1]) > minBox[1]) &
+				   (dgInt32 (m_minBox[2]) < maxBox[2]) & (dgInt32 (m_maxBox[2]) > minBox[2]);
+		}
+
+		dgUnsigned16 m_minBox[3];
+		dgUnsigned16 m_maxBox[3];
+		dgInt32 m_child;
+		dgInt32 m_parent;
+		dgInt32 m_skip;
+		union
+		{
+			void* m_leaf;
+			dgBody* m_body;
+			dgBroadPhaseAggregate* m_aggregate;
+		};
+	};
+
+	virtual dgInt32 GetType() const;
+	virtual void Add(dgBody* const body);
+	virtual void Remove(dgBody* const body);
+	virtual void AddBodies(dgBody** const bodies, dgInt32 count);
+	virtual void UpdateFitness();
+	virtual void InvalidateCache();
+	virtual void DestroyAggregate(dgBroadPhaseAggregate* const aggregate);
+
+	virtual void LinkAggregate (dgBroadPhaseAggregate* const aggregate);
+	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate);
+	virtual void UpdateLeafBox (dgBroadPhaseNode* const leaf);
+	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+
+	virtual void RayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	virtual dgInt32 Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	virtual dgInt32 ConvexCast (dgCollisionInstance* const shape, const dgMatrix& p0, const dgVector& p1, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	virtual void ForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+
+	void BuildLinearTree();
+	void RefitLinearNode (dgInt32 index);
+	bool QuantizeNode (dgLinearNode* const linearNode, const dgBroadPhaseNode* const node) const;
+	void QuantizeBox (const dgVector& minBox, const dgVector& maxBox, dgInt32* const minQuantized, dgInt32* const maxQuantized) const;
+	void GetNodeBox (const dgLinearNode& node, dgVector& minBox, dgVector& maxBox) const;
+	bool LeafOverlap (const dgLinearNode& leaf, const dgVector& minBox, const dgVector& maxBox) const;
+	void QuantizeLeaf (const dgLinearNode& leaf, dgInt32* const minBox, dgInt32* const maxBox) const;
+	void SubmitPairs (const dgLinearNode& leaf, const dgInt32* const minBox, const dgInt32* const maxBox, dgInt32 index, dgFloat32 timestep, dgInt32 threadID);
+
+	DG_INLINE bool IsValid() const
+	{
+		return m_linearNodesCount && !m_linearDirty;
+	}
+
+	dgArray<dgLinearNode> m_linearNodes;
+	dgVector m_quantizeOrigin;
+	dgVector m_quantizeScale;
+	dgVector m_quantizeInvScale;
+	dgInt32 m_linearNodesCount;
+	dgUnsigned32 m_linearRevision;
+	bool m_linearDirty;
+};
+
+
+#endif
@@ -104,6 +104,8 @@ void dgBroadPhasePersistent::Add(dgBody* const body)
 			root->m_right = new (m_world->GetAllocator()) dgBroadPhaseBodyNode(body);
 			root->m_right->m_parent = m_rootNode;
 		}
+		// static leaves are not in the update array, only a full scan finds their pairs
+		InvalidatePairCache();
 	} else {
 		dgBroadPhaseBodyNode* const newNode = new (m_world->GetAllocator()) dgBroadPhaseBodyNode(body);
 		if (root->m_left) {
@@ -113,7 +115,41 @@ void dgBroadPhasePersistent::Add(dgBody* const body)
 			root->m_left = newNode;
 			root->m_left->m_parent = m_rootNode;
 		}
-		newNode->m_updateNode = m_updateList.Append(newNode);
+		AddToUpdateArray(newNode);
+	}
+}
+
+void dgBroadPhasePersistent::AddBodies(dgBody** const bodies, dgInt32 count)
+{
+	// the static and the dynamic bodies of the batch are built into one sub tree each
+	dgAssert (m_rootNode->IsPersistentRoot());
+	dgBroadPhasePesistanceRootNode* const root = (dgBroadPhasePesistanceRootNode*)m_rootNode;
+
+	dgInt32 staticCount = 0;
+	dgInt32 dynamicsCount = 0;
+	dgStack<dgBroadPhaseNode*> staticLeaves(count);
+	dgStack<dgBroadPhaseNode*> dynamicsLeaves(count);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBody* const body = bodies[i];
+		dgAssert (!body->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI));
+		dgBroadPhaseBodyNode* const newNode = new (m_world->GetAllocator()) dgBroadPhaseBodyNode(body);
+		if (body->GetInvMass().m_w == dgFloat32(0.0f)) {
+			staticLeaves[staticCount] = newNode;
+			staticCount ++;
+		} else {
+			AddToUpdateArray(newNode);
+			dynamicsLeaves[dynamicsCount] = newNode;
+			dynamicsCount ++;
+		}
+	}
+
+	if (staticCount) {
+		m_staticNeedsUpdate = true;
+		AddLeaves(m_staticFitness, m_staticEntropy, &root->m_right, m_rootNode, &staticLeaves[0], staticCount);
+		InvalidatePairCache();
+	}
+	if (dynamicsCount) {
+		AddLeaves(m_dynamicsFitness, m_dynamicsEntropy, &root->m_left, m_rootNode, &dynamicsLeaves[0], dynamicsCount);
 	}
 }
 
@@ -137,13 +173,13 @@ void dgBroadPhasePersistent::LinkAggregate(dgBroadPhaseAggregate* const aggregat
 		root->m_left = aggregate;
 		root->m_left->m_parent = m_rootNode;
 	}
-	aggregate->m_updateNode = m_updateList.Append(aggregate);
+	AddToUpdateArray(aggregate);
 	aggregate->m_myAggregateNode = m_aggregateList.Append(aggregate);
 }
 
 void dgBroadPhasePersistent::DestroyAggregate(dgBroadPhaseAggregate* const aggregate)
 {
-	m_updateList.Remove(aggregate->m_updateNode);
+	RemoveFromUpdateArray(aggregate);
 	m_aggregateList.Remove(aggregate->m_myAggregateNode);
 	RemoveNode(aggregate);
 }
@@ -328,9 +364,7 @@ void dgBroadPhasePersistent::Remove(dgBody* const body)
 {
 	if (body->GetBroadPhase()) {
 		dgBroadPhaseBodyNode* const node = body->GetBroadPhase();
-		if (node->m_updateNode) {
-			m_updateList.Remove(node->m_updateNode);
-		}
+		RemoveFromUpdateArray(node);
 		RemoveNode(node);
 	}
 }
@@ -496,73 +530,52 @@ dgInt32 dgBroadPhasePersistent::Collide(dgCollisionInstance* const shape, const
 	return totalCount;
 }
 
-void dgBroadPhasePersistent::FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const nodePtr, dgInt32 threadID)
+void dgBroadPhasePersistent::FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
 {
 	const dgFloat32 timestep = descriptor->m_timestep;
 
-	dgList<dgBroadPhaseNode*>::dgListNode* node = nodePtr;
-	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
-	while (node) {
-		dgBroadPhaseNode* const broadPhaseNode = node->GetInfo();
-		dgAssert(broadPhaseNode->IsLeafNode());
-		dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
-
-		if (broadPhaseNode->IsAggregate()) {
-			((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
-		}
+	dgAssert(broadPhaseNode->IsLeafNode());
+	dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
 
-		for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
-			dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
-			dgAssert(!parent->IsLeafNode());
-			dgBroadPhaseNode* const sibling = parent->m_right;
-			if (sibling && (sibling != ptr)) {
-				SubmitPairs(broadPhaseNode, sibling, timestep, 0, threadID);
-			}
-		}
+	if (broadPhaseNode->IsAggregate()) {
+		((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
+	}
 
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			//node = (node && node->GetInfo()->GetBody() && (node->GetInfo()->GetBody()->GetInvMass().m_w != dgFloat32(0.0f))) ? node->GetNext() : NULL;
-			dgBroadPhaseNode* const info = node ? node->GetInfo() : NULL;
-			node = (info && ((info->GetBody() && (info->GetBody()->GetInvMass().m_w != dgFloat32(0.0f))) || info->IsAggregate())) ? node->GetNext() : NULL;
+	for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
+		dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
+		dgAssert(!parent->IsLeafNode());
+		dgBroadPhaseNode* const sibling = parent->m_right;
+		if (sibling && (sibling != ptr)) {
+			SubmitPairs(broadPhaseNode, sibling, timestep, 0, threadID);
 		}
-	}	
+	}
 }
 
-void dgBroadPhasePersistent::FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const nodePtr, dgInt32 threadID)
+void dgBroadPhasePersistent::FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
 {
 	const dgFloat32 timestep = descriptor->m_timestep;
 
-	dgList<dgBroadPhaseNode*>::dgListNode* node = nodePtr;
 	const dgInt32 threadCount = descriptor->m_world->GetThreadCount();
 	const dgUnsigned32 lru = m_lru + 1;
-	while (node) {
-		dgBroadPhaseNode* const broadPhaseNode = node->GetInfo();
-		dgAssert(broadPhaseNode->IsLeafNode());
-		dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
-
-		if (lru == broadPhaseNode->GetDirtyLru()) {
-			if (broadPhaseNode->IsAggregate()) {
-				((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
-			}
+	dgAssert(broadPhaseNode->IsLeafNode());
+	dgAssert(!broadPhaseNode->GetBody() || (broadPhaseNode->GetBody()->GetBroadPhase() == broadPhaseNode));
 
-			for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
-				dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
-				dgAssert(!parent->IsLeafNode());
-				dgBroadPhaseNode* const rightSibling = parent->m_right;
-				if (rightSibling && (rightSibling != ptr)) {
-					SubmitPairs(broadPhaseNode, rightSibling, timestep, threadCount, threadID);
-				}
-				dgBroadPhaseNode* const leftSibling = parent->m_left;
-				if (leftSibling && (leftSibling != ptr)) {
-					SubmitPairs(broadPhaseNode, leftSibling, timestep, threadCount, threadID);
-				}
-			}
+	if (lru == broadPhaseNode->GetDirtyLru()) {
+		if (broadPhaseNode->IsAggregate()) {
+			((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
 		}
 
-		for (dgInt32 i = 0; i < threadCount; i++) {
-			//node = (node && node->GetInfo()->GetBody() && (node->GetInfo()->GetBody()->GetInvMass().m_w != dgFloat32(0.0f))) ? node->GetNext() : NULL;
-			dgBroadPhaseNode* const info = node ? node->GetInfo() : NULL;
-			node = (info && ((info->GetBody() && (info->GetBody()->GetInvMass().m_w != dgFloat32(0.0f))) || info->IsAggregate())) ? node->GetNext() : NULL;
+		for (dgBroadPhaseNode* ptr = broadPhaseNode; ptr->m_parent; ptr = ptr->m_parent) {
+			dgBroadPhaseTreeNode* const parent = (dgBroadPhaseTreeNode*)ptr->m_parent;
+			dgAssert(!parent->IsLeafNode());
+			dgBroadPhaseNode* const rightSibling = parent->m_right;
+			if (rightSibling && (rightSibling != ptr)) {
+				SubmitPairs(broadPhaseNode, rightSibling, timestep, threadCount, threadID);
+			}
+			dgBroadPhaseNode* const leftSibling = parent->m_left;
+			if (leftSibling && (leftSibling != ptr)) {
+				SubmitPairs(broadPhaseNode, leftSibling, timestep, threadCount, threadID);
+			}
 		}
 	}
 }
@@ -38,6 +38,7 @@ class dgBroadPhasePersistent: public dgBroadPhase
 	virtual dgInt32 GetType() const;
 	virtual void Add(dgBody* const body);
 	virtual void Remove(dgBody* const body);
+	virtual void AddBodies(dgBody** const bodies, dgInt32 count);
 	virtual void InvalidateCache();
 	virtual dgBroadPhaseAggregate* CreateAggregate();
 	virtual void DestroyAggregate(dgBroadPhaseAggregate* const aggregate);
@@ -45,8 +46,8 @@ class dgBroadPhasePersistent: public dgBroadPhase
 	virtual void CheckStaticDynamic(dgBody* const body, dgFloat32 mass);
 	virtual void LinkAggregate(dgBroadPhaseAggregate* const aggregate);
 	virtual void UnlinkAggregate(dgBroadPhaseAggregate* const aggregate);
-	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID);
-	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgList<dgBroadPhaseNode*>::dgListNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
 
 	virtual void ResetEntropy();
 	virtual void UpdateFitness();
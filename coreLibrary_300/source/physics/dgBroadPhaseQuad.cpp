@@ -0,0 +1,730 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgCollisionInstance.h"
+#include "dgBroadPhaseQuad.h"
+#include "dgBroadPhaseAggregate.h"
+
+// an unused slot is a point far away from the world, it fails every overlap and every ray test
+#define DG_QUAD_EMPTY_BOX	dgFloat32 (1.0e15f)
+
+
+DG_INLINE static dgInt32 dgQuadPushChild (dgInt32* const stackPool, dgFloat32* const distance, dgInt32 stack, dgInt32 child, dgFloat32 dist)
+{
+	dgInt32 j = stack;
+	for (; j && (dist > distance[j - 1]); j--) {
+		stackPool[j] = stackPool[j - 1];
+		distance[j] = distance[j - 1];
+	}
+	stackPool[j] = child;
+	distance[j] = dist;
+	dgAssert((stack + 1) < DG_QUAD_STACK_DEPTH);
+	return stack + 1;
+}
+
+
+void dgBroadPhaseQuad::dgQuadNode::GetSlotBox(dgInt32 slot, dgVector& minBox, dgVector& maxBox) const
+{
+	minBox = dgVector(m_minX[slot], m_minY[slot], m_minZ[slot], dgFloat32(0.0f));
+	maxBox = dgVector(m_maxX[slot], m_maxY[slot], m_maxZ[slot], dgFloat32(0.0f));
+}
+
+void dgBroadPhaseQuad::dgQuadNode::SetSlotBox(dgInt32 slot, const dgVector& minBox, const dgVector& maxBox)
+{
+	m_minX[slot] = minBox.m_x;
+	m_minY[slot] = minBox.m_y;
+	m_minZ[slot] = minBox.m_z;
+	m_maxX[slot] = maxBox.m_x;
+	m_maxY[slot] = maxBox.m_y;
+	m_maxZ[slot] = maxBox.m_z;
+}
+
+void dgBroadPhaseQuad::dgQuadNode::GetBox(dgVector& minBox, dgVector& maxBox) const
+{
+	minBox = dgVector(DG_QUAD_EMPTY_BOX);
+	maxBox = dgVector(-DG_QUAD_EMPTY_BOX);
+	bool empty = true;
+	for (dgInt32 i = 0; i < 4; i++) {
+		if (m_child[i] != DG_QUAD_EMPTY_SLOT) {
+			dgVector p0;
+			dgVector p1;
+			GetSlotBox(i, p0, p1);
+			minBox = minBox.GetMin(p0);
+			maxBox = maxBox.GetMax(p1);
+			empty = false;
+		}
+	}
+	if (empty) {
+		maxBox = minBox;
+	}
+	minBox = minBox & dgVector::m_triplexMask;
+	maxBox = maxBox & dgVector::m_triplexMask;
+}
+
+dgBroadPhaseQuad::dgQuadRay::dgQuadRay(const dgFastRayTest& ray, const dgVector& boxP0, const dgVector& boxP1)
+{
+	m_p0[0] = ray.m_p0.BroadcastX();
+	m_p0[1] = ray.m_p0.BroadcastY();
+	m_p0[2] = ray.m_p0.BroadcastZ();
+	m_invDir[0] = ray.m_dpInv.BroadcastX();
+	m_invDir[1] = ray.m_dpInv.BroadcastY();
+	m_invDir[2] = ray.m_dpInv.BroadcastZ();
+	m_isParallel[0] = ray.m_isParallel.BroadcastX();
+	m_isParallel[1] = ray.m_isParallel.BroadcastY();
+	m_isParallel[2] = ray.m_isParallel.BroadcastZ();
+
+	// for a convex cast the node boxes are inflated by the box of the cast shape
+	m_minOffset[0] = boxP1.BroadcastX();
+	m_minOffset[1] = boxP1.BroadcastY();
+	m_minOffset[2] = boxP1.BroadcastZ();
+	m_maxOffset[0] = boxP0.BroadcastX();
+	m_maxOffset[1] = boxP0.BroadcastY();
+	m_maxOffset[2] = boxP0.BroadcastZ();
+}
+
+DG_INLINE dgVector dgBroadPhaseQuad::dgQuadRay::BoxIntersect(const dgQuadNode& node) const
+{
+	// same slab test as dgFastRayTest::BoxIntersect, one child per lane
+	const dgVector minX(node.m_minX - m_minOffset[0]);
+	const dgVector maxX(node.m_maxX - m_maxOffset[0]);
+	const dgVector minY(node.m_minY - m_minOffset[1]);
+	const dgVector maxY(node.m_maxY - m_maxOffset[1]);
+	const dgVector minZ(node.m_minZ - m_minOffset[2]);
+	const dgVector maxZ(node.m_maxZ - m_maxOffset[2]);
+
+	const dgVector reject((m_isParallel[0] & ((m_p0[0] <= minX) | (m_p0[0] >= maxX))) |
+						  (m_isParallel[1] & ((m_p0[1] <= minY) | (m_p0[1] >= maxY))) |
+						  (m_isParallel[2] & ((m_p0[2] <= minZ) | (m_p0[2] >= maxZ))));
+
+	const dgVector tx0((minX - m_p0[0]).CompProduct4(m_invDir[0]));
+	const dgVector tx1((maxX - m_p0[0]).CompProduct4(m_invDir[0]));
+	const dgVector ty0((minY - m_p0[1]).CompProduct4(m_invDir[1]));
+	const dgVector ty1((maxY - m_p0[1]).CompProduct4(m_invDir[1]));
+	const dgVector tz0((minZ - m_p0[2]).CompProduct4(m_invDir[2]));
+	const dgVector tz1((maxZ - m_p0[2]).CompProduct4(m_invDir[2]));
+
+	const dgVector t0(dgVector::m_zero.GetMax(tx0.GetMin(tx1)).GetMax(ty0.GetMin(ty1)).GetMax(tz0.GetMin(tz1)));
+	const dgVector t1(dgVector::m_one.GetMin(tx0.GetMax(tx1)).GetMin(ty0.GetMax(ty1)).GetMin(tz0.GetMax(tz1)));
+	const dgVector mask((t0 < t1).AndNot(reject));
+	return (t0 & mask) | dgVector(dgFloat32(1.2f)).AndNot(mask);
+}
+
+
+dgBroadPhaseQuad::dgBroadPhaseQuad(dgWorld* const world)
+	:dgBroadPhaseDefault(world)
+	,m_quadNodes(world->GetAllocator(), 64)
+	,m_quadLeaves(world->GetAllocator())
+	,m_quadNodesCount(0)
+	,m_quadLeavesCount(0)
+	,m_quadRevision(0)
+	,m_quadDirty(true)
+{
+	dgAssert(sizeof (dgQuadNode) <= 128);
+}
+
+dgBroadPhaseQuad::~dgBroadPhaseQuad()
+{
+}
+
+dgInt32 dgBroadPhaseQuad::GetType() const
+{
+	return dgWorld::m_quadBroadphase;
+}
+
+void dgBroadPhaseQuad::Add(dgBody* const body)
+{
+	dgBroadPhaseDefault::Add(body);
+	m_quadDirty = true;
+}
+
+void dgBroadPhaseQuad::Remove(dgBody* const body)
+{
+	dgBroadPhaseDefault::Remove(body);
+	m_quadDirty = true;
+}
+
+void dgBroadPhaseQuad::AddBodies(dgBody** const bodies, dgInt32 count)
+{
+	dgBroadPhaseDefault::AddBodies(bodies, count);
+	m_quadDirty = true;
+}
+
+void dgBroadPhaseQuad::DestroyAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgBroadPhaseDefault::DestroyAggregate(aggregate);
+	m_quadDirty = true;
+}
+
+void dgBroadPhaseQuad::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgBroadPhaseDefault::LinkAggregate(aggregate);
+	m_quadDirty = true;
+}
+
+void dgBroadPhaseQuad::UnlinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgBroadPhaseDefault::UnlinkAggregate(aggregate);
+	m_quadDirty = true;
+}
+
+void dgBroadPhaseQuad::UpdateFitness()
+{
+	ImproveFitness(m_fitness, m_treeEntropy, &m_rootNode);
+	// the collapsed tree is still a valid tree after the rotations, so it is only rebuilt
+	// once the rotations have changed a good part of the pointer tree
+	const dgUnsigned32 rotations = m_treeRevision - m_quadRevision;
+	if (!IsValid() || (rotations > dgUnsigned32(m_quadLeavesCount >> 2))) {
+		BuildQuadTree();
+	}
+}
+
+void dgBroadPhaseQuad::InvalidateCache()
+{
+	dgBroadPhaseDefault::InvalidateCache();
+	BuildQuadTree();
+}
+
+void dgBroadPhaseQuad::BuildQuadTree()
+{
+	dTimeTrackerEvent(__FUNCTION__);
+
+	m_quadDirty = false;
+	m_quadNodesCount = 0;
+	m_quadLeavesCount = 0;
+	m_quadRevision = m_treeRevision;
+	if (!m_rootNode) {
+		return;
+	}
+
+	dgBroadPhaseNode* stackPool[DG_QUAD_STACK_DEPTH];
+	dgInt32 parentPool[DG_QUAD_STACK_DEPTH];
+
+	stackPool[0] = m_rootNode;
+	parentPool[0] = -1;
+	dgInt32 stack = 1;
+	while (stack) {
+		stack--;
+		dgBroadPhaseNode* const subTree = stackPool[stack];
+		const dgInt32 parent = parentPool[stack];
+		const dgInt32 index = m_quadNodesCount;
+		m_quadNodesCount++;
+
+		if (parent >= 0) {
+			dgQuadNode& parentNode = m_quadNodes[dgQuadNode::GetIndex(parent)];
+			dgInt32& child = parentNode.m_child[parent & DG_QUAD_NODE_KIND_MASK];
+			child = dgQuadNode::MakeChild(index, dgQuadNode::GetKind(child));
+		} else {
+			// an aggregate at the root has no slot, it can only collide with itself
+			subTree->m_linearIndex = -1;
+		}
+
+		// the children of an aggregate node are the collapse of the aggregate private tree
+		dgBroadPhaseAggregate* aggregate = NULL;
+		dgBroadPhaseNode* root = subTree;
+		if (subTree->IsAggregate()) {
+			aggregate = (dgBroadPhaseAggregate*)subTree;
+			root = aggregate->m_root;
+		}
+
+		// collapse the binary tree, keep opening the largest interior node until there are four children
+		dgBroadPhaseNode* children[4];
+		dgInt32 count = 0;
+		if (root) {
+			children[0] = root;
+			count = 1;
+			while (count < 4) {
+				dgInt32 bestSlot = -1;
+				dgFloat32 bestArea = dgFloat32(-1.0f);
+				for (dgInt32 i = 0; i < count; i++) {
+					const dgBroadPhaseNode* const node = children[i];
+					if (!node->IsLeafNode() && (node->m_surfaceArea > bestArea)) {
+						bestArea = node->m_surfaceArea;
+						bestSlot = i;
+					}
+				}
+				if (bestSlot < 0) {
+					break;
+				}
+				dgBroadPhaseTreeNode* const node = (dgBroadPhaseTreeNode*)children[bestSlot];
+				children[bestSlot] = node->m_right;
+				children[count] = node->m_left;
+				count++;
+			}
+		}
+
+		dgQuadNode& quadNode = m_quadNodes[index];
+		quadNode.m_parent = parent;
+		quadNode.m_aggregate = aggregate;
+		for (dgInt32 i = 0; i < 4; i++) {
+			quadNode.m_child[i] = DG_QUAD_EMPTY_SLOT;
+			quadNode.SetSlotBox(i, dgVector(DG_QUAD_EMPTY_BOX), dgVector(DG_QUAD_EMPTY_BOX));
+		}
+
+		for (dgInt32 i = 0; i < count; i++) {
+			dgBroadPhaseNode* const node = children[i];
+			const dgInt32 slot = dgQuadNode::MakeChild(index, i);
+			if (node->IsAggregate()) {
+				node->m_linearIndex = slot;
+				quadNode.m_child[i] = dgQuadNode::MakeChild(0, m_aggregateSlot);
+				stackPool[stack] = node;
+				parentPool[stack] = slot;
+				stack++;
+				dgAssert(stack < DG_QUAD_STACK_DEPTH);
+			} else if (node->IsLeafNode()) {
+				dgAssert(node->GetBody());
+				node->m_linearIndex = slot;
+				m_quadLeaves[m_quadLeavesCount] = node;
+				quadNode.m_child[i] = dgQuadNode::MakeChild(m_quadLeavesCount, m_bodySlot);
+				quadNode.SetSlotBox(i, node->m_minBox, node->m_maxBox);
+				m_quadLeavesCount++;
+			} else {
+				quadNode.m_child[i] = dgQuadNode::MakeChild(0, m_treeSlot);
+				stackPool[stack] = node;
+				parentPool[stack] = slot;
+				stack++;
+				dgAssert(stack < DG_QUAD_STACK_DEPTH);
+			}
+		}
+	}
+
+	// children always come after their parent, a backward sweep sets the interior bounds bottom up
+	dgQuadNode* const nodes = &m_quadNodes[0];
+	for (dgInt32 i = m_quadNodesCount - 1; i > 0; i--) {
+		const dgQuadNode& node = nodes[i];
+		dgVector minBox;
+		dgVector maxBox;
+		node.GetBox(minBox, maxBox);
+		nodes[dgQuadNode::GetIndex(node.m_parent)].SetSlotBox(node.m_parent & DG_QUAD_NODE_KIND_MASK, minBox, maxBox);
+	}
+}
+
+void dgBroadPhaseQuad::RefitQuadNode(dgInt32 index)
+{
+	dgQuadNode* const nodes = &m_quadNodes[0];
+	for (dgInt32 parent = nodes[index].m_parent; parent >= 0; parent = nodes[index].m_parent) {
+		dgVector minBox;
+		dgVector maxBox;
+		nodes[index].GetBox(minBox, maxBox);
+
+		// same as the pointer tree, stop as soon as a parent still contains its children
+		index = dgQuadNode::GetIndex(parent);
+		const dgInt32 slot = parent & DG_QUAD_NODE_KIND_MASK;
+		dgVector slotMinBox;
+		dgVector slotMaxBox;
+		nodes[index].GetSlotBox(slot, slotMinBox, slotMaxBox);
+		if (dgBoxInclusionTest(minBox, maxBox, slotMinBox, slotMaxBox)) {
+			break;
+		}
+		nodes[index].SetSlotBox(slot, minBox, maxBox);
+	}
+}
+
+void dgBroadPhaseQuad::UpdateLeafBox(dgBroadPhaseNode* const leaf)
+{
+	// called from UpdateBody with the broadphase lock held
+	if (IsValid()) {
+		const dgInt32 slot = leaf->m_linearIndex;
+		const dgInt32 index = dgQuadNode::GetIndex(slot);
+		dgAssert((index >= 0) && (index < m_quadNodesCount));
+		dgQuadNode& node = m_quadNodes[index];
+		dgAssert(dgQuadNode::GetKind(node.m_child[slot & DG_QUAD_NODE_KIND_MASK]) == m_bodySlot);
+		node.SetSlotBox(slot & DG_QUAD_NODE_KIND_MASK, leaf->m_minBox, leaf->m_maxBox);
+		RefitQuadNode(index);
+	}
+}
+
+void dgBroadPhaseQuad::SubmitSlots(dgBroadPhaseNode* const leaf, dgInt32 index, dgInt32 slotMask, dgFloat32 timestep, dgInt32 threadID)
+{
+	dgBody* const body0 = leaf->GetBody();
+	const dgVector& boxP0 = body0 ? body0->m_minAABB : leaf->m_minBox;
+	const dgVector& boxP1 = body0 ? body0->m_maxAABB : leaf->m_maxBox;
+	const dgVector minBox[] = {boxP0.BroadcastX(), boxP0.BroadcastY(), boxP0.BroadcastZ()};
+	const dgVector maxBox[] = {boxP1.BroadcastX(), boxP1.BroadcastY(), boxP1.BroadcastZ()};
+
+	const bool test0 = body0 ? (body0->GetInvMass().m_w != dgFloat32(0.0f)) : true;
+	const dgQuadNode* const nodes = &m_quadNodes[0];
+
+	dgInt32 stackPool[DG_QUAD_STACK_DEPTH];
+	stackPool[0] = index;
+	dgInt32 stack = 1;
+	while (stack) {
+		stack--;
+		const dgQuadNode& node = nodes[stackPool[stack]];
+		dgInt32 mask = node.Overlap(minBox, maxBox) & slotMask;
+		slotMask = 0x0f;
+		for (dgInt32 i = 0; mask; i++, mask >>= 1) {
+			if (mask & 1) {
+				const dgInt32 child = node.m_child[i];
+				const dgInt32 childIndex = dgQuadNode::GetIndex(child);
+				switch (dgQuadNode::GetKind(child))
+				{
+					case m_bodySlot:
+					{
+						dgBody* const body1 = m_quadLeaves[childIndex]->GetBody();
+						if (body0) {
+							if (test0 || (body1->GetInvMass().m_w != dgFloat32(0.0f))) {
+								AddPair(body0, body1, timestep, threadID);
+							}
+						} else {
+							((dgBroadPhaseAggregate*)leaf)->SummitPairs(body1, timestep, threadID);
+						}
+						break;
+					}
+
+					case m_aggregateSlot:
+					{
+						dgBroadPhaseAggregate* const aggregate = nodes[childIndex].m_aggregate;
+						if (body0) {
+							aggregate->SummitPairs(body0, timestep, threadID);
+						} else {
+							((dgBroadPhaseAggregate*)leaf)->SummitPairs(aggregate, timestep, threadID);
+						}
+						break;
+					}
+
+					case m_treeSlot:
+					default:
+					{
+						stackPool[stack] = childIndex;
+						stack++;
+						dgAssert(stack < DG_QUAD_STACK_DEPTH);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhaseQuad::FindCollidingPairsForward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::FindCollidingPairsForward(descriptor, broadPhaseNode, threadID);
+		return;
+	}
+
+	const dgFloat32 timestep = descriptor->m_timestep;
+	if (broadPhaseNode->IsAggregate()) {
+		((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
+	}
+
+	// a pair is found from the leaf in the lower slot of the node where the two paths split
+	const dgQuadNode* const nodes = &m_quadNodes[0];
+	for (dgInt32 slot = broadPhaseNode->m_linearIndex; slot >= 0; ) {
+		const dgInt32 index = dgQuadNode::GetIndex(slot);
+		const dgInt32 slotMask = (0x0f << ((slot & DG_QUAD_NODE_KIND_MASK) + 1)) & 0x0f;
+		if (slotMask) {
+			SubmitSlots(broadPhaseNode, index, slotMask, timestep, threadID);
+		}
+		slot = nodes[index].m_parent;
+	}
+}
+
+void dgBroadPhaseQuad::FindCollidingPairsForwardAndBackward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::FindCollidingPairsForwardAndBackward(descriptor, broadPhaseNode, threadID);
+		return;
+	}
+
+	const dgUnsigned32 lru = m_lru + 1;
+	if (lru == broadPhaseNode->GetDirtyLru()) {
+		const dgFloat32 timestep = descriptor->m_timestep;
+		if (broadPhaseNode->IsAggregate()) {
+			((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
+		}
+
+		const dgQuadNode* const nodes = &m_quadNodes[0];
+		for (dgInt32 slot = broadPhaseNode->m_linearIndex; slot >= 0; ) {
+			const dgInt32 index = dgQuadNode::GetIndex(slot);
+			const dgInt32 slotMask = 0x0f & ~(1 << (slot & DG_QUAD_NODE_KIND_MASK));
+			SubmitSlots(broadPhaseNode, index, slotMask, timestep, threadID);
+			slot = nodes[index].m_parent;
+		}
+	}
+}
+
+void dgBroadPhaseQuad::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::ForEachBodyInAABB(minBox, maxBox, callback, userData);
+		return;
+	}
+
+	const dgVector minSplat[] = {minBox.BroadcastX(), minBox.BroadcastY(), minBox.BroadcastZ()};
+	const dgVector maxSplat[] = {maxBox.BroadcastX(), maxBox.BroadcastY(), maxBox.BroadcastZ()};
+
+	dgInt32 stackPool[DG_QUAD_STACK_DEPTH];
+	stackPool[0] = 0;
+	dgInt32 stack = 1;
+	const dgQuadNode* const nodes = &m_quadNodes[0];
+	while (stack) {
+		stack--;
+		const dgQuadNode& node = nodes[stackPool[stack]];
+		dgInt32 mask = node.Overlap(minSplat, maxSplat);
+		for (dgInt32 i = 0; mask; i++, mask >>= 1) {
+			if (mask & 1) {
+				const dgInt32 child = node.m_child[i];
+				if (dgQuadNode::GetKind(child) == m_bodySlot) {
+					dgBody* const body = m_quadLeaves[dgQuadNode::GetIndex(child)]->GetBody();
+					if (dgOverlapTest(body->m_minAABB, body->m_maxAABB, minBox, maxBox)) {
+						if (!callback(body, userData)) {
+							return;
+						}
+					}
+				} else {
+					stackPool[stack] = dgQuadNode::GetIndex(child);
+					stack++;
+					dgAssert(stack < DG_QUAD_STACK_DEPTH);
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhaseQuad::RayCast(const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	if (!IsValid()) {
+		dgBroadPhaseDefault::RayCast(l0, l1, filter, prefilter, userData);
+		return;
+	}
+
+	if (filter) {
+		dgVector segment(l1 - l0);
+		dgFloat32 dist2 = segment.DotProduct3(segment);
+		if (dist2 > dgFloat32(1.0e-8f)) {
+			dgFloat32 distance[DG_QUAD_STACK_DEPTH];
+			dgInt32 stackPool[DG_QUAD_STACK_DEPTH];
+
+			dgFastRayTest ray(l0, l1);
+			const dgQuadRay quadRay(ray, dgVector::m_zero, dgVector::m_zero);
+			dgLineBox line;
+			line.m_l0 = l0;
+			line.m_l1 = l1;
+			dgVector test(line.m_l0 <= line.m_l1);
+			line.m_boxL0 = (line.m_l0 & test) | line.m_l1.AndNot(test);
+			line.m_boxL1 = (line.m_l1 & test) | line.m_l0.AndNot(test);
+
+			// the stack holds tagged children, the bodies are sorted along with the nodes
+			const dgQuadNode* const nodes = &m_quadNodes[0];
+			stackPool[0] = dgQuadNode::MakeChild(0, m_treeSlot);
+			distance[0] = dgFloat32(0.0f);
+
+			dgInt32 stack = 1;
+			dgFloat32 maxParam = dgFloat32(1.2f);
+			while (stack) {
+				stack--;
+				if (distance[stack] > maxParam) {
+					break;
+				}
+				const dgInt32 child = stackPool[stack];
+				if (dgQuadNode::GetKind(child) == m_bodySlot) {
+					dgBody* const body = m_quadLeaves[dgQuadNode::GetIndex(child)]->GetBody();
+					dgFloat32 param = body->RayCast(line, filter, prefilter, userData, maxParam);
+					if (param < maxParam) {
+						maxParam = param;
+						if (maxParam < dgFloat32(1.0e-8f)) {
+							break;
+						}
+					}
+				} else {
+					const dgQuadNode& node = nodes[dgQuadNode::GetIndex(child)];
+					const dgVector dist(quadRay.BoxIntersect(node));
+					dgInt32 mask = (dist < dgVector(maxParam)).GetSignMask();
+					for (dgInt32 i = 0; mask; i++, mask >>= 1) {
+						if (mask & 1) {
+							stack = dgQuadPushChild(stackPool, distance, stack, node.m_child[i], dist[i]);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+dgInt32 dgBroadPhaseQuad::ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	if (!IsValid()) {
+		return dgBroadPhaseDefault::ConvexCast(shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	dgVector boxP0;
+	dgVector boxP1;
+	dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
+	dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
+	dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
+	dgFloat32 distance[DG_QUAD_STACK_DEPTH];
+	dgInt32 stackPool[DG_QUAD_STACK_DEPTH];
+
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgVector velocA((target - matrix.m_posit) & dgVector::m_triplexMask);
+	dgVector velocB(dgFloat32(0.0f));
+	dgFastRayTest ray(dgVector(dgFloat32(0.0f)), velocA);
+	const dgQuadRay quadRay(ray, boxP0, boxP1);
+
+	const dgQuadNode* const nodes = &m_quadNodes[0];
+	stackPool[0] = dgQuadNode::MakeChild(0, m_treeSlot);
+	distance[0] = dgFloat32(0.0f);
+
+	maxContacts = dgMin(maxContacts, DG_CONVEX_CAST_POOLSIZE);
+	dgAssert(!maxContacts || (maxContacts && info));
+
+	*param = dgFloat32(1.0f);
+	dgInt32 totalCount = 0;
+	dgInt32 stack = 1;
+	dgFloat32 maxParam = *param;
+	dgFloat32 timeToImpact = *param;
+	while (stack) {
+		stack--;
+		if (distance[stack] > maxParam) {
+			break;
+		}
+
+		const dgInt32 child = stackPool[stack];
+		if (dgQuadNode::GetKind(child) == m_bodySlot) {
+			dgBody* const body = m_quadLeaves[dgQuadNode::GetIndex(child)]->GetBody();
+			if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
+				dgInt32 count = m_world->CollideContinue(shape, matrix, velocA, velocB, body->m_collision, body->m_matrix, velocB, velocB, timeToImpact, points, normals, penetration, attributeA, attributeB, maxContacts, threadIndex);
+
+				if (timeToImpact < maxParam) {
+					if ((timeToImpact - maxParam) < dgFloat32(-1.0e-3f)) {
+						totalCount = 0;
+					}
+					maxParam = timeToImpact;
+					if (count >= (maxContacts - totalCount)) {
+						count = maxContacts - totalCount;
+					}
+
+					for (dgInt32 i = 0; i < count; i++) {
+						info[totalCount].m_point[0] = points[i].m_x;
+						info[totalCount].m_point[1] = points[i].m_y;
+						info[totalCount].m_point[2] = points[i].m_z;
+						info[totalCount].m_point[3] = dgFloat32(0.0f);
+						info[totalCount].m_normal[0] = normals[i].m_x;
+						info[totalCount].m_normal[1] = normals[i].m_y;
+						info[totalCount].m_normal[2] = normals[i].m_z;
+						info[totalCount].m_normal[3] = dgFloat32(0.0f);
+						info[totalCount].m_penetration = penetration[i];
+						info[totalCount].m_contaID = attributeB[i];
+						info[totalCount].m_hitBody = body;
+						totalCount++;
+					}
+				}
+				if (maxParam < 1.0e-8f) {
+					break;
+				}
+			}
+		} else {
+			const dgQuadNode& node = nodes[dgQuadNode::GetIndex(child)];
+			const dgVector dist(quadRay.BoxIntersect(node));
+			dgInt32 mask = (dist < dgVector(maxParam)).GetSignMask();
+			for (dgInt32 i = 0; mask; i++, mask >>= 1) {
+				if (mask & 1) {
+					stack = dgQuadPushChild(stackPool, distance, stack, node.m_child[i], dist[i]);
+				}
+			}
+		}
+	}
+	*param = maxParam;
+	return totalCount;
+}
+
+dgInt32 dgBroadPhaseQuad::Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	if (!IsValid()) {
+		return dgBroadPhaseDefault::Collide(shape, matrix, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	dgVector boxP0;
+	dgVector boxP1;
+	dgTriplex points[DG_CONVEX_CAST_POOLSIZE];
+	dgTriplex normals[DG_CONVEX_CAST_POOLSIZE];
+	dgFloat32 penetration[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeA[DG_CONVEX_CAST_POOLSIZE];
+	dgInt64 attributeB[DG_CONVEX_CAST_POOLSIZE];
+	dgInt32 stackPool[DG_QUAD_STACK_DEPTH];
+
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+	const dgVector minSplat[] = {boxP0.BroadcastX(), boxP0.BroadcastY(), boxP0.BroadcastZ()};
+	const dgVector maxSplat[] = {boxP1.BroadcastX(), boxP1.BroadcastY(), boxP1.BroadcastZ()};
+
+	dgInt32 totalCount = 0;
+	stackPool[0] = 0;
+	dgInt32 stack = 1;
+	const dgQuadNode* const nodes = &m_quadNodes[0];
+	while (stack) {
+		stack--;
+		const dgQuadNode& node = nodes[stackPool[stack]];
+		dgInt32 mask = node.Overlap(minSplat, maxSplat);
+		for (dgInt32 i = 0; mask; i++, mask >>= 1) {
+			if (mask & 1) {
+				const dgInt32 child = node.m_child[i];
+				if (dgQuadNode::GetKind(child) != m_bodySlot) {
+					stackPool[stack] = dgQuadNode::GetIndex(child);
+					stack++;
+					dgAssert(stack < DG_QUAD_STACK_DEPTH);
+					continue;
+				}
+
+				dgBody* const body = m_quadLeaves[dgQuadNode::GetIndex(child)]->GetBody();
+				if (!PREFILTER_RAYCAST(prefilter, body, body->m_collision, userData)) {
+					dgInt32 count = m_world->Collide(shape, matrix, body->m_collision, body->m_matrix, points, normals, penetration, attributeA, attributeB, DG_CONVEX_CAST_POOLSIZE, threadIndex);
+
+					if (count) {
+						bool teminate = false;
+						if (count >= (maxContacts - totalCount)) {
+							count = maxContacts - totalCount;
+							teminate = true;
+						}
+
+						for (dgInt32 j = 0; j < count; j++) {
+							info[totalCount].m_point[0] = points[j].m_x;
+							info[totalCount].m_point[1] = points[j].m_y;
+							info[totalCount].m_point[2] = points[j].m_z;
+							info[totalCount].m_point[3] = dgFloat32(0.0f);
+							info[totalCount].m_normal[0] = normals[j].m_x;
+							info[totalCount].m_normal[1] = normals[j].m_y;
+							info[totalCount].m_normal[2] = normals[j].m_z;
+							info[totalCount].m_normal[3] = dgFloat32(0.0f);
+							info[totalCount].m_penetration = penetration[j];
+							info[totalCount].m_contaID = attributeB[j];
+							info[totalCount].m_hitBody = body;
+							totalCount++;
+						}
+
+						if (teminate) {
+							return totalCount;
+						}
+					}
+				}
+			}
+		}
+	}
+	return totalCount;
+}
@@ -0,0 +1,144 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __AFX_BROADPHASE_QUAD_H_
+#define __AFX_BROADPHASE_QUAD_H_
+
+#include "dgPhysicsStdafx.h"
+#include "dgBroadPhaseDefault.h"
+
+#define DG_QUAD_NODE_KIND_MASK	3
+#define DG_QUAD_NODE_KIND_BITS	2
+#define DG_QUAD_EMPTY_SLOT		-1
+#define DG_QUAD_STACK_DEPTH		(DG_BROADPHASE_MAX_STACK_DEPTH * 2)
+
+// same tree as the default broadphase, but all traversals run on a 4-ary collapse of it.
+// each node keeps the bounds of its four children in SoA form, so that a ray or a box
+// is tested against all four children with one sequence of simd instructions.
+class dgBroadPhaseQuad: public dgBroadPhaseDefault
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator);
+
+	dgBroadPhaseQuad(dgWorld* const world);
+	virtual ~dgBroadPhaseQuad();
+
+	protected:
+	enum dgSlotKind
+	{
+		m_treeSlot,
+		m_bodySlot,
+		m_aggregateSlot,
+	};
+
+	class dgQuadNode
+	{
+		public:
+		DG_INLINE static dgInt32 GetKind(dgInt32 child)
+		{
+			return child & DG_QUAD_NODE_KIND_MASK;
+		}
+
+		DG_INLINE static dgInt32 GetIndex(dgInt32 child)
+		{
+			return child >> DG_QUAD_NODE_KIND_BITS;
+		}
+
+		DG_INLINE static dgInt32 MakeChild(dgInt32 index, dgInt32 kind)
+		{
+			return (index << DG_QUAD_NODE_KIND_BITS) | kind;
+		}
+
+		DG_INLINE dgInt32 Overlap(const dgVector* const minBox, const dgVector* const maxBox) const
+		{
+			const dgVector test((m_minX < maxBox[0]) & (m_maxX > minBox[0]) &
+								(m_minY < maxBox[1]) & (m_maxY > minBox[1]) &
+								(m_minZ < maxBox[2]) & (m_maxZ > minBox[2]));
+			return test.GetSignMask();
+		}
+
+		void GetSlotBox(dgInt32 slot, dgVector& minBox, dgVector& maxBox) const;
+		void SetSlotBox(dgInt32 slot, const dgVector& minBox, const dgVector& maxBox);
+		void GetBox(dgVector& minBox, dgVector& maxBox) const;
+
+		dgVector m_minX;
+		dgVector m_minY;
+		dgVector m_minZ;
+		dgVector m_maxX;
+		dgVector m_maxY;
+		dgVector m_maxZ;
+		dgInt32 m_child[4];
+		dgInt32 m_parent;
+		dgBroadPhaseAggregate* m_aggregate;
+	};
+
+	// a ray, or a box swept along a ray, splat across the four lanes of a node
+	class dgQuadRay
+	{
+		public:
+		dgQuadRay(const dgFastRayTest& ray, const dgVector& boxP0, const dgVector& boxP1);
+		DG_INLINE dgVector BoxIntersect(const dgQuadNode& node) const;
+
+		dgVector m_p0[3];
+		dgVector m_invDir[3];
+		dgVector m_isParallel[3];
+		dgVector m_minOffset[3];
+		dgVector m_maxOffset[3];
+	};
+
+	virtual dgInt32 GetType() const;
+	virtual void Add(dgBody* const body);
+	virtual void Remove(dgBody* const body);
+	virtual void AddBodies(dgBody** const bodies, dgInt32 count);
+	virtual void UpdateFitness();
+	virtual void InvalidateCache();
+	virtual void DestroyAggregate(dgBroadPhaseAggregate* const aggregate);
+
+	virtual void LinkAggregate (dgBroadPhaseAggregate* const aggregate);
+	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate);
+	virtual void UpdateLeafBox (dgBroadPhaseNode* const leaf);
+	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+
+	virtual void RayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	virtual dgInt32 Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	virtual dgInt32 ConvexCast (dgCollisionInstance* const shape, const dgMatrix& p0, const dgVector& p1, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	virtual void ForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+
+	void BuildQuadTree();
+	void RefitQuadNode(dgInt32 index);
+	void SubmitSlots(dgBroadPhaseNode* const leaf, dgInt32 index, dgInt32 slotMask, dgFloat32 timestep, dgInt32 threadID);
+
+	DG_INLINE bool IsValid() const
+	{
+		return m_quadNodesCount && !m_quadDirty;
+	}
+
+	dgArray<dgQuadNode> m_quadNodes;
+	dgArray<dgBroadPhaseNode*> m_quadLeaves;
+	dgInt32 m_quadNodesCount;
+	dgInt32 m_quadLeavesCount;
+	dgUnsigned32 m_quadRevision;
+	bool m_quadDirty;
+};
+
+
+#endif
@@ -0,0 +1,323 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgBroadPhase.h"
+#include "dgCollisionBVH.h"
+#include "dgCollisionInstance.h"
+#include "dgBroadPhaseAggregate.h"
+
+#define DG_RAY_BATCH_PACKET_SIZE		4
+#define DG_RAY_BATCH_GRAIN_SIZE			8
+#define DG_RAY_BATCH_QUANTIZE_BITS		9
+
+
+class dgRayCastBatchKey
+{
+	public:
+	dgInt32 m_key;
+	dgInt32 m_index;
+};
+
+class dgBroadPhase::dgRayCastBatchDescriptor
+{
+	public:
+	const dgBroadPhase* m_broadPhase;
+	const dgFloat32* m_p0;
+	const dgFloat32* m_p1;
+	const dgRayCastBatchKey* m_sortedRays;
+	dgRayCastReturnInfo* m_info;
+	OnRayPrecastAction m_prefilter;
+	void* m_userData;
+	dgInt32 m_stride;
+	dgInt32 m_count;
+	bool m_anyHit;
+};
+
+
+DG_INLINE static dgInt32 dgRayBatchSpreadBits (dgInt32 x)
+{
+	// insert two zero bits between each of the low nine bits of x
+	dgUnsigned32 code = dgUnsigned32 (x) & 0x1ff;
+	code = (code | (code << 16)) & 0x030000ff;
+	code = (code | (code << 8)) & 0x0300f00f;
+	code = (code | (code << 4)) & 0x030c30c3;
+	code = (code | (code << 2)) & 0x09249249;
+	return dgInt32 (code);
+}
+
+static dgInt32 dgRayBatchGetKey (const dgRayCastBatchKey* const key, void* const context)
+{
+	return key->m_key;
+}
+
+
+dgInt32 dgBroadPhase::RayCastBatch (const dgFloat32* const p0, const dgFloat32* const p1, dgInt32 strideInBytes, dgInt32 count, dgRayCastReturnInfo* const info, bool anyHit, OnRayPrecastAction prefilter, void* const userData) const
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	if (count <= 0) {
+		return 0;
+	}
+
+	const dgInt32 stride = strideInBytes / sizeof (dgFloat32);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgRayCastReturnInfo& hit = info[i];
+		hit.m_hitBody = NULL;
+		hit.m_intersectParam = dgFloat32 (1.0f);
+	}
+
+	if (!m_rootNode) {
+		return 0;
+	}
+
+	// sort the rays by direction octant and by the morton code of their origin, so that the rays
+	// of each packet are coherent and neighbor packets run on the same parts of the tree
+	dgVector minBox (dgFloat32 (1.0e15f));
+	dgVector maxBox (dgFloat32 (-1.0e15f));
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgFloat32* const q = &p0[i * stride];
+		const dgVector q0 (q[0], q[1], q[2], dgFloat32 (0.0f));
+		minBox = minBox.GetMin(q0);
+		maxBox = maxBox.GetMax(q0);
+	}
+	const dgFloat32 range = dgFloat32 ((1 << DG_RAY_BATCH_QUANTIZE_BITS) - 1);
+	const dgVector size (maxBox - minBox);
+	const dgVector scale (((dgVector (range).CompProduct4(size.Reciproc())) & (size > dgVector (dgFloat32 (1.0e-6f)))) & dgVector::m_triplexMask);
+
+	dgStack<dgRayCastBatchKey> keys (count);
+	dgStack<dgRayCastBatchKey> tmpKeys (count);
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgVector q0 (p0[i * stride + 0], p0[i * stride + 1], p0[i * stride + 2], dgFloat32 (0.0f));
+		const dgVector q1 (p1[i * stride + 0], p1[i * stride + 1], p1[i * stride + 2], dgFloat32 (0.0f));
+		const dgVector cell ((q0 - minBox).CompProduct4(scale));
+		const dgInt32 octant = (q1 - q0).GetSignMask() & 0x07;
+		const dgInt32 morton = dgRayBatchSpreadBits (dgInt32 (cell.m_x)) | (dgRayBatchSpreadBits (dgInt32 (cell.m_y)) << 1) | (dgRayBatchSpreadBits (dgInt32 (cell.m_z)) << 2);
+		keys[i].m_key = (octant << (3 * DG_RAY_BATCH_QUANTIZE_BITS)) | morton;
+		keys[i].m_index = i;
+	}
+	dgRadixSort (&keys[0], &tmpKeys[0], count, 4, dgRayBatchGetKey);
+
+	dgRayCastBatchDescriptor descriptor;
+	descriptor.m_broadPhase = this;
+	descriptor.m_p0 = p0;
+	descriptor.m_p1 = p1;
+	descriptor.m_sortedRays = &keys[0];
+	descriptor.m_info = info;
+	descriptor.m_prefilter = prefilter;
+	descriptor.m_userData = userData;
+	descriptor.m_stride = stride;
+	descriptor.m_count = count;
+	descriptor.m_anyHit = anyHit;
+
+	const dgInt32 packetsCount = (count + DG_RAY_BATCH_PACKET_SIZE - 1) / DG_RAY_BATCH_PACKET_SIZE;
+	m_world->ParallelFor (packetsCount, RayCastBatchKernel, &descriptor, DG_RAY_BATCH_GRAIN_SIZE);
+
+	dgInt32 hitCount = 0;
+	for (dgInt32 i = 0; i < count; i ++) {
+		hitCount += info[i].m_hitBody ? 1 : 0;
+	}
+	return hitCount;
+}
+
+
+void dgBroadPhase::RayCastBatchKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	const dgRayCastBatchDescriptor* const descriptor = (dgRayCastBatchDescriptor*) context;
+	const dgBroadPhase* const broadPhase = descriptor->m_broadPhase;
+	for (dgInt32 i = start; i < end; i ++) {
+		const dgInt32 first = i * DG_RAY_BATCH_PACKET_SIZE;
+		const dgInt32 count = dgMin (descriptor->m_count - first, DG_RAY_BATCH_PACKET_SIZE);
+		dgInt32 rayIndex[DG_RAY_BATCH_PACKET_SIZE];
+		for (dgInt32 j = 0; j < count; j ++) {
+			rayIndex[j] = descriptor->m_sortedRays[first + j].m_index;
+		}
+		broadPhase->RayCastPacket (descriptor, rayIndex, count);
+	}
+}
+
+
+void dgBroadPhase::RayCastPacket (const dgRayCastBatchDescriptor* const descriptor, const dgInt32* const rayIndex, dgInt32 count) const
+{
+	const dgInt32 stride = descriptor->m_stride;
+	dgVector q0[DG_RAY_BATCH_PACKET_SIZE];
+	dgVector q1[DG_RAY_BATCH_PACKET_SIZE];
+	for (dgInt32 i = 0; i < DG_RAY_BATCH_PACKET_SIZE; i ++) {
+		const dgFloat32* const p0 = &descriptor->m_p0[rayIndex[dgMin (i, count - 1)] * stride];
+		const dgFloat32* const p1 = &descriptor->m_p1[rayIndex[dgMin (i, count - 1)] * stride];
+		q0[i] = dgVector (p0[0], p0[1], p0[2], dgFloat32 (0.0f));
+		q1[i] = dgVector (p1[0], p1[1], p1[2], dgFloat32 (0.0f));
+	}
+
+	const dgFastRayTest rays[] = {dgFastRayTest (q0[0], q1[0]), dgFastRayTest (q0[1], q1[1]), dgFastRayTest (q0[2], q1[2]), dgFastRayTest (q0[3], q1[3])};
+	const dgFastRayTest* const rayArray[] = {&rays[0], &rays[1], &rays[2], &rays[3]};
+	const dgFastRayPacket packet (rayArray, DG_RAY_BATCH_PACKET_SIZE);
+
+	// a lane with a zero max param is inactive, that is how padding and degenerated rays are skipped
+	dgVector maxParam (dgFloat32 (0.0f));
+	for (dgInt32 i = 0; i < count; i ++) {
+		if (rays[i].m_diff.DotProduct3(rays[i].m_diff) > dgFloat32 (1.0e-8f)) {
+			maxParam[i] = dgFloat32 (1.2f);
+		}
+	}
+
+	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	dgVector distance[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+	stackPool[0] = m_rootNode;
+	distance[0] = dgVector (dgFloat32 (0.0f));
+	dgInt32 stack = 1;
+	while (stack) {
+		stack --;
+		const dgVector dist (distance[stack]);
+		const dgInt32 mask = (dist < maxParam).GetSignMask();
+		if (!mask) {
+			continue;
+		}
+
+		const dgBroadPhaseNode* const me = stackPool[stack];
+		dgAssert (me);
+		if (me->GetBody()) {
+			RayCastPacketBody (descriptor, me->GetBody(), rayArray, rayIndex, maxParam, mask);
+		} else if (me->IsAggregate()) {
+			const dgBroadPhaseNode* const child = ((dgBroadPhaseAggregate*)me)->m_root;
+			if (child) {
+				const dgVector dist1 (packet.BoxIntersect(child->m_minBox, child->m_maxBox));
+				if ((dist1 < maxParam).GetSignMask()) {
+					stackPool[stack] = child;
+					distance[stack] = dist1;
+					stack++;
+					dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+				}
+			}
+		} else {
+			const dgBroadPhaseNode* nodes[2];
+			dgVector nodeDist[2];
+			dgInt32 nodeCount = 0;
+			const dgBroadPhaseNode* const children[] = {me->GetRight(), me->GetLeft()};
+			for (dgInt32 i = 0; i < 2; i ++) {
+				const dgBroadPhaseNode* const child = children[i];
+				if (child) {
+					const dgVector dist1 (packet.BoxIntersect(child->m_minBox, child->m_maxBox));
+					if ((dist1 < maxParam).GetSignMask()) {
+						nodes[nodeCount] = child;
+						nodeDist[nodeCount] = dist1;
+						nodeCount ++;
+					}
+				}
+			}
+
+			// push the farther child first, so that the rays visit the nearest one next
+			if ((nodeCount == 2) && (nodeDist[0].GetMin(maxParam).AddHorizontal().GetScalar() < nodeDist[1].GetMin(maxParam).AddHorizontal().GetScalar())) {
+				dgSwap (nodes[0], nodes[1]);
+				dgSwap (nodeDist[0], nodeDist[1]);
+			}
+			for (dgInt32 i = 0; i < nodeCount; i ++) {
+				stackPool[stack] = nodes[i];
+				distance[stack] = nodeDist[i];
+				stack++;
+				dgAssert(stack < DG_BROADPHASE_MAX_STACK_DEPTH);
+			}
+		}
+	}
+}
+
+
+void dgBroadPhase::RayCastPacketBody (const dgRayCastBatchDescriptor* const descriptor, dgBody* const body, const dgFastRayTest* const* const rays, const dgInt32* const rayIndex, dgVector& maxParam, dgInt32 mask) const
+{
+	// same as dgBody::RayCast, but the rays that reach a static mesh go down its tree as one packet
+	dgVector localP0[DG_RAY_BATCH_PACKET_SIZE];
+	dgVector localP1[DG_RAY_BATCH_PACKET_SIZE];
+	dgInt32 lanes[DG_RAY_BATCH_PACKET_SIZE];
+
+	dgInt32 count = 0;
+	const dgCollisionInstance* const collision = body->m_collision;
+	const dgMatrix& globalMatrix = collision->GetGlobalMatrix();
+	for (dgInt32 i = 0; mask; i ++, mask >>= 1) {
+		if (mask & 1) {
+			const dgFastRayTest& ray = *rays[i];
+			dgVector l0 (ray.m_p0);
+			dgVector l1 (ray.m_p0 + ray.m_diff.Scale4 (dgMin(maxParam[i], dgFloat32 (1.0f))));
+			if (dgRayBoxClip (l0, l1, body->m_minAABB, body->m_maxAABB)) {
+				const dgVector p0 (globalMatrix.UntransformVector (l0));
+				const dgVector p1 (globalMatrix.UntransformVector (l1));
+				const dgVector p1p0 (p1 - p0);
+				if (p1p0.DotProduct3(p1p0) > dgFloat32 (1.0e-12f)) {
+					localP0[count] = p0;
+					localP1[count] = p1;
+					lanes[count] = i;
+					count ++;
+				}
+			}
+		}
+	}
+	if (!count) {
+		return;
+	}
+
+	dgFloat32 param[DG_RAY_BATCH_PACKET_SIZE];
+	dgContactPoint contactOut[DG_RAY_BATCH_PACKET_SIZE];
+	const dgCollision* const shape = collision->GetChildShape();
+	if ((count > 1) && (collision->GetScaleType() == dgCollisionInstance::m_unit) && shape->IsType(dgCollision::dgCollisionBVH_RTTI) && !((dgCollisionBVH*)shape)->GetDebugRayCastCallback()) {
+		if (PREFILTER_RAYCAST(descriptor->m_prefilter, body, collision, descriptor->m_userData)) {
+			return;
+		}
+		for (dgInt32 i = 0; i < count; i ++) {
+			param[i] = dgFloat32 (1.0f);
+		}
+		((dgCollisionBVH*)shape)->RayCastPacket (localP0, localP1, count, param, contactOut, descriptor->m_userData);
+	} else {
+		for (dgInt32 i = 0; i < count; i ++) {
+			param[i] = collision->RayCast (localP0[i], localP1[i], dgFloat32 (1.0f), contactOut[i], descriptor->m_prefilter, body, descriptor->m_userData);
+		}
+	}
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		if (param[i] < dgFloat32 (1.0f)) {
+			const dgInt32 lane = lanes[i];
+			const dgFastRayTest& ray = *rays[lane];
+			const dgVector p (globalMatrix.TransformVector(localP0[i] + (localP1[i] - localP0[i]).Scale3(param[i])));
+			const dgFloat32 t = ray.m_diff.DotProduct3(p - ray.m_p0) / ray.m_diff.DotProduct3(ray.m_diff);
+			if (t < maxParam[lane]) {
+				dgAssert (t >= dgFloat32 (0.0f));
+				dgAssert (t <= dgFloat32 (1.0f));
+				const dgVector normal (globalMatrix.RotateVector (contactOut[i].m_normal));
+				dgRayCastReturnInfo& hit = descriptor->m_info[rayIndex[lane]];
+				hit.m_point[0] = p.m_x;
+				hit.m_point[1] = p.m_y;
+				hit.m_point[2] = p.m_z;
+				hit.m_point[3] = dgFloat32 (0.0f);
+				hit.m_normal[0] = normal.m_x;
+				hit.m_normal[1] = normal.m_y;
+				hit.m_normal[2] = normal.m_z;
+				hit.m_normal[3] = dgFloat32 (0.0f);
+				hit.m_contaID = contactOut[i].m_shapeId0;
+				hit.m_hitBody = body;
+				hit.m_intersectParam = t;
+
+				// an any hit ray is done at the first intersection
+				maxParam[lane] = descriptor->m_anyHit ? dgFloat32 (0.0f) : t;
+			}
+		}
+	}
+}
@@ -0,0 +1,873 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgCollisionInstance.h"
+#include "dgBroadPhaseSweepAndPrune.h"
+#include "dgBroadPhaseAggregate.h"
+
+#define DG_SWEEP_AND_PRUNE_SORT_GRAIN_SIZE	4
+
+
+DG_INLINE static dgInt64 dgSweepAndPruneRegionKey (dgInt32 x, dgInt32 z)
+{
+	return (dgInt64 (x) << 32) + dgInt64 (dgUnsigned32 (z));
+}
+
+// narrows [t0, t1] to the part of the sweep where the interval [a0, a1] moving at velocity v touches [b0, b1]
+DG_INLINE static void dgSweepAndPruneClip (dgFloat32 a0, dgFloat32 a1, dgFloat32 v, dgFloat32 b0, dgFloat32 b1, dgFloat32& t0, dgFloat32& t1)
+{
+	if (dgAbsf (v) < dgFloat32 (1.0e-8f)) {
+		if ((a0 > b1) || (a1 < b0)) {
+			t0 = dgFloat32 (1.0f);
+			t1 = dgFloat32 (0.0f);
+		}
+	} else {
+		const dgFloat32 invV = dgFloat32 (1.0f) / v;
+		const dgFloat32 ta = (b0 - a1) * invV;
+		const dgFloat32 tb = (b1 - a0) * invV;
+		t0 = dgMax (t0, dgMin (ta, tb));
+		t1 = dgMin (t1, dgMax (ta, tb));
+	}
+}
+
+DG_INLINE static dgInt32 dgSweepAndPrunePushNode (const dgBroadPhaseNode** const stackPool, dgFloat32* const distance, dgInt32 stack, const dgBroadPhaseNode* const node, dgFloat32 dist)
+{
+	dgInt32 j = stack;
+	for (; j && (dist > distance[j - 1]); j--) {
+		stackPool[j] = stackPool[j - 1];
+		distance[j] = distance[j - 1];
+	}
+	stackPool[j] = node;
+	distance[j] = dist;
+	return stack + 1;
+}
+
+
+dgBroadPhaseSweepAndPrune::dgRegion::dgRegion(dgMemoryAllocator* const allocator, dgInt32 x, dgInt32 z)
+	:m_entries(allocator)
+	,m_maxWidth(dgFloat32 (0.0f))
+	,m_count(0)
+	,m_x(x)
+	,m_z(z)
+	,m_sorted(true)
+	,m_dirty(false)
+{
+}
+
+dgInt32 dgBroadPhaseSweepAndPrune::dgRegion::LowerBound(dgFloat32 minX) const
+{
+	// first entry with m_minX >= minX
+	dgAssert (m_sorted);
+	const dgEntry* const entries = &m_entries[0];
+	dgInt32 i0 = 0;
+	dgInt32 i1 = m_count;
+	while (i0 < i1) {
+		const dgInt32 mid = (i0 + i1) >> 1;
+		if (entries[mid].m_minX < minX) {
+			i0 = mid + 1;
+		} else {
+			i1 = mid;
+		}
+	}
+	return i0;
+}
+
+dgInt32 dgBroadPhaseSweepAndPrune::dgRegion::Find(const dgBroadPhaseNode* const node, dgFloat32 minX) const
+{
+	const dgEntry* const entries = &m_entries[0];
+	if (m_sorted) {
+		for (dgInt32 i = LowerBound(minX); (i < m_count) && (entries[i].m_minX == minX); i ++) {
+			if (entries[i].m_node == node) {
+				return i;
+			}
+		}
+	} else {
+		for (dgInt32 i = 0; i < m_count; i ++) {
+			if (entries[i].m_node == node) {
+				return i;
+			}
+		}
+	}
+	dgAssert (0);
+	return -1;
+}
+
+void dgBroadPhaseSweepAndPrune::dgRegion::Sort()
+{
+	// the entries move very little from one frame to the next, insertion sort is close to linear
+	dgEntry* const entries = &m_entries[0];
+	dgFloat32 maxWidth = dgFloat32 (0.0f);
+	for (dgInt32 i = 0; i < m_count; i ++) {
+		const dgEntry entry (entries[i]);
+		dgInt32 j = i;
+		for (; j && (entries[j - 1].m_minX > entry.m_minX); j --) {
+			entries[j] = entries[j - 1];
+		}
+		entries[j] = entry;
+		maxWidth = dgMax (maxWidth, entry.m_maxX - entry.m_minX);
+	}
+	m_maxWidth = maxWidth;
+	m_sorted = true;
+}
+
+
+dgBroadPhaseSweepAndPrune::dgBroadPhaseSweepAndPrune(dgWorld* const world)
+	:dgBroadPhaseDefault(world)
+	,m_regions(world->GetAllocator())
+	,m_proxies(world->GetAllocator())
+	,m_oversized(world->GetAllocator())
+	,m_dirtyRegions(world->GetAllocator())
+	,m_invRegionSize(dgFloat32 (1.0f) / DG_SWEEP_AND_PRUNE_REGION_SIZE)
+	,m_proxiesCount(0)
+	,m_oversizedCount(0)
+	,m_dirtyRegionsCount(0)
+{
+}
+
+dgBroadPhaseSweepAndPrune::~dgBroadPhaseSweepAndPrune()
+{
+	dgTree<dgRegion*, dgInt64>::Iterator iter (m_regions);
+	for (iter.Begin(); iter; iter ++) {
+		delete iter.GetNode()->GetInfo();
+	}
+}
+
+dgInt32 dgBroadPhaseSweepAndPrune::GetType() const
+{
+	return dgWorld::m_sweepAndPruneBroadphase;
+}
+
+void dgBroadPhaseSweepAndPrune::Add(dgBody* const body)
+{
+	dgBroadPhaseDefault::Add(body);
+	dgBroadPhaseNode* const node = body->GetBroadPhase();
+	AddProxy(node, node->m_minBox, node->m_maxBox);
+}
+
+void dgBroadPhaseSweepAndPrune::AddBodies(dgBody** const bodies, dgInt32 count)
+{
+	dgBroadPhaseDefault::AddBodies(bodies, count);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBroadPhaseNode* const node = bodies[i]->GetBroadPhase();
+		AddProxy(node, node->m_minBox, node->m_maxBox);
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::Remove(dgBody* const body)
+{
+	// bodies inside an aggregate are covered by the aggregate proxy
+	if (body->GetBroadPhase() && !body->GetBroadPhaseAggregate()) {
+		RemoveProxy(body->GetBroadPhase());
+	}
+	dgBroadPhaseDefault::Remove(body);
+}
+
+void dgBroadPhaseSweepAndPrune::DestroyAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	RemoveProxy(aggregate);
+	dgBroadPhaseDefault::DestroyAggregate(aggregate);
+}
+
+void dgBroadPhaseSweepAndPrune::LinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	dgBroadPhaseDefault::LinkAggregate(aggregate);
+	AddProxy(aggregate, aggregate->m_minBox, aggregate->m_maxBox);
+}
+
+void dgBroadPhaseSweepAndPrune::UnlinkAggregate(dgBroadPhaseAggregate* const aggregate)
+{
+	RemoveProxy(aggregate);
+	dgBroadPhaseDefault::UnlinkAggregate(aggregate);
+}
+
+void dgBroadPhaseSweepAndPrune::UpdateFitness()
+{
+	// the pointer tree still gets its rotations, the fall back queries and the batched ray casts traverse it.
+	// the aggregate proxies may have grown while their bodies moved, they are set back to the aggregate box
+	ImproveFitness(m_fitness, m_treeEntropy, &m_rootNode);
+	for (dgList<dgBroadPhaseAggregate*>::dgListNode* node = m_aggregateList.GetFirst(); node; node = node->GetNext()) {
+		dgBroadPhaseAggregate* const aggregate = node->GetInfo();
+		const dgInt32 index = aggregate->m_linearIndex;
+		if ((index >= 0) && (index < m_proxiesCount) && (m_proxies[index].m_node == aggregate)) {
+			const dgProxy& proxy = m_proxies[index];
+			const dgVector mask ((proxy.m_minBox == aggregate->m_minBox) & (proxy.m_maxBox == aggregate->m_maxBox));
+			if ((mask.GetSignMask() & 0x07) != 0x07) {
+				MoveProxy(aggregate, aggregate->m_minBox, aggregate->m_maxBox);
+			}
+		}
+	}
+	SortRegions();
+}
+
+void dgBroadPhaseSweepAndPrune::InvalidateCache()
+{
+	dgBroadPhaseDefault::InvalidateCache();
+	UpdateFitness();
+}
+
+void dgBroadPhaseSweepAndPrune::GetCells(const dgVector& minBox, const dgVector& maxBox, dgInt32& x0, dgInt32& z0, dgInt32& x1, dgInt32& z1) const
+{
+	const dgFloat32 maxCell = dgFloat32 (DG_SWEEP_AND_PRUNE_MAX_CELL);
+	x0 = dgInt32 (dgFloor (dgClamp (minBox.m_x * m_invRegionSize, -maxCell, maxCell)));
+	z0 = dgInt32 (dgFloor (dgClamp (minBox.m_z * m_invRegionSize, -maxCell, maxCell)));
+	x1 = dgInt32 (dgFloor (dgClamp (maxBox.m_x * m_invRegionSize, -maxCell, maxCell)));
+	z1 = dgInt32 (dgFloor (dgClamp (maxBox.m_z * m_invRegionSize, -maxCell, maxCell)));
+}
+
+dgBroadPhaseSweepAndPrune::dgRegion* dgBroadPhaseSweepAndPrune::GetRegion(dgInt32 x, dgInt32 z) const
+{
+	dgTree<dgRegion*, dgInt64>::dgTreeNode* const node = m_regions.Find(dgSweepAndPruneRegionKey(x, z));
+	return node ? node->GetInfo() : NULL;
+}
+
+dgBroadPhaseSweepAndPrune::dgRegion* dgBroadPhaseSweepAndPrune::GetProxyRegion(const dgProxy& proxy, dgInt32 x, dgInt32 z) const
+{
+	// the region of the proxy first cell is cached, most proxies touch only that one
+	return ((x == proxy.m_x0) && (z == proxy.m_z0)) ? proxy.m_region : GetRegion(x, z);
+}
+
+void dgBroadPhaseSweepAndPrune::MarkDirty(dgRegion* const region)
+{
+	if (!region->m_dirty) {
+		region->m_dirty = true;
+		m_dirtyRegions[m_dirtyRegionsCount] = region;
+		m_dirtyRegionsCount ++;
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::SetEntry(dgEntry& entry, const dgProxy& proxy) const
+{
+	entry.m_minX = proxy.m_minBox.m_x;
+	entry.m_minY = proxy.m_minBox.m_y;
+	entry.m_minZ = proxy.m_minBox.m_z;
+	entry.m_maxX = proxy.m_maxBox.m_x;
+	entry.m_maxY = proxy.m_maxBox.m_y;
+	entry.m_maxZ = proxy.m_maxBox.m_z;
+	entry.m_cellX = proxy.m_x0;
+	entry.m_cellZ = proxy.m_z0;
+	entry.m_node = proxy.m_node;
+}
+
+dgBroadPhaseSweepAndPrune::dgRegion* dgBroadPhaseSweepAndPrune::AddEntry(dgProxy& proxy, dgInt32 x, dgInt32 z)
+{
+	dgRegion* region = GetRegion(x, z);
+	if (!region) {
+		region = new (m_world->GetAllocator()) dgRegion(m_world->GetAllocator(), x, z);
+		m_regions.Insert(region, dgSweepAndPruneRegionKey(x, z));
+	}
+
+	// new entries go to the end of the list, the region is sorted again before the next scan
+	SetEntry(region->m_entries[region->m_count], proxy);
+	region->m_count ++;
+	region->m_sorted = (region->m_count == 1);
+	region->m_maxWidth = dgMax (region->m_maxWidth, proxy.m_maxBox.m_x - proxy.m_minBox.m_x);
+	MarkDirty(region);
+	return region;
+}
+
+void dgBroadPhaseSweepAndPrune::RemoveEntry(dgProxy& proxy, dgRegion* const region)
+{
+	dgAssert (region);
+	const dgInt32 index = region->Find(proxy.m_node, proxy.m_minBox.m_x);
+	dgAssert (index >= 0);
+	dgEntry* const entries = &region->m_entries[0];
+	region->m_count --;
+	if (region->m_sorted) {
+		for (dgInt32 i = index; i < region->m_count; i ++) {
+			entries[i] = entries[i + 1];
+		}
+	} else {
+		entries[index] = entries[region->m_count];
+	}
+
+	// empty regions are only deleted by the next update, so that the dirty list never points to a deleted region
+	if (!region->m_count) {
+		MarkDirty(region);
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::UpdateEntry(dgProxy& proxy, dgFloat32 oldMinX, dgRegion* const region)
+{
+	dgAssert (region);
+	const dgInt32 index = region->Find(proxy.m_node, oldMinX);
+	dgAssert (index >= 0);
+	dgEntry* const entries = &region->m_entries[0];
+	dgEntry& entry = entries[index];
+	SetEntry(entry, proxy);
+	region->m_maxWidth = dgMax (region->m_maxWidth, entry.m_maxX - entry.m_minX);
+
+	if (region->m_sorted) {
+		const bool sorted = ((index == 0) || (entries[index - 1].m_minX <= entry.m_minX)) && ((index == (region->m_count - 1)) || (entries[index + 1].m_minX >= entry.m_minX));
+		if (!sorted) {
+			region->m_sorted = false;
+			MarkDirty(region);
+		}
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::AddProxy(dgBroadPhaseNode* const node, const dgVector& minBox, const dgVector& maxBox)
+{
+	dgAssert (node->IsLeafNode() || node->IsAggregate());
+	const dgInt32 index = m_proxiesCount;
+	m_proxiesCount ++;
+	node->m_linearIndex = index;
+
+	dgProxy& proxy = m_proxies[index];
+	proxy.m_node = node;
+	proxy.m_minBox = minBox;
+	proxy.m_maxBox = maxBox;
+	GetCells(proxy.m_minBox, proxy.m_maxBox, proxy.m_x0, proxy.m_z0, proxy.m_x1, proxy.m_z1);
+
+	if (((proxy.m_x1 - proxy.m_x0) >= DG_SWEEP_AND_PRUNE_MAX_PROXY_CELLS) || ((proxy.m_z1 - proxy.m_z0) >= DG_SWEEP_AND_PRUNE_MAX_PROXY_CELLS)) {
+		proxy.m_region = NULL;
+		proxy.m_oversizedIndex = m_oversizedCount;
+		m_oversized[m_oversizedCount] = node;
+		m_oversizedCount ++;
+	} else {
+		proxy.m_oversizedIndex = -1;
+		proxy.m_region = AddEntry(proxy, proxy.m_x0, proxy.m_z0);
+		for (dgInt32 z = proxy.m_z0; z <= proxy.m_z1; z ++) {
+			for (dgInt32 x = proxy.m_x0; x <= proxy.m_x1; x ++) {
+				if ((x != proxy.m_x0) || (z != proxy.m_z0)) {
+					AddEntry(proxy, x, z);
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::RemoveProxy(dgBroadPhaseNode* const node)
+{
+	const dgInt32 index = node->m_linearIndex;
+	dgAssert ((index >= 0) && (index < m_proxiesCount));
+	dgAssert (m_proxies[index].m_node == node);
+
+	dgProxy& proxy = m_proxies[index];
+	if (proxy.m_oversizedIndex >= 0) {
+		m_oversizedCount --;
+		dgBroadPhaseNode* const last = m_oversized[m_oversizedCount];
+		m_oversized[proxy.m_oversizedIndex] = last;
+		m_proxies[last->m_linearIndex].m_oversizedIndex = proxy.m_oversizedIndex;
+	} else {
+		for (dgInt32 z = proxy.m_z0; z <= proxy.m_z1; z ++) {
+			for (dgInt32 x = proxy.m_x0; x <= proxy.m_x1; x ++) {
+				RemoveEntry(proxy, GetProxyRegion(proxy, x, z));
+			}
+		}
+	}
+
+	m_proxiesCount --;
+	if (index != m_proxiesCount) {
+		m_proxies[index] = m_proxies[m_proxiesCount];
+		m_proxies[index].m_node->m_linearIndex = index;
+	}
+	node->m_linearIndex = -1;
+}
+
+void dgBroadPhaseSweepAndPrune::MoveProxy(dgBroadPhaseNode* const node, const dgVector& minBox, const dgVector& maxBox)
+{
+	const dgInt32 index = node->m_linearIndex;
+	dgAssert ((index >= 0) && (index < m_proxiesCount));
+	dgProxy& proxy = m_proxies[index];
+	dgAssert (proxy.m_node == node);
+
+	dgInt32 x0;
+	dgInt32 z0;
+	dgInt32 x1;
+	dgInt32 z1;
+	GetCells(minBox, maxBox, x0, z0, x1, z1);
+	const bool oversized = ((x1 - x0) >= DG_SWEEP_AND_PRUNE_MAX_PROXY_CELLS) || ((z1 - z0) >= DG_SWEEP_AND_PRUNE_MAX_PROXY_CELLS);
+
+	if (oversized || (proxy.m_oversizedIndex >= 0)) {
+		// oversized proxies are not in the regions, a change of state is a remove and an add
+		if (oversized && (proxy.m_oversizedIndex >= 0)) {
+			proxy.m_minBox = minBox;
+			proxy.m_maxBox = maxBox;
+			proxy.m_x0 = x0;
+			proxy.m_z0 = z0;
+			proxy.m_x1 = x1;
+			proxy.m_z1 = z1;
+		} else {
+			RemoveProxy(node);
+			AddProxy(node, minBox, maxBox);
+		}
+		return;
+	}
+
+	// regions the proxy leaves
+	for (dgInt32 z = proxy.m_z0; z <= proxy.m_z1; z ++) {
+		for (dgInt32 x = proxy.m_x0; x <= proxy.m_x1; x ++) {
+			if ((x < x0) || (x > x1) || (z < z0) || (z > z1)) {
+				RemoveEntry(proxy, GetProxyRegion(proxy, x, z));
+			}
+		}
+	}
+
+	const dgInt32 oldX0 = proxy.m_x0;
+	const dgInt32 oldZ0 = proxy.m_z0;
+	const dgInt32 oldX1 = proxy.m_x1;
+	const dgInt32 oldZ1 = proxy.m_z1;
+	const dgFloat32 oldMinX = proxy.m_minBox.m_x;
+	dgRegion* const oldRegion = proxy.m_region;
+	proxy.m_minBox = minBox;
+	proxy.m_maxBox = maxBox;
+	proxy.m_x0 = x0;
+	proxy.m_z0 = z0;
+	proxy.m_x1 = x1;
+	proxy.m_z1 = z1;
+
+	// regions the proxy stays in, most of the time that is only the old first region
+	dgRegion* firstRegion = NULL;
+	const dgInt32 keepX0 = dgMax (x0, oldX0);
+	const dgInt32 keepZ0 = dgMax (z0, oldZ0);
+	const dgInt32 keepX1 = dgMin (x1, oldX1);
+	const dgInt32 keepZ1 = dgMin (z1, oldZ1);
+	for (dgInt32 z = keepZ0; z <= keepZ1; z ++) {
+		for (dgInt32 x = keepX0; x <= keepX1; x ++) {
+			dgRegion* const region = ((x == oldX0) && (z == oldZ0)) ? oldRegion : GetRegion(x, z);
+			if ((x == x0) && (z == z0)) {
+				firstRegion = region;
+			}
+			UpdateEntry(proxy, oldMinX, region);
+		}
+	}
+
+	// regions the proxy enters
+	for (dgInt32 z = z0; z <= z1; z ++) {
+		for (dgInt32 x = x0; x <= x1; x ++) {
+			if ((x < oldX0) || (x > oldX1) || (z < oldZ0) || (z > oldZ1)) {
+				dgRegion* const region = AddEntry(proxy, x, z);
+				if ((x == x0) && (z == z0)) {
+					firstRegion = region;
+				}
+			}
+		}
+	}
+	dgAssert (firstRegion && (firstRegion == GetRegion(x0, z0)));
+	proxy.m_region = firstRegion;
+}
+
+void dgBroadPhaseSweepAndPrune::UpdateLeafBox(dgBroadPhaseNode* const leaf)
+{
+	// called from UpdateBody with the broadphase lock held
+	dgBody* const body = leaf->GetBody();
+	dgBroadPhaseAggregate* const aggregate = body ? body->GetBroadPhaseAggregate() : NULL;
+	if (aggregate) {
+		// the aggregate box is refit after this call, the proxy grows to hold the leaf until the next update
+		const dgInt32 index = aggregate->m_linearIndex;
+		if ((index >= 0) && (index < m_proxiesCount) && (m_proxies[index].m_node == aggregate)) {
+			const dgProxy& proxy = m_proxies[index];
+			if (!dgBoxInclusionTest(leaf->m_minBox, leaf->m_maxBox, proxy.m_minBox, proxy.m_maxBox)) {
+				MoveProxy(aggregate, proxy.m_minBox.GetMin(leaf->m_minBox), proxy.m_maxBox.GetMax(leaf->m_maxBox));
+			}
+		}
+	} else {
+		MoveProxy(leaf, leaf->m_minBox, leaf->m_maxBox);
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::SortRegionsKernel(void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgBroadPhaseSweepAndPrune* const broadPhase = (dgBroadPhaseSweepAndPrune*) context;
+	dgRegion** const regions = &broadPhase->m_dirtyRegions[0];
+	for (dgInt32 i = start; i < end; i ++) {
+		dgRegion* const region = regions[i];
+		if (!region->m_sorted) {
+			region->Sort();
+		}
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::SortRegions()
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	if (m_dirtyRegionsCount) {
+		m_world->ParallelFor(m_dirtyRegionsCount, SortRegionsKernel, this, DG_SWEEP_AND_PRUNE_SORT_GRAIN_SIZE);
+		for (dgInt32 i = 0; i < m_dirtyRegionsCount; i ++) {
+			dgRegion* const region = m_dirtyRegions[i];
+			region->m_dirty = false;
+			if (!region->m_count) {
+				m_regions.Remove(dgSweepAndPruneRegionKey(region->m_x, region->m_z));
+				delete region;
+			}
+		}
+		m_dirtyRegionsCount = 0;
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::SubmitPair(dgBroadPhaseNode* const leaf, const dgVector& boxP0, const dgVector& boxP1, bool test0, dgBroadPhaseNode* const node, dgFloat32 timestep, dgInt32 threadID)
+{
+	// the region entries hold the node boxes, the leaf gets the exact test of the pointer tree
+	if (dgOverlapTest(node->m_minBox, node->m_maxBox, boxP0, boxP1)) {
+		dgBody* const body0 = leaf->GetBody();
+		dgBody* const body1 = node->GetBody();
+		if (body0) {
+			if (body1) {
+				if (test0 || (body1->GetInvMass().m_w != dgFloat32(0.0f))) {
+					AddPair(body0, body1, timestep, threadID);
+				}
+			} else {
+				((dgBroadPhaseAggregate*)node)->SummitPairs(body0, timestep, threadID);
+			}
+		} else {
+			dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*)leaf;
+			if (body1) {
+				aggregate->SummitPairs(body1, timestep, threadID);
+			} else {
+				aggregate->SummitPairs((dgBroadPhaseAggregate*)node, timestep, threadID);
+			}
+		}
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::SubmitPairs(dgBroadPhaseNode* const leaf, bool backward, dgFloat32 timestep, dgInt32 threadID)
+{
+	dgBody* const body0 = leaf->GetBody();
+	const dgVector& boxP0 = body0 ? body0->m_minAABB : leaf->m_minBox;
+	const dgVector& boxP1 = body0 ? body0->m_maxAABB : leaf->m_maxBox;
+	const bool test0 = body0 ? (body0->GetInvMass().m_w != dgFloat32(0.0f)) : true;
+
+	const dgProxy& proxy = m_proxies[leaf->m_linearIndex];
+	dgAssert (proxy.m_node == leaf);
+	if (proxy.m_oversizedIndex >= 0) {
+		if (backward) {
+			for (dgInt32 i = 0; i < m_proxiesCount; i ++) {
+				dgBroadPhaseNode* const node = m_proxies[i].m_node;
+				if (node != leaf) {
+					SubmitPair(leaf, boxP0, boxP1, test0, node, timestep, threadID);
+				}
+			}
+		} else {
+			// the other oversized leaves are tested in order, the small ones find this leaf from their own scan
+			for (dgInt32 i = proxy.m_oversizedIndex + 1; i < m_oversizedCount; i ++) {
+				SubmitPair(leaf, boxP0, boxP1, test0, m_oversized[i], timestep, threadID);
+			}
+		}
+		return;
+	}
+
+	for (dgInt32 i = 0; i < m_oversizedCount; i ++) {
+		SubmitPair(leaf, boxP0, boxP1, test0, m_oversized[i], timestep, threadID);
+	}
+
+	for (dgInt32 z = proxy.m_z0; z <= proxy.m_z1; z ++) {
+		for (dgInt32 x = proxy.m_x0; x <= proxy.m_x1; x ++) {
+			// most leaves are in a single region, the first region of a leaf is cached in its proxy
+			const dgRegion* const region = ((x == proxy.m_x0) && (z == proxy.m_z0)) ? proxy.m_region : GetRegion(x, z);
+			dgAssert (region && (region == GetRegion(x, z)));
+			const dgEntry* const entries = &region->m_entries[0];
+			const dgInt32 index = region->Find(leaf, proxy.m_minBox.m_x);
+			const dgEntry& me = entries[index];
+
+			// a pair is reported by the region that holds the first cell of the overlap of the two proxies,
+			// only a sorted region can stop the sweep early
+			const dgInt32 count = region->m_count;
+			const bool sorted = region->m_sorted;
+			for (dgInt32 j = index + 1; j < count; j ++) {
+				const dgEntry& entry = entries[j];
+				if (entry.m_minX > me.m_maxX) {
+					if (sorted) {
+						break;
+					}
+					continue;
+				}
+				if ((entry.m_maxX >= me.m_minX) && (entry.m_minY <= me.m_maxY) && (entry.m_maxY >= me.m_minY) && (entry.m_minZ <= me.m_maxZ) && (entry.m_maxZ >= me.m_minZ)) {
+					if ((dgMax (entry.m_cellX, me.m_cellX) == x) && (dgMax (entry.m_cellZ, me.m_cellZ) == z)) {
+						SubmitPair(leaf, boxP0, boxP1, test0, entry.m_node, timestep, threadID);
+					}
+				}
+			}
+
+			if (backward) {
+				const dgFloat32 minX = me.m_minX - region->m_maxWidth;
+				for (dgInt32 j = index - 1; j >= 0; j --) {
+					const dgEntry& entry = entries[j];
+					if (entry.m_minX < minX) {
+						if (sorted) {
+							break;
+						}
+						continue;
+					}
+					if ((entry.m_minX <= me.m_maxX) && (entry.m_maxX >= me.m_minX) && (entry.m_minY <= me.m_maxY) && (entry.m_maxY >= me.m_minY) && (entry.m_minZ <= me.m_maxZ) && (entry.m_maxZ >= me.m_minZ)) {
+						if ((dgMax (entry.m_cellX, me.m_cellX) == x) && (dgMax (entry.m_cellZ, me.m_cellZ) == z)) {
+							SubmitPair(leaf, boxP0, boxP1, test0, entry.m_node, timestep, threadID);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::FindCollidingPairsForward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
+{
+	const dgFloat32 timestep = descriptor->m_timestep;
+	if (broadPhaseNode->IsAggregate()) {
+		((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
+	}
+	SubmitPairs(broadPhaseNode, false, timestep, threadID);
+}
+
+void dgBroadPhaseSweepAndPrune::FindCollidingPairsForwardAndBackward(dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const broadPhaseNode, dgInt32 threadID)
+{
+	const dgUnsigned32 lru = m_lru + 1;
+	if (lru == broadPhaseNode->GetDirtyLru()) {
+		const dgFloat32 timestep = descriptor->m_timestep;
+		if (broadPhaseNode->IsAggregate()) {
+			((dgBroadPhaseAggregate*)broadPhaseNode)->SubmitSeltPairs(timestep, threadID);
+		}
+		SubmitPairs(broadPhaseNode, true, timestep, threadID);
+	}
+}
+
+bool dgBroadPhaseSweepAndPrune::IsQueryValid(const dgVector& minBox, const dgVector& maxBox, dgInt32 maxCells) const
+{
+	// a single leaf is never updated by UpdateBody, and large queries are cheaper on the tree,
+	// the tree visits the nodes along a ray in order and stops at the first hit
+	if (!m_rootNode || m_rootNode->IsLeafNode()) {
+		return false;
+	}
+	dgInt32 x0;
+	dgInt32 z0;
+	dgInt32 x1;
+	dgInt32 z1;
+	GetCells(minBox, maxBox, x0, z0, x1, z1);
+	return ((x1 - x0 + 1) * (z1 - z0 + 1)) <= maxCells;
+}
+
+dgInt32 dgBroadPhaseSweepAndPrune::CollectLeaves(const dgVector& minBox, const dgVector& maxBox, const dgFastRayTest* const ray, const dgVector& castP0, const dgVector& castP1, const dgBroadPhaseNode** const leaves, dgFloat32* const distance, dgInt32 maxCount) const
+{
+	// gather the leaves that overlap the query box, with a ray only the leaves hit by the ray are taken, sorted with the closest at the end.
+	// returns -1 when there are more than maxCount leaves, the caller then falls back to the tree.
+	dgInt32 x0;
+	dgInt32 z0;
+	dgInt32 x1;
+	dgInt32 z1;
+	GetCells(minBox, maxBox, x0, z0, x1, z1);
+
+	dgInt32 count = 0;
+	for (dgInt32 i = 0; i < m_oversizedCount; i ++) {
+		const dgBroadPhaseNode* const node = m_oversized[i];
+		if (dgOverlapTest(node->m_minBox, node->m_maxBox, minBox, maxBox)) {
+			dgFloat32 dist = dgFloat32 (0.0f);
+			if (ray) {
+				dist = ray->BoxIntersect(node->m_minBox - castP1, node->m_maxBox - castP0);
+				if (dist >= dgFloat32 (1.0f)) {
+					continue;
+				}
+			}
+			if (count >= maxCount) {
+				return -1;
+			}
+			count = dgSweepAndPrunePushNode(leaves, distance, count, node, dist);
+		}
+	}
+
+	const dgVector padding (DG_SWEEP_AND_PRUNE_REGION_SIZE * dgFloat32 (1.0e-3f));
+	for (dgInt32 z = z0; z <= z1; z ++) {
+		for (dgInt32 x = x0; x <= x1; x ++) {
+			const dgRegion* const region = GetRegion(x, z);
+			if (!region || !region->m_count) {
+				continue;
+			}
+
+			dgVector regionMinBox (minBox);
+			dgVector regionMaxBox (maxBox);
+			if (ray) {
+				// only the part of the swept box that is inside the region can hit the region entries
+				dgFloat32 t0 = dgFloat32 (0.0f);
+				dgFloat32 t1 = dgFloat32 (1.0f);
+				const dgFloat32 rx0 = dgFloat32 (x) * DG_SWEEP_AND_PRUNE_REGION_SIZE - padding.m_x;
+				const dgFloat32 rz0 = dgFloat32 (z) * DG_SWEEP_AND_PRUNE_REGION_SIZE - padding.m_z;
+				dgSweepAndPruneClip (ray->m_p0.m_x + castP0.m_x, ray->m_p0.m_x + castP1.m_x, ray->m_diff.m_x, rx0, rx0 + DG_SWEEP_AND_PRUNE_REGION_SIZE + dgFloat32 (2.0f) * padding.m_x, t0, t1);
+				dgSweepAndPruneClip (ray->m_p0.m_z + castP0.m_z, ray->m_p0.m_z + castP1.m_z, ray->m_diff.m_z, rz0, rz0 + DG_SWEEP_AND_PRUNE_REGION_SIZE + dgFloat32 (2.0f) * padding.m_z, t0, t1);
+				if (t0 > t1) {
+					continue;
+				}
+				const dgVector q0 (ray->m_p0 + ray->m_diff.Scale4(t0));
+				const dgVector q1 (ray->m_p0 + ray->m_diff.Scale4(t1));
+				regionMinBox = q0.GetMin(q1) + castP0 - padding;
+				regionMaxBox = q0.GetMax(q1) + castP1 + padding;
+			}
+
+			const dgEntry* const entries = &region->m_entries[0];
+			const dgInt32 start = region->m_sorted ? region->LowerBound(regionMinBox.m_x - region->m_maxWidth) : 0;
+			for (dgInt32 i = start; i < region->m_count; i ++) {
+				const dgEntry& entry = entries[i];
+				if (entry.m_minX >= regionMaxBox.m_x) {
+					if (region->m_sorted) {
+						break;
+					}
+					continue;
+				}
+				if (!((entry.m_maxX > regionMinBox.m_x) && (entry.m_minY < regionMaxBox.m_y) && (entry.m_maxY > regionMinBox.m_y) && (entry.m_minZ < regionMaxBox.m_z) && (entry.m_maxZ > regionMinBox.m_z))) {
+					continue;
+				}
+
+				const dgBroadPhaseNode* const node = entry.m_node;
+				dgFloat32 dist = dgFloat32 (0.0f);
+				if (ray) {
+					dist = ray->BoxIntersect(node->m_minBox - castP1, node->m_maxBox - castP0);
+					if (dist >= dgFloat32 (1.0f)) {
+						continue;
+					}
+					// the regions along the path are not all visited, a leaf in many regions is looked up in the candidates
+					const dgProxy& proxy = m_proxies[node->m_linearIndex];
+					if ((proxy.m_x0 != proxy.m_x1) || (proxy.m_z0 != proxy.m_z1)) {
+						bool duplicate = false;
+						for (dgInt32 j = 0; (j < count) && !duplicate; j ++) {
+							duplicate = (leaves[j] == node);
+						}
+						if (duplicate) {
+							continue;
+						}
+					}
+				} else if ((dgMax (entry.m_cellX, x0) != x) || (dgMax (entry.m_cellZ, z0) != z)) {
+					// a leaf in many regions is only taken from the first region it shares with the query
+					continue;
+				}
+
+				if (count >= maxCount) {
+					return -1;
+				}
+				count = dgSweepAndPrunePushNode(leaves, distance, count, node, dist);
+			}
+		}
+	}
+	return count;
+}
+
+void dgBroadPhaseSweepAndPrune::ForEachBodyInAABB(const dgVector& minBox, const dgVector& maxBox, OnBodiesInAABB callback, void* const userData) const
+{
+	if (!IsQueryValid(minBox, maxBox, DG_SWEEP_AND_PRUNE_MAX_QUERY_CELLS)) {
+		dgBroadPhaseDefault::ForEachBodyInAABB(minBox, maxBox, callback, userData);
+		return;
+	}
+
+	const dgBroadPhaseNode* leaves[DG_SWEEP_AND_PRUNE_MAX_QUERY_LEAVES];
+	dgFloat32 distance[DG_SWEEP_AND_PRUNE_MAX_QUERY_LEAVES];
+	const dgInt32 count = CollectLeaves(minBox, maxBox, NULL, dgVector::m_zero, dgVector::m_zero, leaves, distance, DG_SWEEP_AND_PRUNE_MAX_QUERY_LEAVES);
+	if (count < 0) {
+		dgBroadPhaseDefault::ForEachBodyInAABB(minBox, maxBox, callback, userData);
+		return;
+	}
+
+	// each leaf is a stack of its own, an aggregate leaf can use the full depth of the stack
+	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+	for (dgInt32 i = 0; i < count; i ++) {
+		stackPool[0] = leaves[i];
+		if (!dgBroadPhase::ForEachBodyInAABB(stackPool, 1, minBox, maxBox, callback, userData)) {
+			break;
+		}
+	}
+}
+
+void dgBroadPhaseSweepAndPrune::RayCast(const dgVector& l0, const dgVector& l1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const
+{
+	const dgVector test(l0 <= l1);
+	const dgVector minBox((l0 & test) | l1.AndNot(test));
+	const dgVector maxBox((l1 & test) | l0.AndNot(test));
+	if (!IsQueryValid(minBox, maxBox, DG_SWEEP_AND_PRUNE_MAX_CAST_CELLS)) {
+		dgBroadPhaseDefault::RayCast(l0, l1, filter, prefilter, userData);
+		return;
+	}
+
+	if (filter) {
+		dgVector segment(l1 - l0);
+		dgFloat32 dist2 = segment.DotProduct3(segment);
+		if (dist2 > dgFloat32(1.0e-8f)) {
+			dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
+			const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+			// the ray box has no thickness along the axes the ray is parallel to, the query box is the closed box of the segment
+			dgFastRayTest ray(l0, l1);
+			const dgVector padding(dgFloat32 (1.0e-3f));
+			const dgInt32 count = CollectLeaves(minBox - padding, maxBox + padding, &ray, dgVector::m_zero, dgVector::m_zero, stackPool, distance, DG_BROADPHASE_MAX_STACK_DEPTH / 2);
+			if (count < 0) {
+				dgBroadPhaseDefault::RayCast(l0, l1, filter, prefilter, userData);
+				return;
+			}
+			dgBroadPhase::RayCast(stackPool, distance, count, l0, l1, ray, filter, prefilter, userData);
+		}
+	}
+}
+
+dgInt32 dgBroadPhaseSweepAndPrune::ConvexCast(dgCollisionInstance* const shape, const dgMatrix& matrix, const dgVector& target, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgVector boxP0;
+	dgVector boxP1;
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+
+	dgVector velocA((target - matrix.m_posit) & dgVector::m_triplexMask);
+	const dgVector minBox(boxP0.GetMin(boxP0 + velocA));
+	const dgVector maxBox(boxP1.GetMax(boxP1 + velocA));
+	if (!IsQueryValid(minBox, maxBox, DG_SWEEP_AND_PRUNE_MAX_CAST_CELLS)) {
+		return dgBroadPhaseDefault::ConvexCast(shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	dgFloat32 distance[DG_BROADPHASE_MAX_STACK_DEPTH];
+	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+	dgVector velocB(dgFloat32(0.0f));
+	dgFastRayTest ray(dgVector(dgFloat32(0.0f)), velocA);
+	const dgVector padding(dgFloat32 (1.0e-3f));
+	const dgInt32 count = CollectLeaves(minBox - padding, maxBox + padding, &ray, boxP0, boxP1, stackPool, distance, DG_BROADPHASE_MAX_STACK_DEPTH / 2);
+	if (count < 0) {
+		return dgBroadPhaseDefault::ConvexCast(shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	*param = dgFloat32 (1.0f);
+	return dgBroadPhase::ConvexCast(stackPool, distance, count, velocA, velocB, ray, shape, matrix, target, param, prefilter, userData, info, maxContacts, threadIndex);
+}
+
+dgInt32 dgBroadPhaseSweepAndPrune::Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const
+{
+	dgVector boxP0;
+	dgVector boxP1;
+	dgAssert(matrix.TestOrthogonal());
+	shape->CalcAABB(matrix, boxP0, boxP1);
+	if (!IsQueryValid(boxP0, boxP1, DG_SWEEP_AND_PRUNE_MAX_QUERY_CELLS)) {
+		return dgBroadPhaseDefault::Collide(shape, matrix, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	const dgBroadPhaseNode* leaves[DG_SWEEP_AND_PRUNE_MAX_QUERY_LEAVES];
+	dgFloat32 distance[DG_SWEEP_AND_PRUNE_MAX_QUERY_LEAVES];
+	const dgInt32 count = CollectLeaves(boxP0, boxP1, NULL, dgVector::m_zero, dgVector::m_zero, leaves, distance, DG_SWEEP_AND_PRUNE_MAX_QUERY_LEAVES);
+	if (count < 0) {
+		return dgBroadPhaseDefault::Collide(shape, matrix, prefilter, userData, info, maxContacts, threadIndex);
+	}
+
+	dgInt32 overlaped[DG_BROADPHASE_MAX_STACK_DEPTH];
+	const dgBroadPhaseNode* stackPool[DG_BROADPHASE_MAX_STACK_DEPTH];
+
+	dgInt32 totalCount = 0;
+	for (dgInt32 i = 0; (i < count) && (totalCount < maxContacts); i ++) {
+		stackPool[0] = leaves[i];
+		overlaped[0] = 1;
+		totalCount += dgBroadPhase::Collide(stackPool, overlaped, 1, boxP0, boxP1, shape, matrix, prefilter, userData, &info[totalCount], maxContacts - totalCount, threadIndex);
+	}
+	return totalCount;
+}
@@ -0,0 +1,152 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __AFX_BROADPHASE_SWEEP_AND_PRUNE_H_
+#define __AFX_BROADPHASE_SWEEP_AND_PRUNE_H_
+
+#include "dgPhysicsStdafx.h"
+#include "dgBroadPhaseDefault.h"
+
+#define DG_SWEEP_AND_PRUNE_REGION_SIZE			dgFloat32 (32.0f)
+#define DG_SWEEP_AND_PRUNE_MAX_CELL				(1<<20)
+#define DG_SWEEP_AND_PRUNE_MAX_PROXY_CELLS		16
+#define DG_SWEEP_AND_PRUNE_MAX_QUERY_CELLS		64
+#define DG_SWEEP_AND_PRUNE_MAX_CAST_CELLS		4
+#define DG_SWEEP_AND_PRUNE_MAX_QUERY_LEAVES		1024
+
+// multi box pruning: the x z plane is split in a grid of square regions, each region keeps the
+// leaves that touch it in a list sorted along x, and pairs are found by sweeping those lists.
+// the lists are nearly sorted from one frame to the next, so they are kept in order with an insertion sort.
+// leaves that span too many regions, like a terrain, are kept in a separate list that is tested by every leaf.
+// the pointer tree of the default broadphase is still maintained, it backs the aggregates,
+// the batched ray casts and the queries that are too large for the grid.
+class dgBroadPhaseSweepAndPrune: public dgBroadPhaseDefault
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator);
+
+	dgBroadPhaseSweepAndPrune(dgWorld* const world);
+	virtual ~dgBroadPhaseSweepAndPrune();
+
+	protected:
+	class dgRegion;
+
+	// a leaf of the top tree, a body or an aggregate, the leaf m_linearIndex is its index in the proxy array
+	class dgProxy
+	{
+		public:
+		dgVector m_minBox;
+		dgVector m_maxBox;
+		dgBroadPhaseNode* m_node;
+		dgRegion* m_region;
+		dgInt32 m_x0;
+		dgInt32 m_z0;
+		dgInt32 m_x1;
+		dgInt32 m_z1;
+		dgInt32 m_oversizedIndex;
+	} DG_GCC_VECTOR_ALIGMENT;
+
+	// the copy of a proxy box in one region, the first cell of the proxy is used to report each overlap in only one region
+	class dgEntry
+	{
+		public:
+		dgFloat32 m_minX;
+		dgFloat32 m_minY;
+		dgFloat32 m_minZ;
+		dgFloat32 m_maxX;
+		dgFloat32 m_maxY;
+		dgFloat32 m_maxZ;
+		dgInt32 m_cellX;
+		dgInt32 m_cellZ;
+		dgBroadPhaseNode* m_node;
+	};
+
+	class dgRegion
+	{
+		public:
+		DG_CLASS_ALLOCATOR(allocator);
+		dgRegion(dgMemoryAllocator* const allocator, dgInt32 x, dgInt32 z);
+
+		dgInt32 LowerBound(dgFloat32 minX) const;
+		dgInt32 Find(const dgBroadPhaseNode* const node, dgFloat32 minX) const;
+		void Sort();
+
+		dgArray<dgEntry> m_entries;
+		dgFloat32 m_maxWidth;
+		dgInt32 m_count;
+		dgInt32 m_x;
+		dgInt32 m_z;
+		bool m_sorted;
+		bool m_dirty;
+	};
+
+	virtual dgInt32 GetType() const;
+	virtual void Add(dgBody* const body);
+	virtual void Remove(dgBody* const body);
+	virtual void AddBodies(dgBody** const bodies, dgInt32 count);
+	virtual void UpdateFitness();
+	virtual void InvalidateCache();
+	virtual void DestroyAggregate(dgBroadPhaseAggregate* const aggregate);
+
+	virtual void LinkAggregate (dgBroadPhaseAggregate* const aggregate);
+	virtual void UnlinkAggregate (dgBroadPhaseAggregate* const aggregate);
+	virtual void UpdateLeafBox (dgBroadPhaseNode* const leaf);
+	virtual void FindCollidingPairsForward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+	virtual void FindCollidingPairsForwardAndBackward (dgBroadphaseSyncDescriptor* const descriptor, dgBroadPhaseNode* const node, dgInt32 threadID);
+
+	virtual void RayCast (const dgVector& p0, const dgVector& p1, OnRayCastAction filter, OnRayPrecastAction prefilter, void* const userData) const;
+	virtual dgInt32 Collide(dgCollisionInstance* const shape, const dgMatrix& matrix, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	virtual dgInt32 ConvexCast (dgCollisionInstance* const shape, const dgMatrix& p0, const dgVector& p1, dgFloat32* const param, OnRayPrecastAction prefilter, void* const userData, dgConvexCastReturnInfo* const info, dgInt32 maxContacts, dgInt32 threadIndex) const;
+	virtual void ForEachBodyInAABB (const dgVector& q0, const dgVector& q1, OnBodiesInAABB callback, void* const userData) const;
+
+	void GetCells (const dgVector& minBox, const dgVector& maxBox, dgInt32& x0, dgInt32& z0, dgInt32& x1, dgInt32& z1) const;
+	dgRegion* GetRegion (dgInt32 x, dgInt32 z) const;
+	dgRegion* GetProxyRegion (const dgProxy& proxy, dgInt32 x, dgInt32 z) const;
+	dgRegion* AddEntry (dgProxy& proxy, dgInt32 x, dgInt32 z);
+	void RemoveEntry (dgProxy& proxy, dgRegion* const region);
+	void UpdateEntry (dgProxy& proxy, dgFloat32 oldMinX, dgRegion* const region);
+	void SetEntry (dgEntry& entry, const dgProxy& proxy) const;
+	void MarkDirty (dgRegion* const region);
+
+	void AddProxy (dgBroadPhaseNode* const node, const dgVector& minBox, const dgVector& maxBox);
+	void RemoveProxy (dgBroadPhaseNode* const node);
+	void MoveProxy (dgBroadPhaseNode* const node, const dgVector& minBox, const dgVector& maxBox);
+	void SortRegions ();
+
+	void SubmitPairs (dgBroadPhaseNode* const leaf, bool backward, dgFloat32 timestep, dgInt32 threadID);
+	void SubmitPair (dgBroadPhaseNode* const leaf, const dgVector& boxP0, const dgVector& boxP1, bool test0, dgBroadPhaseNode* const node, dgFloat32 timestep, dgInt32 threadID);
+	dgInt32 CollectLeaves (const dgVector& minBox, const dgVector& maxBox, const dgFastRayTest* const ray, const dgVector& castP0, const dgVector& castP1, const dgBroadPhaseNode** const leaves, dgFloat32* const distance, dgInt32 maxCount) const;
+	bool IsQueryValid (const dgVector& minBox, const dgVector& maxBox, dgInt32 maxCells) const;
+
+	static void SortRegionsKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID);
+
+	dgTree<dgRegion*, dgInt64> m_regions;
+	dgArray<dgProxy> m_proxies;
+	dgArray<dgBroadPhaseNode*> m_oversized;
+	dgArray<dgRegion*> m_dirtyRegions;
+	dgFloat32 m_invRegionSize;
+	dgInt32 m_proxiesCount;
+	dgInt32 m_oversizedCount;
+	dgInt32 m_dirtyRegionsCount;
+};
+
+
+#endif
@@ -0,0 +1,654 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgBroadPhase.h"
+#include "dgBroadPhaseAggregate.h"
+
+#define DG_TREE_BUILD_BINS				16
+#define DG_TREE_BUILD_MAX_CHUNKS		64
+#define DG_TREE_BUILD_CHUNK_SIZE		512
+#define DG_TREE_BUILD_TASK_SIZE			1024
+#define DG_TREE_BUILD_SMALL_RANGE		8
+#define DG_TREE_BUILD_STACK_DEPTH		64
+#define DG_TREE_BUILD_LARGE_LEAF		dgFloat32 (0.5f)
+
+
+DG_INLINE static dgFloat32 dgTreeBuildArea (const dgVector& minBox, const dgVector& maxBox)
+{
+	const dgVector side (maxBox - minBox);
+	return side.DotProduct4(side.ShiftTripleRight()).GetScalar();
+}
+
+// the builder works on a copy of the leaf boxes packed in one array, so that the passes over a range read memory in order
+DG_MSC_VECTOR_ALIGMENT
+class dgTreeBuildLeaf
+{
+	public:
+	dgVector m_minBox;
+	dgVector m_maxBox;
+	dgBroadPhaseNode* m_node;
+	dgFloat32 m_area;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_INLINE static void dgTreeBuildSetLeaf (dgTreeBuildLeaf& leaf, dgBroadPhaseNode* const node)
+{
+	leaf.m_minBox = node->m_minBox;
+	leaf.m_maxBox = node->m_maxBox;
+	leaf.m_node = node;
+	leaf.m_area = node->m_surfaceArea;
+}
+
+DG_MSC_VECTOR_ALIGMENT
+class dgTreeBuildBounds
+{
+	public:
+	void Init()
+	{
+		m_minBox = dgVector (dgFloat32 (1.0e15f));
+		m_maxBox = dgVector (-dgFloat32 (1.0e15f));
+		m_minCentroid = m_minBox;
+		m_maxCentroid = m_maxBox;
+		m_maxArea = dgFloat32 (-1.0f);
+		m_maxAreaIndex = -1;
+	}
+
+	void Add (const dgTreeBuildLeaf& leaf, dgInt32 index)
+	{
+		// twice the centroid, the scale does not change the binning
+		const dgVector centroid (leaf.m_minBox + leaf.m_maxBox);
+		m_minBox = m_minBox.GetMin(leaf.m_minBox);
+		m_maxBox = m_maxBox.GetMax(leaf.m_maxBox);
+		m_minCentroid = m_minCentroid.GetMin(centroid);
+		m_maxCentroid = m_maxCentroid.GetMax(centroid);
+		if (leaf.m_area > m_maxArea) {
+			m_maxArea = leaf.m_area;
+			m_maxAreaIndex = index;
+		}
+	}
+
+	void Merge (const dgTreeBuildBounds& bounds)
+	{
+		m_minBox = m_minBox.GetMin(bounds.m_minBox);
+		m_maxBox = m_maxBox.GetMax(bounds.m_maxBox);
+		m_minCentroid = m_minCentroid.GetMin(bounds.m_minCentroid);
+		m_maxCentroid = m_maxCentroid.GetMax(bounds.m_maxCentroid);
+		if (bounds.m_maxArea > m_maxArea) {
+			m_maxArea = bounds.m_maxArea;
+			m_maxAreaIndex = bounds.m_maxAreaIndex;
+		}
+	}
+
+	dgVector m_minBox;
+	dgVector m_maxBox;
+	dgVector m_minCentroid;
+	dgVector m_maxCentroid;
+	dgFloat32 m_maxArea;
+	dgInt32 m_maxAreaIndex;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgTreeBuildBins
+{
+	public:
+	void Init()
+	{
+		for (dgInt32 i = 0; i < 3; i ++) {
+			for (dgInt32 j = 0; j < DG_TREE_BUILD_BINS; j ++) {
+				m_minBox[i][j] = dgVector (dgFloat32 (1.0e15f));
+				m_maxBox[i][j] = dgVector (-dgFloat32 (1.0e15f));
+				m_count[i][j] = 0;
+			}
+		}
+	}
+
+	void Merge (const dgTreeBuildBins& bins)
+	{
+		for (dgInt32 i = 0; i < 3; i ++) {
+			for (dgInt32 j = 0; j < DG_TREE_BUILD_BINS; j ++) {
+				m_minBox[i][j] = m_minBox[i][j].GetMin(bins.m_minBox[i][j]);
+				m_maxBox[i][j] = m_maxBox[i][j].GetMax(bins.m_maxBox[i][j]);
+				m_count[i][j] += bins.m_count[i][j];
+			}
+		}
+	}
+
+	dgVector m_minBox[3][DG_TREE_BUILD_BINS];
+	dgVector m_maxBox[3][DG_TREE_BUILD_BINS];
+	dgInt32 m_count[3][DG_TREE_BUILD_BINS];
+} DG_GCC_VECTOR_ALIGMENT;
+
+// the bins of a range are evenly spaced along the centroid bounds of the range
+DG_MSC_VECTOR_ALIGMENT
+class dgTreeBuildSplit
+{
+	public:
+	dgTreeBuildSplit (const dgTreeBuildBounds& bounds)
+		:m_origin(bounds.m_minCentroid)
+		,m_scale(dgFloat32 (0.0f))
+		,m_axis(-1)
+		,m_bin(-1)
+	{
+		const dgVector extent (bounds.m_maxCentroid - bounds.m_minCentroid);
+		for (dgInt32 i = 0; i < 3; i ++) {
+			if (extent[i] > dgFloat32 (1.0e-6f)) {
+				m_scale[i] = dgFloat32 (DG_TREE_BUILD_BINS) * dgFloat32 (0.999f) / extent[i];
+			}
+		}
+	}
+
+	DG_INLINE dgInt32 GetBin (const dgTreeBuildLeaf& leaf, dgInt32 axis) const
+	{
+		const dgFloat32 centroid = leaf.m_minBox[axis] + leaf.m_maxBox[axis];
+		return dgMin (dgInt32 ((centroid - m_origin[axis]) * m_scale[axis]), DG_TREE_BUILD_BINS - 1);
+	}
+
+	DG_INLINE bool IsLeft (const dgTreeBuildLeaf& leaf) const
+	{
+		return GetBin (leaf, m_axis) <= m_bin;
+	}
+
+	// pick the bin plane with the lowest surface area heuristic cost, false if all the centroids fall in one bin
+	bool Select (const dgTreeBuildBins& bins)
+	{
+		dgFloat32 bestCost = dgFloat32 (1.0e30f);
+		for (dgInt32 i = 0; i < 3; i ++) {
+			if (m_scale[i] > dgFloat32 (0.0f)) {
+				dgFloat32 rightArea[DG_TREE_BUILD_BINS];
+				dgInt32 rightCount[DG_TREE_BUILD_BINS];
+				dgVector minBox (dgFloat32 (1.0e15f));
+				dgVector maxBox (-dgFloat32 (1.0e15f));
+				dgInt32 count = 0;
+				for (dgInt32 j = DG_TREE_BUILD_BINS - 1; j > 0; j --) {
+					minBox = minBox.GetMin(bins.m_minBox[i][j]);
+					maxBox = maxBox.GetMax(bins.m_maxBox[i][j]);
+					count += bins.m_count[i][j];
+					rightArea[j] = count ? dgTreeBuildArea (minBox, maxBox) : dgFloat32 (0.0f);
+					rightCount[j] = count;
+				}
+
+				minBox = dgVector (dgFloat32 (1.0e15f));
+				maxBox = dgVector (-dgFloat32 (1.0e15f));
+				count = 0;
+				for (dgInt32 j = 0; j < DG_TREE_BUILD_BINS - 1; j ++) {
+					minBox = minBox.GetMin(bins.m_minBox[i][j]);
+					maxBox = maxBox.GetMax(bins.m_maxBox[i][j]);
+					count += bins.m_count[i][j];
+					if (count && rightCount[j + 1]) {
+						const dgFloat32 cost = dgTreeBuildArea (minBox, maxBox) * count + rightArea[j + 1] * rightCount[j + 1];
+						if (cost < bestCost) {
+							bestCost = cost;
+							m_axis = i;
+							m_bin = j;
+						}
+					}
+				}
+			}
+		}
+		return m_axis >= 0;
+	}
+
+	dgVector m_origin;
+	dgVector m_scale;
+	dgInt32 m_axis;
+	dgInt32 m_bin;
+} DG_GCC_VECTOR_ALIGMENT;
+
+class dgTreeBuildTask
+{
+	public:
+	dgBroadPhaseTreeNode* m_parent;
+	dgInt32 m_first;
+	dgInt32 m_last;
+	dgInt32 m_isLeft;
+};
+
+// a range on the build stack, the bounds of a child come out of the partition of its parent
+DG_MSC_VECTOR_ALIGMENT
+class dgTreeBuildRange
+{
+	public:
+	dgTreeBuildBounds m_bounds;
+	dgTreeBuildTask m_task;
+} DG_GCC_VECTOR_ALIGMENT;
+
+// ranges larger than the task size are split on the calling thread, with the bounds, bins and partition of each split
+// spread over the thread hive, the smaller ranges are built as independent sub tree tasks.
+// a range [first, last] of leaves always owns the interior nodes [first, last - 1], so the tasks never share nodes,
+// and the partition is stable, so the tree is the same for any number of threads.
+DG_MSC_VECTOR_ALIGMENT
+class dgBroadPhase::dgTreeBuildDescriptor
+{
+	public:
+	DG_CLASS_ALLOCATOR(allocator)
+
+	dgTreeBuildDescriptor (dgWorld* const world, dgTreeBuildLeaf* const leafArray, dgTreeBuildLeaf* const tempArray, dgBroadPhaseTreeNode** const nodeArray)
+		:m_world(world)
+		,m_leafArray(leafArray)
+		,m_tempArray(tempArray)
+		,m_nodeArray(nodeArray)
+		,m_root(NULL)
+		,m_split(NULL)
+		,m_tasks(world->GetAllocator())
+		,m_tasksCount(0)
+	{
+	}
+
+	void CalculateBounds (dgTreeBuildBounds& bounds, dgInt32 first, dgInt32 count) const
+	{
+		bounds.Init();
+		for (dgInt32 i = 0; i < count; i ++) {
+			bounds.Add (m_leafArray[first + i], first + i);
+		}
+	}
+
+	void CalculateBins (dgTreeBuildBins& bins, const dgTreeBuildSplit& split, dgInt32 first, dgInt32 count) const
+	{
+		bins.Init();
+		for (dgInt32 i = 0; i < count; i ++) {
+			const dgTreeBuildLeaf& leaf = m_leafArray[first + i];
+			for (dgInt32 j = 0; j < 3; j ++) {
+				const dgInt32 bin = split.GetBin (leaf, j);
+				bins.m_minBox[j][bin] = bins.m_minBox[j][bin].GetMin(leaf.m_minBox);
+				bins.m_maxBox[j][bin] = bins.m_maxBox[j][bin].GetMax(leaf.m_maxBox);
+				bins.m_count[j][bin] ++;
+			}
+		}
+	}
+
+	// the bounds of the two children are collected while the leaves are moved to their side
+	void Scatter (const dgTreeBuildSplit& split, dgInt32 first, dgInt32 count, dgInt32 leftIndex, dgInt32 rightIndex, dgTreeBuildBounds& leftBounds, dgTreeBuildBounds& rightBounds) const
+	{
+		leftBounds.Init();
+		rightBounds.Init();
+		for (dgInt32 i = 0; i < count; i ++) {
+			const dgTreeBuildLeaf& leaf = m_leafArray[first + i];
+			if (split.IsLeft (leaf)) {
+				m_tempArray[leftIndex] = leaf;
+				leftBounds.Add (leaf, leftIndex);
+				leftIndex ++;
+			} else {
+				m_tempArray[rightIndex] = leaf;
+				rightBounds.Add (leaf, rightIndex);
+				rightIndex ++;
+			}
+		}
+	}
+
+	void SetChunks (dgInt32 first, dgInt32 count)
+	{
+		m_first = first;
+		m_count = count;
+		m_chunksCount = dgMin ((count + DG_TREE_BUILD_CHUNK_SIZE - 1) / DG_TREE_BUILD_CHUNK_SIZE, DG_TREE_BUILD_MAX_CHUNKS);
+		m_chunkSize = (count + m_chunksCount - 1) / m_chunksCount;
+	}
+
+	void GetChunk (dgInt32 chunk, dgInt32& first, dgInt32& count) const
+	{
+		first = m_first + chunk * m_chunkSize;
+		count = dgMin (m_chunkSize, m_first + m_count - first);
+	}
+
+	void GetBounds (dgTreeBuildBounds& bounds, dgInt32 first, dgInt32 count, bool parallel)
+	{
+		if (parallel) {
+			SetChunks (first, count);
+			m_world->ParallelFor (m_chunksCount, BoundsKernel, this, 1);
+			bounds.Init();
+			for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+				bounds.Merge (m_chunkBounds[i]);
+			}
+		} else {
+			CalculateBounds (bounds, first, count);
+		}
+	}
+
+	// the binning does not pay off for a handful of leaves, they are sorted along the widest axis and split in the middle
+	dgInt32 SplitSmallRange (const dgTreeBuildBounds& bounds, dgInt32 first, dgInt32 last)
+	{
+		const dgVector extent (bounds.m_maxCentroid - bounds.m_minCentroid);
+		const dgInt32 axis = (extent.m_x >= extent.m_y) ? ((extent.m_x >= extent.m_z) ? 0 : 2) : ((extent.m_y >= extent.m_z) ? 1 : 2);
+		for (dgInt32 i = first + 1; i <= last; i ++) {
+			const dgTreeBuildLeaf leaf (m_leafArray[i]);
+			const dgFloat32 key = leaf.m_minBox[axis] + leaf.m_maxBox[axis];
+			dgInt32 j = i - 1;
+			for (; (j >= first) && ((m_leafArray[j].m_minBox[axis] + m_leafArray[j].m_maxBox[axis]) > key); j --) {
+				m_leafArray[j + 1] = m_leafArray[j];
+			}
+			m_leafArray[j + 1] = leaf;
+		}
+		return first + (last - first + 1) / 2;
+	}
+
+	// returns the index of the first leaf of the right child, parallel splits are only issued from the calling thread
+	dgInt32 Split (const dgTreeBuildBounds& bounds, dgInt32 first, dgInt32 last, dgTreeBuildBounds& leftBounds, dgTreeBuildBounds& rightBounds, bool parallel)
+	{
+		const dgInt32 count = last - first + 1;
+		dgAssert (count >= 3);
+
+		dgInt32 mid = -1;
+		// a leaf that covers most of the range, like a terrain, makes any child that holds it as big as the parent,
+		// so it is pulled out as the right child and the rest of the range is split without it
+		if (bounds.m_maxArea > (DG_TREE_BUILD_LARGE_LEAF * dgTreeBuildArea (bounds.m_minBox, bounds.m_maxBox))) {
+			dgSwap (m_leafArray[bounds.m_maxAreaIndex], m_leafArray[last]);
+			mid = last;
+		} else if (count <= DG_TREE_BUILD_SMALL_RANGE) {
+			mid = SplitSmallRange (bounds, first, last);
+		} else {
+			dgTreeBuildSplit split (bounds);
+			dgTreeBuildBins bins;
+			if (parallel) {
+				SetChunks (first, count);
+				m_split = &split;
+				m_world->ParallelFor (m_chunksCount, BinsKernel, this, 1);
+				bins.Init();
+				for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+					bins.Merge (m_chunkBins[i]);
+				}
+			} else {
+				CalculateBins (bins, split, first, count);
+			}
+
+			if (split.Select (bins)) {
+				// the bins already know how many leaves go to each side
+				dgInt32 leftCount = 0;
+				for (dgInt32 i = 0; i <= split.m_bin; i ++) {
+					leftCount += bins.m_count[split.m_axis][i];
+				}
+				dgAssert ((leftCount > 0) && (leftCount < count));
+
+				if (parallel) {
+					dgInt32 chunkLeft = 0;
+					for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+						m_chunkLeft[i] = chunkLeft;
+						for (dgInt32 j = 0; j <= split.m_bin; j ++) {
+							chunkLeft += m_chunkBins[i].m_count[split.m_axis][j];
+						}
+					}
+					m_leftCount = leftCount;
+					m_world->ParallelFor (m_chunksCount, ScatterKernel, this, 1);
+					leftBounds.Init();
+					rightBounds.Init();
+					for (dgInt32 i = 0; i < m_chunksCount; i ++) {
+						leftBounds.Merge (m_chunkBounds[i]);
+						rightBounds.Merge (m_chunkRightBounds[i]);
+					}
+				} else {
+					Scatter (split, first, count, first, first + leftCount, leftBounds, rightBounds);
+				}
+				memcpy (&m_leafArray[first], &m_tempArray[first], count * sizeof (dgTreeBuildLeaf));
+				return first + leftCount;
+			}
+
+			// all the centroids are in the same spot, any split is as good as any other
+			mid = first + count / 2;
+		}
+
+		GetBounds (leftBounds, first, mid - first, parallel);
+		GetBounds (rightBounds, mid, last - mid + 1, parallel);
+		return mid;
+	}
+
+	void Link (dgBroadPhaseNode* const node, dgBroadPhaseTreeNode* const parent, bool isLeft)
+	{
+		node->m_parent = parent;
+		if (!parent) {
+			m_root = node;
+		} else if (isLeft) {
+			parent->m_left = node;
+		} else {
+			parent->m_right = node;
+		}
+	}
+
+	// splits a range and pushes its two children on the stack, the smaller child on top
+	// so that the stack only grows with the log of the leaf count
+	dgInt32 SplitRange (dgTreeBuildRange* const stack, dgInt32 stackIndex, const dgTreeBuildRange& range, bool parallel)
+	{
+		const dgTreeBuildTask& task = range.m_task;
+		dgAssert ((stackIndex + 2) <= DG_TREE_BUILD_STACK_DEPTH);
+
+		dgInt32 mid = task.m_last;
+		dgTreeBuildBounds leftBounds;
+		dgTreeBuildBounds rightBounds;
+		if ((task.m_last - task.m_first) == 1) {
+			CalculateBounds (leftBounds, task.m_first, 1);
+			CalculateBounds (rightBounds, task.m_last, 1);
+		} else {
+			mid = Split (range.m_bounds, task.m_first, task.m_last, leftBounds, rightBounds, parallel);
+		}
+
+		dgBroadPhaseTreeNode* const node = m_nodeArray[mid - 1];
+		node->SetAABB (range.m_bounds.m_minBox, range.m_bounds.m_maxBox);
+		Link (node, task.m_parent, task.m_isLeft ? true : false);
+
+		dgTreeBuildRange& left = stack[stackIndex + ((mid - task.m_first) < (task.m_last - mid + 1) ? 1 : 0)];
+		left.m_bounds = leftBounds;
+		left.m_task.m_parent = node;
+		left.m_task.m_first = task.m_first;
+		left.m_task.m_last = mid - 1;
+		left.m_task.m_isLeft = 1;
+
+		dgTreeBuildRange& right = stack[stackIndex + ((mid - task.m_first) < (task.m_last - mid + 1) ? 0 : 1)];
+		right.m_bounds = rightBounds;
+		right.m_task.m_parent = node;
+		right.m_task.m_first = mid;
+		right.m_task.m_last = task.m_last;
+		right.m_task.m_isLeft = 0;
+		return stackIndex + 2;
+	}
+
+	void BuildSubTree (const dgTreeBuildTask& task)
+	{
+		dgTreeBuildRange stack[DG_TREE_BUILD_STACK_DEPTH];
+		stack[0].m_task = task;
+		CalculateBounds (stack[0].m_bounds, task.m_first, task.m_last - task.m_first + 1);
+		dgInt32 stackIndex = 1;
+		while (stackIndex) {
+			stackIndex --;
+			const dgTreeBuildRange range (stack[stackIndex]);
+			if (range.m_task.m_first == range.m_task.m_last) {
+				Link (m_leafArray[range.m_task.m_first].m_node, range.m_task.m_parent, range.m_task.m_isLeft ? true : false);
+			} else {
+				stackIndex = SplitRange (stack, stackIndex, range, false);
+			}
+		}
+	}
+
+	void Build (dgInt32 leafCount)
+	{
+		dgTreeBuildTask root;
+		root.m_parent = NULL;
+		root.m_first = 0;
+		root.m_last = leafCount - 1;
+		root.m_isLeft = 0;
+
+		if ((m_world->GetThreadCount() == 1) || (leafCount <= DG_TREE_BUILD_TASK_SIZE)) {
+			BuildSubTree (root);
+		} else {
+			// split the large ranges in parallel until they are small enough to be built by one thread
+			dgTreeBuildRange stack[DG_TREE_BUILD_STACK_DEPTH];
+			stack[0].m_task = root;
+			GetBounds (stack[0].m_bounds, 0, leafCount, true);
+			dgInt32 stackIndex = 1;
+			m_tasksCount = 0;
+			while (stackIndex) {
+				stackIndex --;
+				const dgTreeBuildRange range (stack[stackIndex]);
+				if ((range.m_task.m_last - range.m_task.m_first) < DG_TREE_BUILD_TASK_SIZE) {
+					m_tasks[m_tasksCount] = range.m_task;
+					m_tasksCount ++;
+				} else {
+					stackIndex = SplitRange (stack, stackIndex, range, true);
+				}
+			}
+			m_world->ParallelFor (m_tasksCount, SubTreeKernel, this, 1);
+		}
+	}
+
+	static void BoundsKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			dgInt32 first;
+			dgInt32 count;
+			descriptor->GetChunk (i, first, count);
+			descriptor->CalculateBounds (descriptor->m_chunkBounds[i], first, count);
+		}
+	}
+
+	static void BinsKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			dgInt32 first;
+			dgInt32 count;
+			descriptor->GetChunk (i, first, count);
+			descriptor->CalculateBins (descriptor->m_chunkBins[i], *descriptor->m_split, first, count);
+		}
+	}
+
+	static void ScatterKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		// each chunk writes its left leaves after the left leaves of the chunks before it, and the same for the right leaves
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			dgInt32 first;
+			dgInt32 count;
+			descriptor->GetChunk (i, first, count);
+			const dgInt32 leftIndex = descriptor->m_first + descriptor->m_chunkLeft[i];
+			const dgInt32 rightIndex = descriptor->m_first + descriptor->m_leftCount + (first - descriptor->m_first) - descriptor->m_chunkLeft[i];
+			descriptor->Scatter (*descriptor->m_split, first, count, leftIndex, rightIndex, descriptor->m_chunkBounds[i], descriptor->m_chunkRightBounds[i]);
+		}
+	}
+
+	static void SubTreeKernel (void* const context, dgInt32 start, dgInt32 end, dgInt32 threadID)
+	{
+		dTimeTrackerEvent(__FUNCTION__);
+		dgTreeBuildDescriptor* const descriptor = (dgTreeBuildDescriptor*) context;
+		for (dgInt32 i = start; i < end; i ++) {
+			descriptor->BuildSubTree (descriptor->m_tasks[i]);
+		}
+	}
+
+	dgTreeBuildBounds m_chunkBounds[DG_TREE_BUILD_MAX_CHUNKS];
+	dgTreeBuildBounds m_chunkRightBounds[DG_TREE_BUILD_MAX_CHUNKS];
+	dgTreeBuildBins m_chunkBins[DG_TREE_BUILD_MAX_CHUNKS];
+	dgInt32 m_chunkLeft[DG_TREE_BUILD_MAX_CHUNKS];
+	dgWorld* m_world;
+	dgTreeBuildLeaf* m_leafArray;
+	dgTreeBuildLeaf* m_tempArray;
+	dgBroadPhaseTreeNode** m_nodeArray;
+	dgBroadPhaseNode* m_root;
+	const dgTreeBuildSplit* m_split;
+	dgArray<dgTreeBuildTask> m_tasks;
+	dgInt32 m_tasksCount;
+	dgInt32 m_first;
+	dgInt32 m_count;
+	dgInt32 m_leftCount;
+	dgInt32 m_chunkSize;
+	dgInt32 m_chunksCount;
+} DG_GCC_VECTOR_ALIGMENT;
+
+
+void dgBroadPhase::BuildTreeSAH (dgFitnessList& fitness, dgBroadPhaseNode** const root, dgBroadPhaseNode** const newLeaves, dgInt32 newLeavesCount)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	// the new leaves need one more interior node each, a tree that is a single leaf has no interior node yet
+	const dgInt32 treeLeavesCount = *root ? fitness.GetCount() + 1 : 0;
+	const dgInt32 leafCount = treeLeavesCount + newLeavesCount;
+	const dgInt32 nodesCount = leafCount - 1;
+	dgAssert (nodesCount >= 1);
+	const bool isLeafRoot = *root && (*root)->IsLeafNode();
+	while (fitness.GetCount() < nodesCount) {
+		dgBroadPhaseTreeNode* const node = new (m_world->GetAllocator()) dgBroadPhaseTreeNode();
+		node->m_fitnessNode = fitness.Append(node);
+	}
+
+	m_world->m_solverJacobiansMemory.ResizeIfNecessary (leafCount * 2 * sizeof (dgTreeBuildLeaf) + nodesCount * sizeof (dgBroadPhaseTreeNode*) + 256);
+	dgTreeBuildLeaf* const leafArray = (dgTreeBuildLeaf*)&m_world->m_solverJacobiansMemory[0];
+	dgTreeBuildLeaf* const tempArray = &leafArray[leafCount];
+	dgBroadPhaseTreeNode** const nodeArray = (dgBroadPhaseTreeNode**) &tempArray[leafCount];
+
+	dgInt32 leafNodesCount = 0;
+	dgInt32 index = 0;
+	for (dgFitnessList::dgListNode* nodePtr = fitness.GetFirst(); nodePtr; nodePtr = nodePtr->GetNext()) {
+		dgBroadPhaseTreeNode* const node = nodePtr->GetInfo();
+		nodeArray[index] = node;
+		index ++;
+
+		dgBroadPhaseNode* const children[] = {node->GetLeft(), node->GetRight()};
+		for (dgInt32 i = 0; i < 2; i ++) {
+			dgBroadPhaseNode* const child = children[i];
+			dgBody* const body = child ? child->GetBody() : NULL;
+			if (body || (child && child->IsAggregate())) {
+				if (body) {
+					child->SetAABB(body->m_minAABB, body->m_maxAABB);
+				}
+				dgTreeBuildSetLeaf (leafArray[leafNodesCount], child);
+				leafNodesCount ++;
+			}
+		}
+	}
+	if (isLeafRoot) {
+		dgTreeBuildSetLeaf (leafArray[leafNodesCount], *root);
+		leafNodesCount ++;
+	}
+	for (dgInt32 i = 0; i < newLeavesCount; i ++) {
+		dgTreeBuildSetLeaf (leafArray[leafNodesCount], newLeaves[i]);
+		leafNodesCount ++;
+	}
+	dgAssert (leafNodesCount == leafCount);
+
+	dgTreeBuildDescriptor* const descriptor = new (m_world->GetAllocator()) dgTreeBuildDescriptor(m_world, leafArray, tempArray, nodeArray);
+	descriptor->Build (leafNodesCount);
+	*root = descriptor->m_root;
+	delete descriptor;
+}
+
+dgBroadPhaseNode* dgBroadPhase::BuildSubTreeSAH (dgFitnessList& fitness, dgBroadPhaseNode** const leaves, dgInt32 count)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgAssert (count >= 2);
+	const dgInt32 nodesCount = count - 1;
+	m_world->m_solverJacobiansMemory.ResizeIfNecessary (count * 2 * sizeof (dgTreeBuildLeaf) + nodesCount * sizeof (dgBroadPhaseTreeNode*) + 256);
+	dgTreeBuildLeaf* const leafArray = (dgTreeBuildLeaf*)&m_world->m_solverJacobiansMemory[0];
+	dgTreeBuildLeaf* const tempArray = &leafArray[count];
+	dgBroadPhaseTreeNode** const nodeArray = (dgBroadPhaseTreeNode**) &tempArray[count];
+
+	for (dgInt32 i = 0; i < nodesCount; i ++) {
+		dgBroadPhaseTreeNode* const node = new (m_world->GetAllocator()) dgBroadPhaseTreeNode();
+		node->m_fitnessNode = fitness.Append(node);
+		nodeArray[i] = node;
+	}
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgAssert (!leaves[i]->m_parent);
+		dgTreeBuildSetLeaf (leafArray[i], leaves[i]);
+	}
+
+	dgTreeBuildDescriptor* const descriptor = new (m_world->GetAllocator()) dgTreeBuildDescriptor(m_world, leafArray, tempArray, nodeArray);
+	descriptor->Build (count);
+	dgBroadPhaseNode* const root = descriptor->m_root;
+	delete descriptor;
+	return root;
+}
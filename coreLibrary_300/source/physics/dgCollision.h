@@ -67,6 +67,7 @@ enum dgCollisionID
 	m_userMesh,
 	m_sceneCollision,
 	m_compoundFracturedCollision,
+	m_tiledHeightField,
 
 	// these are for internal use only	
 	m_contactCloud,
@@ -228,6 +229,7 @@ class dgCollision
 		dgCollisionHeightField_RTTI					= 1<<19,
 		dgCollisionScene_RTTI						= 1<<20,
 		dgCollisionCompoundBreakable_RTTI			= 1<<21,
+		dgCollisionHeightFieldTiled_RTTI			= 1<<22,
 	};													 
 	
 	DG_CLASS_ALLOCATOR(allocator)
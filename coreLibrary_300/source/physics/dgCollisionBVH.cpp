@@ -89,16 +89,36 @@ void dgCollisionBVH::SetCollisionRayCastCallback (dgCollisionBVHUserRayCastCallb
 }
 
 
-void dgCollisionBVH::EndBuild(dgInt32 optimize)
+void dgCollisionBVH::EndBuild(dgInt32 optimize, dgInt32 threadCount, dgInt32 quality, dgTreeStats* const stats)
 {
+	dTimeTrackerEvent(__FUNCTION__);
 	dgVector p0;
 	dgVector p1;
 
 	bool state = optimize ? true : false;
 
-	m_builder->End(state);
-	Create (*m_builder, state);
-	CalculateAdjacendy();
+	// the build runs on its own worker threads, the allocator is made thread safe while they are alive
+	dgThreadHive threads (m_allocator);
+	dgThreadHive* const threadPool = (threadCount > 1) ? &threads : NULL;
+	const bool threadSafe = m_allocator->IsThreadSafe();
+	if (threadPool) {
+		m_allocator->SetThreadSafe (true);
+		threads.SetThreadsCount (threadCount);
+	}
+
+	m_builder->End(state, threadPool);
+	Create (*m_builder, state, threadPool, quality);
+	CalculateAdjacendy(threadPool);
+
+	if (threadPool) {
+		// join the workers before the allocator leaves thread safe mode
+		threads.SetThreadsCount (1);
+		m_allocator->SetThreadSafe (threadSafe);
+	}
+
+	if (stats) {
+		GetTreeStats (*stats);
+	}
 	
 	GetAABB (p0, p1);
 	SetCollisionBBox (p0, p1);
@@ -256,7 +276,7 @@ dgFloat32 dgCollisionBVH::RayCast (const dgVector& localP0, const dgVector& loca
 	ray.m_userData = userData;
 	if (!m_userRayCastCallback) {
 		ForAllSectorsRayHit (ray, maxT, RayHit, &ray);
-		if (ray.m_t <= maxT) {
+		if (ray.m_t < maxT) {
 			maxT = ray.m_t; 
 			contactOut.m_normal = ray.m_normal.Scale3 (dgRsqrt (ray.m_normal.DotProduct3(ray.m_normal) + dgFloat32 (1.0e-8f)));
 //			contactOut.m_userId = ray.m_id;
@@ -281,6 +301,41 @@ dgFloat32 dgCollisionBVH::RayCast (const dgVector& localP0, const dgVector& loca
 	return maxT;
 }
 
+void dgCollisionBVH::RayCastPacket (const dgVector* const localP0, const dgVector* const localP1, dgInt32 count, dgFloat32* const maxT, dgContactPoint* const contactOut, void* const userData) const
+{
+	dgAssert ((count >= 1) && (count <= 4));
+	dgAssert (!m_userRayCastCallback);
+	dgBVHRay rays[] = {dgBVHRay (localP0[0], localP1[0]), 
+					   dgBVHRay (localP0[dgMin (1, count - 1)], localP1[dgMin (1, count - 1)]),
+					   dgBVHRay (localP0[dgMin (2, count - 1)], localP1[dgMin (2, count - 1)]),
+					   dgBVHRay (localP0[dgMin (3, count - 1)], localP1[dgMin (3, count - 1)])};
+
+	void* contexts[4];
+	dgFloat32 param[4];
+	const dgFastRayTest* rayArray[4];
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBVHRay& ray = rays[i];
+		ray.m_t = dgMin(maxT[i], dgFloat32 (1.0f));
+		ray.m_me = this;
+		ray.m_userData = userData;
+		param[i] = maxT[i];
+		rayArray[i] = &ray;
+		contexts[i] = &ray;
+	}
+
+	ForAllSectorsRayHitPacket (rayArray, count, param, RayHit, contexts);
+	for (dgInt32 i = 0; i < count; i ++) {
+		const dgBVHRay& ray = rays[i];
+		// same test as the single ray, m_t still equals its start value on a miss and m_normal was never written
+		if (ray.m_t < maxT[i]) {
+			maxT[i] = ray.m_t; 
+			contactOut[i].m_normal = ray.m_normal.Scale3 (dgRsqrt (ray.m_normal.DotProduct3(ray.m_normal) + dgFloat32 (1.0e-8f)));
+			contactOut[i].m_shapeId0 = ray.m_id;
+			contactOut[i].m_shapeId1 = ray.m_id;
+		}
+	}
+}
+
 dgIntersectStatus dgCollisionBVH::GetPolygon (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount, dgFloat32 hitDistance)
 {
 	dgPolygonMeshDesc& data = (*(dgPolygonMeshDesc*) context);
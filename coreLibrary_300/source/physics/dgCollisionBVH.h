@@ -55,13 +55,14 @@ class dgCollisionBVH: public dgCollisionMesh, public dgAABBPolygonSoup
 
 	void BeginBuild();
 	void AddFace (dgInt32 vertexCount, const dgFloat32* const vertexPtr, dgInt32 strideInBytes, dgInt32 faceAttribute);
-	void EndBuild(dgInt32 optimize);
+	void EndBuild(dgInt32 optimize, dgInt32 threadCount = 1, dgInt32 quality = DG_SOUP_BUILD_QUALITY_HIGH, dgTreeStats* const stats = NULL);
 
 	void SetCollisionRayCastCallback (dgCollisionBVHUserRayCastCallback rayCastCallback);
 	dgCollisionBVHUserRayCastCallback GetDebugRayCastCallback() const { return m_userRayCastCallback;} 
 	void GetVertexListIndexList (const dgVector& p0, const dgVector& p1, dgMeshVertexListIndexList &data) const;
 
 	void ForEachFace (dgAABBIntersectCallback callback, void* const context) const;
+	void RayCastPacket (const dgVector* const localP0, const dgVector* const localP1, dgInt32 count, dgFloat32* const maxT, dgContactPoint* const contactOut, void* const userData) const;
 
 	private:
 	static dgFloat32 RayHit (void* const context, const dgFloat32* const polygon, dgInt32 strideInBytes, const dgInt32* const indexArray, dgInt32 indexCount);
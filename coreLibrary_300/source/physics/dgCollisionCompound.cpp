@@ -27,6 +27,7 @@
 #include "dgCollisionInstance.h"
 #include "dgCollisionUserMesh.h"
 #include "dgCollisionHeightField.h"
+#include "dgCollisionHeightFieldTiled.h"
 
 
 //////////////////////////////////////////////////////////////////////
@@ -1557,6 +1558,8 @@ dgInt32 dgCollisionCompound::CalculateContacts (dgBroadPhase::dgPair* const pair
 				contactCount = CalculateContactsToCollisionTree (pair, proxy);
 			} else if (body1->m_collision->IsType (dgCollision::dgCollisionHeightField_RTTI)) {
 				contactCount = CalculateContactsToHeightField (pair, proxy);
+			} else if (body1->m_collision->IsType (dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+				contactCount = CalculateContactsToHeightField (pair, proxy);
 			} else {
 				dgAssert (body1->m_collision->IsType (dgCollision::dgCollisionUserMesh_RTTI));
 				contactCount = CalculateContactsUserDefinedCollision (pair, proxy);
@@ -1924,8 +1927,9 @@ dgInt32 dgCollisionCompound::CalculateContactsToHeightField (dgBroadPhase::dgPai
 	dgCollisionInstance* const terrainInstance = terrainBody->m_collision;
 
 	dgAssert (compoundInstance->GetChildShape() == this);
-	dgAssert (terrainInstance->IsType (dgCollision::dgCollisionHeightField_RTTI));
-	dgCollisionHeightField* const terrainCollision = (dgCollisionHeightField*)terrainInstance->GetChildShape();
+	dgAssert (terrainInstance->IsType (dgCollision::dgCollisionHeightField_RTTI) || terrainInstance->IsType (dgCollision::dgCollisionHeightFieldTiled_RTTI));
+	dgCollisionHeightField* const terrainCollision = terrainInstance->IsType (dgCollision::dgCollisionHeightField_RTTI) ? (dgCollisionHeightField*)terrainInstance->GetChildShape() : NULL;
+	dgCollisionHeightFieldTiled* const tiledTerrainCollision = terrainInstance->IsType (dgCollision::dgCollisionHeightFieldTiled_RTTI) ? (dgCollisionHeightFieldTiled*)terrainInstance->GetChildShape() : NULL;
 
 	proxy.m_body0 = myBody;
 	proxy.m_body1 = terrainBody;
@@ -1953,7 +1957,11 @@ dgInt32 dgCollisionCompound::CalculateContactsToHeightField (dgBroadPhase::dgPai
 		dgVector size (data.m_absMatrix.UnrotateVector(me->m_size));
 		dgVector p0 (origin - size);
 		dgVector p1 (origin + size);
-		terrainCollision->GetLocalAABB (p0, p1, nodeProxi.m_p0, nodeProxi.m_p1);
+		if (terrainCollision) {
+			terrainCollision->GetLocalAABB (p0, p1, nodeProxi.m_p0, nodeProxi.m_p1);
+		} else {
+			tiledTerrainCollision->GetLocalAABB (p0, p1, nodeProxi.m_p0, nodeProxi.m_p1);
+		}
 		//nodeProxi.m_size = (nodeProxi.m_p1 - nodeProxi.m_p0).Scale3 (dgFloat32 (0.5f));
 		//nodeProxi.m_origin = (nodeProxi.m_p1 + nodeProxi.m_p0).Scale3 (dgFloat32 (0.5f));
 		nodeProxi.m_size = (nodeProxi.m_p1 - nodeProxi.m_p0).CompProduct4(dgVector::m_half);
@@ -2256,6 +2264,7 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 	dgInt32 stack = 1;
 	stackPool[0].m_myNode = m_root;
 	stackPool[0].m_treeNode = treeCollision->GetRootNode();
+	treeCollision->GetNodeAABB(stackPool[0].m_treeNode, stackPool[0].m_treeNodeP0, stackPool[0].m_treeNodeP1);
 	stackPool[0].m_treeNodeIsLeaf = 0;
 
 	dgNodeBase nodeProxi;
@@ -2280,9 +2289,11 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 		dgVector p0;
 		dgVector p1;
 
-		treeCollision->GetNodeAABB(other, p0, p1);
-		nodeProxi.m_p0 = p0.CompProduct4(treeScale);
-		nodeProxi.m_p1 = p1.CompProduct4(treeScale);
+		// the entry is overwritten by the first push, the tree node box is read first
+		const dgVector otherP0 (stackEntry->m_treeNodeP0);
+		const dgVector otherP1 (stackEntry->m_treeNodeP1);
+		nodeProxi.m_p0 = otherP0.CompProduct4(treeScale);
+		nodeProxi.m_p1 = otherP1.CompProduct4(treeScale);
 
 		p0 = nodeProxi.m_p0.CompProduct4(dgVector::m_half);
 		p1 = nodeProxi.m_p1.CompProduct4(dgVector::m_half);
@@ -2333,43 +2344,67 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 			} else if (me->m_type == m_leaf) {
 				void* const frontNode = treeCollision->GetFrontNode(other);
 				void* const backNode = treeCollision->GetBackNode(other);
+				dgVector backP0;
+				dgVector backP1;
+				dgVector frontP0;
+				dgVector frontP1;
+				if (backNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 0, backP0, backP1);
+				}
+				if (frontNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 1, frontP0, frontP1);
+				}
 				if (backNode && frontNode) {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 				} else if (backNode && !frontNode) {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 
 					stack++;
 
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 				} else if (!backNode && frontNode) {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 				} else {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 				}
@@ -2377,12 +2412,16 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 			} else if (treeNodeIsLeaf) {
 				stackPool[stack].m_myNode = me->m_left;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = 1;
 				stack++;
 				dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNodeBase*)));
 
 				stackPool[stack].m_myNode = me->m_right;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = 1;
 				stack++;
 				dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNodeBase*)));
@@ -2391,51 +2430,79 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 				dgAssert (me->m_type == m_node);
 				void* const frontNode = treeCollision->GetFrontNode(other);
 				void* const backNode = treeCollision->GetBackNode(other);
+				dgVector backP0;
+				dgVector backP1;
+				dgVector frontP0;
+				dgVector frontP1;
+				if (backNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 0, backP0, backP1);
+				}
+				if (frontNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 1, frontP0, frontP1);
+				}
 				if (backNode && frontNode) {
 					stackPool[stack].m_myNode = (dgNodeBase*) me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = (dgNodeBase*) me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 				} else if (backNode && !frontNode) {
 					stackPool[stack].m_myNode = (dgNodeBase*) me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_left;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_right;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 				} else if (!backNode && frontNode) {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_left;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_right;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 				} else {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 				}
@@ -2444,11 +2511,15 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTree (dgBroadPhase::dgP
 				dgAssert (me->m_type == m_node);
 				stackPool[stack].m_myNode = me->m_left;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = treeNodeIsLeaf;
 				stack++;
 
 				stackPool[stack].m_myNode = me->m_right;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = treeNodeIsLeaf;
 				stack++;
 			}
@@ -2835,6 +2906,7 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 	dgInt32 stack = 1;
 	stackPool[0].m_myNode = m_root;
 	stackPool[0].m_treeNode = treeCollision->GetRootNode();
+	treeCollision->GetNodeAABB(stackPool[0].m_treeNode, stackPool[0].m_treeNodeP0, stackPool[0].m_treeNodeP1);
 	stackPool[0].m_treeNodeIsLeaf = 0;
 
 	dgNodeBase nodeProxi;
@@ -2867,9 +2939,11 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 		dgVector p0;
 		dgVector p1;
 
-		treeCollision->GetNodeAABB(other, p0, p1);
-		nodeProxi.m_p0 = p0.CompProduct4(treeScale);
-		nodeProxi.m_p1 = p1.CompProduct4(treeScale);
+		// the entry is overwritten by the first push, the tree node box is read first
+		const dgVector otherP0 (stackEntry->m_treeNodeP0);
+		const dgVector otherP1 (stackEntry->m_treeNodeP1);
+		nodeProxi.m_p0 = otherP0.CompProduct4(treeScale);
+		nodeProxi.m_p1 = otherP1.CompProduct4(treeScale);
 
 		p0 = nodeProxi.m_p0.CompProduct4(dgVector::m_half);
 		p1 = nodeProxi.m_p1.CompProduct4(dgVector::m_half);
@@ -2946,41 +3020,65 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 			} else if (me->m_type == m_leaf) {
 				void* const frontNode = treeCollision->GetFrontNode(other);
 				void* const backNode = treeCollision->GetBackNode(other);
+				dgVector backP0;
+				dgVector backP1;
+				dgVector frontP0;
+				dgVector frontP1;
+				if (backNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 0, backP0, backP1);
+				}
+				if (frontNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 1, frontP0, frontP1);
+				}
 
 				if (backNode && frontNode) {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 				} else if (backNode && !frontNode) {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 				} else if (!backNode && frontNode) {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 				} else {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 				}
@@ -2989,12 +3087,16 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 
 				stackPool[stack].m_myNode = me->m_left;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = 1;
 				stack++;
 				dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNodeBase*)));
 
 				stackPool[stack].m_myNode = me->m_right;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = 1;
 				stack++;
 				dgAssert (stack < dgInt32 (sizeof (stackPool) / sizeof (dgNodeBase*)));
@@ -3004,29 +3106,49 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 				dgAssert (me->m_type == m_node);
 				void* const frontNode = treeCollision->GetFrontNode(other);
 				void* const backNode = treeCollision->GetBackNode(other);
+				dgVector backP0;
+				dgVector backP1;
+				dgVector frontP0;
+				dgVector frontP1;
+				if (backNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 0, backP0, backP1);
+				}
+				if (frontNode) {
+					treeCollision->GetChildNodeAABB(other, otherP0, otherP1, 1, frontP0, frontP1);
+				}
 				if (backNode && frontNode) {
 					stackPool[stack].m_myNode = (dgNodeBase*) me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = (dgNodeBase*) me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 				} else if (backNode && !frontNode) {
 					stackPool[stack].m_myNode = (dgNodeBase*) me;
 					stackPool[stack].m_treeNode = backNode;
+					stackPool[stack].m_treeNodeP0 = backP0;
+					stackPool[stack].m_treeNodeP1 = backP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_left;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_right;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
@@ -3034,22 +3156,30 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = frontNode;
+					stackPool[stack].m_treeNodeP0 = frontP0;
+					stackPool[stack].m_treeNodeP1 = frontP1;
 					stackPool[stack].m_treeNodeIsLeaf = 0;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_left;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 					stackPool[stack].m_myNode = me->m_right;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 
 				} else {
 					stackPool[stack].m_myNode = me;
 					stackPool[stack].m_treeNode = other;
+					stackPool[stack].m_treeNodeP0 = otherP0;
+					stackPool[stack].m_treeNodeP1 = otherP1;
 					stackPool[stack].m_treeNodeIsLeaf = 1;
 					stack++;
 				}
@@ -3058,11 +3188,15 @@ dgInt32 dgCollisionCompound::CalculateContactsToCollisionTreeContinue (dgBroadPh
 				dgAssert (me->m_type == m_node);
 				stackPool[stack].m_myNode = me->m_left;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = treeNodeIsLeaf;
 				stack++;
 
 				stackPool[stack].m_myNode = me->m_right;
 				stackPool[stack].m_treeNode = other;
+				stackPool[stack].m_treeNodeP0 = otherP0;
+				stackPool[stack].m_treeNodeP1 = otherP1;
 				stackPool[stack].m_treeNodeIsLeaf = treeNodeIsLeaf;
 				stack++;
 			}
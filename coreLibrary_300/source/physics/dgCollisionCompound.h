@@ -122,13 +122,16 @@ class dgCollisionCompound: public dgCollision
 	} DG_GCC_VECTOR_ALIGMENT;
 
 	protected:
+	DG_MSC_VECTOR_ALIGMENT
 	class dgNodePairs
 	{
 		public:
+		dgVector m_treeNodeP0;
+		dgVector m_treeNodeP1;
 		const void* m_treeNode;
 		dgNodeBase* m_myNode;
 		dgInt32 m_treeNodeIsLeaf;
-	};
+	} DG_GCC_VECTOR_ALIGMENT;
 
 	class dgSpliteInfo;
 	class dgHeapNodePair;
@@ -62,6 +62,7 @@ dgCollisionHeightField::dgCollisionHeightField(
 	,m_height(height)
 	,m_diagonalMode (dgCollisionHeightFieldGridConstruction  (dgClamp (contructionMode, dgInt32 (m_normalDiagonals), dgInt32 (m_starInvertexDiagonals))))
 	,m_horizontalDisplacement(NULL)
+	,m_minMaxPyramid(NULL)
 	,m_verticalScale(verticalScale)
 	,m_horizontalScale_x(horizontalScale_x)
 	,m_horizontalScaleInv_x (dgFloat32 (1.0f) / m_horizontalScale_x)
@@ -71,6 +72,9 @@ dgCollisionHeightField::dgCollisionHeightField(
 	,m_horizontalDisplacementScale_z(dgFloat32(1.0f))
 	,m_userRayCastCallback(NULL)
 	,m_elevationDataType(elevationDataType)
+	,m_mappedImage(false)
+	,m_mappedDisplacement(false)
+	,m_pyramidLevelsCount(0)
 {
 	m_rtti |= dgCollisionHeightField_RTTI;
 
@@ -247,6 +251,7 @@ dgCollisionHeightField::dgCollisionHeightField(
 	m_instanceData->m_refCount ++;
 
 	CalculateAABB();
+	BuildMinMaxPyramid();
 	SetCollisionBBox(m_minBox, m_maxBox);
 }
 
@@ -259,6 +264,9 @@ dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserial
 
 	m_userRayCastCallback = NULL;
 	m_horizontalDisplacement = NULL;
+	m_elevationMap = NULL;
+	m_minMaxPyramid = NULL;
+	m_pyramidLevelsCount = 0;
 	deserialization (userData, &m_width, sizeof (dgInt32));
 	deserialization (userData, &m_height, sizeof (dgInt32));
 	deserialization (userData, &m_diagonalMode, sizeof (dgInt32));
@@ -272,35 +280,31 @@ dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserial
 	deserialization (userData, &m_maxBox.m_x, sizeof (dgVector)); 
 
 	m_elevationDataType = dgElevationType (elevationDataType);
-
-	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
-	m_atributeMap = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
-	m_diagonals = (dgInt8 *)dgMallocStack(attibutePaddedMapSize * sizeof (dgInt8));
+	m_mappedImage = dgIsMappedImage (deserialization);
+	m_mappedDisplacement = m_mappedImage;
 
 	switch (m_elevationDataType) 
 	{
 		case m_float32Bit:
 		{
-			m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgFloat32));
-			deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
+			m_elevationMap = dgDeserializeArray (deserialization, userData, m_width * m_height * sizeof (dgFloat32));
 			break;
 		}
 
 		case m_unsigned16Bit:
 		{
-			m_elevationMap = dgMallocStack(m_width * m_height * sizeof (dgUnsigned16));
-			deserialization (userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
+			m_elevationMap = dgDeserializeArray (deserialization, userData, m_width * m_height * sizeof (dgUnsigned16));
 			break;
 		}
 	}
-	deserialization (userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
-	deserialization (userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
+	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
+	m_atributeMap = (dgInt8 *)dgDeserializeArray (deserialization, userData, attibutePaddedMapSize * sizeof (dgInt8));
+	m_diagonals = (dgInt8 *)dgDeserializeArray (deserialization, userData, attibutePaddedMapSize * sizeof (dgInt8));
 
 	dgInt32 hasDisplacement = m_horizontalDisplacement ? 1 : 0;
 	deserialization (userData, &hasDisplacement, sizeof (hasDisplacement));
 	if (hasDisplacement) {
-		m_horizontalDisplacement = (dgUnsigned16*) dgMallocStack(m_width * m_height * sizeof (dgUnsigned16));
-		deserialization (userData, m_horizontalDisplacement, m_width * m_height * sizeof (dgUnsigned16));
+		m_horizontalDisplacement = (dgUnsigned16*) dgDeserializeArray (deserialization, userData, m_width * m_height * sizeof (dgUnsigned16));
 	}
 
 	m_horizontalScaleInv_x = dgFloat32 (1.0f) / m_horizontalScale_x;
@@ -322,6 +326,12 @@ dgCollisionHeightField::dgCollisionHeightField (dgWorld* const world, dgDeserial
 	m_instanceData = (dgPerIntanceData*)nodeData->GetInfo();
 
 	m_instanceData->m_refCount ++;
+
+	// the pyramid is not part of the serialized data, it is rebuilt from the elevation map.
+	// a truncated mapped image leaves the map out, the world then discards the shape
+	if (m_elevationMap) {
+		BuildMinMaxPyramid();
+	}
 	SetCollisionBBox(m_minBox, m_maxBox);
 }
 
@@ -333,13 +343,19 @@ dgCollisionHeightField::~dgCollisionHeightField(void)
 		delete m_instanceData;
 		world->m_perInstanceData.Remove(DG_HIGHTFIELD_DATA_ID);
 	}
-	dgFreeStack(m_elevationMap);
-	dgFreeStack(m_atributeMap);
-	dgFreeStack(m_diagonals);
+	if (!m_mappedImage) {
+		dgFreeStack(m_elevationMap);
+		dgFreeStack(m_atributeMap);
+		dgFreeStack(m_diagonals);
+	}
 
-	if (m_horizontalDisplacement) {
+	if (m_horizontalDisplacement && !m_mappedDisplacement) {
 		dgFreeStack(m_horizontalDisplacement);
 	}
+
+	if (m_minMaxPyramid) {
+		dgFreeStack(m_minMaxPyramid);
+	}
 }
 
 void dgCollisionHeightField::Serialize(dgSerialize callback, void* const userData) const
@@ -364,24 +380,24 @@ void dgCollisionHeightField::Serialize(dgSerialize callback, void* const userDat
 	{
 		case m_float32Bit:
 		{
-			callback (userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
+			dgSerializeArray (callback, userData, m_elevationMap, m_width * m_height * sizeof (dgFloat32));
 			break;
 		}
 		case m_unsigned16Bit:
 		{
-			callback (userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
+			dgSerializeArray (callback, userData, m_elevationMap, m_width * m_height * sizeof (dgUnsigned16));
 			break;
 		}
 	}
 
 	dgInt32 attibutePaddedMapSize = (m_width * m_height + 4) & -4; 
-	callback (userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
-	callback (userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
+	dgSerializeArray (callback, userData, m_atributeMap, attibutePaddedMapSize * sizeof (dgInt8));
+	dgSerializeArray (callback, userData, m_diagonals, attibutePaddedMapSize * sizeof (dgInt8));
 	
 	dgInt32 hasDisplacement = m_horizontalDisplacement ? 1 : 0;
 	callback (userData, &hasDisplacement, sizeof (hasDisplacement));
 	if (hasDisplacement) {
-		callback (userData, m_horizontalDisplacement, m_width * m_height * sizeof (dgUnsigned16));
+		dgSerializeArray (callback, userData, m_horizontalDisplacement, m_width * m_height * sizeof (dgUnsigned16));
 	}
 }
 
@@ -392,10 +408,11 @@ void dgCollisionHeightField::SetCollisionRayCastCallback (dgCollisionHeightField
 
 void dgCollisionHeightField::SetHorizontalDisplacement (const dgUnsigned16* const displacemnet, dgFloat32 scale)
 {
-	if (m_horizontalDisplacement) {
+	if (m_horizontalDisplacement && !m_mappedDisplacement) {
 		dgFreeStack(m_horizontalDisplacement);
-		m_horizontalDisplacement = NULL;
 	}
+	m_horizontalDisplacement = NULL;
+	m_mappedDisplacement = false;
 
 	m_horizontalDisplacementScale_x = scale;
 	if (displacemnet) {
@@ -484,6 +501,283 @@ void dgCollisionHeightField::CalculateAABB()
 	m_maxBox = dgVector (dgFloat32 (m_width - 1) * m_horizontalScale_x, y1 * m_verticalScale, dgFloat32 (m_height-1) * m_horizontalScale_z, dgFloat32 (0.0f)); 
 }
 
+void dgCollisionHeightField::SetMinMaxPyramid (bool state)
+{
+	if (m_minMaxPyramid) {
+		dgFreeStack(m_minMaxPyramid);
+		m_minMaxPyramid = NULL;
+		m_pyramidLevelsCount = 0;
+	}
+	if (state) {
+		BuildMinMaxPyramid();
+	}
+}
+
+// each level halves the one below it, until the top level is a single node. 
+// the nodes are pairs of min max elevations of the same type as the elevation map
+void dgCollisionHeightField::BuildMinMaxPyramid ()
+{
+	dgInt32 width = (m_width - 1 + DG_HEIGHTFIELD_PYRAMID_BLOCK - 1) / DG_HEIGHTFIELD_PYRAMID_BLOCK;
+	dgInt32 height = (m_height - 1 + DG_HEIGHTFIELD_PYRAMID_BLOCK - 1) / DG_HEIGHTFIELD_PYRAMID_BLOCK;
+	if ((width <= 1) && (height <= 1)) {
+		// the map is a single block, the pyramid does not save anything
+		return;
+	}
+
+	dgInt32 nodesCount = 0;
+	m_pyramidLevelsCount = 0;
+	for (bool done = false; !done; ) {
+		dgAssert (m_pyramidLevelsCount < DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS);
+		done = (width == 1) && (height == 1);
+		m_pyramidLevels[m_pyramidLevelsCount].m_offset = nodesCount;
+		m_pyramidLevels[m_pyramidLevelsCount].m_width = width;
+		m_pyramidLevels[m_pyramidLevelsCount].m_height = height;
+		m_pyramidLevelsCount ++;
+		nodesCount += width * height;
+		width = (width + 1) >> 1;
+		height = (height + 1) >> 1;
+	}
+
+	switch (m_elevationDataType) 
+	{
+		case m_float32Bit:
+		{
+			m_minMaxPyramid = dgMallocStack(2 * nodesCount * sizeof (dgFloat32));
+			BuildMinMaxPyramid ((dgFloat32*)m_elevationMap, (dgFloat32*)m_minMaxPyramid);
+			break;
+		}
+
+		case m_unsigned16Bit:
+		{
+			m_minMaxPyramid = dgMallocStack(2 * nodesCount * sizeof (dgUnsigned16));
+			BuildMinMaxPyramid ((dgUnsigned16*)m_elevationMap, (dgUnsigned16*)m_minMaxPyramid);
+			break;
+		}
+	}
+}
+
+template<class T>
+void dgCollisionHeightField::BuildMinMaxPyramid (const T* const elevation, T* const pyramid) const
+{
+	const dgPyramidLevel& leafs = m_pyramidLevels[0];
+	for (dgInt32 z = 0; z < leafs.m_height; z ++) {
+		for (dgInt32 x = 0; x < leafs.m_width; x ++) {
+			dgInt32 x0;
+			dgInt32 x1;
+			dgInt32 z0;
+			dgInt32 z1;
+			GetPyramidNodeBox (0, x, z, x0, x1, z0, z1);
+			T minHeight = elevation[z0 * m_width + x0];
+			T maxHeight = minHeight;
+			for (dgInt32 i = z0; i <= z1; i ++) {
+				const T* const row = &elevation[i * m_width];
+				for (dgInt32 j = x0; j <= x1; j ++) {
+					minHeight = dgMin (minHeight, row[j]);
+					maxHeight = dgMax (maxHeight, row[j]);
+				}
+			}
+			T* const node = &pyramid[2 * (leafs.m_offset + z * leafs.m_width + x)];
+			node[0] = minHeight;
+			node[1] = maxHeight;
+		}
+	}
+
+	for (dgInt32 level = 1; level < m_pyramidLevelsCount; level ++) {
+		const dgPyramidLevel& parents = m_pyramidLevels[level];
+		const dgPyramidLevel& children = m_pyramidLevels[level - 1];
+		for (dgInt32 z = 0; z < parents.m_height; z ++) {
+			for (dgInt32 x = 0; x < parents.m_width; x ++) {
+				const T* child = &pyramid[2 * (children.m_offset + 2 * z * children.m_width + 2 * x)];
+				T minHeight = child[0];
+				T maxHeight = child[1];
+				for (dgInt32 i = 2 * z; i < dgMin (2 * z + 2, children.m_height); i ++) {
+					for (dgInt32 j = 2 * x; j < dgMin (2 * x + 2, children.m_width); j ++) {
+						child = &pyramid[2 * (children.m_offset + i * children.m_width + j)];
+						minHeight = dgMin (minHeight, child[0]);
+						maxHeight = dgMax (maxHeight, child[1]);
+					}
+				}
+				T* const node = &pyramid[2 * (parents.m_offset + z * parents.m_width + x)];
+				node[0] = minHeight;
+				node[1] = maxHeight;
+			}
+		}
+	}
+}
+
+// the range of samples of a node, the last sample of a node is the first of the next
+void dgCollisionHeightField::GetPyramidNodeBox (dgInt32 level, dgInt32 x, dgInt32 z, dgInt32& x0, dgInt32& x1, dgInt32& z0, dgInt32& z1) const
+{
+	const dgInt32 cells = DG_HEIGHTFIELD_PYRAMID_BLOCK << level;
+	x0 = x * cells;
+	z0 = z * cells;
+	x1 = dgMin (x0 + cells, m_width - 1);
+	z1 = dgMin (z0 + cells, m_height - 1);
+}
+
+void dgCollisionHeightField::GetPyramidNodeRange (dgInt32 level, dgInt32 x, dgInt32 z, dgFloat32& minHeight, dgFloat32& maxHeight) const
+{
+	const dgPyramidLevel& nodes = m_pyramidLevels[level];
+	const dgInt32 index = 2 * (nodes.m_offset + z * nodes.m_width + x);
+	switch (m_elevationDataType) 
+	{
+		case m_float32Bit:
+		{
+			const dgFloat32* const pyramid = (dgFloat32*)m_minMaxPyramid;
+			minHeight = pyramid[index] * m_verticalScale;
+			maxHeight = pyramid[index + 1] * m_verticalScale;
+			break;
+		}
+
+		case m_unsigned16Bit:
+		default:
+		{
+			const dgUnsigned16* const pyramid = (dgUnsigned16*)m_minMaxPyramid;
+			minHeight = dgFloat32 (pyramid[index]) * m_verticalScale;
+			maxHeight = dgFloat32 (pyramid[index + 1]) * m_verticalScale;
+			break;
+		}
+	}
+}
+
+void dgCollisionHeightField::ScanElevationRange (dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const
+{
+	minHeight = dgFloat32 (1.0e10f);
+	maxHeight = dgFloat32 (-1.0e10f);
+	dgInt32 base = z0 * m_width;
+	switch (m_elevationDataType) 
+	{
+		case m_float32Bit:
+		{
+			const dgFloat32* const elevation = (dgFloat32*)m_elevationMap;
+			for (dgInt32 z = z0; z <= z1; z ++) {
+				for (dgInt32 x = x0; x <= x1; x ++) {
+					dgFloat32 high = elevation[base + x];
+					if (high < minHeight) {
+						minHeight = high;
+					}
+					if (high > maxHeight) {
+						maxHeight = high;
+					}
+				}
+				base += m_width;
+			}
+			break;
+		}
+
+		case m_unsigned16Bit:
+		{
+			const dgUnsigned16* const elevation = (dgUnsigned16*)m_elevationMap;
+			for (dgInt32 z = z0; z <= z1; z ++) {
+				for (dgInt32 x = x0; x <= x1; x ++) {
+					dgFloat32 high = dgFloat32 (elevation[base + x]);
+					if (high < minHeight) {
+						minHeight = high;
+					}
+					if (high > maxHeight) {
+						maxHeight = high;
+					}
+				}
+				base += m_width;
+			}
+			break;
+		}
+	}
+
+	minHeight *= m_verticalScale;
+	maxHeight *= m_verticalScale;
+}
+
+// finds the elevation range of the samples in the rectangle [x0, x1] x [z0, z1] that can touch the vertical range [minY, maxY].
+// with the pyramid the blocks of samples that are all above or all below the range are skipped, and the rectangle 
+// shrinks to the blocks that are left. returns false if no sample can touch the range.
+bool dgCollisionHeightField::GetElevationRange (dgInt32& x0, dgInt32& x1, dgInt32& z0, dgInt32& z1, dgFloat32 minY, dgFloat32 maxY, dgFloat32& minHeight, dgFloat32& maxHeight) const
+{
+	if (!m_minMaxPyramid) {
+		ScanElevationRange (x0, x1, z0, z1, minHeight, maxHeight);
+		return !((maxHeight < minY) || (minHeight > maxY));
+	}
+
+	dgInt32 stack[DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS * 4][3];
+
+	dgInt32 boxX0 = m_width;
+	dgInt32 boxX1 = -1;
+	dgInt32 boxZ0 = m_height;
+	dgInt32 boxZ1 = -1;
+	minHeight = dgFloat32 (1.0e10f);
+	maxHeight = dgFloat32 (-1.0e10f);
+
+	stack[0][0] = m_pyramidLevelsCount - 1;
+	stack[0][1] = 0;
+	stack[0][2] = 0;
+	dgInt32 stackIndex = 1;
+	while (stackIndex) {
+		stackIndex --;
+		const dgInt32 level = stack[stackIndex][0];
+		const dgInt32 x = stack[stackIndex][1];
+		const dgInt32 z = stack[stackIndex][2];
+
+		dgInt32 nodeX0;
+		dgInt32 nodeX1;
+		dgInt32 nodeZ0;
+		dgInt32 nodeZ1;
+		GetPyramidNodeBox (level, x, z, nodeX0, nodeX1, nodeZ0, nodeZ1);
+		const dgInt32 clipX0 = dgMax (nodeX0, x0);
+		const dgInt32 clipX1 = dgMin (nodeX1, x1);
+		const dgInt32 clipZ0 = dgMax (nodeZ0, z0);
+		const dgInt32 clipZ1 = dgMin (nodeZ1, z1);
+		if ((clipX0 > clipX1) || (clipZ0 > clipZ1)) {
+			continue;
+		}
+
+		dgFloat32 nodeMinHeight;
+		dgFloat32 nodeMaxHeight;
+		GetPyramidNodeRange (level, x, z, nodeMinHeight, nodeMaxHeight);
+		if ((nodeMaxHeight < minY) || (nodeMinHeight > maxY)) {
+			continue;
+		}
+
+		const bool inside = (clipX0 == nodeX0) && (clipX1 == nodeX1) && (clipZ0 == nodeZ0) && (clipZ1 == nodeZ1);
+		if (!inside || (nodeMinHeight < minY) || (nodeMaxHeight > maxY)) {
+			if (level) {
+				const dgPyramidLevel& children = m_pyramidLevels[level - 1];
+				for (dgInt32 i = 2 * z; i < dgMin (2 * z + 2, children.m_height); i ++) {
+					for (dgInt32 j = 2 * x; j < dgMin (2 * x + 2, children.m_width); j ++) {
+						dgAssert (stackIndex < dgInt32 (sizeof (stack) / sizeof (stack[0])));
+						stack[stackIndex][0] = level - 1;
+						stack[stackIndex][1] = j;
+						stack[stackIndex][2] = i;
+						stackIndex ++;
+					}
+				}
+				continue;
+			}
+			if (!inside) {
+				ScanElevationRange (clipX0, clipX1, clipZ0, clipZ1, nodeMinHeight, nodeMaxHeight);
+				if ((nodeMaxHeight < minY) || (nodeMinHeight > maxY)) {
+					continue;
+				}
+			}
+		}
+
+		minHeight = dgMin (minHeight, nodeMinHeight);
+		maxHeight = dgMax (maxHeight, nodeMaxHeight);
+		boxX0 = dgMin (boxX0, clipX0);
+		boxX1 = dgMax (boxX1, clipX1);
+		boxZ0 = dgMin (boxZ0, clipZ0);
+		boxZ1 = dgMax (boxZ1, clipZ1);
+	}
+
+	if (boxX1 < 0) {
+		return false;
+	}
+	x0 = boxX0;
+	x1 = boxX1;
+	z0 = boxZ0;
+	z1 = boxZ1;
+	return true;
+}
+
 void dgCollisionHeightField::GetCollisionInfo(dgCollisionInfo* const info) const
 {
 	dgCollision::GetCollisionInfo(info);
@@ -602,6 +896,112 @@ dgFloat32 dgCollisionHeightField::RayCastCell (const dgFastRayTest& ray, dgInt32
 }
 
 dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const
+{
+	dgInt32 xIndex0 = 0;
+	dgInt32 zIndex0 = 0;
+	dgVector normalOut (dgFloat32 (0.0f));
+	dgFloat32 t = m_minMaxPyramid ? RayCastPyramid (q0, q1, maxT, normalOut, xIndex0, zIndex0) : RayCastGrid (q0, q1, maxT, normalOut, xIndex0, zIndex0);
+	if (t < maxT) {
+		// copy the data into the descriptor
+		contactOut.m_normal = normalOut.Scale3 (dgRsqrt (normalOut.DotProduct3(normalOut)));
+		contactOut.m_shapeId0 = m_atributeMap[zIndex0 * m_width + xIndex0];
+		contactOut.m_shapeId1 = m_atributeMap[zIndex0 * m_width + xIndex0];
+
+		if (m_userRayCastCallback) {
+			dgVector normal (body->GetCollision()->GetGlobalMatrix().RotateVector (contactOut.m_normal));
+			m_userRayCastCallback (body, this, t, xIndex0, zIndex0, &normal, dgInt32 (contactOut.m_shapeId0), userData);
+		}
+		return t;
+	}
+
+	// if no cell was hit, return a large value
+	return dgFloat32 (1.2f);
+}
+
+// visits the pyramid nodes hit by the ray from the closest to the farthest, the cells of the leafs are tested one by one
+dgFloat32 dgCollisionHeightField::RayCastPyramid (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgVector& normalOut, dgInt32& xIndex, dgInt32& zIndex) const
+{
+	dgInt32 stack[DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS * 4][3];
+	dgFloat32 distance[DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS * 4];
+
+	dgFastRayTest ray (q0, q1);
+	const dgVector scale (m_horizontalScale_x, dgFloat32 (1.0f), m_horizontalScale_z, dgFloat32 (0.0f));
+
+	dgFloat32 t = dgFloat32 (1.2f);
+	stack[0][0] = m_pyramidLevelsCount - 1;
+	stack[0][1] = 0;
+	stack[0][2] = 0;
+	distance[0] = dgFloat32 (0.0f);
+	dgInt32 stackIndex = 1;
+	while (stackIndex) {
+		stackIndex --;
+		if (distance[stackIndex] >= maxT) {
+			// the stack is sorted, all the other nodes are farther away
+			break;
+		}
+
+		const dgInt32 level = stack[stackIndex][0];
+		const dgInt32 x = stack[stackIndex][1];
+		const dgInt32 z = stack[stackIndex][2];
+		if (!level) {
+			dgInt32 x0;
+			dgInt32 x1;
+			dgInt32 z0;
+			dgInt32 z1;
+			GetPyramidNodeBox (0, x, z, x0, x1, z0, z1);
+			for (dgInt32 i = z0; i < z1; i ++) {
+				for (dgInt32 j = x0; j < x1; j ++) {
+					dgVector normal;
+					dgFloat32 dist = RayCastCell (ray, j, i, normal, maxT);
+					if (dist < maxT) {
+						t = dist;
+						maxT = dist;
+						normalOut = normal;
+						xIndex = j;
+						zIndex = i;
+					}
+				}
+			}
+		} else {
+			const dgPyramidLevel& children = m_pyramidLevels[level - 1];
+			for (dgInt32 i = 2 * z; i < dgMin (2 * z + 2, children.m_height); i ++) {
+				for (dgInt32 j = 2 * x; j < dgMin (2 * x + 2, children.m_width); j ++) {
+					dgInt32 x0;
+					dgInt32 x1;
+					dgInt32 z0;
+					dgInt32 z1;
+					dgFloat32 minHeight;
+					dgFloat32 maxHeight;
+					GetPyramidNodeBox (level - 1, j, i, x0, x1, z0, z1);
+					GetPyramidNodeRange (level - 1, j, i, minHeight, maxHeight);
+					const dgVector minBox (dgVector (dgFloat32 (x0), minHeight, dgFloat32 (z0), dgFloat32 (0.0f)).CompProduct4(scale) - m_padding);
+					const dgVector maxBox (dgVector (dgFloat32 (x1), maxHeight, dgFloat32 (z1), dgFloat32 (0.0f)).CompProduct4(scale) + m_padding);
+					dgFloat32 dist = ray.BoxIntersect (minBox, maxBox);
+					if (dist < maxT) {
+						// insert the node sorted so that the closest one is at the top of the stack
+						dgInt32 index = stackIndex;
+						for (; (index > 0) && (distance[index - 1] < dist); index --) {
+							distance[index] = distance[index - 1];
+							stack[index][0] = stack[index - 1][0];
+							stack[index][1] = stack[index - 1][1];
+							stack[index][2] = stack[index - 1][2];
+						}
+						dgAssert (stackIndex < dgInt32 (sizeof (stack) / sizeof (stack[0])));
+						distance[index] = dist;
+						stack[index][0] = level - 1;
+						stack[index][1] = j;
+						stack[index][2] = i;
+						stackIndex ++;
+					}
+				}
+			}
+		}
+	}
+	return t;
+}
+
+// walks the cells under the ray with a 2d dda, and stops at the first hit
+dgFloat32 dgCollisionHeightField::RayCastGrid (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgVector& normalOut, dgInt32& xIndex, dgInt32& zIndex) const
 {
 	dgVector boxP0;
 	dgVector boxP1;
@@ -615,7 +1015,6 @@ dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q
 	// clip the line against the bounding box
 	if (dgRayBoxClip (p0, p1, boxP0, boxP1)) { 
 		dgVector dp (p1 - p0);
-		dgVector normalOut (dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f), dgFloat32 (0.0f));
 
 		dgFloat32 scale_x = m_horizontalScale_x;
 		dgFloat32 invScale_x = m_horizontalScaleInv_x;
@@ -673,16 +1072,9 @@ dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q
 		do {
 			dgFloat32 t = RayCastCell (ray, xIndex0, zIndex0, normalOut, maxT);
 			if (t < maxT) {
-				// bail out at the first intersection and copy the data into the descriptor
-				contactOut.m_normal = normalOut.Scale3 (dgRsqrt (normalOut.DotProduct3(normalOut)));
-				contactOut.m_shapeId0 = m_atributeMap[zIndex0 * m_width + xIndex0];
-				contactOut.m_shapeId1 = m_atributeMap[zIndex0 * m_width + xIndex0];
-
-				if (m_userRayCastCallback) {
-					dgVector normal (body->GetCollision()->GetGlobalMatrix().RotateVector (contactOut.m_normal));
-					m_userRayCastCallback (body, this, t, xIndex0, zIndex0, &normal, dgInt32 (contactOut.m_shapeId0), userData);
-				}
-
+				// bail out at the first intersection
+				xIndex = xIndex0;
+				zIndex = zIndex0;
 				return t;
 			}
 
@@ -698,7 +1090,6 @@ dgFloat32 dgCollisionHeightField::RayCast (const dgVector& q0, const dgVector& q
 		} while ((tx <= dgFloat32 (1.0f)) || (tz <= dgFloat32 (1.0f)));
 	}
 
-	// if no cell was hit, return a large value
 	return dgFloat32 (1.2f);
 }
 
@@ -893,50 +1284,12 @@ void dgCollisionHeightField::GetLocalAABB (const dgVector& q0, const dgVector& q
 	dgInt32 z0 = dgInt32 (p0.m_iz);
 	dgInt32 z1 = dgInt32 (p1.m_iz);
 
-	dgFloat32 minHeight = dgFloat32 (1.0e10f);
-	dgFloat32 maxHeight = dgFloat32 (-1.0e10f);
-	dgInt32 base = z0 * m_width;
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			const dgFloat32* const elevation = (dgFloat32*)m_elevationMap;
-			for (dgInt32 z = z0; z <= z1; z ++) {
-				for (dgInt32 x = x0; x <= x1; x ++) {
-					dgFloat32 high = elevation[base + x];
-					if (high < minHeight) {
-						minHeight = high;
-					}
-					if (high > maxHeight) {
-						maxHeight = high;
-					}
-				}
-				base += m_width;
-			}
-			break;
-		}
+	dgFloat32 minHeight;
+	dgFloat32 maxHeight;
+	GetElevationRange (x0, x1, z0, z1, dgFloat32 (-1.0e10f), dgFloat32 (1.0e10f), minHeight, maxHeight);
 
-		case m_unsigned16Bit:
-		{
-			const dgUnsigned16* const elevation = (dgUnsigned16*)m_elevationMap;
-			for (dgInt32 z = z0; z <= z1; z ++) {
-				for (dgInt32 x = x0; x <= x1; x ++) {
-					dgFloat32 high = dgFloat32 (elevation[base + x]);
-					if (high < minHeight) {
-						minHeight = high;
-					}
-					if (high > maxHeight) {
-						maxHeight = high;
-					}
-				}
-				base += m_width;
-			}
-			break;
-		}
-	}
-
-	boxP0.m_y = m_verticalScale * minHeight;
-	boxP1.m_y = m_verticalScale * maxHeight;
+	boxP0.m_y = minHeight;
+	boxP1.m_y = maxHeight;
 }
 
 void dgCollisionHeightField::AddDisplacement (dgVector* const vertex, dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1) const
@@ -985,54 +1338,11 @@ void dgCollisionHeightField::GetCollidingFaces (dgPolygonMeshDesc* const data) c
 	dgInt32 z1 = dgInt32 (p1.m_iz);
 
 	data->m_separationDistance = dgFloat32 (0.0f);
-	dgFloat32 minHeight = dgFloat32 (1.0e10f);
-	dgFloat32 maxHeight = dgFloat32 (-1.0e10f);
-	dgInt32 base = z0 * m_width;
-	switch (m_elevationDataType) 
-	{
-		case m_float32Bit:
-		{
-			const dgFloat32* const elevation = (dgFloat32*)m_elevationMap;
-			for (dgInt32 z = z0; z <= z1; z ++) {
-				for (dgInt32 x = x0; x <= x1; x ++) {
-					dgFloat32 high = elevation[base + x];
-					if (high < minHeight) {
-						minHeight = high;
-					}
-					if (high > maxHeight) {
-						maxHeight = high;
-					}
-				}
-				base += m_width;
-			}
-			break;
-		}
-
-		case m_unsigned16Bit:
-		{
-			const dgUnsigned16* const elevation = (dgUnsigned16*)m_elevationMap;
-			for (dgInt32 z = z0; z <= z1; z ++) {
-				for (dgInt32 x = x0; x <= x1; x ++) {
-					dgFloat32 high = dgFloat32 (elevation[base + x]);
-					if (high < minHeight) {
-						minHeight = high;
-					}
-					if (high > maxHeight) {
-						maxHeight = high;
-					}
-				}
-				base += m_width;
-			}
-			break;
-		}
-	}
-
-	minHeight *= m_verticalScale;
-	maxHeight *= m_verticalScale;
-
-	if (!((maxHeight < boxP0.m_y) || (minHeight > boxP1.m_y))) {
+	dgFloat32 minHeight;
+	dgFloat32 maxHeight;
+	if (GetElevationRange (x0, x1, z0, z1, boxP0.m_y, boxP1.m_y, minHeight, maxHeight)) {
 		// scan the vertices's intersected by the box extend
-		base = (z1 - z0 + 1) * (x1 - x0 + 1) + 2 * (z1 - z0) * (x1 - x0);
+		dgInt32 base = (z1 - z0 + 1) * (x1 - x0 + 1) + 2 * (z1 - z0) * (x1 - x0);
 		while (base > m_instanceData->m_vertexCount[data->m_threadNumber]) {
 			AllocateVertex(world, data->m_threadNumber);
 		}
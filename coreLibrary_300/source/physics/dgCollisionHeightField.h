@@ -25,6 +25,10 @@
 #include "dgCollision.h"
 #include "dgCollisionMesh.h"
 
+// the leafs of the min max pyramid are blocks of 4 x 4 cells, so the pyramid takes about one sixth of the memory of the elevation map
+#define DG_HEIGHTFIELD_PYRAMID_BLOCK		4
+#define DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS	16
+
 class dgCollisionHeightField;
 typedef dgFloat32 (*dgCollisionHeightFieldRayCastCallback) (const dgBody* const body, const dgCollisionHeightField* const heightFieldCollision, dgFloat32 interception, dgInt32 row, dgInt32 col, dgVector* const normal, int faceId, void* const usedData);
 
@@ -62,7 +66,18 @@ class dgCollisionHeightField: public dgCollisionMesh
 
 	void SetHorizontalDisplacement (const dgUnsigned16* const displacemnet, dgFloat32 scale);
 
+	void SetMinMaxPyramid (bool state);
+	bool GetMinMaxPyramid () const { return m_minMaxPyramid ? true : false;}
+
 	private:
+	class dgPyramidLevel
+	{
+		public:
+		dgInt32 m_offset;
+		dgInt32 m_width;
+		dgInt32 m_height;
+	};
+
 	class dgPerIntanceData
 	{
 		public:
@@ -78,6 +93,15 @@ class dgCollisionHeightField: public dgCollisionMesh
 	void CalculateMinExtend2d (const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const;
 	void CalculateMinExtend3d (const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const;
 	dgFloat32 RayCastCell (const dgFastRayTest& ray, dgInt32 xIndex0, dgInt32 zIndex0, dgVector& normalOut, dgFloat32 maxT) const;
+	dgFloat32 RayCastGrid (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgVector& normalOut, dgInt32& xIndex, dgInt32& zIndex) const;
+	dgFloat32 RayCastPyramid (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgVector& normalOut, dgInt32& xIndex, dgInt32& zIndex) const;
+
+	void BuildMinMaxPyramid ();
+	template<class T> void BuildMinMaxPyramid (const T* const elevation, T* const pyramid) const;
+	void GetPyramidNodeBox (dgInt32 level, dgInt32 x, dgInt32 z, dgInt32& x0, dgInt32& x1, dgInt32& z0, dgInt32& z1) const;
+	void GetPyramidNodeRange (dgInt32 level, dgInt32 x, dgInt32 z, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+	void ScanElevationRange (dgInt32 x0, dgInt32 x1, dgInt32 z0, dgInt32 z1, dgFloat32& minHeight, dgFloat32& maxHeight) const;
+	bool GetElevationRange (dgInt32& x0, dgInt32& x1, dgInt32& z0, dgInt32& z1, dgFloat32 minY, dgFloat32 maxY, dgFloat32& minHeight, dgFloat32& maxHeight) const;
 
 	virtual void Serialize(dgSerialize callback, void* const userData) const;
 	virtual dgFloat32 RayCast (const dgVector& localP0, const dgVector& localP1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const;
@@ -113,6 +137,7 @@ class dgCollisionHeightField: public dgCollisionMesh
 	dgInt8* m_diagonals;
 	void* m_elevationMap;
 	dgUnsigned16* m_horizontalDisplacement;
+	void* m_minMaxPyramid;
 	dgFloat32 m_verticalScale;
 	dgFloat32 m_horizontalScale_x;
 	dgFloat32 m_horizontalScaleInv_x;
@@ -122,6 +147,10 @@ class dgCollisionHeightField: public dgCollisionMesh
 	dgFloat32 m_horizontalDisplacementScale_z;
 	dgCollisionHeightFieldRayCastCallback m_userRayCastCallback;
 	dgElevationType m_elevationDataType;
+	bool m_mappedImage;
+	bool m_mappedDisplacement;
+	dgInt32 m_pyramidLevelsCount;
+	dgPyramidLevel m_pyramidLevels[DG_HEIGHTFIELD_PYRAMID_MAX_LEVELS];
 
 	static dgVector m_yMask;
 	static dgVector m_padding;
@@ -131,6 +160,7 @@ class dgCollisionHeightField: public dgCollisionMesh
 	
 	dgPerIntanceData* m_instanceData;
 	friend class dgCollisionCompound;
+	friend class dgCollisionHeightFieldTiled;
 };
 
 
@@ -0,0 +1,647 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgCollisionInstance.h"
+#include "dgCollisionHeightFieldTiled.h"
+
+
+dgCollisionHeightFieldTiled::dgCollisionHeightFieldTiled (
+	dgWorld* const world, dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 contructionMode,
+	dgCollisionHeightField::dgElevationType elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation,
+	dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgInt32 maxResidentTiles)
+	:dgCollisionMesh (world, m_tiledHeightField)
+	,m_width(width)
+	,m_height(height)
+	// the tiles start at even rows and columns so that the diagonal patterns of the tiles line up with the patterns of the whole map
+	,m_tileSize(dgMax ((tileSize + 1) & -2, 2))
+	,m_diagonalMode(dgClamp (contructionMode, dgInt32 (dgCollisionHeightField::m_normalDiagonals), dgInt32 (dgCollisionHeightField::m_starInvertexDiagonals)))
+	,m_maxResidentTiles(dgMax (maxResidentTiles, 1))
+	,m_minElevation(minElevation)
+	,m_maxElevation(maxElevation)
+	,m_verticalScale(verticalScale)
+	,m_horizontalScale_x(horizontalScale_x)
+	,m_horizontalScale_z(horizontalScale_z)
+	,m_prefetchDistance(dgFloat32 (0.0f))
+	,m_elevationDataType(elevationDataType)
+	,m_residentList(world->GetAllocator())
+{
+	m_rtti |= dgCollisionHeightFieldTiled_RTTI;
+	Init (world);
+}
+
+dgCollisionHeightFieldTiled::dgCollisionHeightFieldTiled (dgWorld* const world, dgDeserialize deserialization, void* const userData, dgInt32 revisionNumber)
+	:dgCollisionMesh (world, deserialization, userData, revisionNumber)
+	,m_residentList(world->GetAllocator())
+{
+	dgAssert (m_rtti | dgCollisionHeightFieldTiled_RTTI);
+
+	// only the description of the grid is serialized, the application has to set the tile source again
+	dgInt32 elevationDataType;
+	deserialization (userData, &m_width, sizeof (dgInt32));
+	deserialization (userData, &m_height, sizeof (dgInt32));
+	deserialization (userData, &m_tileSize, sizeof (dgInt32));
+	deserialization (userData, &m_diagonalMode, sizeof (dgInt32));
+	deserialization (userData, &elevationDataType, sizeof (dgInt32));
+	deserialization (userData, &m_maxResidentTiles, sizeof (dgInt32));
+	deserialization (userData, &m_minElevation, sizeof (dgFloat32));
+	deserialization (userData, &m_maxElevation, sizeof (dgFloat32));
+	deserialization (userData, &m_verticalScale, sizeof (dgFloat32));
+	deserialization (userData, &m_horizontalScale_x, sizeof (dgFloat32));
+	deserialization (userData, &m_horizontalScale_z, sizeof (dgFloat32));
+	deserialization (userData, &m_prefetchDistance, sizeof (dgFloat32));
+	m_elevationDataType = dgCollisionHeightField::dgElevationType (elevationDataType);
+
+	Init (world);
+}
+
+dgCollisionHeightFieldTiled::~dgCollisionHeightFieldTiled(void)
+{
+	ReleaseTiles();
+	m_world->m_tiledHeightFields.Remove (m_worldNode);
+
+	dgFreeStack (m_tiles);
+	dgFreeStack (m_scratchElevation);
+	dgFreeStack (m_scratchAtributes);
+}
+
+void dgCollisionHeightFieldTiled::Init (dgWorld* const world)
+{
+	dgAssert (m_width >= 2);
+	dgAssert (m_height >= 2);
+
+	m_world = world;
+	m_tileCallback = NULL;
+	m_tileCallbackUserData = NULL;
+	m_mappedElevation = NULL;
+	m_mappedAtributes = NULL;
+	m_frame = 0;
+	m_residentListFrame = 0;
+	m_requestCount = 0;
+
+	m_tilesCount_x = (m_width - 2) / m_tileSize + 1;
+	m_tilesCount_z = (m_height - 2) / m_tileSize + 1;
+	m_tileScaleInv_x = dgFloat32 (1.0f) / (m_tileSize * m_horizontalScale_x);
+	m_tileScaleInv_z = dgFloat32 (1.0f) / (m_tileSize * m_horizontalScale_z);
+
+	m_tiles = (dgTile*) dgMallocStack (m_tilesCount_x * m_tilesCount_z * sizeof (dgTile));
+	memset (m_tiles, 0, m_tilesCount_x * m_tilesCount_z * sizeof (dgTile));
+
+	const dgInt32 samples = (m_tileSize + 1) * (m_tileSize + 1);
+	const dgInt32 elementSize = (m_elevationDataType == dgCollisionHeightField::m_float32Bit) ? sizeof (dgFloat32) : sizeof (dgUnsigned16);
+	m_scratchElevation = dgMallocStack (samples * elementSize);
+	m_scratchAtributes = (dgInt8*) dgMallocStack (((samples + 4) & -4) * sizeof (dgInt8));
+
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		m_vertexCount[i] = 0;
+		m_vertex[i].SetAllocator (world->GetAllocator());
+	}
+
+	dgFloat32 y0 = m_minElevation * m_verticalScale;
+	dgFloat32 y1 = m_maxElevation * m_verticalScale;
+	m_minBox = dgVector (dgFloat32 (0.0f), dgMin (y0, y1), dgFloat32 (0.0f), dgFloat32 (0.0f));
+	m_maxBox = dgVector (dgFloat32 (m_width - 1) * m_horizontalScale_x, dgMax (y0, y1), dgFloat32 (m_height - 1) * m_horizontalScale_z, dgFloat32 (0.0f));
+	SetCollisionBBox (m_minBox, m_maxBox);
+
+	m_worldNode = world->m_tiledHeightFields.Append (this);
+}
+
+void dgCollisionHeightFieldTiled::ReleaseTiles ()
+{
+	while (m_residentList.GetCount()) {
+		EvictTile (m_residentList.GetLast()->GetInfo());
+	}
+	m_requestCount = 0;
+}
+
+void dgCollisionHeightFieldTiled::Serialize(dgSerialize callback, void* const userData) const
+{
+	SerializeLow (callback, userData);
+
+	dgInt32 elevationDataType = m_elevationDataType;
+	callback (userData, &m_width, sizeof (dgInt32));
+	callback (userData, &m_height, sizeof (dgInt32));
+	callback (userData, &m_tileSize, sizeof (dgInt32));
+	callback (userData, &m_diagonalMode, sizeof (dgInt32));
+	callback (userData, &elevationDataType, sizeof (dgInt32));
+	callback (userData, &m_maxResidentTiles, sizeof (dgInt32));
+	callback (userData, &m_minElevation, sizeof (dgFloat32));
+	callback (userData, &m_maxElevation, sizeof (dgFloat32));
+	callback (userData, &m_verticalScale, sizeof (dgFloat32));
+	callback (userData, &m_horizontalScale_x, sizeof (dgFloat32));
+	callback (userData, &m_horizontalScale_z, sizeof (dgFloat32));
+	callback (userData, &m_prefetchDistance, sizeof (dgFloat32));
+}
+
+void dgCollisionHeightFieldTiled::SetTileCallback (OnTileLoadCallback callback, void* const userData)
+{
+	// the resident tiles were read from the old source
+	ReleaseTiles();
+	m_tileCallback = callback;
+	m_tileCallbackUserData = userData;
+	m_mappedElevation = NULL;
+	m_mappedAtributes = NULL;
+}
+
+void dgCollisionHeightFieldTiled::SetMappedSource (const void* const elevationMap, const dgInt8* const atributeMap)
+{
+	// the maps are not copied, the application keeps then mapped for the life of the collision
+	ReleaseTiles();
+	m_tileCallback = NULL;
+	m_tileCallbackUserData = NULL;
+	m_mappedElevation = elevationMap;
+	m_mappedAtributes = atributeMap;
+}
+
+void dgCollisionHeightFieldTiled::SetPrefetchDistance (dgFloat32 distance)
+{
+	m_prefetchDistance = dgMax (distance, dgFloat32 (0.0f));
+}
+
+void dgCollisionHeightFieldTiled::SetMaxResidentTiles (dgInt32 maxResidentTiles)
+{
+	m_maxResidentTiles = dgMax (maxResidentTiles, 1);
+}
+
+void dgCollisionHeightFieldTiled::AllocateVertex (dgInt32 thread, dgInt32 count) const
+{
+	if (count > m_vertexCount[thread]) {
+		m_vertex[thread].Resize (dgMax (count, m_vertexCount[thread] * 2));
+		m_vertexCount[thread] = m_vertex[thread].GetElementsCapacity();
+	}
+}
+
+DG_INLINE dgVector dgCollisionHeightFieldTiled::GetTileOrigin (dgInt32 x, dgInt32 z) const
+{
+	return dgVector (dgFloat32 (x * m_tileSize) * m_horizontalScale_x, dgFloat32 (0.0f), dgFloat32 (z * m_tileSize) * m_horizontalScale_z, dgFloat32 (0.0f));
+}
+
+// returns the tile if it is resident and stamps it as used by this step, otherwise the tile is queued for loading
+DG_INLINE const dgCollisionHeightField* dgCollisionHeightFieldTiled::GetResidentTile (dgInt32 x, dgInt32 z) const
+{
+	const dgInt32 index = z * m_tilesCount_x + x;
+	dgTile& tile = m_tiles[index];
+	if (tile.m_shape) {
+		tile.m_lastUsed = m_frame;
+	} else {
+		QueueTileRequest (index);
+	}
+	return tile.m_shape;
+}
+
+bool dgCollisionHeightFieldTiled::GetTileRange (const dgVector& p0, const dgVector& p1, dgInt32& x0, dgInt32& x1, dgInt32& z0, dgInt32& z1) const
+{
+	// pad the box by the same amount the height field pads its queries, so that cells on a tile border see both tiles
+	const dgFloat32 padding = dgFloat32 (0.25f);
+	if ((p1.m_x < (m_minBox.m_x - padding)) || (p1.m_z < (m_minBox.m_z - padding)) || (p0.m_x > (m_maxBox.m_x + padding)) || (p0.m_z > (m_maxBox.m_z + padding))) {
+		return false;
+	}
+	x0 = dgClamp (dgInt32 (dgFloor ((p0.m_x - padding) * m_tileScaleInv_x)), dgInt32 (0), m_tilesCount_x - 1);
+	x1 = dgClamp (dgInt32 (dgFloor ((p1.m_x + padding) * m_tileScaleInv_x)), dgInt32 (0), m_tilesCount_x - 1);
+	z0 = dgClamp (dgInt32 (dgFloor ((p0.m_z - padding) * m_tileScaleInv_z)), dgInt32 (0), m_tilesCount_z - 1);
+	z1 = dgClamp (dgInt32 (dgFloor ((p1.m_z + padding) * m_tileScaleInv_z)), dgInt32 (0), m_tilesCount_z - 1);
+	return true;
+}
+
+void dgCollisionHeightFieldTiled::QueueTileRequest (dgInt32 tileIndex) const
+{
+	dgTile& tile = m_tiles[tileIndex];
+	if (!tile.m_requested && !dgInterlockedExchange (&tile.m_requested, 1)) {
+		dgInt32 index = dgAtomicExchangeAndAdd (&m_requestCount, 1);
+		if (index < DG_TILED_HEIGHTFIELD_MAX_REQUESTS) {
+			m_requests[index] = tileIndex;
+		} else {
+			// the queue is full, the tile will be asked for again
+			tile.m_requested = 0;
+		}
+	}
+}
+
+bool dgCollisionHeightFieldTiled::LoadTile (dgInt32 tileIndex)
+{
+	dgTile& tile = m_tiles[tileIndex];
+	dgAssert (!tile.m_shape);
+
+	const dgInt32 x0 = (tileIndex % m_tilesCount_x) * m_tileSize;
+	const dgInt32 z0 = (tileIndex / m_tilesCount_x) * m_tileSize;
+	const dgInt32 width = dgMin (m_tileSize + 1, m_width - x0);
+	const dgInt32 height = dgMin (m_tileSize + 1, m_height - z0);
+	dgAssert ((width >= 2) && (height >= 2));
+
+	bool loaded = false;
+	memset (m_scratchAtributes, 0, width * height * sizeof (dgInt8));
+	if (m_tileCallback) {
+		loaded = m_tileCallback (m_tileCallbackUserData, x0, z0, width, height, m_scratchElevation, m_scratchAtributes) ? true : false;
+	} else if (m_mappedElevation) {
+		// the full map can have more than 2^31 samples
+		const size_t elementSize = (m_elevationDataType == dgCollisionHeightField::m_float32Bit) ? sizeof (dgFloat32) : sizeof (dgUnsigned16);
+		const dgInt8* const elevation = (const dgInt8*) m_mappedElevation;
+		dgInt8* const scratch = (dgInt8*) m_scratchElevation;
+		for (dgInt32 z = 0; z < height; z ++) {
+			const size_t start = size_t (z0 + z) * size_t (m_width) + size_t (x0);
+			memcpy (&scratch[z * width * elementSize], &elevation[start * elementSize], width * elementSize);
+			if (m_mappedAtributes) {
+				memcpy (&m_scratchAtributes[z * width], &m_mappedAtributes[start], width * sizeof (dgInt8));
+			}
+		}
+		loaded = true;
+	}
+
+	if (loaded) {
+		tile.m_shape = new (m_world->GetAllocator()) dgCollisionHeightField (m_world, width, height, m_diagonalMode, m_scratchElevation, m_elevationDataType, m_verticalScale, m_scratchAtributes, m_horizontalScale_x, m_horizontalScale_z);
+		tile.m_residentNode = m_residentList.Addtop (tileIndex);
+		tile.m_lastUsed = m_frame;
+	}
+	return loaded;
+}
+
+void dgCollisionHeightFieldTiled::EvictTile (dgInt32 tileIndex)
+{
+	dgTile& tile = m_tiles[tileIndex];
+	dgAssert (tile.m_shape);
+	tile.m_shape->Release();
+	m_residentList.Remove (tile.m_residentNode);
+	tile.m_shape = NULL;
+	tile.m_residentNode = NULL;
+}
+
+void dgCollisionHeightFieldTiled::BeginTileRequests ()
+{
+	m_frame ++;
+}
+
+// p0 and p1 are a box in the local space of the height field, the resident tiles overlapping the box
+// are pinned for this step and the other tiles are queued for loading
+void dgCollisionHeightFieldTiled::RequestTiles (const dgVector& p0, const dgVector& p1)
+{
+	dgInt32 x0;
+	dgInt32 x1;
+	dgInt32 z0;
+	dgInt32 z1;
+	if (GetTileRange (p0, p1, x0, x1, z0, z1)) {
+		for (dgInt32 z = z0; z <= z1; z ++) {
+			for (dgInt32 x = x0; x <= x1; x ++) {
+				GetResidentTile (x, z);
+			}
+		}
+	}
+}
+
+void dgCollisionHeightFieldTiled::CommitTileRequests ()
+{
+	const dgInt32 count = dgMin (m_requestCount, dgInt32 (DG_TILED_HEIGHTFIELD_MAX_REQUESTS));
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgTile& tile = m_tiles[m_requests[i]];
+		tile.m_requested = 0;
+		if (!tile.m_shape) {
+			LoadTile (m_requests[i]);
+		}
+	}
+	m_requestCount = 0;
+
+	// move the tiles used since the last commit to the front of the list
+	for (dgList<dgInt32>::dgListNode* node = m_residentList.GetFirst(); node; ) {
+		dgList<dgInt32>::dgListNode* const next = node->GetNext();
+		if (m_tiles[node->GetInfo()].m_lastUsed >= m_residentListFrame) {
+			m_residentList.RotateToBegin (node);
+		}
+		node = next;
+	}
+	m_residentListFrame = m_frame;
+
+	// release the least recently used tiles, the tiles pinned by this step are never released
+	while (m_residentList.GetCount() > m_maxResidentTiles) {
+		const dgInt32 index = m_residentList.GetLast()->GetInfo();
+		if (m_tiles[index].m_lastUsed == m_frame) {
+			break;
+		}
+		EvictTile (index);
+	}
+}
+
+void dgCollisionHeightFieldTiled::GetCollisionInfo(dgCollisionInfo* const info) const
+{
+	dgCollision::GetCollisionInfo(info);
+
+	dgCollisionInfo::dgHeightMapCollisionData& data = info->m_heightFieldCollision;
+	data.m_width = m_width;
+	data.m_height = m_height;
+	data.m_gridsDiagonals = m_diagonalMode;
+	data.m_elevationDataType = m_elevationDataType;
+	data.m_horizotalDisplacement = NULL;
+	data.m_verticalScale = m_verticalScale;
+	data.m_horizonalScale_x = m_horizontalScale_x;
+	data.m_horizonalScale_z = m_horizontalScale_z;
+	data.m_horizonalDisplacementScale_x = dgFloat32 (1.0f);
+	data.m_horizonalDisplacementScale_z = dgFloat32 (1.0f);
+	data.m_atributes = (dgInt8*) m_mappedAtributes;
+	data.m_elevation = (void*) m_mappedElevation;
+}
+
+// like the regular height field the vertex list query is not supported, the resident tiles are not a single
+// vertex array, so the query returns an empty list
+void dgCollisionHeightFieldTiled::GetVertexListIndexList (const dgVector& p0, const dgVector& p1, dgMeshVertexListIndexList &data) const
+{
+	data.m_veterxArray = NULL;
+	data.m_triangleCount = 0;
+	data.m_vertexCount = 0;
+	data.m_vertexStrideInBytes = 0;
+}
+
+dgVector dgCollisionHeightFieldTiled::SupportVertex (const dgVector& dir, dgInt32* const vertexIndex) const
+{
+	// the elevation of the tiles that are not resident is not known, the box is the best estimate
+	dgVector mask (dir > dgVector (dgFloat32 (0.0f)));
+	return (m_maxBox & mask) | m_minBox.AndNot(mask);
+}
+
+dgVector dgCollisionHeightFieldTiled::SupportVertexSpecial (const dgVector& dir, dgInt32* const vertexIndex) const
+{
+	dgAssert (0);
+	return SupportVertex (dir, vertexIndex);
+}
+
+void dgCollisionHeightFieldTiled::DebugCollision (const dgMatrix& matrix, dgCollision::OnDebugCollisionMeshCallback callback, void* const userData) const
+{
+	for (dgList<dgInt32>::dgListNode* node = m_residentList.GetFirst(); node; node = node->GetNext()) {
+		const dgInt32 index = node->GetInfo();
+		dgMatrix tileMatrix (matrix);
+		tileMatrix.m_posit = matrix.TransformVector (GetTileOrigin (index % m_tilesCount_x, index / m_tilesCount_x));
+		m_tiles[index].m_shape->DebugCollision (tileMatrix, callback, userData);
+	}
+}
+
+void dgCollisionHeightFieldTiled::GetLocalAABB (const dgVector& q0, const dgVector& q1, dgVector& boxP0, dgVector& boxP1) const
+{
+	boxP0 = (q0.GetMax(m_minBox) & dgVector::m_triplexMask);
+	boxP1 = (q1.GetMin(m_maxBox) & dgVector::m_triplexMask);
+	boxP0.m_y = m_maxBox.m_y;
+	boxP1.m_y = m_minBox.m_y;
+
+	dgInt32 x0;
+	dgInt32 x1;
+	dgInt32 z0;
+	dgInt32 z1;
+	if (GetTileRange (q0, q1, x0, x1, z0, z1)) {
+		for (dgInt32 z = z0; z <= z1; z ++) {
+			for (dgInt32 x = x0; x <= x1; x ++) {
+				const dgCollisionHeightField* const tile = GetResidentTile (x, z);
+				if (tile) {
+					dgVector tileP0;
+					dgVector tileP1;
+					const dgVector origin (GetTileOrigin (x, z));
+					tile->GetLocalAABB (q0 - origin, q1 - origin, tileP0, tileP1);
+					boxP0.m_y = dgMin (boxP0.m_y, tileP0.m_y);
+					boxP1.m_y = dgMax (boxP1.m_y, tileP1.m_y);
+				} else {
+					// the tile is not resident, it will have no faces but the box can not be known
+					boxP0.m_y = m_minBox.m_y;
+					boxP1.m_y = m_maxBox.m_y;
+				}
+			}
+		}
+	}
+
+	if (boxP0.m_y > boxP1.m_y) {
+		boxP0.m_y = m_minBox.m_y;
+		boxP1.m_y = m_maxBox.m_y;
+	}
+}
+
+// walks the tiles crossed by the ray from the closest to the farthest and casts the ray on the resident ones
+dgFloat32 dgCollisionHeightFieldTiled::RayCast (const dgVector& q0, const dgVector& q1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const
+{
+	dgVector p0 (q0);
+	dgVector p1 (q1);
+	if (dgRayBoxClip (p0, p1, m_minBox, m_maxBox)) {
+		dgVector dp (p1 - p0);
+
+		const dgFloat32 scale_x = m_tileSize * m_horizontalScale_x;
+		const dgFloat32 scale_z = m_tileSize * m_horizontalScale_z;
+		dgInt32 ix0 = dgClamp (dgInt32 (dgFloor (p0.m_x * m_tileScaleInv_x)), dgInt32 (0), m_tilesCount_x - 1);
+		dgInt32 iz0 = dgClamp (dgInt32 (dgFloor (p0.m_z * m_tileScaleInv_z)), dgInt32 (0), m_tilesCount_z - 1);
+
+		dgInt32 xInc;
+		dgFloat32 tx;
+		dgFloat32 stepX;
+		if (dp.m_x > dgFloat32 (0.0f)) {
+			xInc = 1;
+			dgFloat32 val = dgFloat32 (1.0f) / dp.m_x;
+			stepX = scale_x * val;
+			tx = (scale_x * (ix0 + dgFloat32 (1.0f)) - p0.m_x) * val;
+		} else if (dp.m_x < dgFloat32 (0.0f)) {
+			xInc = -1;
+			dgFloat32 val = -dgFloat32 (1.0f) / dp.m_x;
+			stepX = scale_x * val;
+			tx = -(scale_x * ix0 - p0.m_x) * val;
+		} else {
+			xInc = 0;
+			stepX = dgFloat32 (0.0f);
+			tx = dgFloat32 (1.0e10f);
+		}
+
+		dgInt32 zInc;
+		dgFloat32 tz;
+		dgFloat32 stepZ;
+		if (dp.m_z > dgFloat32 (0.0f)) {
+			zInc = 1;
+			dgFloat32 val = dgFloat32 (1.0f) / dp.m_z;
+			stepZ = scale_z * val;
+			tz = (scale_z * (iz0 + dgFloat32 (1.0f)) - p0.m_z) * val;
+		} else if (dp.m_z < dgFloat32 (0.0f)) {
+			zInc = -1;
+			dgFloat32 val = -dgFloat32 (1.0f) / dp.m_z;
+			stepZ = scale_z * val;
+			tz = -(scale_z * iz0 - p0.m_z) * val;
+		} else {
+			zInc = 0;
+			stepZ = dgFloat32 (0.0f);
+			tz = dgFloat32 (1.0e10f);
+		}
+
+		dgFloat32 txAcc = tx;
+		dgFloat32 tzAcc = tz;
+		dgInt32 xIndex0 = ix0;
+		dgInt32 zIndex0 = iz0;
+
+		// for each tile touched by the line
+		do {
+			const dgCollisionHeightField* const tile = GetResidentTile (xIndex0, zIndex0);
+			if (tile) {
+				const dgVector origin (GetTileOrigin (xIndex0, zIndex0));
+				dgFloat32 t = tile->RayCast (q0 - origin, q1 - origin, maxT, contactOut, body, userData, preFilter);
+				if (t < maxT) {
+					// the tiles are visited in order, bail out at the first intersection
+					return t;
+				}
+			}
+
+			if (txAcc < tzAcc) {
+				xIndex0 += xInc;
+				tx = txAcc;
+				txAcc += stepX;
+			} else {
+				zIndex0 += zInc;
+				tz = tzAcc;
+				tzAcc += stepZ;
+			}
+		} while (((tx <= dgFloat32 (1.0f)) || (tz <= dgFloat32 (1.0f))) && (xIndex0 >= 0) && (xIndex0 < m_tilesCount_x) && (zIndex0 >= 0) && (zIndex0 < m_tilesCount_z));
+	}
+
+	// if no tile was hit, return a large value
+	return dgFloat32 (1.2f);
+}
+
+// collects the faces of each resident tile overlapping the box and merges them in one face list in the
+// space of the tiled height field, the edges on the tile borders keep the normals of their own tile.
+void dgCollisionHeightFieldTiled::GetCollidingFaces (dgPolygonMeshDesc* const data) const
+{
+	data->m_separationDistance = dgFloat32 (0.0f);
+
+	dgVector boxP0 (data->m_p0 + (data->m_boxDistanceTravelInMeshSpace & (data->m_boxDistanceTravelInMeshSpace < dgVector (dgFloat32 (0.0f)))));
+	dgVector boxP1 (data->m_p1 + (data->m_boxDistanceTravelInMeshSpace & (data->m_boxDistanceTravelInMeshSpace > dgVector (dgFloat32 (0.0f)))));
+
+	dgInt32 x0;
+	dgInt32 x1;
+	dgInt32 z0;
+	dgInt32 z1;
+	if (!GetTileRange (boxP0, boxP1, x0, x1, z0, z1)) {
+		return;
+	}
+
+	dgPolygonMeshDesc tileData;
+	(dgFastAABBInfo&) tileData = *data;
+	tileData.m_boxDistanceTravelInMeshSpace = data->m_boxDistanceTravelInMeshSpace;
+	tileData.m_threadNumber = data->m_threadNumber;
+	tileData.m_skinThickness = data->m_skinThickness;
+	tileData.m_userData = data->m_userData;
+	tileData.m_objBody = data->m_objBody;
+	tileData.m_polySoupBody = data->m_polySoupBody;
+	tileData.m_convexInstance = data->m_convexInstance;
+	tileData.m_polySoupInstance = data->m_polySoupInstance;
+	tileData.m_maxT = data->m_maxT;
+	tileData.m_doContinuesCollisionTest = data->m_doContinuesCollisionTest;
+
+	const dgInt32 thread = data->m_threadNumber;
+	dgInt32* const indices = data->m_globalFaceVertexIndex;
+	dgInt32* const faceIndexCount = data->m_meshData.m_globalFaceIndexCount;
+	dgInt32* const address = data->m_meshData.m_globalFaceIndexStart;
+	dgFloat32* const hitDistance = data->m_meshData.m_globalHitDistance;
+
+	dgInt32 faceCount = 0;
+	dgInt32 indexCount = 0;
+	dgInt32 vertexCount = 0;
+	for (dgInt32 z = z0; (z <= z1) && (faceCount < DG_MAX_COLLIDING_FACES); z ++) {
+		for (dgInt32 x = x0; (x <= x1) && (faceCount < DG_MAX_COLLIDING_FACES); x ++) {
+			const dgCollisionHeightField* const tile = GetResidentTile (x, z);
+			if (!tile) {
+				continue;
+			}
+
+			const dgVector origin (GetTileOrigin (x, z));
+			tileData.m_posit = data->m_posit - origin;
+			tileData.m_p0 = data->m_p0 - origin;
+			tileData.m_p1 = data->m_p1 - origin;
+			tileData.m_faceCount = 0;
+			tileData.m_me = tile;
+			tile->GetCollidingFaces (&tileData);
+			if (!tileData.m_faceCount) {
+				continue;
+			}
+
+			// the tile stores the points first and the face normals after, find both ranges
+			dgInt32 tileVertexCount = 0;
+			dgInt32 normalBase = 0x7fffffff;
+			for (dgInt32 i = 0; i < tileData.m_faceCount; i ++) {
+				const dgInt32* const face = &tileData.m_faceVertexIndex[tileData.m_faceIndexStart[i]];
+				for (dgInt32 j = 0; j < 3; j ++) {
+					tileVertexCount = dgMax (tileVertexCount, face[j] + 1);
+				}
+				for (dgInt32 j = 4; j < 8; j ++) {
+					tileVertexCount = dgMax (tileVertexCount, face[j] + 1);
+					normalBase = dgMin (normalBase, face[j]);
+				}
+			}
+
+			AllocateVertex (thread, vertexCount + tileVertexCount);
+			dgVector* const vertex = &m_vertex[thread][vertexCount];
+			const dgVector* const tileVertex = (dgVector*) tileData.m_vertex;
+			for (dgInt32 i = 0; i < normalBase; i ++) {
+				vertex[i] = tileVertex[i] + origin;
+			}
+			for (dgInt32 i = normalBase; i < tileVertexCount; i ++) {
+				vertex[i] = tileVertex[i];
+			}
+
+			for (dgInt32 i = 0; (i < tileData.m_faceCount) && (faceCount < DG_MAX_COLLIDING_FACES); i ++) {
+				const dgInt32* const src = &tileData.m_faceVertexIndex[tileData.m_faceIndexStart[i]];
+				dgInt32* const dst = &indices[indexCount];
+				dst[0] = src[0] + vertexCount;
+				dst[1] = src[1] + vertexCount;
+				dst[2] = src[2] + vertexCount;
+				dst[3] = src[3];
+				dst[4] = src[4] + vertexCount;
+				dst[5] = src[5] + vertexCount;
+				dst[6] = src[6] + vertexCount;
+				dst[7] = src[7] + vertexCount;
+				dst[8] = src[8];
+
+				faceIndexCount[faceCount] = 3;
+				address[faceCount] = indexCount;
+				hitDistance[faceCount] = tileData.m_hitDistance[i];
+				faceCount ++;
+				indexCount += 9;
+			}
+			vertexCount += tileVertexCount;
+		}
+	}
+
+	if (faceCount) {
+		const dgVector* const vertex = &m_vertex[thread][0];
+		data->m_faceCount = faceCount;
+		data->m_vertex = (dgFloat32*) &vertex[0].m_x;
+		data->m_faceVertexIndex = indices;
+		data->m_faceIndexStart = address;
+		data->m_hitDistance = hitDistance;
+		data->m_faceIndexCount = faceIndexCount;
+		data->m_vertexStrideInBytes = sizeof (dgVector);
+
+		if (GetDebugCollisionCallback()) {
+			dgTriplex triplex[3];
+			const dgVector scale = data->m_polySoupInstance->GetScale();
+			dgMatrix matrix(data->m_polySoupInstance->GetLocalMatrix() * data->m_polySoupBody->GetMatrix());
+
+			for (dgInt32 i = 0; i < data->m_faceCount; i ++) {
+				dgInt32 base1 = address[i];
+				for (dgInt32 j = 0; j < 3; j ++) {
+					dgInt32 index1 = data->m_faceVertexIndex[base1 + j];
+					dgVector p (matrix.TransformVector(scale.CompProduct4(dgVector(vertex[index1]))));
+					triplex[j].m_x = p.m_x;
+					triplex[j].m_y = p.m_y;
+					triplex[j].m_z = p.m_z;
+				}
+				GetDebugCollisionCallback() (data->m_polySoupBody, data->m_objBody, data->m_faceVertexIndex[base1 + 4], 3, &triplex[0].m_x, sizeof (dgTriplex));
+			}
+		}
+	}
+}
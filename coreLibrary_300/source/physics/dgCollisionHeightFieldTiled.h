@@ -0,0 +1,143 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __DGCOLLISION_HEIGHT_FIELD_TILED__
+#define __DGCOLLISION_HEIGHT_FIELD_TILED__
+
+#include "dgCollision.h"
+#include "dgCollisionMesh.h"
+#include "dgCollisionHeightField.h"
+
+// maximum number of tiles that the queries of one step can ask for, the rest are asked again next step
+#define DG_TILED_HEIGHTFIELD_MAX_REQUESTS	256
+
+
+// a very large height field split in square tiles of cells, only the resident tiles are in memory.
+// each resident tile is a regular height field of (tileSize + 1) x (tileSize + 1) samples placed at its
+// origin in the grid, the elevation of a tile is read from a user callback or from a memory mapped image
+// when the tile is requested, and tiles are release by a least recently used policy when the number of
+// resident tiles exceeds the budget.
+// collision and ray cast queries only see resident tiles, the tiles they touch that are not resident are
+// queued and loaded by the world at the beginning of the next step.
+class dgCollisionHeightFieldTiled: public dgCollisionMesh
+{
+	public:
+	typedef dgInt32 (dgApi *OnTileLoadCallback) (void* const userData, dgInt32 x0, dgInt32 z0, dgInt32 width, dgInt32 height, void* const elevation, dgInt8* const atributes);
+
+	dgCollisionHeightFieldTiled (dgWorld* const world, dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 contructionMode,
+								 dgCollisionHeightField::dgElevationType elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation,
+								 dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgInt32 maxResidentTiles);
+
+	dgCollisionHeightFieldTiled (dgWorld* const world, dgDeserialize deserialization, void* const userData, dgInt32 revisionNumber);
+
+	virtual ~dgCollisionHeightFieldTiled(void);
+
+	void SetTileCallback (OnTileLoadCallback callback, void* const userData);
+	void SetMappedSource (const void* const elevationMap, const dgInt8* const atributeMap);
+
+	void SetPrefetchDistance (dgFloat32 distance);
+	dgFloat32 GetPrefetchDistance () const { return m_prefetchDistance;}
+
+	void SetMaxResidentTiles (dgInt32 maxResidentTiles);
+	dgInt32 GetMaxResidentTiles () const { return m_maxResidentTiles;}
+	dgInt32 GetResidentTileCount () const { return m_residentList.GetCount();}
+
+	// the residency update, these are called by the world before the broad phase, never during the collision update.
+	void BeginTileRequests ();
+	void RequestTiles (const dgVector& p0, const dgVector& p1);
+	void CommitTileRequests ();
+
+	void GetLocalAABB (const dgVector& p0, const dgVector& p1, dgVector& boxP0, dgVector& boxP1) const;
+
+	private:
+	class dgTile
+	{
+		public:
+		dgCollisionHeightField* m_shape;
+		dgList<dgInt32>::dgListNode* m_residentNode;
+		dgInt32 m_lastUsed;
+		dgInt32 m_requested;
+	};
+
+	void Init (dgWorld* const world);
+	void ReleaseTiles ();
+	void AllocateVertex (dgInt32 thread, dgInt32 count) const;
+
+	bool GetTileRange (const dgVector& p0, const dgVector& p1, dgInt32& x0, dgInt32& x1, dgInt32& z0, dgInt32& z1) const;
+	DG_INLINE dgVector GetTileOrigin (dgInt32 x, dgInt32 z) const;
+	DG_INLINE const dgCollisionHeightField* GetResidentTile (dgInt32 x, dgInt32 z) const;
+	void QueueTileRequest (dgInt32 tileIndex) const;
+	bool LoadTile (dgInt32 tileIndex);
+	void EvictTile (dgInt32 tileIndex);
+
+	virtual void Serialize(dgSerialize callback, void* const userData) const;
+	virtual dgFloat32 RayCast (const dgVector& localP0, const dgVector& localP1, dgFloat32 maxT, dgContactPoint& contactOut, const dgBody* const body, void* const userData, OnRayPrecastAction preFilter) const;
+	virtual void GetCollidingFaces (dgPolygonMeshDesc* const data) const;
+
+	virtual void GetCollisionInfo(dgCollisionInfo* const info) const;
+	virtual dgVector SupportVertex (const dgVector& dir, dgInt32* const vertexIndex) const;
+	virtual dgVector SupportVertexSpecial (const dgVector& dir, dgInt32* const vertexIndex) const;
+	virtual dgVector SupportVertexSpecialProjectPoint (const dgVector& point, const dgVector& dir) const {return point;};
+
+	virtual void DebugCollision (const dgMatrix& matrixPtr, dgCollision::OnDebugCollisionMeshCallback callback, void* const userData) const;
+	void GetVertexListIndexList (const dgVector& p0, const dgVector& p1, dgMeshVertexListIndexList &data) const;
+
+	dgVector m_minBox;
+	dgVector m_maxBox;
+
+	dgWorld* m_world;
+	dgList<dgCollisionHeightFieldTiled*>::dgListNode* m_worldNode;
+	dgInt32 m_width;
+	dgInt32 m_height;
+	dgInt32 m_tileSize;
+	dgInt32 m_tilesCount_x;
+	dgInt32 m_tilesCount_z;
+	dgInt32 m_diagonalMode;
+	dgInt32 m_maxResidentTiles;
+	dgFloat32 m_minElevation;
+	dgFloat32 m_maxElevation;
+	dgFloat32 m_verticalScale;
+	dgFloat32 m_horizontalScale_x;
+	dgFloat32 m_horizontalScale_z;
+	dgFloat32 m_tileScaleInv_x;
+	dgFloat32 m_tileScaleInv_z;
+	dgFloat32 m_prefetchDistance;
+	dgCollisionHeightField::dgElevationType m_elevationDataType;
+
+	OnTileLoadCallback m_tileCallback;
+	void* m_tileCallbackUserData;
+	const void* m_mappedElevation;
+	const dgInt8* m_mappedAtributes;
+
+	dgTile* m_tiles;
+	void* m_scratchElevation;
+	dgInt8* m_scratchAtributes;
+	dgList<dgInt32> m_residentList;
+	dgInt32 m_frame;
+	dgInt32 m_residentListFrame;
+	mutable dgInt32 m_requestCount;
+	mutable dgInt32 m_requests[DG_TILED_HEIGHTFIELD_MAX_REQUESTS];
+
+	mutable dgInt32 m_vertexCount[DG_MAX_THREADS_HIVE_COUNT];
+	mutable dgArray<dgVector> m_vertex[DG_MAX_THREADS_HIVE_COUNT];
+};
+
+#endif
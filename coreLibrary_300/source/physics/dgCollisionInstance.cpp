@@ -35,6 +35,7 @@
 #include "dgCollisionCompound.h"
 #include "dgCollisionHeightField.h"
 #include "dgCollisionConvexPolygon.h"
+#include "dgCollisionHeightFieldTiled.h"
 #include "dgCollisionChamferCylinder.h"
 #include "dgCollisionCompoundFractured.h"
 #include "dgCollisionDeformableSolidMesh.h"
@@ -193,6 +194,12 @@ dgCollisionInstance::dgCollisionInstance(const dgWorld* const constWorld, dgDese
 					break;
 				}
 
+				case m_tiledHeightField:
+				{
+					collision = new (allocator) dgCollisionHeightFieldTiled (world, deserialization, userData, revisionNumber);
+					break;
+				}
+
 				case m_boundingBoxHierachy:
 				{
 					collision = new (allocator) dgCollisionBVH (world, deserialization, userData, revisionNumber);
@@ -302,7 +309,10 @@ dgCollisionInstance::~dgCollisionInstance()
 	if (m_world->m_onCollisionInstanceDestruction) {
 		m_world->m_onCollisionInstanceDestruction (m_world, this);
 	}
-	((dgWorld*) m_world)->ReleaseCollision(m_childShape);
+	// an instance read from a truncated mapped image may have no shape
+	if (m_childShape) {
+		((dgWorld*) m_world)->ReleaseCollision(m_childShape);
+	}
 }
 
 
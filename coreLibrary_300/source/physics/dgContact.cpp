@@ -90,6 +90,7 @@ dgContact::dgContact(dgContact* const clone)
 	,m_positAcc(clone->m_positAcc)
 	,m_rotationAcc(clone->m_rotationAcc)
 	,m_separtingVector (clone->m_separtingVector)
+	,m_featureCache (clone->m_featureCache)
 	,m_closestDistance(clone->m_closestDistance)
 	,m_separationDistance(clone->m_separationDistance)
 	,m_timeOfImpact(clone->m_timeOfImpact)
@@ -31,11 +31,17 @@ class dgContact;
 class dgContactPoint; 
 class dgContactMaterial;
 class dgPolygonMeshDesc;
+class dgContactFeatureCache;
 class dgCollisionInstance;
 
 
 #define DG_MAX_CONTATCS					128
 #define DG_RESTING_CONTACT_PENETRATION	(DG_PENETRATION_TOL + dgFloat32 (1.0f / 1024.0f))
+#define DG_PRIMITIVE_MAX_CONTACTS		2
+#define DG_PRIMITIVE_BATCH_WIDTH		4
+#define DG_CONTACT_FEATURE_MAX_POINTS	8
+#define DG_CONTACT_FEATURE_ANGULAR_ERROR	dgFloat32 (1.0e-3f)
+#define DG_CONTACT_FEATURE_LINEAR_ERROR		(DG_PENETRATION_TOL * dgFloat32 (0.25f))
 
 class dgActiveContacts: public dgList<dgContact*>
 {
@@ -58,6 +64,7 @@ class dgCollisionParamProxy
 		,m_contactJoint(contact)
 		,m_contacts(contactBuffer)
 		,m_polyMeshData(NULL)		
+		,m_featureCache(NULL)
 		,m_threadIndex(threadIndex)
 		,m_continueCollision(ccdMode)
 		,m_intersectionTestOnly(intersectionTestOnly)
@@ -74,6 +81,7 @@ class dgCollisionParamProxy
 	dgCollisionInstance* m_instance1;
 	dgContactPoint* m_contacts;
 	dgPolygonMeshDesc* m_polyMeshData;
+	dgContactFeatureCache* m_featureCache;
 	
 	dgFloat32 m_timestep;
 	dgFloat32 m_skinThickness;
@@ -85,6 +93,37 @@ class dgCollisionParamProxy
 }DG_GCC_VECTOR_ALIGMENT;
 
 
+// the closest features of a pair of primitives, this is what the contact solver finds with the gjk and the epa.
+// the normal points from shape0 to shape1 and the contacts are on the plane half way between the two surfaces,
+// a kernel that leaves the contact count at zero lets the contact solver clip the features at that plane
+DG_MSC_VECTOR_ALIGMENT
+class dgPrimitiveContact
+{
+	public:
+	void Swap ()
+	{
+		m_normal = m_normal.Scale4 (dgFloat32 (-1.0f));
+		dgSwap (m_point0, m_point1);
+	}
+
+	dgVector m_normal;
+	dgVector m_point0;
+	dgVector m_point1;
+	dgVector m_contacts[DG_PRIMITIVE_MAX_CONTACTS];
+	dgFloat32 m_distance;
+	dgInt32 m_count;
+} DG_GCC_VECTOR_ALIGMENT;
+
+// the pairs of primitives that the narrow phase collides DG_PRIMITIVE_BATCH_WIDTH at the time
+enum dgPrimitiveBatchKind
+{
+	m_sphereSphereBatch,
+	m_sphereBoxBatch,
+	m_boxBoxBatch,
+	m_primitiveBatchKinds,
+};
+
+
 DG_MSC_VECTOR_ALIGMENT
 class dgContactPoint
 {
@@ -175,6 +214,60 @@ class dgContactMaterial: public dgContactPoint
 
 
 
+// what the contact solver found the last time a pair of convex shapes was collided, the support points of the
+// closest simplex and the features clipped to make the contacts are kept in the local space of each shape,
+// so that they are still points of the shapes after the bodies move and the next update can start from them.
+DG_MSC_VECTOR_ALIGMENT 
+class dgContactFeatureCache
+{
+	public:
+	dgContactFeatureCache ()
+	{
+		Reset (NULL, NULL);
+	}
+
+	// the cache belongs to one pair of shapes, a different pair (a compound child, a new collision or a new scale)
+	// starts it again. mesh faces are temporary shapes so they are never cached.
+	DG_INLINE dgContactFeatureCache* Bind (const dgCollisionInstance* const instance0, const dgCollisionInstance* const instance1)
+	{
+		if (instance0->IsType (dgCollision::dgCollisionConvexPolygon_RTTI) || instance1->IsType (dgCollision::dgCollisionConvexPolygon_RTTI)) {
+			return NULL;
+		}
+		if ((instance0 != m_instance0) || (instance1 != m_instance1) || (instance0->m_childShape != m_shape0) || (instance1->m_childShape != m_shape1) || 
+			((instance0->m_scale == m_scale0).GetSignMask() != 0x0f) || ((instance1->m_scale == m_scale1).GetSignMask() != 0x0f)) {
+			Reset (instance0, instance1);
+		}
+		return this;
+	}
+
+	void Reset (const dgCollisionInstance* const instance0, const dgCollisionInstance* const instance1)
+	{
+		m_instance0 = instance0;
+		m_instance1 = instance1;
+		m_shape0 = instance0 ? instance0->m_childShape : NULL;
+		m_shape1 = instance1 ? instance1->m_childShape : NULL;
+		m_scale0 = instance0 ? instance0->m_scale : dgVector::m_zero;
+		m_scale1 = instance1 ? instance1->m_scale : dgVector::m_zero;
+		m_simplexCount = 0;
+		m_featureCount[0] = 0;
+		m_featureCount[1] = 0;
+	}
+
+	dgVector m_scale0;
+	dgVector m_scale1;
+	dgVector m_simplex0[3];
+	dgVector m_simplex1[3];
+	dgPlane m_featurePlane[2];
+	dgVector m_feature[2][DG_CONTACT_FEATURE_MAX_POINTS];
+	const dgCollisionInstance* m_instance0;
+	const dgCollisionInstance* m_instance1;
+	const dgCollision* m_shape0;
+	const dgCollision* m_shape1;
+	dgInt32 m_simplexCount;
+	dgInt32 m_featureCount[2];
+} DG_GCC_VECTOR_ALIGMENT;
+
+
 DG_MSC_VECTOR_ALIGMENT 
 class dgContact: public dgConstraint, public dgList<dgContactMaterial>
 {
@@ -208,6 +301,7 @@ class dgContact: public dgConstraint, public dgList<dgContactMaterial>
 	dgVector m_positAcc;
 	dgQuaternion m_rotationAcc;
 	dgVector m_separtingVector;
+	dgContactFeatureCache m_featureCache;
 	dgFloat32 m_closestDistance;
 	dgFloat32 m_separationDistance;
 	dgFloat32 m_timeOfImpact;
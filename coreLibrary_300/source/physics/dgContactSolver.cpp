@@ -94,6 +94,49 @@ DG_INLINE void dgContactSolver::SupportVertex(const dgVector& dir0, dgInt32 vert
 	m_hullSum[vertexIndex] = p + q;
 }
 
+// rebuild the closest simplex of the last update from the support points saved in the space of each shape,
+// the points that the motion made coincident or colinear with the others are dropped
+DG_INLINE void dgContactSolver::WarmStartSimplex()
+{
+	const dgContactFeatureCache* const cache = m_proxy->m_featureCache;
+	if (cache && cache->m_simplexCount) {
+		const dgMatrix& matrix0 = m_instance0->m_globalMatrix;
+		const dgMatrix& matrix1 = m_instance1->m_globalMatrix;
+		dgInt32 count = 0;
+		for (dgInt32 i = 0; i < cache->m_simplexCount; i ++) {
+			dgVector p(matrix0.TransformVector(cache->m_simplex0[i]) & dgVector::m_triplexMask);
+			dgVector q(matrix1.TransformVector(cache->m_simplex1[i]) & dgVector::m_triplexMask);
+			m_hullDiff[count] = p - q;
+			m_hullSum[count] = p + q;
+			if (count == 0) {
+				count ++;
+			} else if (count == 1) {
+				dgVector e10(m_hullDiff[1] - m_hullDiff[0]);
+				count += (e10.DotProduct3(e10) > dgFloat32(1.0e-10f)) ? 1 : 0;
+			} else {
+				dgVector normal((m_hullDiff[1] - m_hullDiff[0]).CrossProduct3(m_hullDiff[2] - m_hullDiff[0]));
+				count += (normal.DotProduct3(normal) > dgFloat32(1.0e-12f)) ? 1 : 0;
+			}
+		}
+		m_vertexIndex = count;
+	}
+}
+
+DG_INLINE void dgContactSolver::SaveSimplex(dgInt32 count) const
+{
+	dgContactFeatureCache* const cache = m_proxy->m_featureCache;
+	if (cache) {
+		dgAssert((count > 0) && (count <= 3));
+		const dgMatrix& matrix0 = m_instance0->m_globalMatrix;
+		const dgMatrix& matrix1 = m_instance1->m_globalMatrix;
+		for (dgInt32 i = 0; i < count; i ++) {
+			cache->m_simplex0[i] = matrix0.UntransformVector(dgVector::m_half.CompProduct4(m_hullSum[i] + m_hullDiff[i]));
+			cache->m_simplex1[i] = matrix1.UntransformVector(dgVector::m_half.CompProduct4(m_hullSum[i] - m_hullDiff[i]));
+		}
+		cache->m_simplexCount = count;
+	}
+}
+
 
 DG_INLINE dgBigVector dgContactSolver::ReduceLine(dgInt32& indexOut)
 {
@@ -1003,6 +1046,7 @@ bool dgContactSolver::CalculateClosestPoints()
 
 	if (simplexPointCount > 0) {
 		dgAssert((simplexPointCount > 0) && (simplexPointCount <= 3));
+		SaveSimplex(simplexPointCount);
 		CalculateContactFromFeacture(simplexPointCount);
 
 		const dgMatrix& matrix0 = m_instance0->m_globalMatrix;
@@ -1010,6 +1054,8 @@ bool dgContactSolver::CalculateClosestPoints()
 		m_closestPoint0 = matrix0.TransformVector(m_instance0->SupportVertexSpecialProjectPoint(matrix0.UntransformVector(m_closestPoint0), matrix0.UnrotateVector(m_normal)));
 		m_closestPoint1 = matrix1.TransformVector(m_instance1->SupportVertexSpecialProjectPoint(matrix1.UntransformVector(m_closestPoint1), matrix1.UnrotateVector(m_normal.Scale4(-1.0f))));
 		m_vertexIndex = simplexPointCount;
+	} else if (m_proxy->m_featureCache) {
+		m_proxy->m_featureCache->m_simplexCount = 0;
 	}
 	return simplexPointCount >= 0;
 }
@@ -1582,6 +1628,7 @@ dgInt32 dgContactSolver::CalculateConvexToConvexContacts ()
 //xxx ++;
 
 	dgInt32 count = 0;
+	WarmStartSimplex();
 	if (m_proxy->m_intersectionTestOnly) {
 		CalculateClosestPoints();
 		dgFloat32 penetration = m_normal.DotProduct4(m_closestPoint1 - m_closestPoint0).GetScalar() - m_proxy->m_skinThickness - DG_PENETRATION_TOL;
@@ -1629,6 +1676,40 @@ dgInt32 dgContactSolver::CalculateConvexToConvexContacts ()
 }
 
 
+// the feature of a convex shape cut by a plane only depends on the plane, when the plane did not move in the space of
+// the shape since the last update the feature of the last update is projected to the new plane instead of calculated again.
+DG_INLINE dgInt32 dgContactSolver::CalculatePlaneIntersection(dgInt32 side, const dgCollisionInstance* const instance, const dgVector& normal, const dgVector& point, dgVector* const contactsOut) const
+{
+	dgContactFeatureCache* const cache = m_proxy->m_featureCache;
+	if (!cache) {
+		return instance->CalculatePlaneIntersection(normal, point, contactsOut);
+	}
+
+	dgAssert(normal.m_w == dgFloat32(0.0f));
+	const dgPlane plane(normal, -normal.DotProduct3(point));
+	const dgPlane& cachedPlane = cache->m_featurePlane[side];
+	const dgInt32 cachedCount = cache->m_featureCount[side];
+	if (cachedCount) {
+		const dgVector error(plane - cachedPlane);
+		if ((error.DotProduct3(error) < (DG_CONTACT_FEATURE_ANGULAR_ERROR * DG_CONTACT_FEATURE_ANGULAR_ERROR)) && (dgAbsf(error.m_w) < DG_CONTACT_FEATURE_LINEAR_ERROR)) {
+			const dgVector* const feature = cache->m_feature[side];
+			for (dgInt32 i = 0; i < cachedCount; i ++) {
+				contactsOut[i] = feature[i] - normal.Scale4(plane.Evalue(feature[i]));
+			}
+			return cachedCount;
+		}
+	}
+
+	const dgInt32 count = instance->CalculatePlaneIntersection(normal, point, contactsOut);
+	cache->m_featureCount[side] = 0;
+	if (count && (count <= DG_CONTACT_FEATURE_MAX_POINTS)) {
+		cache->m_featurePlane[side] = plane;
+		cache->m_featureCount[side] = count;
+		memcpy(cache->m_feature[side], contactsOut, count * sizeof (dgVector));
+	}
+	return count;
+}
+
 dgInt32 dgContactSolver::CalculateContacts(const dgVector& point0, const dgVector& point1, const dgVector& normal)
 {
 #if 0
@@ -1767,7 +1848,7 @@ dgInt32 dgContactSolver::CalculateContacts(const dgVector& point0, const dgVecto
 	dgVector normalOnInstance1(matrix1.UnrotateVector(normal));
 	dgFloat32 dist = (normal.DotProduct4(point0 - point1)).GetScalar();
 	if (dist < dgFloat32(0.0f)) {
-		count1 = m_instance1->CalculatePlaneIntersection(normalOnInstance1, ponintOnInstance1, shape1);
+		count1 = CalculatePlaneIntersection(1, m_instance1, normalOnInstance1, ponintOnInstance1, shape1);
 	}
 	if (!count1) {
 		dgVector step(normal.Scale4(DG_PENETRATION_TOL * dgFloat32(2.0f)));
@@ -1775,7 +1856,7 @@ dgInt32 dgContactSolver::CalculateContacts(const dgVector& point0, const dgVecto
 		for (dgInt32 i = 0; (i < 3) && !count1; i++) {
 			alternatePoint -= step;
 			dgVector alternatePointOnInstance1(matrix1.UntransformVector(alternatePoint));
-			count1 = m_instance1->CalculatePlaneIntersection(normalOnInstance1, alternatePointOnInstance1, shape1);
+			count1 = CalculatePlaneIntersection(1, m_instance1, normalOnInstance1, alternatePointOnInstance1, shape1);
 		}
 		//dgAssert(count1);
 		step = matrix1.UnrotateVector(normal.CompProduct4((alternatePoint - origin).DotProduct4(normal)));
@@ -1796,7 +1877,7 @@ dgInt32 dgContactSolver::CalculateContacts(const dgVector& point0, const dgVecto
 		dgVector pointOnInstance0(matrix0.UntransformVector(origin));
 		dgVector normalOnInstance0(matrix0.UnrotateVector(normal.Scale4(dgFloat32(-1.0f))));
 		if (dist < dgFloat32(0.0f)) {
-			count0 = m_instance0->CalculatePlaneIntersection(normalOnInstance0, pointOnInstance0, shape0);
+			count0 = CalculatePlaneIntersection(0, m_instance0, normalOnInstance0, pointOnInstance0, shape0);
 		}
 		if (!count0) {
 			dgVector step(normal.Scale4(DG_PENETRATION_TOL * dgFloat32(2.0f)));
@@ -1804,7 +1885,7 @@ dgInt32 dgContactSolver::CalculateContacts(const dgVector& point0, const dgVecto
 			for (dgInt32 i = 0; (i < 3) && !count0; i++) {
 				alternatePoint += step;
 				dgVector alternatePointOnInstance0(matrix0.UntransformVector(alternatePoint));
-				count0 = m_instance0->CalculatePlaneIntersection(normalOnInstance0, alternatePointOnInstance0, shape0);
+				count0 = CalculatePlaneIntersection(0, m_instance0, normalOnInstance0, alternatePointOnInstance0, shape0);
 			}
 			dgAssert(count0);
 			step = matrix0.UnrotateVector(normal.CompProduct4((alternatePoint - origin).DotProduct4(normal)));
@@ -61,9 +61,12 @@ class dgContactSolver: public dgDownHeap<dgMinkFace *, dgFloat32>
 	dgInt32 CalculateConvexToConvexContacts();
 	dgFloat32 RayCast (const dgVector& localP0, const dgVector& localP1, dgFloat32 maxT, dgContactPoint& contactOut);
 
+	dgInt32 CalculateContacts (const dgVector& point0, const dgVector& point1, const dgVector& normal);
+
 	const dgVector& GetNormal() const {return m_normal;}
 	const dgVector& GetPoint0() const {return m_closestPoint0;}
 	const dgVector& GetPoint1() const {return m_closestPoint1;}
+	const dgVector* GetContacts() const {return m_hullDiff;}
 	
 	private:
 	class dgPerimenterEdge
@@ -85,6 +88,9 @@ class dgContactSolver: public dgDownHeap<dgMinkFace *, dgFloat32>
 	DG_INLINE void DeleteFace(dgMinkFace* const face);
 	DG_INLINE dgMinkFace* AddFace(dgInt32 v0, dgInt32 v1, dgInt32 v2);
 	DG_INLINE void SupportVertex(const dgVector& dir, dgInt32 vertexIndex);
+	DG_INLINE void WarmStartSimplex();
+	DG_INLINE void SaveSimplex(dgInt32 count) const;
+	DG_INLINE dgInt32 CalculatePlaneIntersection(dgInt32 side, const dgCollisionInstance* const instance, const dgVector& normal, const dgVector& point, dgVector* const contactsOut) const;
 	
 	DG_INLINE void TranslateSimplex(const dgVector& step);
 	
@@ -98,7 +104,6 @@ class dgContactSolver: public dgDownHeap<dgMinkFace *, dgFloat32>
 	bool SanityCheck() const;
 	dgInt32 ConvexPolygonsIntersection(const dgVector& normal, dgInt32 count1, dgVector* const shape1, dgInt32 count2, dgVector* const shape2, dgVector* const contactOut, dgInt32 maxContacts) const;
 	dgInt32 ConvexPolygonToLineIntersection(const dgVector& normal, dgInt32 count1, dgVector* const shape1, dgInt32 count2, dgVector* const shape2, dgVector* const contactOut, dgVector* const mem) const;
-	dgInt32 CalculateContacts (const dgVector& point0, const dgVector& point1, const dgVector& normal);
 	dgInt32 CalculateClosestSimplex ();
 	dgInt32 CalculateIntersectingPlane(dgInt32 count);
 
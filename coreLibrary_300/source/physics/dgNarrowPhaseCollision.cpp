@@ -45,6 +45,7 @@
 #include "dgCollisionConvexPolygon.h"
 #include "dgCollisionDeformableMesh.h"
 #include "dgCollisionChamferCylinder.h"
+#include "dgCollisionHeightFieldTiled.h"
 #include "dgCollisionCompoundFractured.h"
 #include "dgCollisionDeformableSolidMesh.h"
 #include "dgCollisionMassSpringDamperSystem.h"
@@ -317,6 +318,19 @@ dgCollisionInstance* dgWorld::CreateHeightField(
 	return instance;
 }
 
+dgCollisionInstance* dgWorld::CreateTiledHeightField(
+	dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 contructionMode, dgInt32 elevationDataType, 
+	dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, 
+	dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgInt32 maxResidentTiles)
+{
+	dgCollision* const collision = new  (m_allocator) dgCollisionHeightFieldTiled (this, width, height, tileSize, contructionMode, 
+																				   elevationDataType ? dgCollisionHeightField::m_unsigned16Bit : dgCollisionHeightField::m_float32Bit,	
+																				   minElevation, maxElevation, verticalScale, horizontalScale_x, horizontalScale_z, maxResidentTiles);
+	dgCollisionInstance* const instance = CreateInstance (collision, 0, dgGetIdentityMatrix()); 
+	collision->Release();
+	return instance;
+}
+
 dgCollisionInstance* dgWorld::CreateInstance (const dgCollision* const child, dgInt32 shapeID, const dgMatrix& offsetMatrix)
 {
 	dgAssert (dgAbsf (offsetMatrix[0].DotProduct3(offsetMatrix[0]) - dgFloat32 (1.0f)) < dgFloat32 (1.0e-5f));
@@ -345,6 +359,31 @@ dgCollisionInstance* dgWorld::CreateCollisionFromSerialization (dgDeserialize de
 	return instance;
 }
 
+void dgWorld::SerializeCollisionMappedImage (dgCollisionInstance* const shape, dgSerialize serialization, void* const userData) const
+{
+	dgMappedImageWriter writer (serialization, userData);
+	SerializeCollision (shape, dgMappedImageWriter::Write, &writer);
+}
+
+dgCollisionInstance* dgWorld::CreateCollisionFromMappedImage (const void* const image, size_t size)
+{
+	dgMappedImageReader reader (image, size);
+	if (!reader.IsValid()) {
+		return NULL;
+	}
+	dgInt32 revision = dgDeserializeMarker (dgMappedImageReader::Read, &reader);
+	if (reader.HasFailed()) {
+		return NULL;
+	}
+	dgCollisionInstance* const instance = new (m_allocator) dgCollisionInstance (this, dgMappedImageReader::Read, &reader, revision);
+	if (reader.HasFailed()) {
+		// the image is truncated or corrupted, the shape may reference arrays that were never mapped
+		instance->Release();
+		return NULL;
+	}
+	return instance;
+}
+
 
 dgContactMaterial* dgWorld::GetMaterial (dgUnsigned32 bodyGroupId0, dgUnsigned32 bodyGroupId1)	const
 {
@@ -731,6 +770,9 @@ void dgWorld::PopulateContacts (dgBroadPhase::dgPair* const pair, dgInt32 thread
 	dgInt32 contactCount = pair->m_contactCount;
 	dgList<dgContactMaterial>& list = *contact;
 
+	// the contact list is only touched by this thread, the lock is there for the allocator
+	const bool lockAllocator = !m_allocator->IsThreadSafe();
+
 	contact->m_timeOfImpact = pair->m_timestep;
 
 	dgInt32 count = 0;
@@ -803,10 +845,12 @@ void dgWorld::PopulateContacts (dgBroadPhase::dgPair* const pair, dgInt32 thread
 			dgAssert (index != -1);
 			nodes[index] = nodes[count];
 			cachePosition[index] = cachePosition[count];
-		} else {
+		} else if (lockAllocator) {
 			GlobalLock(false);
 			contactNode = list.Append ();
 			GlobalUnlock();
+		} else {
+			contactNode = list.Append ();
 		}
 
 		dgContactMaterial* const contactMaterial = &contactNode->GetInfo();
@@ -900,11 +944,15 @@ void dgWorld::PopulateContacts (dgBroadPhase::dgPair* const pair, dgInt32 thread
 	}
 
 	if (count) {
-		GlobalLock(false);
+		if (lockAllocator) {
+			GlobalLock(false);
+		}
 		for (dgInt32 i = 0; i < count; i ++) {
 			list.Remove(nodes[i]);
 		}
-		GlobalUnlock();
+		if (lockAllocator) {
+			GlobalUnlock();
+		}
 	}
 
 	contact->m_maxDOF = dgUnsigned32 (3 * contact->GetCount());
@@ -1396,6 +1444,12 @@ dgInt32 dgWorld::CalculateConvexToConvexContacts(dgCollisionParamProxy& proxy) c
 	dgAssert(proxy.m_instance1->IsType(dgCollision::dgCollisionConvexShape_RTTI));
 
 	if (!contactJoint->m_material->m_contactGeneration) {
+		proxy.m_featureCache = proxy.m_continueCollision ? NULL : contactJoint->m_featureCache.Bind (collision0, collision1);
+		if (m_primitiveContacts && !proxy.m_continueCollision && CalculatePrimitiveContacts (proxy, count)) {
+			proxy.m_featureCache = NULL;
+			return count;
+		}
+
 		dgCollisionInstance instance0(*collision0, collision0->m_childShape);
 		dgCollisionInstance instance1(*collision1, collision1->m_childShape);
 
@@ -1451,6 +1505,7 @@ dgTrace (("n(%f %f %f)\n", xxxx1[0], xxxx1[1], xxxx1[2]));
 		instance1.m_userData1 = NULL;
 		proxy.m_instance0 = collision0;
 		proxy.m_instance1 = collision1;
+		proxy.m_featureCache = NULL;
 
 	} else {
 		count = CalculateUserContacts(proxy);
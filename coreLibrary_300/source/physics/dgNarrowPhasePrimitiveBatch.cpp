@@ -0,0 +1,451 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgContact.h"
+#include "dgCollisionInstance.h"
+
+#define DG_PRIMITIVE_BATCH_MIN_DISTANCE		dgFloat32 (1.0e-5f)
+#define DG_PRIMITIVE_BATCH_EDGE_AXIS_BIAS	dgFloat32 (1.0e-3f)
+#define DG_PRIMITIVE_BATCH_MIN_EDGE_AXIS	dgFloat32 (1.0e-6f)
+
+
+// each lane of a vector is one pair of the batch, the kernels do the same arithmetic as the scalar kernels
+// in dgNarrowPhasePrimitiveContacts.cpp so that a pair gets the same contacts whether it is batched or not.
+DG_MSC_VECTOR_ALIGMENT
+class dgPrimitiveSoaVector
+{
+	public:
+	DG_INLINE dgPrimitiveSoaVector()
+	{
+	}
+
+	DG_INLINE dgPrimitiveSoaVector(const dgVector& x, const dgVector& y, const dgVector& z)
+		:m_x(x)
+		,m_y(y)
+		,m_z(z)
+	{
+	}
+
+	DG_INLINE dgPrimitiveSoaVector(const dgVector& v0, const dgVector& v1, const dgVector& v2, const dgVector& v3)
+	{
+		dgVector w;
+		dgVector::Transpose4x4 (m_x, m_y, m_z, w, v0, v1, v2, v3);
+	}
+
+	DG_INLINE void Scatter (dgVector* const out, const dgVector& w) const
+	{
+		dgVector::Transpose4x4 (out[0], out[1], out[2], out[3], m_x, m_y, m_z, w);
+	}
+
+	DG_INLINE dgPrimitiveSoaVector operator+ (const dgPrimitiveSoaVector& a) const
+	{
+		return dgPrimitiveSoaVector (m_x + a.m_x, m_y + a.m_y, m_z + a.m_z);
+	}
+
+	DG_INLINE dgPrimitiveSoaVector operator- (const dgPrimitiveSoaVector& a) const
+	{
+		return dgPrimitiveSoaVector (m_x - a.m_x, m_y - a.m_y, m_z - a.m_z);
+	}
+
+	DG_INLINE dgPrimitiveSoaVector Scale (const dgVector& s) const
+	{
+		return dgPrimitiveSoaVector (m_x.CompProduct4(s), m_y.CompProduct4(s), m_z.CompProduct4(s));
+	}
+
+	DG_INLINE dgVector DotProduct (const dgPrimitiveSoaVector& a) const
+	{
+		return m_x.CompProduct4(a.m_x) + m_y.CompProduct4(a.m_y) + m_z.CompProduct4(a.m_z);
+	}
+
+	DG_INLINE dgPrimitiveSoaVector CrossProduct (const dgPrimitiveSoaVector& a) const
+	{
+		return dgPrimitiveSoaVector (m_y.CompProduct4(a.m_z) - m_z.CompProduct4(a.m_y), m_z.CompProduct4(a.m_x) - m_x.CompProduct4(a.m_z), m_x.CompProduct4(a.m_y) - m_y.CompProduct4(a.m_x));
+	}
+
+	// the lanes of this vector where the mask is set, and the lanes of a elsewhere
+	DG_INLINE dgPrimitiveSoaVector Select (const dgPrimitiveSoaVector& a, const dgVector& mask) const
+	{
+		return dgPrimitiveSoaVector ((m_x & mask) | a.m_x.AndNot(mask), (m_y & mask) | a.m_y.AndNot(mask), (m_z & mask) | a.m_z.AndNot(mask));
+	}
+
+	dgVector m_x;
+	dgVector m_y;
+	dgVector m_z;
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_INLINE static dgVector dgBatchSelect (const dgVector& a, const dgVector& b, const dgVector& mask)
+{
+	return (a & mask) | b.AndNot(mask);
+}
+
+// plus one on the lanes where the value is positive or zero, minus one on the others
+DG_INLINE static dgVector dgBatchSign (const dgVector& a)
+{
+	return dgBatchSelect (dgVector::m_one, dgVector::m_negOne, a >= dgVector::m_zero);
+}
+
+DG_INLINE static dgVector dgBatchLane (const dgVector* const v, dgInt32 index)
+{
+	return dgVector (v[0][index], v[1][index], v[2][index], v[3][index]);
+}
+
+DG_INLINE static dgPrimitiveSoaVector dgBatchRow (const dgMatrix* const matrix, dgInt32 row)
+{
+	return dgPrimitiveSoaVector (matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+}
+
+
+static void dgSphereSphereContactBatch (const dgMatrix* const matrix0, const dgVector* const size0, const dgMatrix* const matrix1, const dgVector* const size1, dgPrimitiveContact* const contacts, dgInt32* const valid)
+{
+	const dgVector radius0 (dgBatchLane (size0, 0));
+	const dgVector radius1 (dgBatchLane (size1, 0));
+	const dgPrimitiveSoaVector center0 (dgBatchRow (matrix0, 3));
+	const dgPrimitiveSoaVector center1 (dgBatchRow (matrix1, 3));
+
+	const dgPrimitiveSoaVector dir (center1 - center0);
+	const dgVector dist2 (dir.DotProduct(dir));
+	const dgVector minDist2 (DG_PRIMITIVE_BATCH_MIN_DISTANCE * DG_PRIMITIVE_BATCH_MIN_DISTANCE);
+	const dgInt32 farMask = (dist2 >= minDist2).GetSignMask();
+	const dgVector dist (dist2.GetMax(minDist2).Sqrt());
+
+	const dgPrimitiveSoaVector normal (dir.Scale (dist.Reciproc()));
+	const dgPrimitiveSoaVector point0 (center0 + normal.Scale (radius0));
+	const dgPrimitiveSoaVector point1 (center1 - normal.Scale (radius1));
+	const dgPrimitiveSoaVector midPoint ((point0 + point1).Scale (dgVector::m_half));
+	const dgVector distance (dist - radius0 - radius1);
+
+	dgVector normalOut[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector point0Out[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector point1Out[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector midPointOut[DG_PRIMITIVE_BATCH_WIDTH];
+	normal.Scatter (normalOut, dgVector::m_zero);
+	point0.Scatter (point0Out, dgVector::m_one);
+	point1.Scatter (point1Out, dgVector::m_one);
+	midPoint.Scatter (midPointOut, dgVector::m_one);
+	for (dgInt32 i = 0; i < DG_PRIMITIVE_BATCH_WIDTH; i ++) {
+		// concentric spheres have not normal, the scalar path deals with them
+		valid[i] &= (farMask >> i) & 1;
+		dgPrimitiveContact& contact = contacts[i];
+		contact.m_normal = normalOut[i];
+		contact.m_point0 = point0Out[i];
+		contact.m_point1 = point1Out[i];
+		contact.m_distance = distance[i];
+		contact.m_contacts[0] = midPointOut[i];
+		contact.m_count = 1;
+	}
+}
+
+// shape 0 is the sphere and shape 1 is the box in all lanes
+static void dgSphereBoxContactBatch (const dgMatrix* const matrix0, const dgVector* const size0, const dgMatrix* const matrix1, const dgVector* const size1, dgPrimitiveContact* const contacts, dgInt32* const valid)
+{
+	const dgVector radius (dgBatchLane (size0, 0));
+	const dgPrimitiveSoaVector center (dgBatchRow (matrix0, 3));
+	const dgPrimitiveSoaVector front (dgBatchRow (matrix1, 0));
+	const dgPrimitiveSoaVector up (dgBatchRow (matrix1, 1));
+	const dgPrimitiveSoaVector right (dgBatchRow (matrix1, 2));
+	const dgPrimitiveSoaVector origin (dgBatchRow (matrix1, 3));
+	const dgPrimitiveSoaVector size (size1[0], size1[1], size1[2], size1[3]);
+
+	const dgPrimitiveSoaVector step (center - origin);
+	const dgPrimitiveSoaVector localCenter (step.DotProduct(front), step.DotProduct(up), step.DotProduct(right));
+	const dgPrimitiveSoaVector closest (localCenter.m_x.GetMax(size.m_x.CompProduct4(dgVector::m_negOne)).GetMin(size.m_x),
+										localCenter.m_y.GetMax(size.m_y.CompProduct4(dgVector::m_negOne)).GetMin(size.m_y),
+										localCenter.m_z.GetMax(size.m_z.CompProduct4(dgVector::m_negOne)).GetMin(size.m_z));
+
+	// the center is outside the box, the closest point is on a face, an edge or a vertex
+	const dgPrimitiveSoaVector dir (localCenter - closest);
+	const dgVector dist2 (dir.DotProduct(dir));
+	const dgVector minDist2 (DG_PRIMITIVE_BATCH_MIN_DISTANCE * DG_PRIMITIVE_BATCH_MIN_DISTANCE);
+	const dgVector outside (dist2 > minDist2);
+	const dgVector outsideDist (dist2.GetMax(minDist2).Sqrt());
+	const dgPrimitiveSoaVector outsideNormal (dir.Scale (outsideDist.Reciproc()));
+
+	// the center is inside the box, push it out through the closest face, ties go to the lower axis
+	const dgVector depthX (size.m_x - localCenter.m_x.Abs());
+	const dgVector depthY (size.m_y - localCenter.m_y.Abs());
+	const dgVector depthZ (size.m_z - localCenter.m_z.Abs());
+	const dgVector axisY (depthY < depthX);
+	const dgVector depthXY (dgBatchSelect (depthY, depthX, axisY));
+	const dgVector axisZ (depthZ < depthXY);
+	const dgVector depth (dgBatchSelect (depthZ, depthXY, axisZ));
+	const dgPrimitiveSoaVector axisMask ((depthX <= depthY) & (depthX <= depthZ), axisY.AndNot(axisZ), axisZ);
+
+	const dgPrimitiveSoaVector side (dgBatchSign (localCenter.m_x), dgBatchSign (localCenter.m_y), dgBatchSign (localCenter.m_z));
+	const dgPrimitiveSoaVector insideNormal (side.m_x & axisMask.m_x, side.m_y & axisMask.m_y, side.m_z & axisMask.m_z);
+	const dgPrimitiveSoaVector facePoint (size.m_x.CompProduct4(side.m_x), size.m_y.CompProduct4(side.m_y), size.m_z.CompProduct4(side.m_z));
+	const dgPrimitiveSoaVector insidePoint (dgBatchSelect (facePoint.m_x, localCenter.m_x, axisMask.m_x), dgBatchSelect (facePoint.m_y, localCenter.m_y, axisMask.m_y), dgBatchSelect (facePoint.m_z, localCenter.m_z, axisMask.m_z));
+
+	const dgPrimitiveSoaVector localNormal (outsideNormal.Select (insideNormal, outside));
+	const dgPrimitiveSoaVector localPoint (closest.Select (insidePoint, outside));
+	const dgVector dist (dgBatchSelect (outsideDist, depth.CompProduct4(dgVector::m_negOne), outside));
+
+	// the local normal points from the box to the sphere
+	const dgPrimitiveSoaVector normal ((front.Scale (localNormal.m_x) + up.Scale (localNormal.m_y) + right.Scale (localNormal.m_z)).Scale (dgVector::m_negOne));
+	const dgPrimitiveSoaVector point1 (origin + front.Scale (localPoint.m_x) + up.Scale (localPoint.m_y) + right.Scale (localPoint.m_z));
+	const dgPrimitiveSoaVector point0 (center + normal.Scale (radius));
+	const dgPrimitiveSoaVector midPoint ((point0 + point1).Scale (dgVector::m_half));
+	const dgVector distance (dist - radius);
+
+	dgVector normalOut[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector point0Out[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector point1Out[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector midPointOut[DG_PRIMITIVE_BATCH_WIDTH];
+	normal.Scatter (normalOut, dgVector::m_zero);
+	point0.Scatter (point0Out, dgVector::m_one);
+	point1.Scatter (point1Out, dgVector::m_one);
+	midPoint.Scatter (midPointOut, dgVector::m_one);
+	for (dgInt32 i = 0; i < DG_PRIMITIVE_BATCH_WIDTH; i ++) {
+		dgPrimitiveContact& contact = contacts[i];
+		contact.m_normal = normalOut[i];
+		contact.m_point0 = point0Out[i];
+		contact.m_point1 = point1Out[i];
+		contact.m_distance = distance[i];
+		contact.m_contacts[0] = midPointOut[i];
+		contact.m_count = 1;
+	}
+}
+
+// the separating axis test of dgWorld::BoxBoxContacts, the closest points are found one lane at the time
+static void dgBoxBoxContactBatch (const dgMatrix* const matrix0, const dgVector* const size0, const dgMatrix* const matrix1, const dgVector* const size1, dgPrimitiveContact* const contacts, dgInt32* const separatingAxis)
+{
+	dgPrimitiveSoaVector axis0[3];
+	dgPrimitiveSoaVector axis1[3];
+	dgVector extend0[3];
+	dgVector extend1[3];
+	for (dgInt32 i = 0; i < 3; i ++) {
+		axis0[i] = dgBatchRow (matrix0, i);
+		axis1[i] = dgBatchRow (matrix1, i);
+		extend0[i] = dgBatchLane (size0, i);
+		extend1[i] = dgBatchLane (size1, i);
+	}
+	const dgPrimitiveSoaVector step (dgBatchRow (matrix1, 3) - dgBatchRow (matrix0, 3));
+
+	// rotation of box1 in the space of box0, and its absolute value
+	dgVector absRot[3][3];
+	for (dgInt32 i = 0; i < 3; i ++) {
+		for (dgInt32 j = 0; j < 3; j ++) {
+			absRot[i][j] = axis0[i].DotProduct(axis1[j]).Abs();
+		}
+	}
+
+	dgVector bestAxis (dgFloat32 (-1.0f));
+	dgVector bestSeparation (dgFloat32 (-1.0e10f));
+	dgPrimitiveSoaVector bestNormal (dgVector::m_zero, dgVector::m_zero, dgVector::m_zero);
+
+	// face axes first, an edge axis must be clearly better to replace them
+	for (dgInt32 i = 0; i < 3; i ++) {
+		const dgVector dist (step.DotProduct(axis0[i]));
+		const dgVector separation (dist.Abs() - extend0[i] - (extend1[0].CompProduct4(absRot[i][0]) + extend1[1].CompProduct4(absRot[i][1]) + extend1[2].CompProduct4(absRot[i][2])));
+		const dgVector better (separation > bestSeparation);
+		bestAxis = dgBatchSelect (dgVector (dgFloat32 (i)), bestAxis, better);
+		bestSeparation = dgBatchSelect (separation, bestSeparation, better);
+		bestNormal = axis0[i].Scale (dgBatchSign (dist)).Select (bestNormal, better);
+	}
+	for (dgInt32 j = 0; j < 3; j ++) {
+		const dgVector dist (step.DotProduct(axis1[j]));
+		const dgVector separation (dist.Abs() - extend1[j] - (extend0[0].CompProduct4(absRot[0][j]) + extend0[1].CompProduct4(absRot[1][j]) + extend0[2].CompProduct4(absRot[2][j])));
+		const dgVector better (separation > bestSeparation);
+		bestAxis = dgBatchSelect (dgVector (dgFloat32 (3 + j)), bestAxis, better);
+		bestSeparation = dgBatchSelect (separation, bestSeparation, better);
+		bestNormal = axis1[j].Scale (dgBatchSign (dist)).Select (bestNormal, better);
+	}
+
+	const dgVector minEdgeAxis (DG_PRIMITIVE_BATCH_MIN_EDGE_AXIS);
+	const dgVector faceSeparation (bestSeparation + dgVector (DG_PRIMITIVE_BATCH_EDGE_AXIS_BIAS));
+	for (dgInt32 i = 0; i < 3; i ++) {
+		for (dgInt32 j = 0; j < 3; j ++) {
+			const dgPrimitiveSoaVector axis (axis0[i].CrossProduct(axis1[j]));
+			const dgVector mag2 (axis.DotProduct(axis));
+			const dgPrimitiveSoaVector normal (axis.Scale (mag2.GetMax(minEdgeAxis).Sqrt().Reciproc()));
+			const dgVector dist (step.DotProduct(normal));
+			dgVector radius (dgVector::m_zero);
+			for (dgInt32 k = 0; k < 3; k ++) {
+				radius += extend0[k].CompProduct4(axis0[k].DotProduct(normal).Abs()) + extend1[k].CompProduct4(axis1[k].DotProduct(normal).Abs());
+			}
+			const dgVector separation (dist.Abs() - radius);
+			const dgVector better ((mag2 > minEdgeAxis) & (separation > faceSeparation) & (separation > bestSeparation));
+			bestAxis = dgBatchSelect (dgVector (dgFloat32 (6 + i * 3 + j)), bestAxis, better);
+			bestSeparation = dgBatchSelect (separation, bestSeparation, better);
+			bestNormal = normal.Scale (dgBatchSign (dist)).Select (bestNormal, better);
+		}
+	}
+
+	dgVector normalOut[DG_PRIMITIVE_BATCH_WIDTH];
+	bestNormal.Scatter (normalOut, dgVector::m_zero);
+	for (dgInt32 i = 0; i < DG_PRIMITIVE_BATCH_WIDTH; i ++) {
+		contacts[i].m_normal = normalOut[i];
+		contacts[i].m_distance = bestSeparation[i];
+		separatingAxis[i] = dgInt32 (bestAxis[i]);
+	}
+}
+
+
+dgInt32 dgWorld::GetPrimitiveBatchKind (const dgContact* const contact) const
+{
+	if (!m_primitiveContacts || contact->m_material->m_contactGeneration) {
+		return -1;
+	}
+
+	const dgCollisionID type0 = contact->m_body0->m_collision->GetCollisionPrimityType();
+	const dgCollisionID type1 = contact->m_body1->m_collision->GetCollisionPrimityType();
+	if (type0 == m_sphereCollision) {
+		if (type1 == m_sphereCollision) {
+			return m_sphereSphereBatch;
+		} else if (type1 == m_boxCollision) {
+			return m_sphereBoxBatch;
+		}
+	} else if (type0 == m_boxCollision) {
+		if (type1 == m_sphereCollision) {
+			return m_sphereBoxBatch;
+		} else if (type1 == m_boxCollision) {
+			return m_boxBoxBatch;
+		}
+	}
+	return -1;
+}
+
+// the lanes that the kernels can not handle are marked not valid, those pairs go to the scalar narrow phase
+void dgWorld::CalculatePrimitiveContactBatch (dgInt32 kind, dgContact* const* const pairs, dgInt32 count, dgPrimitiveContact* const contacts, dgInt32* const valid) const
+{
+	dgAssert (DG_PRIMITIVE_BATCH_WIDTH == sizeof (dgVector) / sizeof (dgFloat32));
+	dgAssert ((count > 0) && (count <= DG_PRIMITIVE_BATCH_WIDTH));
+
+	dgMatrix matrix0[DG_PRIMITIVE_BATCH_WIDTH];
+	dgMatrix matrix1[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector size0[DG_PRIMITIVE_BATCH_WIDTH];
+	dgVector size1[DG_PRIMITIVE_BATCH_WIDTH];
+	dgInt32 swapShapes[DG_PRIMITIVE_BATCH_WIDTH];
+
+	dgInt32 validLane = -1;
+	for (dgInt32 i = 0; i < DG_PRIMITIVE_BATCH_WIDTH; i ++) {
+		valid[i] = 0;
+		swapShapes[i] = 0;
+		if (i < count) {
+			const dgCollisionInstance* instance0 = pairs[i]->m_body0->m_collision;
+			const dgCollisionInstance* instance1 = pairs[i]->m_body1->m_collision;
+			if (instance0->GetCollisionPrimityType() != instance1->GetCollisionPrimityType()) {
+				// the sphere is always shape 0 of a sphere box lane
+				if (instance0->GetCollisionPrimityType() == m_boxCollision) {
+					dgSwap (instance0, instance1);
+					swapShapes[i] = 1;
+				}
+			}
+
+			dgFloat32 radius0;
+			dgFloat32 radius1;
+			switch (kind)
+			{
+				case m_sphereSphereBatch:
+					valid[i] = GetPrimitiveSphereRadius (instance0, radius0) && GetPrimitiveSphereRadius (instance1, radius1);
+					size0[i] = dgVector (radius0);
+					size1[i] = dgVector (radius1);
+					break;
+
+				case m_sphereBoxBatch:
+					valid[i] = GetPrimitiveSphereRadius (instance0, radius0) && GetPrimitiveBoxSize (instance1, size1[i]);
+					size0[i] = dgVector (radius0);
+					break;
+
+				case m_boxBoxBatch:
+					valid[i] = GetPrimitiveBoxSize (instance0, size0[i]) && GetPrimitiveBoxSize (instance1, size1[i]);
+					break;
+
+				default:
+					dgAssert (0);
+			}
+			matrix0[i] = instance0->m_globalMatrix;
+			matrix1[i] = instance1->m_globalMatrix;
+			if (valid[i]) {
+				validLane = i;
+			}
+		}
+	}
+
+	if (validLane < 0) {
+		return;
+	}
+
+	// the empty lanes repeat a good pair, their results are ignored
+	for (dgInt32 i = 0; i < DG_PRIMITIVE_BATCH_WIDTH; i ++) {
+		if (!valid[i]) {
+			matrix0[i] = matrix0[validLane];
+			matrix1[i] = matrix1[validLane];
+			size0[i] = size0[validLane];
+			size1[i] = size1[validLane];
+		}
+	}
+
+	switch (kind)
+	{
+		case m_sphereSphereBatch:
+			dgSphereSphereContactBatch (matrix0, size0, matrix1, size1, contacts, valid);
+			break;
+
+		case m_sphereBoxBatch:
+			dgSphereBoxContactBatch (matrix0, size0, matrix1, size1, contacts, valid);
+			break;
+
+		case m_boxBoxBatch:
+		{
+			dgInt32 separatingAxis[DG_PRIMITIVE_BATCH_WIDTH];
+			dgBoxBoxContactBatch (matrix0, size0, matrix1, size1, contacts, separatingAxis);
+			for (dgInt32 i = 0; i < count; i ++) {
+				if (valid[i]) {
+					const dgVector normal (contacts[i].m_normal);
+					const dgFloat32 separation = contacts[i].m_distance;
+					BoxBoxClosestPoints (matrix0[i], size0[i], matrix1[i], size1[i], separatingAxis[i], separation, normal, contacts[i]);
+				}
+			}
+			break;
+		}
+	}
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		if (valid[i] && swapShapes[i]) {
+			contacts[i].Swap();
+		}
+	}
+}
+
+// same as dgWorld::CalculateContacts for a convex pair, but with the closest features already known
+void dgWorld::CalculatePrimitivePairContacts (dgBroadPhase::dgPair* const pair, const dgPrimitiveContact& contact, dgInt32 threadIndex) const
+{
+	dgContact* const contactJoint = pair->m_contact;
+	const dgContactMaterial* const material = contactJoint->m_material;
+	dgCollisionParamProxy proxy(contactJoint, pair->m_contactBuffer, threadIndex, false, false);
+
+	proxy.m_timestep = pair->m_timestep;
+	proxy.m_maxContacts = DG_MAX_CONTATCS;
+	proxy.m_skinThickness = material->m_skinThickness;
+	proxy.m_body0 = contactJoint->m_body0;
+	proxy.m_body1 = contactJoint->m_body1;
+	proxy.m_instance0 = proxy.m_body0->m_collision;
+	proxy.m_instance1 = proxy.m_body1->m_collision;
+	proxy.m_featureCache = contactJoint->m_featureCache.Bind (proxy.m_instance0, proxy.m_instance1);
+
+	contactJoint->m_closestDistance = dgFloat32(1.0e10f);
+	contactJoint->m_separationDistance = dgFloat32(0.0f);
+	pair->m_contactCount = EmitPrimitiveContacts (proxy, contact);
+	pair->m_timestep = proxy.m_timestep;
+}
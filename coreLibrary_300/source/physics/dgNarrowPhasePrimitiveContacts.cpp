@@ -0,0 +1,502 @@
+/* Copyright (c) <2003-2016> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dgPhysicsStdafx.h"
+#include "dgBody.h"
+#include "dgWorld.h"
+#include "dgContact.h"
+#include "dgContactSolver.h"
+#include "dgCollisionBox.h"
+#include "dgCollisionSphere.h"
+#include "dgCollisionCapsule.h"
+#include "dgCollisionInstance.h"
+
+#define DG_PRIMITIVE_MIN_DISTANCE		dgFloat32 (1.0e-5f)
+#define DG_PRIMITIVE_PARALLEL_AXIS		dgFloat32 (0.998f)
+#define DG_PRIMITIVE_EDGE_AXIS_BIAS		dgFloat32 (1.0e-3f)
+
+
+// the kernels only deal with scales that keep the shape a sphere, a capsule or a box
+static bool dgGetUniformScale (const dgCollisionInstance* const instance, dgFloat32& scale)
+{
+	switch (instance->GetScaleType())
+	{
+		case dgCollisionInstance::m_unit:
+			scale = dgFloat32 (1.0f);
+			return true;
+
+		case dgCollisionInstance::m_uniform:
+			scale = instance->m_scale.m_x;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+static bool dgGetBoxScale (const dgCollisionInstance* const instance, dgVector& scale)
+{
+	switch (instance->GetScaleType())
+	{
+		case dgCollisionInstance::m_unit:
+			scale = dgVector (dgFloat32 (1.0f), dgFloat32 (1.0f), dgFloat32 (1.0f), dgFloat32 (0.0f));
+			return true;
+
+		case dgCollisionInstance::m_uniform:
+		case dgCollisionInstance::m_nonUniform:
+			scale = instance->m_scale & dgVector::m_triplexMask;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+bool dgWorld::GetPrimitiveSphereRadius (const dgCollisionInstance* const sphere, dgFloat32& radius) const
+{
+	dgFloat32 scale;
+	// the point shape of the world is a sphere with a special support function
+	if (!dgGetUniformScale (sphere, scale) || (sphere->m_childShape == m_pointCollision->m_childShape)) {
+		return false;
+	}
+	radius = ((dgCollisionSphere*) sphere->m_childShape)->m_radius * scale;
+	return true;
+}
+
+bool dgWorld::GetPrimitiveBoxSize (const dgCollisionInstance* const box, dgVector& size) const
+{
+	dgVector scale;
+	if (!dgGetBoxScale (box, scale)) {
+		return false;
+	}
+	size = ((dgCollisionBox*) box->m_childShape)->m_size[0].CompProduct4 (scale);
+	return true;
+}
+
+void dgWorld::InitPrimitiveContacts ()
+{
+	m_primitiveContacts = 1;
+	memset (m_primitiveContactKernels, 0, sizeof (m_primitiveContactKernels));
+
+	m_primitiveContactKernels[m_sphereCollision][m_sphereCollision].m_callback = &dgWorld::SphereSphereContacts;
+
+	m_primitiveContactKernels[m_sphereCollision][m_capsuleCollision].m_callback = &dgWorld::SphereCapsuleContacts;
+	m_primitiveContactKernels[m_capsuleCollision][m_sphereCollision].m_callback = &dgWorld::SphereCapsuleContacts;
+	m_primitiveContactKernels[m_capsuleCollision][m_sphereCollision].m_swapShapes = 1;
+
+	m_primitiveContactKernels[m_sphereCollision][m_boxCollision].m_callback = &dgWorld::SphereBoxContacts;
+	m_primitiveContactKernels[m_boxCollision][m_sphereCollision].m_callback = &dgWorld::SphereBoxContacts;
+	m_primitiveContactKernels[m_boxCollision][m_sphereCollision].m_swapShapes = 1;
+
+	m_primitiveContactKernels[m_capsuleCollision][m_capsuleCollision].m_callback = &dgWorld::CapsuleCapsuleContacts;
+	m_primitiveContactKernels[m_boxCollision][m_boxCollision].m_callback = &dgWorld::BoxBoxContacts;
+}
+
+
+// returns false when the pair has no kernel or the kernel can not handle it, the pair then goes to the contact solver.
+bool dgWorld::CalculatePrimitiveContacts (dgCollisionParamProxy& proxy, dgInt32& count) const
+{
+	dgCollisionInstance* const collision0 = proxy.m_instance0;
+	dgCollisionInstance* const collision1 = proxy.m_instance1;
+	const dgCollisionID type0 = collision0->GetCollisionPrimityType();
+	const dgCollisionID type1 = collision1->GetCollisionPrimityType();
+	// mesh faces come here as polygon shapes, they do not have kernels
+	if ((type0 >= m_nullCollision) || (type1 >= m_nullCollision)) {
+		return false;
+	}
+
+	const dgPrimitiveContactKernel& kernel = m_primitiveContactKernels[type0][type1];
+	if (!kernel.m_callback) {
+		return false;
+	}
+
+	dgPrimitiveContact contact;
+	contact.m_count = 0;
+	if (kernel.m_swapShapes) {
+		if (!(this->*kernel.m_callback) (collision1, collision0, contact)) {
+			return false;
+		}
+		contact.Swap();
+	} else if (!(this->*kernel.m_callback) (collision0, collision1, contact)) {
+		return false;
+	}
+
+	count = EmitPrimitiveContacts (proxy, contact);
+	return true;
+}
+
+// the proxy and the contact joint are set the same way dgContactSolver::CalculateConvexToConvexContacts sets them
+dgInt32 dgWorld::EmitPrimitiveContacts (dgCollisionParamProxy& proxy, const dgPrimitiveContact& contact) const
+{
+	dgCollisionInstance* const collision0 = proxy.m_instance0;
+	dgCollisionInstance* const collision1 = proxy.m_instance1;
+	dgContact* const contactJoint = proxy.m_contactJoint;
+	contactJoint->m_isNewContact = false;
+	contactJoint->m_separtingVector = contact.m_normal;
+
+	const dgFloat32 penetration = contact.m_distance - proxy.m_skinThickness - DG_PENETRATION_TOL;
+	if (proxy.m_intersectionTestOnly) {
+		const dgInt32 retVal = (penetration <= dgFloat32(0.0f)) ? -1 : 0;
+		contactJoint->m_contactActive = retVal;
+		return retVal;
+	}
+
+	dgInt32 count = 0;
+	const dgVector* contacts = contact.m_contacts;
+	dgContactSolver contactSolver (&proxy);
+	if (penetration <= dgFloat32(1.0e-5f)) {
+		contactJoint->m_contactActive = 1;
+		if (collision0->GetCollisionMode() & collision1->GetCollisionMode()) {
+			count = contact.m_count;
+			if (!count) {
+				count = contactSolver.CalculateContacts (contact.m_point0, contact.m_point1, contact.m_normal.Scale4 (dgFloat32 (-1.0f)));
+				contacts = contactSolver.GetContacts();
+			}
+		}
+	}
+
+	proxy.m_closestPointBody0 = contact.m_point0;
+	proxy.m_closestPointBody1 = contact.m_point1;
+	contactJoint->m_closestDistance = penetration;
+	contactJoint->m_separationDistance = penetration;
+
+	const dgVector normal (contact.m_normal.Scale4 (dgFloat32 (-1.0f)));
+	proxy.m_normal = normal;
+	count = dgMin (proxy.m_maxContacts, count);
+
+	dgContactPoint* const contactOut = proxy.m_contacts;
+	for (dgInt32 i = 0; i < count; i ++) {
+		contactOut[i].m_point = contacts[i];
+		contactOut[i].m_normal = normal;
+		contactOut[i].m_penetration = -penetration;
+		contactOut[i].m_body0 = proxy.m_body0;
+		contactOut[i].m_body1 = proxy.m_body1;
+		contactOut[i].m_collision0 = collision0;
+		contactOut[i].m_collision1 = collision1;
+		contactOut[i].m_shapeId0 = collision0->GetUserDataID();
+		contactOut[i].m_shapeId1 = collision1->GetUserDataID();
+	}
+	return count;
+}
+
+
+bool dgWorld::SphereSphereContacts (const dgCollisionInstance* const sphere0, const dgCollisionInstance* const sphere1, dgPrimitiveContact& contact) const
+{
+	dgFloat32 radius0;
+	dgFloat32 radius1;
+	if (!(GetPrimitiveSphereRadius (sphere0, radius0) && GetPrimitiveSphereRadius (sphere1, radius1))) {
+		return false;
+	}
+
+	const dgVector& center0 = sphere0->m_globalMatrix.m_posit;
+	const dgVector& center1 = sphere1->m_globalMatrix.m_posit;
+
+	const dgVector dir ((center1 - center0) & dgVector::m_triplexMask);
+	const dgFloat32 dist2 = dir.DotProduct3(dir);
+	if (dist2 < (DG_PRIMITIVE_MIN_DISTANCE * DG_PRIMITIVE_MIN_DISTANCE)) {
+		return false;
+	}
+	const dgFloat32 dist = dgSqrt (dist2);
+
+	contact.m_normal = dir.Scale4 (dgFloat32 (1.0f) / dist);
+	contact.m_point0 = center0 + contact.m_normal.Scale4 (radius0);
+	contact.m_point1 = center1 - contact.m_normal.Scale4 (radius1);
+	contact.m_distance = dist - radius0 - radius1;
+	contact.m_contacts[0] = (contact.m_point0 + contact.m_point1).Scale4 (dgFloat32 (0.5f)) | dgVector::m_wOne;
+	contact.m_count = 1;
+	return true;
+}
+
+bool dgWorld::SphereCapsuleContacts (const dgCollisionInstance* const sphere, const dgCollisionInstance* const capsule, dgPrimitiveContact& contact) const
+{
+	dgFloat32 radius0;
+	dgFloat32 scale1;
+	if (!(GetPrimitiveSphereRadius (sphere, radius0) && dgGetUniformScale (capsule, scale1))) {
+		return false;
+	}
+	const dgCollisionCapsule* const capsuleShape = (dgCollisionCapsule*) capsule->m_childShape;
+	if (capsuleShape->m_radio0 != capsuleShape->m_radio1) {
+		return false;
+	}
+
+	const dgFloat32 radius1 = capsuleShape->m_radio0 * scale1;
+	const dgMatrix& matrix = capsule->m_globalMatrix;
+	const dgVector axis (matrix.m_front.Scale4 (capsuleShape->m_height * scale1));
+	const dgVector& center0 = sphere->m_globalMatrix.m_posit;
+
+	// the sphere against the closest point of the capsule segment
+	const dgVector p0 (matrix.m_posit - axis);
+	const dgVector segment (axis.Scale4 (dgFloat32 (2.0f)));
+	const dgFloat32 t = dgClamp ((center0 - p0).DotProduct3(segment) / segment.DotProduct3(segment), dgFloat32 (0.0f), dgFloat32 (1.0f));
+	const dgVector center1 (p0 + segment.Scale4 (t));
+
+	const dgVector dir ((center1 - center0) & dgVector::m_triplexMask);
+	const dgFloat32 dist2 = dir.DotProduct3(dir);
+	if (dist2 < (DG_PRIMITIVE_MIN_DISTANCE * DG_PRIMITIVE_MIN_DISTANCE)) {
+		return false;
+	}
+	const dgFloat32 dist = dgSqrt (dist2);
+
+	contact.m_normal = dir.Scale4 (dgFloat32 (1.0f) / dist);
+	contact.m_point0 = center0 + contact.m_normal.Scale4 (radius0);
+	contact.m_point1 = center1 - contact.m_normal.Scale4 (radius1);
+	contact.m_distance = dist - radius0 - radius1;
+	contact.m_contacts[0] = (contact.m_point0 + contact.m_point1).Scale4 (dgFloat32 (0.5f)) | dgVector::m_wOne;
+	contact.m_count = 1;
+	return true;
+}
+
+bool dgWorld::SphereBoxContacts (const dgCollisionInstance* const sphere, const dgCollisionInstance* const box, dgPrimitiveContact& contact) const
+{
+	dgFloat32 radius;
+	dgVector size;
+	if (!(GetPrimitiveSphereRadius (sphere, radius) && GetPrimitiveBoxSize (box, size))) {
+		return false;
+	}
+
+	const dgMatrix& matrix = box->m_globalMatrix;
+	const dgVector& center = sphere->m_globalMatrix.m_posit;
+	const dgVector localCenter (matrix.UntransformVector (center) & dgVector::m_triplexMask);
+	const dgVector closest (localCenter.GetMax (size.Scale4 (dgFloat32 (-1.0f))).GetMin (size));
+
+	dgVector localNormal;
+	dgVector localPoint;
+	dgFloat32 dist;
+	const dgVector dir (localCenter - closest);
+	const dgFloat32 dist2 = dir.DotProduct3(dir);
+	if (dist2 > (DG_PRIMITIVE_MIN_DISTANCE * DG_PRIMITIVE_MIN_DISTANCE)) {
+		// the center is outside the box, the closest point is on a face, an edge or a vertex
+		dist = dgSqrt (dist2);
+		localNormal = dir.Scale4 (dgFloat32 (1.0f) / dist);
+		localPoint = closest;
+	} else {
+		// the center is inside the box, push it out through the closest face
+		dgInt32 axis = 0;
+		dgFloat32 depth = size[0] - dgAbsf (localCenter[0]);
+		for (dgInt32 i = 1; i < 3; i ++) {
+			const dgFloat32 faceDepth = size[i] - dgAbsf (localCenter[i]);
+			if (faceDepth < depth) {
+				depth = faceDepth;
+				axis = i;
+			}
+		}
+		const dgFloat32 side = (localCenter[axis] >= dgFloat32 (0.0f)) ? dgFloat32 (1.0f) : dgFloat32 (-1.0f);
+		localNormal = dgVector (dgFloat32 (0.0f));
+		localNormal[axis] = side;
+		localPoint = localCenter;
+		localPoint[axis] = size[axis] * side;
+		dist = -depth;
+	}
+
+	// the local normal points from the box to the sphere
+	contact.m_normal = matrix.RotateVector (localNormal.Scale4 (dgFloat32 (-1.0f)));
+	contact.m_point1 = matrix.TransformVector (localPoint);
+	contact.m_point0 = center + contact.m_normal.Scale4 (radius);
+	contact.m_distance = dist - radius;
+	contact.m_contacts[0] = (contact.m_point0 + contact.m_point1).Scale4 (dgFloat32 (0.5f)) | dgVector::m_wOne;
+	contact.m_count = 1;
+	return true;
+}
+
+bool dgWorld::CapsuleCapsuleContacts (const dgCollisionInstance* const capsule0, const dgCollisionInstance* const capsule1, dgPrimitiveContact& contact) const
+{
+	dgFloat32 scale0;
+	dgFloat32 scale1;
+	if (!(dgGetUniformScale (capsule0, scale0) && dgGetUniformScale (capsule1, scale1))) {
+		return false;
+	}
+	const dgCollisionCapsule* const shape0 = (dgCollisionCapsule*) capsule0->m_childShape;
+	const dgCollisionCapsule* const shape1 = (dgCollisionCapsule*) capsule1->m_childShape;
+	if ((shape0->m_radio0 != shape0->m_radio1) || (shape1->m_radio0 != shape1->m_radio1)) {
+		return false;
+	}
+
+	const dgFloat32 radius0 = shape0->m_radio0 * scale0;
+	const dgFloat32 radius1 = shape1->m_radio0 * scale1;
+	const dgVector& dir0 = capsule0->m_globalMatrix.m_front;
+	const dgVector& dir1 = capsule1->m_globalMatrix.m_front;
+	const dgFloat32 height0 = shape0->m_height * scale0;
+	const dgFloat32 height1 = shape1->m_height * scale1;
+	const dgVector p0 (capsule0->m_globalMatrix.m_posit - dir0.Scale4 (height0));
+	const dgVector p1 (capsule0->m_globalMatrix.m_posit + dir0.Scale4 (height0));
+	const dgVector q0 (capsule1->m_globalMatrix.m_posit - dir1.Scale4 (height1));
+	const dgVector q1 (capsule1->m_globalMatrix.m_posit + dir1.Scale4 (height1));
+
+	dgVector closest0;
+	dgVector closest1;
+	dgRayToRayDistance (p0, p1, q0, q1, closest0, closest1);
+	const dgVector dir ((closest1 - closest0) & dgVector::m_triplexMask);
+	const dgFloat32 dist2 = dir.DotProduct3(dir);
+	if (dist2 < (DG_PRIMITIVE_MIN_DISTANCE * DG_PRIMITIVE_MIN_DISTANCE)) {
+		// the segments cross, there is not a unique normal
+		return false;
+	}
+	const dgFloat32 dist = dgSqrt (dist2);
+
+	contact.m_normal = dir.Scale4 (dgFloat32 (1.0f) / dist);
+	contact.m_point0 = closest0 + contact.m_normal.Scale4 (radius0);
+	contact.m_point1 = closest1 - contact.m_normal.Scale4 (radius1);
+	contact.m_distance = dist - radius0 - radius1;
+
+	contact.m_count = 0;
+	if (dgAbsf (dir0.DotProduct3(dir1)) > DG_PRIMITIVE_PARALLEL_AXIS) {
+		// parallel capsules touch along the overlap of the two segments
+		const dgFloat32 base = capsule0->m_globalMatrix.m_posit.DotProduct3(dir0);
+		dgFloat32 min1 = q0.DotProduct3(dir0) - base;
+		dgFloat32 max1 = q1.DotProduct3(dir0) - base;
+		if (min1 > max1) {
+			dgSwap (min1, max1);
+		}
+		const dgFloat32 clip0 = dgMax (min1, -height0);
+		const dgFloat32 clip1 = dgMin (max1, height0);
+		if ((clip1 - clip0) > DG_PRIMITIVE_MIN_DISTANCE) {
+			const dgVector offset (contact.m_normal.Scale4 (radius0 + contact.m_distance * dgFloat32 (0.5f)));
+			contact.m_contacts[0] = capsule0->m_globalMatrix.m_posit + dir0.Scale4 (clip0) + offset;
+			contact.m_contacts[1] = capsule0->m_globalMatrix.m_posit + dir0.Scale4 (clip1) + offset;
+			contact.m_count = 2;
+		}
+	}
+	if (!contact.m_count) {
+		contact.m_contacts[0] = (contact.m_point0 + contact.m_point1).Scale4 (dgFloat32 (0.5f)) | dgVector::m_wOne;
+		contact.m_count = 1;
+	}
+	return true;
+}
+
+
+// separating axis test over the three face normals of each box and the nine edge cross products.
+// when the boxes are apart the distance is the separation along the best axis, which is never larger than the real distance
+bool dgWorld::BoxBoxContacts (const dgCollisionInstance* const box0, const dgCollisionInstance* const box1, dgPrimitiveContact& contact) const
+{
+	dgVector size0;
+	dgVector size1;
+	if (!(GetPrimitiveBoxSize (box0, size0) && GetPrimitiveBoxSize (box1, size1))) {
+		return false;
+	}
+
+	const dgMatrix& matrix0 = box0->m_globalMatrix;
+	const dgMatrix& matrix1 = box1->m_globalMatrix;
+	const dgVector step ((matrix1.m_posit - matrix0.m_posit) & dgVector::m_triplexMask);
+
+	// rotation of box1 in the space of box0, and its absolute value
+	dgFloat32 rot[3][3];
+	dgFloat32 absRot[3][3];
+	for (dgInt32 i = 0; i < 3; i ++) {
+		for (dgInt32 j = 0; j < 3; j ++) {
+			rot[i][j] = matrix0[i].DotProduct3(matrix1[j]);
+			absRot[i][j] = dgAbsf (rot[i][j]);
+		}
+	}
+
+	dgInt32 bestAxis = -1;
+	dgFloat32 bestSeparation = dgFloat32 (-1.0e10f);
+	dgVector bestNormal (dgFloat32 (0.0f));
+
+	// face axes first, an edge axis must be clearly better to replace them
+	for (dgInt32 i = 0; i < 3; i ++) {
+		const dgFloat32 dist = step.DotProduct3(matrix0[i]);
+		const dgFloat32 separation = dgAbsf (dist) - size0[i] - (size1[0] * absRot[i][0] + size1[1] * absRot[i][1] + size1[2] * absRot[i][2]);
+		if (separation > bestSeparation) {
+			bestAxis = i;
+			bestSeparation = separation;
+			bestNormal = (dist >= dgFloat32 (0.0f)) ? matrix0[i] : matrix0[i].Scale4 (dgFloat32 (-1.0f));
+		}
+	}
+	for (dgInt32 j = 0; j < 3; j ++) {
+		const dgFloat32 dist = step.DotProduct3(matrix1[j]);
+		const dgFloat32 separation = dgAbsf (dist) - size1[j] - (size0[0] * absRot[0][j] + size0[1] * absRot[1][j] + size0[2] * absRot[2][j]);
+		if (separation > bestSeparation) {
+			bestAxis = 3 + j;
+			bestSeparation = separation;
+			bestNormal = (dist >= dgFloat32 (0.0f)) ? matrix1[j] : matrix1[j].Scale4 (dgFloat32 (-1.0f));
+		}
+	}
+
+	const dgFloat32 faceSeparation = bestSeparation + DG_PRIMITIVE_EDGE_AXIS_BIAS;
+	for (dgInt32 i = 0; i < 3; i ++) {
+		for (dgInt32 j = 0; j < 3; j ++) {
+			const dgVector axis (matrix0[i].CrossProduct3(matrix1[j]));
+			const dgFloat32 mag2 = axis.DotProduct3(axis);
+			if (mag2 > dgFloat32 (1.0e-6f)) {
+				const dgVector normal (axis.Scale4 (dgRsqrt (mag2)));
+				const dgFloat32 dist = step.DotProduct3(normal);
+				dgFloat32 radius = dgFloat32 (0.0f);
+				for (dgInt32 k = 0; k < 3; k ++) {
+					radius += size0[k] * dgAbsf (matrix0[k].DotProduct3(normal)) + size1[k] * dgAbsf (matrix1[k].DotProduct3(normal));
+				}
+				const dgFloat32 separation = dgAbsf (dist) - radius;
+				if ((separation > faceSeparation) && (separation > bestSeparation)) {
+					bestAxis = 6 + i * 3 + j;
+					bestSeparation = separation;
+					bestNormal = (dist >= dgFloat32 (0.0f)) ? normal : normal.Scale4 (dgFloat32 (-1.0f));
+				}
+			}
+		}
+	}
+
+	BoxBoxClosestPoints (matrix0, size0, matrix1, size1, bestAxis, bestSeparation, bestNormal, contact);
+	return true;
+}
+
+// the closest points come from the two edges or from the deepest vertex against the reference face,
+// the contact polygon is left to the contact solver.
+void dgWorld::BoxBoxClosestPoints (const dgMatrix& matrix0, const dgVector& size0, const dgMatrix& matrix1, const dgVector& size1, dgInt32 bestAxis, dgFloat32 bestSeparation, const dgVector& bestNormal, dgPrimitiveContact& contact)
+{
+	contact.m_normal = bestNormal;
+	contact.m_distance = bestSeparation;
+	contact.m_count = 0;
+	if (bestAxis >= 6) {
+		// edge against edge, each edge is the one of its box that is extreme along the normal
+		const dgInt32 i = (bestAxis - 6) / 3;
+		const dgInt32 j = (bestAxis - 6) % 3;
+		dgVector edge0 (matrix0.m_posit);
+		dgVector edge1 (matrix1.m_posit);
+		for (dgInt32 k = 0; k < 3; k ++) {
+			if (k != i) {
+				const dgFloat32 side = (matrix0[k].DotProduct3(bestNormal) >= dgFloat32 (0.0f)) ? size0[k] : -size0[k];
+				edge0 += matrix0[k].Scale4 (side);
+			}
+			if (k != j) {
+				const dgFloat32 side = (matrix1[k].DotProduct3(bestNormal) <= dgFloat32 (0.0f)) ? size1[k] : -size1[k];
+				edge1 += matrix1[k].Scale4 (side);
+			}
+		}
+		const dgVector dir0 (matrix0[i].Scale4 (size0[i]));
+		const dgVector dir1 (matrix1[j].Scale4 (size1[j]));
+		dgRayToRayDistance (edge0 - dir0, edge0 + dir0, edge1 - dir1, edge1 + dir1, contact.m_point0, contact.m_point1);
+		return;
+	}
+
+	// the deepest vertex of the incident box and its projection on the reference face
+	const bool referenceIsBox0 = (bestAxis < 3);
+	const dgMatrix& incMatrix = referenceIsBox0 ? matrix1 : matrix0;
+	const dgVector& incSize = referenceIsBox0 ? size1 : size0;
+	const dgVector refNormal (referenceIsBox0 ? bestNormal : bestNormal.Scale4 (dgFloat32 (-1.0f)));
+
+	dgVector incPoint (incMatrix.m_posit);
+	for (dgInt32 k = 0; k < 3; k ++) {
+		const dgFloat32 side = (incMatrix[k].DotProduct3(refNormal) > dgFloat32 (0.0f)) ? -incSize[k] : incSize[k];
+		incPoint += incMatrix[k].Scale4 (side);
+	}
+	const dgVector refPoint (incPoint + refNormal.Scale4 (-bestSeparation));
+	contact.m_point0 = referenceIsBox0 ? refPoint : incPoint;
+	contact.m_point1 = referenceIsBox0 ? incPoint : refPoint;
+}
@@ -52,6 +52,7 @@
 #include "dgCollisionHeightField.h"
 #include "dgCollisionConvexPolygon.h"
 #include "dgCollisionDeformableMesh.h"
+#include "dgCollisionHeightFieldTiled.h"
 #include "dgCollisionCompoundFractured.h"
 #include "dgCollisionLumpedMassParticles.h"
 
@@ -31,13 +31,18 @@
 #include "dgCollisionScene.h"
 #include "dgCollisionSphere.h"
 #include "dgCollisionCapsule.h"
+#include "dgBroadPhaseLinear.h"
+#include "dgBroadPhaseQuad.h"
+#include "dgBroadPhaseSweepAndPrune.h"
 #include "dgBroadPhaseDefault.h"
 #include "dgCollisionInstance.h"
 #include "dgCollisionCompound.h"
 #include "dgWorldDynamicUpdate.h"
 #include "dgCollisionConvexHull.h"
 #include "dgBroadPhasePersistent.h"
+#include "dgBroadPhaseAggregate.h"
 #include "dgCollisionChamferCylinder.h"
+#include "dgCollisionHeightFieldTiled.h"
 
 #include "dgUserConstraint.h"
 #include "dgBallConstraint.h"
@@ -217,11 +222,13 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator, dgInt32 stackSize)
 	,m_pointCollision(NULL)
 	,m_preListener(allocator)
 	,m_postListener(allocator)
+	,m_tiledHeightFields(allocator)
 	,m_perInstanceData(allocator)
 	,m_bodiesMemory (allocator, 64)
 	,m_jointsMemory (allocator, 64)
 	,m_solverJacobiansMemory (allocator, 64)
 	,m_solverForceAccumulatorMemory (allocator, 64)
+	,m_solverSoaMemory (allocator, 64)
 	,m_clusterMemory (allocator, 64)
 {
 	dgMutexThread* const mutexThread = this;
@@ -238,6 +245,9 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator, dgInt32 stackSize)
 	m_allocator = allocator;
 	m_clusterUpdate = NULL;
 	m_getDebugTime = NULL;
+	m_collectStats = 0;
+	m_stats.Clear();
+	InitPrimitiveContacts ();
 
 	m_onCollisionInstanceDestruction = NULL;
 	m_onCollisionInstanceCopyConstrutor = NULL;
@@ -272,6 +282,7 @@ dgWorld::dgWorld(dgMemoryAllocator* const allocator, dgInt32 stackSize)
 
 	m_solverConvergeQuality = 0;
 	m_contactTolerance = DG_PRUNE_CONTACT_TOLERANCE;
+	m_broadPhaseRebuildRatio = DG_BROADPHASE_REBUILD_RATIO;
 
 	dgInt32 steps = 1;
 	dgFloat32 freezeAccel2 = m_freezeAccel2;
@@ -338,6 +349,12 @@ dgWorld::~dgWorld()
 void dgWorld::SetThreadsCount (dgInt32 count)
 {
 	dgThreadHive::SetThreadsCount(count);
+
+	// worker threads add and remove contact points in the narrow phase,
+	// the per thread caches let them do it without taking the global lock
+	if (GetThreadCount() > 1) {
+		m_allocator->SetThreadSafe (true);
+	}
 }
 
 dgUnsigned32 dgWorld::GetPerformanceCount ()
@@ -465,7 +482,7 @@ void dgWorld::DestroyAllBodies ()
 }
 
 
-void dgWorld::InitBody (dgBody* const body, dgCollisionInstance* const collision, const dgMatrix& matrix)
+void dgWorld::InitBody (dgBody* const body, dgCollisionInstance* const collision, const dgMatrix& matrix, bool addToBroadPhase)
 {
 	dgAssert (collision);
 
@@ -490,7 +507,7 @@ void dgWorld::InitBody (dgBody* const body, dgCollisionInstance* const collision
 	inertia[2][2] = DG_INFINITE_MASS;
 	body->SetMassMatrix (DG_INFINITE_MASS * dgFloat32 (2.0f), inertia);
 	body->SetMatrix (matrix);
-	if (!body->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI)) {
+	if (addToBroadPhase && !body->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI)) {
 		m_broadPhase->Add (body);
 	}
 }
@@ -542,7 +559,69 @@ dgKinematicBody* dgWorld::CreateKinematicBody (dgCollisionInstance* const collis
 }
 
 
-void dgWorld::DestroyBody(dgBody* const body)
+// the bodies of a batch are allocated back to back in one memory block, and the broad phase 
+// links all of them at once instead of inserting them one at a time
+void dgWorld::CreateBodies (dgBody::dgType type, dgInt32 count, dgCollisionInstance* const* const collisions, const dgMatrix* const matrices, dgBody** const bodies)
+{
+	dgAssert (count > 0);
+	dgAssert (dgInt32 (sizeof (dgBody) & 0xf) == 0);
+	const dgInt32 size = (type == dgBody::m_dynamicBody) ? sizeof (dgDynamicBody) : sizeof (dgKinematicBody);
+	m_allocator->MallocBlocks (size, count, (void**) bodies);
+
+	// bodies spawned from a callback of the update are added one at a time, the batch build needs the update scratch memory and the thread pool
+	const bool addToBroadPhase = m_inUpdate ? true : false;
+
+	dgInt32 broadPhaseCount = 0;
+	dgStack<dgBody*> broadPhaseBodies(count);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBody* const body = (type == dgBody::m_dynamicBody) ? (dgBody*) ::new (bodies[i]) dgDynamicBody() : (dgBody*) ::new (bodies[i]) dgKinematicBody();
+		dgAssert ((dgUnsigned64 (body) & 0xf) == 0);
+		bodies[i] = body;
+		InitBody (body, collisions[i], matrices[i], addToBroadPhase);
+		if (!addToBroadPhase && !body->GetCollision()->IsType (dgCollision::dgCollisionNull_RTTI)) {
+			broadPhaseBodies[broadPhaseCount] = body;
+			broadPhaseCount ++;
+		}
+	}
+
+	if (broadPhaseCount) {
+		m_broadPhase->AddBodies (&broadPhaseBodies[0], broadPhaseCount);
+	}
+}
+
+void dgWorld::DestroyBodies (dgBody** const bodies, dgInt32 count)
+{
+	// the listeners and the destructors see the bodies one at a time, 
+	// but the broad phase unlinks the whole batch before any body is released
+	dgInt32 broadPhaseCount = 0;
+	dgStack<dgBody*> broadPhaseBodies(count);
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBody* const body = bodies[i];
+		NotifyBodyDestroy (body);
+		if (body->m_masterNode) {
+			broadPhaseBodies[broadPhaseCount] = body;
+			broadPhaseCount ++;
+		}
+	}
+
+	if (broadPhaseCount) {
+		m_broadPhase->RemoveBodies (&broadPhaseBodies[0], broadPhaseCount);
+	}
+
+	for (dgInt32 i = 0; i < count; i ++) {
+		dgBody* const body = bodies[i];
+		if (body->m_masterNode) {
+			dgBodyMasterList::RemoveBody (body);
+		} else {
+			m_disableBodies.Remove(body);
+		}
+		dgAssert (body->m_collision);
+		body->m_collision->Release();
+		delete body;
+	}
+}
+
+void dgWorld::NotifyBodyDestroy (dgBody* const body)
 {
 	for (dgListenerList::dgListNode* node = m_postListener.GetLast(); node; node = node->GetPrev()) {
 		dgListener& listener = node->GetInfo();
@@ -558,10 +637,14 @@ void dgWorld::DestroyBody(dgBody* const body)
 		}
 	}
 
-
 	if (body->m_destructor) {
 		body->m_destructor (*body);
 	}
+}
+
+void dgWorld::DestroyBody(dgBody* const body)
+{
+	NotifyBodyDestroy (body);
 	
 	if (m_disableBodies.Find(body)) {
 		m_disableBodies.Remove(body);
@@ -909,20 +992,111 @@ void dgWorld::StepDynamics (dgFloat32 timestep)
 
 	m_inUpdate ++;
 
+	if (m_tiledHeightFields.GetCount()) {
+		UpdateTiledHeightFields (timestep);
+	}
 	m_broadPhase->UpdateContacts (timestep);
 	UpdateDynamics (timestep);
 
 	if (m_postListener.GetCount()) {
 		dTimeTrackerEvent("postListeners");
+		dgWorldStats::dgPhaseTimer timer (GetStatsCollector());
 		for (dgListenerList::dgListNode* node = m_postListener.GetFirst(); node; node = node->GetNext()) {
 			dgListener& listener = node->GetInfo();
 			listener.m_onListenerUpdate (this, listener.m_userData, timestep);
 		}
+		timer.Lap (dgWorldStats::m_postListeners);
 	}
 
 	m_inUpdate --;
 }
 
+// loads the tiles of the tiled height fields under the active dynamic bodies before the broad phase.
+// a body prefetches the tiles of the tiled height field bodies it already has a contact joint with, its box is
+// extended by the distance it can travel this step plus the prefetch distance of the height field.
+// the tiles missed by the collision queries of the last step, including the queries against tiled height
+// fields nested in compound shapes, are loaded here too.
+void dgWorld::UpdateTiledHeightFields (dgFloat32 timestep)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgWorldStats::dgPhaseTimer timer (GetStatsCollector());
+
+	for (dgList<dgCollisionHeightFieldTiled*>::dgListNode* node = m_tiledHeightFields.GetFirst(); node; node = node->GetNext()) {
+		node->GetInfo()->BeginTileRequests();
+	}
+
+	dgBroadPhaseNode** const updateArray = &m_broadPhase->m_updateArray[0];
+	const dgInt32 updateCount = m_broadPhase->m_updateCount;
+	for (dgInt32 i = 0; i < updateCount; i ++) {
+		dgBroadPhaseNode* const leaf = updateArray[i];
+		if (leaf->IsAggregate()) {
+			dgBroadPhaseAggregate* const aggregate = (dgBroadPhaseAggregate*) leaf;
+			if (aggregate->m_root) {
+				dgBroadPhaseNode* pool[DG_BROADPHASE_MAX_STACK_DEPTH];
+				pool[0] = aggregate->m_root;
+				dgInt32 stack = 1;
+				while (stack) {
+					stack --;
+					dgBroadPhaseNode* const node = pool[stack];
+					if (node->IsLeafNode()) {
+						RequestTiledHeightFieldTiles (node->GetBody(), timestep);
+					} else {
+						pool[stack] = node->GetLeft();
+						stack ++;
+						pool[stack] = node->GetRight();
+						stack ++;
+						dgAssert(stack < dgInt32(sizeof (pool) / sizeof (pool[0])));
+					}
+				}
+			}
+		} else {
+			RequestTiledHeightFieldTiles (leaf->GetBody(), timestep);
+		}
+	}
+
+	for (dgList<dgCollisionHeightFieldTiled*>::dgListNode* node = m_tiledHeightFields.GetFirst(); node; node = node->GetNext()) {
+		node->GetInfo()->CommitTileRequests();
+	}
+
+	timer.Lap (dgWorldStats::m_tileStreaming);
+}
+
+void dgWorld::RequestTiledHeightFieldTiles (dgBody* const body, dgFloat32 timestep) const
+{
+	if ((body->GetInvMass().m_w == dgFloat32 (0.0f)) || body->GetSleepState()) {
+		return;
+	}
+
+	dgVector p0;
+	dgVector p1;
+	body->GetAABB (p0, p1);
+	const dgVector step (body->GetVelocity().Scale4 (timestep));
+	p0 += step & (step < dgVector (dgFloat32 (0.0f)));
+	p1 += step & (step > dgVector (dgFloat32 (0.0f)));
+	const dgVector origin ((p1 + p0).CompProduct4 (dgVector::m_half));
+	const dgVector extends ((p1 - p0).CompProduct4 (dgVector::m_half));
+
+	const dgBodyMasterListRow& row = body->m_masterNode->GetInfo();
+	for (dgBodyMasterListRow::dgListNode* link = row.GetFirst(); link; link = link->GetNext()) {
+		const dgBodyMasterListCell& cell = link->GetInfo();
+		if (cell.m_joint->GetId() == dgConstraint::m_contactConstraint) {
+			const dgCollisionInstance* const instance = cell.m_bodyNode->GetCollision();
+			if (instance->IsType (dgCollision::dgCollisionHeightFieldTiled_RTTI)) {
+				dgCollisionHeightFieldTiled* const terrain = (dgCollisionHeightFieldTiled*) instance->GetChildShape();
+				const dgMatrix& matrix = instance->GetGlobalMatrix();
+				const dgVector invScale (instance->GetInvScale());
+				const dgVector size (extends + dgVector (terrain->GetPrefetchDistance()));
+
+				const dgVector localOrigin (matrix.UntransformVector (origin));
+				const dgVector localSize (matrix[0].Abs().DotProduct4 (size).m_x, matrix[1].Abs().DotProduct4 (size).m_x, matrix[2].Abs().DotProduct4 (size).m_x, dgFloat32 (0.0f));
+				const dgVector q0 (invScale.CompProduct4 (localOrigin - localSize) & dgVector::m_triplexMask);
+				const dgVector q1 (invScale.CompProduct4 (localOrigin + localSize) & dgVector::m_triplexMask);
+				terrain->RequestTiles (q0.GetMin (q1), q0.GetMax (q1));
+			}
+		}
+	}
+}
+
 
 void dgWorldThreadPool::OnBeginWorkerThread (dgInt32 threadId)
 {
@@ -954,6 +1128,14 @@ void dgWorld::Sync ()
 void dgWorld::RunStep ()
 {
 	dgUnsigned64 timeAcc = m_getDebugTime ? m_getDebugTime() : 0;
+	dgWorldStats* const stats = GetStatsCollector();
+	dgUnsigned64 statsTime = 0;
+	if (stats) {
+		stats->Clear();
+		stats->m_substeps = dgInt32 (m_numberOfSubsteps);
+		statsTime = dgGetTimeInNanoseconds();
+	}
+
 	dgFloat32 step = m_savetimestep / m_numberOfSubsteps;
 	for (dgUnsigned32 i = 0; i < m_numberOfSubsteps; i ++) {
 		dgInterlockedExchange(&m_delayDelateLock, 1);
@@ -967,6 +1149,9 @@ void dgWorld::RunStep ()
 		bodyList.DestroyBodies (*this);
 	}
 	m_lastExecutionTime = m_getDebugTime ? dgFloat32 (m_getDebugTime() - timeAcc) * dgFloat32 (1.0e-6f): 0;
+	if (stats) {
+		stats->m_stepTime = dgGetTimeInNanoseconds() - statsTime;
+	}
 }
 
 void dgWorld::TickCallback (dgInt32 threadID)
@@ -1111,6 +1296,17 @@ void dgWorld::SetGetTimeInMicrosenconds (OnGetTimeInMicrosenconds callback)
 	m_getDebugTime = callback;
 }
 
+void dgWorld::SetCollectStats (bool state)
+{
+	m_collectStats = state ? 1 : 0;
+	m_stats.Clear();
+}
+
+void dgWorld::SetPrimitiveContacts (bool state)
+{
+	m_primitiveContacts = state ? 1 : 0;
+}
+
 void dgWorld::SetCollisionInstanceConstructorDestructor (OnCollisionInstanceDuplicate constructor, OnCollisionInstanceDestroy destructor)
 {
 	m_onCollisionInstanceDestruction = destructor;
@@ -1350,6 +1546,18 @@ void dgWorld::SetBroadPhaseType(dgInt32 type)
 				newBroadPhase = new (m_allocator) dgBroadPhasePersistent(this);
 				break;
 
+			case m_linearBroadphase:
+				newBroadPhase = new (m_allocator) dgBroadPhaseLinear(this);
+				break;
+
+			case m_quadBroadphase:
+				newBroadPhase = new (m_allocator) dgBroadPhaseQuad(this);
+				break;
+
+			case m_sweepAndPruneBroadphase:
+				newBroadPhase = new (m_allocator) dgBroadPhaseSweepAndPrune(this);
+				break;
+
 			case m_defaultBroadphase:
 			default:
 				newBroadPhase = new (m_allocator) dgBroadPhaseDefault(this);
@@ -1362,6 +1570,23 @@ void dgWorld::SetBroadPhaseType(dgInt32 type)
 	}
 }
 
+dgFloat32 dgWorld::GetBroadPhaseRebuildRatio() const
+{
+	return m_broadPhaseRebuildRatio;
+}
+
+void dgWorld::SetBroadPhaseRebuildRatio(dgFloat32 ratio)
+{
+	// a ratio of zero disables the automatic rebuild, values close to one rebuild the tree almost every update
+	m_broadPhaseRebuildRatio = (ratio > dgFloat32 (0.0f)) ? dgMax (ratio, dgFloat32 (1.01f)) : dgFloat32 (0.0f);
+}
+
+void dgWorld::RebuildBroadPhase()
+{
+	dgAssert (m_inUpdate == 0);
+	m_broadPhase->RebuildTree();
+}
+
 
 dgSkeletonContainer* dgWorld::CreateNewtonSkeletonContainer (dgBody* const rootBone)
 {
@@ -54,7 +54,9 @@ class dgSkeletonContainer;
 class dgUpVectorConstraint;
 class dgUniversalConstraint;
 class dgCorkscrewConstraint;
+class dgPrimitiveContact;
 class dgCollisionDeformableMesh;
+class dgCollisionHeightFieldTiled;
 
 
 class dgBodyCollisionList: public dgTree<const dgCollision*, dgUnsigned32>
@@ -101,6 +103,89 @@ class dgSolverSleepTherfesholds
 	dgInt32 m_steps;
 };
 
+// breakdown of the last world update, accumulated over all the sub steps.
+// phase times are wall clock nanoseconds measured by the thread driving the update, except
+// m_integration which is added per cluster by the thread that solves it and is part of m_solver.
+class dgWorldStats
+{
+	public:
+	enum dgPhase
+	{
+		m_forceCallbacks = 0,
+		m_preListeners,
+		m_sleepingState,
+		m_tileStreaming,
+		m_broadPhase,
+		m_narrowPhase,
+		m_buildClusters,
+		m_solver,
+		m_integration,
+		m_postListeners,
+		m_phasesCount,
+	};
+
+	class dgPhaseTimer
+	{
+		public:
+		DG_INLINE dgPhaseTimer (dgWorldStats* const stats)
+			:m_stats(stats)
+			,m_time(stats ? dgGetTimeInNanoseconds() : 0)
+		{
+		}
+
+		DG_INLINE void Reset ()
+		{
+			if (m_stats) {
+				m_time = dgGetTimeInNanoseconds();
+			}
+		}
+
+		// charge the time since the last lap to a phase
+		DG_INLINE void Lap (dgPhase phase)
+		{
+			if (m_stats) {
+				dgUnsigned64 time = dgGetTimeInNanoseconds();
+				m_stats->AddTime (phase, time - m_time);
+				m_time = time;
+			}
+		}
+
+		dgWorldStats* m_stats;
+		dgUnsigned64 m_time;
+	};
+
+	void Clear ()
+	{
+		memset (this, 0, sizeof (dgWorldStats));
+	}
+
+	// safe to call from worker threads
+	DG_INLINE void AddTime (dgPhase phase, dgUnsigned64 time)
+	{
+		dgInt64* const ptr = (dgInt64*) &m_phaseTime[phase];
+		dgInt64 value = *ptr;
+		for (dgInt64 prev = dgInterlockedCompareExchange64 (ptr, value + dgInt64 (time), value); prev != value; prev = dgInterlockedCompareExchange64 (ptr, value + dgInt64 (time), value)) {
+			value = prev;
+		}
+	}
+
+	DG_INLINE void AddCount (dgInt32* const counter, dgInt32 count)
+	{
+		dgAtomicExchangeAndAdd (counter, count);
+	}
+
+	dgUnsigned64 m_phaseTime[m_phasesCount];
+	dgUnsigned64 m_stepTime;
+	dgInt32 m_substeps;
+	dgInt32 m_activeBodies;
+	dgInt32 m_pairsTested;
+	dgInt32 m_contactsCreated;
+	dgInt32 m_contactsDestroyed;
+	dgInt32 m_clusters;
+	dgInt32 m_jointRows;
+	dgInt32 m_solverPasses;
+};
+
 class dgWorldThreadPool: public dgThreadHive
 {
 	public:
@@ -176,6 +261,9 @@ class dgWorld
 	{
 		m_defaultBroadphase,
 		m_persistentBroadphase,
+		m_linearBroadphase,
+		m_quadBroadphase,
+		m_sweepAndPruneBroadphase,
 	};
 
 	class dgListener
@@ -282,10 +370,14 @@ class dgWorld
 
 	void SetIslandUpdateCallback (OnClusterUpdate callback); 
 
-	void InitBody (dgBody* const body, dgCollisionInstance* const collision, const dgMatrix& matrix);
+	void InitBody (dgBody* const body, dgCollisionInstance* const collision, const dgMatrix& matrix, bool addToBroadPhase = true);
 	dgDynamicBody* CreateDynamicBody (dgCollisionInstance* const collision, const dgMatrix& matrix);
 	dgKinematicBody* CreateKinematicBody (dgCollisionInstance* const collision, const dgMatrix& matrix);
 	void DestroyBody(dgBody* const body);
+
+	void CreateBodies (dgBody::dgType type, dgInt32 count, dgCollisionInstance* const* const collisions, const dgMatrix* const matrices, dgBody** const bodies);
+	void DestroyBodies (dgBody** const bodies, dgInt32 count);
+	void NotifyBodyDestroy (dgBody* const body);
 	void DestroyAllBodies ();
 
 //	void AddToBreakQueue (const dgContact* const contactJoint, dgBody* const body, dgFloat32 maxForce);
@@ -323,12 +415,20 @@ class dgWorld
 	dgCollisionInstance* CreateBVH ();	
 	dgCollisionInstance* CreateStaticUserMesh (const dgVector& boxP0, const dgVector& boxP1, const dgUserMeshCreation& data);
 	dgCollisionInstance* CreateHeightField (dgInt32 width, dgInt32 height, dgInt32 contructionMode, dgInt32 elevationDataType, const void* const elevationMap, const dgInt8* const atributeMap, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z);
+	dgCollisionInstance* CreateTiledHeightField (dgInt32 width, dgInt32 height, dgInt32 tileSize, dgInt32 contructionMode, dgInt32 elevationDataType, dgFloat32 minElevation, dgFloat32 maxElevation, dgFloat32 verticalScale, dgFloat32 horizontalScale_x, dgFloat32 horizontalScale_z, dgInt32 maxResidentTiles);
 	dgCollisionInstance* CreateScene ();	
 
 	dgBroadPhaseAggregate* CreateAggreGate() const; 
 	void DestroyAggregate(dgBroadPhaseAggregate* const aggregate) const; 
 
 	void SetGetTimeInMicrosenconds (OnGetTimeInMicrosenconds callback);
+
+	void SetCollectStats (bool state);
+	bool GetCollectStats () const;
+	void SetPrimitiveContacts (bool state);
+	bool GetPrimitiveContacts () const;
+	const dgWorldStats& GetStats () const;
+	dgWorldStats* GetStatsCollector ();
 	void SetCollisionInstanceConstructorDestructor (OnCollisionInstanceDuplicate constructor, OnCollisionInstanceDestroy destructor);
 
 	static dgInt32 SerializeToFileSort (const dgBody* const body0, const dgBody* const body1, void* const context);
@@ -354,6 +454,8 @@ class dgWorld
 
 	void SerializeCollision (dgCollisionInstance* const shape, dgSerialize deserialization, void* const userData) const;
 	dgCollisionInstance* CreateCollisionFromSerialization (dgDeserialize deserialization, void* const userData);
+	void SerializeCollisionMappedImage (dgCollisionInstance* const shape, dgSerialize serialization, void* const userData) const;
+	dgCollisionInstance* CreateCollisionFromMappedImage (const void* const image, size_t size);
 	void ReleaseCollision(const dgCollision* const collision);
 	
 	dgUpVectorConstraint* CreateUpVectorConstraint (const dgVector& pin, dgBody *body);
@@ -392,6 +494,10 @@ class dgWorld
 
 	dgInt32 GetBroadPhaseType() const;
 	void SetBroadPhaseType (dgInt32 type);
+
+	dgFloat32 GetBroadPhaseRebuildRatio() const;
+	void SetBroadPhaseRebuildRatio(dgFloat32 ratio);
+	void RebuildBroadPhase ();
 	
 	dgFloat32 GetContactMergeTolerance() const;
 	void SetContactMergeTolerance(dgFloat32 tolerenace);
@@ -412,10 +518,36 @@ class dgWorld
 	dgInt32 CalculateUserContacts (dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateConvexToNonConvexContacts (dgCollisionParamProxy& proxy) const;
 	dgInt32 CalculateConvexToConvexContacts (dgCollisionParamProxy& proxy) const;
+
+	typedef bool (dgWorld::*dgPrimitiveContactCallback) (const dgCollisionInstance* const instance0, const dgCollisionInstance* const instance1, dgPrimitiveContact& contact) const;
+	class dgPrimitiveContactKernel
+	{
+		public:
+		dgPrimitiveContactCallback m_callback;
+		dgInt32 m_swapShapes;
+	};
+
+	void InitPrimitiveContacts ();
+	bool CalculatePrimitiveContacts (dgCollisionParamProxy& proxy, dgInt32& count) const;
+	dgInt32 EmitPrimitiveContacts (dgCollisionParamProxy& proxy, const dgPrimitiveContact& contact) const;
+	bool GetPrimitiveSphereRadius (const dgCollisionInstance* const sphere, dgFloat32& radius) const;
+	bool GetPrimitiveBoxSize (const dgCollisionInstance* const box, dgVector& size) const;
+	bool SphereSphereContacts (const dgCollisionInstance* const sphere0, const dgCollisionInstance* const sphere1, dgPrimitiveContact& contact) const;
+	bool SphereCapsuleContacts (const dgCollisionInstance* const sphere, const dgCollisionInstance* const capsule, dgPrimitiveContact& contact) const;
+	bool SphereBoxContacts (const dgCollisionInstance* const sphere, const dgCollisionInstance* const box, dgPrimitiveContact& contact) const;
+	bool CapsuleCapsuleContacts (const dgCollisionInstance* const capsule0, const dgCollisionInstance* const capsule1, dgPrimitiveContact& contact) const;
+	bool BoxBoxContacts (const dgCollisionInstance* const box0, const dgCollisionInstance* const box1, dgPrimitiveContact& contact) const;
+	static void BoxBoxClosestPoints (const dgMatrix& matrix0, const dgVector& size0, const dgMatrix& matrix1, const dgVector& size1, dgInt32 bestAxis, dgFloat32 bestSeparation, const dgVector& bestNormal, dgPrimitiveContact& contact);
+
+	dgInt32 GetPrimitiveBatchKind (const dgContact* const contact) const;
+	void CalculatePrimitiveContactBatch (dgInt32 kind, dgContact* const* const pairs, dgInt32 count, dgPrimitiveContact* const contacts, dgInt32* const valid) const;
+	void CalculatePrimitivePairContacts (dgBroadPhase::dgPair* const pair, const dgPrimitiveContact& contact, dgInt32 threadIndex) const;
 	
 	void PopulateContacts (dgBroadPhase::dgPair* const pair, dgInt32 threadIndex);	
 	void ProcessContacts (dgBroadPhase::dgPair* const pair, dgInt32 threadIndex);
 	void ProcessCachedContacts (dgContact* const contact, dgFloat32 timestep, dgInt32 threadIndex) const;
+	void UpdateTiledHeightFields (dgFloat32 timestep);
+	void RequestTiledHeightFieldTiles (dgBody* const body, dgFloat32 timestep) const;
 
 	void ConvexContacts (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
 	void CompoundContacts (dgBroadPhase::dgPair* const pair, dgCollisionParamProxy& proxy) const;
@@ -464,8 +596,13 @@ class dgWorld
 	dgFloat32 m_frictiomTheshold;
 	dgFloat32 m_savetimestep;
 	dgFloat32 m_contactTolerance;
+	dgFloat32 m_broadPhaseRebuildRatio;
 	dgFloat32 m_lastExecutionTime;
 	dgInt32 m_solverConvergeQuality;
+	dgInt32 m_collectStats;
+	dgInt32 m_primitiveContacts;
+	dgWorldStats m_stats;
+	dgPrimitiveContactKernel m_primitiveContactKernels[m_nullCollision][m_nullCollision];
 
 	dgSolverSleepTherfesholds m_sleepTable[DG_SLEEP_ENTRIES];
 	
@@ -485,11 +622,13 @@ class dgWorld
 
 	dgListenerList m_preListener;
 	dgListenerList m_postListener;
+	dgList<dgCollisionHeightFieldTiled*> m_tiledHeightFields;
 	dgTree<void*, unsigned> m_perInstanceData;
 	dgArray<dgUnsigned8> m_bodiesMemory; 
 	dgArray<dgUnsigned8> m_jointsMemory; 
 	dgArray<dgUnsigned8> m_solverJacobiansMemory;  
 	dgArray<dgUnsigned8> m_solverForceAccumulatorMemory;
+	dgArray<dgUnsigned8> m_solverSoaMemory;
 	dgArray<dgUnsigned8> m_clusterMemory;
 	
 	
@@ -513,6 +652,7 @@ class dgWorld
 	friend class dgCollisionConvexPolygon;
 	friend class dgCollidingPairCollector;
 	friend class dgCollisionDeformableMesh;
+	friend class dgCollisionHeightFieldTiled;
 	friend class dgParallelSolverUpdateForce;
 	friend class dgParallelSolverUpdateVeloc;
 	friend class dgParallelSolverBodyInertia;
@@ -556,4 +696,25 @@ inline dgFloat32 dgWorld::GetUpdateTime() const
 	return m_lastExecutionTime;
 }
 
+inline bool dgWorld::GetCollectStats () const
+{
+	return m_collectStats ? true : false;
+}
+
+inline bool dgWorld::GetPrimitiveContacts () const
+{
+	return m_primitiveContacts ? true : false;
+}
+
+inline const dgWorldStats& dgWorld::GetStats () const
+{
+	return m_stats;
+}
+
+// NULL when stats are disabled, so that every probe cost a single test
+inline dgWorldStats* dgWorld::GetStatsCollector ()
+{
+	return m_collectStats ? &m_stats : NULL;
+}
+
 #endif
\ No newline at end of file
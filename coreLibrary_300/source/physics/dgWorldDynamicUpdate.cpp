@@ -75,6 +75,8 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 {
 	dTimeTrackerEvent(__FUNCTION__);
 	dgWorld* const world = (dgWorld*) this;
+	dgWorldStats* const stats = world->GetStatsCollector();
+	dgWorldStats::dgPhaseTimer timer (stats);
 	
 	UpdateSkeletons();
 	
@@ -102,6 +104,12 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 		softBodiesCount += cluster.m_hasSoftBodies;
 	}
 	m_solverMemory.Init (world, maxRowCount, m_bodies, blockMatrixSize);
+	if (stats) {
+		stats->m_clusters += m_clusters;
+		stats->m_activeBodies += m_bodies - m_clusters;
+		stats->m_jointRows += maxRowCount;
+	}
+	timer.Lap (dgWorldStats::m_buildClusters);
 
 	dgInt32 threadCount = world->GetThreadCount();	
 
@@ -119,15 +127,13 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 	dgInt32 useParallel = world->m_useParallelSolver && (threadCount > 1);
 	//useParallel = 1;
 	if (useParallel) {
-		dgInt32 sum = m_joints;
-		useParallel = useParallel && m_joints && m_clusters;
-		useParallel = useParallel && ((threadCount * m_clusterMemory[0].m_jointCount) >= sum);
-		useParallel = useParallel && (m_clusterMemory[0].m_jointCount > DG_PARALLEL_JOINT_COUNT_CUT_OFF);
+		useParallel = useParallel && m_joints && (index < m_clusters);
+		useParallel = useParallel && ((threadCount * m_clusterMemory[index].m_jointCount) >= m_joints);
+		useParallel = useParallel && (m_clusterMemory[index].m_jointCount > DG_PARALLEL_JOINT_COUNT_CUT_OFF);
 		//useParallel = 1;
 		while (useParallel) {
 			CalculateReactionForcesParallel(&m_clusterMemory[index], timestep);
 			index ++;
-			sum -= m_clusterMemory[index].m_jointCount;
 			useParallel = useParallel && (index < m_clusters);
 			useParallel = useParallel && ((threadCount * m_clusterMemory[index].m_jointCount) >= m_joints);
 			useParallel = useParallel && (m_clusterMemory[index].m_jointCount > DG_PARALLEL_JOINT_COUNT_CUT_OFF);
@@ -155,6 +161,7 @@ void dgWorldDynamicUpdate::UpdateDynamics(dgFloat32 timestep)
 		body->IntegrateOpenLoopExternalForce(timestep);
 		IntegrateVelocity(cluster, DG_SOLVER_MAX_ERROR, timestep, 0);
 	}
+	timer.Lap (dgWorldStats::m_solver);
 
 	m_clusterMemory = NULL;
 }
@@ -34,6 +34,18 @@
 #define	DG_BODY_LRU_STEP				2	
 #define	DG_MAX_SKELETON_JOINT_COUNT		256
 
+// joints are greedily colored with up to DG_PARALLEL_JOINT_COLORS per round, joints that do not get a color
+// are colored again with a fresh palette, whatever is left after the last round goes to the serial overflow batch
+#define	DG_PARALLEL_JOINT_COLORS		30
+#define	DG_PARALLEL_JOINT_COLOR_ROUNDS	4
+#define	DG_PARALLEL_JOINT_OVERFLOW_BATCH	(DG_PARALLEL_JOINT_COLORS * DG_PARALLEL_JOINT_COLOR_ROUNDS)
+#define	DG_MAX_PARALLEL_JOINT_BATCHES	(DG_PARALLEL_JOINT_OVERFLOW_BATCH + 2)
+
+// joints of the same color are packed in blocks this wide and solved by the SIMD kernel, 
+// comment out DG_USE_SOA_JOINT_SOLVER to fall back to the one joint at a time solver
+#define	DG_USE_SOA_JOINT_SOLVER
+#define	DG_SOLVER_SOA_WIDTH				4
+
 #define	DG_FREEZZING_VELOCITY_DRAG		dgFloat32 (0.9f)
 #define	DG_SOLVER_MAX_ERROR				(DG_FREEZE_MAG * dgFloat32 (0.5f))
 
@@ -53,6 +65,9 @@
 
 class dgBody;
 class dgDynamicBody;
+class dgSkeletonContainer;
+class dgSoaJointBlock;
+class dgSoaMatrixElement;
 class dgParallelSolverSyncData;
 class dgWorldDynamicUpdateSyncDescriptor;
 
@@ -113,6 +128,19 @@ class dgParallelSolverSyncData
 		dgInt32 m_color;
 		dgInt32 m_bashCount;
 		dgInt32 m_jointIndex;
+		dgInt32 m_rowCount;
+	};
+
+	class dgParallelSleepInfo
+	{
+		public:
+		dgFloat32 m_maxAccel;
+		dgFloat32 m_maxAlpha;
+		dgFloat32 m_maxSpeed;
+		dgFloat32 m_maxOmega;
+		dgInt32 m_sleepCounter;
+		dgInt32 m_isAutoSleep;
+		dgInt32 m_stackSleeping;
 	};
 
 	dgParallelSolverSyncData()
@@ -121,6 +149,7 @@ class dgParallelSolverSyncData
 	}
 
 	dgFloat32 m_accelNorm[DG_MAX_THREADS_HIVE_COUNT];
+	dgParallelSleepInfo m_sleepInfo[DG_MAX_THREADS_HIVE_COUNT];
 
 	dgFloat32 m_timestep;
 	dgFloat32 m_invTimestep;
@@ -137,14 +166,18 @@ class dgParallelSolverSyncData
 	dgInt32 m_jointCount;
 	dgInt32 m_rowCount;
 	dgInt32 m_atomicIndex;
-	dgInt32 m_lock0;
-	dgInt32 m_lock1;
-	dgInt32 m_jacobianMatrixRowAtomicIndex;
+	dgInt32 m_skeletonCount;
+	dgInt32 m_hasCyclingJoints;
 
-	dgInt32* m_bodyLocks;  
 	const dgBodyCluster* m_cluster;
 	dgParallelJointMap* m_jointConflicts;
-	dgInt32 m_jointBatches[32];
+	dgSkeletonContainer** m_skeletonArray;
+	dgInt32* m_skeletonMemoryOffsets;
+	dgInt8* m_skeletonMemory;
+	dgSoaJointBlock* m_soaBlocks;
+	dgSoaMatrixElement* m_soaRows;
+	dgInt32 m_jointBatches[DG_MAX_PARALLEL_JOINT_BATCHES];
+	dgInt32 m_soaBatches[DG_MAX_PARALLEL_JOINT_BATCHES];
 	dgInt32 m_hasJointFeeback[DG_MAX_THREADS_HIVE_COUNT];
 };
 
@@ -227,6 +260,56 @@ class dgJacobianMatrixElement
 	dgInt32 m_normalForceIndex;
 } DG_GCC_VECTOR_ALIGMENT;
 
+// the rows of DG_SOLVER_SOA_WIDTH independent joints transposed to structure of arrays, 
+// lane k of each vector belongs to the k-th joint of the block 
+class dgSoaVector3
+{
+	public:
+	dgVector m_x;
+	dgVector m_y;
+	dgVector m_z;
+};
+
+class dgSoaJacobian
+{
+	public:
+	dgSoaVector3 m_linear;
+	dgSoaVector3 m_angular;
+};
+
+class dgSoaJacobianPair
+{
+	public:
+	dgSoaJacobian m_jacobianM0;
+	dgSoaJacobian m_jacobianM1;
+};
+
+DG_MSC_VECTOR_ALIGMENT
+class dgSoaMatrixElement
+{
+	public:
+	dgSoaJacobianPair m_Jt;
+	dgSoaJacobianPair m_JMinv;
+	dgVector m_diagDamp;
+	dgVector m_invJMinvJt;
+	dgVector m_lowerBoundFrictionCoefficent;
+	dgVector m_upperBoundFrictionCoefficent;
+	dgInt32 m_normalForceIndex[DG_SOLVER_SOA_WIDTH];
+	dgInt32 m_rowIndex[DG_SOLVER_SOA_WIDTH];
+} DG_GCC_VECTOR_ALIGMENT;
+
+DG_MSC_VECTOR_ALIGMENT
+class dgSoaJointBlock
+{
+	public:
+	dgVector m_scale0;
+	dgVector m_scale1;
+	dgInt32 m_m0[DG_SOLVER_SOA_WIDTH];
+	dgInt32 m_m1[DG_SOLVER_SOA_WIDTH];
+	dgInt32 m_rowStart;
+	dgInt32 m_rowCount;
+} DG_GCC_VECTOR_ALIGMENT;
+
 class dgJacobianMemory
 {
 	public:
@@ -257,8 +340,11 @@ class dgWorldDynamicUpdate
 	static void IntegrateInslandParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void InitializeBodyArrayParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void BuildJacobianMatrixParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
-	static void SolverInitInternalForcesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void InitSkeletonsMassMatrixParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void CalculateJointsForceParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void CalculateJointsForceSoaParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void BuildSoaBlocksParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
+	static void CalculateSkeletonsForceParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void CalculateJointsAccelParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void CalculateJointsVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
 	static void KinematicCallbackUpdateParallelKernel (void* const context, void* const worldContext, dgInt32 threadID); 
@@ -269,10 +355,13 @@ class dgWorldDynamicUpdate
 	void IntegrateClusterParallel(dgParallelSolverSyncData* const syncData) const; 
 	void InitilizeBodyArrayParallel (dgParallelSolverSyncData* const syncData) const; 
 	void BuildJacobianMatrixParallel (dgParallelSolverSyncData* const syncData) const; 
-	void SolverInitInternalForcesParallel (dgParallelSolverSyncData* const syncData) const; 
+	void InitSkeletonsParallel (dgParallelSolverSyncData* const syncData) const; 
 	void CalculateForcesGameModeParallel (dgParallelSolverSyncData* const syncData) const; 
+	void RunJointBatchesParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const; 
+	void RunSoaBatchesParallel (dgParallelSolverSyncData* const syncData) const; 
+	void BuildSoaBlocksParallel (dgParallelSolverSyncData* const syncData) const; 
 
-	void CalculateReactionForcesParallel (const dgBodyCluster* const cluster, dgFloat32 timestep) const;
+	void CalculateReactionForcesParallel (dgBodyCluster* const cluster, dgFloat32 timestep) const;
 	void LinearizeJointParallelArray(dgParallelSolverSyncData* const solverSyncData, dgJointInfo* const constraintArray, const dgBodyCluster* const cluster) const;
 
 	void CalculateNetAcceleration (dgBody* const body, const dgVector& invTimeStep, const dgVector& accNorm) const;
@@ -287,6 +376,7 @@ class dgWorldDynamicUpdate
 	
 	dgFloat32 CalculateJointForceDanzig(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, dgJacobianMatrixElement* const matrixRow, dgFloat32 restAcceleration) const;
 	dgFloat32 CalculateJointForceGaussSeidel(const dgJointInfo* const jointInfo, const dgBodyInfo* const bodyArray, dgJacobian* const internalForces, dgJacobianMatrixElement* const matrixRow, dgFloat32 restAcceleration) const;
+	dgFloat32 CalculateJointForceSoa(const dgSoaJointBlock* const block, const dgSoaMatrixElement* const soaRows, dgJacobian* const internalForces, dgJacobianMatrixElement* const matrixRow, dgFloat32 restAcceleration) const;
 
 	void SortClustersByCount ();
 	void IntegrateExternalForce(const dgBodyCluster* const cluster, dgFloat32 timestep, dgInt32 threadID) const;
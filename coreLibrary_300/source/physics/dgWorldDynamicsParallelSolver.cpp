@@ -25,34 +25,39 @@
 #include "dgWorld.h"
 #include "dgConstraint.h"
 #include "dgDynamicBody.h"
+#include "dgSkeletonContainer.h"
 #include "dgWorldDynamicUpdate.h"
 
+#define DG_PARALLEL_JOINT_BATCH_CUT_OFF		(16)
 
 
-
-
-void dgWorldDynamicUpdate::CalculateReactionForcesParallel(const dgBodyCluster* const cluster, dgFloat32 timestep) const
+void dgWorldDynamicUpdate::CalculateReactionForcesParallel(dgBodyCluster* const cluster, dgFloat32 timestep) const
 {
-	dgAssert(0);
-	/*
-	dgParallelSolverSyncData syncData;
-
+	dTimeTrackerEvent(__FUNCTION__);
 	dgWorld* const world = (dgWorld*) this;
 
-	syncData.m_bodyLocks = dgAlloca (dgInt32, island->m_bodyCount + 1024);
-	syncData.m_jointConflicts = dgAlloca (dgParallelSolverSyncData::dgParallelJointMap, island->m_jointCount + 1024);
-	memset (syncData.m_bodyLocks, 0, island->m_bodyCount * sizeof (dgInt32));
+	if (cluster->m_isContinueCollision || !cluster->m_activeJointCount) {
+		// continue collision clusters are sub stepped, they can only be resolved by the serial solver
+		ResolveClusterForces(cluster, 0, timestep);
+		return;
+	}
 
-	dgInt32 bodyCount = island->m_bodyCount;
-	dgInt32 jointsCount = island->m_jointCount;
-	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
+	SortClusters(cluster, timestep, 0);
 
-	LinearizeJointParallelArray (&syncData, constraintArray, island);
-	
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-	internalForces[0].m_linear = dgVector::m_zero;
-	internalForces[0].m_angular = dgVector::m_zero;
+	dgParallelSolverSyncData syncData;
+	syncData.m_jointConflicts = dgAlloca (dgParallelSolverSyncData::dgParallelJointMap, cluster->m_activeJointCount + 1);
+
+	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	LinearizeJointParallelArray (&syncData, constraintArray, cluster);
+
+	// reserve the rows of each joint up front, so that the jacobians can be built concurrently
+	dgInt32 rowCount = 0;
+	for (dgInt32 i = 0; i < cluster->m_activeJointCount; i ++) {
+		constraintArray[i].m_pairStart = rowCount;
+		rowCount += constraintArray[i].m_pairCount;
+	}
+	dgAssert (rowCount <= cluster->m_rowsCount);
 
 	const dgInt32 maxPasses = 4;
 	syncData.m_timestep = timestep;
@@ -63,24 +68,65 @@ void dgWorldDynamicUpdate::CalculateReactionForcesParallel(const dgBodyCluster*
 	syncData.m_maxPasses = maxPasses;
 	syncData.m_passes = world->m_solverMode;
 
-	syncData.m_bodyCount = bodyCount;
-	syncData.m_jointCount = jointsCount;
+	syncData.m_bodyCount = cluster->m_bodyCount;
+	syncData.m_jointCount = cluster->m_activeJointCount;
+	syncData.m_rowCount = rowCount;
 	syncData.m_atomicIndex = 0;
-	syncData.m_island = island;
+	syncData.m_cluster = cluster;
 
 	InitilizeBodyArrayParallel (&syncData);
 	BuildJacobianMatrixParallel (&syncData);
-	SolverInitInternalForcesParallel (&syncData);
+#ifdef DG_USE_SOA_JOINT_SOLVER
+	BuildSoaBlocksParallel (&syncData);
+#endif
+
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJacobianMatrixElement* const matrixRow = &m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
+
+	dgInt32 skeletonCount = 0;
+	dgInt32 hasCyclingJoints = 0;
+	dgInt32 skeletonMemorySizeInBytes = 0;
+	dgInt32 lru = dgAtomicExchangeAndAdd(&dgSkeletonContainer::m_lruMarker, 1);
+	dgSkeletonContainer* skeletonArray[DG_MAX_SKELETON_JOINT_COUNT];
+	dgInt32 memoryOffsets[DG_MAX_SKELETON_JOINT_COUNT];
+	for (dgInt32 i = 1; i < cluster->m_bodyCount; i++) {
+		dgDynamicBody* const body = (dgDynamicBody*)bodyArray[i].m_body;
+		dgSkeletonContainer* const container = body->GetSkeleton();
+		if (container && (container->m_lru != lru)) {
+			container->m_lru = lru;
+			memoryOffsets[skeletonCount] = skeletonMemorySizeInBytes;
+			skeletonMemorySizeInBytes += container->GetMemoryBufferSizeInBytes(constraintArray, matrixRow);
+			hasCyclingJoints |= container->m_cyclingJoints.GetCount() ? 1 : 0;
+			skeletonArray[skeletonCount] = container;
+			skeletonCount++;
+			dgAssert(skeletonCount < dgInt32(sizeof (skeletonArray) / sizeof (skeletonArray[0])));
+		}
+	}
+
+	dgInt8* const skeletonMemory = (dgInt8*)dgAlloca(dgVector, skeletonMemorySizeInBytes / sizeof (dgVector));
+	dgAssert((dgInt64(skeletonMemory) & 0x0f) == 0);
+
+	syncData.m_skeletonCount = skeletonCount;
+	syncData.m_hasCyclingJoints = hasCyclingJoints;
+	syncData.m_skeletonArray = skeletonArray;
+	syncData.m_skeletonMemoryOffsets = memoryOffsets;
+	syncData.m_skeletonMemory = skeletonMemory;
+
+	InitSkeletonsParallel (&syncData);
 	CalculateForcesGameModeParallel (&syncData);
-	IntegrateIslandParallel(&syncData); 
-*/
+
+	dgWorldStats::dgPhaseTimer timer (world->GetStatsCollector());
+	IntegrateClusterParallel (&syncData); 
+	timer.Lap (dgWorldStats::m_integration);
 }
 
 
 dgInt32 dgWorldDynamicUpdate::SortJointInfoByColor(const dgParallelSolverSyncData::dgParallelJointMap* const indirectIndexA, const dgParallelSolverSyncData::dgParallelJointMap* const indirectIndexB, void* const )
 {
-	dgInt64 keyA = (((dgInt64)indirectIndexA->m_bashCount) << 32) + indirectIndexA->m_color;
-	dgInt64 keyB = (((dgInt64)indirectIndexB->m_bashCount) << 32) + indirectIndexB->m_color;
+	// inside a batch joints are sorted by row count, so that the SoA blocks pack joints of similar size
+	dgInt64 keyA = (((dgInt64)indirectIndexA->m_bashCount) << 32) + indirectIndexA->m_rowCount;
+	dgInt64 keyB = (((dgInt64)indirectIndexB->m_bashCount) << 32) + indirectIndexB->m_rowCount;
 	if (keyA < keyB) {
 		return -1;
 	}
@@ -93,55 +139,80 @@ dgInt32 dgWorldDynamicUpdate::SortJointInfoByColor(const dgParallelSolverSyncDat
 
 void dgWorldDynamicUpdate::LinearizeJointParallelArray(dgParallelSolverSyncData* const solverSyncData, dgJointInfo* const constraintArray, const dgBodyCluster* const cluster) const
 {
+	dTimeTrackerEvent(__FUNCTION__);
 	dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = solverSyncData->m_jointConflicts;
-	dgInt32 count = cluster->m_jointCount;
+	const dgInt32 count = cluster->m_activeJointCount;
 	for (dgInt32 i = 0; i < count; i++) {
 		dgConstraint* const joint = constraintArray[i].m_joint;
 		joint->m_index = i;
 		jointInfoMap[i].m_jointIndex = i;
 		jointInfoMap[i].m_color = 0;
+		jointInfoMap[i].m_bashCount = DG_PARALLEL_JOINT_OVERFLOW_BATCH;
+		jointInfoMap[i].m_rowCount = constraintArray[i].m_pairCount;
 	}
 	jointInfoMap[count].m_color = 0x7fffffff;
 	jointInfoMap[count].m_jointIndex = -1;
-
-	for (dgInt32 i = 0; i < count; i++) {
-		dgInt32 index = 0;
-		dgInt32 color = jointInfoMap[i].m_color;
-		for (dgInt32 n = 1; n & color; n <<= 1) {
-			index++;
-			dgAssert(index < 32);
-		}
-		jointInfoMap[i].m_bashCount = index;
-		color = 1 << index;
-		dgAssert(jointInfoMap[i].m_jointIndex == i);
-		dgJointInfo& jointInfo = constraintArray[i];
-
-		dgConstraint* const constraint = jointInfo.m_joint;
-		dgDynamicBody* const body0 = (dgDynamicBody*)constraint->m_body0;
-		dgAssert(body0->IsRTTIType(dgBody::m_dynamicBodyRTTI));
-
-		if (body0->m_invMass.m_w > dgFloat32(0.0f)) {
-			for (dgBodyMasterListRow::dgListNode* jointNode = body0->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
-				dgBodyMasterListCell& cell = jointNode->GetInfo();
-
-				dgConstraint* const neiborgLink = cell.m_joint;
-				if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF)) {
-					dgParallelSolverSyncData::dgParallelJointMap& info = jointInfoMap[neiborgLink->m_index];
-					info.m_color |= color;
-				}
+	jointInfoMap[count].m_rowCount = 0;
+
+	// a body with more joints than colors leaves some of its joints uncolored, those are colored again
+	// in the next round, since batches run one after another joints of different rounds never conflict.
+	// joints still uncolored after the last round go to the overflow batch, which is solved by a single thread
+	dgInt32 pending = count;
+	for (dgInt32 round = 0; (round < DG_PARALLEL_JOINT_COLOR_ROUNDS) && pending; round ++) {
+		const dgInt32 colorBase = round * DG_PARALLEL_JOINT_COLORS;
+		if (round) {
+			for (dgInt32 i = 0; i < count; i++) {
+				jointInfoMap[i].m_color = 0;
 			}
 		}
 
-		dgDynamicBody* const body1 = (dgDynamicBody*)constraint->m_body1;
-		dgAssert(body1->IsRTTIType(dgBody::m_dynamicBodyRTTI));
-		if (body1->m_invMass.m_w > dgFloat32(0.0f)) {
-			for (dgBodyMasterListRow::dgListNode* jointNode = body1->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
-				dgBodyMasterListCell& cell = jointNode->GetInfo();
+		pending = 0;
+		for (dgInt32 i = 0; i < count; i++) {
+			if (jointInfoMap[i].m_bashCount != DG_PARALLEL_JOINT_OVERFLOW_BATCH) {
+				continue;
+			}
+
+			dgInt32 index = 0;
+			dgInt32 color = jointInfoMap[i].m_color;
+			for (dgInt32 n = 1; (n & color) && (index < DG_PARALLEL_JOINT_COLORS); n <<= 1) {
+				index++;
+			}
+			if (index == DG_PARALLEL_JOINT_COLORS) {
+				pending ++;
+				continue;
+			}
+			jointInfoMap[i].m_bashCount = colorBase + index;
+
+			color = 1 << index;
+			dgAssert(jointInfoMap[i].m_jointIndex == i);
+			dgJointInfo& jointInfo = constraintArray[i];
+
+			dgConstraint* const constraint = jointInfo.m_joint;
+			const dgBody* const body0 = constraint->m_body0;
+			if (body0->m_invMass.m_w > dgFloat32(0.0f)) {
+				for (dgBodyMasterListRow::dgListNode* jointNode = body0->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+					dgBodyMasterListCell& cell = jointNode->GetInfo();
+
+					dgConstraint* const neiborgLink = cell.m_joint;
+					const dgInt32 neiborgIndex = dgInt32 (neiborgLink->m_index);
+					if ((neiborgLink != constraint) && (neiborgIndex < count) && (constraintArray[neiborgIndex].m_joint == neiborgLink)) {
+						dgParallelSolverSyncData::dgParallelJointMap& info = jointInfoMap[neiborgIndex];
+						info.m_color |= color;
+					}
+				}
+			}
 
-				dgConstraint* const neiborgLink = cell.m_joint;
-				if ((neiborgLink != constraint) && (neiborgLink->m_maxDOF)) {
-					dgParallelSolverSyncData::dgParallelJointMap& info = jointInfoMap[neiborgLink->m_index];
-					info.m_color |= color;
+			const dgBody* const body1 = constraint->m_body1;
+			if (body1->m_invMass.m_w > dgFloat32(0.0f)) {
+				for (dgBodyMasterListRow::dgListNode* jointNode = body1->m_masterNode->GetInfo().GetFirst(); jointNode; jointNode = jointNode->GetNext()) {
+					dgBodyMasterListCell& cell = jointNode->GetInfo();
+
+					dgConstraint* const neiborgLink = cell.m_joint;
+					const dgInt32 neiborgIndex = dgInt32 (neiborgLink->m_index);
+					if ((neiborgLink != constraint) && (neiborgIndex < count) && (constraintArray[neiborgIndex].m_joint == neiborgLink)) {
+						dgParallelSolverSyncData::dgParallelJointMap& info = jointInfoMap[neiborgIndex];
+						info.m_color |= color;
+					}
 				}
 			}
 		}
@@ -152,7 +223,8 @@ void dgWorldDynamicUpdate::LinearizeJointParallelArray(dgParallelSolverSyncData*
 	dgInt32 acc = 0;
 	dgInt32 bash = 0;
 	dgInt32 bachCount = 0;
-	for (int i = 0; i < count; i++) {
+	solverSyncData->m_jointBatches[0] = 0;
+	for (dgInt32 i = 0; i < count; i++) {
 		if (jointInfoMap[i].m_bashCount > bash) {
 			bash = jointInfoMap[i].m_bashCount;
 			solverSyncData->m_jointBatches[bachCount + 1] = acc;
@@ -164,353 +236,699 @@ void dgWorldDynamicUpdate::LinearizeJointParallelArray(dgParallelSolverSyncData*
 	bachCount++;
 	solverSyncData->m_bachCount = bachCount;
 	solverSyncData->m_jointBatches[bachCount] = acc;
-	dgAssert(bachCount < (dgInt32(sizeof (solverSyncData->m_jointBatches) / sizeof (solverSyncData->m_jointBatches[0])) - 1));
+	dgAssert(bachCount < (dgInt32(sizeof (solverSyncData->m_jointBatches) / sizeof (solverSyncData->m_jointBatches[0]))));
+}
+
+
+void dgWorldDynamicUpdate::RunJointBatchesParallel (dgParallelSolverSyncData* const syncData, dgWorkerThreadTaskCallback kernel) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+	const dgInt32 batchCount = syncData->m_bachCount;
+	const dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
+
+	// joints in the same batch do not share any dynamics body, so each batch can be solved concurrently
+	for (dgInt32 i = 0; i < batchCount; i ++) {
+		const dgInt32 start = syncData->m_jointBatches[i];
+		const dgInt32 end = syncData->m_jointBatches[i + 1];
+		syncData->m_atomicIndex = start;
+		syncData->m_bachIndex = end;
+		const bool isOverflowBatch = (jointInfoMap[start].m_bashCount == DG_PARALLEL_JOINT_OVERFLOW_BATCH);
+		if (isOverflowBatch || ((end - start) < (threadCounts * DG_PARALLEL_JOINT_BATCH_CUT_OFF))) {
+			kernel (syncData, world, 0);
+		} else {
+			for (dgInt32 j = 0; j < threadCounts; j ++) {
+				world->QueueJob (kernel, syncData, world);
+			}
+			world->SynchronizationBarrier();
+		}
+	}
 }
 
 
 void dgWorldDynamicUpdate::InitilizeBodyArrayParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgAssert (0);
-	/*
 	dgWorld* const world = (dgWorld*) this;
 	const dgInt32 threadCounts = world->GetThreadCount();	
 
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-	internalForces[0].m_linear = dgVector(dgFloat32(0.0f));
-	internalForces[0].m_angular = dgVector(dgFloat32(0.0f));
+	dgJacobian* const internalForces = &m_solverMemory.m_internalForcesBuffer[syncData->m_cluster->m_bodyStart];
+	internalForces[0].m_linear = dgVector::m_zero;
+	internalForces[0].m_angular = dgVector::m_zero;
 
 	syncData->m_atomicIndex = 1;
 	for (dgInt32 i = 0; i < threadCounts; i ++) {
 		world->QueueJob (InitializeBodyArrayParallelKernel, syncData, world);
 	}
 	world->SynchronizationBarrier();
-*/
 }
 
+
 void dgWorldDynamicUpdate::InitializeBodyArrayParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
+	dTimeTrackerEvent(__FUNCTION__);
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
 
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
 
 	if (syncData->m_timestep != dgFloat32 (0.0f)) {
 		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgAssert (bodyArray[0].m_body->IsRTTIType (dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_accel.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_accel)) == dgFloat32 (0.0f));
-			dgAssert (bodyArray[0].m_body->IsRTTIType (dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_alpha.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_alpha)) == dgFloat32 (0.0f));
-
-			dgBody* const body = bodyArray[i].m_body;
-			dgAssert (body->m_index == i);
+			dgDynamicBody* const body = (dgDynamicBody*)bodyArray[i].m_body;
+			dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
 			if (!body->m_equilibrium) {
 				dgAssert (body->m_invMass.m_w > dgFloat32 (0.0f));
 				body->AddDampingAcceleration(syncData->m_timestep);
 				body->CalcInvInertiaMatrix ();
-			}
-
-			if (body->m_active) {
-				// re use these variables for temp storage 
-				body->m_netForce = body->m_veloc;
-				body->m_netTorque = body->m_omega;
+				internalForces[i].m_linear = dgVector::m_zero;
+				internalForces[i].m_angular = dgVector::m_zero;
+			} else if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+				internalForces[i].m_linear = body->m_externalForce.CompProduct4(dgVector::m_negOne);
+				internalForces[i].m_angular = body->m_externalTorque.CompProduct4(dgVector::m_negOne);
+			} else {
 				internalForces[i].m_linear = dgVector::m_zero;
 				internalForces[i].m_angular = dgVector::m_zero;
 			}
+
+			// re use these variables for temp storage 
+			body->m_accel = body->m_veloc;
+			body->m_alpha = body->m_omega;
 		}
 	} else {
 		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgAssert(bodyArray[0].m_body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_accel.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_accel)) == dgFloat32(0.0f));
-			dgAssert(bodyArray[0].m_body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || (((dgDynamicBody*)bodyArray[0].m_body)->m_alpha.DotProduct3(((dgDynamicBody*)bodyArray[0].m_body)->m_alpha)) == dgFloat32(0.0f));
-
 			dgBody* const body = bodyArray[i].m_body;
+			dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
 			if (!body->m_equilibrium) {
-				dgAssert(body->m_invMass.m_w > dgFloat32(0.0f));
-				body->CalcInvInertiaMatrix();
+				dgAssert (body->m_invMass.m_w > dgFloat32 (0.0f));
+				body->CalcInvInertiaMatrix ();
 			}
 
-			if (body->m_active) {
-				 //re use these variables for temp storage 
-				body->m_netForce = body->m_veloc;
-				body->m_netTorque = body->m_omega;
-				internalForces[i].m_linear = dgVector::m_zero;
-				internalForces[i].m_angular = dgVector::m_zero;
-			}
+			// re use these variables for temp storage 
+			body->m_accel = body->m_veloc;
+			body->m_alpha = body->m_omega;
+
+			internalForces[i].m_linear = dgVector::m_zero;
+			internalForces[i].m_angular = dgVector::m_zero;
 		}
 	}
-*/
 }
 
 
 void dgWorldDynamicUpdate::BuildJacobianMatrixParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgWorld* const world = (dgWorld*) this;
-	const dgInt32 threadCounts = world->GetThreadCount();	
-
-	syncData->m_atomicIndex = 0;
-	for (dgInt32 i = 0; i < threadCounts; i ++) {
-		world->QueueJob (BuildJacobianMatrixParallelKernel, syncData, world);
-	}
-	world->SynchronizationBarrier();
+	RunJointBatchesParallel (syncData, BuildJacobianMatrixParallelKernel);
 }
 
 
 void dgWorldDynamicUpdate::BuildJacobianMatrixParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
+	dTimeTrackerEvent(__FUNCTION__);
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
-	const dgIsland* const island = syncData->m_island;
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
-	dgAssert (syncData->m_jointCount);
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
+	const dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
 
 	dgContraintDescritor constraintParams;
 	constraintParams.m_world = world;
 	constraintParams.m_threadIndex = threadID;
 	constraintParams.m_timestep = syncData->m_timestep;
-	constraintParams.m_invTimestep = syncData->m_invTimestep;
+	constraintParams.m_invTimestep = (syncData->m_timestep > dgFloat32(1.0e-5f)) ? dgFloat32(1.0f / syncData->m_timestep) : dgFloat32(0.0f);
+	const dgFloat32 forceOrImpulseScale = (syncData->m_timestep > dgFloat32 (0.0f)) ? dgFloat32 (1.0f) : dgFloat32 (0.0f);
 
-	dgFloat32 forceOrImpulseScale = (syncData->m_timestep > dgFloat32 (0.0f)) ? dgFloat32 (1.0f) : dgFloat32 (0.0f);
-	for (dgInt32 jointIndex = dgAtomicExchangeAndAdd(atomicIndex, 1); jointIndex < syncData->m_jointCount;  jointIndex = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgJointInfo* const jointInfo = &constraintArray[jointIndex];
+	const dgInt32 batchEnd = syncData->m_bachIndex;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < batchEnd; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgJointInfo* const jointInfo = &constraintArray[jointInfoMap[i].m_jointIndex];
 		dgConstraint* const constraint = jointInfo->m_joint;
+		dgAssert (dgInt32 (constraint->m_index) == jointInfoMap[i].m_jointIndex);
 
-		dgInt32 rowBase = dgAtomicExchangeAndAdd(&syncData->m_jacobianMatrixRowAtomicIndex, jointInfo->m_pairCount);
-
-		world->GetJacobianDerivatives(constraintParams, jointInfo, constraint, matrixRow, rowBase);
-
+		world->GetJacobianDerivatives(constraintParams, jointInfo, constraint, matrixRow, jointInfo->m_pairStart);
 		dgAssert (jointInfo->m_m0 >= 0);
 		dgAssert (jointInfo->m_m1 >= 0);
-		dgAssert (jointInfo->m_m0 != jointInfo->m_m1);
-		dgAssert (jointInfo->m_m0 < island->m_bodyCount);
-		dgAssert (jointInfo->m_m1 < island->m_bodyCount);
-		world->BuildJacobianMatrix (bodyArray, jointInfo, matrixRow, forceOrImpulseScale);
+		dgAssert (jointInfo->m_m0 < cluster->m_bodyCount);
+		dgAssert (jointInfo->m_m1 < cluster->m_bodyCount);
+		world->BuildJacobianMatrix (bodyArray, jointInfo, internalForces, matrixRow, forceOrImpulseScale);
 	}
-*/
 }
 
 
-void dgWorldDynamicUpdate::SolverInitInternalForcesParallel (dgParallelSolverSyncData* const syncData) const
+void dgWorldDynamicUpdate::InitSkeletonsParallel (dgParallelSolverSyncData* const syncData) const
 {
-	dgWorld* const world = (dgWorld*) this;
-	const dgInt32 threadCounts = world->GetThreadCount();	
+	if (syncData->m_skeletonCount) {
+		dgWorld* const world = (dgWorld*) this;
+		const dgInt32 threadCounts = world->GetThreadCount();	
 
-	syncData->m_atomicIndex = 0;
-	for (dgInt32 i = 0; i < threadCounts; i ++) {
-		world->QueueJob (SolverInitInternalForcesParallelKernel, syncData, world);
+		syncData->m_atomicIndex = 0;
+		for (dgInt32 i = 0; i < threadCounts; i ++) {
+			world->QueueJob (InitSkeletonsMassMatrixParallelKernel, syncData, world);
+		}
+		world->SynchronizationBarrier();
 	}
-	world->SynchronizationBarrier();
 }
 
 
-void dgWorldDynamicUpdate::SolverInitInternalForcesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+void dgWorldDynamicUpdate::InitSkeletonsMassMatrixParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgIsland* const island = syncData->m_island;
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgInt32* const bodyLocks = syncData->m_bodyLocks;
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 
-	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgJointInfo* const jointInfo = &constraintArray[i];
-		if (jointInfo->m_joint->m_solverActive) {
-			dgJacobian y0;
-			dgJacobian y1;
-			world->InitJointForce (jointInfo, matrixRow, y0, y1);
-			const dgInt32 m0 = jointInfo->m_m0;
-			const dgInt32 m1 = jointInfo->m_m1;
-			dgAssert (m0 != m1);
-
-			if (m0) {
-				dgSpinLock(&bodyLocks[m0], false);
-				internalForces[m0].m_linear += y0.m_linear;
-				internalForces[m0].m_angular += y0.m_angular;
-				dgSpinUnlock(&bodyLocks[m0]);
-			}
-			if (m1) {
-				dgSpinLock(&bodyLocks[m1], false);
-				internalForces[m1].m_linear += y1.m_linear;
-				internalForces[m1].m_angular += y1.m_angular;
-				dgSpinUnlock(&bodyLocks[m1]);
-			}
-		}
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_skeletonCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgSkeletonContainer* const skeleton = syncData->m_skeletonArray[i];
+		skeleton->InitMassMatrix(constraintArray, matrixRow, &syncData->m_skeletonMemory[syncData->m_skeletonMemoryOffsets[i]]);
 	}
-*/
 }
 
 
 void dgWorldDynamicUpdate::CalculateJointsAccelParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
+	dTimeTrackerEvent(__FUNCTION__);
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgIsland* const island = syncData->m_island;
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 
 	dgJointAccelerationDecriptor joindDesc;
 	joindDesc.m_timeStep = syncData->m_timestepRK;
 	joindDesc.m_invTimeStep = syncData->m_invTimestepRK;
 	joindDesc.m_firstPassCoefFlag = syncData->m_firstPassCoef;
 
-	dgInt32* const atomicIndex = &syncData->m_atomicIndex; 
-	if (joindDesc.m_firstPassCoefFlag == dgFloat32 (0.0f)) {
-		for (dgInt32 curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1); curJoint < syncData->m_jointCount;  curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgJointInfo* const jointInfo = &constraintArray[curJoint];
-			dgConstraint* const constraint = jointInfo->m_joint;
-			if (constraint->m_solverActive) {
-				joindDesc.m_rowsCount = jointInfo->m_pairCount;
-				joindDesc.m_rowMatrix = &matrixRow[jointInfo->m_pairStart];
-				constraint->JointAccelerations(&joindDesc);
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgJointInfo* const jointInfo = &constraintArray[i];
+		dgConstraint* const constraint = jointInfo->m_joint;
+		joindDesc.m_rowsCount = jointInfo->m_pairCount;
+		joindDesc.m_rowMatrix = &matrixRow[jointInfo->m_pairStart];
+		constraint->JointAccelerations(&joindDesc);
+	}
+}
+
+
+void dgWorldDynamicUpdate::CalculateJointsForceParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	const dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
+	const dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
+
+	dgFloat32 accNorm = dgFloat32(0.0f);
+	const dgInt32 batchEnd = syncData->m_bachIndex;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < batchEnd; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgJointInfo* const jointInfo = &constraintArray[jointInfoMap[i].m_jointIndex];
+		if (!jointInfo->m_isSkeleton) {
+			dgFloat32 accel = world->CalculateJointForceGaussSeidel(jointInfo, bodyArray, internalForces, matrixRow, DG_SOLVER_MAX_ERROR);
+			accNorm = (accel > accNorm) ? accel : accNorm;
+		}
+	}
+
+	// the same thread can execute more than one job, so the norm has to be accumulated
+	syncData->m_accelNorm[threadID] = dgMax (syncData->m_accelNorm[threadID], accNorm);
+}
+
+
+void dgWorldDynamicUpdate::BuildSoaBlocksParallel (dgParallelSolverSyncData* const syncData) const
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
+	const dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	const dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
+	const dgInt32 batchCount = syncData->m_bachCount;
+
+	// first pass counts the blocks and the rows of each block, which is the row count of its largest joint
+	dgInt32 blockCount = 0;
+	dgInt32 soaRowCount = 0;
+	for (dgInt32 i = 0; i < batchCount; i ++) {
+		const dgInt32 start = syncData->m_jointBatches[i];
+		const dgInt32 end = syncData->m_jointBatches[i + 1];
+		if (jointInfoMap[start].m_bashCount == DG_PARALLEL_JOINT_OVERFLOW_BATCH) {
+			continue;
+		}
+		dgInt32 lane = 0;
+		dgInt32 maxRows = 0;
+		for (dgInt32 j = start; j < end; j ++) {
+			const dgJointInfo* const jointInfo = &constraintArray[jointInfoMap[j].m_jointIndex];
+			if (!jointInfo->m_isSkeleton) {
+				maxRows = dgMax (maxRows, jointInfo->m_pairCount);
+				lane ++;
+				if (lane == DG_SOLVER_SOA_WIDTH) {
+					blockCount ++;
+					soaRowCount += maxRows;
+					lane = 0;
+					maxRows = 0;
+				}
 			}
 		}
-	} else {
-		const dgIsland* const island = syncData->m_island;
-		dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-		const dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-
-		for (dgInt32 curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1); curJoint < syncData->m_jointCount;  curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgJointInfo* const jointInfo = &constraintArray[curJoint];
-			dgConstraint* const constraint = jointInfo->m_joint;
-			if (constraint->m_solverActive) {
-				const dgInt32 m0 = jointInfo->m_m0;
-				const dgInt32 m1 = jointInfo->m_m1;
-				const dgBody* const body0 = bodyArray[m0].m_body;
-				const dgBody* const body1 = bodyArray[m1].m_body;
-				if (!(body0->m_resting & body1->m_resting)) {
-					joindDesc.m_rowsCount = jointInfo->m_pairCount;
-					joindDesc.m_rowMatrix = &matrixRow[jointInfo->m_pairStart];
-					constraint->JointAccelerations(&joindDesc);
+		if (lane) {
+			blockCount ++;
+			soaRowCount += maxRows;
+		}
+	}
+
+	world->m_solverSoaMemory.ResizeIfNecessary (blockCount * sizeof (dgSoaJointBlock) + soaRowCount * sizeof (dgSoaMatrixElement) + 64);
+	dgSoaJointBlock* const blocks = (dgSoaJointBlock*) &world->m_solverSoaMemory[0];
+	dgSoaMatrixElement* const soaRows = (dgSoaMatrixElement*) &blocks[blockCount];
+	dgAssert ((dgUnsigned64(blocks) & 0x0f) == 0);
+	syncData->m_soaBlocks = blocks;
+	syncData->m_soaRows = soaRows;
+
+	// second pass assigns the joints to the lanes, padding lanes point to the sentinel body and have no rows
+	blockCount = 0;
+	soaRowCount = 0;
+	for (dgInt32 i = 0; i < batchCount; i ++) {
+		const dgInt32 start = syncData->m_jointBatches[i];
+		const dgInt32 end = syncData->m_jointBatches[i + 1];
+		syncData->m_soaBatches[i] = blockCount;
+		if (jointInfoMap[start].m_bashCount == DG_PARALLEL_JOINT_OVERFLOW_BATCH) {
+			continue;
+		}
+
+		dgInt32 j = start;
+		while (j < end) {
+			const dgJointInfo* laneJoints[DG_SOLVER_SOA_WIDTH];
+			dgInt32 lanes = 0;
+			for (; (j < end) && (lanes < DG_SOLVER_SOA_WIDTH); j ++) {
+				const dgJointInfo* const jointInfo = &constraintArray[jointInfoMap[j].m_jointIndex];
+				if (!jointInfo->m_isSkeleton) {
+					laneJoints[lanes] = jointInfo;
+					lanes ++;
 				}
 			}
+			if (!lanes) {
+				break;
+			}
+
+			dgSoaJointBlock& block = blocks[blockCount];
+			dgFloat32 scale0[DG_SOLVER_SOA_WIDTH];
+			dgFloat32 scale1[DG_SOLVER_SOA_WIDTH];
+			dgInt32 maxRows = 0;
+			for (dgInt32 k = 0; k < DG_SOLVER_SOA_WIDTH; k ++) {
+				if (k < lanes) {
+					block.m_m0[k] = laneJoints[k]->m_m0;
+					block.m_m1[k] = laneJoints[k]->m_m1;
+					scale0[k] = laneJoints[k]->m_scale0;
+					scale1[k] = laneJoints[k]->m_scale1;
+					maxRows = dgMax (maxRows, laneJoints[k]->m_pairCount);
+				} else {
+					block.m_m0[k] = 0;
+					block.m_m1[k] = 0;
+					scale0[k] = dgFloat32 (0.0f);
+					scale1[k] = dgFloat32 (0.0f);
+				}
+			}
+			block.m_scale0 = dgVector (scale0[0], scale0[1], scale0[2], scale0[3]);
+			block.m_scale1 = dgVector (scale1[0], scale1[1], scale1[2], scale1[3]);
+			block.m_rowStart = soaRowCount;
+			block.m_rowCount = maxRows;
+
+			for (dgInt32 r = 0; r < maxRows; r ++) {
+				dgSoaMatrixElement& soaRow = soaRows[soaRowCount + r];
+				for (dgInt32 k = 0; k < DG_SOLVER_SOA_WIDTH; k ++) {
+					if ((k < lanes) && (r < laneJoints[k]->m_pairCount)) {
+						soaRow.m_rowIndex[k] = laneJoints[k]->m_pairStart + r;
+					} else {
+						soaRow.m_rowIndex[k] = -1;
+					}
+				}
+			}
+
+			soaRowCount += maxRows;
+			blockCount ++;
 		}
 	}
-*/
+	syncData->m_soaBatches[batchCount] = blockCount;
+
+	syncData->m_atomicIndex = 0;
+	syncData->m_bachIndex = blockCount;
+	for (dgInt32 i = 0; i < threadCounts; i ++) {
+		world->QueueJob (BuildSoaBlocksParallelKernel, syncData, world);
+	}
+	world->SynchronizationBarrier();
 }
 
 
-void dgWorldDynamicUpdate::CalculateJointsVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+void dgWorldDynamicUpdate::BuildSoaBlocksParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-dgAssert (0);
-/*
+	dTimeTrackerEvent(__FUNCTION__);
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 
-	const dgIsland* const island = syncData->m_island;
-	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	const dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
+	const dgSoaJointBlock* const blocks = syncData->m_soaBlocks;
+
+	dgJacobianMatrixElement zeroRow;
+	memset (&zeroRow, 0, sizeof (zeroRow));
+	zeroRow.m_normalForceIndex = -1;
+
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bachIndex; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgSoaJointBlock& block = blocks[i];
+		for (dgInt32 r = 0; r < block.m_rowCount; r ++) {
+			dgSoaMatrixElement& soaRow = syncData->m_soaRows[block.m_rowStart + r];
 
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
+			const dgJacobianMatrixElement* rows[DG_SOLVER_SOA_WIDTH];
+			for (dgInt32 k = 0; k < DG_SOLVER_SOA_WIDTH; k ++) {
+				rows[k] = (soaRow.m_rowIndex[k] >= 0) ? &matrixRow[soaRow.m_rowIndex[k]] : &zeroRow;
+				soaRow.m_normalForceIndex[k] = rows[k]->m_normalForceIndex;
+			}
+
+			dgVector tmp;
+			dgVector::Transpose4x4 (soaRow.m_Jt.m_jacobianM0.m_linear.m_x, soaRow.m_Jt.m_jacobianM0.m_linear.m_y, soaRow.m_Jt.m_jacobianM0.m_linear.m_z, tmp, 
+									rows[0]->m_Jt.m_jacobianM0.m_linear, rows[1]->m_Jt.m_jacobianM0.m_linear, rows[2]->m_Jt.m_jacobianM0.m_linear, rows[3]->m_Jt.m_jacobianM0.m_linear);
+			dgVector::Transpose4x4 (soaRow.m_Jt.m_jacobianM0.m_angular.m_x, soaRow.m_Jt.m_jacobianM0.m_angular.m_y, soaRow.m_Jt.m_jacobianM0.m_angular.m_z, tmp, 
+									rows[0]->m_Jt.m_jacobianM0.m_angular, rows[1]->m_Jt.m_jacobianM0.m_angular, rows[2]->m_Jt.m_jacobianM0.m_angular, rows[3]->m_Jt.m_jacobianM0.m_angular);
+			dgVector::Transpose4x4 (soaRow.m_Jt.m_jacobianM1.m_linear.m_x, soaRow.m_Jt.m_jacobianM1.m_linear.m_y, soaRow.m_Jt.m_jacobianM1.m_linear.m_z, tmp, 
+									rows[0]->m_Jt.m_jacobianM1.m_linear, rows[1]->m_Jt.m_jacobianM1.m_linear, rows[2]->m_Jt.m_jacobianM1.m_linear, rows[3]->m_Jt.m_jacobianM1.m_linear);
+			dgVector::Transpose4x4 (soaRow.m_Jt.m_jacobianM1.m_angular.m_x, soaRow.m_Jt.m_jacobianM1.m_angular.m_y, soaRow.m_Jt.m_jacobianM1.m_angular.m_z, tmp, 
+									rows[0]->m_Jt.m_jacobianM1.m_angular, rows[1]->m_Jt.m_jacobianM1.m_angular, rows[2]->m_Jt.m_jacobianM1.m_angular, rows[3]->m_Jt.m_jacobianM1.m_angular);
+
+			dgVector::Transpose4x4 (soaRow.m_JMinv.m_jacobianM0.m_linear.m_x, soaRow.m_JMinv.m_jacobianM0.m_linear.m_y, soaRow.m_JMinv.m_jacobianM0.m_linear.m_z, tmp, 
+									rows[0]->m_JMinv.m_jacobianM0.m_linear, rows[1]->m_JMinv.m_jacobianM0.m_linear, rows[2]->m_JMinv.m_jacobianM0.m_linear, rows[3]->m_JMinv.m_jacobianM0.m_linear);
+			dgVector::Transpose4x4 (soaRow.m_JMinv.m_jacobianM0.m_angular.m_x, soaRow.m_JMinv.m_jacobianM0.m_angular.m_y, soaRow.m_JMinv.m_jacobianM0.m_angular.m_z, tmp, 
+									rows[0]->m_JMinv.m_jacobianM0.m_angular, rows[1]->m_JMinv.m_jacobianM0.m_angular, rows[2]->m_JMinv.m_jacobianM0.m_angular, rows[3]->m_JMinv.m_jacobianM0.m_angular);
+			dgVector::Transpose4x4 (soaRow.m_JMinv.m_jacobianM1.m_linear.m_x, soaRow.m_JMinv.m_jacobianM1.m_linear.m_y, soaRow.m_JMinv.m_jacobianM1.m_linear.m_z, tmp, 
+									rows[0]->m_JMinv.m_jacobianM1.m_linear, rows[1]->m_JMinv.m_jacobianM1.m_linear, rows[2]->m_JMinv.m_jacobianM1.m_linear, rows[3]->m_JMinv.m_jacobianM1.m_linear);
+			dgVector::Transpose4x4 (soaRow.m_JMinv.m_jacobianM1.m_angular.m_x, soaRow.m_JMinv.m_jacobianM1.m_angular.m_y, soaRow.m_JMinv.m_jacobianM1.m_angular.m_z, tmp, 
+									rows[0]->m_JMinv.m_jacobianM1.m_angular, rows[1]->m_JMinv.m_jacobianM1.m_angular, rows[2]->m_JMinv.m_jacobianM1.m_angular, rows[3]->m_JMinv.m_jacobianM1.m_angular);
+
+			soaRow.m_diagDamp = dgVector (rows[0]->m_diagDamp, rows[1]->m_diagDamp, rows[2]->m_diagDamp, rows[3]->m_diagDamp);
+			soaRow.m_invJMinvJt = dgVector (rows[0]->m_invJMinvJt, rows[1]->m_invJMinvJt, rows[2]->m_invJMinvJt, rows[3]->m_invJMinvJt);
+			soaRow.m_lowerBoundFrictionCoefficent = dgVector (rows[0]->m_lowerBoundFrictionCoefficent, rows[1]->m_lowerBoundFrictionCoefficent, rows[2]->m_lowerBoundFrictionCoefficent, rows[3]->m_lowerBoundFrictionCoefficent);
+			soaRow.m_upperBoundFrictionCoefficent = dgVector (rows[0]->m_upperBoundFrictionCoefficent, rows[1]->m_upperBoundFrictionCoefficent, rows[2]->m_upperBoundFrictionCoefficent, rows[3]->m_upperBoundFrictionCoefficent);
+		}
+	}
+}
+
+
+void dgWorldDynamicUpdate::RunSoaBatchesParallel (dgParallelSolverSyncData* const syncData) const
+{
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+	const dgInt32 batchCount = syncData->m_bachCount;
+	const dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
+
+	for (dgInt32 i = 0; i < batchCount; i ++) {
+		const dgInt32 start = syncData->m_jointBatches[i];
+		if (jointInfoMap[start].m_bashCount == DG_PARALLEL_JOINT_OVERFLOW_BATCH) {
+			// joints in the overflow batch share bodies, they can not be packed and are solved one at a time
+			syncData->m_atomicIndex = start;
+			syncData->m_bachIndex = syncData->m_jointBatches[i + 1];
+			CalculateJointsForceParallelKernel (syncData, world, 0);
+		} else {
+			const dgInt32 blockStart = syncData->m_soaBatches[i];
+			const dgInt32 blockEnd = syncData->m_soaBatches[i + 1];
+			syncData->m_atomicIndex = blockStart;
+			syncData->m_bachIndex = blockEnd;
+			if (((blockEnd - blockStart) * DG_SOLVER_SOA_WIDTH) < (threadCounts * DG_PARALLEL_JOINT_BATCH_CUT_OFF)) {
+				CalculateJointsForceSoaParallelKernel (syncData, world, 0);
+			} else {
+				for (dgInt32 j = 0; j < threadCounts; j ++) {
+					world->QueueJob (CalculateJointsForceSoaParallelKernel, syncData, world);
+				}
+				world->SynchronizationBarrier();
+			}
+		}
+	}
+}
 
-	dgVector speedFreeze2 (world->m_freezeSpeed2 * dgFloat32 (0.1f));
-	dgVector freezeOmega2 (world->m_freezeOmega2 * dgFloat32 (0.1f));
-	dgVector forceActiveMask ((syncData->m_jointCount <= DG_SMALL_ISLAND_COUNT) ?  dgVector (-1, -1, -1, -1) : dgFloat32 (0.0f));
+
+void dgWorldDynamicUpdate::CalculateJointsForceSoaParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 
-	if (syncData->m_timestepRK != dgFloat32 (0.0f)) {
-		dgVector timestep4 (syncData->m_timestepRK);
-		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
-			dgAssert (body->m_index == i);
-			world->ApplyNetVelcAndOmega (body, internalForces[i], timestep4, speedFreeze2, forceActiveMask);
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
+
+	dgFloat32 accNorm = dgFloat32(0.0f);
+	const dgInt32 batchEnd = syncData->m_bachIndex;
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < batchEnd; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		const dgSoaJointBlock* const block = &syncData->m_soaBlocks[i];
+		dgFloat32 accel = world->CalculateJointForceSoa(block, &syncData->m_soaRows[block->m_rowStart], internalForces, matrixRow, DG_SOLVER_MAX_ERROR);
+		accNorm = (accel > accNorm) ? accel : accNorm;
+	}
+	syncData->m_accelNorm[threadID] = dgMax (syncData->m_accelNorm[threadID], accNorm);
+}
+
+
+// same iteration as CalculateJointForceGaussSeidel, but each lane solves a different joint. 
+// A lane stops updating its forces as soon as its joint meets the exit condition of the scalar solver.
+dgFloat32 dgWorldDynamicUpdate::CalculateJointForceSoa(const dgSoaJointBlock* const block, const dgSoaMatrixElement* const soaRows, dgJacobian* const internalForces, dgJacobianMatrixElement* const matrixRow, dgFloat32 restAcceleration) const
+{
+	dgVector force[DG_CONSTRAINT_MAX_ROWS];
+	dgVector coordenateAccel[DG_CONSTRAINT_MAX_ROWS];
+	dgVector cacheForce[DG_CONSTRAINT_MAX_ROWS + 4];
+
+	const dgInt32* const m0 = block->m_m0;
+	const dgInt32* const m1 = block->m_m1;
+	const dgInt32 rowsCount = block->m_rowCount;
+	dgAssert (rowsCount <= DG_CONSTRAINT_MAX_ROWS);
+
+	dgSoaVector3 linearM0;
+	dgSoaVector3 angularM0;
+	dgSoaVector3 linearM1;
+	dgSoaVector3 angularM1;
+	dgVector tmp;
+	dgVector::Transpose4x4 (linearM0.m_x, linearM0.m_y, linearM0.m_z, tmp, internalForces[m0[0]].m_linear, internalForces[m0[1]].m_linear, internalForces[m0[2]].m_linear, internalForces[m0[3]].m_linear);
+	dgVector::Transpose4x4 (angularM0.m_x, angularM0.m_y, angularM0.m_z, tmp, internalForces[m0[0]].m_angular, internalForces[m0[1]].m_angular, internalForces[m0[2]].m_angular, internalForces[m0[3]].m_angular);
+	dgVector::Transpose4x4 (linearM1.m_x, linearM1.m_y, linearM1.m_z, tmp, internalForces[m1[0]].m_linear, internalForces[m1[1]].m_linear, internalForces[m1[2]].m_linear, internalForces[m1[3]].m_linear);
+	dgVector::Transpose4x4 (angularM1.m_x, angularM1.m_y, angularM1.m_z, tmp, internalForces[m1[0]].m_angular, internalForces[m1[1]].m_angular, internalForces[m1[2]].m_angular, internalForces[m1[3]].m_angular);
+
+	cacheForce[0] = dgVector::m_one;
+	cacheForce[1] = dgVector::m_one;
+	cacheForce[2] = dgVector::m_one;
+	cacheForce[3] = dgVector::m_one;
+	dgVector* const normalForce = &cacheForce[4];
+	for (dgInt32 i = 0; i < rowsCount; i ++) {
+		const dgSoaMatrixElement* const row = &soaRows[i];
+		dgFloat32 f[DG_SOLVER_SOA_WIDTH];
+		dgFloat32 a[DG_SOLVER_SOA_WIDTH];
+		for (dgInt32 k = 0; k < DG_SOLVER_SOA_WIDTH; k ++) {
+			const dgInt32 index = row->m_rowIndex[k];
+			f[k] = (index >= 0) ? matrixRow[index].m_force : dgFloat32 (0.0f);
+			a[k] = (index >= 0) ? matrixRow[index].m_coordenateAccel : dgFloat32 (0.0f);
 		}
-	} else {
-		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-			dgBody* const body = bodyArray[i].m_body;
-			if (body->m_active) {
-				const dgVector& linearMomentum = internalForces[i].m_linear;
-				const dgVector& angularMomentum = internalForces[i].m_angular;
+		force[i] = dgVector (f[0], f[1], f[2], f[3]);
+		coordenateAccel[i] = dgVector (a[0], a[1], a[2], a[3]);
+		normalForce[i] = force[i];
+	}
+
+	const dgVector scale0 (block->m_scale0);
+	const dgVector scale1 (block->m_scale1);
+	const dgVector restAccel (restAcceleration);
+	const dgVector tolerance (dgFloat32(1.0e-2f));
+
+	dgVector accNorm (dgVector::m_zero);
+	dgVector maxAccel (dgFloat32 (1.0e10f));
+	dgVector prevError (dgFloat32 (1.0e20f));
+	dgVector firstPass (dgVector::m_one);
+	dgVector active (maxAccel > restAccel);
+	for (dgInt32 j = 0; j < 5; j ++) {
+		active = active & (maxAccel > restAccel) & ((prevError - maxAccel) > tolerance);
+		if (!active.GetSignMask()) {
+			break;
+		}
+		prevError = maxAccel;
+		maxAccel = dgVector::m_zero;
+		for (dgInt32 i = 0; i < rowsCount; i ++) {
+			const dgSoaMatrixElement* const row = &soaRows[i];
+
+			dgVector diag (row->m_JMinv.m_jacobianM0.m_linear.m_x.CompProduct4(linearM0.m_x) + row->m_JMinv.m_jacobianM0.m_linear.m_y.CompProduct4(linearM0.m_y) + row->m_JMinv.m_jacobianM0.m_linear.m_z.CompProduct4(linearM0.m_z));
+			diag += row->m_JMinv.m_jacobianM0.m_angular.m_x.CompProduct4(angularM0.m_x) + row->m_JMinv.m_jacobianM0.m_angular.m_y.CompProduct4(angularM0.m_y) + row->m_JMinv.m_jacobianM0.m_angular.m_z.CompProduct4(angularM0.m_z);
+			diag += row->m_JMinv.m_jacobianM1.m_linear.m_x.CompProduct4(linearM1.m_x) + row->m_JMinv.m_jacobianM1.m_linear.m_y.CompProduct4(linearM1.m_y) + row->m_JMinv.m_jacobianM1.m_linear.m_z.CompProduct4(linearM1.m_z);
+			diag += row->m_JMinv.m_jacobianM1.m_angular.m_x.CompProduct4(angularM1.m_x) + row->m_JMinv.m_jacobianM1.m_angular.m_y.CompProduct4(angularM1.m_y) + row->m_JMinv.m_jacobianM1.m_angular.m_z.CompProduct4(angularM1.m_z);
+
+			dgVector accel (coordenateAccel[i] - force[i].CompProduct4(row->m_diagDamp) - diag);
+			dgVector rowForce (force[i] + row->m_invJMinvJt.CompProduct4(accel));
+
+			const dgInt32* const frictionIndex = row->m_normalForceIndex;
+			const dgVector frictionNormal (normalForce[frictionIndex[0]][0], normalForce[frictionIndex[1]][1], normalForce[frictionIndex[2]][2], normalForce[frictionIndex[3]][3]);
+			const dgVector lowerFrictionForce (frictionNormal.CompProduct4(row->m_lowerBoundFrictionCoefficent));
+			const dgVector upperFrictionForce (frictionNormal.CompProduct4(row->m_upperBoundFrictionCoefficent));
+
+			accel = accel.AndNot((rowForce > upperFrictionForce) | (rowForce < lowerFrictionForce)) & active;
+			rowForce = (rowForce.GetMax(lowerFrictionForce).GetMin(upperFrictionForce) & active) | force[i].AndNot(active);
+
+			dgVector accelAbs (accel.Abs());
+			maxAccel = maxAccel.GetMax(accelAbs);
+			accNorm = accNorm.GetMax(accelAbs.CompProduct4(firstPass));
+
+			dgVector deltaForce (rowForce - force[i]);
+			force[i] = rowForce;
+			normalForce[i] = rowForce;
+
+			dgVector deltaforce0 (scale0.CompProduct4(deltaForce));
+			dgVector deltaforce1 (scale1.CompProduct4(deltaForce));
+			linearM0.m_x += row->m_Jt.m_jacobianM0.m_linear.m_x.CompProduct4(deltaforce0);
+			linearM0.m_y += row->m_Jt.m_jacobianM0.m_linear.m_y.CompProduct4(deltaforce0);
+			linearM0.m_z += row->m_Jt.m_jacobianM0.m_linear.m_z.CompProduct4(deltaforce0);
+			angularM0.m_x += row->m_Jt.m_jacobianM0.m_angular.m_x.CompProduct4(deltaforce0);
+			angularM0.m_y += row->m_Jt.m_jacobianM0.m_angular.m_y.CompProduct4(deltaforce0);
+			angularM0.m_z += row->m_Jt.m_jacobianM0.m_angular.m_z.CompProduct4(deltaforce0);
+			linearM1.m_x += row->m_Jt.m_jacobianM1.m_linear.m_x.CompProduct4(deltaforce1);
+			linearM1.m_y += row->m_Jt.m_jacobianM1.m_linear.m_y.CompProduct4(deltaforce1);
+			linearM1.m_z += row->m_Jt.m_jacobianM1.m_linear.m_z.CompProduct4(deltaforce1);
+			angularM1.m_x += row->m_Jt.m_jacobianM1.m_angular.m_x.CompProduct4(deltaforce1);
+			angularM1.m_y += row->m_Jt.m_jacobianM1.m_angular.m_y.CompProduct4(deltaforce1);
+			angularM1.m_z += row->m_Jt.m_jacobianM1.m_angular.m_z.CompProduct4(deltaforce1);
+		}
+		firstPass = dgVector::m_zero;
+	}
 
-				body->m_veloc += linearMomentum.Scale4(body->m_invMass.m_w);
-				body->m_omega += body->m_invWorldInertiaMatrix.RotateVector(angularMomentum);
+	for (dgInt32 i = 0; i < rowsCount; i ++) {
+		const dgSoaMatrixElement* const row = &soaRows[i];
+		for (dgInt32 k = 0; k < DG_SOLVER_SOA_WIDTH; k ++) {
+			const dgInt32 index = row->m_rowIndex[k];
+			if (index >= 0) {
+				dgJacobianMatrixElement* const aosRow = &matrixRow[index];
+				aosRow->m_force = force[i][k];
+				aosRow->m_maxImpact = dgMax (dgAbsf (aosRow->m_force), aosRow->m_maxImpact);
 			}
 		}
 	}
-*/
+
+	// padding lanes and lanes attached to a static body point to entry zero, those lanes are masked out of the store
+	dgVector linear[DG_SOLVER_SOA_WIDTH];
+	dgVector angular[DG_SOLVER_SOA_WIDTH];
+	dgVector::Transpose4x4 (linear[0], linear[1], linear[2], linear[3], linearM0.m_x, linearM0.m_y, linearM0.m_z, dgVector::m_zero);
+	dgVector::Transpose4x4 (angular[0], angular[1], angular[2], angular[3], angularM0.m_x, angularM0.m_y, angularM0.m_z, dgVector::m_zero);
+	for (dgInt32 k = 0; k < DG_SOLVER_SOA_WIDTH; k ++) {
+		if (m0[k]) {
+			internalForces[m0[k]].m_linear = linear[k];
+			internalForces[m0[k]].m_angular = angular[k];
+		}
+	}
+	dgVector::Transpose4x4 (linear[0], linear[1], linear[2], linear[3], linearM1.m_x, linearM1.m_y, linearM1.m_z, dgVector::m_zero);
+	dgVector::Transpose4x4 (angular[0], angular[1], angular[2], angular[3], angularM1.m_x, angularM1.m_y, angularM1.m_z, dgVector::m_zero);
+	for (dgInt32 k = 0; k < DG_SOLVER_SOA_WIDTH; k ++) {
+		if (m1[k]) {
+			internalForces[m1[k]].m_linear = linear[k];
+			internalForces[m1[k]].m_angular = angular[k];
+		}
+	}
+
+	return dgMax (dgMax (accNorm[0], accNorm[1]), dgMax (accNorm[2], accNorm[3]));
 }
 
-/*
-void dgWorldDynamicUpdate::CalculateJointsImpulseVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+
+void dgWorldDynamicUpdate::CalculateSkeletonsForceParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
+	dTimeTrackerEvent(__FUNCTION__);
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 
-	const dgIsland* const island = syncData->m_island;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+	const dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForces[0];
-	//dgJacobian* const internalVeloc = &world->m_solverMemory.m_internalVeloc[0];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_skeletonCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		syncData->m_skeletonArray[i]->CalculateJointForce(constraintArray, bodyArray, internalForces, matrixRow);
+	}
+}
 
+
+void dgWorldDynamicUpdate::CalculateJointsVelocParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
+	dgWorld* const world = (dgWorld*) worldContext;
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
-	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgInt32 index = i + 1;
-		dgAssert (index);
-		dgDynamicBody* const body = (dgDynamicBody*) bodyArray[index].m_body;
-		dgAssert (body->m_index == index);
 
-		const dgVector& linearMomentum = internalForces[index].m_linear;
-		const dgVector& angularMomentum = internalForces[index].m_angular;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[cluster->m_bodyStart];
 
-		body->m_veloc += linearMomentum.Scale4(body->m_invMass.m_w);
-		body->m_omega += body->m_invWorldInertiaMatrix.RotateVector (angularMomentum);
+	if (syncData->m_timestepRK != dgFloat32 (0.0f)) {
+		const dgVector timestep4 (syncData->m_timestepRK);
+		const dgVector speedFreeze2 (world->m_freezeSpeed2 * dgFloat32 (0.1f));
+		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+			dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
+			dgAssert (body->m_index == i);
+			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+				world->ApplyForceAndTorque (body, internalForces[i], timestep4, speedFreeze2);
+			}
+		}
+	} else {
+		for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+			dgBody* const body = bodyArray[i].m_body;
+			const dgVector& linearMomentum = internalForces[i].m_linear;
+			const dgVector& angularMomentum = internalForces[i].m_angular;
 
-		//internalVeloc[index].m_linear += body->m_veloc;
-		//internalVeloc[index].m_angular += body->m_omega;
+			body->m_veloc += linearMomentum.Scale4(body->m_invMass.m_w);
+			body->m_omega += body->m_invWorldInertiaMatrix.RotateVector(angularMomentum);
+		}
 	}
 }
-*/
+
 
 void dgWorldDynamicUpdate::UpdateFeedbackForcesParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-dgAssert (0);
-/*
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgIsland* const island = syncData->m_island;
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
+	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[cluster->m_rowsStart];
 
 	dgInt32 hasJointFeeback = 0;
-	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
-	
-	for (dgInt32 curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1); curJoint < syncData->m_jointCount;  curJoint = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgJointInfo* const jointInfo = &constraintArray[curJoint];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgJointInfo* const jointInfo = &constraintArray[i];
 		dgConstraint* const constraint = jointInfo->m_joint;
-		if (constraint->m_solverActive) {
-			const dgInt32 first = jointInfo->m_pairStart;
-			const dgInt32 count = jointInfo->m_pairCount;
-
-			for (dgInt32 j = 0; j < count; j++) {
-				dgJacobianMatrixElement* const row = &matrixRow[j + first];
-				dgFloat32 val = row->m_force;
-				dgAssert(dgCheckFloat(val));
-				row->m_jointFeebackForce[0].m_force = val;
-				row->m_jointFeebackForce[0].m_impact = row->m_maxImpact * syncData->m_timestepRK;
-			}
-			hasJointFeeback |= (constraint->m_updaFeedbackCallback ? 1 : 0);
+		const dgInt32 first = jointInfo->m_pairStart;
+		const dgInt32 count = jointInfo->m_pairCount;
+
+		for (dgInt32 j = 0; j < count; j++) {
+			dgJacobianMatrixElement* const row = &matrixRow[j + first];
+			dgFloat32 val = row->m_force;
+			dgAssert(dgCheckFloat(val));
+			row->m_jointFeebackForce[0].m_force = val;
+			row->m_jointFeebackForce[0].m_impact = row->m_maxImpact * syncData->m_timestepRK;
 		}
+		hasJointFeeback |= (constraint->m_updaFeedbackCallback ? 1 : 0);
 	}
-	syncData->m_hasJointFeeback[threadID] = hasJointFeeback;
-*/
+	syncData->m_hasJointFeeback[threadID] |= hasJointFeeback;
 }
 
 
@@ -519,19 +937,15 @@ void dgWorldDynamicUpdate::UpdateBodyVelocityParallelKernel (void* const context
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
 
-	const dgBodyCluster* const island = syncData->m_cluster;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-
-	dgFloat32 maxAccNorm2 = DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR;
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 
-	//dgFloat32 invTimestepSrc = dgFloat32 (1.0f) / syncData->m_timestep;
-	dgFloat32 invTimestepSrc = syncData->m_invTimestep;
-
-	dgVector invTime (invTimestepSrc);
+	const dgVector invTime (syncData->m_invTimestep);
+	const dgVector maxAccNorm2 (DG_SOLVER_MAX_ERROR * DG_SOLVER_MAX_ERROR);
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
+		dgBody* const body = bodyArray[i].m_body;
 		world->CalculateNetAcceleration (body, invTime, maxAccNorm2);
 	}
 }
@@ -541,9 +955,9 @@ void dgWorldDynamicUpdate::KinematicCallbackUpdateParallelKernel (void* const co
 {
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
-	const dgBodyCluster* const island = syncData->m_cluster;
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
+	dgJointInfo* const constraintArray = &constraintArrayPtr[cluster->m_jointStart];
 
 	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_jointCount;  i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
@@ -555,28 +969,18 @@ void dgWorldDynamicUpdate::KinematicCallbackUpdateParallelKernel (void* const co
 }
 
 
-void dgWorldDynamicUpdate::IntegrateClusterParallel(dgParallelSolverSyncData* const syncData) const
-{
-	dgWorld* const world = (dgWorld*) this;
-//	dgWorldDynamicUpdate::IntegrateIslandParallelKernel (syncData, world, 0);
-	world->IntegrateVelocity (syncData->m_cluster, DG_SOLVER_MAX_ERROR, syncData->m_timestep, 0); 
-}
-
-
 void dgWorldDynamicUpdate::CalculateForcesGameModeParallel (dgParallelSolverSyncData* const syncData) const
 {
-dgAssert (0);
-/*
+	dTimeTrackerEvent(__FUNCTION__);
 	dgWorld* const world = (dgWorld*) this;
 	const dgInt32 threadCounts = world->GetThreadCount();	
 
 	const dgInt32 passes = syncData->m_passes;
 	const dgInt32 maxPasses = syncData->m_maxPasses;
-//	const dgInt32 batchCount = syncData->m_bachCount;
 	syncData->m_firstPassCoef = dgFloat32 (0.0f);
+	dgInt32 passCount = 0;
 
 	for (dgInt32 step = 0; step < maxPasses; step++) {
-
 		syncData->m_atomicIndex = 0;
 		for (dgInt32 i = 0; i < threadCounts; i++) {
 			world->QueueJob(CalculateJointsAccelParallelKernel, syncData, world);
@@ -586,56 +990,53 @@ dgAssert (0);
 
 		dgFloat32 accNorm = DG_SOLVER_MAX_ERROR * dgFloat32(2.0f);
 		for (dgInt32 k = 0; (k < passes) && (accNorm > DG_SOLVER_MAX_ERROR); k++) {
-
-#if 0
-			dgInt32 batchIndex = 0;
-			dgInt32 count = syncData->m_jointBatches[batchIndex + 1];
-			while ((batchIndex < batchCount) && (count >= threadCounts * 8)) {
-				syncData->m_bachIndex = syncData->m_jointBatches[batchIndex + 1];
-				syncData->m_atomicIndex = syncData->m_jointBatches[batchIndex];
-				for (dgInt32 i = 0; i < threadCounts; i++) {
-					world->QueueJob(CalculateJointsForceParallelKernel, syncData, world);
-				}
-				world->SynchronizationBarrier();
-				accNorm = dgFloat32(0.0f);
-				for (dgInt32 i = 0; i < threadCounts; i++) {
-					accNorm = dgMax(accNorm, syncData->m_accelNorm[i]);
-				}
-
-				batchIndex++;
-				count = syncData->m_jointBatches[batchIndex + 1] - syncData->m_jointBatches[batchIndex];
-			}
-
-			if (batchIndex < batchCount) {
-				syncData->m_bachIndex = syncData->m_jointBatches[batchCount];
-				syncData->m_atomicIndex = syncData->m_jointBatches[batchIndex];
-				CalculateJointsForceParallelKernel(syncData, world, 0);
-				accNorm = dgMax(accNorm, syncData->m_accelNorm[0]);
+			passCount ++;
+			for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i++) {
+				syncData->m_accelNorm[i] = dgFloat32(0.0f);
 			}
+#ifdef DG_USE_SOA_JOINT_SOLVER
+			RunSoaBatchesParallel (syncData);
+#else
+			RunJointBatchesParallel (syncData, CalculateJointsForceParallelKernel);
 #endif
 
-			syncData->m_atomicIndex = 0;
-			for (dgInt32 i = 0; i < threadCounts; i++) {
-				world->QueueJob(CalculateJointsForceParallelKernel, syncData, world);
+			if (syncData->m_skeletonCount) {
+				syncData->m_atomicIndex = 0;
+				if (syncData->m_hasCyclingJoints) {
+					// cycling joints can link bodies of different skeletons 
+					CalculateSkeletonsForceParallelKernel (syncData, world, 0);
+				} else {
+					for (dgInt32 i = 0; i < threadCounts; i++) {
+						world->QueueJob(CalculateSkeletonsForceParallelKernel, syncData, world);
+					}
+					world->SynchronizationBarrier();
+				}
 			}
-			world->SynchronizationBarrier();
+
 			accNorm = dgFloat32(0.0f);
-			for (dgInt32 i = 0; i < threadCounts; i++) {
+			for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i++) {
 				accNorm = dgMax(accNorm, syncData->m_accelNorm[i]);
 			}
 		}
 
-
 		syncData->m_atomicIndex = 1;
-		for (dgInt32 j = 0; j < threadCounts; j++) {
+		for (dgInt32 i = 0; i < threadCounts; i++) {
 			world->QueueJob(CalculateJointsVelocParallelKernel, syncData, world);
 		}
 		world->SynchronizationBarrier();
 	}
 
+	dgWorldStats* const stats = world->GetStatsCollector();
+	if (stats) {
+		stats->m_solverPasses += passCount;
+	}
+
 	if (syncData->m_timestepRK != dgFloat32 (0.0f)) {
+		for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+			syncData->m_hasJointFeeback[i] = 0;
+		}
 		syncData->m_atomicIndex = 0;
-		for (dgInt32 j = 0; j < threadCounts; j ++) {
+		for (dgInt32 i = 0; i < threadCounts; i ++) {
 			world->QueueJob (UpdateFeedbackForcesParallelKernel, syncData, world);
 		}
 		world->SynchronizationBarrier();
@@ -646,89 +1047,192 @@ dgAssert (0);
 		}
 
 		syncData->m_atomicIndex = 1;
-		for (dgInt32 j = 0; j < threadCounts; j++) {
+		for (dgInt32 i = 0; i < threadCounts; i++) {
 			world->QueueJob(UpdateBodyVelocityParallelKernel, syncData, world);
 		}
 		world->SynchronizationBarrier();
 
 		if (hasJointFeeback) {
 			syncData->m_atomicIndex = 0;
-			for (dgInt32 j = 0; j < threadCounts; j++) {
+			for (dgInt32 i = 0; i < threadCounts; i++) {
 				world->QueueJob(KinematicCallbackUpdateParallelKernel, syncData, world);
 			}
 			world->SynchronizationBarrier();
 		}
-
 	} else {
 		const dgInt32 count = syncData->m_bodyCount;
-		const dgIsland* const island = syncData->m_island;
+		const dgBodyCluster* const cluster = syncData->m_cluster;
 		dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*)&world->m_bodiesMemory[0];
-		dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
+		dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
 		for (dgInt32 i = 1; i < count; i++) {
 			dgBody* const body = bodyArray[i].m_body;
-			if (body->m_active) {
-				body->m_netForce = dgVector::m_zero;
-				body->m_netTorque = dgVector::m_zero;
-			}
+			body->m_accel = dgVector::m_zero;
+			body->m_alpha = dgVector::m_zero;
 		}
 	}
-*/
 }
 
 
-void dgWorldDynamicUpdate::CalculateJointsForceParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
+void dgWorldDynamicUpdate::IntegrateInslandParallelKernel (void* const context, void* const worldContext, dgInt32 threadID)
 {
-	dgAssert (0);
-/*
+	dTimeTrackerEvent(__FUNCTION__);
 	dgParallelSolverSyncData* const syncData = (dgParallelSolverSyncData*) context;
 	dgWorld* const world = (dgWorld*) worldContext;
+	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
 
-	const dgIsland* const island = syncData->m_island;
-	dgJacobianMatrixElement* const matrixRow = &world->m_solverMemory.m_jacobianBuffer[0];
+	const dgBodyCluster* const cluster = syncData->m_cluster;
 	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
-	const dgBodyInfo* const bodyArray = &bodyArrayPtr[island->m_bodyStart];
-	dgJointInfo* const constraintArrayPtr = (dgJointInfo*) &world->m_jointsMemory[0];
-	dgJointInfo* const constraintArray = &constraintArrayPtr[island->m_jointStart];
-	dgJacobian* const internalForces = &world->m_solverMemory.m_internalForcesBuffer[0];
-//	const int jointCount = syncData->m_bachIndex;
-	const int jointCount = syncData->m_jointCount;
-
-	dgInt32* const bodyLocks = syncData->m_bodyLocks;
-	dgParallelSolverSyncData::dgParallelJointMap* const jointInfoMap = syncData->m_jointConflicts;
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	const dgFloat32 timestep = syncData->m_timestep;
 
-	dgInt32* const atomicIndex = &syncData->m_atomicIndex;
-	dgFloat32 accNorm = dgFloat32(0.0f);
-	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < jointCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
-		dgInt32 index = jointInfoMap[i].m_jointIndex;
-		dgJointInfo* const jointInfo = &constraintArray[index];
+	dgAssert (cluster->m_jointCount);
+	const dgFloat32 velocityDragCoeff = DG_FREEZZING_VELOCITY_DRAG;
+	const dgFloat32 speedFreeze = world->m_freezeSpeed2 * dgFloat32(0.01f);
+	const dgFloat32 accelFreeze = world->m_freezeAccel2 * dgFloat32(0.01f);
+	const dgVector velocDragVect (velocityDragCoeff, velocityDragCoeff, velocityDragCoeff, dgFloat32 (0.0f));
 
-		const dgInt32 m0 = jointInfo->m_m0;
-		const dgInt32 m1 = jointInfo->m_m1;
-		dgAssert(m0 != m1);
+	dgParallelSolverSyncData::dgParallelSleepInfo& info = syncData->m_sleepInfo[threadID];
+	for (dgInt32 i = dgAtomicExchangeAndAdd(atomicIndex, 1); i < syncData->m_bodyCount; i = dgAtomicExchangeAndAdd(atomicIndex, 1)) {
+		dgBody* const body = bodyArray[i].m_body;
+		dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBody));
+
+		dgVector isMovingMask (body->m_veloc + body->m_omega + body->m_accel + body->m_alpha);
+		dgAssert (dgCheckVector(isMovingMask));
+		if (!body->m_equilibrium || ((isMovingMask.TestZero().GetSignMask() & 7) != 7)) {
+			dgAssert (body->m_invMass.m_w);
+			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+				body->IntegrateVelocity(timestep);
+			}
 
-		dgSpinLock(&syncData->m_lock0, false);
-			if (m0) {
-				dgSpinLock(&bodyLocks[m0], false);
+			dgFloat32 accel2 = body->m_accel.DotProduct4(body->m_accel).GetScalar();
+			dgFloat32 alpha2 = body->m_alpha.DotProduct4(body->m_alpha).GetScalar();
+			dgFloat32 speed2 = body->m_veloc.DotProduct4(body->m_veloc).GetScalar();
+			dgFloat32 omega2 = body->m_omega.DotProduct4(body->m_omega).GetScalar();
+
+			info.m_maxAccel = dgMax (info.m_maxAccel, accel2);
+			info.m_maxAlpha = dgMax (info.m_maxAlpha, alpha2);
+			info.m_maxSpeed = dgMax (info.m_maxSpeed, speed2);
+			info.m_maxOmega = dgMax (info.m_maxOmega, omega2);
+
+			bool equilibrium = (accel2 < accelFreeze) && (alpha2 < accelFreeze) && (speed2 < speedFreeze) && (omega2 < speedFreeze);
+			if (equilibrium) {
+				dgVector veloc (body->m_veloc.CompProduct4(velocDragVect));
+				dgVector omega = body->m_omega.CompProduct4 (velocDragVect);
+				body->m_veloc = (dgVector (veloc.CompProduct4(veloc)) > m_velocTol) & veloc;
+				body->m_omega = (dgVector (omega.CompProduct4(omega)) > m_velocTol) & omega;
 			}
-			if (m1) {
-				dgSpinLock(&bodyLocks[m1], false);
+
+			body->m_equilibrium = dgUnsigned32 (equilibrium);
+			info.m_stackSleeping &= equilibrium ? 1 : 0;
+			info.m_isAutoSleep &= body->m_autoSleep ? 1 : 0;
+			if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+				info.m_sleepCounter = dgMin (info.m_sleepCounter, ((dgDynamicBody*)body)->m_sleepingCounter);
 			}
-		dgSpinUnlock(&syncData->m_lock0);
 
-		dgFloat32 accel = world->CalculateJointForce(jointInfo, bodyArray, internalForces, matrixRow);
+			body->UpdateMatrix (timestep, threadID);
+		}
+	}
+}
 
-		dgSpinLock(&syncData->m_lock1, false);
-			if (m0) {
-				dgSpinUnlock(&bodyLocks[m0]);
-			}
-			if (m1) {
-				dgSpinUnlock(&bodyLocks[m1]);
-			}
-		dgSpinUnlock(&syncData->m_lock1);
 
-		accNorm = (accel > accNorm) ? accel : accNorm;
+void dgWorldDynamicUpdate::IntegrateClusterParallel(dgParallelSolverSyncData* const syncData) const
+{
+	dTimeTrackerEvent(__FUNCTION__);
+	dgWorld* const world = (dgWorld*) this;
+	const dgInt32 threadCounts = world->GetThreadCount();	
+
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		dgParallelSolverSyncData::dgParallelSleepInfo& info = syncData->m_sleepInfo[i];
+		info.m_maxAccel = dgFloat32 (0.0f);
+		info.m_maxAlpha = dgFloat32 (0.0f);
+		info.m_maxSpeed = dgFloat32 (0.0f);
+		info.m_maxOmega = dgFloat32 (0.0f);
+		info.m_sleepCounter = 10000;
+		info.m_isAutoSleep = 1;
+		info.m_stackSleeping = 1;
 	}
 
-	syncData->m_accelNorm[threadID] = accNorm;
-*/
+	syncData->m_atomicIndex = 1;
+	for (dgInt32 i = 0; i < threadCounts; i ++) {
+		world->QueueJob (IntegrateInslandParallelKernel, syncData, world);
+	}
+	world->SynchronizationBarrier();
+
+	dgFloat32 maxAccel = dgFloat32 (0.0f);
+	dgFloat32 maxAlpha = dgFloat32 (0.0f);
+	dgFloat32 maxSpeed = dgFloat32 (0.0f);
+	dgFloat32 maxOmega = dgFloat32 (0.0f);
+	dgInt32 sleepCounter = 10000;
+	bool isAutoSleep = true;
+	bool stackSleeping = true;
+	for (dgInt32 i = 0; i < DG_MAX_THREADS_HIVE_COUNT; i ++) {
+		const dgParallelSolverSyncData::dgParallelSleepInfo& info = syncData->m_sleepInfo[i];
+		maxAccel = dgMax (maxAccel, info.m_maxAccel);
+		maxAlpha = dgMax (maxAlpha, info.m_maxAlpha);
+		maxSpeed = dgMax (maxSpeed, info.m_maxSpeed);
+		maxOmega = dgMax (maxOmega, info.m_maxOmega);
+		sleepCounter = dgMin (sleepCounter, info.m_sleepCounter);
+		isAutoSleep &= info.m_isAutoSleep ? true : false;
+		stackSleeping &= info.m_stackSleeping ? true : false;
+	}
+
+	const dgBodyCluster* const cluster = syncData->m_cluster;
+	dgBodyInfo* const bodyArrayPtr = (dgBodyInfo*) &world->m_bodiesMemory[0]; 
+	dgBodyInfo* const bodyArray = &bodyArrayPtr[cluster->m_bodyStart];
+	const dgInt32 count = cluster->m_bodyCount;
+	if (isAutoSleep) {
+		if (stackSleeping) {
+			for (dgInt32 i = 1; i < count; i ++) {
+				dgBody* const body = bodyArray[i].m_body;
+				dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
+				body->m_accel = dgVector::m_zero;
+				body->m_alpha = dgVector::m_zero;
+				body->m_veloc = dgVector::m_zero;
+				body->m_omega = dgVector::m_zero;
+			}
+		} else {
+			const bool state = (maxAccel > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxAccel) || (maxAlpha > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxAlpha) ||
+							   (maxSpeed > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxVeloc) || (maxOmega > world->m_sleepTable[DG_SLEEP_ENTRIES - 1].m_maxOmega);
+			if (state) { 
+				for (dgInt32 i = 1; i < count; i ++) {
+					dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
+					if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+						body->m_sleepingCounter = 0;
+					}
+				}
+			} else {
+				dgInt32 index = 0;
+				for (dgInt32 i = 0; i < DG_SLEEP_ENTRIES; i ++) {
+					if ((maxAccel <= world->m_sleepTable[i].m_maxAccel) &&
+						(maxAlpha <= world->m_sleepTable[i].m_maxAlpha) &&
+						(maxSpeed <= world->m_sleepTable[i].m_maxVeloc) &&
+						(maxOmega <= world->m_sleepTable[i].m_maxOmega)) {
+							index = i;
+							break;
+					}
+				}
+
+				dgInt32 timeScaleSleepCount = dgInt32 (dgFloat32 (60.0f) * sleepCounter * syncData->m_timestep);
+				if (timeScaleSleepCount > world->m_sleepTable[index].m_steps) {
+					for (dgInt32 i = 1; i < count; i ++) {
+						dgBody* const body = bodyArray[i].m_body;
+						dgAssert(body->IsRTTIType(dgBody::m_dynamicBodyRTTI) || body->IsRTTIType(dgBody::m_kinematicBodyRTTI));
+						body->m_accel = dgVector::m_zero;
+						body->m_alpha = dgVector::m_zero;
+						body->m_veloc = dgVector::m_zero;
+						body->m_omega = dgVector::m_zero;
+						body->m_equilibrium = true;
+					}
+				} else {
+					sleepCounter ++;
+					for (dgInt32 i = 1; i < count; i ++) {
+						dgDynamicBody* const body = (dgDynamicBody*) bodyArray[i].m_body;
+						if (body->IsRTTIType(dgBody::m_dynamicBodyRTTI)) {
+							body->m_sleepingCounter = sleepCounter;
+						}
+					}
+				}
+			}
+		}
+	}
 }
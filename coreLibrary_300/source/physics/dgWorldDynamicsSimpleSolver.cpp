@@ -40,6 +40,7 @@ void dgWorldDynamicUpdate::ResolveClusterForces(dgBodyCluster* const cluster, dg
 	}
 
 	if (!cluster->m_isContinueCollision) {
+		dgWorldStats::dgPhaseTimer timer (((dgWorld*) this)->GetStatsCollector());
 		if (cluster->m_activeJointCount) {
 			BuildJacobianMatrix (cluster, threadID, timestep);
 			if (graphDepth < 5) {
@@ -47,11 +48,12 @@ void dgWorldDynamicUpdate::ResolveClusterForces(dgBodyCluster* const cluster, dg
 			} else {
 				CalculateClusterReactionForces(cluster, threadID, timestep, DG_SOLVER_MAX_ERROR);
 			}
-			
+			timer.Reset ();
 		} else {
 			IntegrateExternalForce(cluster, timestep, threadID);
 		}
 		IntegrateVelocity (cluster, DG_SOLVER_MAX_ERROR, timestep, threadID); 
+		timer.Lap (dgWorldStats::m_integration);
 	} else {
 		// calculate reaction forces and new velocities
 		BuildJacobianMatrix (cluster, threadID, timestep);
@@ -679,10 +681,15 @@ dgFloat32 dgWorldDynamicUpdate::CalculateJointForceGaussSeidel(const dgJointInfo
 		row->m_maxImpact = dgMax (dgAbsf (row->m_force), row->m_maxImpact);
 	}
 
-	internalForces[m0].m_linear = linearM0;
-	internalForces[m0].m_angular = angularM0;
-	internalForces[m1].m_linear = linearM1;
-	internalForces[m1].m_angular = angularM1;
+	// entry zero is the shared static body, its JMinv is zero and it must stay untouched
+	if (m0) {
+		internalForces[m0].m_linear = linearM0;
+		internalForces[m0].m_angular = angularM0;
+	}
+	if (m1) {
+		internalForces[m1].m_linear = linearM1;
+		internalForces[m1].m_angular = angularM1;
+	}
 	
 	return accNorm.GetScalar();
 }
@@ -851,6 +858,7 @@ void dgWorldDynamicUpdate::CalculateSinglePassClusterReactionForces(const dgBody
 	}
 
 	const dgInt32 passes = world->m_solverMode;
+	dgInt32 passCount = 0;
 	for (dgInt32 step = 0; step < derivativesEvaluationsRK4; step++) {
 		
 		for (dgInt32 i = 0; i < jointCount; i++) {
@@ -865,6 +873,7 @@ void dgWorldDynamicUpdate::CalculateSinglePassClusterReactionForces(const dgBody
 		dgFloat32 accNorm(maxAccNorm * dgFloat32(2.0f));
 		for (dgInt32 i = 0; (i < passes) && (accNorm > maxAccNorm); i++) {
 			accNorm = dgFloat32(0.0f);
+			passCount ++;
 			for (dgInt32 j = 0; (j < jointCount) && !constraintArray[j].m_isSkeleton; j++) {
 				dgJointInfo* const jointInfo = &constraintArray[j];
 				dgFloat32 accel = CalculateJointForceGaussSeidel(jointInfo, bodyArray, internalForces, matrixRow, maxAccNorm);
@@ -895,6 +904,11 @@ void dgWorldDynamicUpdate::CalculateSinglePassClusterReactionForces(const dgBody
 		}
 	}
 
+	dgWorldStats* const stats = world->GetStatsCollector();
+	if (stats) {
+		stats->AddCount (&stats->m_solverPasses, passCount);
+	}
+
 	dgInt32 hasJointFeeback = 0;
 	if (timestepRK != dgFloat32(0.0f)) {
 		for (dgInt32 i = 0; i < jointCount; i++) {
@@ -998,6 +1012,7 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 	}
 
 	const dgInt32 passes = world->m_solverMode;
+	dgInt32 passCount = 0;
 	for (dgInt32 step = 0; step < derivativesEvaluationsRK4; step++) {
 
 		for (dgInt32 i = 0; i < jointCount; i++) {
@@ -1012,6 +1027,7 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 		dgFloat32 accNorm(maxAccNorm * dgFloat32(2.0f));
 		for (dgInt32 i = 0; (i < passes) && (accNorm > maxAccNorm); i++) {
 			accNorm = dgFloat32(0.0f);
+			passCount ++;
 			for (dgInt32 j = 0; (j < jointCount) && !constraintArray[j].m_isSkeleton; j++) {
 				dgJointInfo* const jointInfo = &constraintArray[j];
 				dgFloat32 accel = CalculateJointForceGaussSeidel(jointInfo, bodyArray, internalForces, matrixRow, maxAccNorm);
@@ -1043,6 +1059,11 @@ void dgWorldDynamicUpdate::CalculateClusterReactionForces(const dgBodyCluster* c
 		}
 	}
 
+	dgWorldStats* const stats = world->GetStatsCollector();
+	if (stats) {
+		stats->AddCount (&stats->m_solverPasses, passCount);
+	}
+
 	dgInt32 hasJointFeeback = 0;
 	if (timestepRK != dgFloat32(0.0f)) {
 		for (dgInt32 i = 0; i < jointCount; i++) {
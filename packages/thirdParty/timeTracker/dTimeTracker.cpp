@@ -1,10 +1,9 @@
-
 /* Copyright (c) <2009> <Newton Game Dynamics>
-* 
+*
 * This software is provided 'as-is', without any express or implied
 * warranty. In no event will the authors be held liable for any damages
 * arising from the use of this software.
-* 
+*
 * Permission is granted to anyone to use this software for any purpose,
 * including commercial applications, and to alter it and redistribute it
 * freely
@@ -12,10 +11,35 @@
 
 
 #include "stdafx.h"
-// need to include stdafx.h first so that visual studio do no issues a precompiled header error 
-#if defined (D_TIME_TRACKER) && defined(_MSC_VER)
+// need to include stdafx.h first so that visual studio do no issues a precompiled header error
+#if defined (D_TIME_TRACKER)
 
 #include "dTimeTracker.h"
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#include <intrin.h>
+	#define D_TIME_TRACKER_USE_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+	#include <x86intrin.h>
+	#define D_TIME_TRACKER_USE_RDTSC
+#endif
+
+#ifdef _MSC_VER
+	#define D_TIME_TRACKER_THREAD_LOCAL __declspec(thread)
+#else
+	#define D_TIME_TRACKER_THREAD_LOCAL __thread
+#endif
+
+static D_TIME_TRACKER_THREAD_LOCAL void* g_threadBuffer = NULL;
+
 
 dTimeTracker* dTimeTracker::GetInstance()
 {
@@ -23,212 +47,413 @@ dTimeTracker* dTimeTracker::GetInstance()
 	return &instance;
 }
 
+dTimeTracker::dThreadBuffer::dThreadBuffer (int threadId)
+	:m_ring(NULL)
+	,m_next(NULL)
+	,m_head(0)
+	,m_tail(0)
+	,m_dropped(0)
+	,m_threadId(threadId)
+	,m_depth(0)
+{
+	sprintf (m_name, "thread_%d", threadId);
+}
+
+dTimeTracker::dThreadBuffer::~dThreadBuffer ()
+{
+	if (m_ring) {
+		delete[] m_ring;
+	}
+}
 
 dTimeTracker::dTimeTracker ()
+	:m_threads(NULL)
+	,m_threadCount(0)
+	,m_capturing(0)
+	,m_nameCount(0)
+	,m_frames(NULL)
+	,m_currentFrame(NULL)
+	,m_phaseSlot(NULL)
+	,m_file(NULL)
+	,m_ticksPerNanosecond(0.0)
+	,m_baseTicks(0)
+	,m_baseNanoseconds(0)
+	,m_frameStartTicks(0)
+	,m_frameCount(0)
+	,m_framesToCapture(0)
+	,m_firstRecord(0)
 {
-	m_file = NULL;
-	m_firstRecord = 0;
-	m_numberOfFrames = 0;
-	m_processId = GetCurrentProcessId();
-	QueryPerformanceFrequency(&m_frequency);
-	QueryPerformanceCounter (&m_baseCount);
+#ifdef _WIN32
+	m_processId = int (GetCurrentProcessId());
+#else
+	m_processId = int (getpid());
+#endif
+}
 
-	InitializeCriticalSectionAndSpinCount(&m_criticalSection, 0x1000);
+dTimeTracker::~dTimeTracker ()
+{
+	StopCapture ();
 
-	m_bufferIndex = 0;
-	m_bufferSize = 1024;
-	m_buffer = ((dTrackEntry*) dContainersAlloc::Alloc (m_bufferSize * sizeof (dTrackEntry)));
+	dThreadBuffer* buffer = m_threads.load();
+	while (buffer) {
+		dThreadBuffer* const next = buffer->m_next;
+		delete buffer;
+		buffer = next;
+	}
+	if (m_frames) {
+		delete[] m_frames;
+		delete[] m_phaseSlot;
+	}
+}
 
-	m_outQueueBufferindex = 0;
-	m_outQueueBufferSize = 1024 * 512;
-	m_outQueueBuffer = ((dTrackEntry*) dContainersAlloc::Alloc (m_outQueueBufferSize * sizeof (dTrackEntry)));
+long long dTimeTracker::GetReferenceTimeInNanoseconds () const
+{
+#ifdef _WIN32
+	LARGE_INTEGER count;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter (&count);
+	QueryPerformanceFrequency (&frequency);
+	return (count.QuadPart / frequency.QuadPart) * 1000000000LL + (count.QuadPart % frequency.QuadPart) * 1000000000LL / frequency.QuadPart;
+#else
+	timespec time;
+	clock_gettime (CLOCK_MONOTONIC, &time);
+	return (long long) (time.tv_sec) * 1000000000LL + time.tv_nsec;
+#endif
 }
 
-dTimeTracker::~dTimeTracker ()
+long long dTimeTracker::GetTicks () const
 {
-	dContainersAlloc::Free (m_buffer);
-	dContainersAlloc::Free (m_outQueueBuffer);
-	DeleteCriticalSection(&m_criticalSection);
+#ifdef D_TIME_TRACKER_USE_RDTSC
+	return (long long) __rdtsc();
+#else
+	return GetReferenceTimeInNanoseconds ();
+#endif
 }
 
-void dTimeTracker::StartSection (int numberOfFrames)
+void dTimeTracker::CalibrateTicks ()
 {
-	if (m_file) {
-		fclose (m_file);
+#ifdef D_TIME_TRACKER_USE_RDTSC
+	// measure the tick rate against the monotonic clock for a couple of milliseconds,
+	// each frame refines it over the whole capture time
+	long long ticks0 = GetTicks ();
+	long long time0 = GetReferenceTimeInNanoseconds ();
+	long long ticks1 = ticks0;
+	long long time1 = time0;
+	while ((time1 - time0) < 2000000) {
+		ticks1 = GetTicks ();
+		time1 = GetReferenceTimeInNanoseconds ();
 	}
+	m_ticksPerNanosecond = double (ticks1 - ticks0) / double (time1 - time0);
+#else
+	m_ticksPerNanosecond = 1.0;
+#endif
+}
 
-	time_t rawtime;
-	char fileName [80];
+long long dTimeTracker::TicksToNanoseconds (long long ticks) const
+{
+	return (long long) (double (ticks - m_baseTicks) / m_ticksPerNanosecond);
+}
 
-	time (&rawtime);
-	struct tm * timeinfo = localtime (&rawtime);
-	strftime (fileName, sizeof(fileName), "profile_%H%M%S%m%d%Y.json", timeinfo);
-	
-	m_file = fopen (fileName, "wb");
+dTimeTracker::dThreadBuffer* dTimeTracker::GetThreadBuffer ()
+{
+	dThreadBuffer* buffer = (dThreadBuffer*) g_threadBuffer;
+	if (!buffer) {
+		buffer = new dThreadBuffer (m_threadCount.fetch_add (1));
+		dThreadBuffer* head = m_threads.load ();
+		do {
+			buffer->m_next = head;
+		} while (!m_threads.compare_exchange_weak (head, buffer));
+		g_threadBuffer = buffer;
+	}
+	return buffer;
+}
 
-	fprintf (m_file, "{\n");
-	fprintf (m_file, "\t\"traceEvents\": [");
+int dTimeTracker::RegisterName (const char* const name)
+{
+	D_TIME_TRACKER_STD::lock_guard<D_TIME_TRACKER_STD::mutex> guard (m_lock);
+
+	int count = m_nameCount.load ();
+	for (int i = 0; i < count; i ++) {
+		if (!strcmp (m_names[i].m_name, name)) {
+			return i;
+		}
+	}
+	if (count >= D_TIME_TRACKER_MAX_NAMES) {
+		return -1;
+	}
 
-	QueryPerformanceFrequency(&m_frequency);
-	QueryPerformanceCounter (&m_baseCount);
-	m_numberOfFrames = numberOfFrames;	
+	strncpy (m_names[count].m_name, name, sizeof (m_names[count].m_name) - 1);
+	m_names[count].m_name[sizeof (m_names[count].m_name) - 1] = 0;
+	m_nameCount.store (count + 1);
+	return count;
 }
 
-void dTimeTracker::EndSection ()
+void dTimeTracker::RegisterThreadName (const char* const threadName)
 {
-	EnterCriticalSection(&m_criticalSection); 
-	FlushQueue ();
+	dThreadBuffer* const buffer = GetThreadBuffer ();
+	strncpy (buffer->m_name, threadName, sizeof (buffer->m_name) - 1);
+	buffer->m_name[sizeof (buffer->m_name) - 1] = 0;
+}
 
-	fprintf (m_file, "\n");
-	fprintf (m_file, "\t],\n");
+bool dTimeTracker::IsCapturing () const
+{
+	return m_capturing.load () ? true : false;
+}
 
-	fprintf (m_file, "\t\"displayTimeUnit\": \"ns\",\n");
-	fprintf (m_file, "\t\"systemTraceEvents\": \"SystemTraceData\",\n");
-	fprintf (m_file, "\t\"otherData\": {\n");
-	fprintf (m_file, "\t\t\"version\": \"My Application v1.0\"\n");
-	fprintf (m_file, "\t}\n");
-	fprintf (m_file, "}\n");
+void dTimeTracker::StartSection (int numberOfFrames)
+{
+	time_t rawtime;
+	char fileName [80];
 
-	fclose (m_file);
-	m_file = NULL;
-	m_firstRecord = 0;
-	LeaveCriticalSection(&m_criticalSection);
+	time (&rawtime);
+	struct tm * timeinfo = localtime (&rawtime);
+	strftime (fileName, sizeof(fileName), "profile_%H%M%S%m%d%Y.json", timeinfo);
+	StartCapture (fileName, numberOfFrames);
 }
 
-void dTimeTracker::Update ()
+bool dTimeTracker::StartCapture (const char* const traceFileName, int numberOfFrames)
 {
-	if (m_file) {
-		QueueEvents ();
-		m_numberOfFrames --;
-		if (m_numberOfFrames == 0) {
-			EndSection ();
+	D_TIME_TRACKER_STD::lock_guard<D_TIME_TRACKER_STD::mutex> guard (m_lock);
+	if (m_capturing.load ()) {
+		EndCapture ();
+	}
+
+	if (traceFileName) {
+		m_file = fopen (traceFileName, "wb");
+		if (!m_file) {
+			return false;
 		}
+		fprintf (m_file, "{\n");
+		fprintf (m_file, "\t\"traceEvents\": [");
+		m_firstRecord = 0;
+	}
+
+	if (!m_frames) {
+		m_frames = new dFrame[D_TIME_TRACKER_FRAME_HISTORY];
+		m_phaseSlot = new int[D_TIME_TRACKER_MAX_NAMES];
+	}
+
+	// discard whatever was left in the rings by a previous capture
+	for (dThreadBuffer* buffer = m_threads.load(); buffer; buffer = buffer->m_next) {
+		buffer->m_tail.store (buffer->m_head.load ());
+		buffer->m_dropped.store (0);
 	}
-}
 
+	if (m_ticksPerNanosecond == 0.0) {
+		CalibrateTicks ();
+	}
+	m_baseTicks = GetTicks ();
+	m_baseNanoseconds = GetReferenceTimeInNanoseconds ();
+
+	m_frameCount = 0;
+	m_framesToCapture = numberOfFrames;
+	BeginFrame (m_baseTicks);
+	m_capturing.store (1);
+	return true;
+}
 
-long long dTimeTracker::GetTimeInNanosenconds()
+void dTimeTracker::StopCapture ()
 {
-	LARGE_INTEGER count;
-	QueryPerformanceCounter (&count);
-	count.QuadPart -= m_baseCount.QuadPart;
-	LONGLONG ticks = LONGLONG (count.QuadPart * LONGLONG (1000000000) / m_frequency.QuadPart);
-	return ticks;
+	D_TIME_TRACKER_STD::lock_guard<D_TIME_TRACKER_STD::mutex> guard (m_lock);
+	if (m_capturing.load ()) {
+		EndCapture ();
+	}
 }
 
-dCRCTYPE dTimeTracker::RegisterName (const char* const name)
+void dTimeTracker::EndCapture ()
 {
-	dCRCTYPE crc = dCRC64 (name);
+	m_capturing.store (0);
+	FlushThreadBuffers ();
 
-	EnterCriticalSection(&m_criticalSection); 
-	dTree<dLabels, dCRCTYPE>::dTreeNode* const node = m_dictionary.Insert (crc);
-	LeaveCriticalSection(&m_criticalSection);
-	if (node) {
-		strncpy (&node->GetInfo().m_name[0], name, sizeof (node->GetInfo().m_name));  
+	if (m_file) {
+		unsigned dropped = 0;
+		for (dThreadBuffer* buffer = m_threads.load(); buffer; buffer = buffer->m_next) {
+			dropped += buffer->m_dropped.load ();
+			fprintf (m_file, "%s\n", m_firstRecord ? "," : "");
+			fprintf (m_file, "\t\t{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"%s\"}}", m_processId, buffer->m_threadId, buffer->m_name);
+			m_firstRecord = 1;
+		}
+
+		fprintf (m_file, "\n");
+		fprintf (m_file, "\t],\n");
+		fprintf (m_file, "\t\"displayTimeUnit\": \"ns\",\n");
+		fprintf (m_file, "\t\"otherData\": {\n");
+		fprintf (m_file, "\t\t\"frames\": %d,\n", m_frameCount);
+		fprintf (m_file, "\t\t\"droppedEvents\": %u\n", dropped);
+		fprintf (m_file, "\t}\n");
+		fprintf (m_file, "}\n");
+
+		fclose (m_file);
+		m_file = NULL;
 	}
-	return crc;
 }
 
-TIMETRACKER_API void dTimeTracker::RegisterThreadName (const char* const threadName)
+void dTimeTracker::BeginFrame (long long ticks)
 {
-	dCRCTYPE crc = GetCurrentThreadId();
-	EnterCriticalSection(&m_criticalSection); 
-	dTree<dLabels, dCRCTYPE>::dTreeNode* const node = m_dictionary.Insert (crc);
-	LeaveCriticalSection(&m_criticalSection);
-	if (node) {
-		strncpy (&node->GetInfo().m_name[0], threadName, sizeof (node->GetInfo().m_name));  
+	m_frameStartTicks = ticks;
+	m_currentFrame = &m_frames[m_frameCount % D_TIME_TRACKER_FRAME_HISTORY];
+	m_currentFrame->m_time = 0;
+	m_currentFrame->m_phaseCount = 0;
+	for (int i = 0; i < D_TIME_TRACKER_MAX_NAMES; i ++) {
+		m_phaseSlot[i] = -1;
 	}
-}	
+}
 
-void dTimeTracker::QueueEvents ()
+void dTimeTracker::FlushThreadBuffers ()
 {
-	EnterCriticalSection(&m_criticalSection); 
-	if ((m_outQueueBufferindex + m_bufferIndex) > m_outQueueBufferSize) {
-		FlushQueue ();
-		m_outQueueBufferindex = 0;
+	dFrame* const frame = m_currentFrame;
+	for (dThreadBuffer* buffer = m_threads.load(); buffer; buffer = buffer->m_next) {
+		unsigned tail = buffer->m_tail.load (D_TIME_TRACKER_STD::memory_order_relaxed);
+		const unsigned head = buffer->m_head.load (D_TIME_TRACKER_STD::memory_order_acquire);
+		for (; tail != head; tail ++) {
+			const dTrackRecord& record = buffer->m_ring[tail & (D_TIME_TRACKER_RING_SIZE - 1)];
+			if (record.m_startTime < m_baseTicks) {
+				// the scope was opened before this capture started
+				continue;
+			}
+
+			const long long startTime = TicksToNanoseconds (record.m_startTime);
+			const long long duration = TicksToNanoseconds (record.m_endTime) - startTime;
+			const char* const name = m_names[record.m_nameIndex].m_name;
+
+			if (m_file) {
+				fprintf (m_file, "%s\n", m_firstRecord ? "," : "");
+				fprintf (m_file, "\t\t{\"name\": \"%s\", \"cat\": \"newton\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+						 name, m_processId, buffer->m_threadId, double (startTime) * 1.0e-3, double (duration) * 1.0e-3);
+				m_firstRecord = 1;
+			}
+
+			int slot = m_phaseSlot[record.m_nameIndex];
+			if (slot < 0) {
+				if (frame->m_phaseCount >= D_TIME_TRACKER_FRAME_PHASES) {
+					continue;
+				}
+				slot = frame->m_phaseCount;
+				frame->m_phaseCount ++;
+				m_phaseSlot[record.m_nameIndex] = slot;
+
+				dPhaseSummary& phase = frame->m_phases[slot];
+				phase.m_name = name;
+				phase.m_parentName = (record.m_parentIndex >= 0) ? m_names[record.m_parentIndex].m_name : NULL;
+				phase.m_time = 0;
+				phase.m_maxTime = 0;
+				phase.m_calls = 0;
+				phase.m_depth = record.m_depth;
+			}
+
+			dPhaseSummary& phase = frame->m_phases[slot];
+			phase.m_time += duration;
+			phase.m_maxTime = (duration > phase.m_maxTime) ? duration : phase.m_maxTime;
+			phase.m_calls ++;
+			if (record.m_depth < phase.m_depth) {
+				phase.m_depth = record.m_depth;
+				phase.m_parentName = (record.m_parentIndex >= 0) ? m_names[record.m_parentIndex].m_name : NULL;
+			}
+		}
+		buffer->m_tail.store (tail, D_TIME_TRACKER_STD::memory_order_release);
 	}
-	memcpy (&m_outQueueBuffer[m_outQueueBufferindex], m_buffer, m_bufferIndex * sizeof (dTrackEntry));
-	m_outQueueBufferindex += m_bufferIndex;
-	m_bufferIndex = 0;
+}
 
-	LeaveCriticalSection(&m_criticalSection);
+void dTimeTracker::Update ()
+{
+	if (m_capturing.load (D_TIME_TRACKER_STD::memory_order_relaxed)) {
+		D_TIME_TRACKER_STD::lock_guard<D_TIME_TRACKER_STD::mutex> guard (m_lock);
+		if (m_capturing.load ()) {
+			const long long ticks = GetTicks ();
+#ifdef D_TIME_TRACKER_USE_RDTSC
+			const long long elapsedTime = GetReferenceTimeInNanoseconds () - m_baseNanoseconds;
+			if (elapsedTime > 50000000) {
+				m_ticksPerNanosecond = double (ticks - m_baseTicks) / double (elapsedTime);
+			}
+#endif
+			FlushThreadBuffers ();
+			m_currentFrame->m_time = TicksToNanoseconds (ticks) - TicksToNanoseconds (m_frameStartTicks);
+			m_frameCount ++;
+			if ((m_framesToCapture > 0) && (m_frameCount >= m_framesToCapture)) {
+				EndCapture ();
+			} else {
+				BeginFrame (ticks);
+			}
+		}
+	}
 }
 
+int dTimeTracker::GetFrameCount () const
+{
+	D_TIME_TRACKER_STD::lock_guard<D_TIME_TRACKER_STD::mutex> guard (m_lock);
+	return (m_frameCount < (D_TIME_TRACKER_FRAME_HISTORY - 1)) ? m_frameCount : (D_TIME_TRACKER_FRAME_HISTORY - 1);
+}
 
-void dTimeTracker::FlushQueue ()
+long long dTimeTracker::GetFrameTime (int frame) const
 {
-	for (int i = 0; i < m_outQueueBufferindex; i ++) {
-		const dTrackEntry& event = m_outQueueBuffer[i];
-		if (!m_firstRecord) {
-			fprintf (m_file, "\n");
-			m_firstRecord = true;
-		} else {
-			fprintf (m_file, ",\n");
-		}
-		
-		dTree<dLabels, dCRCTYPE>::dTreeNode* threadNodeName = m_dictionary.Find (event.m_threadId);
-		if (!threadNodeName) {
-			threadNodeName = m_dictionary.Insert(event.m_threadId);
-			sprintf (threadNodeName->GetInfo().m_name, "thread_%d", event.m_threadId);
-		}
+	D_TIME_TRACKER_STD::lock_guard<D_TIME_TRACKER_STD::mutex> guard (m_lock);
+	const int count = (m_frameCount < (D_TIME_TRACKER_FRAME_HISTORY - 1)) ? m_frameCount : (D_TIME_TRACKER_FRAME_HISTORY - 1);
+	if ((frame < 0) || (frame >= count)) {
+		return 0;
+	}
+	return m_frames[(m_frameCount - 1 - frame) % D_TIME_TRACKER_FRAME_HISTORY].m_time;
+}
 
-		fprintf (m_file, "\t\t {");
-		fprintf (m_file, "\"name\": \"%s\"", m_dictionary.Find (event.m_nameCRC)->GetInfo().m_name);
-		fprintf (m_file, ", \"cat\": \"%s\"", threadNodeName->GetInfo().m_name);
-		fprintf (m_file, ", \"ph\": \"X\"");
-		fprintf (m_file, ", \"pid\": \"%d\"", m_processId);
-		fprintf (m_file, ", \"tid\": \"%d\"", event.m_threadId);
-		fprintf (m_file, ", \"ts\": %lld", event.m_startTime);
-		fprintf (m_file, ", \"dur\": %lld", event.m_endTime - event.m_startTime);
-		fprintf (m_file, "}");
-/*
-		fprintf (m_file, "\t\t {");
-		fprintf (m_file, "\"name\": \"%s\", ", m_dictionary.Find (event.m_nameCRC)->GetInfo().m_name);
-		fprintf (m_file, "\"cat\": \"%s\", ", threadNodeName->GetInfo().m_name);
-		fprintf (m_file, "\"ph\": \"E\", ");
-		fprintf (m_file, "\"pid\": \"%d\", ", m_processId);
-		fprintf (m_file, "\"tid\": \"%d\", ", event.m_threadId);
-		fprintf (m_file, "\"ts\": %lld", event.m_endTime);
-		fprintf (m_file, "}");
-*/
+int dTimeTracker::GetFrameSummary (int frame, dPhaseSummary* const phases, int maxCount) const
+{
+	D_TIME_TRACKER_STD::lock_guard<D_TIME_TRACKER_STD::mutex> guard (m_lock);
+	const int count = (m_frameCount < (D_TIME_TRACKER_FRAME_HISTORY - 1)) ? m_frameCount : (D_TIME_TRACKER_FRAME_HISTORY - 1);
+	if ((frame < 0) || (frame >= count)) {
+		return 0;
 	}
 
-	m_outQueueBufferindex = 0;
+	const dFrame& data = m_frames[(m_frameCount - 1 - frame) % D_TIME_TRACKER_FRAME_HISTORY];
+	const int phaseCount = (data.m_phaseCount < maxCount) ? data.m_phaseCount : maxCount;
+	for (int i = 0; i < phaseCount; i ++) {
+		phases[i] = data.m_phases[i];
+	}
+	return phaseCount;
 }
 
 
-
-dTimeTracker::dTrackEntry::dTrackEntry(dCRCTYPE nameCRC)
+dTimeTracker::dTrackEntry::dTrackEntry(int nameIndex)
+	:m_nameIndex(-1)
 {
 	dTimeTracker* const instance = dTimeTracker::GetInstance();
-	if (instance->m_file) {
-		long long startTime = instance->GetTimeInNanosenconds ();
-		m_nameCRC = nameCRC;
-		m_startTime = startTime;
-		m_endTime = startTime;
-		m_threadId = GetCurrentThreadId();
+	if ((nameIndex >= 0) && instance->m_capturing.load (D_TIME_TRACKER_STD::memory_order_relaxed)) {
+		dThreadBuffer* const buffer = instance->GetThreadBuffer();
+		if (buffer->m_depth < D_TIME_TRACKER_MAX_DEPTH) {
+			buffer->m_stack[buffer->m_depth] = nameIndex;
+			buffer->m_depth ++;
+			m_nameIndex = nameIndex;
+			m_startTime = instance->GetTicks();
+		}
 	}
-
 }
 
 dTimeTracker::dTrackEntry::~dTrackEntry()
 {
-	dTimeTracker* const instance = dTimeTracker::GetInstance();
-	m_endTime = instance->GetTimeInNanosenconds ();
-	if (instance->m_file) {
-		EnterCriticalSection(&instance->m_criticalSection); 
-		if (instance->m_bufferIndex >= instance->m_bufferSize) {
-			dTrackEntry* const buffer = ((dTrackEntry*) dContainersAlloc::Alloc (2 * instance->m_bufferSize * sizeof (dTrackEntry)));
-			memcpy (buffer, instance->m_buffer, instance->m_bufferIndex * sizeof (dTrackEntry));
-			dContainersAlloc::Free (instance->m_buffer);
-			instance->m_bufferSize = instance->m_bufferSize * 2;
-			instance->m_buffer = buffer;
+	if (m_nameIndex >= 0) {
+		dTimeTracker* const instance = dTimeTracker::GetInstance();
+		const long long endTime = instance->GetTicks();
+		dThreadBuffer* const buffer = instance->GetThreadBuffer();
+
+		buffer->m_depth --;
+		const int depth = buffer->m_depth;
+		if (!buffer->m_ring) {
+			buffer->m_ring = new dTrackRecord[D_TIME_TRACKER_RING_SIZE];
+		}
+
+		const unsigned head = buffer->m_head.load (D_TIME_TRACKER_STD::memory_order_relaxed);
+		const unsigned tail = buffer->m_tail.load (D_TIME_TRACKER_STD::memory_order_acquire);
+		if ((head - tail) < D_TIME_TRACKER_RING_SIZE) {
+			dTrackRecord& record = buffer->m_ring[head & (D_TIME_TRACKER_RING_SIZE - 1)];
+			record.m_startTime = m_startTime;
+			record.m_endTime = endTime;
+			record.m_nameIndex = m_nameIndex;
+			record.m_parentIndex = depth ? buffer->m_stack[depth - 1] : -1;
+			record.m_depth = depth;
+			buffer->m_head.store (head + 1, D_TIME_TRACKER_STD::memory_order_release);
+		} else {
+			buffer->m_dropped.fetch_add (1, D_TIME_TRACKER_STD::memory_order_relaxed);
 		}
-		instance->m_buffer[instance->m_bufferIndex] = *this;
-		instance->m_bufferIndex ++;
-		LeaveCriticalSection(&instance->m_criticalSection);
 	}
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -1,10 +1,9 @@
-
 /* Copyright (c) <2009> <Newton Game Dynamics>
-* 
+*
 * This software is provided 'as-is', without any express or implied
 * warranty. In no event will the authors be held liable for any damages
 * arising from the use of this software.
-* 
+*
 * Permission is granted to anyone to use this software for any purpose,
 * including commercial applications, and to alter it and redistribute it
 * freely
@@ -13,15 +12,118 @@
 #ifndef __DTIME_TRACKER_H__
 #define __DTIME_TRACKER_H__
 
-#if defined (D_TIME_TRACKER) && defined(_MSC_VER)
+#ifdef D_TIME_TRACKER
+
+#include <stdio.h>
+
+#if defined(_MSC_VER) && (_MSC_VER < 1700)
+	// visual studio 2010 has neither <atomic> nor <mutex>, these are the few parts of them the tracker uses.
+	// msvc gives volatile accesses acquire and release semantics, and the interlocked functions are full barriers
+	#include <windows.h>
+
+	namespace dTimeTrackerStd
+	{
+		enum memory_order
+		{
+			memory_order_relaxed,
+			memory_order_acquire,
+			memory_order_release,
+		};
+
+		template<class T>
+		class atomic
+		{
+			public:
+			atomic (T value)
+				:m_value(value)
+			{
+			}
+
+			T load (memory_order order = memory_order_acquire) const
+			{
+				return m_value;
+			}
+
+			void store (T value, memory_order order = memory_order_release)
+			{
+				m_value = value;
+			}
+
+			T fetch_add (T value, memory_order order = memory_order_acquire)
+			{
+				return T (InterlockedExchangeAdd ((volatile LONG*) &m_value, LONG (value)));
+			}
+
+			bool compare_exchange_weak (T& expected, T value)
+			{
+				const T old = (T) InterlockedCompareExchangePointer ((void* volatile*) &m_value, value, expected);
+				if (old == expected) {
+					return true;
+				}
+				expected = old;
+				return false;
+			}
+
+			private:
+			volatile T m_value;
+		};
+
+		class mutex
+		{
+			public:
+			mutex ()
+			{
+				InitializeCriticalSection (&m_section);
+			}
+
+			~mutex ()
+			{
+				DeleteCriticalSection (&m_section);
+			}
+
+			void lock ()
+			{
+				EnterCriticalSection (&m_section);
+			}
 
-#include "dContainersAlloc.h"
-#include "dList.h"
-#include "dTree.h"
-#include "dCRC.h"
+			void unlock ()
+			{
+				LeaveCriticalSection (&m_section);
+			}
 
+			private:
+			CRITICAL_SECTION m_section;
+		};
 
-#ifdef TIMETRACKER_EXPORTS
+		template<class T>
+		class lock_guard
+		{
+			public:
+			lock_guard (T& mutex)
+				:m_mutex(mutex)
+			{
+				m_mutex.lock();
+			}
+
+			~lock_guard ()
+			{
+				m_mutex.unlock();
+			}
+
+			private:
+			T& m_mutex;
+		};
+	}
+	#define D_TIME_TRACKER_STD dTimeTrackerStd
+#else
+	#include <atomic>
+	#include <mutex>
+	#define D_TIME_TRACKER_STD std
+#endif
+
+#if defined(_TIMETRACKER_STATIC_LIB)
+	#define TIMETRACKER_API
+#elif defined(TIMETRACKER_EXPORTS)
 	#ifdef _WIN32
 		#define TIMETRACKER_API __declspec (dllexport)
 	#else
@@ -35,33 +137,92 @@
 	#endif
 #endif
 
-
+// every thread records its events into its own ring, the owner thread is the only writer of the head
+// and the thread calling Update is the only writer of the tail, so recording an event never takes a lock.
+#define D_TIME_TRACKER_RING_SIZE		(1<<13)
+#define D_TIME_TRACKER_MAX_DEPTH		64
+#define D_TIME_TRACKER_MAX_NAMES		512
+#define D_TIME_TRACKER_FRAME_PHASES		128
+#define D_TIME_TRACKER_FRAME_HISTORY	64
 
 class dTimeTracker
 {
 	public:
+	class dTrackEntry
+	{
+		public:
+		TIMETRACKER_API dTrackEntry(int nameIndex);
+		TIMETRACKER_API ~dTrackEntry();
+
+		private:
+		long long m_startTime;
+		int m_nameIndex;
+	};
+
+	class dPhaseSummary
+	{
+		public:
+		const char* m_name;
+		const char* m_parentName;
+		long long m_time;
+		long long m_maxTime;
+		int m_calls;
+		int m_depth;
+	};
+
 	TIMETRACKER_API static dTimeTracker* GetInstance();
 
 	TIMETRACKER_API void Update ();
 	TIMETRACKER_API void StartSection (int numberOfFrames);
-	TIMETRACKER_API dCRCTYPE RegisterName (const char* const name);
+	TIMETRACKER_API bool StartCapture (const char* const traceFileName, int numberOfFrames);
+	TIMETRACKER_API void StopCapture ();
+	TIMETRACKER_API bool IsCapturing () const;
+
+	TIMETRACKER_API int GetFrameCount () const;
+	TIMETRACKER_API long long GetFrameTime (int frame) const;
+	TIMETRACKER_API int GetFrameSummary (int frame, dPhaseSummary* const phases, int maxCount) const;
+
+	TIMETRACKER_API int RegisterName (const char* const name);
 	TIMETRACKER_API void RegisterThreadName (const char* const name);
 
-	class dTrackEntry
+	private:
+	class dTrackRecord
 	{
 		public:
-		dTrackEntry(){}
-		TIMETRACKER_API dTrackEntry(dCRCTYPE nameCRC);
-		TIMETRACKER_API ~dTrackEntry();
-
 		long long m_startTime;
 		long long m_endTime;
-		dCRCTYPE m_nameCRC;
-		DWORD m_threadId;
+		int m_nameIndex;
+		int m_parentIndex;
+		int m_depth;
+		int m_unused;
 	};
 
-	private:
-	class dLabels
+	class dThreadBuffer
+	{
+		public:
+		dThreadBuffer (int threadId);
+		~dThreadBuffer ();
+
+		dTrackRecord* m_ring;
+		dThreadBuffer* m_next;
+		D_TIME_TRACKER_STD::atomic<unsigned> m_head;
+		D_TIME_TRACKER_STD::atomic<unsigned> m_tail;
+		D_TIME_TRACKER_STD::atomic<unsigned> m_dropped;
+		int m_threadId;
+		int m_depth;
+		int m_stack[D_TIME_TRACKER_MAX_DEPTH];
+		char m_name[64];
+	};
+
+	class dFrame
+	{
+		public:
+		long long m_time;
+		int m_phaseCount;
+		dPhaseSummary m_phases[D_TIME_TRACKER_FRAME_PHASES];
+	};
+
+	class dLabel
 	{
 		public:
 		char m_name[128];
@@ -70,26 +231,35 @@ class dTimeTracker
 	dTimeTracker ();
 	~dTimeTracker ();
 
-	void EndSection ();
-	void FlushQueue ();
-	void QueueEvents ();
-	long long GetTimeInNanosenconds();
-	
-	dTree<dLabels, dCRCTYPE> m_dictionary;
-	LARGE_INTEGER m_frequency;
-	LARGE_INTEGER m_baseCount;
-	CRITICAL_SECTION m_criticalSection; 
-	DWORD m_processId;
+	dThreadBuffer* GetThreadBuffer ();
+	long long GetTicks () const;
+	long long GetReferenceTimeInNanoseconds () const;
+	long long TicksToNanoseconds (long long ticks) const;
+	void CalibrateTicks ();
+
+	void BeginFrame (long long ticks);
+	void FlushThreadBuffers ();
+	void EndCapture ();
+
+	D_TIME_TRACKER_STD::atomic<dThreadBuffer*> m_threads;
+	D_TIME_TRACKER_STD::atomic<int> m_threadCount;
+	D_TIME_TRACKER_STD::atomic<int> m_capturing;
+	D_TIME_TRACKER_STD::atomic<int> m_nameCount;
+	mutable D_TIME_TRACKER_STD::mutex m_lock;
+
+	dLabel m_names[D_TIME_TRACKER_MAX_NAMES];
+	dFrame* m_frames;
+	dFrame* m_currentFrame;
+	int* m_phaseSlot;
 	FILE* m_file;
-	int m_numberOfFrames;
+	double m_ticksPerNanosecond;
+	long long m_baseTicks;
+	long long m_baseNanoseconds;
+	long long m_frameStartTicks;
+	int m_frameCount;
+	int m_framesToCapture;
 	int m_firstRecord;
-	long m_bufferIndex;
-	long m_bufferSize;
-	dTrackEntry* m_buffer;
-
-	int m_outQueueBufferindex;
-	int m_outQueueBufferSize;
-	dTrackEntry* m_outQueueBuffer;
+	int m_processId;
 };
 
 
@@ -103,10 +273,10 @@ class dTimeTracker
 	dTimeTracker::GetInstance()->RegisterThreadName (name);
 
 #define dTimeTrackerEvent(name)																\
-	static dCRCTYPE __crcEventName__ = dTimeTracker::GetInstance()->RegisterName (name);	\
-	dTimeTracker::dTrackEntry ___trackerEntry___(__crcEventName__);	
+	static int __trackerEventName__ = dTimeTracker::GetInstance()->RegisterName (name);	\
+	dTimeTracker::dTrackEntry ___trackerEntry___(__trackerEventName__);
 
-#else 
+#else
 
 #define dTimeTrackerUpdate()
 #define dTimeTrackerEvent(name)
@@ -115,4 +285,4 @@ class dTimeTracker
 
 #endif
 
-#endif
\ No newline at end of file
+#endif
@@ -15,11 +15,8 @@
   #include <time.h>
 #endif
 
-#include <dContainersStdAfx.h>
-#include <dContainersAlloc.h>
-#include <dList.h>
-#include <dTree.h>
-#include <dCRC.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 
 